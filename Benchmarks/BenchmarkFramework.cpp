@@ -0,0 +1,92 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <cstdio>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+CBenchmarkCase* CBenchmarkCase::firstCase = nullptr;
+CBenchmarkCase* CBenchmarkCase::lastCase = nullptr;
+
+CBenchmarkCase::CBenchmarkCase( const char* _name, TBenchmarkFunction _function ) :
+	name( _name ),
+	function( _function )
+{
+	if( lastCase != nullptr ) {
+		lastCase->next = this;
+	} else {
+		firstCase = this;
+	}
+	lastCase = this;
+}
+
+bool CBenchmarkCase::Run() const
+{
+	printf( "%s\n", name );
+	try {
+		function();
+	} catch( const CException& e ) {
+		printf( "%s: unexpected exception: %s\n", name, e.GetMessageText().Ptr() );
+		return false;
+	} catch( ... ) {
+		printf( "%s: unexpected exception\n", name );
+		return false;
+	}
+	return true;
+}
+
+void CBenchmarkCase::ReportTime( const char* label, double seconds, double itemCount, const char* itemName )
+{
+	const auto itemTime = seconds * 1e9 / itemCount;
+	const auto itemRate = itemCount / seconds / 1e6;
+	printf( "    %-40s %10.3f ms %10.2f ns/%s %10.2f M%s/s\n", label, seconds * 1e3, itemTime, itemName, itemRate, itemName );
+}
+
+void CBenchmarkCase::ReportValue( const char* label, double value, const char* unit )
+{
+	printf( "    %-40s %10.2f %s\n", label, value, unit );
+}
+
+// Results are accumulated in a volatile variable.
+static volatile unsigned keptResult = 0;
+void CBenchmarkCase::KeepResult( unsigned value )
+{
+	keptResult = keptResult + value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static long long getCurrentTicks()
+{
+	LARGE_INTEGER count;
+	::QueryPerformanceCounter( &count );
+	return count.QuadPart;
+}
+
+CBenchmarkTimer::CBenchmarkTimer() :
+	startTicks( getCurrentTicks() )
+{
+}
+
+void CBenchmarkTimer::Restart()
+{
+	startTicks = getCurrentTicks();
+}
+
+double CBenchmarkTimer::GetElapsedSeconds() const
+{
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency( &frequency );
+	return static_cast<double>( getCurrentTicks() - startTicks ) / frequency.QuadPart;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,83 @@
+#pragma once
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+typedef void ( *TBenchmarkFunction )();
+
+// Benchmark of the benchmark executable. Benchmarks are registered by their static objects and run in the order of registration.
+class CBenchmarkCase {
+public:
+	CBenchmarkCase( const char* name, TBenchmarkFunction function );
+
+	const char* GetName() const
+		{ return name; }
+	const CBenchmarkCase* GetNext() const
+		{ return next; }
+	static const CBenchmarkCase* GetFirst()
+		{ return firstCase; }
+
+	// Run the benchmark and return true if it has finished. Exceptions are reported as failures.
+	bool Run() const;
+
+	// Report the time that the running benchmark has spent on the given number of items.
+	static void ReportTime( const char* label, double seconds, double itemCount, const char* itemName );
+	// Report a measurement that is not a time.
+	static void ReportValue( const char* label, double value, const char* unit );
+	// Keep a result of the measured code, so that the compiler cannot remove the code.
+	static void KeepResult( unsigned value );
+
+private:
+	const char* name;
+	TBenchmarkFunction function;
+	CBenchmarkCase* next = nullptr;
+
+	static CBenchmarkCase* firstCase;
+	static CBenchmarkCase* lastCase;
+
+	// Copying is prohibited.
+	CBenchmarkCase( CBenchmarkCase& ) = delete;
+	void operator=( CBenchmarkCase& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Wall clock time measurement. The timer starts on construction.
+class CBenchmarkTimer {
+public:
+	CBenchmarkTimer();
+
+	void Restart();
+	double GetElapsedSeconds() const;
+
+private:
+	long long startTicks;
+};
+
+// Run the action several times and return the shortest time in seconds.
+template <class Action>
+double MeasureTime( int runCount, Action action )
+{
+	double result = DBL_MAX;
+	for( int i = 0; i < runCount; i++ ) {
+		const CBenchmarkTimer timer;
+		action();
+		result = min( result, timer.GetElapsedSeconds() );
+	}
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
+
+// Define a benchmark function and register it in the benchmark executable.
+#define GIN_BENCHMARK( benchmarkName ) \
+	static void benchmarkName(); \
+	static const Gin::Benchmarks::CBenchmarkCase benchmarkName##Case( #benchmarkName, benchmarkName ); \
+	static void benchmarkName()
@@ -0,0 +1,22 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace Gin::Benchmarks;
+
+// Run the registered benchmarks. Names can be filtered by a substring given in the command line.
+// The exit code is the number of failed benchmarks.
+int main( int argc, char* argv[] )
+{
+	const char* nameFilter = argc > 1 ? argv[1] : "";
+	int failedCount = 0;
+	for( auto benchmarkCase = CBenchmarkCase::GetFirst(); benchmarkCase != nullptr; benchmarkCase = benchmarkCase->GetNext() ) {
+		if( strstr( benchmarkCase->GetName(), nameFilter ) != nullptr && !benchmarkCase->Run() ) {
+			failedCount++;
+		}
+	}
+	return failedCount;
+}
@@ -0,0 +1,116 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <BlockCompressor.h>
+#include <BlockDecoder.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int compressionImageSize = 2048;
+static const int compressionRunCount = 3;
+
+static const TBlockCompressionQuality compressionQualities[] = { BCQ_Fast, BCQ_Normal, BCQ_High };
+static const char* const qualityTimeLabels[] = { "Fast quality", "Normal quality", "High quality" };
+static const char* const qualityPsnrLabels[] = { "Fast quality PSNR", "Normal quality PSNR", "High quality PSNR" };
+static const int qualityCount = sizeof( compressionQualities ) / sizeof( compressionQualities[0] );
+
+// Photo-like test image: smooth color waves with fine noise and an alpha ramp with a hard edge.
+static CImageData createCompressionImage()
+{
+	CImageData result( TT_Texture2D, compressionImageSize, compressionImageSize, 1, TF_RGBA, TDT_UnsignedByte, 1, 1 );
+	auto& pixels = result.GetMipmapData( 0 );
+	unsigned seed = 19;
+	for( int y = 0; y < compressionImageSize; y++ ) {
+		for( int x = 0; x < compressionImageSize; x++ ) {
+			BYTE* pixel = pixels.Ptr() + ( y * compressionImageSize + x ) * 4;
+			for( int channel = 0; channel < 3; channel++ ) {
+				seed = seed * 1664525 + 1013904223;
+				const auto wave = sin( x * ( 0.011 + channel * 0.003 ) ) * cos( y * ( 0.007 + channel * 0.002 ) );
+				const auto noise = static_cast<int>( seed >> 29 ) - 4;
+				pixel[channel] = static_cast<BYTE>( max( 0, min( 255, static_cast<int>( 128 + 110 * wave ) + noise ) ) );
+			}
+			pixel[3] = static_cast<BYTE>( x < compressionImageSize / 2 ? 255 : 255 - ( y * 255 / compressionImageSize ) );
+		}
+	}
+	return result;
+}
+
+// Peak signal to noise ratio of the first channels of the decoded image.
+static double findPsnr( const BYTE* pixels, const BYTE* decodedPixels, int pixelCount, int channelCount )
+{
+	double squaredError = 0;
+	for( int i = 0; i < pixelCount; i++ ) {
+		for( int channel = 0; channel < channelCount; channel++ ) {
+			const int difference = pixels[i * 4 + channel] - decodedPixels[i * 4 + channel];
+			squaredError += difference * difference;
+		}
+	}
+	const auto meanSquaredError = max( squaredError / ( static_cast<double>( pixelCount ) * channelCount ), 1e-10 );
+	return 10 * log10( 255.0 * 255.0 / meanSquaredError );
+}
+
+// Compress the image with each quality tier on all the hardware threads and report the quality of the decoded result.
+// The normal tier is also compressed with a single worker.
+static void benchmarkCompression( TTextureCompressionType type, int channelCount )
+{
+	const CImageData image = createCompressionImage();
+	const int pixelCount = compressionImageSize * compressionImageSize;
+	CBlockCompressor compressor;
+	const CBlockDecoder decoder;
+	CArray<BYTE> decodedPixels;
+	decodedPixels.IncreaseSizeNoInitialize( pixelCount * 4 );
+	for( int i = 0; i < qualityCount; i++ ) {
+		compressor.SetQuality( compressionQualities[i] );
+		compressor.SetWorkerCount( GetHardwareThreadCount() );
+		const auto compressionTime = MeasureTime( compressionRunCount, [&]() {
+			const auto compressed = compressor.Compress( image, type );
+			CBenchmarkCase::KeepResult( compressed.GetImageData( 0 )[0] );
+		} );
+		const auto compressed = compressor.Compress( image, type );
+		decoder.DecodeImage( compressed, 0, 0, 0, decodedPixels.Ptr() );
+		CBenchmarkCase::ReportTime( qualityTimeLabels[i], compressionTime, pixelCount, "pixel" );
+		CBenchmarkCase::ReportValue( qualityPsnrLabels[i], findPsnr( image.GetImageData( 0 ), decodedPixels.Ptr(), pixelCount, channelCount ), "dB" );
+	}
+
+	compressor.SetQuality( BCQ_Normal );
+	compressor.SetWorkerCount( 1 );
+	const auto singleWorkerTime = MeasureTime( compressionRunCount, [&]() {
+		const auto compressed = compressor.Compress( image, type );
+		CBenchmarkCase::KeepResult( compressed.GetImageData( 0 )[0] );
+	} );
+	CBenchmarkCase::ReportTime( "Normal quality, single worker", singleWorkerTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportValue( "Worker count", GetHardwareThreadCount(), "workers" );
+}
+
+GIN_BENCHMARK( BlockCompressionBc1 )
+{
+	benchmarkCompression( TCT_Dxt1_RGB, 3 );
+}
+
+GIN_BENCHMARK( BlockCompressionBc3 )
+{
+	benchmarkCompression( TCT_Dxt5, 4 );
+}
+
+GIN_BENCHMARK( BlockCompressionBc4 )
+{
+	benchmarkCompression( TCT_Bc4, 1 );
+}
+
+GIN_BENCHMARK( BlockCompressionBc5 )
+{
+	benchmarkCompression( TCT_Bc5, 2 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
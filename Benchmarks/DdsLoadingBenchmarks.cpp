@@ -0,0 +1,129 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <DdsImage.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+#include <psapi.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+// The benchmark file is written to the working directory.
+static const char* ddsBenchmarkFileName = "DdsLoadBenchmark.dds";
+static const int ddsLoadRunCount = 3;
+static const int pageSize = 4096;
+
+static double getMegabyteCount( double byteCount )
+{
+	return byteCount / ( 1024 * 1024 );
+}
+
+static SIZE_T getWorkingSetSize()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	counters.cb = sizeof( counters );
+	::GetProcessMemoryInfo( ::GetCurrentProcess(), &counters, sizeof( counters ) );
+	return counters.WorkingSetSize;
+}
+
+// Write a texture with a full mipmap chain to the benchmark file and return the size of the image data.
+static int writeBenchmarkFile( CImageData&& source )
+{
+	int byteCount = 0;
+	for( int level = 0; level < source.GetMipmapCount(); level++ ) {
+		auto& levelData = source.GetMipmapData( level );
+		for( int i = 0; i < levelData.Size(); i++ ) {
+			levelData[i] = static_cast<BYTE>( i * 7 + level * 31 + 1 );
+		}
+		byteCount += levelData.Size();
+	}
+	CDdsImage( ddsBenchmarkFileName ).WriteImageData( source );
+	return byteCount;
+}
+
+// Read a byte of every page of the image data. A texture upload reads all the pages, so mapped pages are faulted in here.
+static unsigned touchImageData( const CImageData& data )
+{
+	unsigned result = 0;
+	for( int level = 0; level < data.GetMipmapCount(); level++ ) {
+		const auto levelData = data.GetMipmapData( level );
+		for( int i = 0; i < levelData.Size(); i += pageSize ) {
+			result += levelData[i];
+		}
+	}
+	return result;
+}
+
+// Load the data and read all of it while another worker samples the working set of the process.
+// Return the largest working set growth over the size before the load.
+template <class Loader>
+static SIZE_T measureWorkingSetPeak( Loader loader )
+{
+	const auto startSize = getWorkingSetSize();
+	volatile LONG isLoaded = 0;
+	// Each task records its own peak.
+	SIZE_T peakSizes[2] = { startSize, startSize };
+	auto loadAction = [&]( int, int taskIndex ) {
+		if( taskIndex == 0 ) {
+			const CImageData data = loader();
+			CBenchmarkCase::KeepResult( touchImageData( data ) );
+			peakSizes[0] = getWorkingSetSize();
+			::InterlockedExchange( &isLoaded, 1 );
+		} else {
+			do {
+				peakSizes[1] = max( peakSizes[1], getWorkingSetSize() );
+			} while( isLoaded == 0 );
+		}
+	};
+	ParallelFor( 2, 2, loadAction );
+	return max( peakSizes[0], peakSizes[1] ) - startSize;
+}
+
+// Compare the copying loader with and without the flip and the mapped loader on the benchmark file.
+static void benchmarkDdsLoading( int byteCount )
+{
+	CDdsImage image( ddsBenchmarkFileName );
+	const auto copyingTime = MeasureTime( ddsLoadRunCount, [&]() {
+		CBenchmarkCase::KeepResult( touchImageData( image.CreateImageData( false ) ) );
+	} );
+	const auto flippingTime = MeasureTime( ddsLoadRunCount, [&]() {
+		CBenchmarkCase::KeepResult( touchImageData( image.CreateImageData() ) );
+	} );
+	const auto mappedTime = MeasureTime( ddsLoadRunCount, [&]() {
+		CBenchmarkCase::KeepResult( touchImageData( image.CreateMappedImageData() ) );
+	} );
+	// The mapped loader is measured first, memory freed by the copying loader is not always trimmed from the working set.
+	const auto mappedPeak = measureWorkingSetPeak( [&]() { return image.CreateMappedImageData(); } );
+	const auto copyingPeak = measureWorkingSetPeak( [&]() { return image.CreateImageData( false ); } );
+
+	CBenchmarkCase::ReportValue( "Image data", getMegabyteCount( byteCount ), "MB" );
+	CBenchmarkCase::ReportTime( "Copying load", copyingTime, byteCount, "byte" );
+	CBenchmarkCase::ReportTime( "Copying load with a flip", flippingTime, byteCount, "byte" );
+	CBenchmarkCase::ReportTime( "Mapped load", mappedTime, byteCount, "byte" );
+	CBenchmarkCase::ReportValue( "Speedup over copying", copyingTime / mappedTime, "x" );
+	CBenchmarkCase::ReportValue( "Copying load working set peak", getMegabyteCount( static_cast<double>( copyingPeak ) ), "MB" );
+	CBenchmarkCase::ReportValue( "Mapped load working set peak", getMegabyteCount( static_cast<double>( mappedPeak ) ), "MB" );
+}
+
+GIN_BENCHMARK( DdsLoadingUncompressed )
+{
+	const auto byteCount = writeBenchmarkFile( CImageData( TT_Texture2D, 4096, 4096, 1, TF_RGBA, TDT_UnsignedByte, 13, 1 ) );
+	benchmarkDdsLoading( byteCount );
+}
+
+GIN_BENCHMARK( DdsLoadingCompressed )
+{
+	const auto byteCount = writeBenchmarkFile( CImageData( TT_Texture2D, 8192, 8192, 1, TCT_Dxt5, 14, 1 ) );
+	benchmarkDdsLoading( byteCount );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,142 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <DistanceField.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int fieldGlyphCount = 64;
+static const int fieldGlyphSize = 48;
+static const int fieldRunCount = 3;
+static const float infiniteFieldDistance = 1e20f;
+
+// Antialiased rings of different radii and thickness, the coverage is supersampled.
+static void createRingBitmaps( CArray<CArray<BYTE>>& bitmaps )
+{
+	const int sampleCount = 4;
+	for( int glyph = 0; glyph < fieldGlyphCount; glyph++ ) {
+		const float center = fieldGlyphSize * 0.5f;
+		const float outerRadius = center - 1 - glyph % 8;
+		const float innerRadius = outerRadius * ( 0.2f + ( glyph / 8 ) * 0.08f );
+		CArray<BYTE> bitmap;
+		bitmap.IncreaseSize( fieldGlyphSize * fieldGlyphSize );
+		for( int y = 0; y < fieldGlyphSize; y++ ) {
+			for( int x = 0; x < fieldGlyphSize; x++ ) {
+				int coveredCount = 0;
+				for( int sample = 0; sample < sampleCount * sampleCount; sample++ ) {
+					const float sampleX = x + ( sample % sampleCount + 0.5f ) / sampleCount - center;
+					const float sampleY = y + ( sample / sampleCount + 0.5f ) / sampleCount - center;
+					const float distance = sqrtf( sampleX * sampleX + sampleY * sampleY );
+					coveredCount += distance >= innerRadius && distance <= outerRadius ? 1 : 0;
+				}
+				bitmap[y * fieldGlyphSize + x] = static_cast<BYTE>( coveredCount * 255 / ( sampleCount * sampleCount ) );
+			}
+		}
+		bitmaps.Add( move( bitmap ) );
+	}
+}
+
+// Squared distances of a field pixel to the shape and to the background. Pixels around the bitmap are the background.
+static void getFieldSamples( const CArray<BYTE>& bitmap, int spread, int fieldX, int fieldY, float& outerSample, float& innerSample )
+{
+	const int x = fieldX - spread;
+	const int y = fieldY - spread;
+	const auto coverage = x >= 0 && y >= 0 && x < fieldGlyphSize && y < fieldGlyphSize ? bitmap[y * fieldGlyphSize + x] : 0;
+	const auto edgeDistance = 0.5f - coverage / 255.0f;
+	if( coverage == 0 ) {
+		outerSample = infiniteFieldDistance;
+		innerSample = 0.0f;
+	} else if( coverage == 255 ) {
+		outerSample = 0.0f;
+		innerSample = infiniteFieldDistance;
+	} else {
+		outerSample = edgeDistance > 0 ? edgeDistance * edgeDistance : 0.0f;
+		innerSample = edgeDistance < 0 ? edgeDistance * edgeDistance : 0.0f;
+	}
+}
+
+// Reference field: each pixel searches all the samples within the spread. Farther samples only produce saturated values.
+static void generateBruteForceField( const CArray<BYTE>& bitmap, int spread, CArrayBuffer<BYTE> field )
+{
+	const auto fieldSize = CDistanceFieldGenerator::GetFieldSize( CVector2<int>( fieldGlyphSize, fieldGlyphSize ), spread );
+	const int searchRadius = spread + 1;
+	for( int y = 0; y < fieldSize.Y(); y++ ) {
+		for( int x = 0; x < fieldSize.X(); x++ ) {
+			float outerDistance = infiniteFieldDistance;
+			float innerDistance = infiniteFieldDistance;
+			for( int sampleY = max( 0, y - searchRadius ); sampleY <= min( fieldSize.Y() - 1, y + searchRadius ); sampleY++ ) {
+				for( int sampleX = max( 0, x - searchRadius ); sampleX <= min( fieldSize.X() - 1, x + searchRadius ); sampleX++ ) {
+					float outerSample;
+					float innerSample;
+					getFieldSamples( bitmap, spread, sampleX, sampleY, outerSample, innerSample );
+					const auto offsetDistance = static_cast<float>( ( x - sampleX ) * ( x - sampleX ) + ( y - sampleY ) * ( y - sampleY ) );
+					outerDistance = min( outerDistance, outerSample + offsetDistance );
+					innerDistance = min( innerDistance, innerSample + offsetDistance );
+				}
+			}
+			const auto distance = sqrtf( innerDistance ) - sqrtf( outerDistance );
+			const auto value = 127.5f + distance * ( 127.5f / spread );
+			field[y * fieldSize.X() + x] = static_cast<BYTE>( min( 255.0f, max( 0.0f, value + 0.5f ) ) );
+		}
+	}
+}
+
+static void benchmarkSpread( const CArray<CArray<BYTE>>& bitmaps, int spread )
+{
+	const auto fieldSize = CDistanceFieldGenerator::GetFieldSize( CVector2<int>( fieldGlyphSize, fieldGlyphSize ), spread );
+	const auto fieldArea = fieldSize.X() * fieldSize.Y();
+	CArray<BYTE> fields;
+	fields.IncreaseSize( fieldArea * fieldGlyphCount );
+	CDistanceFieldGenerator generator;
+	const auto generatorTime = MeasureTime( fieldRunCount, [&]() {
+		for( int i = 0; i < fieldGlyphCount; i++ ) {
+			generator.Generate( bitmaps[i].Ptr(), CVector2<int>( fieldGlyphSize, fieldGlyphSize ), fieldGlyphSize, spread,
+				CArrayBuffer<BYTE>( fields.Ptr() + i * fieldArea, fieldArea ) );
+		}
+	} );
+	CArray<BYTE> referenceFields;
+	referenceFields.IncreaseSize( fieldArea * fieldGlyphCount );
+	const auto referenceTime = MeasureTime( 1, [&]() {
+		for( int i = 0; i < fieldGlyphCount; i++ ) {
+			generateBruteForceField( bitmaps[i], spread, CArrayBuffer<BYTE>( referenceFields.Ptr() + i * fieldArea, fieldArea ) );
+		}
+	} );
+
+	int maxDifference = 0;
+	double differenceSum = 0;
+	for( int i = 0; i < fields.Size(); i++ ) {
+		const auto difference = abs( fields[i] - referenceFields[i] );
+		maxDifference = max( maxDifference, difference );
+		differenceSum += difference;
+	}
+	CBenchmarkCase::ReportTime( "Separable transform, 64 glyphs", generatorTime, fields.Size(), "pixel" );
+	CBenchmarkCase::ReportTime( "Brute force search, 64 glyphs", referenceTime, fields.Size(), "pixel" );
+	CBenchmarkCase::ReportValue( "Speedup", referenceTime / generatorTime, "x" );
+	CBenchmarkCase::ReportValue( "Max difference from brute force", maxDifference, "levels" );
+	CBenchmarkCase::ReportValue( "Mean difference from brute force", differenceSum / fields.Size(), "levels" );
+}
+
+GIN_BENCHMARK( DistanceFieldDefaultSpread )
+{
+	CArray<CArray<BYTE>> bitmaps;
+	createRingBitmaps( bitmaps );
+	benchmarkSpread( bitmaps, CDistanceFieldGenerator::DefaultSpread );
+}
+
+GIN_BENCHMARK( DistanceFieldWideSpread )
+{
+	CArray<CArray<BYTE>> bitmaps;
+	createRingBitmaps( bitmaps );
+	benchmarkSpread( bitmaps, 2 * CDistanceFieldGenerator::DefaultSpread );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
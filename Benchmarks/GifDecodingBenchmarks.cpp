@@ -0,0 +1,243 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <GifFile.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+// The benchmark file is written to the working directory.
+static const char* gifBenchmarkFileName = "GifDecodeBenchmark.gif";
+static const int gifWidth = 480;
+static const int gifHeight = 270;
+static const int gifFrameCount = 30;
+static const int gifRunCount = 5;
+
+static const int lzwMinKeySize = 8;
+static const int lzwMaxCodeCount = 0x1000;
+
+// LZW encoder of the GIF image data. Codes are packed starting from the least significant bit.
+class CGifLzwEncoder {
+public:
+	CGifLzwEncoder() { codeTable.IncreaseSize( lzwMaxCodeCount << lzwMinKeySize ); }
+
+	// Encode the palette indices and return the code stream.
+	const CArray<BYTE>& Encode( CArrayView<BYTE> indices );
+
+private:
+	static const int clearCode = 1 << lzwMinKeySize;
+	static const int stopCode = clearCode + 1;
+
+	// Code of the string that consists of the prefix code and the next index, zero if the string is not in the table.
+	CArray<short> codeTable;
+	int nextCode = 0;
+	int keySize = 0;
+	CArray<BYTE> stream;
+	unsigned bitBuffer = 0;
+	int bitCount = 0;
+
+	void resetTable();
+	void addCode( int code );
+};
+
+const CArray<BYTE>& CGifLzwEncoder::Encode( CArrayView<BYTE> indices )
+{
+	stream.Empty();
+	bitBuffer = 0;
+	bitCount = 0;
+	resetTable();
+	addCode( clearCode );
+	int prefix = indices[0];
+	for( int i = 1; i < indices.Size(); i++ ) {
+		auto& tableCode = codeTable[( prefix << lzwMinKeySize ) + indices[i]];
+		if( tableCode != 0 ) {
+			prefix = tableCode;
+			continue;
+		}
+		addCode( prefix );
+		tableCode = static_cast<short>( nextCode++ );
+		// The decoder adds its table entries one code later, so the key grows when the table exceeds the key size.
+		if( nextCode > ( 1 << keySize ) && keySize < 12 ) {
+			keySize++;
+		}
+		if( nextCode == lzwMaxCodeCount ) {
+			addCode( clearCode );
+			resetTable();
+		}
+		prefix = indices[i];
+	}
+	addCode( prefix );
+	addCode( stopCode );
+	if( bitCount > 0 ) {
+		stream.Add( static_cast<BYTE>( bitBuffer ) );
+	}
+	return stream;
+}
+
+void CGifLzwEncoder::resetTable()
+{
+	::memset( codeTable.Ptr(), 0, codeTable.Size() * sizeof( short ) );
+	nextCode = stopCode + 1;
+	keySize = lzwMinKeySize + 1;
+}
+
+void CGifLzwEncoder::addCode( int code )
+{
+	bitBuffer |= code << bitCount;
+	bitCount += keySize;
+	while( bitCount >= 8 ) {
+		stream.Add( static_cast<BYTE>( bitBuffer ) );
+		bitBuffer >>= 8;
+		bitCount -= 8;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static void addWord( CArray<BYTE>& data, int value )
+{
+	data.Add( static_cast<BYTE>( value ) );
+	data.Add( static_cast<BYTE>( value >> 8 ) );
+}
+
+// Palette index of a frame pixel: diagonal bands that move between the frames with sparse noise.
+static BYTE getFrameIndex( int frame, int x, int y, unsigned& seed )
+{
+	seed = seed * 1664525 + 1013904223;
+	const bool isNoise = ( seed >> 24 ) < 8;
+	return static_cast<BYTE>( isNoise ? seed >> 16 : ( ( x + frame * 6 ) / 12 + y / 16 ) % 48 );
+}
+
+// Write the animation and return its size in bytes. The red channel of each palette color is equal to its index.
+static int writeGifAnimation( CArray<BYTE>& indices )
+{
+	CArray<BYTE> data;
+	const char* header = "GIF89a";
+	for( int i = 0; i < 6; i++ ) {
+		data.Add( static_cast<BYTE>( header[i] ) );
+	}
+	addWord( data, gifWidth );
+	addWord( data, gifHeight );
+	// Global color table with 256 entries, background color and aspect ratio.
+	data.Add( 0x87 );
+	data.Add( 0 );
+	data.Add( 0 );
+	for( int i = 0; i < 256; i++ ) {
+		data.Add( static_cast<BYTE>( i ) );
+		data.Add( static_cast<BYTE>( 255 - i ) );
+		data.Add( static_cast<BYTE>( i / 2 ) );
+	}
+
+	CGifLzwEncoder encoder;
+	unsigned seed = 29;
+	const int framePixelCount = gifWidth * gifHeight;
+	indices.IncreaseSizeNoInitialize( framePixelCount * gifFrameCount );
+	for( int frame = 0; frame < gifFrameCount; frame++ ) {
+		BYTE* frameIndices = indices.Ptr() + frame * framePixelCount;
+		for( int y = 0; y < gifHeight; y++ ) {
+			for( int x = 0; x < gifWidth; x++ ) {
+				frameIndices[y * gifWidth + x] = getFrameIndex( frame, x, y, seed );
+			}
+		}
+		// Graphic control extension with a 40 ms delay, followed by a frame that covers the whole canvas.
+		const BYTE controlExtension[] = { '!', 0xF9, 4, 0, 4, 0, 0, 0 };
+		for( auto value : controlExtension ) {
+			data.Add( value );
+		}
+		data.Add( ',' );
+		addWord( data, 0 );
+		addWord( data, 0 );
+		addWord( data, gifWidth );
+		addWord( data, gifHeight );
+		data.Add( 0 );
+		data.Add( static_cast<BYTE>( lzwMinKeySize ) );
+		const auto& codeStream = encoder.Encode( CArrayView<BYTE>( frameIndices, framePixelCount ) );
+		for( int pos = 0; pos < codeStream.Size(); pos += 255 ) {
+			const int blockSize = min( 255, codeStream.Size() - pos );
+			data.Add( static_cast<BYTE>( blockSize ) );
+			for( int i = 0; i < blockSize; i++ ) {
+				data.Add( codeStream[pos + i] );
+			}
+		}
+		data.Add( 0 );
+	}
+	data.Add( ';' );
+
+	CFileWriter file( gifBenchmarkFileName, FCM_CreateAlways );
+	file.Write( data.Ptr(), data.Size() );
+	return data.Size();
+}
+
+// Number of decoded pixels whose red channel is not equal to the encoded palette index. Frames are in the top-down order.
+static int countDifferentPixels( const CGifFrameSequence& sequence, const CArray<BYTE>& indices )
+{
+	const int framePixelCount = gifWidth * gifHeight;
+	int result = 0;
+	for( int frame = 0; frame < gifFrameCount; frame++ ) {
+		const BYTE* pixels = sequence.Frames.GetImageData( 0, frame );
+		for( int i = 0; i < framePixelCount; i++ ) {
+			result += pixels[4 * i] != indices[frame * framePixelCount + i] ? 1 : 0;
+		}
+	}
+	return result;
+}
+
+// Decoding of the whole animation into the texture array image, on the calling thread and on the loader thread.
+GIN_BENCHMARK( GifFrameSequence )
+{
+	CArray<BYTE> indices;
+	const auto fileSize = writeGifAnimation( indices );
+	const CGifFile file( gifBenchmarkFileName );
+	const auto decodeTime = MeasureTime( gifRunCount, [&]() {
+		const auto sequence = file.CreateFrameSequence( false );
+		CBenchmarkCase::KeepResult( sequence.Frames.GetImageData( 0 )[0] );
+	} );
+
+	// The loader returns immediately, the frames are decoded by its thread.
+	double loaderStartTime = DBL_MAX;
+	double loaderTotalTime = DBL_MAX;
+	int differentPixelCount = 0;
+	for( int i = 0; i < gifRunCount; i++ ) {
+		const CBenchmarkTimer timer;
+		CGifFrameLoader loader( gifBenchmarkFileName, false );
+		loaderStartTime = min( loaderStartTime, timer.GetElapsedSeconds() );
+		const auto sequence = loader.TakeResult();
+		loaderTotalTime = min( loaderTotalTime, timer.GetElapsedSeconds() );
+		differentPixelCount = countDifferentPixels( sequence, indices );
+	}
+
+	const int pixelCount = gifWidth * gifHeight * gifFrameCount;
+	CBenchmarkCase::ReportValue( "File size", fileSize / 1024.0, "KB" );
+	CBenchmarkCase::ReportTime( "Decode", decodeTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportValue( "Decoded frames per second", gifFrameCount / decodeTime, "frames" );
+	CBenchmarkCase::ReportTime( "Loader until the result", loaderTotalTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportValue( "Loader start on the calling thread", loaderStartTime * 1e3, "ms" );
+	CBenchmarkCase::ReportValue( "Pixels that differ from the encoded ones", differentPixelCount, "pixels" );
+}
+
+// Playback of the decoded animation only looks up the layer of the current time.
+GIN_BENCHMARK( GifFramePlayback )
+{
+	CArray<BYTE> indices;
+	writeGifAnimation( indices );
+	const auto sequence = CGifFile( gifBenchmarkFileName ).CreateFrameSequence();
+	const int lookupCount = 1000 * 1000;
+	const auto lookupTime = MeasureTime( gifRunCount, [&]() {
+		unsigned layerSum = 0;
+		for( int time = 0; time < lookupCount; time++ ) {
+			layerSum += sequence.FindFrame( time );
+		}
+		CBenchmarkCase::KeepResult( layerSum );
+	} );
+	CBenchmarkCase::ReportTime( "Frame lookup", lookupTime, lookupCount, "lookup" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,192 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <SyntheticGlyphProvider.h>
+#include <FreeTypeInitializer.h>
+#include <FontListGlyphProvider.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int batchPxHeight = 16;
+static const int batchGlyphCount = 16 * 1024;
+static const int batchRunCount = 5;
+
+// Sum of the first bitmap bytes of the batch glyphs.
+static unsigned getBatchChecksum( const CGlyphBatch& batch )
+{
+	unsigned result = 0;
+	for( int i = 0; i < batch.Size(); i++ ) {
+		const auto glyphData = batch.GetGlyphData( i );
+		result += glyphData.SizeData.Size.X() > 0 ? glyphData.BitmapData[0] : 0;
+	}
+	return result;
+}
+
+// Rasterize the glyphs into a reused batch and count the runs that have moved the bitmap blob.
+template <class Action>
+static double measureBatchFill( CGlyphBatch& batch, int& reallocationCount, Action action )
+{
+	const BYTE* bitmapBlob = nullptr;
+	reallocationCount = 0;
+	return MeasureTime( batchRunCount, [&]() {
+		batch.Empty();
+		action();
+		const auto newBlob = batch.GetGlyphData( 0 ).BitmapData;
+		reallocationCount += bitmapBlob != nullptr && newBlob != bitmapBlob ? 1 : 0;
+		bitmapBlob = newBlob;
+		CBenchmarkCase::KeepResult( getBatchChecksum( batch ) );
+	} );
+}
+
+// Glyph objects created by one call to GetGlyph per character compared to the pooled batch storage.
+GIN_BENCHMARK( GlyphBatchStorage )
+{
+	CArray<unsigned> codes;
+	for( int i = 0; i < batchGlyphCount; i++ ) {
+		codes.Add( static_cast<unsigned>( ' ' + i ) );
+	}
+	const CSyntheticGlyphProvider provider( batchPxHeight, false );
+
+	int glyphObjectCount = 0;
+	const auto glyphObjectTime = MeasureTime( batchRunCount, [&]() {
+		unsigned checksum = 0;
+		glyphObjectCount = 0;
+		for( auto code : codes ) {
+			const auto glyph = provider.GetGlyph( code );
+			const auto glyphData = glyph->GetGlyphData();
+			checksum += glyphData.SizeData.Size.X() > 0 ? glyphData.BitmapData[0] : 0;
+			glyphObjectCount++;
+		}
+		CBenchmarkCase::KeepResult( checksum );
+	} );
+
+	// The default implementation of the interface copies separate glyph objects into the batch.
+	CGlyphBatch defaultBatch;
+	int defaultReallocationCount = 0;
+	const auto defaultBatchTime = measureBatchFill( defaultBatch, defaultReallocationCount, [&]() {
+		provider.IGlyphProvider::GetGlyphs( codes, defaultBatch );
+	} );
+
+	CGlyphBatch pooledBatch;
+	int pooledReallocationCount = 0;
+	const auto pooledBatchTime = measureBatchFill( pooledBatch, pooledReallocationCount, [&]() {
+		provider.GetGlyphs( codes, pooledBatch );
+	} );
+
+	CBenchmarkCase::ReportTime( "Glyph object per character", glyphObjectTime, codes.Size(), "glyph" );
+	CBenchmarkCase::ReportValue( "Glyph objects per run", glyphObjectCount, "objects" );
+	CBenchmarkCase::ReportTime( "Batch of glyph object copies", defaultBatchTime, codes.Size(), "glyph" );
+	CBenchmarkCase::ReportTime( "Pooled batch", pooledBatchTime, codes.Size(), "glyph" );
+	CBenchmarkCase::ReportValue( "Speedup over glyph objects", glyphObjectTime / pooledBatchTime, "x" );
+	CBenchmarkCase::ReportValue( "Blob reallocations after the first run", pooledReallocationCount + defaultReallocationCount, "runs" );
+	CBenchmarkCase::ReportValue( "Bitmap bytes", pooledBatch.GetBitmapByteCount(), "bytes" );
+	CBenchmarkCase::ReportValue( "Batches that differ", getBatchChecksum( defaultBatch ) != getBatchChecksum( pooledBatch ) ? 1 : 0, "batches" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Fonts that are present on every Windows installation. The symbol font provides the characters that the first font lacks.
+static const CStringView fontListTextFontName = "C:\\Windows\\Fonts\\arial.ttf";
+static const CStringView fontListSymbolFontName = "C:\\Windows\\Fonts\\seguisym.ttf";
+static const int fontListPxHeight = 16;
+
+// Pairs of Latin letters interleaved with arrows, mathematical operators and miscellaneous symbols.
+static void createFontListPairs( CArray<unsigned>& codes )
+{
+	unsigned seed = 5;
+	for( int i = 0; i < 64 * 1024; i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		const bool isSymbol = ( seed >> 16 ) % 4 == 0;
+		codes.Add( isSymbol ? 0x2190 + ( seed >> 8 ) % 0x200 : 'A' + ( seed >> 8 ) % 58 );
+	}
+}
+
+// Search of the font list without the source cache: fonts are queried one by one for every character.
+static void findUncachedSource( CArrayView<const CFreeTypeGlyphProvider*> fonts, unsigned code, int& fontIndex, unsigned& glyphIndex )
+{
+	fontIndex = 0;
+	glyphIndex = 0;
+	for( int i = 0; i < fonts.Size(); i++ ) {
+		const auto index = fonts[i]->GetGlyphIndex( code );
+		if( index != 0 ) {
+			fontIndex = i;
+			glyphIndex = index;
+			return;
+		}
+	}
+}
+
+static int findUncachedKerning( CArrayView<const CFreeTypeGlyphProvider*> fonts, unsigned leftCode, unsigned rightCode )
+{
+	int leftFont = 0;
+	unsigned leftIndex = 0;
+	findUncachedSource( fonts, leftCode, leftFont, leftIndex );
+	int rightFont = 0;
+	unsigned rightIndex = 0;
+	findUncachedSource( fonts, rightCode, rightFont, rightIndex );
+	if( leftFont != rightFont || !fonts[leftFont]->HasKerning() ) {
+		return 0;
+	}
+	return fonts[leftFont]->GetKerningByIndex( leftIndex, rightIndex );
+}
+
+// Kerning lookups resolve the source font of both characters without rasterizing them.
+GIN_BENCHMARK( FontListSourceLookup )
+{
+	CFreeTypeInitializer freeType;
+	const CFontOwner textFont( fontListTextFontName );
+	const CFontOwner symbolFont( fontListSymbolFontName );
+	const CFreeTypeGlyphProvider textProvider( textFont, fontListPxHeight );
+	const CFreeTypeGlyphProvider symbolProvider( symbolFont, fontListPxHeight );
+	const CFreeTypeGlyphProvider* fontArray[] = { &textProvider, &symbolProvider };
+	const CArrayView<const CFreeTypeGlyphProvider*> fonts( fontArray, sizeof( fontArray ) / sizeof( fontArray[0] ) );
+
+	CArray<unsigned> codes;
+	createFontListPairs( codes );
+	const int pairCount = codes.Size() - 1;
+
+	CArray<int> uncachedKerning;
+	uncachedKerning.IncreaseSize( pairCount );
+	const auto uncachedTime = MeasureTime( batchRunCount, [&]() {
+		for( int i = 0; i < pairCount; i++ ) {
+			uncachedKerning[i] = findUncachedKerning( fonts, codes[i], codes[i + 1] );
+		}
+	} );
+
+	CFontListGlyphProvider fontList;
+	fontList.AddFont( textFont, fontListPxHeight );
+	fontList.AddFont( symbolFont, fontListPxHeight );
+	CArray<int> cachedKerning;
+	cachedKerning.IncreaseSize( pairCount );
+	CBenchmarkTimer firstRunTimer;
+	for( int i = 0; i < pairCount; i++ ) {
+		cachedKerning[i] = fontList.GetKerning( codes[i], codes[i + 1] );
+	}
+	const auto firstRunTime = firstRunTimer.GetElapsedSeconds();
+	const auto cachedTime = MeasureTime( batchRunCount, [&]() {
+		for( int i = 0; i < pairCount; i++ ) {
+			cachedKerning[i] = fontList.GetKerning( codes[i], codes[i + 1] );
+		}
+	} );
+
+	int differentPairCount = 0;
+	for( int i = 0; i < pairCount; i++ ) {
+		differentPairCount += uncachedKerning[i] != cachedKerning[i] ? 1 : 0;
+	}
+	CBenchmarkCase::ReportTime( "Query every font", uncachedTime, pairCount, "pair" );
+	CBenchmarkCase::ReportTime( "Source cache, first run", firstRunTime, pairCount, "pair" );
+	CBenchmarkCase::ReportTime( "Source cache", cachedTime, pairCount, "pair" );
+	CBenchmarkCase::ReportValue( "Speedup", uncachedTime / cachedTime, "x" );
+	CBenchmarkCase::ReportValue( "Kerning values that differ", differentPairCount, "pairs" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
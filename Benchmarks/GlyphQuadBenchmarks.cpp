@@ -0,0 +1,105 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <FontRenderer.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int quadGlyphCount = 1000 * 1000;
+// Glyphs are placed in lines, each line has its own mesh origin.
+static const int quadLineLength = 100;
+static const int quadRunCount = 5;
+
+// Glyph quad of the previous text vertex format: two separate triangles of float vertices.
+static CPixelRect addFloatGlyphQuad( CVector2<int> fontPos, CRenderGlyphData glyph, CArrayBuffer<CVector4<float>> vertices, int vertexOffset )
+{
+	const auto glyphData = glyph.GlyphData;
+	const auto texOffset = static_cast<CVector2<float>>( glyph.GlyphOffset );
+	const auto glyphSize = static_cast<CVector2<float>>( glyphData.Size );
+	const auto glyphPos = static_cast<CVector2<float>>( fontPos + glyphData.Offset );
+
+	const CVector4<float> topLeft{ glyphPos.X(), glyphPos.Y(), texOffset };
+	const CVector4<float> bottomLeft{ glyphPos.X(), glyphPos.Y() - glyphSize.Y(), texOffset.X(), texOffset.Y() + glyphSize.Y() };
+	const CVector4<float> bottomRight{ glyphPos.X() + glyphSize.X(), glyphPos.Y() - glyphSize.Y(), texOffset.X() + glyphSize.X(), texOffset.Y() + glyphSize.Y() };
+	const CVector4<float> topRight{ glyphPos.X() + glyphSize.X(), glyphPos.Y(), texOffset.X() + glyphSize.X(), texOffset.Y() };
+	vertices[vertexOffset] = topLeft;
+	vertices[vertexOffset + 1] = bottomLeft;
+	vertices[vertexOffset + 2] = bottomRight;
+	vertices[vertexOffset + 3] = topLeft;
+	vertices[vertexOffset + 4] = bottomRight;
+	vertices[vertexOffset + 5] = topRight;
+	const auto glyphBoundsHeight = max( 1, glyphData.Size.Y() );
+	return CPixelRect{ CPixelVector( bottomLeft.XY() ), glyphData.Advance.X(), glyphBoundsHeight };
+}
+
+// Glyphs of a proportional font in a 512 pixel wide atlas.
+static void createQuadGlyphs( CArray<CRenderGlyphData>& glyphs )
+{
+	const int fontGlyphCount = 96;
+	CArray<CRenderGlyphData> fontGlyphs;
+	for( int i = 0; i < fontGlyphCount; i++ ) {
+		CGlyphSizeData sizeData;
+		sizeData.Size = CVector2<int>( 6 + i % 7, 12 + i % 5 );
+		sizeData.Offset = CVector2<int>( i % 2, sizeData.Size.Y() - 3 );
+		sizeData.Advance = CVector2<int>( sizeData.Size.X() + 1, 0 );
+		fontGlyphs.Add( CRenderGlyphData( sizeData, CVector2<int>( ( i % 32 ) * 16, ( i / 32 ) * 20 ) ) );
+	}
+	glyphs.Empty();
+	glyphs.ReserveBuffer( quadGlyphCount );
+	unsigned seed = 1;
+	for( int i = 0; i < quadGlyphCount; i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		glyphs.Add( fontGlyphs[( seed >> 16 ) % fontGlyphCount] );
+	}
+}
+
+// Fill the quads of all the glyphs with the given function. Vertex buffer must have the vertices of every glyph.
+template <class TVertex, class TQuadFunction>
+static void fillGlyphQuads( CArrayView<CRenderGlyphData> glyphs, CArray<TVertex>& vertices, int vertexCount, TQuadFunction quadFunction )
+{
+	CPixelRect boundRect;
+	CVector2<int> pos;
+	for( int i = 0; i < glyphs.Size(); i++ ) {
+		if( i % quadLineLength == 0 ) {
+			pos = CVector2<int>{};
+		}
+		boundRect = GetRectUnion( boundRect, quadFunction( pos, glyphs[i], vertices, i * vertexCount ) );
+		pos.X() += glyphs[i].GlyphData.Advance.X();
+	}
+	CBenchmarkCase::KeepResult( static_cast<unsigned>( boundRect.Right() ) );
+}
+
+GIN_BENCHMARK( GlyphQuadFill )
+{
+	CArray<CRenderGlyphData> glyphs;
+	createQuadGlyphs( glyphs );
+
+	const int floatVertexCount = 6;
+	CArray<CVector4<float>> floatVertices;
+	floatVertices.IncreaseSizeNoInitialize( quadGlyphCount * floatVertexCount );
+	const auto floatTime = MeasureTime( quadRunCount, [&]() {
+		fillGlyphQuads( glyphs, floatVertices, floatVertexCount, addFloatGlyphQuad );
+	} );
+	CBenchmarkCase::ReportTime( "Float triangles, 1M glyphs", floatTime, quadGlyphCount, "glyph" );
+	CBenchmarkCase::ReportValue( "Float triangle size", static_cast<double>( floatVertexCount * sizeof( CVector4<float> ) ), "bytes/glyph" );
+
+	CArray<CTextVertex> quadVertices;
+	quadVertices.IncreaseSizeNoInitialize( quadGlyphCount * CFontRenderer::GlyphQuadVertexCount );
+	const auto quadTime = MeasureTime( quadRunCount, [&]() {
+		fillGlyphQuads( glyphs, quadVertices, CFontRenderer::GlyphQuadVertexCount, CFontRenderer::AddGlyphQuad );
+	} );
+	CBenchmarkCase::ReportTime( "Indexed 16-bit quads, 1M glyphs", quadTime, quadGlyphCount, "glyph" );
+	CBenchmarkCase::ReportValue( "Indexed 16-bit quad size", static_cast<double>( CFontRenderer::GlyphQuadVertexCount * sizeof( CTextVertex ) ), "bytes/glyph" );
+	CBenchmarkCase::ReportValue( "Speedup", floatTime / quadTime, "x" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
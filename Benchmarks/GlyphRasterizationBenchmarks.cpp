@@ -0,0 +1,89 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <FreeTypeInitializer.h>
+#include <FreeTypeGlyphProvider.h>
+#include <DistanceFieldGlyphProvider.h>
+#include <GlyphAtlas.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Font that is present on every Windows installation.
+static const CStringView rasterizationFontName = "C:\\Windows\\Fonts\\arial.ttf";
+static const int rasterizationPxHeight = 48;
+static const int rasterizationRunCount = 3;
+
+// All the characters of the basic multilingual plane that the font has.
+static void findFontCharacters( const CFontOwner& font, CArray<unsigned>& codes )
+{
+	for( unsigned code = ' '; code < 0x10000; code++ ) {
+		if( font.HasGlyph( code ) ) {
+			codes.Add( code );
+		}
+	}
+}
+
+// Fill the atlas with the glyphs using the given number of workers.
+static double measureAtlasFill( const IGlyphProvider& provider, CArrayView<unsigned> codes, int workerCount, CGlyphAtlas& atlas )
+{
+	CArray<CAtlasGlyph> glyphs;
+	glyphs.IncreaseSize( codes.Size() );
+	return MeasureTime( rasterizationRunCount, [&]() {
+		atlas.FreeBuffer();
+		atlas.AddGlyphs( provider, codes, workerCount, glyphs );
+	} );
+}
+
+// Compare the sequential and the parallel fill of an atlas. The packing does not depend on the worker count, so the atlases must be identical.
+static void benchmarkAtlasFill( const IGlyphProvider& provider, CArrayView<unsigned> codes )
+{
+	const auto workerCount = GetHardwareThreadCount();
+	CGlyphAtlas sequentialAtlas;
+	const auto sequentialTime = measureAtlasFill( provider, codes, 1, sequentialAtlas );
+	CGlyphAtlas parallelAtlas;
+	const auto parallelTime = measureAtlasFill( provider, codes, workerCount, parallelAtlas );
+
+	int differentTexelCount = abs( sequentialAtlas.GetPixels().Size() - parallelAtlas.GetPixels().Size() );
+	const auto commonSize = min( sequentialAtlas.GetPixels().Size(), parallelAtlas.GetPixels().Size() );
+	for( int i = 0; i < commonSize; i++ ) {
+		differentTexelCount += sequentialAtlas.GetPixels()[i] != parallelAtlas.GetPixels()[i] ? 1 : 0;
+	}
+	CBenchmarkCase::ReportValue( "Glyph count", codes.Size(), "glyphs" );
+	CBenchmarkCase::ReportTime( "Single worker", sequentialTime, codes.Size(), "glyph" );
+	CBenchmarkCase::ReportTime( "All hardware threads", parallelTime, codes.Size(), "glyph" );
+	CBenchmarkCase::ReportValue( "Worker count", workerCount, "workers" );
+	CBenchmarkCase::ReportValue( "Speedup", sequentialTime / parallelTime, "x" );
+	CBenchmarkCase::ReportValue( "Atlas texels that differ", differentTexelCount, "texels" );
+}
+
+GIN_BENCHMARK( GlyphRasterizationCoverage )
+{
+	CFreeTypeInitializer freeType;
+	const CFontOwner font( rasterizationFontName );
+	CArray<unsigned> codes;
+	findFontCharacters( font, codes );
+	const CFreeTypeGlyphProvider provider( font, rasterizationPxHeight );
+	benchmarkAtlasFill( provider, codes );
+}
+
+GIN_BENCHMARK( GlyphRasterizationDistanceField )
+{
+	CFreeTypeInitializer freeType;
+	const CFontOwner font( rasterizationFontName );
+	CArray<unsigned> codes;
+	findFontCharacters( font, codes );
+	const CDistanceFieldGlyphProvider provider( CreateOwner<CFreeTypeGlyphProvider>( font, rasterizationPxHeight ) );
+	benchmarkAtlasFill( provider, codes );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,117 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <ImageData.h>
+#include <DxtBlockFlip.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int flipImageSize = 4096;
+static const int flipRunCount = 5;
+
+static void fillFlipImage( CImageData& image )
+{
+	auto& imageData = image.GetMipmapData( 0 );
+	unsigned seed = 13;
+	for( int i = 0; i < imageData.Size(); i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		imageData[i] = static_cast<BYTE>( seed >> 24 );
+	}
+}
+
+static int countDifferentBytes( const BYTE* first, const BYTE* second, int byteCount )
+{
+	int result = 0;
+	for( int i = 0; i < byteCount; i++ ) {
+		result += first[i] != second[i] ? 1 : 0;
+	}
+	return result;
+}
+
+// Flip the image into a new buffer, flip it in place and check that both give the same result.
+static void benchmarkImageFlip( CImageData& image, CArray<BYTE>& flippedCopy )
+{
+	const int imageSize = image.GetImageDataSize( 0 );
+	const auto copyTime = MeasureTime( flipRunCount, [&]() {
+		CArray<BYTE> buffer;
+		buffer.IncreaseSizeNoInitialize( imageSize );
+		image.CopyImageData( 0, 0, 0, buffer.Ptr(), true );
+		CBenchmarkCase::KeepResult( buffer[0] );
+	} );
+	flippedCopy.Empty();
+	flippedCopy.IncreaseSizeNoInitialize( imageSize );
+	image.CopyImageData( 0, 0, 0, flippedCopy.Ptr(), true );
+
+	// The number of runs is odd, the image ends up flipped.
+	const auto inPlaceTime = MeasureTime( flipRunCount, [&]() {
+		image.FlipImage( 0, 0, 0 );
+		CBenchmarkCase::KeepResult( image.GetImageData( 0 )[0] );
+	} );
+
+	const int pixelCount = flipImageSize * flipImageSize;
+	CBenchmarkCase::ReportValue( "Image data", imageSize / ( 1024.0 * 1024.0 ), "MB" );
+	CBenchmarkCase::ReportTime( "Flipped copy into a new buffer", copyTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportTime( "In place flip", inPlaceTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportValue( "Bytes that differ", countDifferentBytes( image.GetImageData( 0 ), flippedCopy.Ptr(), imageSize ), "bytes" );
+}
+
+// Flip the image with the single block function, the way compressed images were flipped before the SSE2 block flips.
+static void flipScalarBlocks( GinInternal::TDxtBlockType blockType, const BYTE* src, BYTE* dest, int imageSize )
+{
+	const int blockSize = GinInternal::GetDxtBlockSize( blockType );
+	const int rowSize = flipImageSize / 4 * blockSize;
+	const int rowCount = imageSize / rowSize;
+	for( int row = 0; row < rowCount; row++ ) {
+		const BYTE* srcRow = src + ( rowCount - row - 1 ) * rowSize;
+		BYTE* destRow = dest + row * rowSize;
+		for( int pos = 0; pos < rowSize; pos += blockSize ) {
+			GinInternal::FlipDxtBlock( blockType, destRow + pos, srcRow + pos );
+		}
+	}
+}
+
+static void benchmarkCompressedFlip( TTextureCompressionType compressionType, GinInternal::TDxtBlockType blockType )
+{
+	CImageData image( TT_Texture2D, flipImageSize, flipImageSize, 1, compressionType, 1, 1 );
+	fillFlipImage( image );
+	const int imageSize = image.GetImageDataSize( 0 );
+	CArray<BYTE> scalarResult;
+	scalarResult.IncreaseSizeNoInitialize( imageSize );
+	const auto scalarTime = MeasureTime( flipRunCount, [&]() {
+		flipScalarBlocks( blockType, image.GetImageData( 0 ), scalarResult.Ptr(), imageSize );
+	} );
+
+	CArray<BYTE> flippedCopy;
+	benchmarkImageFlip( image, flippedCopy );
+	CBenchmarkCase::ReportTime( "Scalar block flip", scalarTime, flipImageSize * flipImageSize, "pixel" );
+	CBenchmarkCase::ReportValue( "Bytes that differ from the scalar flip", countDifferentBytes( scalarResult.Ptr(), flippedCopy.Ptr(), imageSize ), "bytes" );
+}
+
+GIN_BENCHMARK( ImageFlipRgba )
+{
+	CImageData image( TT_Texture2D, flipImageSize, flipImageSize, 1, TF_RGBA, TDT_UnsignedByte, 1, 1 );
+	fillFlipImage( image );
+	CArray<BYTE> flippedCopy;
+	benchmarkImageFlip( image, flippedCopy );
+}
+
+GIN_BENCHMARK( ImageFlipDxt1 )
+{
+	benchmarkCompressedFlip( TCT_Dxt1_RGB, GinInternal::DBT_Dxt1 );
+}
+
+GIN_BENCHMARK( ImageFlipDxt5 )
+{
+	benchmarkCompressedFlip( TCT_Dxt5, GinInternal::DBT_Dxt5 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,100 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <MipmapGenerator.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int mipmapImageSize = 4096;
+static const int mipmapRunCount = 3;
+
+// Image with the full mipmap chain and a noisy first level. Alpha has the full range, so coverage preservation has work to do.
+static CImageData createMipmapImage( TTexelFormat format )
+{
+	const auto mipmapCount = CMipmapGenerator::GetFullMipmapCount( mipmapImageSize, mipmapImageSize );
+	CImageData result( TT_Texture2D, mipmapImageSize, mipmapImageSize, 1, format, TDT_UnsignedByte, mipmapCount, 1 );
+	auto& firstLevel = result.GetMipmapData( 0 );
+	unsigned seed = 17;
+	for( int i = 0; i < firstLevel.Size(); i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		firstLevel[i] = static_cast<BYTE>( seed >> 24 );
+	}
+	return result;
+}
+
+// Generate the chain of a new image with a single worker and with a worker per hardware thread.
+// Throughput is counted in the pixels of the first level.
+static void benchmarkMipmaps( TTexelFormat format, CMipmapGenerator& generator )
+{
+	CImageData image = createMipmapImage( format );
+	const int pixelCount = mipmapImageSize * mipmapImageSize;
+	generator.SetWorkerCount( 1 );
+	const auto singleWorkerTime = MeasureTime( mipmapRunCount, [&]() {
+		generator.GenerateMipmaps( image );
+		CBenchmarkCase::KeepResult( image.GetImageData( 1 )[0] );
+	} );
+	generator.SetWorkerCount( GetHardwareThreadCount() );
+	const auto allThreadsTime = MeasureTime( mipmapRunCount, [&]() {
+		generator.GenerateMipmaps( image );
+		CBenchmarkCase::KeepResult( image.GetImageData( 1 )[0] );
+	} );
+
+	CBenchmarkCase::ReportTime( "Single worker", singleWorkerTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportTime( "All hardware threads", allThreadsTime, pixelCount, "pixel" );
+	CBenchmarkCase::ReportValue( "Speedup", singleWorkerTime / allThreadsTime, "x" );
+}
+
+GIN_BENCHMARK( MipmapBoxRgba )
+{
+	CMipmapGenerator generator;
+	benchmarkMipmaps( TF_RGBA, generator );
+}
+
+GIN_BENCHMARK( MipmapBoxSrgbRgba )
+{
+	CMipmapGenerator generator;
+	generator.SetSrgb( true );
+	benchmarkMipmaps( TF_RGBA, generator );
+}
+
+GIN_BENCHMARK( MipmapAlphaCoverageRgba )
+{
+	CMipmapGenerator generator;
+	generator.SetSrgb( true );
+	generator.SetAlphaCoveragePreservation( true );
+	benchmarkMipmaps( TF_RGBA, generator );
+}
+
+GIN_BENCHMARK( MipmapKaiserSrgbRgba )
+{
+	CMipmapGenerator generator;
+	generator.SetFilter( MF_Kaiser );
+	generator.SetSrgb( true );
+	benchmarkMipmaps( TF_RGBA, generator );
+}
+
+GIN_BENCHMARK( MipmapBoxRed )
+{
+	CMipmapGenerator generator;
+	benchmarkMipmaps( TF_Red, generator );
+}
+
+GIN_BENCHMARK( MipmapKaiserRed )
+{
+	CMipmapGenerator generator;
+	generator.SetFilter( MF_Kaiser );
+	benchmarkMipmaps( TF_Red, generator );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
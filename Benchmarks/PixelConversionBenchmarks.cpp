@@ -0,0 +1,93 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <PixelConverter.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int conversionPixelCount = 2048 * 2048;
+static const int conversionRunCount = 5;
+
+static const char* const fromFormatLabels[PF_EnumCount] = { "From R8", "From RG8", "From RGB8", "From BGR8", "From RGBA8", "From BGRA8",
+	"From RGB565", "From RGBA16F", "From RGBA32F" };
+static const char* const toFormatLabels[PF_EnumCount] = { "To R8", "To RG8", "To RGB8", "To BGR8", "To RGBA8", "To BGRA8",
+	"To RGB565", "To RGBA16F", "To RGBA32F" };
+
+// Random RGBA8 pixels converted to the given format.
+static void createConversionSource( TPixelFormat format, CArray<BYTE>& result )
+{
+	CArray<BYTE> rgbaPixels;
+	rgbaPixels.IncreaseSizeNoInitialize( conversionPixelCount * 4 );
+	unsigned seed = 23;
+	for( int i = 0; i < rgbaPixels.Size(); i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		rgbaPixels[i] = static_cast<BYTE>( seed >> 24 );
+	}
+	result.Empty();
+	result.IncreaseSizeNoInitialize( conversionPixelCount * CPixelConverter::GetPixelSize( format ) );
+	const CPixelConverter converter;
+	converter.ConvertPixels( rgbaPixels.Ptr(), PF_RGBA8, result.Ptr(), format, conversionPixelCount );
+}
+
+static double measureConversion( const CPixelConverter& converter, CArrayView<BYTE> src, TPixelFormat srcFormat, TPixelFormat destFormat )
+{
+	CArray<BYTE> dest;
+	dest.IncreaseSizeNoInitialize( conversionPixelCount * CPixelConverter::GetPixelSize( destFormat ) );
+	return MeasureTime( conversionRunCount, [&]() {
+		converter.ConvertPixels( src.Ptr(), srcFormat, dest.Ptr(), destFormat, conversionPixelCount );
+		CBenchmarkCase::KeepResult( dest[0] );
+	} );
+}
+
+// Conversion of each format to the RGBA8 format that textures are uploaded in.
+GIN_BENCHMARK( PixelConversionToRgba8 )
+{
+	const CPixelConverter converter;
+	CArray<BYTE> src;
+	for( int format = 0; format < PF_EnumCount; format++ ) {
+		createConversionSource( static_cast<TPixelFormat>( format ), src );
+		const auto time = measureConversion( converter, src, static_cast<TPixelFormat>( format ), PF_RGBA8 );
+		CBenchmarkCase::ReportTime( fromFormatLabels[format], time, conversionPixelCount, "pixel" );
+	}
+}
+
+GIN_BENCHMARK( PixelConversionFromRgba8 )
+{
+	const CPixelConverter converter;
+	CArray<BYTE> src;
+	createConversionSource( PF_RGBA8, src );
+	for( int format = 0; format < PF_EnumCount; format++ ) {
+		const auto time = measureConversion( converter, src, PF_RGBA8, static_cast<TPixelFormat>( format ) );
+		CBenchmarkCase::ReportTime( toFormatLabels[format], time, conversionPixelCount, "pixel" );
+	}
+}
+
+// Color space and alpha operations that go through the floating point stage.
+GIN_BENCHMARK( PixelConversionColorSpace )
+{
+	CArray<BYTE> src;
+	createConversionSource( PF_RGBA8, src );
+	CPixelConverter converter;
+	converter.SetSourceSrgb( true );
+	CBenchmarkCase::ReportTime( "sRGB RGBA8 to linear RGBA16F", measureConversion( converter, src, PF_RGBA8, PF_RGBA16F ), conversionPixelCount, "pixel" );
+	converter.SetDestSrgb( true );
+	converter.SetAlphaConversion( AC_Premultiply );
+	CBenchmarkCase::ReportTime( "Premultiply sRGB RGBA8", measureConversion( converter, src, PF_RGBA8, PF_RGBA8 ), conversionPixelCount, "pixel" );
+	converter.SetAlphaConversion( AC_Unpremultiply );
+	CBenchmarkCase::ReportTime( "Unpremultiply sRGB RGBA8", measureConversion( converter, src, PF_RGBA8, PF_RGBA8 ), conversionPixelCount, "pixel" );
+	converter.SetSourceSrgb( false );
+	converter.SetDestSrgb( false );
+	converter.SetAlphaConversion( AC_Premultiply );
+	CBenchmarkCase::ReportTime( "Premultiply linear RGBA8", measureConversion( converter, src, PF_RGBA8, PF_RGBA8 ), conversionPixelCount, "pixel" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
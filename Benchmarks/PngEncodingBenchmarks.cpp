@@ -0,0 +1,102 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <PngEncoder.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Size of a 4K screen capture.
+static const int pngImageWidth = 3840;
+static const int pngImageHeight = 2160;
+static const int pngRunCount = 3;
+
+static const TPngFilterStrategy filterStrategies[] = { PFS_None, PFS_Sub, PFS_Up, PFS_Paeth, PFS_MinimumSum };
+static const char* const filterTimeLabels[] = { "No filter", "Sub filter", "Up filter", "Paeth filter", "Minimum sum filter" };
+static const char* const filterSizeLabels[] = { "No filter, size", "Sub filter, size", "Up filter, size", "Paeth filter, size",
+	"Minimum sum filter, size" };
+static const int filterStrategyCount = sizeof( filterStrategies ) / sizeof( filterStrategies[0] );
+
+// Capture-like RGBA image: flat areas and gradients of the interface with a noisy scene region.
+static void createCaptureImage( CArray<BYTE>& result )
+{
+	result.Empty();
+	result.IncreaseSizeNoInitialize( pngImageWidth * pngImageHeight * 4 );
+	unsigned seed = 31;
+	for( int y = 0; y < pngImageHeight; y++ ) {
+		for( int x = 0; x < pngImageWidth; x++ ) {
+			BYTE* pixel = result.Ptr() + ( y * pngImageWidth + x ) * 4;
+			seed = seed * 1664525 + 1013904223;
+			const bool isScene = x > pngImageWidth / 4 && y > pngImageHeight / 8;
+			const int noise = isScene ? static_cast<int>( seed >> 28 ) : 0;
+			pixel[0] = static_cast<BYTE>( x / 16 + noise );
+			pixel[1] = static_cast<BYTE>( y / 9 + noise );
+			pixel[2] = static_cast<BYTE>( isScene ? ( x + y ) / 32 + noise : 48 );
+			pixel[3] = 255;
+		}
+	}
+}
+
+static double measureEncoding( const CPngEncoder& encoder, const CArray<BYTE>& pixels, CArray<BYTE>& file )
+{
+	return MeasureTime( pngRunCount, [&]() {
+		encoder.Encode( pixels, TF_RGBA, pngImageWidth * 4, CVector2<int>( pngImageWidth, pngImageHeight ), file );
+		CBenchmarkCase::KeepResult( file[file.Size() - 1] );
+	} );
+}
+
+// Encode the capture with a single worker and with a worker per hardware thread. Throughput is counted in the bytes of the image.
+static void benchmarkPngEncoding( TPngCompressionLevel level )
+{
+	CArray<BYTE> pixels;
+	createCaptureImage( pixels );
+	CPngEncoder encoder;
+	encoder.SetCompressionLevel( level );
+	CArray<BYTE> file;
+	encoder.SetWorkerCount( 1 );
+	const auto singleWorkerTime = measureEncoding( encoder, pixels, file );
+	encoder.SetWorkerCount( GetHardwareThreadCount() );
+	const auto allThreadsTime = measureEncoding( encoder, pixels, file );
+
+	CBenchmarkCase::ReportTime( "Single worker", singleWorkerTime, pixels.Size(), "byte" );
+	CBenchmarkCase::ReportTime( "All hardware threads", allThreadsTime, pixels.Size(), "byte" );
+	CBenchmarkCase::ReportValue( "Speedup", singleWorkerTime / allThreadsTime, "x" );
+	CBenchmarkCase::ReportValue( "File size", file.Size() * 100.0 / pixels.Size(), "% of the image" );
+}
+
+GIN_BENCHMARK( PngEncodingStore )
+{
+	benchmarkPngEncoding( PCL_Store );
+}
+
+GIN_BENCHMARK( PngEncodingFast )
+{
+	benchmarkPngEncoding( PCL_Fast );
+}
+
+// Cost and gain of each row filter at the fast level on all the hardware threads.
+GIN_BENCHMARK( PngFilterStrategies )
+{
+	CArray<BYTE> pixels;
+	createCaptureImage( pixels );
+	CPngEncoder encoder;
+	encoder.SetWorkerCount( GetHardwareThreadCount() );
+	CArray<BYTE> file;
+	for( int i = 0; i < filterStrategyCount; i++ ) {
+		encoder.SetFilterStrategy( filterStrategies[i] );
+		const auto time = measureEncoding( encoder, pixels, file );
+		CBenchmarkCase::ReportTime( filterTimeLabels[i], time, pixels.Size(), "byte" );
+		CBenchmarkCase::ReportValue( filterSizeLabels[i], file.Size() * 100.0 / pixels.Size(), "% of the image" );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,98 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <BenchmarkFramework.h>
+#include <SoftwareMixer.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int mixerSampleRate = 48000;
+static const int bufferSampleRate = 44100;
+// Ten seconds of output rendered by 10 ms parts.
+static const int renderPartFrameCount = mixerSampleRate / 100;
+static const int renderPartCount = 1000;
+static const int mixerRunCount = 3;
+
+static const int voiceCounts[] = { 1, 8, 32, 128, 512 };
+static const char* const voiceCountLabels[] = { "1 voice", "8 voices", "32 voices", "128 voices", "512 voices" };
+static const int voiceCountCount = sizeof( voiceCounts ) / sizeof( voiceCounts[0] );
+
+// One second of a looping tone.
+static unsigned createToneBuffer( CSoftwareMixer& mixer, int channelCount )
+{
+	CArray<short> samples;
+	for( int i = 0; i < bufferSampleRate * channelCount; i++ ) {
+		const double phase = static_cast<double>( i / channelCount ) * 6.283185307 / bufferSampleRate;
+		samples.Add( static_cast<short>( 8000 * sin( phase * ( 220 + 110 * ( i % channelCount ) ) ) ) );
+	}
+	unsigned bufferId;
+	mixer.CreateBuffers( 1, &bufferId );
+	mixer.SetBufferData( bufferId, channelCount == 1 ? ADF_Mono16 : ADF_Stereo16, bufferSampleRate, samples.Ptr(),
+		samples.Size() * static_cast<int>( sizeof( short ) ) );
+	return bufferId;
+}
+
+// Render the output of the given number of looping voices to the null sink. Throughput is counted in the frames of each voice.
+// Mono voices are placed around the listener and have different pitches, stereo voices are only resampled to the output rate.
+static double measureVoiceMixing( int voiceCount, int channelCount )
+{
+	CSoftwareMixer mixer( CreateOwner<CNullAudioSink>(), mixerSampleRate );
+	const unsigned bufferId = createToneBuffer( mixer, channelCount );
+	for( int i = 0; i < voiceCount; i++ ) {
+		const unsigned sourceId = mixer.CreateSource();
+		mixer.QueueBuffers( sourceId, 1, &bufferId );
+		mixer.SetSourceLooping( sourceId, true );
+		mixer.SetSourceGain( sourceId, 1.0f / voiceCount );
+		if( channelCount == 1 ) {
+			const float angle = i * 2.399963f;
+			const float distance = 1.0f + i % 16;
+			mixer.SetSourcePosition( sourceId, CVector3<float>( distance * cos( angle ), 0.0f, distance * sin( angle ) ) );
+			mixer.SetSourcePitch( sourceId, 0.75f + ( i % 7 ) * 0.125f );
+		}
+		mixer.PlaySource( sourceId );
+	}
+
+	return MeasureTime( mixerRunCount, [&]() {
+		for( int i = 0; i < renderPartCount; i++ ) {
+			mixer.Render( renderPartFrameCount );
+		}
+		CBenchmarkCase::KeepResult( static_cast<unsigned>( mixer.GetMixedSourceCount() ) );
+	} );
+}
+
+static void benchmarkVoiceScaling( int channelCount )
+{
+	const int frameCount = renderPartFrameCount * renderPartCount;
+	for( int i = 0; i < voiceCountCount; i++ ) {
+		const auto time = measureVoiceMixing( voiceCounts[i], channelCount );
+		CBenchmarkCase::ReportTime( voiceCountLabels[i], time, static_cast<double>( frameCount ) * voiceCounts[i], "frame" );
+	}
+	CBenchmarkCase::ReportValue( "Rendered sound", frameCount / static_cast<double>( mixerSampleRate ), "s" );
+}
+
+GIN_BENCHMARK( SoftwareMixerMonoVoices )
+{
+	benchmarkVoiceScaling( 1 );
+}
+
+GIN_BENCHMARK( SoftwareMixerStereoVoices )
+{
+	benchmarkVoiceScaling( 2 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
+
+#endif
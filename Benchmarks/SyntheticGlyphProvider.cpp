@@ -0,0 +1,64 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <SyntheticGlyphProvider.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+CGlyphSizeData CSyntheticGlyphProvider::GetSizeData( unsigned code ) const
+{
+	CGlyphSizeData result;
+	// Spaces have no bitmap.
+	const bool isEmpty = code == ' ';
+	result.Size = isEmpty ? CVector2<int>{} : CVector2<int>( pxHeight / 3 + code % 5, pxHeight * 2 / 3 + code % 3 );
+	result.Offset = CVector2<int>( code % 2, result.Size.Y() );
+	result.Advance = CVector2<int>( pxHeight / 3 + code % 5 + 1, 0 );
+	result.Pitch = result.Size.X();
+	return result;
+}
+
+// Rasterize a filled shape with antialiased borders.
+void CSyntheticGlyphProvider::fillBitmap( unsigned code, CGlyphSizeData sizeData, CArrayBuffer<BYTE> bitmap )
+{
+	for( int y = 0; y < sizeData.Size.Y(); y++ ) {
+		for( int x = 0; x < sizeData.Size.X(); x++ ) {
+			const bool isBorder = x == 0 || y == 0 || x == sizeData.Size.X() - 1 || y == sizeData.Size.Y() - 1;
+			const bool isFilled = ( x + y + code ) % 3 != 0;
+			bitmap[y * sizeData.Pitch + x] = static_cast<BYTE>( isBorder ? 128 : isFilled ? 255 : 0 );
+		}
+	}
+}
+
+CPtrOwner<IGlyph> CSyntheticGlyphProvider::GetGlyph( int utf32 ) const
+{
+	const auto sizeData = GetSizeData( utf32 );
+	CArray<BYTE> bitmap;
+	bitmap.IncreaseSizeNoInitialize( sizeData.Pitch * sizeData.Size.Y() );
+	fillBitmap( utf32, sizeData, bitmap );
+	return CreateOwner<CSyntheticGlyph>( sizeData, move( bitmap ) );
+}
+
+void CSyntheticGlyphProvider::GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const
+{
+	for( auto code : utf32Codes ) {
+		const auto sizeData = GetSizeData( code );
+		fillBitmap( code, sizeData, result.AddGlyphBitmap( sizeData ) );
+	}
+}
+
+int CSyntheticGlyphProvider::GetKerning( int leftUtf32, int rightUtf32 ) const
+{
+	// Most of the pairs have no kerning.
+	const auto pairHash = static_cast<unsigned>( leftUtf32 * 31 + rightUtf32 );
+	return pairHash % 7 == 0 ? static_cast<int>( pairHash % 3 ) - 1 : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,50 @@
+#pragma once
+#include <GlyphProvider.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Glyph with its own bitmap storage.
+class CSyntheticGlyph : public IGlyph {
+public:
+	CSyntheticGlyph( CGlyphSizeData _sizeData, CArray<BYTE> _bitmap ) : sizeData( _sizeData ), bitmap( move( _bitmap ) ) {}
+
+	virtual CGlyphData GetGlyphData() const override final
+		{ return CGlyphData{ sizeData, bitmap.Ptr() }; }
+
+private:
+	CGlyphSizeData sizeData;
+	CArray<BYTE> bitmap;
+};
+
+// Provider of glyphs that are computed from the glyph codes. Metrics resemble a proportional font of the given pixel height.
+// Benchmarks measure the glyph handling of the engine, the rasterization cost of a real font is not a part of it.
+class CSyntheticGlyphProvider : public IGlyphProvider {
+public:
+	CSyntheticGlyphProvider( int _pxHeight, bool _hasKerning ) : pxHeight( _pxHeight ), hasKerning( _hasKerning ) {}
+
+	CGlyphSizeData GetSizeData( unsigned code ) const;
+
+	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+	virtual void GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const override final;
+	virtual bool HasKerning() const override final
+		{ return hasKerning; }
+	virtual int GetKerning( int leftUtf32, int rightUtf32 ) const override final;
+	virtual CPtrOwner<IGlyphProvider> CreateWorkerCopy() const override final
+		{ return CreateOwner<CSyntheticGlyphProvider>( pxHeight, hasKerning ); }
+
+private:
+	int pxHeight;
+	bool hasKerning;
+
+	static void fillBitmap( unsigned code, CGlyphSizeData sizeData, CArrayBuffer<BYTE> bitmap );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
@@ -0,0 +1,243 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BenchmarkFramework.h>
+#include <SyntheticGlyphProvider.h>
+#include <GlyphCache.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int layoutPxHeight = 16;
+static const int layoutLineWidth = 640;
+static const int layoutRunCount = 5;
+
+// Paragraphs of random words. Most of the words are Latin, some are Cyrillic.
+static void createParagraphText( int length, CArray<wchar_t>& text )
+{
+	text.Empty();
+	text.ReserveBuffer( length );
+	unsigned seed = 3;
+	int wordCount = 0;
+	while( text.Size() < length ) {
+		seed = seed * 1664525 + 1013904223;
+		const int wordLength = 1 + ( seed >> 8 ) % 10;
+		const bool isCyrillic = ( seed >> 16 ) % 8 == 0;
+		for( int i = 0; i < wordLength && text.Size() < length; i++ ) {
+			seed = seed * 1664525 + 1013904223;
+			const auto letter = ( seed >> 16 ) % 26;
+			text.Add( static_cast<wchar_t>( isCyrillic ? 0x430 + letter : 'a' + letter ) );
+		}
+		wordCount++;
+		if( text.Size() < length ) {
+			text.Add( wordCount % 80 == 0 ? L'\n' : L' ' );
+		}
+	}
+}
+
+// UTF-8 copy of the text. Characters are below U+0800.
+static void convertToUtf8( CArrayView<wchar_t> text, CArray<char>& result )
+{
+	result.Empty();
+	result.ReserveBuffer( text.Size() * 2 );
+	for( auto ch : text ) {
+		if( ch < 0x80 ) {
+			result.Add( static_cast<char>( ch ) );
+		} else {
+			result.Add( static_cast<char>( 0xC0 | ( ch >> 6 ) ) );
+			result.Add( static_cast<char>( 0x80 | ( ch & 0x3F ) ) );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+GIN_BENCHMARK( TextLayout )
+{
+	const int glyphCount = 200 * 1000;
+	CArray<wchar_t> text;
+	createParagraphText( glyphCount, text );
+	CArray<char> utf8Text;
+	convertToUtf8( text, utf8Text );
+	const CUnicodePart utf16Str( text.Ptr(), text.Size() );
+	const CStringPart utf8Str( utf8Text.Ptr(), utf8Text.Size() );
+
+	// Layout results are written to the preallocated storage.
+	CArray<CTextLayoutGlyph> glyphs;
+	glyphs.IncreaseSize( glyphCount );
+	CArray<CTextLayoutLine> lines;
+	lines.IncreaseSize( glyphCount );
+
+	// The first layout rasterizes the glyphs.
+	const auto firstLayoutTime = MeasureTime( layoutRunCount, [&]() {
+		CGlyphCache cache;
+		cache.SetGlyphProvider( CreateOwner<CSyntheticGlyphProvider>( layoutPxHeight, false ) );
+		const auto result = cache.LayoutText( utf16Str, layoutLineWidth, layoutPxHeight, 0, glyphs, lines );
+		CBenchmarkCase::KeepResult( static_cast<unsigned>( result.LineCount ) );
+	} );
+	CBenchmarkCase::ReportTime( "First layout, UTF-16", firstLayoutTime, glyphCount, "glyph" );
+
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CSyntheticGlyphProvider>( layoutPxHeight, false ) );
+	cache.LoadGlyphs( utf16Str, 1 );
+	const auto utf16Time = MeasureTime( layoutRunCount, [&]() {
+		const auto result = cache.LayoutText( utf16Str, layoutLineWidth, layoutPxHeight, 0, glyphs, lines );
+		CBenchmarkCase::KeepResult( static_cast<unsigned>( result.LineCount ) );
+	} );
+	CBenchmarkCase::ReportTime( "Layout, UTF-16", utf16Time, glyphCount, "glyph" );
+	const auto utf8Time = MeasureTime( layoutRunCount, [&]() {
+		const auto result = cache.LayoutText( utf8Str, layoutLineWidth, layoutPxHeight, 0, glyphs, lines );
+		CBenchmarkCase::KeepResult( static_cast<unsigned>( result.LineCount ) );
+	} );
+	CBenchmarkCase::ReportTime( "Layout, UTF-8", utf8Time, glyphCount, "glyph" );
+}
+
+// Cost of the precomputed kerning pairs in the layout of the same text.
+GIN_BENCHMARK( TextLayoutKerning )
+{
+	const int glyphCount = 200 * 1000;
+	CArray<wchar_t> text;
+	createParagraphText( glyphCount, text );
+	const CUnicodePart str( text.Ptr(), text.Size() );
+	CArray<CTextLayoutGlyph> glyphs;
+	glyphs.IncreaseSize( glyphCount );
+	CArray<CTextLayoutLine> lines;
+	lines.IncreaseSize( glyphCount );
+
+	double layoutTimes[2];
+	for( int hasKerning = 0; hasKerning < 2; hasKerning++ ) {
+		CGlyphCache cache;
+		cache.SetGlyphProvider( CreateOwner<CSyntheticGlyphProvider>( layoutPxHeight, hasKerning != 0 ) );
+		cache.LoadGlyphs( str, 1 );
+		layoutTimes[hasKerning] = MeasureTime( layoutRunCount, [&]() {
+			const auto result = cache.LayoutText( str, layoutLineWidth, layoutPxHeight, 0, glyphs, lines );
+			CBenchmarkCase::KeepResult( static_cast<unsigned>( result.LineCount ) );
+		} );
+	}
+	CBenchmarkCase::ReportTime( "Layout without kerning", layoutTimes[0], glyphCount, "glyph" );
+	CBenchmarkCase::ReportTime( "Layout with kerning", layoutTimes[1], glyphCount, "glyph" );
+	CBenchmarkCase::ReportValue( "Kerning overhead", ( layoutTimes[1] / layoutTimes[0] - 1 ) * 100, "%" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int shapingLineCount = 1024;
+static const int shapingRequestCount = 200 * 1000;
+
+// Distinct single line labels cut from the paragraph text.
+static void createShapingLines( CArray<wchar_t>& text, CArray<CUnicodePart>& shapingLines )
+{
+	createParagraphText( shapingLineCount * 48, text );
+	for( int i = 0; i < text.Size(); i++ ) {
+		text[i] = text[i] == L'\n' ? L' ' : text[i];
+	}
+	unsigned seed = 7;
+	int lineStart = 0;
+	while( shapingLines.Size() < shapingLineCount ) {
+		seed = seed * 1664525 + 1013904223;
+		const int lineLength = 8 + ( seed >> 8 ) % 40;
+		shapingLines.Add( CUnicodePart( text.Ptr() + lineStart, lineLength ) );
+		lineStart += lineLength;
+	}
+}
+
+// Indices of the requested lines. A user interface requests a few labels every frame and the rest rarely,
+// so the line index is skewed towards the start of the list.
+static void createShapingRequests( CArray<int>& requests )
+{
+	unsigned seed = 11;
+	for( int i = 0; i < shapingRequestCount; i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		const auto random = static_cast<double>( seed >> 8 ) / ( 1 << 24 );
+		requests.Add( static_cast<int>( random * random * random * shapingLineCount ) );
+	}
+}
+
+// Shaping without the cache: every request decodes the line and looks up the kerning.
+static CVector2<int> shapeUncachedLine( CGlyphCache& cache, CUnicodePart line, CArray<CTextLayoutGlyph>& glyphs )
+{
+	glyphs.Empty();
+	CVector2<int> pen;
+	unsigned prevCode = 0;
+	for( int strPos = 0; strPos < line.Length(); ) {
+		CTextLayoutGlyph glyph;
+		glyph.StrPos = strPos;
+		glyph.GlyphCode = CGlyphCache::ParseCharacter( line, strPos );
+		const auto sizeData = cache.GetRenderData( glyph.GlyphCode ).GlyphData;
+		if( !glyphs.IsEmpty() ) {
+			pen.X() += cache.GetKerning( prevCode, glyph.GlyphCode );
+		}
+		glyph.Position = pen;
+		glyphs.Add( glyph );
+		pen += sizeData.Advance;
+		prevCode = glyph.GlyphCode;
+	}
+	return pen;
+}
+
+// Request the lines from the shaped line cache with the given budget and report the time and the hit rate.
+static void measureShapedLines( const char* label, int cacheBudget, CArrayView<CUnicodePart> shapingLines, CArrayView<int> requests,
+	CArrayView<int> expectedWidths )
+{
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CSyntheticGlyphProvider>( layoutPxHeight, true ) );
+	cache.SetShapingCacheBudget( cacheBudget );
+	for( auto line : shapingLines ) {
+		cache.LoadGlyphs( line, 1 );
+	}
+	int differentLineCount = 0;
+	const auto cachedTime = MeasureTime( layoutRunCount, [&]() {
+		differentLineCount = 0;
+		for( auto lineIndex : requests ) {
+			const auto& shapedLine = cache.GetShapedLine( shapingLines[lineIndex] );
+			differentLineCount += shapedLine.EndOffset.X() != expectedWidths[lineIndex] ? 1 : 0;
+		}
+	} );
+	const auto& statistics = cache.GetShapingCacheStatistics();
+	CBenchmarkCase::ReportTime( label, cachedTime, requests.Size(), "line" );
+	CBenchmarkCase::ReportValue( "Hit rate", 100.0 * statistics.HitCount / ( statistics.HitCount + statistics.MissCount ), "%" );
+	CBenchmarkCase::ReportValue( "Evictions per run", static_cast<double>( statistics.EvictionCount ) / layoutRunCount, "lines" );
+	CBenchmarkCase::ReportValue( "Lines that differ", differentLineCount, "lines" );
+}
+
+// Repeated labels are served by the shaped line cache instead of decoding and kerning them again.
+GIN_BENCHMARK( ShapedLineCache )
+{
+	CArray<wchar_t> text;
+	CArray<CUnicodePart> shapingLines;
+	createShapingLines( text, shapingLines );
+	CArray<int> requests;
+	createShapingRequests( requests );
+
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CSyntheticGlyphProvider>( layoutPxHeight, true ) );
+	CArray<CTextLayoutGlyph> glyphs;
+	CArray<int> expectedWidths;
+	int shapedByteCount = 0;
+	for( auto line : shapingLines ) {
+		expectedWidths.Add( shapeUncachedLine( cache, line, glyphs ).X() );
+		shapedByteCount += glyphs.Size() * sizeof( CTextLayoutGlyph );
+	}
+	const auto uncachedTime = MeasureTime( layoutRunCount, [&]() {
+		unsigned checksum = 0;
+		for( auto lineIndex : requests ) {
+			checksum += shapeUncachedLine( cache, shapingLines[lineIndex], glyphs ).X();
+		}
+		CBenchmarkCase::KeepResult( checksum );
+	} );
+
+	CBenchmarkCase::ReportTime( "Decode and kern every request", uncachedTime, requests.Size(), "line" );
+	CBenchmarkCase::ReportValue( "Shaped bytes of all the lines", shapedByteCount, "bytes" );
+	measureShapedLines( "Cache with all the lines", CGlyphCache::DefaultShapingCacheBudget, shapingLines, requests, expectedWidths );
+	// A budget for an eighth of the lines keeps the frequent labels only.
+	measureShapedLines( "Cache with an eighth of the lines", shapedByteCount / 8, shapingLines, requests, expectedWidths );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
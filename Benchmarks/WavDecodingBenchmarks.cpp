@@ -0,0 +1,182 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <BenchmarkFramework.h>
+#include <WavDecoder.h>
+
+namespace Gin {
+
+namespace Benchmarks {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+// The benchmark file is written to the working directory and overwritten for each encoding.
+static const char* wavBenchmarkFileName = "WavDecodeBenchmark.wav";
+// Thirty seconds of stereo sound.
+static const int wavSampleRate = 44100;
+static const int wavFrameCount = wavSampleRate * 30;
+static const int wavChannelCount = 2;
+// The file is decoded by the parts of the default stream buffer.
+static const int wavPartFrameCount = wavSampleRate / 4;
+static const int wavRunCount = 5;
+
+static const int pcmFormatTag = 1;
+static const int floatFormatTag = 3;
+static const int imaAdpcmFormatTag = 0x11;
+static const int adpcmBlockAlign = 2048;
+
+static void addValue( int value, int size, CArray<BYTE>& data )
+{
+	for( int i = 0; i < size; i++ ) {
+		data.Add( static_cast<BYTE>( value >> ( 8 * i ) ) );
+	}
+}
+
+static void addId( const char* id, CArray<BYTE>& data )
+{
+	for( int i = 0; i < 4; i++ ) {
+		data.Add( static_cast<BYTE>( id[i] ) );
+	}
+}
+
+static void addChunkHeader( const char* id, int size, CArray<BYTE>& data )
+{
+	addId( id, data );
+	addValue( size, 4, data );
+}
+
+static void writeWavFile( int formatTag, int bitsPerSample, int blockAlign, const CArray<BYTE>& samples )
+{
+	CArray<BYTE> data;
+	addChunkHeader( "RIFF", 4 + 8 + 16 + 8 + samples.Size(), data );
+	addId( "WAVE", data );
+	addChunkHeader( "fmt ", 16, data );
+	addValue( formatTag, 2, data );
+	addValue( wavChannelCount, 2, data );
+	addValue( wavSampleRate, 4, data );
+	addValue( wavSampleRate * blockAlign, 4, data );
+	addValue( blockAlign, 2, data );
+	addValue( bitsPerSample, 2, data );
+	addChunkHeader( "data", samples.Size(), data );
+	for( int i = 0; i < samples.Size(); i++ ) {
+		data.Add( samples[i] );
+	}
+
+	CFileWriter file( wavBenchmarkFileName, FCM_CreateAlways );
+	file.Write( data.Ptr(), data.Size() );
+}
+
+// Sample of a chord with a little noise in the [-1, 1) range.
+static double getWavSample( int index, unsigned& seed )
+{
+	seed = seed * 1664525 + 1013904223;
+	// Phase of the 1 Hz wave.
+	const double phase = static_cast<double>( index / wavChannelCount ) * 6.283185307 / wavSampleRate;
+	const double noise = ( static_cast<int>( seed >> 20 ) - 2048 ) / 204800.0;
+	return 0.4 * sin( phase * 220 ) + 0.3 * sin( phase * 277 ) + 0.2 * sin( phase * 330 ) + noise;
+}
+
+// Write the file with integer samples of the given size in bytes.
+static void writePcmFile( int sampleSize )
+{
+	CArray<BYTE> samples;
+	unsigned seed = 37;
+	const double scale = static_cast<double>( 1u << ( sampleSize * 8 - 1 ) );
+	for( int i = 0; i < wavFrameCount * wavChannelCount; i++ ) {
+		addValue( static_cast<int>( getWavSample( i, seed ) * scale ), sampleSize, samples );
+	}
+	writeWavFile( pcmFormatTag, sampleSize * 8, sampleSize * wavChannelCount, samples );
+}
+
+static void writeFloatFile()
+{
+	CArray<BYTE> samples;
+	unsigned seed = 37;
+	for( int i = 0; i < wavFrameCount * wavChannelCount; i++ ) {
+		const float sample = static_cast<float>( getWavSample( i, seed ) );
+		int bits;
+		memcpy( &bits, &sample, sizeof( bits ) );
+		addValue( bits, 4, samples );
+	}
+	writeWavFile( floatFormatTag, 32, 4 * wavChannelCount, samples );
+}
+
+// ADPCM blocks with valid headers and random codes. The predictors are clamped, so any codes give a valid stream.
+static void writeAdpcmFile()
+{
+	const int headerSize = 4 * wavChannelCount;
+	const int framesPerBlock = 1 + ( adpcmBlockAlign - headerSize ) / headerSize * 8;
+	const int blockCount = Ceil( wavFrameCount, framesPerBlock );
+	CArray<BYTE> blocks;
+	unsigned seed = 37;
+	for( int block = 0; block < blockCount; block++ ) {
+		for( int channel = 0; channel < wavChannelCount; channel++ ) {
+			seed = seed * 1664525 + 1013904223;
+			addValue( static_cast<int>( seed >> 16 ), 2, blocks );
+			addValue( static_cast<int>( ( seed >> 8 ) % 89 ), 1, blocks );
+			addValue( 0, 1, blocks );
+		}
+		for( int i = headerSize; i < adpcmBlockAlign; i++ ) {
+			seed = seed * 1664525 + 1013904223;
+			blocks.Add( static_cast<BYTE>( seed >> 24 ) );
+		}
+	}
+	writeWavFile( imaAdpcmFormatTag, 4, adpcmBlockAlign, blocks );
+}
+
+// Decode the whole file by the stream buffer parts. The decoder makes no OpenAL calls, the decoded parts are discarded
+// the way a null device would discard them.
+static void benchmarkWavDecoding( const char* label, bool allowFloatOutput )
+{
+	CWavDecoder decoder( wavBenchmarkFileName, allowFloatOutput );
+	CArray<BYTE> part;
+	const auto time = MeasureTime( wavRunCount, [&]() {
+		decoder.Rewind();
+		unsigned checksum = 0;
+		while( !decoder.IsFinished() ) {
+			part.Empty();
+			decoder.Decode( wavPartFrameCount, part );
+			checksum += part[part.Size() - 1];
+		}
+		CBenchmarkCase::KeepResult( checksum );
+	} );
+	CBenchmarkCase::ReportTime( label, time, decoder.GetFrameCount(), "frame" );
+}
+
+// Conversion of each sample encoding to the 16 bit PCM output. 16 bit PCM is passed as is.
+GIN_BENCHMARK( WavDecodingTo16Bit )
+{
+	writePcmFile( 2 );
+	benchmarkWavDecoding( "PCM 16", false );
+	writePcmFile( 3 );
+	benchmarkWavDecoding( "PCM 24", false );
+	writePcmFile( 4 );
+	benchmarkWavDecoding( "PCM 32", false );
+	writeFloatFile();
+	benchmarkWavDecoding( "Float 32", false );
+	writeAdpcmFile();
+	benchmarkWavDecoding( "IMA ADPCM", false );
+}
+
+// Conversion of the wide encodings to the float output that is used when the OpenAL extension is present.
+GIN_BENCHMARK( WavDecodingToFloat )
+{
+	writePcmFile( 3 );
+	benchmarkWavDecoding( "PCM 24", true );
+	writePcmFile( 4 );
+	benchmarkWavDecoding( "PCM 32", true );
+	writeFloatFile();
+	benchmarkWavDecoding( "Float 32", true );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Benchmarks.
+
+}	// namespace Gin.
+
+#endif
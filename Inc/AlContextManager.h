@@ -4,6 +4,10 @@
 #include <AudioRecord.h>
 #include <AudioListener.h>
 #include <AudioUtils.h>
+#include <AudioBackend.h>
+#include <AudioSink.h>
+#include <AudioSequence.h>
+#include <State.h>
 
 namespace Gin {
 
@@ -13,15 +17,16 @@ namespace Audio {
 
 //////////////////////////////////////////////////////////////////////////
 
-typedef struct ALCdevice_struct ALCdevice;
-typedef struct ALCcontext_struct ALCcontext;
-class CSoundView;
+class CSoftwareMixer;
 //////////////////////////////////////////////////////////////////////////
 
-// Class for managing OpenAL context. A single context at a time is assumed.
+// Class for managing the audio context. A single context at a time is assumed.
+// The context plays the sounds with OpenAL or mixes them in software.
+// Records are virtual voices that are not limited in number. Each update the most audible voices are mapped on a fixed pool of sources,
+// other voices are virtualized: they keep their playback position without producing any sound and resume when a source is available.
 class GINAPI CAlContextManager {
 public:
-	CAlContextManager() : device( 0 ), context( 0 ) {}
+	CAlContextManager() = default;
 	~CAlContextManager();
 
 	// Get context's listener object.
@@ -30,49 +35,116 @@ public:
 	const CAudioListener& GetListener() const
 		{ return listener; }
 
-	// Create a new playing audio source. 
-	// If the source cannot be created, an existing record is stopped and its id is reused.
+	// Create a new playing voice. If all the sources are busy, the least audible voice is virtualized.
 	CAudioRecord CreateRecord( CSoundView seq, TSourcePriority priority, CVector3<float> pos, CVector3<float> velocity, bool isLooping );
-	int GetAudioRecord( int sourcePos, int sourceGeneration ) const;
+	// Get the voice index of the record. Return NotFound if the record has been stopped.
+	int GetAudioRecord( int voicePos, int voiceGeneration ) const;
+
+	// Voice controls used by the records.
+	CAudioRecord::TRecordState GetVoiceState( int voicePos ) const;
+	void PlayVoice( int voicePos );
+	void PauseVoice( int voicePos );
+	void StopVoice( int voicePos );
+	void RewindVoice( int voicePos );
+	void SetVoiceGain( int voicePos, float newValue );
+	void SetVoicePitch( int voicePos, float newValue );
+	void SetVoicePan( int voicePos, float newValue );
+
+	// Number of voices that are playing or paused.
+	int GetVoiceCount() const
+		{ return voiceCount; }
+	// Number of playing voices that have no source.
+	int GetVirtualVoiceCount() const;
+	// Check if any of the active records uses the given sound.
+	bool HasSoundRecords( CSoundView sound ) const;
+
+	// Refresh the source states, advance the virtual voices and remap the voices on the sources. Called once per frame.
+	void Update( TTime secondsPassed );
 
 	// Stop playing all the sounds and detach the buffers.
 	void StopAllRecords();
 
 	// Is the context created.
 	bool HasContext() const
-		{ return context != nullptr; }
-	// Create the context.
+		{ return backend != nullptr; }
+	// Audio output of the context.
+	IAudioBackend& GetBackend()
+		{ assert( HasContext() ); return *backend; }
+	// Software mixer of the context. Null if the context uses OpenAL.
+	CSoftwareMixer* GetSoftwareMixer()
+		{ return softwareMixer; }
+	// Create the context on the default OpenAL device.
 	void Initialize();
+	// Create the context with a software mixer that writes to the given sink.
+	void InitializeSoftware( CPtrOwner<IAudioSink> sink, int sampleRate );
+	// Create the context with the given backend.
+	void InitializeBackend( CPtrOwner<IAudioBackend> newBackend );
 	// Delete the context.
 	void Cleanup();
 
 private:
-	// Used audio device.
-	ALCdevice* device;
-	// Native handle to the audio context.
-	ALCcontext* context;
+	// Audio output.
+	CPtrOwner<IAudioBackend> backend;
+	// The backend if it is a software mixer.
+	CSoftwareMixer* softwareMixer = nullptr;
 	// Listener object of the context.
 	CAudioListener listener;
 
+	struct CVoice {
+		CSoundView Sound;
+		CVector3<float> Position;
+		CVector3<float> Velocity;
+		float Gain = 1.0f;
+		float Pitch = 1.0f;
+		float Pan = 0.0f;
+		bool IsLooping = false;
+		// Low priority voices are virtualized first.
+		TSourcePriority Priority = SP_LowPriority;
+		CAudioRecord::TRecordState State = CAudioRecord::RS_Stopped;
+		// Playback position in seconds. Updated while the voice is virtual.
+		float Offset = 0.0f;
+		// Length of the sound in seconds.
+		float Duration = 0.0f;
+		// Index of the voice source in activeRecords. NotFound for virtual voices.
+		int SourcePos = NotFound;
+		// Voices can be reused. To distinguish between them, generation number is increased with every reuse.
+		int Generation = 0;
+		// Audibility score of the last update.
+		float Score = 0.0f;
+	};
+
 	struct CPlayingSource {
-		// Source identifier in the OpenAl system.
+		// Source identifier in the audio backend.
 		unsigned Id;
-		// Source identifiers can be reused. To distinguish between them, generation number is increased with every reuse.
-		int Generation = 0;
-		// Source priority. Low priority sources can be reused.
-		TSourcePriority Priority = SP_LowPriority;
+		// Index of the voice that uses the source. NotFound for free sources.
+		int VoicePos = NotFound;
 
 		explicit CPlayingSource( unsigned id ) : Id( id ) {}
 	};
 
-	// List of playing records with an ID.
+	// Logical voices and the indices of the unused ones.
+	CArray<CVoice> voices;
+	CArray<int> freeVoices;
+	int voiceCount = 0;
+	// Pool of the backend sources.
 	CStaticArray<CPlayingSource> activeRecords;
+	// Identifiers of the pool sources and their states queried by the last update.
+	CArray<unsigned> sourceIds;
+	CArray<CAudioRecord::TRecordState> sourceStates;
+	// Best scored voices of the last update.
+	CArray<int> selectedVoices;
 
 	void initSources();
-	int findSourcePos( TSourcePriority priority );
-	bool isActive( const CPlayingSource& src ) const;
-	void playSource( int srcId, CSoundView seq, CVector3<float> pos, CVector3<float> velocity, bool isLooping ) const;
-	void stopSource( CPlayingSource& src );
+	void updateSourceStates();
+	void updateVirtualVoices( TTime secondsPassed );
+	void selectAudibleVoices();
+	float getVoiceScore( const CVoice& voice ) const;
+	int findFreeSource() const;
+	int findWeakestSource( float score ) const;
+	void attachSource( int voicePos, int sourcePos );
+	void detachSource( int voicePos );
+	void setSourcePlacement( unsigned sourceId, const CVoice& voice );
+	void freeVoice( int voicePos );
 
 	// Copying is prohibited.
 	CAlContextManager( const CAlContextManager& ) = delete;
@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+#include <AudioRecord.h>
+
+namespace Gin {
+
+namespace Audio {
+
+enum TAudioDataFormat;
+//////////////////////////////////////////////////////////////////////////
+
+// General interface for the audio output.
+// The interface follows the OpenAL object model: sources play queues of buffers, identifiers of the objects are never zero.
+class GINAPI IAudioBackend {
+public:
+	virtual ~IAudioBackend() {}
+
+	// Check if the 32 bit float buffer formats are supported.
+	virtual bool IsFloatFormatSupported() const = 0;
+
+	virtual void CreateBuffers( int count, unsigned* result ) = 0;
+	virtual void DeleteBuffers( int count, const unsigned* bufferIds ) = 0;
+	virtual void SetBufferData( unsigned bufferId, TAudioDataFormat format, int frequency, const void* data, int size ) = 0;
+	// Length of the buffer data in seconds.
+	virtual float GetBufferDuration( unsigned bufferId ) const = 0;
+
+	virtual unsigned CreateSource() = 0;
+	virtual void DeleteSource( unsigned sourceId ) = 0;
+
+	// Relative sources are positioned in the listener space.
+	virtual void SetSourceRelative( unsigned sourceId, bool isRelative ) = 0;
+	virtual void SetSourcePosition( unsigned sourceId, CVector3<float> position ) = 0;
+	virtual void SetSourceVelocity( unsigned sourceId, CVector3<float> velocity ) = 0;
+	// Looping sources play their whole queue again after the end.
+	virtual void SetSourceLooping( unsigned sourceId, bool isLooping ) = 0;
+	virtual void SetSourceGain( unsigned sourceId, float gain ) = 0;
+	// Playback speed multiplier. Changes the pitch of the sound.
+	virtual void SetSourcePitch( unsigned sourceId, float pitch ) = 0;
+	// Attenuation of a mono source at the given distance from the listener.
+	virtual float GetDistanceGain( float distance ) const = 0;
+
+	virtual CAudioRecord::TRecordState GetSourceState( unsigned sourceId ) const = 0;
+	// Get the states of several sources with a single call.
+	virtual void GetSourceStates( int count, const unsigned* sourceIds, CAudioRecord::TRecordState* result ) const = 0;
+	virtual void PlaySource( unsigned sourceId ) = 0;
+	virtual void PauseSource( unsigned sourceId ) = 0;
+	virtual void StopSource( unsigned sourceId ) = 0;
+	virtual void RewindSource( unsigned sourceId ) = 0;
+	// Playback position from the start of the queue in seconds. A position set before the playback is used when the source starts.
+	virtual float GetSourceOffset( unsigned sourceId ) const = 0;
+	virtual void SetSourceOffset( unsigned sourceId, float offset ) = 0;
+
+	// Append the buffers to the source queue.
+	virtual void QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds ) = 0;
+	// Remove up to maxCount played buffers from the start of the queue. Return the number of removed buffers.
+	virtual int UnqueueProcessedBuffers( unsigned sourceId, int maxCount, unsigned* result ) = 0;
+	virtual int GetQueuedBufferCount( unsigned sourceId ) const = 0;
+	// Remove all the buffers from the queue of a stopped source.
+	virtual void DetachBuffers( unsigned sourceId ) = 0;
+
+	virtual void SetListenerPosition( CVector3<float> position ) = 0;
+	virtual void SetListenerOrientation( CVector3<float> direction, CVector3<float> upVector ) = 0;
+	virtual void SetListenerVelocity( CVector3<float> velocity ) = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Gain of the inverse clamped distance model. The model is the OpenAL default and is used by the software mixer.
+inline float GetInverseClampedDistanceGain( float distance, float referenceDistance, float maxDistance, float rolloffFactor )
+{
+	const float clampedDistance = max( referenceDistance, min( maxDistance, distance ) );
+	const float denominator = referenceDistance + rolloffFactor * ( clampedDistance - referenceDistance );
+	return denominator > 0.0f ? referenceDistance / denominator : 1.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
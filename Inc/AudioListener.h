@@ -34,8 +34,6 @@ private:
 	CVector3<float> upVector;
 	CVector3<float> velocity;
 
-	void checkLastAudioError() const;
-
 	// Copying is prohibited.
 	CAudioListener( CAudioListener& ) = delete;
 	void operator=( CAudioListener& ) = delete;
@@ -10,7 +10,8 @@ namespace Audio {
 
 //////////////////////////////////////////////////////////////////////////
 
-// Representation of a playing audio source. Records can be stopped by the audio manager at any time.
+// Representation of a playing voice. A voice can be virtualized by the audio manager, in that case it keeps its position without producing any sound.
+// Records become invalid when the voice stops.
 class GINAPI CAudioRecord {
 public:
 	enum TRecordState {
@@ -21,10 +22,10 @@ public:
 	};
 
 	CAudioRecord() = default;
-	CAudioRecord( int recordPos, int generation );
+	CAudioRecord( int voicePos, int generation );
 
 	bool IsValid() const
-		{ return sourcePos != NotFound; }
+		{ return voicePos != NotFound; }
 
 	// State of the record.
 	TRecordState GetState() const;
@@ -39,14 +40,21 @@ public:
 	void Pause();
 	// Rewind the record to its initial state.
 	void Rewind();
+
+	// Volume multiplier of the record.
+	void SetGain( float newValue );
+	// Playback speed multiplier. Changes the pitch of the sound.
+	void SetPitch( float newValue );
+	// Stereo position from -1 ( left ) to 1 ( right ). A panned record is played relative to the listener at the distance of 1, its position is ignored.
+	// Zero pan returns the record to its position. Stereo sounds are never panned.
+	void SetPan( float newValue );
 	
 private:
-	// Record index in the context manager source array.
-	int sourcePos = NotFound;
-	// Record generation. Generation and sourcePos are used together to get an actual source index.
+	// Record index in the context manager voice array.
+	int voicePos = NotFound;
+	// Record generation. Generation and voicePos are used together to check if the voice still belongs to the record.
 	int recordGeneration = NotFound;
 
-	void checkLastAudioError() const;
 	int getRecordId() const;
 };
 
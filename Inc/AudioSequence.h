@@ -13,7 +13,10 @@ enum TAudioDataFormat {
 	ADF_Mono8 = 0x1100,	// AL_FORMAT_MONO8
 	ADF_Mono16 = 0x1101,	// AL_FORMAT_MONO16
 	ADF_Stereo8 = 0x1102,	// AL_FORMAT_STEREO8
-	ADF_Stereo16 = 0x1103	// AL_FORMAT_STEREO16
+	ADF_Stereo16 = 0x1103,	// AL_FORMAT_STEREO16
+	// Formats of the AL_EXT_FLOAT32 extension.
+	ADF_MonoFloat32 = 0x10010,	// AL_FORMAT_MONO_FLOAT32
+	ADF_StereoFloat32 = 0x10011	// AL_FORMAT_STEREO_FLOAT32
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -64,8 +67,6 @@ public:
 	
 private:
 	CStaticArray<unsigned> bufferIds;
-
-	void checkAudioError();
 };
 
 //////////////////////////////////////////////////////////////////////////
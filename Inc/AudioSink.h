@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Receiver of the software mixer output.
+class GINAPI IAudioSink {
+public:
+	virtual ~IAudioSink() {}
+
+	// Accept the mixed frames. Frames are interleaved stereo samples in the [-1, 1] range.
+	virtual void WriteFrames( CArrayView<float> samples, int sampleRate ) = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Sink that discards the output. Used to run the mixer without an audio device.
+class GINAPI CNullAudioSink : public IAudioSink {
+public:
+	// Total number of received frames.
+	__int64 GetFrameCount() const
+		{ return frameCount; }
+	// Largest absolute sample value of the received frames.
+	float GetPeakLevel() const
+		{ return peakLevel; }
+
+	virtual void WriteFrames( CArrayView<float> samples, int sampleRate ) override final;
+
+private:
+	__int64 frameCount = 0;
+	float peakLevel = 0.0f;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Sink that writes the output to a 16 bit stereo WAV file.
+// The sizes in the file header are updated when the sink is closed.
+class GINAPI CWavFileSink : public IAudioSink {
+public:
+	explicit CWavFileSink( CStringPart fileName );
+	~CWavFileSink();
+
+	__int64 GetFrameCount() const
+		{ return frameCount; }
+
+	virtual void WriteFrames( CArrayView<float> samples, int sampleRate ) override final;
+	// Finish the file header. No frames can be written after that.
+	void Close();
+
+private:
+	CDynamicFile wavFile;
+	__int64 frameCount = 0;
+	int sampleRate = 0;
+	// Converted samples.
+	CArray<short> buffer;
+
+	void writeHeader();
+
+	// Copying is prohibited.
+	CWavFileSink( CWavFileSink& ) = delete;
+	void operator=( CWavFileSink& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
@@ -0,0 +1,82 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+
+namespace Gin {
+
+class CImageData;
+//////////////////////////////////////////////////////////////////////////
+
+// Quality tiers of the block compressor.
+enum TBlockCompressionQuality {
+	// Endpoints are taken from the bounding box of the block and the indices are found by projection. Suitable for runtime compression.
+	BCQ_Fast,
+	// Endpoints are placed on the principal axis of the block and refined once with least squares.
+	BCQ_Normal,
+	// Endpoints are refined until the error stops decreasing, alternative endpoint modes are tried as well.
+	BCQ_High
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// CPU compressor of BC1 (DXT1), BC3 (DXT5), BC4 and BC5 images.
+// BC1 and BC3 blocks are created from the RGBA channels of 8-bit images. BC4 takes the red channel, BC5 takes the red and green channels.
+// Missing color channels are read as zero, missing alpha is read as opaque. Edge blocks of images that are not multiples of four repeat the last row and column.
+// sRGB formats are compressed in the stored color space. Rows of blocks are distributed between worker threads.
+class GINAPI CBlockCompressor {
+public:
+	TBlockCompressionQuality GetQuality() const
+		{ return quality; }
+	void SetQuality( TBlockCompressionQuality newValue )
+		{ quality = newValue; }
+
+	int GetWorkerCount() const
+		{ return workerCount; }
+	void SetWorkerCount( int newValue );
+
+	// Check if the compression type can be produced by the compressor.
+	static bool IsCompressionSupported( TTextureCompressionType type );
+
+	// Create a compressed copy of an uncompressed 8-bit image with all its mipmap levels, array elements and cube faces.
+	// The image must be two-dimensional. Row order of the source is preserved.
+	CImageData Compress( const CImageData& source, TTextureCompressionType type ) const;
+
+	// Compress a 4x4 block of RGBA pixels to an 8-byte BC1 color block. Alpha is ignored.
+	void CompressColorBlock( const BYTE* rgbaPixels, BYTE* result ) const;
+	// Compress 16 values of a single channel to an 8-byte BC4 block. This is also the alpha block of BC3.
+	// Values are read from the block pixels with the given stride in bytes.
+	void CompressChannelBlock( const BYTE* values, int stride, BYTE* result ) const;
+
+private:
+	// Location of the channels in a source pixel.
+	struct CSourceLayout {
+		int PixelSize = 0;
+		// Byte offset of the red, green, blue and alpha channels. NotFound for missing channels.
+		int ChannelOffsets[4];
+	};
+
+	TBlockCompressionQuality quality = BCQ_Normal;
+	int workerCount = 1;
+
+	static void getSourceLayout( const CImageData& source, CSourceLayout& result );
+	static int getBlockSize( TTextureCompressionType type );
+	static void fetchBlock( const BYTE* image, int width, int height, const CSourceLayout& layout, int blockX, int blockY, BYTE* result );
+	void compressBlock( TTextureCompressionType type, const BYTE* rgbaPixels, BYTE* result ) const;
+
+	static void findRangeEndpoints( const BYTE* rgbaPixels, float* first, float* second );
+	static bool findPrincipalEndpoints( const BYTE* rgbaPixels, float* first, float* second );
+	static bool refineColorEndpoints( const BYTE* rgbaPixels, unsigned indices, float* first, float* second );
+	static int findColorIndices( const BYTE* rgbaPixels, int first, int second, unsigned& indices );
+	static unsigned projectColorIndices( const BYTE* rgbaPixels, int first, int second );
+	static void writeColorBlock( int first, int second, unsigned indices, BYTE* result );
+
+	static int findChannelIndices( const int* values, int first, int second, unsigned __int64& indices );
+	static unsigned __int64 projectChannelIndices( const int* values, int first, int second );
+	static bool refineChannelEndpoints( const int* values, unsigned __int64 indices, int& first, int& second );
+	static void writeChannelBlock( int first, int second, unsigned __int64 indices, BYTE* result );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
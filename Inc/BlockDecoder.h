@@ -0,0 +1,45 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+
+namespace Gin {
+
+class CImageData;
+//////////////////////////////////////////////////////////////////////////
+
+// CPU decoder of DXT1, DXT3, DXT5, BC4 and BC5 images to RGBA8 pixels.
+// Used for thumbnails, tooling and contexts that do not support S3TC. Interpolation follows the S3TC and RGTC specifications with integer rounding down.
+// BC4 and BC5 channels are written to red and green, the remaining color channels are zero and alpha is opaque.
+// Rows of a color block are decoded with SSE2 if it is available. Rows of blocks are distributed between worker threads.
+class GINAPI CBlockDecoder {
+public:
+	int GetWorkerCount() const
+		{ return workerCount; }
+	void SetWorkerCount( int newValue );
+
+	// Check if the compression type can be decoded.
+	static bool IsDecodingSupported( TTextureCompressionType type );
+
+	// Create an RGBA8 copy of a compressed image with all its mipmap levels, array elements and cube faces.
+	// The image must be two-dimensional. Row order of the source is preserved.
+	CImageData Decode( const CImageData& source ) const;
+	// Decode a single image to RGBA8. Exactly width * height * 4 bytes of the given mipmap level are written to result.
+	void DecodeImage( const CImageData& source, int mipmapLevel, int arrayIndex, int cubeFace, BYTE* result ) const;
+
+	// Decode a single block to a 4x4 block of RGBA pixels in row order.
+	static void DecodeBlock( TTextureCompressionType type, const BYTE* block, BYTE* rgbaPixels );
+
+private:
+	int workerCount = 1;
+
+	static int getBlockSize( TTextureCompressionType type );
+	void decodeImage( TTextureCompressionType type, const BYTE* blocks, int width, int height, BYTE* result ) const;
+	static void decodeColorBlock( const BYTE* block, bool allowThreeColorMode, BYTE* rgbaPixels );
+	static void decodeExplicitAlphaBlock( const BYTE* block, BYTE* values, int stride );
+	static void decodeChannelBlock( const BYTE* block, BYTE* values, int stride );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,27 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Scoped ownership of a critical section.
+class CCriticalSectionLock {
+public:
+	explicit CCriticalSectionLock( CRITICAL_SECTION& _section ) : section( _section )
+		{ ::EnterCriticalSection( &section ); }
+	~CCriticalSectionLock()
+		{ ::LeaveCriticalSection( &section ); }
+
+private:
+	CRITICAL_SECTION& section;
+
+	// Copying is prohibited.
+	CCriticalSectionLock( CCriticalSectionLock& ) = delete;
+	void operator=( CCriticalSectionLock& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
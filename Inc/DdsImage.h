@@ -6,6 +6,7 @@
 namespace Gin {
 
 class CImageData;
+class CFileMapping;
 //////////////////////////////////////////////////////////////////////////
 
 // Exception that occurs while trying to extract data from a DDS file.
@@ -33,21 +34,42 @@ public:
 	// Get all the data associated with the texture.
 	// topLeftOrigin indicates that the source image should be flipped vertically to match the bottom left origin in OpenGL.
 	CImageData CreateImageData( bool topLeftOrigin = true );
+	// Get the texture data without copying it. Images reference the memory mapped file contents which stay mapped while the data exists.
+	// Unlike CreateImageData, the data is never flipped: images keep the top left origin of the file and are upside down in OpenGL.
+	// Callers that need the bottom left origin copy the images with CImageData::CopyImageData.
+	// Texture arrays and cubemaps with more than one mipmap level are rejected, their levels are not contiguous in the file.
+	CImageData CreateMappedImageData();
 	// Write an existing texture data to the file.
 	void WriteImageData( const CImageData& data );
 	
 private:
+	// Image parameters taken from the file headers.
+	struct CImageParameters {
+		TTextureType Type;
+		int Width;
+		int Height;
+		int Depth;
+		int MipmapCount;
+		int ArrayCount;
+		TTextureCompressionType CompressionType;
+		TTexelFormat Format;
+		TTexelDataType DataType;
+	};
+
 	// Name of the file with the texture data.
 	CString textureFileName;
 
 	CArray<BYTE> readFileBuffer();
-	void parseMagicNumber( CArray<BYTE>& data );
-	void parseDdsHeader(  CArray<BYTE>& data, DDS::CDdsHeader& result );
+	void checkFileSize( int fileSize );
+	int parseHeaders( CArrayView<BYTE> data, CImageParameters& result );
+	void parseMagicNumber( CArrayView<BYTE> data );
+	void parseDdsHeader( CArrayView<BYTE> data, DDS::CDdsHeader& result );
 	static bool hasDxtHeader( const DDS::CDdsHeader& header );
-	void getOrCreateDxtHeader( CArray<BYTE>& data, int& pos, const DDS::CDdsHeader& header, DDS::CDxt10Header& result );
+	void getOrCreateDxtHeader( CArrayView<BYTE> data, int& pos, const DDS::CDdsHeader& header, DDS::CDxt10Header& result );
 	void createDxtHeader( const DDS::CDdsHeader& header, DDS::CDxt10Header& result );
 
-	CImageData parseTextureData( CArray<BYTE>& data, int pos, const DDS::CDdsHeader& header, const DDS::CDxt10Header& dxtHeader, bool shouldFlip );
+	void getImageParameters( const DDS::CDdsHeader& header, const DDS::CDxt10Header& dxtHeader, CImageParameters& result ) const;
+	CImageData parseTextureData( CArrayView<BYTE> data, int pos, const CImageParameters& params, bool shouldFlip );
 	void getTextureParameters( const DDS::CDdsHeader& header, const DDS::CDxt10Header& dxtHeader, TTextureType& type, int& width, int& height, int& depth ) const;
 	void getTexelParameters( const DDS::CDdsHeader& header, const DDS::CDxt10Header& dxtHeader, TTextureCompressionType& compressionType, TTexelFormat& format, TTexelDataType& dataType ) const;
 	DDS::TDXGIFormat findDxgiFormat( const DDS::CDdsHeader& header ) const;
@@ -44,6 +44,10 @@ enum TDdsFourCCFlag {
 	DCF_DXT1 = 0x31545844,
 	DCF_DXT3 = 0x33545844,
 	DCF_DXT5 = 0x35545844,
+	DCF_ATI1 = 0x31495441,
+	DCF_ATI2 = 0x32495441,
+	DCF_BC4U = 0x55344342,
+	DCF_BC5U = 0x55354342,
 	DCF_DX10 = 0x30315844
 };
 
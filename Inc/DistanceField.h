@@ -0,0 +1,42 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Generator of signed distance fields from coverage bitmaps.
+// The field is stored in bytes: 128 is the outline, greater values are inside the shape, smaller values are outside.
+// Values change linearly and reach the byte limits at the spread distance from the outline.
+// Partially covered pixels are used to place the outline with sub-pixel precision.
+// Scratch buffers are kept between calls, so a single generator can process many bitmaps without allocations.
+class GINAPI CDistanceFieldGenerator {
+public:
+	// Default distance in pixels that is represented on each side of the outline.
+	static const int DefaultSpread = 4;
+
+	// Size of the field generated for a bitmap. The field has a border of spread pixels around the bitmap.
+	static CVector2<int> GetFieldSize( CVector2<int> bitmapSize, int spread );
+
+	// Generate a distance field from the coverage bitmap. Rows of both the bitmap and the result go from top to bottom.
+	// The result buffer must have space for GetFieldSize( bitmapSize, spread ) pixels.
+	void Generate( const BYTE* bitmap, CVector2<int> bitmapSize, int pitch, int spread, CArrayBuffer<BYTE> result );
+
+private:
+	// Squared distances to the closest pixel outside and inside the shape.
+	CArray<float> outerGrid;
+	CArray<float> innerGrid;
+	// Buffers of the one-dimensional transform.
+	CArray<float> sampleValues;
+	CArray<float> envelopeBounds;
+	CArray<int> envelopeRoots;
+
+	void initializeGrids( const BYTE* bitmap, CVector2<int> bitmapSize, int pitch, int spread, CVector2<int> fieldSize );
+	void transformGrid( CArray<float>& grid, CVector2<int> size );
+	void transformLine( float* line, int length, int stride );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,58 @@
+#pragma once
+#include <GinDefs.h>
+#include <GlyphProvider.h>
+#include <DistanceField.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Glyph with a distance field bitmap.
+class GINAPI CDistanceFieldGlyph : public IGlyph {
+public:
+	CDistanceFieldGlyph( CGlyphSizeData _sizeData, CArray<BYTE> _bitmap ) : sizeData( _sizeData ), bitmap( move( _bitmap ) ) {}
+
+	// IGlyph.
+	virtual CGlyphData GetGlyphData() const override final
+		{ return CGlyphData{ sizeData, bitmap.Ptr() }; }
+
+private:
+	CGlyphSizeData sizeData;
+	CArray<BYTE> bitmap;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Provider that converts glyphs of another provider into signed distance fields.
+// Distance field glyphs can be scaled without losing the sharpness of the outline, a single atlas serves all the text sizes.
+// Glyph bitmaps are extended by the spread in each direction, metrics are adjusted accordingly.
+class GINAPI CDistanceFieldGlyphProvider : public IGlyphProvider {
+public:
+	explicit CDistanceFieldGlyphProvider( CPtrOwner<IGlyphProvider> sourceProvider, int spread = CDistanceFieldGenerator::DefaultSpread );
+
+	int GetSpread() const
+		{ return spread; }
+
+	// IGlyphProvider.
+	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+	virtual void GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const override final;
+	virtual bool HasKerning() const override final
+		{ return sourceProvider->HasKerning(); }
+	virtual int GetKerning( int leftUtf32, int rightUtf32 ) const override final
+		{ return sourceProvider->GetKerning( leftUtf32, rightUtf32 ); }
+	virtual CPtrOwner<IGlyphProvider> CreateWorkerCopy() const override final;
+
+private:
+	CPtrOwner<IGlyphProvider> sourceProvider;
+	int spread;
+	mutable CDistanceFieldGenerator generator;
+	// Source glyphs of a batch request.
+	mutable CGlyphBatch sourceBatch;
+
+	static CGlyphSizeData getFieldSizeData( CGlyphSizeData sourceData, int fieldSpread );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -69,6 +69,7 @@ enum TMeshDrawMode {
 enum TGlType {
 	GLT_Undefined = -1,
 	GLT_UnsignedByte = 0x1401,	// gl::UNSIGNED_BYTE
+	GLT_Short = 0x1402,	// gl::SHORT
 	GLT_UnsignedShort = 0x1403,	// gl::UNSIGNED_SHORT
 	GLT_Int = 0x1404,	// gl::INT
 	GLT_UnsignedInt = 0x1405,	// gl::UNSIGNED_INT
@@ -170,6 +171,7 @@ enum TTexelDataType {
 	TDT_UnsignedInt = 0x1405,	// gl::UNSIGNED_INT
 	TDT_Int = 0x1404,	// gl::INT
 	TDT_Float = 0x1406,	// gl::FLOAT
+	TDT_HalfFloat = 0x140B,	// gl::HALF_FLOAT
 	TDT_UnsignedByte332 = 0x8032,	// gl::UNSIGNED_BYTE_3_3_2
 	TDT_UnsingedByte233Rev = 0x8362,	// gl::UNSIGNED_BYTE_2_3_3_REV
 	TDT_UnsignedShort565 = 0x8363,	// gl::UNSIGNED_SHORT_5_6_5
@@ -233,7 +235,9 @@ enum TTextureCompressionType {
 	TCT_Dxt5 = 0x83F3,	// gl::COMPRESSED_RGBA_S3TC_DXT5_EXT
 	TCT_Dxt1_sRGB = 0x8C4C,	// gl::COMPRESSED_SRGB_S3TC_DXT1_EXT
 	TCT_Dxt3_sRGBA = 0x8C4E,	// gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
-	TCT_Dxt5_sRGBA = 0x8C4F	// gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+	TCT_Dxt5_sRGBA = 0x8C4F,	// gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+	TCT_Bc4 = 0x8DBB,	// gl::COMPRESSED_RED_RGTC1
+	TCT_Bc5 = 0x8DBD	// gl::COMPRESSED_RG_RGTC2
 };
 
 // Supported texture types.
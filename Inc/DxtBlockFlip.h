@@ -0,0 +1,40 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+namespace GinInternal {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Layouts of the DXT blocks that can be flipped.
+enum TDxtBlockType {
+	// 8-byte color block.
+	DBT_Dxt1,
+	// 16-byte block with explicit alpha.
+	DBT_Dxt3,
+	// 16-byte block with interpolated alpha.
+	DBT_Dxt5,
+	// 8-byte single channel block.
+	DBT_Bc4,
+	// 16-byte block with two channels.
+	DBT_Bc5
+};
+
+// Size of a single block in bytes.
+int GINAPI GetDxtBlockSize( TDxtBlockType type );
+
+// Flip the pixel rows of a single block without SSE2. The register flips give the same result.
+void GINAPI FlipDxtBlock( TDxtBlockType type, BYTE* dest, const BYTE* src );
+// Flip the pixel rows of each block in src and write the result to dest. dest may be equal to src.
+// byteCount must be a multiple of the block size. Blocks are processed with SSE2 if it is available.
+void GINAPI FlipDxtBlocks( TDxtBlockType type, BYTE* dest, const BYTE* src, int byteCount );
+// Flip the pixel rows of each block in both ranges and exchange the ranges. The ranges may be the same.
+void GINAPI SwapFlipDxtBlocks( TDxtBlockType type, BYTE* first, BYTE* second, int byteCount );
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace GinInternal.
+
+}	// namespace Gin.
+
@@ -57,15 +57,26 @@ private:
 // Fixed step engine implementation. 
 class GINAPI CFixedStepEngine : public CEngine {
 public:
-	explicit CFixedStepEngine( int maxFPS );
+	explicit CFixedStepEngine( int _maxFPS );
 
 	// IEngine.
 	virtual CFrameInformation AdvanceFrame() override final;
 
 	// Set the FPS cap in milliseconds.
 	void SetMaxFPS( int newValue );
+	int GetMaxFPS() const
+		{ return maxFPS; }
+
+	// In the capture mode every frame is advanced by the fixed step without waiting for the real time.
+	// Recorded frames are evenly spaced in the game time no matter how long the drawing and the capture take.
+	bool IsCaptureMode() const
+		{ return isCaptureMode; }
+	void SetCaptureMode( bool isSet )
+		{ isCaptureMode = isSet; }
 
 private:
+	int maxFPS;
+	bool isCaptureMode = false;
 	// Size of the fixed step in seconds.
 	TTime stepSize;
 	// Step size in QueryPerformanceCounter units.
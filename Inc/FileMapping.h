@@ -0,0 +1,39 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Read-only view of a whole file mapped into the address space.
+// File contents are paged in on demand and are shared with the system file cache.
+class GINAPI CFileMapping {
+public:
+	explicit CFileMapping( CStringPart fileName );
+	~CFileMapping();
+
+	CStringView GetFileName() const
+		{ return fileName; }
+	// Contents of the file. The view stays valid for the lifetime of the mapping.
+	CArrayView<BYTE> GetData() const
+		{ return CArrayView<BYTE>( view, size ); }
+
+private:
+	CString fileName;
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = nullptr;
+	const BYTE* view = nullptr;
+	int size = 0;
+
+	void close();
+	void checkMappingError( bool condition );
+
+	// Copying is prohibited.
+	CFileMapping( CFileMapping& ) = delete;
+	void operator=( CFileMapping& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -1,5 +1,6 @@
 #pragma once
 #include <Gindefs.h>
+#include <GlyphInc.h>
 
 struct FT_Library_Rec_;
 typedef struct FT_LibraryRec_* FT_Library;
@@ -15,6 +16,7 @@ namespace Gin {
 class GINAPI CFontView {
 public:
 	CFontView() = default;
+	// Views of the faces that were not loaded by a font owner have no font data and can't create face copies.
 	explicit CFontView( FT_Face face ) : fontFace( face ) {}
 	explicit CFontView( const CFontOwner& owner );
 
@@ -37,10 +39,24 @@ public:
 	CGlyph GetGlyph( unsigned charCode, CFontSizeView fontSize ) const;
 	// Get the glyph structure for the given glyph index.
 	CGlyph GetGlyphByIndex( unsigned glyphIndex, CFontSizeView fontSize ) const;
+	// Render the glyph into the glyph slot of the face without creating a glyph object.
+	// Returned bitmap stays valid until the next glyph is loaded by the face.
+	CGlyphData RenderGlyphByIndex( unsigned glyphIndex, CFontSizeView fontSize ) const;
+
+	// Check if the font contains kerning information.
+	bool HasKerning() const;
+	// Horizontal kerning between two glyphs in pixels.
+	int GetKerning( unsigned leftGlyphIndex, unsigned rightGlyphIndex, CFontSizeView fontSize ) const;
+
+	// Open a new face from the same font data. Faces can be used on different threads.
+	// The copy shares the font data with the original and must be destroyed before it.
+	CFontOwner CreateFaceCopy() const;
 
 protected:
 	// FreeType internal structure.
 	FT_Face fontFace = nullptr;
+	// Memory buffer of the font file that the face was created from.
+	CArrayView<BYTE> fontData;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -50,6 +66,8 @@ class GINAPI CFontEdit : public CFontView {
 public:
 	FT_Face& GetFtFace()
 		{ return fontFace; }
+	void SetFontData( CArrayView<BYTE> newValue )
+		{ fontData = newValue; }
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -90,6 +108,8 @@ public:
 
 	// Initialization functions need access to the FT_Library object to fill it.
 	friend class CFreeTypeInitializer;
+	// Views create face copies.
+	friend class CFontView;
 
 private:
 	// Buffer with the font data.
@@ -99,6 +119,9 @@ private:
 
 	static FT_Library freeTypeLib;
 
+	// Take ownership of a face that was created from the font data of another owner.
+	CFontOwner( FT_Face face, CArrayView<BYTE> sharedData );
+
 	void cleanup();
 	void detachView();
 
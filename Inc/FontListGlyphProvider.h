@@ -12,9 +12,23 @@ public:
 	void AddFont( CFontView fontView, int fontPxHeight );
 	// IGlyphProvider.
 	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+	virtual void GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const override final;
+	virtual bool HasKerning() const override final;
+	virtual int GetKerning( int leftUtf32, int rightUtf32 ) const override final;
+	virtual CPtrOwner<IGlyphProvider> CreateWorkerCopy() const override final;
 
 private:
+	// Font that contains the character and the glyph index in that font.
+	struct CGlyphSource {
+		int FontIndex = 0;
+		unsigned GlyphIndex = 0;
+	};
+
 	CArray<CFreeTypeGlyphProvider> fontList;
+	// Sources of the characters that have been requested. Characters missing from all the fonts are taken from the first one.
+	mutable CMap<unsigned, CGlyphSource> glyphSources;
+
+	CGlyphSource findGlyphSource( unsigned utf32 ) const;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -8,13 +8,45 @@
 #include <SamplerObject.h>
 #include <PixelRect.h>
 #include <GlyphInc.h>
+#include <GlyphCache.h>
+#include <TextMeshCache.h>
+#include <TextLayout.h>
 
 namespace Gin {
 
 class CFontRenderer;
+class CTextBatch;
 class CPixelVector;
 //////////////////////////////////////////////////////////////////////////
 
+// Contents of the glyph atlas.
+enum TGlyphAtlasMode {
+	// Glyph coverage bitmaps rendered for a single font size.
+	GAM_Coverage,
+	// Signed distance fields. Text can be drawn with any scale.
+	GAM_DistanceField
+};
+
+// Draw call statistics of the text rendering.
+struct CTextDrawStatistics {
+	// Number of draw calls issued by DisplayText and DisplayTextBatch.
+	int DrawCallCount = 0;
+	// Number of glyph quads drawn by these calls.
+	int DrawnGlyphCount = 0;
+	// Number of text batch vertex buffer updates.
+	int BatchUploadCount = 0;
+	// Total size of the uploaded batch vertices.
+	int BatchUploadedByteCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Vertex of a glyph quad: pixel position in XY, atlas texel offset in ZW.
+// Glyph positions and atlas offsets are whole pixels, so 16-bit integers store them exactly as long as the layout fits in CFontRenderer::MaxTextExtent.
+typedef CVector4<short> CTextVertex;
+
+//////////////////////////////////////////////////////////////////////////
+
 // Mesh containing text position information. This object is returned by CFontRenderer rendering methods.
 class GINAPI CTextMesh {
 public:
@@ -41,18 +73,23 @@ public:
 
 private:
 	// Unicode text representation.
-	CGlBufferOwner<BT_Array, CVector4<float>> meshData;
+	CGlBufferOwner<BT_Array, CTextVertex> meshData;
 	// Mesh bounding rectangle.
 	CPixelRect boundRect;
-	CMeshOwner<CArrayMesh> mesh;
+	CMeshOwner<CElementMesh> mesh;
+	// Mesh that is used for drawing. Streamed text refers to the renderer's streaming mesh instead of its own.
+	CElementMesh drawMesh;
 	// Font renderer that created the mesh.
 	const CFontRenderer* owner = nullptr;
+	int firstVertex = 0;
 	int vertexCount = 0;
 
 	// Create an empty text mesh.
 	explicit CTextMesh( const CFontRenderer& owner );
 	// Move the created mesh into text mesh.
-	CTextMesh( CGlBufferOwner<BT_Array, CVector4<float>>&& dataSource, CMeshOwner<CArrayMesh>&& source, CPixelRect boundRect, const CFontRenderer& owner, int vertexCount );
+	CTextMesh( CGlBufferOwner<BT_Array, CTextVertex>&& dataSource, CMeshOwner<CElementMesh>&& source, CPixelRect boundRect, const CFontRenderer& owner, int vertexCount );
+	// Create a text mesh that refers to a range in a shared mesh.
+	CTextMesh( CElementMesh sharedMesh, int firstVertex, CPixelRect boundRect, const CFontRenderer& owner, int vertexCount );
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -70,7 +107,7 @@ struct CParagraphRenderResult {
 class GINAPI CFontRenderer {
 public:
 	CFontRenderer();
-	explicit CFontRenderer( CPtrOwner<IGlyphProvider> glyphProvider );
+	explicit CFontRenderer( CPtrOwner<IGlyphProvider> glyphProvider, TGlyphAtlasMode atlasMode = GAM_Coverage );
 	~CFontRenderer();
 
 	// Initialize the font shader. Called automatically during application initialization.
@@ -79,8 +116,11 @@ public:
 	static void ClearShaderData();
 
 	bool IsFontLoaded() const
-		{ return glyphProvider != nullptr; }
-	void SetGlyphProvider( CPtrOwner<IGlyphProvider> newValue );
+		{ return glyphCache.IsFontLoaded(); }
+	// Glyph provider must return distance field glyphs in the distance field mode.
+	void SetGlyphProvider( CPtrOwner<IGlyphProvider> newValue, TGlyphAtlasMode atlasMode = GAM_Coverage );
+	TGlyphAtlasMode GetAtlasMode() const
+		{ return atlasMode; }
 	// Unload all characters, delete the texture and invalidate all rendered text meshes.
 	void UnloadFont();
 
@@ -88,12 +128,31 @@ public:
 	void LoadBasicCharSet() const;
 	// Populate the texture with symbols from the given set or string.
 	void LoadCharSet( CUnicodePart str ) const;
+	// Populate the texture using several threads for glyph rasterization. The texture is updated once after all the glyphs are ready.
+	// Glyph provider must support worker copies, otherwise all the glyphs are rasterized on the calling thread.
+	void LoadCharSet( CUnicodePart str, int workerCount ) const;
 	// Access cached glyph data for a given UTF32 character.
 	// If the character has not been rendered, it is added to the texture.
 	CGlyphSizeData GetGlyphData( unsigned symbolUTF ) const;
+	// Kerning between two UTF32 characters. Kerning pairs are precomputed for the Latin range when the glyphs are added to the texture.
+	int GetKerning( unsigned leftUTF, unsigned rightUTF ) const;
+
+	// Number of vertices in a glyph quad.
+	static const int GlyphQuadVertexCount = 4;
+	// Maximum distance of a glyph edge from the origin of its mesh in pixels. Vertex coordinates are stored as 16-bit integers.
+	// Rendering a layout that exceeds this extent throws an exception.
+	static const int MaxTextExtent = SHRT_MAX;
 
 	// Shader program used to draw the font.
 	static CShaderProgram Shader();
+	// Shader program used to draw text batches.
+	static CShaderProgram BatchShader();
+	// Shader programs used to draw the text from a distance field atlas.
+	static CShaderProgram DistanceFieldShader();
+	static CShaderProgram DistanceFieldBatchShader();
+	// Shader programs that correspond to the renderer atlas mode.
+	CShaderProgram GetShader() const;
+	CShaderProgram GetBatchShader() const;
 	// Source name for log messages.
 	static CStringView GetMessageSource();
 
@@ -106,28 +165,73 @@ public:
 	CParagraphRenderResult RenderMultipleLines( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset ) const;
 	void RenderMultipleLines( CStringPart str, int lineWidth, int startHOffset, CArray<CTextMesh>& lines ) const;
 	CParagraphRenderResult RenderMultipleLines( CStringPart str, int lineWidth, int lineHeight, int startHOffset ) const;
-	// Draw the rendered string with the given pixel space position.
+	// Draw the rendered string with the given pixel space position. Shader that corresponds to the atlas mode must be active.
 	void DisplayText( const CTextMesh& textMesh, const CMatrix3<float>& modelToClip, float zOrder, CColor color ) const;
 
-private:
-	// Position and size information of the atlas with glyphs.
-	struct CGlyphAtlasState {
-		CVector2<int> Size;
-		CVector2<int> Offset;
-		int LineHeight = 0;
-	};
-
-	// Data that is necessary for rendering from the atlas.
-	struct CRenderGlyphData {
-		// Glyph metrics.
-		CGlyphSizeData GlyphData;
-		// Offset in the atlas in pixels.
-		CVector2<int> GlyphOffset;
-
-		CRenderGlyphData() : GlyphOffset( NotFound, NotFound ) {}
-		CRenderGlyphData( CGlyphSizeData data, CVector2<int> offset ) : GlyphData( data ), GlyphOffset( offset ) {}
-	};
+	// Render a single line without creating OpenGL objects. Quad vertices are added to the end of the array.
+	// Return the bounding rectangle of the line.
+	CPixelRect RenderLineVertices( CUnicodePart str, CArray<CTextVertex>& vertices ) const;
+	CPixelRect RenderLineVertices( CStringPart str, CArray<CTextVertex>& vertices ) const;
+	// Draw all the lines of the batch with a single draw call. Batch shader must be active.
+	void DisplayTextBatch( const CTextBatch& batch, const CMatrix3<float>& pixelToClip, float zOrder ) const;
+
+	// Separate the string into lines with a maximum width and place each glyph.
+	// Results are written to the caller provided storage, no memory is allocated except for glyphs that are seen for the first time.
+	CTextLayoutResult LayoutText( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset,
+		CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines ) const;
+	CTextLayoutResult LayoutText( CStringPart str, int lineWidth, int lineHeight, int startHOffset,
+		CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines ) const;
+	// Create glyph quads for the laid out glyphs. Vertex buffer must contain GlyphQuadVertexCount vertices for each glyph.
+	// Return the bounding rectangle of the quads.
+	CPixelRect RenderLayoutVertices( CArrayView<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextVertex> vertices ) const;
+	// Write the GlyphQuadVertexCount vertices of a glyph quad at the given offset. Return the bounding rectangle of the quad.
+	static CPixelRect AddGlyphQuad( CVector2<int> pos, CRenderGlyphData glyph, CArrayBuffer<CTextVertex> vertices, int vertexOffset );
+
+	// Cached rendering. Meshes are taken from the text mesh cache and rendered only if the text is not present.
+	// Returned meshes are owned by the cache and stay valid at least until the next AdvanceTextCacheFrame call.
+	const CTextMesh& RenderCachedLine( CUnicodePart str ) const;
+	const CTextMesh& RenderCachedLine( CStringPart str ) const;
+	const CTextMesh& RenderCachedMultipleLines( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset ) const;
+	const CTextMesh& RenderCachedMultipleLines( CStringPart str, int lineWidth, int lineHeight, int startHOffset ) const;
+	// Render a line into the shared streaming buffer. Useful for text that changes every frame.
+	// The returned mesh must be drawn before the next AdvanceTextCacheFrame call.
+	CTextMesh RenderStreamedLine( CUnicodePart str ) const;
+	CTextMesh RenderStreamedLine( CStringPart str ) const;
+	// Start a new frame of the text mesh cache.
+	// Meshes used in previous frames become available for eviction and the streaming buffer is reused.
+	void AdvanceTextCacheFrame() const;
+
+	const CTextMeshCacheStatistics& GetTextCacheStatistics() const
+		{ return meshCachePolicy.GetStatistics(); }
+	// Maximum amount of memory taken by the cached meshes.
+	int GetTextCacheBudget() const
+		{ return meshCachePolicy.GetByteBudget(); }
+	void SetTextCacheBudget( int byteCount )
+		{ meshCachePolicy.SetByteBudget( byteCount ); }
+
+	// Single lines are shaped once: decoded glyph codes and kerned positions are cached by the line text.
+	static const int DefaultShapingCacheBudget = CGlyphCache::DefaultShapingCacheBudget;
+	const CTextMeshCacheStatistics& GetShapingCacheStatistics() const
+		{ return glyphCache.GetShapingCacheStatistics(); }
+	int GetShapingCacheBudget() const
+		{ return glyphCache.GetShapingCacheBudget(); }
+	void SetShapingCacheBudget( int byteCount )
+		{ glyphCache.SetShapingCacheBudget( byteCount ); }
+
+	// New glyphs are written to a CPU copy of the atlas, the changed region is uploaded with a single texture update.
+	// Called automatically before drawing and on each AdvanceTextCacheFrame call.
+	void FlushGlyphAtlas() const;
+	const CGlyphAtlasStatistics& GetAtlasStatistics() const
+		{ return glyphCache.GetAtlas().GetStatistics(); }
+	void ResetAtlasStatistics() const
+		{ glyphCache.GetAtlas().ResetStatistics(); }
+	// A batch of any size is drawn with a single call, the batch vertices are uploaded only after the batch changes.
+	const CTextDrawStatistics& GetDrawStatistics() const
+		{ return drawStatistics; }
+	void ResetDrawStatistics() const
+		{ drawStatistics = CTextDrawStatistics(); }
 
+private:
 	struct CFontShaderData {
 		// Default shader program that is used for rendering.
 		CShaderProgramOwner FontProgram;
@@ -143,19 +247,62 @@ private:
 		CUniform<CMatrix3<float>> ModelToClipUniform;
 		// Text Z order.
 		CUniform<float> ZOrderUniform;
+		// Program for drawing text batches. Color and transformation are taken from vertices.
+		CShaderProgramOwner BatchProgram;
+		// Uniforms for the batch program.
+		CUniform<CVector2<float>> BatchAtlasSizeUniform;
+		CUniform<CTexture<TBT_Texture2, TGF_Red>> BatchFontUniform;
+		CUniform<CMatrix3<float>> BatchPixelToClipUniform;
+		CUniform<float> BatchZOrderUniform;
+		// Programs for drawing text from a distance field atlas.
+		CShaderProgramOwner DistanceFieldProgram;
+		CUniform<CColor> DistanceFieldColorUniform;
+		CUniform<CVector2<float>> DistanceFieldAtlasSizeUniform;
+		CUniform<CTexture<TBT_Texture2, TGF_Red>> DistanceFieldFontUniform;
+		CUniform<CMatrix3<float>> DistanceFieldModelToClipUniform;
+		CUniform<float> DistanceFieldZOrderUniform;
+		CShaderProgramOwner DistanceFieldBatchProgram;
+		CUniform<CVector2<float>> DistanceFieldBatchAtlasSizeUniform;
+		CUniform<CTexture<TBT_Texture2, TGF_Red>> DistanceFieldBatchFontUniform;
+		CUniform<CMatrix3<float>> DistanceFieldBatchPixelToClipUniform;
+		CUniform<float> DistanceFieldBatchZOrderUniform;
+		// Index buffer shared by all text meshes. Contains two triangles for each glyph quad.
+		CGlBufferOwner<BT_ElementArray, unsigned> QuadIndexBuffer;
+		// Number of quads in the index buffer.
+		int QuadIndexCapacity = 0;
 
 		CFontShaderData();
 		static CShaderProgramOwner createDefaultProgram();
+		static CShaderProgramOwner createBatchProgram();
+		static CShaderProgramOwner createDistanceFieldProgram();
+		static CShaderProgramOwner createDistanceFieldBatchProgram();
 	};
 
-	// Font used by the renderer.
-	CPtrOwner<IGlyphProvider> glyphProvider;
+	TGlyphAtlasMode atlasMode = GAM_Coverage;
 
-	// Map containing connections between symbol codes and their offset in the texture atlas.
-	mutable CMap<unsigned, CRenderGlyphData> fontData;
+	// Glyphs of the font, the CPU copy of the atlas and the shaped lines. The texture storage is resized to match the atlas capacity on the next flush.
+	mutable CGlyphCache glyphCache;
 	// Texture atlas with glyph bitmaps.
 	mutable CTextureOwner<TBT_Texture2, TGF_Red> fontTexture;
-	mutable CGlyphAtlasState fontTextureState;
+	// Size of the texture storage.
+	mutable CVector2<int> atlasTextureSize;
+
+	// Text mesh cache bookkeeping and the cached meshes themselves. Meshes are allocated separately to keep references stable.
+	mutable CTextMeshCachePolicy meshCachePolicy;
+	mutable CArray<CPtrOwner<CTextMesh>> cachedMeshes;
+	mutable CArray<int> evictedMeshSlots;
+	// Shared buffer for the streamed text. The storage is orphaned each frame.
+	mutable CGlBufferOwner<BT_Array, CTextVertex> streamBuffer;
+	mutable CMeshOwner<CElementMesh> streamMesh;
+	mutable CArray<CTextVertex> streamStagingBuffer;
+	// Streaming buffer size in vertices.
+	mutable int streamBufferCapacity = 0;
+	// Vertices written to the streaming buffer during the current frame.
+	mutable int streamVertexCount = 0;
+	// Vertices requested during the current frame, including the ones that did not fit.
+	mutable int streamRequestedVertexCount = 0;
+	// Draw calls and batch uploads since the last ResetDrawStatistics call.
+	mutable CTextDrawStatistics drawStatistics;
 
 	// Offset of the first printable character.
 	static const int asciiSymbolOffset = 32;
@@ -165,38 +312,34 @@ private:
 	static CPtrOwner<CFontShaderData> shaderData;
 	static CUnicodeString asciiCharsStr;
 
-	unsigned parseUtf16Character( CUnicodePart str, int& index ) const;
-	unsigned parseUtf8Character( CStringPart str, int& index ) const;
-	void fillTextureBuffer( CTextureOwner<TBT_Texture2, TGF_Red>& target, CVector2<int> textureOffset, const BYTE* bitmap, CVector2<int> bitmapSize ) const;
-	CGlyphAtlasState fitGlyphIntoAtlas( CGlyphAtlasState state, CVector2<int> glyphSize ) const;
-	void setGlyphAtlasState( CGlyphAtlasState newState ) const;
-	void padGlyphAtlas( CVector2<int> oldSize, CVector2<int> newSize ) const;
-
 	int calculateWhitespaceHAdvance( CUnicodePart str, int& strPos ) const;
 	int calculateWhitespaceHAdvance( CStringPart str, int& strPos ) const;
-	void addLineMesh( int lineStartPos, int strPos, CPixelRect lineRect, CArrayView<CVector4<float>> lineBuffer, CArray<CTextMesh>& lines ) const;
-	CPixelRect renderUtf8Word( CStringPart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CVector4<float>>& wordBuffer ) const;
-	CPixelRect renderUtf16Word( CUnicodePart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CVector4<float>>& wordBuffer ) const;
-	bool tryAddWordCharacter( unsigned glyphCode, int maxWidth, CVector2<int>& symbolPos, CPixelRect& wordRect, CArray<CVector4<float>>& wordBuffer ) const;
-	static CPixelRect startNewLine( float lineOffset, CPixelRect wordRect, CArrayBuffer<CVector4<float>> lineWordBuffer );
-	static CPixelRect startNewLine( CPixelVector lineOffset, CPixelRect wordRect, CArrayBuffer<CVector4<float>> lineWordBuffer );
-
-	CTextMesh doRenderTextLine( const void* lineBuffer, int length, void ( CFontRenderer::*renderMethod )( const void*, int, CPixelRect&, int&, CArrayBuffer<CVector4<float>> ) const ) const;
-	void renderSingleUtf16Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const;
+	void addLineMesh( int lineStartPos, int strPos, CPixelRect lineRect, CArrayView<CTextVertex> lineBuffer, CArray<CTextMesh>& lines ) const;
+	CPixelRect renderUtf8Word( CStringPart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CTextVertex>& wordBuffer ) const;
+	CPixelRect renderUtf16Word( CUnicodePart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CTextVertex>& wordBuffer ) const;
+	bool tryAddWordCharacter( unsigned glyphCode, int maxWidth, CVector2<int>& symbolPos, CPixelRect& wordRect, CArray<CTextVertex>& wordBuffer ) const;
+	static CPixelRect startNewLine( int lineOffset, CPixelRect wordRect, CArrayBuffer<CTextVertex> lineWordBuffer );
+	static CPixelRect startNewLine( CPixelVector lineOffset, CPixelRect wordRect, CArrayBuffer<CTextVertex> lineWordBuffer );
+
+	CTextMesh doRenderTextLine( const void* lineBuffer, int length, void ( CFontRenderer::*renderMethod )( const void*, int, CPixelRect&, int&, CArrayBuffer<CTextVertex> ) const ) const;
+	CTextMesh doRenderStreamedLine( const void* lineBuffer, int length, void ( CFontRenderer::*renderMethod )( const void*, int, CPixelRect&, int&, CArrayBuffer<CTextVertex> ) const ) const;
+	CMeshOwner<CElementMesh> createTextMesh( CGlBuffer<BT_Array, CTextVertex> vertexBuffer, int vertexCount ) const;
+	static void reserveQuadIndices( int quadCount );
+	void updateBatchBuffer( const CTextBatch& batch ) const;
+	const CTextMesh& addCachedMesh( const CTextMeshCacheKey& key, CArrayView<BYTE> text, CTextMesh mesh ) const;
+	void resizeStreamBuffer( int newCapacity ) const;
+	void renderSingleUtf16Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const;
 	void renderMultipleUtf16Lines( CUnicodePart str, int lineWidth, int lineHeight, CPixelRect& boundRect, int& totalVertexCount, CVector2<int>& lineOffset, 
-		CArrayBuffer<CVector4<float>> stringData ) const;
+		CArrayBuffer<CTextVertex> stringData ) const;
 	void renderMultipleUtf8Lines( CStringPart str, int lineWidth, int lineHeight, CPixelRect& boundRect, int& totalVertexCount, CVector2<int>& lineOffset,
-		CArrayBuffer<CVector4<float>> stringData ) const;
-	void copyWordToBuffer( CPixelRect wordRect, CArray<CVector4<float>>& wordBuffer, int lineWidth, int lineHeight, int prevLineEndPosX, CVector2<int>& linePos,
-		CPixelRect& boundRect, int& totalVertexCount, CArrayBuffer<CVector4<float>> stringData ) const;
-
-	void renderSingleUtf8Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const;
-	void renderUtf16Line( CUnicodePart line, CVector2<int>& pos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const;
-	void renderUtf8Line( CStringPart line, CVector2<int>& pos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const;
-	int addNewGlyph( unsigned glyphCode, CPixelRect& boundRect, CVector2<int>& fontPos, int symbolIndex, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const;
-	CPixelRect addQuadToMesh( CVector2<int> pos, CRenderGlyphData charData, CArrayBuffer<CVector4<float>> stringData, int meshOffset ) const;
-	void addCharToTexture( unsigned charCode, CRenderGlyphData& result ) const;
-	CRenderGlyphData getOrCreateRenderData( unsigned glyphCode ) const;
+		CArrayBuffer<CTextVertex> stringData ) const;
+	void copyWordToBuffer( CPixelRect wordRect, CArray<CTextVertex>& wordBuffer, int lineWidth, int lineHeight, int prevLineEndPosX, CVector2<int>& linePos,
+		CPixelRect& boundRect, int& totalVertexCount, CArrayBuffer<CTextVertex> stringData ) const;
+
+	void renderSingleUtf8Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const;
+	void renderUtf16Line( CUnicodePart line, CVector2<int>& pos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const;
+	void renderUtf8Line( CStringPart line, CVector2<int>& pos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const;
+	void renderShapedLine( const CShapedLine& line, CVector2<int>& fontPos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const;
 	static void initAsciiCharString( CUnicodeString& str );
 
 	// Copying and movement is prohibited.
@@ -0,0 +1,144 @@
+#pragma once
+#include <Gindefs.h>
+#include <PixelReadbackQueue.h>
+#include <ImageEncodeQueue.h>
+
+namespace Gin {
+
+class CFixedStepEngine;
+//////////////////////////////////////////////////////////////////////////
+
+// Output of the frame capture.
+enum TFrameCaptureFormat {
+	// Numbered PNG files in a folder. Files are named Frame000000.png, Frame000001.png and so on.
+	FCF_Png,
+	// Numbered uncompressed BMP files in a folder.
+	FCF_Bmp,
+	// A single uncompressed YUV4MPEG2 stream with 4:4:4 sampling.
+	FCF_Y4m
+};
+
+// Behavior of the capture when the readback buffers or the encode queue are full.
+enum TCaptureOverflowMode {
+	// Wait for the GPU and the encoders. Every frame is recorded.
+	COM_Wait,
+	// Skip the frame and count it as dropped. The render thread is never blocked by the encoders.
+	COM_Drop
+};
+
+// Frame capture parameters.
+struct CFrameCaptureSettings {
+	// Destination folder for the image formats, destination file name for the stream format.
+	CString Path;
+	TFrameCaptureFormat Format = FCF_Png;
+	TCaptureOverflowMode OverflowMode = COM_Wait;
+	int EncoderCount = 2;
+	// Number of read frames that can wait for the encoders.
+	int MaxQueuedFrameCount = 8;
+	int ReadbackBufferCount = CPixelReadbackQueue::DefaultBufferCount;
+};
+
+// Summary of the capture session.
+struct CFrameCaptureReport {
+	// Number of frames passed to the capture.
+	int FrameCount = 0;
+	// Frames skipped because the readback buffers or the encode queue were full.
+	int DroppedFrameCount = 0;
+	// Frames whose readback buffer couldn't be mapped.
+	int LostFrameCount = 0;
+	int WrittenFrameCount = 0;
+	// Frames the encoders failed to write.
+	int FailedFrameCount = 0;
+	// Number of times the render thread waited for a readback.
+	int ReadbackStallCount = 0;
+	// Real time since the start of the capture in seconds.
+	double Duration = 0.0;
+	// Time the encoders spent writing the frames in seconds, summed over all the encoders.
+	double EncodeTime = 0.0;
+	long long WrittenPixelCount = 0;
+
+	// Written frames per second of the real time.
+	double GetFrameThroughput() const
+		{ return Duration > 0.0 ? WrittenFrameCount / Duration : 0.0; }
+	// Written megapixels per second of the real time.
+	double GetPixelThroughput() const
+		{ return Duration > 0.0 ? WrittenPixelCount / Duration / 1e6 : 0.0; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Encoding part of the frame capture. Frames are numbered by the caller and written by the encode queue in the format of the settings.
+// No OpenGL calls are made, so the frames can come from any source. Frames must be added from a single thread.
+class GINAPI CCaptureFrameWriter {
+public:
+	// If an encoder is given, it writes the frames instead of the encoder of the settings format. The encoder must outlive the writer.
+	CCaptureFrameWriter( const CFrameCaptureSettings& settings, int frameRate, IImageEncoder* customEncoder = nullptr );
+
+	CImageEncodeStatistics GetStatistics() const
+		{ return encodeQueue.GetStatistics(); }
+	// Name of the file the frame is written to. Empty for the stream format.
+	CString GetFrameFileName( int frameIndex ) const;
+
+	// Queue a copy of the frame. Rows go from the bottom to the top and are aligned to 4 bytes. The stream format keeps the order of addition.
+	// Return false if the queue is full in the COM_Drop mode and the frame is dropped. In the COM_Wait mode the caller is blocked instead.
+	bool AddFrame( int frameIndex, CArrayView<BYTE> pixels, CVector2<int> size );
+	// Wait until all the frames are written.
+	void Flush()
+		{ encodeQueue.Flush(); }
+
+private:
+	const CFrameCaptureSettings settings;
+	CPtrOwner<IImageEncoder> formatEncoder;
+	CImageEncodeQueue encodeQueue;
+
+	static CPtrOwner<IImageEncoder> createEncoder( const CFrameCaptureSettings& captureSettings, int frameRate );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Recorder of the drawn frames.
+// The engine is put in the capture mode, so each frame is advanced by the same virtual step. Frames are read into a ring of pixel pack buffers
+// and passed to a bounded queue of encoder threads. CaptureFrame and Finish must be called on the thread with the rendering context.
+class GINAPI CFrameCapture : public IPixelReadbackListener {
+public:
+	// The engine must outlive the capture.
+	CFrameCapture( CFixedStepEngine& engine, CFrameCaptureSettings settings );
+	// Finish the capture.
+	~CFrameCapture();
+
+	const CFrameCaptureSettings& GetSettings() const
+		{ return settings; }
+	// Report on the frames processed so far.
+	CFrameCaptureReport GetReport() const;
+
+	// Record the current contents of the screen. Must be called once per frame after the frame is drawn.
+	void CaptureFrame();
+	// Write all the pending frames, leave the capture mode and return the final report.
+	CFrameCaptureReport Finish();
+
+	// IPixelReadbackListener.
+	virtual void OnReadbackComplete( int readbackId, CArrayView<BYTE> pixels, CVector2<int> size ) override final;
+	virtual void OnReadbackLost( int readbackId ) override final;
+
+private:
+	CFixedStepEngine& engine;
+	const CFrameCaptureSettings settings;
+	CCaptureFrameWriter frameWriter;
+	CPixelReadbackQueue readbackQueue;
+
+	long long startTime;
+	long long finishTime = 0;
+	bool isFinished = false;
+	int frameCount = 0;
+	int droppedFrameCount = 0;
+	int lostFrameCount = 0;
+
+	// Copying is prohibited.
+	CFrameCapture( CFrameCapture& ) = delete;
+	void operator=( CFrameCapture& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
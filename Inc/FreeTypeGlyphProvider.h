@@ -15,12 +15,30 @@ public:
 
 	unsigned GetGlyphIndex( int utf32 ) const;
 	CPtrOwner<IGlyph> GetGlyphByIndex( unsigned index ) const;
+	// Render the glyph without creating a glyph object. Bitmap is valid until the next glyph is rendered by the provider.
+	CGlyphData RenderGlyphByIndex( unsigned index ) const;
+
+	// Kerning between two glyphs of the font.
+	int GetKerningByIndex( unsigned leftIndex, unsigned rightIndex ) const;
+
+	// Create a provider with its own font face. The copy can rasterize glyphs concurrently with the original.
+	// Font data is shared, the copy must be destroyed before the original font.
+	CFreeTypeGlyphProvider CreateFaceCopy() const;
 
 	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+	virtual void GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const override final;
+	virtual bool HasKerning() const override final;
+	virtual int GetKerning( int leftUtf32, int rightUtf32 ) const override final;
+	virtual CPtrOwner<IGlyphProvider> CreateWorkerCopy() const override final;
 
 private:
+	// Face owned by the provider. Only face copies own their faces.
+	CFontOwner ownFace;
 	CFontView fontView;
 	CFontSizeOwner fontSize;
+	int fontPxHeight;
+
+	CFreeTypeGlyphProvider( CFontOwner&& face, int fontPxHeight );
 };
 
 //////////////////////////////////////////////////////////////////////////
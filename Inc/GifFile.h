@@ -0,0 +1,94 @@
+#pragma once
+#include <Gindefs.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Exception that occurs while trying to decode a GIF file.
+class GINAPI CGifException : public CFileWrapperException {
+public:
+	CGifException( CStringPart fileName, CStringPart additionalInfo ) : CFileWrapperException( fileName, additionalInfo ) {}
+
+	virtual CString GetMessageTemplate() const override
+		{ return Str( generalGifError ); }
+
+private:
+	static const CStringView generalGifError;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Decoded frames of a GIF animation.
+struct GINAPI CGifFrameSequence {
+	// Complete RGBA frames stored as the array elements of a two-dimensional image. Transparent pixels have zero alpha.
+	// The image can be uploaded as a texture array, so the playback only changes the layer index.
+	CImageData Frames;
+	// Display time of each frame in milliseconds.
+	CArray<int> FrameDelays;
+
+	CGifFrameSequence( CImageData&& frames, CArray<int>&& frameDelays ) : Frames( move( frames ) ), FrameDelays( move( frameDelays ) ) {}
+
+	// Total duration of the animation in milliseconds.
+	int GetDuration() const;
+	// Index of the frame that is displayed at the given time in milliseconds since the start of the animation. The animation is looped.
+	int FindFrame( int time ) const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Image in a GIF format.
+class GINAPI CGifFile {
+public:
+	explicit CGifFile( CStringPart fileName );
+
+	CStringView GetName() const
+		{ return fileName; }
+
+	// Decode all the frames of the animation. Each frame is composed over the previous ones according to their disposal methods.
+	// topLeftOrigin indicates that the frames should be flipped vertically to match the bottom left origin in OpenGL.
+	CGifFrameSequence CreateFrameSequence( bool topLeftOrigin = true ) const;
+
+private:
+	// Name of the file with the image data.
+	CString fileName;
+
+	CArray<BYTE> readFileBuffer() const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Loader that decodes the frames of a GIF file on a worker thread.
+class GINAPI CGifFrameLoader {
+public:
+	// Start decoding the file.
+	explicit CGifFrameLoader( CStringPart fileName, bool topLeftOrigin = true );
+	// Wait for the worker thread to finish.
+	~CGifFrameLoader();
+
+	// Check if the decoding has finished.
+	bool IsComplete() const;
+	// Wait for the decoding to finish and take the decoded frames. Exceptions thrown by the decoder are rethrown here.
+	// The frames can only be taken once.
+	CGifFrameSequence TakeResult();
+
+private:
+	struct CLoadTask;
+
+	CPtrOwner<CLoadTask> task;
+	HANDLE thread = nullptr;
+
+	void waitForCompletion();
+	static void runLoadTask( CLoadTask& loadTask );
+	static DWORD WINAPI loadProc( void* param );
+
+	// Copying is prohibited.
+	CGifFrameLoader( CGifFrameLoader& ) = delete;
+	void operator=( CGifFrameLoader& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
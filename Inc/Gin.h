@@ -7,6 +7,8 @@
 #include <Application.h>
 #include <BaseParticleEmitter.h>
 #include <BlendModeSwitcher.h>
+#include <BlockCompressor.h>
+#include <BlockDecoder.h>
 #include <BmpFile.h>
 #include <BoundUserInputAction.h>
 #include <BufferMapper.h>
@@ -18,12 +20,15 @@
 #include <ConsoleSystem.h>
 #include <DdsImage.h>
 #include <DefaultSamplerContainer.h>
+#include <DistanceField.h>
+#include <DistanceFieldGlyphProvider.h>
 #include <StandardWindowDispatcher.h>
 #include <DepthTestSwitcher.h>
 #include <DrawFunctions.h>
 #include <DrawMaskSwitchers.h>
 #include <Engine.h>
 #include <FaceCullSwitcher.h>
+#include <FileMapping.h>
 #include <FontRenderer.h>
 #include <Font.h>
 #include <FontListGlyphProvider.h>
@@ -31,6 +36,7 @@
 #include <FreeTypeGlyphProvider.h>
 #include <ForwardRenderer.h>
 #include <Framebuffer.h>
+#include <FrameCapture.h>
 #include <GifFile.h>
 #include <GinComponents.h>
 #include <GinGlobals.h>
@@ -39,7 +45,9 @@
 #include <GlWindow.h>
 #include <GlWindowUtils.h>
 #include <Glyph.h>
+#include <GlyphBatch.h>
 #include <ImageData.h>
+#include <ImageEncodeQueue.h>
 #include <InputBinding.h>
 #include <InputController.h>
 #include <InputHandler.h>
@@ -47,6 +55,7 @@
 #include <MainFrame.h>
 #include <MaterialDatabase.h>
 #include <Mesh.h>
+#include <MipmapGenerator.h>
 #include <Model.h>
 #include <NoisePermutationTable.h>
 #include <ObjFile.h>
@@ -54,8 +63,12 @@
 #include <ParticleShader.h>
 #include <ParticleSystem.h>
 #include <ParticleEmitter.h>
+#include <PixelConverter.h>
+#include <PixelReadbackPolicy.h>
+#include <PixelReadbackQueue.h>
 #include <PixelRect.h>
 #include <PixelVector.h>
+#include <PngEncoder.h>
 #include <PngFile.h>
 #include <Quad.h>
 #include <SamplerObject.h>
@@ -66,7 +79,12 @@
 #include <State.h>
 #include <StateManager.h>
 #include <Screenshots.h>
+#include <TextBatch.h>
 #include <TextureBinder.h>
+#include <TextureResidencyPolicy.h>
+#include <TextureStreamingManager.h>
+#include <TextureUploadPolicy.h>
+#include <TextureUploadQueue.h>
 #include <TextureWrappers.h>
 #include <Uniform.h>
 #include <UniformBlock.h>
@@ -76,10 +94,17 @@
 #include <AudioUtils.h>
 #include <AlGlobals.h>
 #include <AlContextManager.h>
+#include <AudioBackend.h>
+#include <OpenAlBackend.h>
+#include <SoftwareMixer.h>
+#include <AudioSink.h>
 #include <AudioSequence.h>
 #include <AudioRecord.h>
 #include <AudioListener.h>
 #include <OggFile.h>
+#include <SoundCache.h>
 #include <VideoSettingsUtils.h>
 #include <WavFile.h>
+#include <WavDecoder.h>
+#include <WavStream.h>
 #include <WavUtils.h>
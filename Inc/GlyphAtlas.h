@@ -0,0 +1,118 @@
+#pragma once
+#include <GinDefs.h>
+#include <GlyphInc.h>
+#include <GlyphBatch.h>
+
+namespace Gin {
+
+class IGlyphProvider;
+//////////////////////////////////////////////////////////////////////////
+
+// Glyph that is placed in the atlas.
+struct CAtlasGlyph {
+	// Glyph metrics.
+	CGlyphSizeData SizeData;
+	// Offset of the glyph bitmap in the atlas in pixels.
+	CVector2<int> Offset;
+};
+
+// Region of the atlas that must be copied to the texture.
+struct CGlyphAtlasUpload {
+	CVector2<int> Offset;
+	CVector2<int> Size;
+	// The texture storage must be recreated with the atlas capacity. The whole atlas is uploaded.
+	bool IsReallocation = false;
+
+	bool IsEmpty() const
+		{ return Size.X() == 0 || Size.Y() == 0; }
+};
+
+// Texture upload statistics of the glyph atlas.
+struct CGlyphAtlasStatistics {
+	// Number of texture update calls.
+	int UploadCount = 0;
+	// Total size of the uploaded texel data.
+	int UploadedByteCount = 0;
+	// Number of times the texture storage was recreated to fit more glyphs.
+	int ReallocationCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// CPU copy of a single channel glyph atlas. Glyphs are rasterized by a glyph provider and packed in rows.
+// The atlas keeps the region that has changed since the last upload, the owner copies this region to a texture.
+// No OpenGL calls are made and the atlas can be used without a rendering context.
+class GINAPI CGlyphAtlas {
+public:
+	// Distance between glyphs in the atlas.
+	static const int GlyphPadding = 1;
+	static const int MaxWidth = 1024;
+	// Texel offsets are stored as 16-bit integers in the text vertices.
+	static const int MaxHeight = SHRT_MAX;
+
+	// Size of the atlas storage. The storage grows when new glyphs do not fit.
+	CVector2<int> GetCapacity() const
+		{ return capacity; }
+	// Atlas texels. Rows are GetCapacity().X() bytes long.
+	CArrayView<BYTE> GetPixels() const
+		{ return pixels; }
+
+	// Region that has changed since the last ClearDirtyRegion call. Empty if the end does not exceed the start.
+	bool HasDirtyRegion() const
+		{ return dirtyEnd.X() > dirtyStart.X() && dirtyEnd.Y() > dirtyStart.Y(); }
+	CVector2<int> GetDirtyStart() const
+		{ return dirtyStart; }
+	CVector2<int> GetDirtyEnd() const
+		{ return dirtyEnd; }
+	void ClearDirtyRegion();
+
+	// Find the region that must be copied to a texture of the given size and clear the dirty region.
+	// Rows of the region are GetCapacity().X() bytes apart in GetPixels().
+	CGlyphAtlasUpload TakeUpload( CVector2<int> textureSize );
+	const CGlyphAtlasStatistics& GetStatistics() const
+		{ return statistics; }
+	void ResetStatistics()
+		{ statistics = CGlyphAtlasStatistics(); }
+
+	// Rasterize a single glyph and add it to the atlas.
+	// Glyphs that do not fit in the maximum atlas height throw an exception and leave the atlas unchanged.
+	CAtlasGlyph AddGlyph( const IGlyphProvider& provider, unsigned glyphCode );
+	// Rasterize several glyphs and add them to the atlas. Result must have an element for each glyph code.
+	// Additional workers rasterize the glyphs with the worker copies of the provider. The packing does not depend on the number of workers.
+	// If the rasterization fails, the atlas is left unchanged.
+	void AddGlyphs( const IGlyphProvider& provider, CArrayView<unsigned> glyphCodes, int workerCount, CArrayBuffer<CAtlasGlyph> result );
+
+	// Remove all the glyphs and free the storage.
+	void FreeBuffer();
+
+private:
+	// Position of the next glyph.
+	struct CPackingState {
+		// Size of the area that is taken by the glyphs.
+		CVector2<int> Size;
+		// End of the last glyph in the current row.
+		CVector2<int> Offset;
+		int LineHeight = 0;
+	};
+
+	CPackingState packingState;
+	CArray<BYTE> pixels;
+	CVector2<int> capacity;
+	CVector2<int> dirtyStart;
+	CVector2<int> dirtyEnd;
+	CGlyphAtlasStatistics statistics;
+	// Storage for the glyphs that are added one at a time.
+	CGlyphBatch singleGlyphBatch;
+
+	static void rasterizeGlyphs( const IGlyphProvider& provider, CArrayView<unsigned> glyphCodes, int workerCount, CArray<CGlyphBatch>& taskBatches );
+	static void sortGlyphsByHeight( CArrayView<CGlyphData> glyphs, CArray<int>& order );
+	static CPackingState fitGlyph( CPackingState state, CVector2<int> glyphSize );
+	void setPackingState( CPackingState newState );
+	void grow( CVector2<int> requiredSize );
+	void stageGlyphBitmap( CVector2<int> atlasOffset, CGlyphData glyph );
+	void markDirty( CVector2<int> start, CVector2<int> end );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
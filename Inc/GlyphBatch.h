@@ -0,0 +1,48 @@
+#pragma once
+#include <GinDefs.h>
+#include <GlyphInc.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Collection of rasterized glyphs in contiguous storage: an array of metric records and a single packed bitmap blob.
+// Bitmap rows are tightly packed, pitch of each glyph is equal to its width.
+// Emptying the batch keeps the memory, so a batch can be reused without allocations.
+class GINAPI CGlyphBatch {
+public:
+	int Size() const
+		{ return glyphs.Size(); }
+	bool IsEmpty() const
+		{ return glyphs.IsEmpty(); }
+	// Total size of the glyph bitmaps in bytes.
+	int GetBitmapByteCount() const
+		{ return bitmaps.Size(); }
+
+	// Data of the glyph with the given index. Bitmap pointers are invalidated when a glyph is added.
+	CGlyphData GetGlyphData( int index ) const;
+
+	// Copy the glyph into the batch. Return the index of the new glyph.
+	int AddGlyph( CGlyphData glyphData );
+	// Add a glyph with the given metrics and return its uninitialized bitmap storage.
+	CArrayBuffer<BYTE> AddGlyphBitmap( CGlyphSizeData sizeData );
+
+	// Remove all the glyphs. Allocated memory is kept.
+	void Empty();
+	void FreeBuffer();
+
+private:
+	struct CBatchGlyph {
+		CGlyphSizeData SizeData;
+		// Position of the bitmap in the blob.
+		int BitmapOffset = 0;
+	};
+
+	CArray<CBatchGlyph> glyphs;
+	CArray<BYTE> bitmaps;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,115 @@
+#pragma once
+#include <GinDefs.h>
+#include <GlyphInc.h>
+#include <GlyphAtlas.h>
+#include <TextMeshCache.h>
+#include <TextLayout.h>
+
+namespace Gin {
+
+class IGlyphProvider;
+//////////////////////////////////////////////////////////////////////////
+
+// Data that is necessary for rendering a glyph from the atlas.
+struct CRenderGlyphData {
+	// Glyph metrics.
+	CGlyphSizeData GlyphData;
+	// Offset in the atlas in pixels.
+	CVector2<int> GlyphOffset;
+
+	CRenderGlyphData() : GlyphOffset( NotFound, NotFound ) {}
+	CRenderGlyphData( CGlyphSizeData data, CVector2<int> offset ) : GlyphData( data ), GlyphOffset( offset ) {}
+};
+
+// Glyph codes and positions of a single line.
+struct CShapedLine {
+	CArray<CTextLayoutGlyph> Glyphs;
+	// Pen position after the last glyph.
+	CVector2<int> EndOffset;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Glyphs of a single font: metrics, atlas placement, kerning and shaped lines.
+// Glyphs are rasterized into the atlas on first use. No OpenGL calls are made and the cache can be used without a rendering context.
+class GINAPI CGlyphCache {
+public:
+	// Number of characters in the direct-mapped table. Covers Basic Latin through Latin Extended-B.
+	// Kerning pairs are precomputed for this range.
+	static const int LatinSymbolCount = 0x250;
+	static const int DefaultShapingCacheBudget = 1024 * 1024;
+
+	bool IsFontLoaded() const
+		{ return glyphProvider != nullptr; }
+	// Remove all the glyphs and use the given provider for the new ones.
+	void SetGlyphProvider( CPtrOwner<IGlyphProvider> newValue );
+
+	const CGlyphAtlas& GetAtlas() const
+		{ return atlas; }
+	CGlyphAtlas& GetAtlas()
+		{ return atlas; }
+
+	// Add all the glyphs of the string to the atlas. Additional workers rasterize the glyphs with the worker copies of the provider.
+	void LoadGlyphs( CUnicodePart str, int workerCount );
+	// Glyph data for a given UTF32 character. If the character has not been rendered, it is added to the atlas.
+	CRenderGlyphData GetRenderData( unsigned glyphCode );
+	// Kerning between two UTF32 characters. Zero for the characters outside the Latin range.
+	int GetKerning( unsigned leftCode, unsigned rightCode );
+
+	// Parse a character at the given position and move the position to the next character.
+	static unsigned ParseCharacter( CUnicodePart str, int& strPos );
+	static unsigned ParseCharacter( CStringPart str, int& strPos );
+	// Source name for log messages.
+	static CStringView GetMessageSource();
+
+	// Single lines are shaped once: decoded glyph codes and kerned positions are cached by the line text.
+	// The returned line stays valid until the next line is shaped.
+	const CShapedLine& GetShapedLine( CUnicodePart line );
+	const CShapedLine& GetShapedLine( CStringPart line );
+	const CTextMeshCacheStatistics& GetShapingCacheStatistics() const
+		{ return shapingCachePolicy.GetStatistics(); }
+	int GetShapingCacheBudget() const
+		{ return shapingCachePolicy.GetByteBudget(); }
+	void SetShapingCacheBudget( int byteCount )
+		{ shapingCachePolicy.SetByteBudget( byteCount ); }
+
+	// Separate the string into lines with a maximum width and place each glyph.
+	// Results are written to the caller provided storage, no memory is allocated except for glyphs that are seen for the first time.
+	CTextLayoutResult LayoutText( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset,
+		CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines );
+	CTextLayoutResult LayoutText( CStringPart str, int lineWidth, int lineHeight, int startHOffset,
+		CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines );
+
+private:
+	// Font used by the cache.
+	CPtrOwner<IGlyphProvider> glyphProvider;
+	// Direct-mapped glyph data for the Latin range. Allocated on first use.
+	CArray<CRenderGlyphData> latinGlyphData;
+	// Glyph data of the characters outside the Latin range.
+	CMap<unsigned, CRenderGlyphData> glyphData;
+	// CPU copy of the atlas.
+	CGlyphAtlas atlas;
+	// Non-zero kerning values of the Latin range, keyed by the glyph pair.
+	CMap<int, int> kerningPairs;
+	// Latin glyphs that have kerning pairs computed.
+	CArray<unsigned> kernedGlyphs;
+	// Shaped line cache.
+	CTextMeshCachePolicy shapingCachePolicy{ DefaultShapingCacheBudget };
+	CArray<CShapedLine> shapedLines;
+	CArray<int> evictedShapingSlots;
+
+	void reserveNewGlyphs( CUnicodePart str, CArray<unsigned>& glyphCodes );
+	CRenderGlyphData& getRenderDataEntry( unsigned glyphCode );
+	void addGlyphToAtlas( unsigned glyphCode, CRenderGlyphData& result );
+	void addKerningPairs( unsigned glyphCode );
+	template <class StrType>
+	const CShapedLine& addShapedLine( StrType line, const CTextMeshCacheKey& key, CArrayView<BYTE> text );
+	template <class StrType>
+	CTextLayoutResult doLayoutText( StrType str, int lineWidth, int lineHeight, int startHOffset,
+		CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines );
+	static void addLayoutLine( int firstGlyph, int glyphEnd, int width, CTextLayoutResult& result, CArrayBuffer<CTextLayoutLine> lines );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
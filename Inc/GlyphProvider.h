@@ -1,6 +1,7 @@
 #pragma once
 #include <GinDefs.h>
 #include <GlyphInc.h>
+#include <GlyphBatch.h>
 
 namespace Gin {
 
@@ -12,6 +13,24 @@ public:
 	virtual ~IGlyphProvider() {}
 
 	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const = 0;
+	// Rasterize several glyphs and add them to the end of the batch.
+	// Providers are expected to override the default implementation to avoid creating separate glyph objects.
+	virtual void GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const
+	{
+		for( auto code : utf32Codes ) {
+			result.AddGlyph( GetGlyph( code )->GetGlyphData() );
+		}
+	}
+	// Check if the provider has kerning information.
+	virtual bool HasKerning() const
+		{ return false; }
+	// Horizontal adjustment of the distance between two characters in pixels.
+	virtual int GetKerning( int /*leftUtf32*/, int /*rightUtf32*/ ) const
+		{ return 0; }
+	// Create a provider that can rasterize glyphs on another thread concurrently with this one.
+	// Return null if concurrent rasterization is not supported.
+	virtual CPtrOwner<IGlyphProvider> CreateWorkerCopy() const
+		{ return CPtrOwner<IGlyphProvider>(); }
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -1,5 +1,6 @@
 #pragma once
 #include <DrawEnums.h>
+#include <FileMapping.h>
 
 namespace Gin {
 
@@ -15,8 +16,16 @@ public:
 	// Common constructor for compressed and uncompressed textures.
 	CImageData( TTextureType type, int width, int height, int depth, TTexelFormat _imageFormat, TTexelDataType _pixelFormat, TTextureCompressionType compressionType, 
 		int mipmapCount, int arrayCount );
+	// Constructor for images that reference the contents of a mapped file. No memory is allocated for the images.
+	// Images are read starting from dataOffset in the order of array elements, cube faces and mipmap levels.
+	CImageData( TTextureType type, int width, int height, int depth, TTexelFormat _imageFormat, TTexelDataType _pixelFormat, TTextureCompressionType compressionType, 
+		int mipmapCount, int arrayCount, CPtrOwner<CFileMapping> mapping, int dataOffset );
 	CImageData( CImageData&& other );
 
+	// Is the data read from a file mapping. Mapped data cannot be modified.
+	bool IsMapped() const
+		{ return fileMapping != nullptr; }
+
 	TTextureType GetType() const
 		{ return type; }
 	TTextureCompressionType GetCompressionType() const
@@ -38,19 +47,26 @@ public:
 	// Get data or size in bytes for the single image in a texture.
 	int GetImageDataSize( int mipmapLevel ) const;
 	const BYTE* GetImageData( int mipmapLevel, int arrayIndex = 0, int cubeFace = 0 ) const;
-	// Set singe image's data. Data is assumed to have a top-left corner as its origin.
+	// Copy a single image to the given memory. Mapped images can be copied as well.
+	// If shouldFlip is set to true, data is flipped vertically while copying. Exactly GetImageDataSize( mipmapLevel ) bytes are written to result.
+	void CopyImageData( int mipmapLevel, int arrayIndex, int cubeFace, BYTE* result, bool shouldFlip ) const;
+	// Set singe image's data. Data is assumed to have a top-left corner as its origin. The image must not be mapped.
 	// If shouldFlip is set to true, data is flipped vertically before copying.
 	// Exactly GetImageDataSize( mipmapLevel ) bytes will be copied from data.
 	void SetImageData( int mipmapLevel, int arrayIndex, int cubeFace, const BYTE* data, bool shouldFlip );
 	// Set image data with a 32-bit BGRA pixel data.
 	void SetImageData( int mipmapLevel, int arrayIndex, int cubeFace, const CColor* data, bool shouldFlip );
+	// Flip a single image vertically. Rows are exchanged in place, no memory is allocated. The image must not be mapped.
+	void FlipImage( int mipmapLevel, int arrayIndex, int cubeFace );
+	// Flip all the images vertically in place.
+	void FlipVertically();
 
 	// Get data for the whole mipmap level.
 	// In simple textures the returned value is the same as in GetImageData.
-	const CArray<BYTE>& GetMipmapData( int mimmapLevel ) const
-		{ return textureData[mimmapLevel].Data; }
-	CArray<BYTE>& GetMipmapData( int mipmapLevel ) 
-		{ return textureData[mipmapLevel].Data; }
+	// Levels of mapped images are contiguous: CDdsImage only maps images that have a single image per level or a single level.
+	CArrayView<BYTE> GetMipmapData( int mipmapLevel ) const;
+	// Modifiable data is only available in images that are not mapped.
+	CArray<BYTE>& GetMipmapData( int mipmapLevel );
 
 	// Get/Set maximum mipmap level.
 	int GetMipmapCount() const
@@ -63,10 +79,12 @@ private:
 	struct CSingleImage {
 		// Data for all the images in the array/cube.
 		CArray<BYTE> Data;
+		// Data of each image in the array/cube in the file mapping. Empty for the images that are not mapped.
+		CArray<const BYTE*> MappedImages;
 		// Size of a single image.
 		int ImageSize;
 		
-		CSingleImage( CSingleImage&& other ) : Data( move( other.Data ) ), ImageSize( move( other.ImageSize ) ) {}
+		CSingleImage( CSingleImage&& other ) : Data( move( other.Data ) ), MappedImages( move( other.MappedImages ) ), ImageSize( move( other.ImageSize ) ) {}
 		CSingleImage() = default;
 
 		// Copying is prohibited.
@@ -90,9 +108,12 @@ private:
 	TTexelFormat texelFormat;
 	TTexelDataType texelDataType;
 
-	// Byte block size for a DXT1 compression format.
+	// Mapped file that contains the image data. Null if the data is owned by the image.
+	CPtrOwner<CFileMapping> fileMapping;
+
+	// Byte block size for DXT1 and BC4 compression formats.
 	static const int dxtSmallBlockSize = 8;
-	// Byte block size for DXT3 and DXT5 compression formats.
+	// Byte block size for DXT3, DXT5 and BC5 compression formats.
 	static const int dxtBigBlockSize = 16;
 	// Pixel block size for DXT compressionFormats.
 	static const int dxtPixelBlockSize = 4;
@@ -108,19 +129,13 @@ private:
 	static void adjustDimensions( int& w, int& h, int& d );
 
 	void allocateData();
+	void mapData( int dataOffset );
 
 	void copyDataFlipped( BYTE* dest, const BYTE* src, int byteSize, int mipmapLevel ) const;
-	void copyUncompressedDataFlipped( BYTE* dest, const BYTE* src, int byteSize, int mipmapLevel ) const;
+	void flipDataInPlace( BYTE* data, int byteSize, int mipmapLevel ) const;
+	void getFlipRowCounts( int mipmapLevel, int& sliceCount, int& rowCount ) const;
 	void getDimensions( int mipmapLevel, int& width, int& height, int& depth ) const;
 
-	static void flipDxt1Block( BYTE* dest, const BYTE* src );
-	static void flipDxt3Block( BYTE* dest, const BYTE* src );
-	static void flipCompressedAlphaBlock( BYTE* dest, const BYTE* src );
-	static void flipDxt5Block( BYTE* dest, const BYTE* src );
-	
-	template<class FlippingFunction>
-	void copyDxtDataFlipped( BYTE* dest, const BYTE* src, int imageSize, int mipmapLevel, int blockSize, FlippingFunction flipBlocks ) const;
-
 	// Copying is prohibited.
 	CImageData( CImageData& ) = delete;
 	void operator=( CImageData& ) = delete;
@@ -128,40 +143,5 @@ private:
 
 //////////////////////////////////////////////////////////////////////////
 
-template<class FlippingFunction>
-void CImageData::copyDxtDataFlipped( BYTE* dest, const BYTE* src, int imageSize, int mipmapLevel, int blockSize, FlippingFunction flipBlocks ) const
-{
-	int currentWidth, currentHeight, currentDepth;
-	getDimensions( mipmapLevel, currentWidth, currentHeight, currentDepth );
-
-	// Height in blocks.
-	const int blockHeight = Ceil( currentHeight, dxtPixelBlockSize );
-	// Size of a texture slice.
-	const int sliceSize = imageSize / currentDepth;
-	// Size of a block row in bytes.
-	const int blockRowSize = sliceSize / blockHeight;
-	// Size of a block row in blocks.
-	const int blockRowCount = Ceil( currentWidth, dxtPixelBlockSize );
-
-	int destPos = 0;
-	int srcPos = sliceSize - blockRowSize;
-	for( int i = 0; i < currentDepth; i++ ) {
-		for( int j = 0; j < blockHeight; j++ ) {
-			for( int k = 0; k < blockRowCount; k++ ) {
-				flipBlocks( dest + destPos, src + srcPos );
-				destPos += blockSize;
-				srcPos += blockSize;
-			}
-			// Go to the next row.
-			srcPos -= 2 * blockRowSize;
-		}
-
-		// Go to the next slice.
-		srcPos += 2 * sliceSize;
-	}
-}
-
-//////////////////////////////////////////////////////////////////////////
-
 }	// namespace Gin.
 
@@ -0,0 +1,109 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Image waiting to be written to a file.
+struct CImageEncodeJob {
+	// Name of the written file. An empty name is replaced with a unique name in the screenshot folder when the job is written.
+	CString FileName;
+	// RGB pixel rows from the bottom to the top, as read from a framebuffer. Rows are aligned to 4 bytes.
+	// Encoders may expect a different channel order.
+	CArray<BYTE> Pixels;
+	CVector2<int> Size;
+	// Position of the job in the queue. Assigned by the queue when the job is accepted.
+	int Index = 0;
+};
+
+// Writer of the queued images. Called from the worker threads, several jobs can be encoded at once.
+class IImageEncoder {
+public:
+	virtual ~IImageEncoder() {}
+
+	// Write the job contents. Return false if the image can't be written, file errors are thrown.
+	virtual bool EncodeImage( const CImageEncodeJob& job ) = 0;
+};
+
+// Statistics of the image encode queue.
+struct CImageEncodeStatistics {
+	// Number of written files.
+	int WrittenCount = 0;
+	// Number of jobs that failed to be written.
+	int FailedCount = 0;
+	// Number of jobs refused because the queue was full.
+	int RejectedCount = 0;
+	// Total number of pixels in the written images.
+	long long WrittenPixelCount = 0;
+	// Time the workers spent encoding, in seconds. Jobs encoded in parallel are summed up.
+	double EncodeTime = 0.0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Queue of images that are encoded on background threads. Images are written as PNG files unless an encoder is given.
+// The queue has a bounded size, so a producer that is faster than the workers is either refused or blocked.
+// Jobs are started in the order they were added. No rendering context is required.
+// Jobs must be added from a single thread.
+class GINAPI CImageEncodeQueue {
+public:
+	static const int DefaultMaxJobCount = 8;
+
+	// The encoder must outlive the queue.
+	explicit CImageEncodeQueue( int workerCount = 1, int maxJobCount = DefaultMaxJobCount, IImageEncoder* encoder = nullptr );
+	// Write the remaining jobs and stop the workers.
+	~CImageEncodeQueue();
+
+	int GetWorkerCount() const
+		{ return workers.Size(); }
+	int GetMaxJobCount() const
+		{ return maxJobCount; }
+	// Number of jobs that are queued or being written.
+	int GetJobCount() const;
+	CImageEncodeStatistics GetStatistics() const;
+
+	// Put the job to the queue if there is space for it. Return false if the queue is full, the job is left untouched.
+	bool TryAddJob( CImageEncodeJob& job );
+	// Put the job to the queue. The caller is blocked while the queue is full.
+	void AddJob( CImageEncodeJob job );
+	// Wait until all the jobs are written.
+	void Flush();
+
+private:
+	const int maxJobCount;
+	IImageEncoder* const encoder;
+	mutable CRITICAL_SECTION lock;
+	// Signaled when a job is added or the workers need to stop.
+	CONDITION_VARIABLE jobAdded;
+	// Signaled when a job is finished.
+	CONDITION_VARIABLE jobFinished;
+	// Serializes the writing of the jobs that need a unique name.
+	CRITICAL_SECTION nameLock;
+
+	// Queued jobs in the order of addition. Protected by the lock.
+	CArray<CPtrOwner<CImageEncodeJob>> jobs;
+	// Number of jobs taken by the workers. Protected by the lock.
+	int activeJobCount = 0;
+	int nextJobIndex = 0;
+	bool isStopping = false;
+	CImageEncodeStatistics statistics;
+
+	CArray<HANDLE> workers;
+
+	void addJob( CImageEncodeJob& job );
+	void runWorker();
+	bool writeJob( const CImageEncodeJob& job );
+	void finishJob( const CImageEncodeJob& job, bool isWritten, long long startTime );
+	static void writePngFile( CStringPart fileName, const CImageEncodeJob& job );
+	static DWORD WINAPI workerProc( void* param );
+
+	// Copying is prohibited.
+	CImageEncodeQueue( CImageEncodeQueue& ) = delete;
+	void operator=( CImageEncodeQueue& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -160,6 +160,8 @@ public:
 
 	void Draw( CShaderProgram shader ) const;
 	void Draw( CShaderProgram shader, int elementCount ) const;
+	// Draw a range of elements starting from firstElement.
+	void Draw( CShaderProgram shader, int firstElement, int elementCount ) const;
 
 protected:
 	void invalidate();
@@ -0,0 +1,98 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+class CImageData;
+//////////////////////////////////////////////////////////////////////////
+
+// Downsampling filter of the mipmap generator.
+enum TMipmapFilter {
+	// Average of the covered source pixels. Fast, slightly blurry.
+	MF_Box,
+	// Kaiser windowed sinc. Sharper levels with less aliasing.
+	MF_Kaiser
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// CPU generator of mipmap chains for RGBA8, BGRA8 and R8 images.
+// Each level is filtered from the previous one. Dimensions don't have to be powers of two, odd sizes are resampled with fractional pixel coverage.
+// Rows of a level are distributed between worker threads.
+class GINAPI CMipmapGenerator {
+public:
+	TMipmapFilter GetFilter() const
+		{ return filter; }
+	void SetFilter( TMipmapFilter newValue )
+		{ filter = newValue; }
+
+	// Color channels are stored in sRGB and are averaged in linear space. Alpha is always linear.
+	bool IsSrgb() const
+		{ return isSrgb; }
+	void SetSrgb( bool newValue )
+		{ isSrgb = newValue; }
+
+	// Alpha of each level is scaled so that the fraction of pixels above the reference alpha stays the same as in the first level.
+	// Keeps alpha tested foliage and fences from thinning out in the distance.
+	bool PreservesAlphaCoverage() const
+		{ return preserveAlphaCoverage; }
+	float GetAlphaCoverageReference() const
+		{ return alphaCoverageReference; }
+	void SetAlphaCoveragePreservation( bool isEnabled, float referenceAlpha = 0.5f );
+
+	int GetWorkerCount() const
+		{ return workerCount; }
+	void SetWorkerCount( int newValue );
+
+	// Number of levels in the full mipmap chain of an image with the given size.
+	static int GetFullMipmapCount( int width, int height );
+
+	// Fill all the levels of the image except the first one. The image must be two-dimensional and not mapped.
+	void GenerateMipmaps( CImageData& image ) const;
+	// Create an image with the full mipmap chain. The first level of each image is copied from the source.
+	CImageData CreateMipmappedImage( const CImageData& source ) const;
+
+private:
+	// Filter weights along one axis of a level.
+	struct CFilterAxis {
+		// Index of the first source pixel for each destination pixel.
+		CArray<int> FirstSource;
+		// TapCount weights for each destination pixel.
+		CArray<float> Weights;
+		int TapCount = 0;
+	};
+
+	// Tables that convert channel values between bytes and linear floats.
+	struct CConversionTables {
+		float ColorToLinear[256];
+		float AlphaToLinear[256];
+		CArray<BYTE> LinearToColor;
+	};
+
+	TMipmapFilter filter = MF_Box;
+	bool isSrgb = false;
+	bool preserveAlphaCoverage = false;
+	float alphaCoverageReference = 0.5f;
+	int workerCount = 1;
+
+	void fillConversionTables( CConversionTables& tables ) const;
+	void buildFilterAxis( int srcSize, int destSize, CFilterAxis& result ) const;
+	static void getLevelTaps( TMipmapFilter levelFilter, int destPos, float scale, int& firstTap, int& lastTap );
+	static float getTapWeight( TMipmapFilter levelFilter, int srcPos, int destPos, float scale );
+
+	void filterRow( const BYTE* srcImage, int srcWidth, BYTE* destRow, int destWidth, int destY, int channelCount,
+		const CFilterAxis& horizontal, const CFilterAxis& vertical, const CConversionTables& tables, CArray<float>& rowBuffer ) const;
+	static void accumulateRow( const BYTE* srcRow, int srcWidth, int channelCount, float weight, const CConversionTables& tables, float* rowBuffer );
+	static void resampleRow( const float* rowBuffer, BYTE* destRow, int destWidth, int channelCount, const CFilterAxis& horizontal, const CConversionTables& tables );
+	static BYTE encodeColor( float value, const CConversionTables& tables );
+	static BYTE encodeAlpha( float value );
+
+	static void findAlphaHistogram( const BYTE* image, int pixelCount, int* histogram );
+	static float findAlphaCoverage( const int* histogram, int pixelCount, float alphaScale, int referenceAlpha );
+	void scaleAlphaCoverage( BYTE* image, int pixelCount, float targetCoverage ) const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -47,6 +47,12 @@ public:
 	// Create an audio buffer from the whole file.
 	CSoundOwner ReadAudioBuffer();
 
+	// Format and sample rate of the decoded audio.
+	TAudioDataFormat GetAudioFormat() const;
+	int GetSampleRate() const;
+	// Decode the whole file to 16 bit PCM and append it to the result. No OpenAL calls are made.
+	void DecodeAudioData( CArray<BYTE>& result );
+
 private:
 	CDynamicFile oggFile;
 	// Vorbis library file handle.
@@ -61,7 +67,6 @@ private:
 
 	int decodeFileData( BYTE* buffer, int size );
 	CSoundOwner createAudioBuffer( const CArray<BYTE>& buffer, int chunkSize ) const;
-	TAudioDataFormat getAudioFormat() const;
 
 	static size_t relibReadFunction( void* ptr, size_t size, size_t nmemb, void* datasource) ;
 	static int relibSeekFunction( void* datasource, __int64 offset, int whence );
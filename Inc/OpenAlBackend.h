@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+#include <AudioBackend.h>
+
+namespace Gin {
+
+namespace Audio {
+
+typedef struct ALCdevice_struct ALCdevice;
+typedef struct ALCcontext_struct ALCcontext;
+//////////////////////////////////////////////////////////////////////////
+
+// Audio output to the default OpenAL device.
+class GINAPI COpenAlBackend : public IAudioBackend {
+public:
+	COpenAlBackend();
+	~COpenAlBackend();
+
+	virtual bool IsFloatFormatSupported() const override final;
+
+	virtual void CreateBuffers( int count, unsigned* result ) override final;
+	virtual void DeleteBuffers( int count, const unsigned* bufferIds ) override final;
+	virtual void SetBufferData( unsigned bufferId, TAudioDataFormat format, int frequency, const void* data, int size ) override final;
+	virtual float GetBufferDuration( unsigned bufferId ) const override final;
+
+	virtual unsigned CreateSource() override final;
+	virtual void DeleteSource( unsigned sourceId ) override final;
+
+	virtual void SetSourceRelative( unsigned sourceId, bool isRelative ) override final;
+	virtual void SetSourcePosition( unsigned sourceId, CVector3<float> position ) override final;
+	virtual void SetSourceVelocity( unsigned sourceId, CVector3<float> velocity ) override final;
+	virtual void SetSourceLooping( unsigned sourceId, bool isLooping ) override final;
+	virtual void SetSourceGain( unsigned sourceId, float gain ) override final;
+	virtual void SetSourcePitch( unsigned sourceId, float pitch ) override final;
+	virtual float GetDistanceGain( float distance ) const override final;
+
+	virtual CAudioRecord::TRecordState GetSourceState( unsigned sourceId ) const override final;
+	virtual void GetSourceStates( int count, const unsigned* sourceIds, CAudioRecord::TRecordState* result ) const override final;
+	virtual void PlaySource( unsigned sourceId ) override final;
+	virtual void PauseSource( unsigned sourceId ) override final;
+	virtual void StopSource( unsigned sourceId ) override final;
+	virtual void RewindSource( unsigned sourceId ) override final;
+	virtual float GetSourceOffset( unsigned sourceId ) const override final;
+	virtual void SetSourceOffset( unsigned sourceId, float offset ) override final;
+
+	virtual void QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds ) override final;
+	virtual int UnqueueProcessedBuffers( unsigned sourceId, int maxCount, unsigned* result ) override final;
+	virtual int GetQueuedBufferCount( unsigned sourceId ) const override final;
+	virtual void DetachBuffers( unsigned sourceId ) override final;
+
+	virtual void SetListenerPosition( CVector3<float> position ) override final;
+	virtual void SetListenerOrientation( CVector3<float> direction, CVector3<float> upVector ) override final;
+	virtual void SetListenerVelocity( CVector3<float> velocity ) override final;
+
+private:
+	// Used audio device.
+	ALCdevice* device = nullptr;
+	// Native handle to the audio context.
+	ALCcontext* context = nullptr;
+
+	void checkAudioError() const;
+
+	// Copying is prohibited.
+	COpenAlBackend( COpenAlBackend& ) = delete;
+	void operator=( COpenAlBackend& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
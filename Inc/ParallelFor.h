@@ -0,0 +1,36 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+namespace GinInternal {
+
+typedef void ( *TParallelTaskFunction )( void* action, int workerIndex, int taskIndex );
+void GINAPI RunParallelTasks( int taskCount, int workerCount, TParallelTaskFunction function, void* action );
+
+template <class Action>
+void invokeParallelAction( void* action, int workerIndex, int taskIndex )
+{
+	( *static_cast<Action*>( action ) )( workerIndex, taskIndex );
+}
+
+}	// namespace GinInternal.
+
+//////////////////////////////////////////////////////////////////////////
+
+// Number of logical processors available to the process.
+int GINAPI GetHardwareThreadCount();
+
+// Call action( workerIndex, taskIndex ) for each task index in [0, taskCount) using the given number of threads.
+// The calling thread works as the worker with index 0. Tasks are distributed dynamically, one at a time.
+// The function returns when all the tasks are complete. The first exception thrown by a task is rethrown to the caller, remaining tasks are skipped.
+template <class Action>
+void ParallelFor( int taskCount, int workerCount, Action& action )
+{
+	GinInternal::RunParallelTasks( taskCount, workerCount, GinInternal::invokeParallelAction<Action>, &action );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,105 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+
+namespace Gin {
+
+class CImageData;
+//////////////////////////////////////////////////////////////////////////
+
+// Pixel layouts supported by the pixel converter.
+enum TPixelFormat {
+	PF_Unknown = NotFound,
+	PF_R8,
+	PF_RG8,
+	PF_RGB8,
+	PF_BGR8,
+	PF_RGBA8,
+	PF_BGRA8,
+	// 16-bit packed color, red is in the high bits.
+	PF_RGB565,
+	PF_RGBA16F,
+	PF_RGBA32F,
+	PF_EnumCount
+};
+
+// Alpha operation performed during the conversion.
+enum TAlphaConversion {
+	AC_None,
+	// Multiply the color channels by alpha.
+	AC_Premultiply,
+	// Divide the color channels by alpha. Colors of fully transparent pixels become black.
+	AC_Unpremultiply
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Converter between the common uncompressed pixel formats.
+// Pixels are decoded to floating point RGBA, color space and alpha operations are applied, and the result is encoded in the destination format.
+// Missing color channels are read as zero, missing alpha is read as opaque. Normalized destination values are clamped and rounded to nearest.
+// Conversions that only reorder 8-bit channels skip the floating point stage. 8-bit four channel formats are processed with SSE2 if it is available.
+class GINAPI CPixelConverter {
+public:
+	CPixelConverter();
+
+	// Color channels of the source are stored in sRGB. Alpha is always linear.
+	bool IsSourceSrgb() const
+		{ return isSourceSrgb; }
+	void SetSourceSrgb( bool newValue )
+		{ isSourceSrgb = newValue; }
+	// Color channels of the result are stored in sRGB.
+	bool IsDestSrgb() const
+		{ return isDestSrgb; }
+	void SetDestSrgb( bool newValue )
+		{ isDestSrgb = newValue; }
+
+	// Alpha operations are performed on linear colors.
+	TAlphaConversion GetAlphaConversion() const
+		{ return alphaConversion; }
+	void SetAlphaConversion( TAlphaConversion newValue )
+		{ alphaConversion = newValue; }
+
+	int GetWorkerCount() const
+		{ return workerCount; }
+	void SetWorkerCount( int newValue );
+
+	// Size of a single pixel in bytes.
+	static int GetPixelSize( TPixelFormat format );
+	// Find the pixel format of uncompressed image data. PF_Unknown is returned for unsupported formats.
+	static TPixelFormat FindPixelFormat( TTexelFormat texelFormat, TTexelDataType dataType );
+	// Image data parameters of the pixel format.
+	static void GetTexelFormat( TPixelFormat format, TTexelFormat& texelFormat, TTexelDataType& dataType );
+
+	// Convert a range of pixels. Source and destination must not overlap.
+	void ConvertPixels( const BYTE* src, TPixelFormat srcFormat, BYTE* dest, TPixelFormat destFormat, int pixelCount ) const;
+	// Create a converted copy of an uncompressed image with all its mipmap levels, array elements and cube faces.
+	CImageData ConvertImage( const CImageData& source, TPixelFormat destFormat ) const;
+
+private:
+	bool isSourceSrgb = false;
+	bool isDestSrgb = false;
+	TAlphaConversion alphaConversion = AC_None;
+	int workerCount = 1;
+
+	// Linear values of the 8-bit sRGB colors.
+	float srgbToLinearTable[256];
+	// 8-bit sRGB colors of the evenly spaced linear values.
+	CArray<BYTE> linearToSrgbTable;
+
+	bool isLinearStageNeeded() const;
+	static bool isByteFormat( TPixelFormat format );
+	static void reorderChannels( const BYTE* src, TPixelFormat srcFormat, BYTE* dest, TPixelFormat destFormat, int pixelCount );
+	void decodePixels( const BYTE* src, TPixelFormat format, bool convertSrgb, float* result, int pixelCount ) const;
+	void applyAlphaConversion( float* pixels, int pixelCount ) const;
+	void encodePixels( const float* pixels, int pixelCount, TPixelFormat format, bool convertSrgb, BYTE* result ) const;
+	BYTE encodeSrgbColor( float value ) const;
+
+	// Copying is prohibited.
+	CPixelConverter( CPixelConverter& ) = delete;
+	void operator=( CPixelConverter& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,94 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Usage statistics of the pixel readback queue.
+struct CPixelReadbackStatistics {
+	// Number of readbacks issued to the driver.
+	int ReadbackCount = 0;
+	// Number of readbacks refused because all the buffers were pending.
+	int BufferShortageCount = 0;
+	// Number of readbacks the render thread had to wait for.
+	int StallCount = 0;
+};
+
+// Life cycle stage of a readback slot.
+enum TReadbackSlotState {
+	// The buffer can receive a new readback.
+	RSS_Free,
+	// The readback has been issued. The GPU writes to the buffer until the fence is signaled.
+	RSS_Pending
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Scheduling part of the pixel readback queue.
+// Readbacks are written to a ring of buffers and finished in the issue order. A readback is only checked for completion after minFrameDelay frames,
+// so the GPU gets time to finish the frame. A readback that is maxFrameDelay frames old has to be waited for, which keeps the delivery latency bounded.
+// No OpenGL calls are made and the policy can be used without a rendering context.
+class GINAPI CPixelReadbackPolicy {
+public:
+	static const int DefaultMinFrameDelay = 1;
+	static const int DefaultMaxFrameDelay = 3;
+
+	explicit CPixelReadbackPolicy( int slotCount, int minFrameDelay = DefaultMinFrameDelay, int maxFrameDelay = DefaultMaxFrameDelay );
+
+	int GetSlotCount() const
+		{ return slots.Size(); }
+	int GetMinFrameDelay() const
+		{ return minFrameDelay; }
+	int GetMaxFrameDelay() const
+		{ return maxFrameDelay; }
+
+	TReadbackSlotState GetSlotState( int slot ) const
+		{ return slots[slot].State; }
+	int GetPendingCount() const
+		{ return pendingCount; }
+
+	const CPixelReadbackStatistics& GetStatistics() const
+		{ return statistics; }
+	void ResetStatistics()
+		{ statistics = CPixelReadbackStatistics(); }
+
+	// Start a new frame.
+	void AdvanceFrame();
+
+	// Reserve the next slot of the ring for a readback issued during the current frame. The slot becomes pending.
+	// Return NotFound if the slot still holds an unfinished readback.
+	int AcquireSlot();
+	// Slot that was issued first among the pending ones. NotFound if nothing is pending.
+	int GetOldestPendingSlot() const
+		{ return pendingCount == 0 ? NotFound : oldestSlot; }
+	// Oldest pending slot if it is old enough to be checked for completion. NotFound otherwise.
+	int FindCompletionCandidate() const;
+	// The candidate slot is too old to be polled, the owner has to wait for its readback.
+	bool IsWaitRequired( int slot ) const;
+	// The readback of the oldest pending slot has been delivered. hasStalled indicates that the owner had to wait for the GPU.
+	void ReleaseSlot( int slot, bool hasStalled );
+
+private:
+	// Readback slot information.
+	struct CReadbackSlot {
+		TReadbackSlotState State = RSS_Free;
+		// Frame the readback was issued in.
+		int IssueFrame = 0;
+	};
+
+	int minFrameDelay;
+	int maxFrameDelay;
+	int currentFrame = 0;
+	CPixelReadbackStatistics statistics;
+
+	CArray<CReadbackSlot> slots;
+	// Oldest pending slot. Pending slots follow it in the ring order.
+	int oldestSlot = 0;
+	int pendingCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
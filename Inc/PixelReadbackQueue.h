@@ -0,0 +1,76 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+#include <PixelReadbackPolicy.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Receiver of the finished readbacks. Methods are called on the render thread during the queue update.
+class IPixelReadbackListener {
+public:
+	virtual ~IPixelReadbackListener() {}
+
+	// The pixels have been read. Rows go from the bottom to the top of the framebuffer and are aligned to 4 bytes.
+	// The data is only valid during the call. New readbacks must not be issued from the call.
+	virtual void OnReadbackComplete( int readbackId, CArrayView<BYTE> pixels, CVector2<int> size ) = 0;
+	// The buffer could not be mapped, the pixels are lost.
+	virtual void OnReadbackLost( int readbackId ) = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Asynchronous reader of the framebuffer contents.
+// Pixels are read into a ring of pixel pack buffers and a fence is placed after each read. The buffers are mapped a frame or more later, when the fence is signaled,
+// so the render thread doesn't wait for the GPU to finish the frame. Scheduling is delegated to CPixelReadbackPolicy.
+// All the methods must be called on the thread with the rendering context.
+class GINAPI CPixelReadbackQueue {
+public:
+	static const int DefaultBufferCount = 3;
+
+	explicit CPixelReadbackQueue( int bufferCount = DefaultBufferCount, int minFrameDelay = CPixelReadbackPolicy::DefaultMinFrameDelay,
+		int maxFrameDelay = CPixelReadbackPolicy::DefaultMaxFrameDelay );
+	~CPixelReadbackQueue();
+
+	const CPixelReadbackStatistics& GetStatistics() const
+		{ return policy.GetStatistics(); }
+	int GetPendingCount() const
+		{ return policy.GetPendingCount(); }
+
+	// Start reading the current viewport of the read framebuffer. Three and four channel byte formats are supported.
+	// Return false if all the buffers are busy.
+	bool ReadScreenBuffer( TTexelFormat format, IPixelReadbackListener* listener, int readbackId );
+	// Deliver the finished readbacks to the listeners. Must be called once per frame after the readbacks of the frame are issued.
+	void Update();
+	// Wait for all the pending readbacks and deliver them.
+	void Flush();
+
+private:
+	// Readback destination.
+	struct CReadbackRequest {
+		IPixelReadbackListener* Listener = nullptr;
+		int ReadbackId = 0;
+		CVector2<int> Size;
+		int DataSize = 0;
+	};
+
+	CPixelReadbackPolicy policy;
+	CArray<unsigned> bufferIds;
+	// Allocated size of each buffer.
+	CArray<int> bufferSizes;
+	CArray<CReadbackRequest> requests;
+	// Fences of the pending slots. Stored as a void pointer to keep the OpenGL types out of the interface.
+	CArray<void*> fences;
+
+	bool deliverReadback( int slot, bool shouldWait );
+
+	// Copying is prohibited.
+	CPixelReadbackQueue( CPixelReadbackQueue& ) = delete;
+	void operator=( CPixelReadbackQueue& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,65 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Compression effort of the PNG encoder.
+enum TPngCompressionLevel {
+	// Uncompressed deflate blocks. The output size is close to the raw image size.
+	PCL_Store,
+	// Greedy matching with a single candidate and the fixed Huffman code.
+	PCL_Fast
+};
+
+// Choice of the PNG row filter.
+enum TPngFilterStrategy {
+	PFS_None,
+	PFS_Sub,
+	PFS_Up,
+	PFS_Paeth,
+	// Each row gets the filter with the smallest sum of absolute differences. Slower, but gives smaller files.
+	PFS_MinimumSum
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Encoder of 8-bit RGB and RGBA images to the PNG format.
+// Rows are split into bands that are filtered and compressed in parallel. Each band is an independent part of the deflate stream
+// that is written as a separate IDAT chunk, so the checksums of the bands are computed by the workers as well.
+class GINAPI CPngEncoder {
+public:
+	int GetWorkerCount() const
+		{ return workerCount; }
+	void SetWorkerCount( int newValue );
+
+	TPngCompressionLevel GetCompressionLevel() const
+		{ return compressionLevel; }
+	void SetCompressionLevel( TPngCompressionLevel newValue )
+		{ compressionLevel = newValue; }
+
+	TPngFilterStrategy GetFilterStrategy() const
+		{ return filterStrategy; }
+	void SetFilterStrategy( TPngFilterStrategy newValue )
+		{ filterStrategy = newValue; }
+
+	// Encode the image to a PNG file in memory. Format must be TF_RGB or TF_RGBA.
+	// scanLineWidth is the distance between the pixel rows in bytes. A negative width means that the rows go from the bottom to the top.
+	void Encode( CArrayView<BYTE> pixels, TTexelFormat format, int scanLineWidth, CVector2<int> size, CArray<BYTE>& result ) const;
+	// Encode the image and write it to a file.
+	void WriteFile( CStringPart fileName, CArrayView<BYTE> pixels, TTexelFormat format, int scanLineWidth, CVector2<int> size ) const;
+
+private:
+	int workerCount = 1;
+	TPngCompressionLevel compressionLevel = PCL_Fast;
+	TPngFilterStrategy filterStrategy = PFS_Up;
+
+	void filterRow( const BYTE* row, const BYTE* prevRow, int rowSize, int pixelSize, BYTE* result, BYTE* candidate ) const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -1,5 +1,7 @@
 #pragma once
 #include <Gindefs.h>
+#include <PixelReadbackQueue.h>
+#include <ImageEncodeQueue.h>
 
 namespace Gin {
 
@@ -15,5 +17,46 @@ CString GINAPI CreateUniqueImageName();
 
 //////////////////////////////////////////////////////////////////////////
 
+// Screenshot maker that doesn't stall the render thread.
+// The screen is read into a pixel pack buffer and the PNG file is written on a background thread once the GPU has finished the frame.
+class GINAPI CScreenshotQueue : public IPixelReadbackListener {
+public:
+	CScreenshotQueue();
+	// Write the pending screenshots.
+	~CScreenshotQueue();
+
+	const CPixelReadbackStatistics& GetReadbackStatistics() const
+		{ return readbackQueue.GetStatistics(); }
+	CImageEncodeStatistics GetEncodeStatistics() const
+		{ return encodeQueue.GetStatistics(); }
+	// Number of screenshots lost because a readback buffer couldn't be mapped.
+	int GetLostCount() const
+		{ return lostCount; }
+
+	// Start reading the screen. The file is created in the screenshot folder a few frames later.
+	// Return false if too many screenshots are in progress.
+	bool MakeScreenshot();
+	// Pass the finished readbacks to the encoder. Must be called once per frame after the frame is drawn.
+	void Update();
+	// Wait for all the screenshots to be written.
+	void Flush();
+
+	// IPixelReadbackListener.
+	virtual void OnReadbackComplete( int readbackId, CArrayView<BYTE> pixels, CVector2<int> size ) override final;
+	virtual void OnReadbackLost( int readbackId ) override final;
+
+private:
+	CPixelReadbackQueue readbackQueue;
+	CImageEncodeQueue encodeQueue;
+	int nextReadbackId = 0;
+	int lostCount = 0;
+
+	// Copying is prohibited.
+	CScreenshotQueue( CScreenshotQueue& ) = delete;
+	void operator=( CScreenshotQueue& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
 }	// namespace Gin.
 
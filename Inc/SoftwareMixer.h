@@ -0,0 +1,154 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+#include <AudioBackend.h>
+#include <AudioSink.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Audio backend that mixes the sources on the CPU and passes the result to a sink.
+// Sources are resampled with linear interpolation. Mono sources are attenuated with the distance from the listener
+// and panned by their direction, stereo sources only get the gain. Velocities are stored but don't affect the pitch.
+// The output is produced by the Render method, so the mixing is deterministic and doesn't need an audio device.
+class GINAPI CSoftwareMixer : public IAudioBackend {
+public:
+	CSoftwareMixer( CPtrOwner<IAudioSink> sink, int sampleRate );
+
+	int GetSampleRate() const
+		{ return sampleRate; }
+	IAudioSink& GetSink()
+		{ return *sink; }
+
+	// Distance attenuation parameters. The attenuation follows the OpenAL inverse clamped distance model.
+	float GetReferenceDistance() const
+		{ return referenceDistance; }
+	void SetReferenceDistance( float newValue );
+	float GetMaxDistance() const
+		{ return maxDistance; }
+	void SetMaxDistance( float newValue );
+	float GetRolloffFactor() const
+		{ return rolloffFactor; }
+	void SetRolloffFactor( float newValue );
+
+	// Number of sources that were playing during the last mix.
+	int GetMixedSourceCount() const
+		{ return mixedSourceCount; }
+
+	// Mix the next frames of the playing sources and pass them to the sink.
+	void Render( int frameCount );
+	// Mix the next frames of the playing sources and append them to the result as interleaved stereo samples.
+	void Mix( int frameCount, CArray<float>& result );
+
+	virtual bool IsFloatFormatSupported() const override final
+		{ return true; }
+
+	virtual void CreateBuffers( int count, unsigned* result ) override final;
+	virtual void DeleteBuffers( int count, const unsigned* bufferIds ) override final;
+	virtual void SetBufferData( unsigned bufferId, TAudioDataFormat format, int frequency, const void* data, int size ) override final;
+	virtual float GetBufferDuration( unsigned bufferId ) const override final;
+
+	virtual unsigned CreateSource() override final;
+	virtual void DeleteSource( unsigned sourceId ) override final;
+
+	virtual void SetSourceRelative( unsigned sourceId, bool isRelative ) override final;
+	virtual void SetSourcePosition( unsigned sourceId, CVector3<float> position ) override final;
+	virtual void SetSourceVelocity( unsigned sourceId, CVector3<float> velocity ) override final;
+	virtual void SetSourceLooping( unsigned sourceId, bool isLooping ) override final;
+	virtual void SetSourceGain( unsigned sourceId, float gain ) override final;
+	virtual void SetSourcePitch( unsigned sourceId, float pitch ) override final;
+	virtual float GetDistanceGain( float distance ) const override final;
+
+	virtual CAudioRecord::TRecordState GetSourceState( unsigned sourceId ) const override final;
+	virtual void GetSourceStates( int count, const unsigned* sourceIds, CAudioRecord::TRecordState* result ) const override final;
+	virtual void PlaySource( unsigned sourceId ) override final;
+	virtual void PauseSource( unsigned sourceId ) override final;
+	virtual void StopSource( unsigned sourceId ) override final;
+	virtual void RewindSource( unsigned sourceId ) override final;
+	virtual float GetSourceOffset( unsigned sourceId ) const override final;
+	virtual void SetSourceOffset( unsigned sourceId, float offset ) override final;
+
+	virtual void QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds ) override final;
+	virtual int UnqueueProcessedBuffers( unsigned sourceId, int maxCount, unsigned* result ) override final;
+	virtual int GetQueuedBufferCount( unsigned sourceId ) const override final;
+	virtual void DetachBuffers( unsigned sourceId ) override final;
+
+	virtual void SetListenerPosition( CVector3<float> position ) override final;
+	virtual void SetListenerOrientation( CVector3<float> direction, CVector3<float> upVector ) override final;
+	virtual void SetListenerVelocity( CVector3<float> velocity ) override final;
+
+private:
+	struct CMixerBuffer {
+		// Samples converted to float. Stereo samples are interleaved.
+		CArray<float> Samples;
+		int ChannelCount = 1;
+		int FrameCount = 0;
+		int Frequency = 0;
+		bool IsUsed = false;
+	};
+
+	struct CMixerSource {
+		// Identifiers of the queued buffers.
+		CArray<unsigned> Queue;
+		// Index of the playing buffer in the queue. Buffers before it are processed.
+		int QueuePos = 0;
+		// Position in the playing buffer in frames. The lower 32 bits hold the fraction.
+		__int64 FramePos = 0;
+		// The position is set by SetSourceOffset and must be kept by the next PlaySource.
+		bool IsPositionSet = false;
+		CVector3<float> Position;
+		CVector3<float> Velocity;
+		float Gain = 1.0f;
+		float Pitch = 1.0f;
+		bool IsRelative = false;
+		bool IsLooping = false;
+		CAudioRecord::TRecordState State = CAudioRecord::RS_Initial;
+		bool IsUsed = false;
+	};
+
+	CPtrOwner<IAudioSink> sink;
+	int sampleRate;
+	float referenceDistance = 1.0f;
+	float maxDistance = FLT_MAX;
+	float rolloffFactor = 1.0f;
+
+	CArray<CMixerBuffer> buffers;
+	CArray<unsigned> freeBufferIds;
+	CArray<CMixerSource> sources;
+	CArray<unsigned> freeSourceIds;
+
+	CVector3<float> listenerPosition;
+	CVector3<float> listenerDirection;
+	CVector3<float> listenerUpVector;
+
+	// Output of the last render.
+	CArray<float> renderBuffer;
+	int mixedSourceCount = 0;
+
+	CMixerBuffer& getBuffer( unsigned bufferId );
+	CMixerSource& getSource( unsigned sourceId );
+	const CMixerSource& getSource( unsigned sourceId ) const;
+
+	void mixSource( CMixerSource& source, int frameCount, float* result ) const;
+	bool findPlayingBuffer( CMixerSource& source ) const;
+	float getNextBufferSample( const CMixerSource& source, int channel ) const;
+	void getChannelGains( const CMixerSource& source, int channelCount, float& leftGain, float& rightGain ) const;
+
+	// Copying is prohibited.
+	CSoftwareMixer( CSoftwareMixer& ) = delete;
+	void operator=( CSoftwareMixer& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
@@ -0,0 +1,211 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Audio {
+
+class CSoundCache;
+//////////////////////////////////////////////////////////////////////////
+
+// Usage statistics of the sound cache.
+struct CSoundCacheStatistics {
+	// Number of requests that were served by a loaded sound.
+	int HitCount = 0;
+	// Number of requests that decoded the file on the calling thread.
+	int MissCount = 0;
+	// Number of times a prefetched file was waited for while a worker was decoding it.
+	int PrefetchWaitCount = 0;
+	// Number of prefetched files that couldn't be decoded.
+	int PrefetchFailedCount = 0;
+	// Number of sounds removed to stay within the memory budget.
+	int EvictionCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Shared reference to a sound in the cache. Referenced sounds are never evicted.
+// References must be copied and released on the thread that owns the cache, the cache must outlive them.
+class GINAPI CSharedSound {
+public:
+	CSharedSound() = default;
+	CSharedSound( const CSharedSound& other );
+	CSharedSound( CSharedSound&& other );
+	CSharedSound& operator=( const CSharedSound& other );
+	CSharedSound& operator=( CSharedSound&& other );
+	~CSharedSound();
+
+	bool IsEmpty() const
+		{ return cache == nullptr; }
+
+	// Non owning view of the sound buffers. The view stays valid while the reference exists or the sound is played by a record.
+	CSoundView GetSound() const;
+	operator CSoundView() const
+		{ return GetSound(); }
+
+	// Drop the reference.
+	void Release();
+
+private:
+	CSoundCache* cache = nullptr;
+	int slot = NotFound;
+
+	CSharedSound( CSoundCache& cache, int slot );
+
+	friend class CSoundCache;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Cache of decoded sounds keyed by the file path. Each file is decoded once and its buffers are shared by all the users.
+// WAV and OGG files are supported, the format is detected by the file signature.
+// Decoded PCM data is kept within the memory budget: least recently requested sounds are deleted when they are neither referenced nor played.
+// If all the sounds are in use, the budget is exceeded until some of them are released.
+// Files can be prefetched on worker threads, the decoded data is uploaded to the audio backend by the Update method.
+// All the methods must be called on the thread that owns the audio context.
+class GINAPI CSoundCache {
+public:
+	static const __int64 DefaultByteBudget = 64 * 1024 * 1024;
+
+	explicit CSoundCache( __int64 byteBudget = DefaultByteBudget, int workerCount = 1 );
+	// Stop the workers and delete the sounds. All the references must be released before.
+	~CSoundCache();
+
+	__int64 GetByteBudget() const
+		{ return byteBudget; }
+	void SetByteBudget( __int64 newValue );
+	// Size of the decoded data of the loaded sounds.
+	__int64 GetUsedByteCount() const
+		{ return usedByteCount; }
+	// Number of loaded sounds.
+	int GetSoundCount() const
+		{ return soundCount; }
+	// Number of prefetched files that aren't loaded yet.
+	int GetPrefetchCount() const
+		{ return prefetchSlots.Size(); }
+	int GetWorkerCount() const
+		{ return workers.Size(); }
+
+	const CSoundCacheStatistics& GetStatistics() const
+		{ return statistics; }
+	void ResetStatistics()
+		{ statistics = CSoundCacheStatistics(); }
+
+	// Check if the sound is loaded and can be returned without decoding.
+	bool IsLoaded( CStringPart fileName ) const;
+	// Return the sound from the given file. The file is decoded on the calling thread if it has not been loaded or prefetched.
+	// If a prefetched file is still being decoded, the caller waits for it. Decoding errors are thrown.
+	CSharedSound GetSound( CStringPart fileName );
+	// Start decoding the file on a worker thread. Nothing is done if the file is already loaded or prefetched.
+	// Files that fail to decode are dropped, the error is thrown by the next GetSound call.
+	void Prefetch( CStringPart fileName );
+
+	// Load the sounds that were decoded by the workers. Should be called once per frame.
+	void Update();
+	// Wait until all the prefetched files are decoded and load them.
+	void Flush();
+	// Delete all the sounds that are not in use.
+	void EvictUnused();
+
+private:
+	// Sound data decoded from a file.
+	struct CDecodedSound {
+		TAudioDataFormat Format = ADF_Mono16;
+		int Frequency = 0;
+		CArray<BYTE> Data;
+	};
+
+	enum TDecodeJobState {
+		DJS_Queued,
+		DJS_Decoding,
+		DJS_Decoded,
+		DJS_Failed
+	};
+
+	// File prefetched by the workers. The state is protected by the lock, the result belongs to the worker while the job is decoding.
+	struct CDecodeJob {
+		CString FileName;
+		bool AllowFloatOutput = false;
+		TDecodeJobState State = DJS_Queued;
+		CDecodedSound Result;
+	};
+
+	// Cache entry information.
+	struct CCacheEntry {
+		CString FileName;
+		CSoundOwner Sound;
+		// Pending prefetch of the entry. Entries with a job have no sound and are not in the recency list.
+		CPtrOwner<CDecodeJob> Job;
+		// Size of the decoded data.
+		__int64 ByteSize = 0;
+		// Number of shared references.
+		int UseCount = 0;
+		// Neighbours in the recency list.
+		int PrevSlot = NotFound;
+		int NextSlot = NotFound;
+	};
+
+	__int64 byteBudget;
+	__int64 usedByteCount = 0;
+	int soundCount = 0;
+	CSoundCacheStatistics statistics;
+
+	// Cache entries. Unused entries are stored in the free list.
+	CArray<CCacheEntry> entries;
+	CArray<int> freeSlots;
+	CMap<CString, int, CCaselessStringHash> fileNameToSlot;
+	// Slots with pending prefetches.
+	CArray<int> prefetchSlots;
+	// Recency list of the loaded sounds. The head is the most recently requested slot, the tail is the least recently requested one.
+	int recentHead = NotFound;
+	int recentTail = NotFound;
+
+	mutable CRITICAL_SECTION lock;
+	// Signaled when a job is queued or the workers need to stop.
+	CONDITION_VARIABLE jobAdded;
+	// Signaled when a job is decoded.
+	CONDITION_VARIABLE jobFinished;
+	// Jobs waiting for a worker. Protected by the lock.
+	CArray<CDecodeJob*> queuedJobs;
+	bool isStopping = false;
+	CArray<HANDLE> workers;
+
+	int addEntry( CStringPart fileName );
+	bool finishPrefetch( int slot, bool waitForJob );
+	void loadSound( int slot, const CDecodedSound& decodedSound );
+	void removeEntry( int slot );
+	void evictLeastRecent( __int64 requiredSize );
+	bool canEvict( int slot ) const;
+	void linkAsMostRecent( int slot );
+	void unlinkSlot( int slot );
+
+	void addReference( int slot );
+	void releaseReference( int slot );
+	CSoundView getSound( int slot ) const
+		{ return entries[slot].Sound; }
+
+	void runWorker();
+	static DWORD WINAPI workerProc( void* param );
+	static TDecodeJobState decodeJob( CDecodeJob& job );
+	static void decodeFile( CStringPart fileName, bool allowFloatOutput, CDecodedSound& result );
+	static bool isOggFile( CStringPart fileName );
+
+	friend class CSharedSound;
+
+	// Copying is prohibited.
+	CSoundCache( CSoundCache& ) = delete;
+	void operator=( CSoundCache& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
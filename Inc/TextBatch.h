@@ -0,0 +1,70 @@
+#pragma once
+#include <Gindefs.h>
+#include <FontRenderer.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Vertex of a batched glyph quad. Transformation and color are baked into each vertex.
+struct CTextBatchVertex {
+	// Transformed position in pixel space.
+	CVector2<float> Position;
+	// Atlas texel offset.
+	CVector2<short> TexelOffset;
+	// Glyph color.
+	CVector4<BYTE> Color;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// A collection of text lines that are drawn with a single draw call.
+// All lines must be rendered by the same font renderer, its glyph atlas is used for drawing.
+class GINAPI CTextBatch {
+public:
+	explicit CTextBatch( const CFontRenderer& renderer );
+
+	const CFontRenderer& GetFontRenderer() const
+		{ return *owner; }
+	bool IsEmpty() const
+		{ return vertices.IsEmpty(); }
+	int GetGlyphCount() const;
+
+	// Add a line with the given transformation from model to pixel space.
+	void AddLine( CUnicodePart str, const CMatrix3<float>& modelToPixel, CColor color );
+	void AddLine( CStringPart str, const CMatrix3<float>& modelToPixel, CColor color );
+	// Remove all the lines. Allocated memory is kept for the next frame.
+	void Empty();
+
+	// Draw all the lines with the batch shader.
+	void Draw( const CMatrix3<float>& pixelToClip, float zOrder ) const;
+
+	// Only the renderer can access the mesh data.
+	friend class CFontRenderer;
+
+private:
+	// Font renderer that creates the glyphs.
+	const CFontRenderer* owner;
+	// Quads of all the lines.
+	CArray<CTextBatchVertex> vertices;
+	// Scratch buffer for the line that is being added.
+	CArray<CTextVertex> lineVertices;
+
+	// Vertex buffer that is updated on the first draw after modification.
+	mutable CGlBufferOwner<BT_Array, CTextBatchVertex> vertexBuffer;
+	mutable CMeshOwner<CElementMesh> mesh;
+	// Vertex buffer size in vertices.
+	mutable int bufferCapacity = 0;
+	mutable bool isBufferValid = false;
+
+	void addLineVertices( const CMatrix3<float>& modelToPixel, CColor color );
+
+	// Copying is prohibited.
+	CTextBatch( CTextBatch& ) = delete;
+	void operator=( CTextBatch& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
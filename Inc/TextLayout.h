@@ -0,0 +1,40 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Glyph placed by the text layout.
+struct CTextLayoutGlyph {
+	// UTF32 character code.
+	unsigned GlyphCode = 0;
+	// Pen position of the glyph in pixels.
+	CVector2<int> Position;
+	// Position of the character in the source string.
+	int StrPos = 0;
+};
+
+// Line produced by the text layout.
+struct CTextLayoutLine {
+	// Index of the first glyph of the line.
+	int FirstGlyph = 0;
+	int GlyphCount = 0;
+	// Right border of the line in pixels.
+	int Width = 0;
+};
+
+// Summary of the text layout.
+// Counts include the glyphs and lines that did not fit into the provided storage.
+// If any of the counts exceed the storage size, the layout must be repeated with bigger buffers.
+struct CTextLayoutResult {
+	int GlyphCount = 0;
+	int LineCount = 0;
+	// Pen position after the last character.
+	CVector2<int> EndOffset;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,129 @@
+#pragma once
+#include <GinDefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Usage statistics of the text mesh cache.
+struct CTextMeshCacheStatistics {
+	// Number of requests that were served by an existing mesh.
+	int HitCount = 0;
+	// Number of requests that required a new mesh.
+	int MissCount = 0;
+	// Number of meshes removed to stay within the memory budget.
+	int EvictionCount = 0;
+	// Number of meshes written to the shared streaming buffer.
+	int StreamedCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Parameters that identify a cached text mesh.
+// Text contents are represented by a hash, the actual text is compared separately to resolve collisions.
+struct CTextMeshCacheKey {
+	// Hash of the text code units.
+	int TextHash = 0;
+	// Size of the text in bytes.
+	int TextSize = 0;
+	// Maximum line width. NotFound for single line meshes.
+	int LineWidth = NotFound;
+	// Distance between lines in a paragraph.
+	int LineHeight = 0;
+	// Horizontal offset of the first paragraph line.
+	int StartHOffset = 0;
+	// Text encoding, UTF16 or UTF8.
+	bool IsUtf16 = false;
+
+	CTextMeshCacheKey() = default;
+	CTextMeshCacheKey( CArrayView<BYTE> text, bool isUtf16, int lineWidth = NotFound, int lineHeight = 0, int startHOffset = 0 );
+
+	int HashKey() const;
+	bool operator==( const CTextMeshCacheKey& other ) const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Bookkeeping part of the text mesh cache.
+// Decides which meshes are kept in the cache and which are evicted, the meshes themselves are stored by the owner in a parallel array of slots.
+// Meshes that were used during the current frame are never evicted, so the references returned to the user stay valid until the next frame.
+// No OpenGL calls are made and the policy can be used without a rendering context.
+class GINAPI CTextMeshCachePolicy {
+public:
+	static const int DefaultByteBudget = 4 * 1024 * 1024;
+
+	explicit CTextMeshCachePolicy( int byteBudget = DefaultByteBudget );
+
+	int GetByteBudget() const
+		{ return byteBudget; }
+	void SetByteBudget( int newValue );
+	// Memory taken by all the cached meshes.
+	int GetUsedByteCount() const
+		{ return usedByteCount; }
+	int GetEntryCount() const
+		{ return keyToSlot.Size(); }
+	// Total number of slots that have been allocated. All slot indices are less than this value.
+	int GetSlotCount() const
+		{ return entries.Size(); }
+
+	const CTextMeshCacheStatistics& GetStatistics() const
+		{ return statistics; }
+	void ResetStatistics()
+		{ statistics = CTextMeshCacheStatistics(); }
+
+	// Start a new frame. Meshes used in the previous frames become available for eviction.
+	void AdvanceFrame();
+
+	// Find the slot with the given text and mark it as recently used. Return NotFound if the text is not cached.
+	int FindSlot( const CTextMeshCacheKey& key, CArrayView<BYTE> text );
+	// Register a new mesh of the given size and return its slot.
+	// Least recently used meshes are evicted to make space, indices of their slots are added to evictedSlots.
+	// A slot that has been evicted may be returned as the result.
+	int AddSlot( const CTextMeshCacheKey& key, CArrayView<BYTE> text, int byteSize, CArray<int>& evictedSlots );
+	// Account for a mesh that went through the streaming buffer instead of the cache.
+	void OnMeshStreamed()
+		{ statistics.StreamedCount++; }
+
+	// Remove all the entries. Statistics are preserved.
+	void Empty();
+
+private:
+	// Cache entry information.
+	struct CCacheEntry {
+		CTextMeshCacheKey Key;
+		// Copy of the text for collision resolution.
+		CArray<BYTE> Text;
+		// Memory taken by the mesh and the text copy.
+		int ByteSize = 0;
+		// Last frame the entry was requested in.
+		int LastUsedFrame = NotFound;
+		// Neighbours in the recency list.
+		int PrevSlot = NotFound;
+		int NextSlot = NotFound;
+	};
+
+	// Maximum amount of memory taken by meshes.
+	int byteBudget;
+	int usedByteCount = 0;
+	int currentFrame = 0;
+	CTextMeshCacheStatistics statistics;
+
+	// Cache entries. Unused entries are stored in the free list.
+	CArray<CCacheEntry> entries;
+	CArray<int> freeSlots;
+	CMap<CTextMeshCacheKey, int> keyToSlot;
+	// Recency list. The head is the most recently used slot, the tail is the least recently used one.
+	int recentHead = NotFound;
+	int recentTail = NotFound;
+
+	void evictLeastRecent( int requiredSize, CArray<int>& evictedSlots );
+	void removeSlot( int slot );
+	void linkAsMostRecent( int slot );
+	void unlinkSlot( int slot );
+	static bool isTextEqual( const CArray<BYTE>& left, CArrayView<BYTE> right );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -4,6 +4,8 @@
 
 namespace Gin {
 
+class CTextureUploadQueue;
+class CTextureStreamingManager;
 //////////////////////////////////////////////////////////////////////////
 
 // Switcher for texture bindings.
@@ -29,6 +31,10 @@ private:
 	static TTextureBindingTarget currentTarget;
 
 	CTextureBinder( TTextureBindingTarget target, GinInternal::CTextureData text );
+
+	// Upload queue and streaming manager bind textures by their identifiers.
+	friend class CTextureUploadQueue;
+	friend class CTextureStreamingManager;
 };
 
 
@@ -0,0 +1,131 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Usage statistics of the texture streaming.
+struct CTextureStreamingStatistics {
+	// Number of mipmap levels scheduled for loading.
+	int LoadCount = 0;
+	// Number of mipmap levels released to stay within the memory budget.
+	int EvictionCount = 0;
+	// Number of times a load was postponed because not enough memory could be released.
+	int BudgetShortageCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Residency part of the texture streaming manager.
+// Each texture has a tail of coarse mipmap levels that is always resident. Finer levels are loaded one at a time, from the coarse to the fine ones, until the level required by the screen size is reached.
+// Resident levels of a texture form a contiguous range that ends with the coarsest level, so residency can be exposed to the GPU with the base level clamp.
+// When the memory budget is exceeded, the finest levels of the least recently used textures are released first.
+// Textures used during the current frame only lose the levels that are finer than they need. Textures with a pending load are not touched.
+// No OpenGL calls are made and the policy can be used without a rendering context.
+class GINAPI CTextureResidencyPolicy {
+public:
+	static const __int64 DefaultByteBudget = 256 * 1024 * 1024;
+	// Levels with both dimensions not exceeding this size are always resident.
+	static const int DefaultTailSize = 64;
+
+	explicit CTextureResidencyPolicy( __int64 byteBudget = DefaultByteBudget, int tailSize = DefaultTailSize );
+
+	__int64 GetByteBudget() const
+		{ return byteBudget; }
+	void SetByteBudget( __int64 newValue );
+	// Memory taken by the resident levels and the levels that are being loaded.
+	__int64 GetUsedByteCount() const
+		{ return usedByteCount; }
+	int GetTailSize() const
+		{ return tailSize; }
+	int GetTextureCount() const
+		{ return textures.Size() - freeSlots.Size(); }
+
+	const CTextureStreamingStatistics& GetStatistics() const
+		{ return statistics; }
+	void ResetStatistics()
+		{ statistics = CTextureStreamingStatistics(); }
+
+	// Register a texture with the given base size and the byte sizes of its mipmap levels, from the finest to the coarsest. Return the texture handle.
+	// Tail levels are considered resident, the owner is expected to load them right away.
+	int AddTexture( int width, int height, CArrayView<int> levelByteSizes );
+	// Remove the texture and release its memory. The texture must not have a pending load. The handle may be reused by the next added texture.
+	void RemoveTexture( int texture );
+
+	int GetLevelCount( int texture ) const
+		{ return textures[texture].LevelByteSizes.Size(); }
+	// Finest level of the tail.
+	int GetTailLevel( int texture ) const
+		{ return textures[texture].TailLevel; }
+	// Finest resident level.
+	int GetResidentLevel( int texture ) const
+		{ return textures[texture].ResidentLevel; }
+	// Finest level required by the latest reported screen size.
+	int GetDesiredLevel( int texture ) const
+		{ return textures[texture].DesiredLevel; }
+	// Level that is being loaded. NotFound if there is no pending load.
+	int GetLoadingLevel( int texture ) const
+		{ return textures[texture].LoadingLevel; }
+
+	// Start a new frame. Textures used in the previous frames can lose all their streamed levels.
+	void AdvanceFrame();
+	// Mark the texture as used in the current frame with the given size on the screen in pixels.
+	// The size is compared with the larger dimension of the texture. Multiple uses during a frame require the biggest of the sizes.
+	void UpdateScreenSize( int texture, float screenSize );
+
+	// Choose the next level to load and reserve memory for it. Levels are evicted to make space, textures that lost levels are added to evictedTextures.
+	// Return the texture handle, NotFound if there is nothing to load or the budget doesn't allow it.
+	int ScheduleNextLoad( int& level, CArray<int>& evictedTextures );
+	// The pending load of the texture has finished, the level becomes resident.
+	void OnLevelLoaded( int texture );
+	// The pending load of the texture has been abandoned, the reserved memory is released.
+	void OnLevelLoadFailed( int texture );
+
+	// Coarsest level that has at least as many texels as the screen size along the larger dimension.
+	static int FindDesiredLevel( int width, int height, float screenSize );
+	// Size on the screen in pixels of an object that has the given world size and is viewed with a perspective projection.
+	static float EstimateScreenSize( float objectSize, float distance, float verticalFov, int viewportHeight );
+
+private:
+	// Streamed texture information.
+	struct CTextureEntry {
+		int Width = 0;
+		int Height = 0;
+		CArray<int> LevelByteSizes;
+		int TailLevel = 0;
+		int ResidentLevel = 0;
+		int DesiredLevel = 0;
+		int LoadingLevel = NotFound;
+		// Last frame the texture was used in.
+		int LastUsedFrame = NotFound;
+		// Neighbours in the recency list.
+		int PrevTexture = NotFound;
+		int NextTexture = NotFound;
+	};
+
+	__int64 byteBudget;
+	int tailSize;
+	__int64 usedByteCount = 0;
+	int currentFrame = 0;
+	CTextureStreamingStatistics statistics;
+
+	// Texture entries. Unused entries are stored in the free list.
+	CArray<CTextureEntry> textures;
+	CArray<int> freeSlots;
+	// Recency list. The head is the most recently used texture, the tail is the least recently used one.
+	int recentHead = NotFound;
+	int recentTail = NotFound;
+
+	int findTailLevel( int width, int height, int levelCount ) const;
+	int findNextLoadTexture() const;
+	int findEvictionLevel( int texture ) const;
+	bool evictLevels( __int64 requiredSize, int requester, CArray<int>& evictedTextures );
+	void linkAsMostRecent( int texture );
+	void unlinkTexture( int texture );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
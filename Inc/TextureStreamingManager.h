@@ -0,0 +1,103 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+#include <ImageData.h>
+#include <TextureData.h>
+#include <TextureResidencyPolicy.h>
+#include <TextureUploadQueue.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Streaming manager of two-dimensional textures.
+// Only the coarse tail levels are uploaded when a texture is added, finer levels are streamed through the upload queue when the screen size of the texture requires them.
+// Resident levels are exposed with the base and max level clamps, released levels get an empty storage. Residency decisions are delegated to CTextureResidencyPolicy.
+// All the methods must be called on the thread with the rendering context. The upload queue keeps references to the manager, so it must be destroyed first or have no pending loads of the manager.
+class GINAPI CTextureStreamingManager : public ITextureUploadListener {
+public:
+	// Maximum number of levels that are loaded at the same time.
+	static const int DefaultMaxLoadCount = 4;
+
+	explicit CTextureStreamingManager( CTextureUploadQueue& uploadQueue, __int64 byteBudget = CTextureResidencyPolicy::DefaultByteBudget,
+		int tailSize = CTextureResidencyPolicy::DefaultTailSize );
+	~CTextureStreamingManager();
+
+	const CTextureResidencyPolicy& GetPolicy() const
+		{ return policy; }
+	void SetByteBudget( __int64 newValue )
+		{ policy.SetByteBudget( newValue ); }
+
+	int GetMaxLoadCount() const
+		{ return maxLoadCount; }
+	void SetMaxLoadCount( int newValue );
+
+	// Add a two-dimensional texture and upload its tail levels. Return the texture handle.
+	// Images created by CDdsImage::CreateMappedImageData keep the finer levels in the file until they are streamed in.
+	// topLeftOrigin indicates that the levels should be flipped vertically during the upload.
+	// Internal format is ignored if the data is compressed.
+	int AddTexture( CImageData sourceData, bool topLeftOrigin, TTextureGlFormat internalFormat = TGF_RGBA );
+	// Remove the texture. The texture object is deleted when its pending load is finished.
+	void RemoveTexture( int texture );
+	// Identifier of the texture object.
+	unsigned GetTextureId( int texture ) const
+		{ return textures[texture]->TextureId; }
+	// Number of levels that are waiting in the upload queue.
+	int GetLoadCount() const
+		{ return loadCount; }
+
+	// Mark the texture as used in the current frame with the given size on the screen in pixels.
+	void UpdateScreenSize( int texture, float screenSize )
+		{ policy.UpdateScreenSize( texture, screenSize ); }
+	// Release the evicted levels and start loading the required ones. Must be called once per frame after the screen sizes are updated.
+	void Update();
+
+	// ITextureUploadListener.
+	virtual void OnUploadComplete( int uploadId ) override;
+	virtual void OnUploadLost( int uploadId ) override;
+
+private:
+	// Streamed texture data.
+	struct CStreamedTexture {
+		CImageData Source;
+		// Levels are flipped vertically during the upload.
+		bool HasTopLeftOrigin;
+		TTextureGlFormat InternalFormat;
+		unsigned TextureId;
+		// Finest level that has storage. It is finer than the resident level while the level is loading.
+		int StorageLevel = 0;
+		// The texture was removed while its level was loading.
+		bool IsRemoved = false;
+
+		CStreamedTexture( CImageData&& source, bool hasTopLeftOrigin, TTextureGlFormat internalFormat, unsigned textureId ) :
+			Source( move( source ) ), HasTopLeftOrigin( hasTopLeftOrigin ), InternalFormat( internalFormat ), TextureId( textureId ) {}
+	};
+
+	CTextureUploadQueue& uploadQueue;
+	CTextureResidencyPolicy policy;
+	int maxLoadCount = DefaultMaxLoadCount;
+	int loadCount = 0;
+	// Textures indexed by the policy handles.
+	CArray<CPtrOwner<CStreamedTexture>> textures;
+	// Buffer for the textures evicted during the update.
+	CArray<int> evictedTextures;
+
+	bool startLevelLoad( int texture, int level );
+	void loadLevelDirectly( int texture, int level );
+	void releaseEvictedLevels( int texture );
+	void finishLevelLoad( int texture, bool isLoaded );
+	void deleteTexture( int texture );
+	void updateMipmapRange( int texture );
+	static void setLevelStorage( const CStreamedTexture& texture, int level, const BYTE* data );
+	static void releaseLevelStorage( const CStreamedTexture& texture, int level );
+	static GinInternal::CTextureData getTextureData( const CStreamedTexture& texture );
+
+	// Copying is prohibited.
+	CTextureStreamingManager( CTextureStreamingManager& ) = delete;
+	void operator=( CTextureStreamingManager& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
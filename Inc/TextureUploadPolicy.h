@@ -0,0 +1,126 @@
+#pragma once
+#include <Gindefs.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Usage statistics of the texture upload queue.
+struct CTextureUploadStatistics {
+	// Number of uploads issued to the driver.
+	int UploadCount = 0;
+	// Total size of the issued uploads in bytes.
+	__int64 UploadedByteCount = 0;
+	// Number of times a loader found no staging memory available.
+	int StagingShortageCount = 0;
+	// Number of frames that ended with queued uploads postponed by the byte budget.
+	int DeferredFrameCount = 0;
+};
+
+// Life cycle stage of a staging slot.
+enum TUploadSlotState {
+	// Staging memory has to be prepared by the render thread before it can be written.
+	USS_Idle,
+	// Staging memory can be acquired by a loader.
+	USS_Available,
+	// A loader is writing to the staging memory.
+	USS_Writing,
+	// The data is waiting for its turn to be uploaded.
+	USS_Queued,
+	// The upload has been issued. Staging memory is read by the GPU until the slot is released.
+	USS_Pending
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Scheduling part of the texture upload queue.
+// Tracks a fixed number of equally sized staging slots and decides which of the queued uploads are issued during the current frame.
+// Uploads are issued in the commit order. The byte budget limits the size of all the uploads issued in a frame, an upload that is bigger than the whole budget is issued alone.
+// Pending slots are released in the issue order, the same way the GPU signals its fences.
+// No OpenGL calls are made and the policy can be used without a rendering context. The policy is not synchronized, the owner is responsible for locking.
+class GINAPI CTextureUploadPolicy {
+public:
+	static const int DefaultFrameByteBudget = 4 * 1024 * 1024;
+
+	CTextureUploadPolicy( int slotCount, int slotByteSize, int frameByteBudget = DefaultFrameByteBudget );
+
+	int GetSlotCount() const
+		{ return slots.Size(); }
+	// Capacity of a single slot. Bigger uploads can't be staged.
+	int GetSlotByteSize() const
+		{ return slotByteSize; }
+
+	int GetFrameByteBudget() const
+		{ return frameByteBudget; }
+	void SetFrameByteBudget( int newValue );
+	// Size of the uploads issued during the current frame.
+	int GetFrameUploadedByteCount() const
+		{ return frameUploadedByteCount; }
+
+	TUploadSlotState GetSlotState( int slot ) const
+		{ return slots[slot].State; }
+	// Size of the data committed to the slot.
+	int GetSlotDataSize( int slot ) const
+		{ return slots[slot].DataSize; }
+	int GetQueuedCount() const
+		{ return queuedSlots.Size(); }
+	int GetPendingCount() const
+		{ return pendingSlots.Size(); }
+
+	const CTextureUploadStatistics& GetStatistics() const
+		{ return statistics; }
+	void ResetStatistics()
+		{ statistics = CTextureUploadStatistics(); }
+
+	// Start a new frame. The byte budget is restored.
+	void AdvanceFrame();
+
+	// Find a slot with staging memory that needs to be prepared. Return NotFound if there is no such slot.
+	int FindIdleSlot() const;
+	// Staging memory of an idle slot is ready to be written by the loaders.
+	void OnSlotPrepared( int slot );
+
+	// Reserve an available slot for writing data of the given size. Return NotFound if all the slots are busy.
+	int AcquireSlot( int byteSize );
+	// Put the written data of an acquired slot to the end of the upload queue.
+	void CommitSlot( int slot, int byteSize );
+	// Return an acquired slot without uploading anything.
+	void CancelSlot( int slot );
+
+	// Take the next queued slot if it fits into the remaining budget of the frame. The slot becomes pending.
+	// Return NotFound if the queue is empty or the budget is exhausted.
+	int ScheduleNextUpload();
+	// Slot that was issued first among the pending ones. NotFound if nothing is pending.
+	int GetOldestPendingSlot() const
+		{ return pendingSlots.IsEmpty() ? NotFound : pendingSlots[0]; }
+	// The GPU has finished reading a pending slot or its upload was abandoned. The slot becomes idle.
+	void ReleaseSlot( int slot );
+
+private:
+	// Staging slot information.
+	struct CUploadSlot {
+		TUploadSlotState State = USS_Idle;
+		int DataSize = 0;
+	};
+
+	int slotByteSize;
+	int frameByteBudget;
+	int frameUploadedByteCount = 0;
+	int frameUploadCount = 0;
+	// The budget prevented an upload during the current frame.
+	bool isFrameDeferred = false;
+	CTextureUploadStatistics statistics;
+
+	CArray<CUploadSlot> slots;
+	// Queued slots in the commit order.
+	CArray<int> queuedSlots;
+	// Pending slots in the issue order.
+	CArray<int> pendingSlots;
+
+	static void deleteSlotIndex( int slot, CArray<int>& slotList );
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,108 @@
+#pragma once
+#include <Gindefs.h>
+#include <DrawEnums.h>
+#include <TextureUploadPolicy.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Receiver of the texture upload notifications. Methods are called on the render thread during the queue update.
+class ITextureUploadListener {
+public:
+	virtual ~ITextureUploadListener() {}
+
+	// The GPU has copied the data to the texture and the staging memory has been released.
+	virtual void OnUploadComplete( int uploadId ) = 0;
+	// The driver discarded the staging memory before the upload was issued. The data needs to be submitted again.
+	virtual void OnUploadLost( int uploadId ) = 0;
+};
+
+// Destination of a staged texture upload.
+struct CTextureUploadRequest {
+	// Identifier of the texture. The texture must have storage for the region.
+	unsigned TextureId = 0;
+	// Two-dimensional textures, two-dimensional texture arrays and cube maps are supported.
+	TTextureBindingTarget Target = TBT_Texture2;
+	// Updated cube map face.
+	TTextureCubeFace Face = TCF_PositiveX;
+	// Updated layer of a texture array.
+	int Layer = 0;
+	int Level = 0;
+	// Position and size of the region in texels. Compressed regions must be aligned to the block size.
+	CVector2<int> Offset;
+	CVector2<int> Size;
+	TTexelFormat TexelFormat = TF_RGBA;
+	TTexelDataType DataType = TDT_UnsignedByte;
+	// Compressed data is uploaded as is, the texel format and type are ignored.
+	TTextureCompressionType CompressionType = TCT_Uncompressed;
+	// Receiver of the notifications. May be null.
+	ITextureUploadListener* Listener = nullptr;
+	// Identifier passed to the listener.
+	int UploadId = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Asynchronous texture upload queue.
+// Loader threads write texture data directly to mapped pixel unpack buffers, the render thread copies the staged data to the textures within a per-frame byte budget.
+// A fence is placed after each upload, the staging buffer is reused when the fence is signaled. Scheduling is delegated to CTextureUploadPolicy.
+// Loader methods can be called from any thread. The constructor, the destructor and the rest of the methods must be called on the thread with the rendering context.
+class GINAPI CTextureUploadQueue {
+public:
+	static const int DefaultStagingBufferCount = 8;
+	static const int DefaultStagingBufferSize = 4 * 1024 * 1024;
+
+	explicit CTextureUploadQueue( int stagingBufferCount = DefaultStagingBufferCount, int stagingBufferSize = DefaultStagingBufferSize,
+		int frameByteBudget = CTextureUploadPolicy::DefaultFrameByteBudget );
+	~CTextureUploadQueue();
+
+	// Maximum size of a single upload.
+	int GetStagingBufferSize() const
+		{ return stagingBufferSize; }
+	int GetFrameByteBudget() const;
+	void SetFrameByteBudget( int newValue );
+	CTextureUploadStatistics GetStatistics() const;
+
+	// Loader methods.
+	// Reserve staging memory for an upload of the given size. The memory can be written until the upload is committed or cancelled.
+	// Return NotFound if all the staging buffers are busy, the caller is expected to try again later.
+	int BeginUpload( int byteSize, BYTE*& stagingMemory );
+	// Queue the data written to the staging memory for upload to the given region.
+	void CommitUpload( int uploadHandle, int byteSize, const CTextureUploadRequest& request );
+	// Release the staging memory without uploading.
+	void CancelUpload( int uploadHandle );
+
+	// Issue the queued uploads that fit into the frame budget, notify the listeners of the finished uploads and prepare the released staging buffers.
+	// Must be called once per frame.
+	void Update();
+
+private:
+	// Size of a single staging buffer.
+	const int stagingBufferSize;
+	// Scheduling information. Protected by the lock.
+	CTextureUploadPolicy policy;
+	mutable CRITICAL_SECTION lock;
+
+	// Slot data. Requests and mapped memory are written by the loaders only while the slot is in the writing state.
+	CArray<unsigned> bufferIds;
+	CArray<BYTE*> mappedMemory;
+	CArray<CTextureUploadRequest> requests;
+	// Fences of the pending slots. Stored as a void pointer to keep the OpenGL types out of the interface.
+	CArray<void*> fences;
+
+	void releaseFinishedUploads();
+	void issueQueuedUploads();
+	void prepareIdleSlots();
+	bool unmapStagingBuffer( int slot );
+	void uploadRegion( const CTextureUploadRequest& request, int byteSize ) const;
+
+	// Copying is prohibited.
+	CTextureUploadQueue( CTextureUploadQueue& ) = delete;
+	void operator=( CTextureUploadQueue& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Sample encoding of the WAV data chunk.
+enum TWavSampleEncoding {
+	WSE_Pcm8,
+	WSE_Pcm16,
+	WSE_Pcm24,
+	WSE_Pcm32,
+	WSE_Float32,
+	WSE_ImaAdpcm
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Incremental decoder of mono and stereo WAV files.
+// The data chunk is read on demand and converted to a format accepted by OpenAL: 8 and 16 bit PCM is passed as is,
+// wider samples are converted to 32 bit float if allowed or to 16 bit PCM otherwise, IMA ADPCM is decoded to 16 bit PCM.
+// The decoder makes no OpenAL calls, so its output can be consumed without an audio device.
+class GINAPI CWavDecoder {
+public:
+	explicit CWavDecoder( CStringPart fileName, bool allowFloatOutput = false );
+
+	TWavSampleEncoding GetEncoding() const
+		{ return encoding; }
+	int GetChannelCount() const
+		{ return channelCount; }
+	int GetSampleRate() const
+		{ return sampleRate; }
+	// Total number of sample frames in the file. A frame contains a sample for each channel.
+	int GetFrameCount() const
+		{ return frameCount; }
+	// Number of frames decoded since the start of the data.
+	int GetPosition() const
+		{ return position; }
+	bool IsFinished() const
+		{ return position >= frameCount; }
+
+	TAudioDataFormat GetOutputFormat() const
+		{ return outputFormat; }
+	// Size of a decoded frame in bytes.
+	int GetOutputFrameSize() const
+		{ return outputFrameSize; }
+
+	// Decode up to maxFrameCount frames from the current position and append them to the result. Return the number of decoded frames.
+	int Decode( int maxFrameCount, CArray<BYTE>& result );
+	// Return to the start of the data.
+	void Rewind();
+
+private:
+	CDynamicFile wavFile;
+	TWavSampleEncoding encoding = WSE_Pcm16;
+	int channelCount = 0;
+	int sampleRate = 0;
+	// Size of a frame for PCM data, size of a compressed block for ADPCM data.
+	int blockAlign = 0;
+	int frameCount = 0;
+	TAudioDataFormat outputFormat = ADF_Mono16;
+	int outputFrameSize = 0;
+
+	// Location of the data chunk in the file.
+	int dataOffset = 0;
+	int dataSize = 0;
+	// Number of data bytes read from the file.
+	int dataPosition = 0;
+	int position = 0;
+
+	// Raw data read from the file.
+	CArray<BYTE> readBuffer;
+	// Samples of the last decoded ADPCM block and the number of frames that are already returned.
+	CArray<short> blockSamples;
+	int blockFrameCount = 0;
+	int blockFramePosition = 0;
+	int framesPerBlock = 0;
+
+	void parseHeaders( bool allowFloatOutput );
+	void parseFormat( const BYTE* data, int size, bool allowFloatOutput );
+	int decodePcm( int maxFrameCount, CArray<BYTE>& result );
+	int decodeAdpcm( int maxFrameCount, CArray<BYTE>& result );
+	bool readAdpcmBlock();
+	int readData( int size );
+
+	void checkWavError( bool condition, CStringPart errorStr ) const;
+
+	// Copying is prohibited.
+	CWavDecoder( CWavDecoder& ) = delete;
+	void operator=( CWavDecoder& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
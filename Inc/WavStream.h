@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <Gindefs.h>
+#include <AudioSequence.h>
+#include <WavDecoder.h>
+#include <AudioBackend.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Streaming playback of a WAV file.
+// The file is decoded in parts to a small queue of audio buffers attached to a dedicated source.
+// Processed buffers are refilled in the Update method that must be called regularly while the stream is playing.
+class GINAPI CWavStream {
+public:
+	static const int DefaultBufferCount = 4;
+	static const int DefaultBufferDuration = 250;
+
+	// bufferDuration is the length of a single buffer in milliseconds.
+	explicit CWavStream( CStringPart fileName, int bufferCount = DefaultBufferCount, int bufferDuration = DefaultBufferDuration );
+	~CWavStream();
+
+	const CWavDecoder& GetDecoder() const
+		{ return decoder; }
+
+	// Looping streams start from the beginning after the end of the data.
+	bool IsLooping() const
+		{ return isLooping; }
+	void SetLooping( bool newValue )
+		{ isLooping = newValue; }
+
+	// Check if the stream is playing or paused.
+	bool IsActive() const
+		{ return isActive; }
+	bool IsPaused() const
+		{ return isPaused; }
+
+	void SetPosition( CVector3<float> newValue );
+	void SetGain( float newValue );
+
+	// Start playing from the current position or resume after a pause.
+	void Play();
+	// Pause the stream without releasing the queued data.
+	void Pause();
+	// Stop playing and return to the start of the file.
+	void Stop();
+
+	// Refill the processed buffers. Restart the source if it has run out of data.
+	void Update();
+
+private:
+	IAudioBackend& backend;
+	CWavDecoder decoder;
+	CSoundOwner buffers;
+	// Identifier of the stream source.
+	unsigned sourceId = 0;
+	// Number of frames in a single buffer.
+	int bufferFrameCount;
+	// Decoded data for a buffer.
+	CArray<BYTE> bufferData;
+	bool isLooping = false;
+	bool isActive = false;
+	bool isPaused = false;
+
+	void queueBuffers( CArrayView<unsigned> bufferIds );
+	bool fillBuffer( unsigned bufferId );
+
+	// Copying is prohibited.
+	CWavStream( CWavStream& ) = delete;
+	void operator=( CWavStream& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
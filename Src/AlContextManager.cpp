@@ -3,9 +3,10 @@
 
 #ifndef GIN_NO_AUDIO
 
-#include <OpenAl\alc.h>
 #include <AlContextManager.h>
 #include <AudioSequence.h>
+#include <OpenAlBackend.h>
+#include <SoftwareMixer.h>
 
 namespace Gin {
 
@@ -15,28 +16,37 @@ namespace Audio {
 
 void CAlContextManager::Initialize()
 {
-	// Open the default device.
-	device = alcOpenDevice( 0 );
-	assert( device != 0 );
-	context = alcCreateContext( device, 0 );
-	assert( context != 0 );
-	const bool makeCurrentResult = alcMakeContextCurrent( context ) != ALC_FALSE;
-	makeCurrentResult;
-	assert( makeCurrentResult );
+	InitializeBackend( CreateOwner<COpenAlBackend>() );
+}
+
+void CAlContextManager::InitializeSoftware( CPtrOwner<IAudioSink> sink, int sampleRate )
+{
+	auto mixer = CreateOwner<CSoftwareMixer>( move( sink ), sampleRate );
+	CSoftwareMixer* mixerPtr = mixer;
+	InitializeBackend( move( mixer ) );
+	softwareMixer = mixerPtr;
+}
+
+void CAlContextManager::InitializeBackend( CPtrOwner<IAudioBackend> newBackend )
+{
+	assert( !HasContext() );
+	assert( newBackend != nullptr );
+	backend = move( newBackend );
 	initSources();
 }
 
 const int maxSourcesCount = 16;
 void CAlContextManager::initSources()
 {
-	CStackArray<unsigned, maxSourcesCount> srcIds;
-	alGenSources( maxSourcesCount, srcIds.Ptr() );
-	assert( alGetError() == AL_NO_ERROR );
-
 	activeRecords.ResetBuffer( maxSourcesCount );
-	for( auto id : srcIds ) {
-		activeRecords.Add( id );
+	sourceIds.Empty();
+	for( int i = 0; i < maxSourcesCount; i++ ) {
+		const unsigned sourceId = backend->CreateSource();
+		activeRecords.Add( sourceId );
+		sourceIds.Add( sourceId );
 	}
+	sourceStates.Empty();
+	sourceStates.IncreaseSize( maxSourcesCount );
 }
 
 CAlContextManager::~CAlContextManager()
@@ -48,83 +58,372 @@ CAlContextManager::~CAlContextManager()
 
 void CAlContextManager::Cleanup()
 {
-	alcMakeContextCurrent( 0 );
-	alcDestroyContext( context );
-	context = nullptr;
-	alcCloseDevice( device );
-	device = 0;
+	StopAllRecords();
+	// Sources are destroyed with the backend.
+	softwareMixer = nullptr;
+	backend = nullptr;
 }
 
 CAudioRecord CAlContextManager::CreateRecord( CSoundView seq, TSourcePriority priority, CVector3<float> pos, CVector3<float> velocity, bool isLooping )
 {
-	const auto freeSourcePos = findSourcePos( priority );
-	const auto& freeSource = activeRecords[freeSourcePos];
-	playSource( freeSource.Id, seq, pos, velocity, isLooping );
-	return CAudioRecord( freeSourcePos, freeSource.Generation );
+	int voicePos;
+	if( freeVoices.IsEmpty() ) {
+		voicePos = voices.Size();
+		voices.IncreaseSize( voicePos + 1 );
+	} else {
+		voicePos = freeVoices.Last();
+		freeVoices.DeleteLast();
+	}
+	voiceCount++;
+
+	auto& voice = voices[voicePos];
+	voice.Sound = seq;
+	voice.Position = pos;
+	voice.Velocity = velocity;
+	voice.Gain = 1.0f;
+	voice.Pitch = 1.0f;
+	voice.Pan = 0.0f;
+	voice.IsLooping = isLooping;
+	voice.Priority = priority;
+	voice.State = CAudioRecord::RS_Playing;
+	voice.Offset = 0.0f;
+	voice.Duration = 0.0f;
+	for( auto bufferId : seq.Buffers() ) {
+		voice.Duration += backend->GetBufferDuration( bufferId );
+	}
+	voice.SourcePos = NotFound;
+	voice.Score = getVoiceScore( voice );
+
+	// The sound starts immediately if there is a free source or a less audible voice. Otherwise it is mapped by the next update.
+	int sourcePos = findFreeSource();
+	if( sourcePos == NotFound ) {
+		sourcePos = findWeakestSource( voice.Score );
+		if( sourcePos != NotFound ) {
+			detachSource( activeRecords[sourcePos].VoicePos );
+		}
+	}
+	if( sourcePos != NotFound ) {
+		attachSource( voicePos, sourcePos );
+	}
+	return CAudioRecord( voicePos, voice.Generation );
+}
+
+int CAlContextManager::GetAudioRecord( int voicePos, int voiceGeneration ) const
+{
+	assert( voicePos >= 0 && voicePos < voices.Size() );
+	return voices[voicePos].Generation == voiceGeneration ? voicePos : NotFound;
 }
 
-int CAlContextManager::findSourcePos( TSourcePriority priority ) 
+CAudioRecord::TRecordState CAlContextManager::GetVoiceState( int voicePos ) const
 {
-	const auto recordCount = activeRecords.Size();
-	for( int i = 0; i < recordCount; i++ ) {
-		auto& src = activeRecords[i];
-		if( !isActive( src ) ) {
-			stopSource( src );
-			src.Priority = priority;
-			return i;
+	// States of the sources are cached by the update, so no backend queries are made.
+	return voices[voicePos].State;
+}
+
+void CAlContextManager::PlayVoice( int voicePos )
+{
+	auto& voice = voices[voicePos];
+	// Paused voices are resumed, other voices start from the beginning.
+	if( voice.State != CAudioRecord::RS_Paused ) {
+		voice.Offset = 0.0f;
+	}
+	voice.State = CAudioRecord::RS_Playing;
+	voice.Score = getVoiceScore( voice );
+	if( voice.SourcePos != NotFound ) {
+		backend->PlaySource( activeRecords[voice.SourcePos].Id );
+	} else {
+		const int sourcePos = findFreeSource();
+		if( sourcePos != NotFound ) {
+			attachSource( voicePos, sourcePos );
 		}
 	}
+}
 
-	// All created sources are playing or paused. At this point we can delete a random low priority sound, it will most likely not be noticeable.
-	for( int i = 0; i < recordCount; i++ ) {
-		auto& src = activeRecords[i];
-		if( src.Priority == SP_LowPriority ) {
-			stopSource( src );
-			src.Priority = priority;
+void CAlContextManager::PauseVoice( int voicePos )
+{
+	auto& voice = voices[voicePos];
+	if( voice.State != CAudioRecord::RS_Playing ) {
+		return;
+	}
+	voice.State = CAudioRecord::RS_Paused;
+	voice.Score = 0.0f;
+	if( voice.SourcePos != NotFound ) {
+		backend->PauseSource( activeRecords[voice.SourcePos].Id );
+	}
+}
+
+void CAlContextManager::StopVoice( int voicePos )
+{
+	freeVoice( voicePos );
+}
+
+void CAlContextManager::RewindVoice( int voicePos )
+{
+	auto& voice = voices[voicePos];
+	voice.State = CAudioRecord::RS_Initial;
+	voice.Offset = 0.0f;
+	voice.Score = 0.0f;
+	if( voice.SourcePos != NotFound ) {
+		backend->RewindSource( activeRecords[voice.SourcePos].Id );
+	}
+}
+
+void CAlContextManager::SetVoiceGain( int voicePos, float newValue )
+{
+	auto& voice = voices[voicePos];
+	voice.Gain = newValue;
+	if( voice.SourcePos != NotFound ) {
+		backend->SetSourceGain( activeRecords[voice.SourcePos].Id, newValue );
+	}
+}
+
+void CAlContextManager::SetVoicePitch( int voicePos, float newValue )
+{
+	auto& voice = voices[voicePos];
+	voice.Pitch = newValue;
+	if( voice.SourcePos != NotFound ) {
+		backend->SetSourcePitch( activeRecords[voice.SourcePos].Id, newValue );
+	}
+}
+
+void CAlContextManager::SetVoicePan( int voicePos, float newValue )
+{
+	auto& voice = voices[voicePos];
+	voice.Pan = newValue;
+	if( voice.SourcePos != NotFound ) {
+		setSourcePlacement( activeRecords[voice.SourcePos].Id, voice );
+	}
+}
+
+int CAlContextManager::GetVirtualVoiceCount() const
+{
+	int result = 0;
+	for( const auto& voice : voices ) {
+		if( voice.State == CAudioRecord::RS_Playing && voice.SourcePos == NotFound ) {
+			result++;
+		}
+	}
+	return result;
+}
+
+bool CAlContextManager::HasSoundRecords( CSoundView sound ) const
+{
+	for( const auto& voice : voices ) {
+		if( voice.State != CAudioRecord::RS_Stopped && voice.Sound == sound ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void CAlContextManager::Update( TTime secondsPassed )
+{
+	if( !HasContext() ) {
+		return;
+	}
+	updateSourceStates();
+	updateVirtualVoices( secondsPassed );
+	selectAudibleVoices();
+}
+
+// Query the states of the pool sources with a single call and release the voices that have finished playing.
+void CAlContextManager::updateSourceStates()
+{
+	backend->GetSourceStates( sourceIds.Size(), sourceIds.Ptr(), sourceStates.Ptr() );
+	for( int i = 0; i < activeRecords.Size(); i++ ) {
+		const int voicePos = activeRecords[i].VoicePos;
+		if( voicePos != NotFound && sourceStates[i] == CAudioRecord::RS_Stopped && voices[voicePos].State == CAudioRecord::RS_Playing ) {
+			freeVoice( voicePos );
+		}
+	}
+}
+
+// Advance the playback positions of the virtual voices.
+void CAlContextManager::updateVirtualVoices( TTime secondsPassed )
+{
+	for( int i = 0; i < voices.Size(); i++ ) {
+		auto& voice = voices[i];
+		if( voice.State != CAudioRecord::RS_Playing || voice.SourcePos != NotFound ) {
+			continue;
+		}
+		voice.Offset += secondsPassed * voice.Pitch;
+		if( voice.Offset >= voice.Duration ) {
+			if( voice.IsLooping && voice.Duration > 0.0f ) {
+				voice.Offset = fmodf( voice.Offset, voice.Duration );
+			} else {
+				freeVoice( i );
+			}
+		}
+	}
+}
+
+// Find the most audible playing voices and make sure that they have sources.
+void CAlContextManager::selectAudibleVoices()
+{
+	const int sourceCount = activeRecords.Size();
+	selectedVoices.Empty();
+	for( int i = 0; i < voices.Size(); i++ ) {
+		auto& voice = voices[i];
+		voice.Score = getVoiceScore( voice );
+		if( voice.State != CAudioRecord::RS_Playing ) {
+			continue;
+		}
+		if( selectedVoices.Size() == sourceCount && voices[selectedVoices.Last()].Score >= voice.Score ) {
+			continue;
+		}
+		// The selection is sorted by the score in the descending order.
+		if( selectedVoices.Size() == sourceCount ) {
+			selectedVoices.DeleteLast();
+		}
+		selectedVoices.Add( i );
+		for( int pos = selectedVoices.Size() - 1; pos > 0 && voices[selectedVoices[pos - 1]].Score < voice.Score; pos-- ) {
+			swap( selectedVoices[pos - 1], selectedVoices[pos] );
+		}
+	}
+
+	for( auto voicePos : selectedVoices ) {
+		const auto& voice = voices[voicePos];
+		if( voice.SourcePos != NotFound ) {
+			continue;
+		}
+		int sourcePos = findFreeSource();
+		if( sourcePos == NotFound ) {
+			// Voices with lower scores are not selected. Voices with equal scores keep their sources.
+			sourcePos = findWeakestSource( voice.Score );
+			if( sourcePos == NotFound ) {
+				continue;
+			}
+			detachSource( activeRecords[sourcePos].VoicePos );
+		}
+		attachSource( voicePos, sourcePos );
+	}
+}
+
+// Voices that play on a source get a bonus to their score, so that the voices with close scores don't swap their sources every frame.
+static const float attachedVoiceScoreFactor = 1.1f;
+// High priority voices are virtualized only if all the sources are taken by other high priority voices.
+static const float highPriorityScoreFactor = 1000000.0f;
+// Score of a playing voice is its priority multiplied by its audibility. Other voices have a zero score.
+float CAlContextManager::getVoiceScore( const CVoice& voice ) const
+{
+	if( voice.State != CAudioRecord::RS_Playing ) {
+		return 0.0f;
+	}
+	// Panned voices are placed at the distance of 1 from the listener.
+	float distance = 1.0f;
+	if( voice.Pan == 0.0f ) {
+		const auto listenerPos = listener.GetPos();
+		const float dx = voice.Position.X() - listenerPos.X();
+		const float dy = voice.Position.Y() - listenerPos.Y();
+		const float dz = voice.Position.Z() - listenerPos.Z();
+		distance = sqrtf( dx * dx + dy * dy + dz * dz );
+	}
+	// The attenuation follows the distance model of the backend.
+	const float audibility = voice.Gain * backend->GetDistanceGain( distance );
+
+	const float priorityFactor = voice.Priority == SP_HighPriority ? highPriorityScoreFactor : 1.0f;
+	const float attachedFactor = voice.SourcePos != NotFound ? attachedVoiceScoreFactor : 1.0f;
+	return priorityFactor * attachedFactor * audibility;
+}
+
+int CAlContextManager::findFreeSource() const
+{
+	for( int i = 0; i < activeRecords.Size(); i++ ) {
+		if( activeRecords[i].VoicePos == NotFound ) {
 			return i;
 		}
 	}
+	return NotFound;
+}
 
-	// All the playing sources are high priority. This is not supposed to happen, just throw.
-	assert( false );
-	return 0;
+// Find the source of the voice with the lowest score that is less than the given one.
+int CAlContextManager::findWeakestSource( float score ) const
+{
+	int result = NotFound;
+	float resultScore = score;
+	for( int i = 0; i < activeRecords.Size(); i++ ) {
+		const int voicePos = activeRecords[i].VoicePos;
+		if( voicePos != NotFound && voices[voicePos].Score < resultScore ) {
+			result = i;
+			resultScore = voices[voicePos].Score;
+		}
+	}
+	return result;
 }
 
-bool CAlContextManager::isActive( const CPlayingSource& src ) const
+// Start playing the voice on the source from its current position.
+void CAlContextManager::attachSource( int voicePos, int sourcePos )
 {
-	int result;
-	alGetSourcei( src.Id, AL_SOURCE_STATE, &result );
-	return result != CAudioRecord::RS_Initial && result != CAudioRecord::RS_Stopped;	
+	auto& voice = voices[voicePos];
+	auto& source = activeRecords[sourcePos];
+	assert( voice.SourcePos == NotFound && source.VoicePos == NotFound );
+	voice.SourcePos = sourcePos;
+	source.VoicePos = voicePos;
+
+	const unsigned sourceId = source.Id;
+	setSourcePlacement( sourceId, voice );
+	backend->SetSourceVelocity( sourceId, voice.Velocity );
+	backend->SetSourceGain( sourceId, voice.Gain );
+	backend->SetSourcePitch( sourceId, voice.Pitch );
+	backend->SetSourceLooping( sourceId, voice.IsLooping );
+	backend->QueueBuffers( sourceId, voice.Sound.Buffers().Size(), voice.Sound.Buffers().Ptr() );
+	if( voice.Offset > 0.0f ) {
+		backend->SetSourceOffset( sourceId, voice.Offset );
+	}
+	backend->PlaySource( sourceId );
+	voice.Score = getVoiceScore( voice );
 }
 
-void CAlContextManager::playSource( int srcId, CSoundView seq, CVector3<float> pos, CVector3<float> velocity, bool isLooping ) const
+// Make the voice virtual and release its source.
+void CAlContextManager::detachSource( int voicePos )
 {
-	assert( srcId >= 0 );
-	alSourcefv( srcId, AEP_Position, pos.Ptr() );
-	alSourcefv( srcId, AEP_Velocity, velocity.Ptr() );
-	alSourcei( srcId, AL_LOOPING, isLooping ? AL_TRUE : AL_FALSE );
-	alSourceQueueBuffers( srcId, seq.Buffers().Size(), seq.Buffers().Ptr() );
-	alSourcePlay( srcId );
-	assert( alGetError() == AL_NO_ERROR );
+	auto& voice = voices[voicePos];
+	if( voice.SourcePos == NotFound ) {
+		return;
+	}
+	auto& source = activeRecords[voice.SourcePos];
+	if( voice.State == CAudioRecord::RS_Playing || voice.State == CAudioRecord::RS_Paused ) {
+		voice.Offset = backend->GetSourceOffset( source.Id );
+	}
+	backend->StopSource( source.Id );
+	backend->DetachBuffers( source.Id );
+	source.VoicePos = NotFound;
+	voice.SourcePos = NotFound;
+	voice.Score = getVoiceScore( voice );
 }
 
-void CAlContextManager::stopSource( CPlayingSource& src )
+// Panned voices are placed on a unit circle in front of the listener, so every backend pans them by the source direction.
+void CAlContextManager::setSourcePlacement( unsigned sourceId, const CVoice& voice )
 {
-	alSourceStop( src.Id );
-	alSourcei( src.Id, AL_BUFFER, 0 );
-	src.Generation++;
+	if( voice.Pan == 0.0f ) {
+		backend->SetSourceRelative( sourceId, false );
+		backend->SetSourcePosition( sourceId, voice.Position );
+	} else {
+		const float x = max( -1.0f, min( 1.0f, voice.Pan ) );
+		backend->SetSourceRelative( sourceId, true );
+		backend->SetSourcePosition( sourceId, CVector3<float>( x, 0.0f, -sqrtf( 1.0f - x * x ) ) );
+	}
 }
 
-int CAlContextManager::GetAudioRecord( int sourcePos, int sourceGeneration ) const
+// Stop the voice and invalidate its records.
+void CAlContextManager::freeVoice( int voicePos )
 {
-	assert( sourcePos >= 0 && sourcePos < activeRecords.Size() );
-	return activeRecords[sourcePos].Generation == sourceGeneration ? activeRecords[sourcePos].Id : NotFound;
+	detachSource( voicePos );
+	auto& voice = voices[voicePos];
+	voice.State = CAudioRecord::RS_Stopped;
+	voice.Sound = CSoundView();
+	voice.Score = 0.0f;
+	voice.Generation++;
+	freeVoices.Add( voicePos );
+	voiceCount--;
 }
 
 void CAlContextManager::StopAllRecords()
 {
-	for( auto& src : activeRecords ) {
-		stopSource( src );
+	for( int i = 0; i < voices.Size(); i++ ) {
+		if( voices[i].State != CAudioRecord::RS_Stopped ) {
+			freeVoice( i );
+		}
 	}
 }
 
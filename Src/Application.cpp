@@ -166,6 +166,9 @@ void CApplication::runUpdateLoop()
 	if( frameInfo.RunUpdate ) {
 		stateManager->GetCurrentState().Update( frameInfo.Step );
 		executeActions( postUpdateActions );
+#ifndef GIN_NO_AUDIO
+		mainFrame.AlContextManager().Update( frameInfo.Step );
+#endif
 		mainFrame.InputHandler().OnFrameEnd();
 	}
 
@@ -24,22 +24,14 @@ CAudioListener::CAudioListener() :
 void CAudioListener::SetPos( CVector3<float> newValue )
 {
 	assert( GetAudioContextManager().HasContext() );
-	alListenerfv( AEP_Position, newValue.Ptr() );
-	checkLastAudioError();
+	GetAudioContextManager().GetBackend().SetListenerPosition( newValue );
 	position = newValue;
 }
 
-void CAudioListener::checkLastAudioError() const
-{
-	assert( alGetError() == AL_NO_ERROR );
-}
-
 void CAudioListener::SetDir( CVector3<float> newDir, CVector3<float> newUpVecotr )
 {
 	assert( GetAudioContextManager().HasContext() );
-	CVector<float, 6> orientation( newDir, newUpVecotr );
-	alListenerfv( AEP_Orientation, orientation.Ptr() );
-	checkLastAudioError();
+	GetAudioContextManager().GetBackend().SetListenerOrientation( newDir, newUpVecotr );
 	direction = newDir;
 	upVector = newUpVecotr;
 }
@@ -47,8 +39,7 @@ void CAudioListener::SetDir( CVector3<float> newDir, CVector3<float> newUpVecotr
 void CAudioListener::SetVelocity( CVector3<float> newValue )
 {
 	assert( GetAudioContextManager().HasContext() );
-	alListenerfv( AEP_Velocity, newValue.Ptr() );
-	checkLastAudioError();
+	GetAudioContextManager().GetBackend().SetListenerVelocity( newValue );
 	velocity = newValue;
 }
 
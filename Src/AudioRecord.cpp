@@ -14,8 +14,8 @@ namespace Audio {
 
 //////////////////////////////////////////////////////////////////////////
 
-CAudioRecord::CAudioRecord( int _sourcePos, int generation ) :
-	sourcePos( _sourcePos ),
+CAudioRecord::CAudioRecord( int _voicePos, int generation ) :
+	voicePos( _voicePos ),
 	recordGeneration( generation )
 {
 }
@@ -26,20 +26,12 @@ CAudioRecord::TRecordState CAudioRecord::GetState() const
 	if( recordId == NotFound ) {
 		return RS_Stopped;
 	}
-	int result;
-	alGetSourcei( recordId, AL_SOURCE_STATE, &result );
-	checkLastAudioError();
-	return TRecordState( result );
-}
-
-void CAudioRecord::checkLastAudioError() const
-{
-	assert( alGetError() == AL_NO_ERROR );
+	return GetAudioContextManager().GetVoiceState( recordId );
 }
 
 int CAudioRecord::getRecordId() const
 {
-	return GetAudioContextManager().GetAudioRecord( sourcePos, recordGeneration );
+	return GetAudioContextManager().GetAudioRecord( voicePos, recordGeneration );
 }
 
 bool CAudioRecord::IsActive() const
@@ -52,8 +44,7 @@ void CAudioRecord::Play()
 {
 	const int recordId = getRecordId();
 	if( recordId != NotFound ) {
-		alSourcePlay( recordId );
-		checkLastAudioError();
+		GetAudioContextManager().PlayVoice( recordId );
 	}
 }
 
@@ -61,8 +52,7 @@ void CAudioRecord::Stop()
 {
 	const int recordId = getRecordId();
 	if( recordId != NotFound ) {
-		alSourceStop( recordId );
-		checkLastAudioError();
+		GetAudioContextManager().StopVoice( recordId );
 	}
 }
 
@@ -70,8 +60,7 @@ void CAudioRecord::Pause()
 {
 	const int recordId = getRecordId();
 	if( recordId != NotFound ) {
-		alSourcePause( recordId );
-		checkLastAudioError();
+		GetAudioContextManager().PauseVoice( recordId );
 	}
 }
 
@@ -79,8 +68,31 @@ void CAudioRecord::Rewind()
 {
 	const int recordId = getRecordId();
 	if( recordId != NotFound ) {
-		alSourceRewind( recordId );
-		checkLastAudioError();
+		GetAudioContextManager().RewindVoice( recordId );
+	}
+}
+
+void CAudioRecord::SetGain( float newValue )
+{
+	const int recordId = getRecordId();
+	if( recordId != NotFound ) {
+		GetAudioContextManager().SetVoiceGain( recordId, newValue );
+	}
+}
+
+void CAudioRecord::SetPitch( float newValue )
+{
+	const int recordId = getRecordId();
+	if( recordId != NotFound ) {
+		GetAudioContextManager().SetVoicePitch( recordId, newValue );
+	}
+}
+
+void CAudioRecord::SetPan( float newValue )
+{
+	const int recordId = getRecordId();
+	if( recordId != NotFound ) {
+		GetAudioContextManager().SetVoicePan( recordId, newValue );
 	}
 }
 
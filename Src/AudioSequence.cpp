@@ -17,28 +17,22 @@ CSoundOwner::CSoundOwner( int bufferCount )
 {
 	bufferIds.ResetSize( bufferCount );
 	assert( GetAudioContextManager().HasContext() );
-	alGenBuffers( bufferCount, bufferIds.Ptr() );
-	checkAudioError();
+	GetAudioContextManager().GetBackend().CreateBuffers( bufferCount, bufferIds.Ptr() );
 }
 
 CSoundOwner::~CSoundOwner()
 {
-	assert( GetAudioContextManager().HasContext() );
-	alDeleteBuffers( bufferIds.Size(), bufferIds.Ptr() );
-	checkAudioError();
+	if( !bufferIds.IsEmpty() ) {
+		assert( GetAudioContextManager().HasContext() );
+		GetAudioContextManager().GetBackend().DeleteBuffers( bufferIds.Size(), bufferIds.Ptr() );
+	}
 }
 
 void CSoundOwner::SetData( int bufferPos, TAudioDataFormat format, int frequency, const void* data, int size )
 {
 	assert( bufferPos >= 0 && bufferPos < bufferIds.Size() );
 	assert( frequency > 0 );
-	alBufferData( bufferIds[bufferPos], format, data, size, frequency );
-	checkAudioError();
-}
-
-void CSoundOwner::checkAudioError()
-{
-	assert( alGetError() == AL_NO_ERROR );
+	GetAudioContextManager().GetBackend().SetBufferData( bufferIds[bufferPos], format, frequency, data, size );
 }
 
 //////////////////////////////////////////////////////////////////////////
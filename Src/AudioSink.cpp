@@ -0,0 +1,106 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <AudioSink.h>
+#include <WavUtils.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+void CNullAudioSink::WriteFrames( CArrayView<float> samples, int )
+{
+	frameCount += samples.Size() / 2;
+	for( auto sample : samples ) {
+		peakLevel = max( peakLevel, fabsf( sample ) );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CWavFileSink::CWavFileSink( CStringPart fileName )
+{
+	wavFile.Open( fileName, FRWM_Write, FCM_CreateAlways, FSM_DenyNone );
+	// Space for the header. The actual values are known after the last frame.
+	writeHeader();
+}
+
+CWavFileSink::~CWavFileSink()
+{
+	Close();
+}
+
+void CWavFileSink::WriteFrames( CArrayView<float> samples, int _sampleRate )
+{
+	assert( wavFile.IsOpen() );
+	assert( sampleRate == 0 || sampleRate == _sampleRate );
+	sampleRate = _sampleRate;
+
+	buffer.Empty();
+	buffer.IncreaseSizeNoInitialize( samples.Size() );
+	for( int i = 0; i < samples.Size(); i++ ) {
+		const float sample = max( -1.0f, min( 1.0f, samples[i] ) );
+		buffer[i] = static_cast<short>( lrintf( sample * 32767.0f ) );
+	}
+	wavFile.Write( buffer.Ptr(), buffer.Size() * sizeof( short ) );
+	frameCount += samples.Size() / 2;
+}
+
+void CWavFileSink::Close()
+{
+	if( wavFile.IsOpen() ) {
+		wavFile.Seek( 0, FSP_Begin );
+		writeHeader();
+		wavFile.Close();
+	}
+}
+
+static const int riffId = 0x46464952;
+static const int waveId = 0x45564157;
+static const int formatChunkId = 0x20746d66;
+static const int dataChunkId = 0x61746164;
+static const int pcmFormatTag = 1;
+static const int sinkChannelCount = 2;
+void CWavFileSink::writeHeader()
+{
+	const int blockAlign = sinkChannelCount * sizeof( short );
+	const int dataSize = static_cast<int>( frameCount * blockAlign );
+
+	WAV::CWavSubheader1 format;
+	format.Id = formatChunkId;
+	format.Size = sizeof( format ) - 2 * sizeof( int );
+	format.AudioFormat = static_cast<short>( pcmFormatTag );
+	format.NumChannels = static_cast<short>( sinkChannelCount );
+	format.SampleRate = sampleRate;
+	format.ByteRate = sampleRate * blockAlign;
+	format.BlockAlign = static_cast<short>( blockAlign );
+	format.BitsPerSample = static_cast<short>( 8 * sizeof( short ) );
+
+	WAV::CWavSubheader2 data;
+	data.Id = dataChunkId;
+	data.Size = dataSize;
+
+	WAV::CRiffHeader riff;
+	riff.Id = riffId;
+	riff.Size = sizeof( riff.Format ) + sizeof( format ) + sizeof( data ) + dataSize;
+	riff.Format = waveId;
+
+	BYTE headerData[sizeof( riff ) + sizeof( format ) + sizeof( data )];
+	memcpy( headerData, &riff, sizeof( riff ) );
+	memcpy( headerData + sizeof( riff ), &format, sizeof( format ) );
+	memcpy( headerData + sizeof( riff ) + sizeof( format ), &data, sizeof( data ) );
+	wavFile.Write( headerData, sizeof( headerData ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
@@ -0,0 +1,637 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BlockCompressor.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Width and height of a compressed block in pixels.
+static const int blockPixelSize = 4;
+static const int blockPixelCount = blockPixelSize * blockPixelSize;
+// Maximum number of least squares iterations in the high quality tier.
+static const int maxRefinementCount = 4;
+
+void CBlockCompressor::SetWorkerCount( int newValue )
+{
+	assert( newValue > 0 );
+	workerCount = newValue;
+}
+
+bool CBlockCompressor::IsCompressionSupported( TTextureCompressionType type )
+{
+	switch( type ) {
+	case TCT_Dxt1_RGB:
+	case TCT_Dxt1_sRGB:
+	case TCT_Dxt5:
+	case TCT_Dxt5_sRGBA:
+	case TCT_Bc4:
+	case TCT_Bc5:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Number of block rows compressed by a single task.
+static const int compressionTaskBlockRowCount = 4;
+CImageData CBlockCompressor::Compress( const CImageData& source, TTextureCompressionType type ) const
+{
+	assert( IsCompressionSupported( type ) );
+	assert( source.Depth() == 1 );
+	CSourceLayout layout;
+	getSourceLayout( source, layout );
+
+	CImageData result( source.GetType(), source.Width(), source.Height(), 1, type, source.GetMipmapCount(), source.GetArrayCount() );
+	const int faceCount = source.GetCubeFaceCount();
+	const int imageCount = source.GetArrayCount() * faceCount;
+	const int blockSize = getBlockSize( type );
+	for( int level = 0; level < source.GetMipmapCount(); level++ ) {
+		const int levelWidth = max( 1, source.Width() >> level );
+		const int levelHeight = max( 1, source.Height() >> level );
+		const int blockColumnCount = Ceil( levelWidth, blockPixelSize );
+		const int blockRowCount = Ceil( levelHeight, blockPixelSize );
+		const int bandCount = Ceil( blockRowCount, compressionTaskBlockRowCount );
+		const int destImageSize = result.GetImageDataSize( level );
+		BYTE* destLevel = result.GetMipmapData( level ).Ptr();
+		auto compressBand = [&]( int, int taskIndex ) {
+			const int imagePos = taskIndex / bandCount;
+			const BYTE* srcImage = source.GetImageData( level, imagePos / faceCount, imagePos % faceCount );
+			BYTE* destImage = destLevel + imagePos * destImageSize;
+			const int firstRow = ( taskIndex % bandCount ) * compressionTaskBlockRowCount;
+			const int rowEnd = min( blockRowCount, firstRow + compressionTaskBlockRowCount );
+			BYTE blockPixels[blockPixelCount * 4];
+			for( int blockY = firstRow; blockY < rowEnd; blockY++ ) {
+				BYTE* destRow = destImage + blockY * blockColumnCount * blockSize;
+				for( int blockX = 0; blockX < blockColumnCount; blockX++ ) {
+					fetchBlock( srcImage, levelWidth, levelHeight, layout, blockX, blockY, blockPixels );
+					compressBlock( type, blockPixels, destRow + blockX * blockSize );
+				}
+			}
+		};
+		ParallelFor( imageCount * bandCount, workerCount, compressBand );
+	}
+	return result;
+}
+
+// Channel layouts of the supported source formats: texel format, pixel size and offsets of the red, green, blue and alpha channels.
+static const int sourceLayouts[][6] = {
+	{ TF_Red, 1, 0, NotFound, NotFound, NotFound },
+	{ TF_RG, 2, 0, 1, NotFound, NotFound },
+	{ TF_RGB, 3, 0, 1, 2, NotFound },
+	{ TF_BGR, 3, 2, 1, 0, NotFound },
+	{ TF_RGBA, 4, 0, 1, 2, 3 },
+	{ TF_BGRA, 4, 2, 1, 0, 3 }
+};
+void CBlockCompressor::getSourceLayout( const CImageData& source, CSourceLayout& result )
+{
+	assert( source.GetCompressionType() == TCT_Uncompressed && source.GetTexelDataType() == TDT_UnsignedByte );
+	for( const auto& layout : sourceLayouts ) {
+		if( layout[0] == source.GetTexelFormat() ) {
+			result.PixelSize = layout[1];
+			for( int i = 0; i < 4; i++ ) {
+				result.ChannelOffsets[i] = layout[2 + i];
+			}
+			return;
+		}
+	}
+	assert( false );
+}
+
+// Byte size of a BC1 and BC4 block.
+static const int smallBlockSize = 8;
+// Byte size of a BC3 and BC5 block.
+static const int bigBlockSize = 16;
+int CBlockCompressor::getBlockSize( TTextureCompressionType type )
+{
+	return ( type == TCT_Dxt1_RGB || type == TCT_Dxt1_sRGB || type == TCT_Bc4 ) ? smallBlockSize : bigBlockSize;
+}
+
+// Read a block of pixels in the RGBA format. Coordinates outside of the image are clamped.
+void CBlockCompressor::fetchBlock( const BYTE* image, int width, int height, const CSourceLayout& layout, int blockX, int blockY, BYTE* result )
+{
+	for( int y = 0; y < blockPixelSize; y++ ) {
+		const BYTE* srcRow = image + min( blockY * blockPixelSize + y, height - 1 ) * width * layout.PixelSize;
+		for( int x = 0; x < blockPixelSize; x++ ) {
+			const BYTE* srcPixel = srcRow + min( blockX * blockPixelSize + x, width - 1 ) * layout.PixelSize;
+			BYTE* destPixel = result + ( y * blockPixelSize + x ) * 4;
+			for( int i = 0; i < 4; i++ ) {
+				const int offset = layout.ChannelOffsets[i];
+				destPixel[i] = offset != NotFound ? srcPixel[offset] : ( i == 3 ? 255 : 0 );
+			}
+		}
+	}
+}
+
+void CBlockCompressor::compressBlock( TTextureCompressionType type, const BYTE* rgbaPixels, BYTE* result ) const
+{
+	switch( type ) {
+	case TCT_Dxt1_RGB:
+	case TCT_Dxt1_sRGB:
+		CompressColorBlock( rgbaPixels, result );
+		break;
+	case TCT_Dxt5:
+	case TCT_Dxt5_sRGBA:
+		// Alpha block goes first.
+		CompressChannelBlock( rgbaPixels + 3, 4, result );
+		CompressColorBlock( rgbaPixels, result + smallBlockSize );
+		break;
+	case TCT_Bc4:
+		CompressChannelBlock( rgbaPixels, 4, result );
+		break;
+	case TCT_Bc5:
+		CompressChannelBlock( rgbaPixels, 4, result );
+		CompressChannelBlock( rgbaPixels + 1, 4, result + smallBlockSize );
+		break;
+	default:
+		assert( false );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static int clampChannel( int value, int maxValue )
+{
+	return min( max( value, 0 ), maxValue );
+}
+
+// Convert a floating point color to the 5:6:5 format.
+static int quantizeColor( const float* color )
+{
+	const int r = clampChannel( Round( color[0] * 31 / 255 ), 31 );
+	const int g = clampChannel( Round( color[1] * 63 / 255 ), 63 );
+	const int b = clampChannel( Round( color[2] * 31 / 255 ), 31 );
+	return ( r << 11 ) | ( g << 5 ) | b;
+}
+
+// Convert a 5:6:5 color to 8 bits per channel.
+static void expandColor( int color, int* result )
+{
+	const int r = ( color >> 11 ) & 31;
+	const int g = ( color >> 5 ) & 63;
+	const int b = color & 31;
+	result[0] = ( r << 3 ) | ( r >> 2 );
+	result[1] = ( g << 2 ) | ( g >> 4 );
+	result[2] = ( b << 3 ) | ( b >> 2 );
+}
+
+// Colors of the four index values. Blocks are always encoded in the four color mode.
+static void findColorPalette( int first, int second, int palette[4][3] )
+{
+	expandColor( first, palette[0] );
+	expandColor( second, palette[1] );
+	for( int i = 0; i < 3; i++ ) {
+		palette[2][i] = ( 2 * palette[0][i] + palette[1][i] ) / 3;
+		palette[3][i] = ( palette[0][i] + 2 * palette[1][i] ) / 3;
+	}
+}
+
+// Weight of the first endpoint for each color index.
+static const float colorIndexWeights[4] = { 1.0f, 0.0f, 2.0f / 3, 1.0f / 3 };
+// Color index of each position on the line from the second endpoint to the first one.
+static const unsigned colorLineIndices[4] = { 1, 3, 2, 0 };
+
+void CBlockCompressor::CompressColorBlock( const BYTE* rgbaPixels, BYTE* result ) const
+{
+	float first[3];
+	float second[3];
+	findRangeEndpoints( rgbaPixels, first, second );
+	int bestFirst = quantizeColor( first );
+	int bestSecond = quantizeColor( second );
+	if( quality == BCQ_Fast ) {
+		writeColorBlock( bestFirst, bestSecond, projectColorIndices( rgbaPixels, bestFirst, bestSecond ), result );
+		return;
+	}
+
+	unsigned bestIndices;
+	int bestError = findColorIndices( rgbaPixels, bestFirst, bestSecond, bestIndices );
+	if( bestError > 0 && findPrincipalEndpoints( rgbaPixels, first, second ) ) {
+		const int principalFirst = quantizeColor( first );
+		const int principalSecond = quantizeColor( second );
+		unsigned indices;
+		const int error = findColorIndices( rgbaPixels, principalFirst, principalSecond, indices );
+		if( error < bestError ) {
+			bestFirst = principalFirst;
+			bestSecond = principalSecond;
+			bestIndices = indices;
+			bestError = error;
+		}
+	}
+
+	const int iterationCount = quality == BCQ_High ? maxRefinementCount : 1;
+	for( int i = 0; i < iterationCount && bestError > 0; i++ ) {
+		if( !refineColorEndpoints( rgbaPixels, bestIndices, first, second ) ) {
+			break;
+		}
+		const int refinedFirst = quantizeColor( first );
+		const int refinedSecond = quantizeColor( second );
+		unsigned indices;
+		const int error = findColorIndices( rgbaPixels, refinedFirst, refinedSecond, indices );
+		if( error >= bestError ) {
+			break;
+		}
+		bestFirst = refinedFirst;
+		bestSecond = refinedSecond;
+		bestIndices = indices;
+		bestError = error;
+	}
+	writeColorBlock( bestFirst, bestSecond, bestIndices, result );
+}
+
+// Inset of the bounding box endpoints relative to the channel range. Reduces the error for the values in the middle of the range.
+static const int rangeInsetShift = 4;
+// Find the endpoints on the diagonal of the color bounding box.
+// The diagonal is chosen by the correlation of red and blue with green.
+void CBlockCompressor::findRangeEndpoints( const BYTE* rgbaPixels, float* first, float* second )
+{
+	int minColor[3] = { 255, 255, 255 };
+	int maxColor[3] = { 0, 0, 0 };
+	int sum[3] = { 0, 0, 0 };
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		for( int c = 0; c < 3; c++ ) {
+			const int value = rgbaPixels[i * 4 + c];
+			minColor[c] = min( minColor[c], value );
+			maxColor[c] = max( maxColor[c], value );
+			sum[c] += value;
+		}
+	}
+
+	int redCovariance = 0;
+	int blueCovariance = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const BYTE* pixel = rgbaPixels + i * 4;
+		const int green = pixel[1] * blockPixelCount - sum[1];
+		redCovariance += ( pixel[0] * blockPixelCount - sum[0] ) * green;
+		blueCovariance += ( pixel[2] * blockPixelCount - sum[2] ) * green;
+	}
+
+	for( int c = 0; c < 3; c++ ) {
+		const int inset = ( maxColor[c] - minColor[c] ) >> rangeInsetShift;
+		first[c] = static_cast<float>( maxColor[c] - inset );
+		second[c] = static_cast<float>( minColor[c] + inset );
+	}
+	if( redCovariance < 0 ) {
+		const float temp = first[0];
+		first[0] = second[0];
+		second[0] = temp;
+	}
+	if( blueCovariance < 0 ) {
+		const float temp = first[2];
+		first[2] = second[2];
+		second[2] = temp;
+	}
+}
+
+// Number of power iterations used to find the principal axis.
+static const int powerIterationCount = 8;
+// Axes with smaller components are considered degenerate.
+static const float minAxisScale = 1e-5f;
+// Find the endpoints on the principal axis of the block colors. Return false if the colors have no dominant direction.
+bool CBlockCompressor::findPrincipalEndpoints( const BYTE* rgbaPixels, float* first, float* second )
+{
+	float mean[3] = { 0, 0, 0 };
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		for( int c = 0; c < 3; c++ ) {
+			mean[c] += rgbaPixels[i * 4 + c];
+		}
+	}
+	for( int c = 0; c < 3; c++ ) {
+		mean[c] /= blockPixelCount;
+	}
+
+	float covariance[3][3] = {};
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		float delta[3];
+		for( int c = 0; c < 3; c++ ) {
+			delta[c] = rgbaPixels[i * 4 + c] - mean[c];
+		}
+		for( int row = 0; row < 3; row++ ) {
+			for( int column = row; column < 3; column++ ) {
+				covariance[row][column] += delta[row] * delta[column];
+			}
+		}
+	}
+	covariance[1][0] = covariance[0][1];
+	covariance[2][0] = covariance[0][2];
+	covariance[2][1] = covariance[1][2];
+
+	// Start from the covariance row of the channel with the largest variance.
+	int startRow = 0;
+	for( int c = 1; c < 3; c++ ) {
+		if( covariance[c][c] > covariance[startRow][startRow] ) {
+			startRow = c;
+		}
+	}
+	float axis[3] = { covariance[startRow][0], covariance[startRow][1], covariance[startRow][2] };
+	for( int iteration = 0; iteration < powerIterationCount; iteration++ ) {
+		float next[3];
+		for( int row = 0; row < 3; row++ ) {
+			next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+		}
+		const float scale = max( fabsf( next[0] ), max( fabsf( next[1] ), fabsf( next[2] ) ) );
+		if( scale < minAxisScale ) {
+			return false;
+		}
+		for( int c = 0; c < 3; c++ ) {
+			axis[c] = next[c] / scale;
+		}
+	}
+	const float axisLength = sqrtf( axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] );
+	for( int c = 0; c < 3; c++ ) {
+		axis[c] /= axisLength;
+	}
+
+	// Projections are relative to the mean, so the range always contains zero.
+	float minProjection = 0;
+	float maxProjection = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const BYTE* pixel = rgbaPixels + i * 4;
+		const float projection = ( pixel[0] - mean[0] ) * axis[0] + ( pixel[1] - mean[1] ) * axis[1] + ( pixel[2] - mean[2] ) * axis[2];
+		minProjection = min( minProjection, projection );
+		maxProjection = max( maxProjection, projection );
+	}
+	for( int c = 0; c < 3; c++ ) {
+		first[c] = mean[c] + axis[c] * maxProjection;
+		second[c] = mean[c] + axis[c] * minProjection;
+	}
+	return true;
+}
+
+// Least squares systems with smaller determinants are considered degenerate.
+static const float minDeterminant = 1e-5f;
+// Find the endpoints that minimize the squared error for the given indices. Return false if the system is degenerate.
+bool CBlockCompressor::refineColorEndpoints( const BYTE* rgbaPixels, unsigned indices, float* first, float* second )
+{
+	float firstSquared = 0;
+	float secondSquared = 0;
+	float product = 0;
+	float firstSum[3] = { 0, 0, 0 };
+	float secondSum[3] = { 0, 0, 0 };
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const float firstWeight = colorIndexWeights[( indices >> ( 2 * i ) ) & 3];
+		const float secondWeight = 1 - firstWeight;
+		firstSquared += firstWeight * firstWeight;
+		secondSquared += secondWeight * secondWeight;
+		product += firstWeight * secondWeight;
+		for( int c = 0; c < 3; c++ ) {
+			firstSum[c] += firstWeight * rgbaPixels[i * 4 + c];
+			secondSum[c] += secondWeight * rgbaPixels[i * 4 + c];
+		}
+	}
+
+	const float determinant = firstSquared * secondSquared - product * product;
+	if( determinant < minDeterminant ) {
+		return false;
+	}
+	for( int c = 0; c < 3; c++ ) {
+		first[c] = ( firstSum[c] * secondSquared - secondSum[c] * product ) / determinant;
+		second[c] = ( secondSum[c] * firstSquared - firstSum[c] * product ) / determinant;
+	}
+	return true;
+}
+
+// Find the closest palette color for each pixel. Return the total squared error.
+int CBlockCompressor::findColorIndices( const BYTE* rgbaPixels, int first, int second, unsigned& indices )
+{
+	int palette[4][3];
+	findColorPalette( first, second, palette );
+	indices = 0;
+	int error = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const BYTE* pixel = rgbaPixels + i * 4;
+		int bestIndex = 0;
+		int bestDistance = INT_MAX;
+		for( int index = 0; index < 4; index++ ) {
+			const int r = pixel[0] - palette[index][0];
+			const int g = pixel[1] - palette[index][1];
+			const int b = pixel[2] - palette[index][2];
+			const int distance = r * r + g * g + b * b;
+			if( distance < bestDistance ) {
+				bestIndex = index;
+				bestDistance = distance;
+			}
+		}
+		indices |= bestIndex << ( 2 * i );
+		error += bestDistance;
+	}
+	return error;
+}
+
+// Find the indices by projecting the pixels on the line between the endpoints.
+unsigned CBlockCompressor::projectColorIndices( const BYTE* rgbaPixels, int first, int second )
+{
+	int firstColor[3];
+	int secondColor[3];
+	expandColor( first, firstColor );
+	expandColor( second, secondColor );
+	const int direction[3] = { firstColor[0] - secondColor[0], firstColor[1] - secondColor[1], firstColor[2] - secondColor[2] };
+	const int lengthSquared = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+	if( lengthSquared == 0 ) {
+		return 0;
+	}
+
+	unsigned indices = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const BYTE* pixel = rgbaPixels + i * 4;
+		const int projection = ( pixel[0] - secondColor[0] ) * direction[0] + ( pixel[1] - secondColor[1] ) * direction[1]
+			+ ( pixel[2] - secondColor[2] ) * direction[2];
+		const int position = ( clampChannel( projection, lengthSquared ) * 6 + lengthSquared ) / ( 2 * lengthSquared );
+		indices |= colorLineIndices[position] << ( 2 * i );
+	}
+	return indices;
+}
+
+void CBlockCompressor::writeColorBlock( int first, int second, unsigned indices, BYTE* result )
+{
+	// The first endpoint must be greater to select the four color mode.
+	if( first < second ) {
+		const int temp = first;
+		first = second;
+		second = temp;
+		// Swap the endpoints and the intermediate colors.
+		indices ^= 0x55555555;
+	} else if( first == second ) {
+		indices = 0;
+	}
+	result[0] = static_cast<BYTE>( first );
+	result[1] = static_cast<BYTE>( first >> 8 );
+	result[2] = static_cast<BYTE>( second );
+	result[3] = static_cast<BYTE>( second >> 8 );
+	for( int i = 0; i < 4; i++ ) {
+		result[4 + i] = static_cast<BYTE>( indices >> ( 8 * i ) );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Values of the eight indices.
+// If the first endpoint is greater, six values are interpolated between the endpoints (eight value mode).
+// Otherwise four values are interpolated and the last two are 0 and 255 (six value mode).
+static void findChannelPalette( int first, int second, int palette[8] )
+{
+	palette[0] = first;
+	palette[1] = second;
+	if( first > second ) {
+		for( int i = 1; i < 7; i++ ) {
+			palette[1 + i] = ( ( 7 - i ) * first + i * second ) / 7;
+		}
+	} else {
+		for( int i = 1; i < 5; i++ ) {
+			palette[1 + i] = ( ( 5 - i ) * first + i * second ) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+void CBlockCompressor::CompressChannelBlock( const BYTE* values, int stride, BYTE* result ) const
+{
+	int blockValues[blockPixelCount];
+	int minValue = 255;
+	int maxValue = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		blockValues[i] = values[i * stride];
+		minValue = min( minValue, blockValues[i] );
+		maxValue = max( maxValue, blockValues[i] );
+	}
+	if( quality == BCQ_Fast ) {
+		writeChannelBlock( maxValue, minValue, projectChannelIndices( blockValues, maxValue, minValue ), result );
+		return;
+	}
+
+	int bestFirst = maxValue;
+	int bestSecond = minValue;
+	unsigned __int64 bestIndices;
+	int bestError = findChannelIndices( blockValues, bestFirst, bestSecond, bestIndices );
+	const int iterationCount = quality == BCQ_High ? maxRefinementCount : 1;
+	for( int i = 0; i < iterationCount && bestError > 0 && bestFirst > bestSecond; i++ ) {
+		int first;
+		int second;
+		if( !refineChannelEndpoints( blockValues, bestIndices, first, second ) ) {
+			break;
+		}
+		unsigned __int64 indices;
+		const int error = findChannelIndices( blockValues, first, second, indices );
+		if( error >= bestError ) {
+			break;
+		}
+		bestFirst = first;
+		bestSecond = second;
+		bestIndices = indices;
+		bestError = error;
+	}
+
+	if( quality == BCQ_High && bestError > 0 ) {
+		// Extreme values are exact in the six value mode, the endpoints only need to cover the rest of the block.
+		int innerMin = 255;
+		int innerMax = 0;
+		for( int i = 0; i < blockPixelCount; i++ ) {
+			if( blockValues[i] != 0 && blockValues[i] != 255 ) {
+				innerMin = min( innerMin, blockValues[i] );
+				innerMax = max( innerMax, blockValues[i] );
+			}
+		}
+		if( innerMin <= innerMax ) {
+			unsigned __int64 indices;
+			const int error = findChannelIndices( blockValues, innerMin, innerMax, indices );
+			if( error < bestError ) {
+				bestFirst = innerMin;
+				bestSecond = innerMax;
+				bestIndices = indices;
+			}
+		}
+	}
+	writeChannelBlock( bestFirst, bestSecond, bestIndices, result );
+}
+
+// Find the closest palette value for each pixel. Return the total squared error.
+int CBlockCompressor::findChannelIndices( const int* values, int first, int second, unsigned __int64& indices )
+{
+	int palette[8];
+	findChannelPalette( first, second, palette );
+	indices = 0;
+	int error = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		int bestIndex = 0;
+		int bestDistance = INT_MAX;
+		for( int index = 0; index < 8; index++ ) {
+			const int distance = ( values[i] - palette[index] ) * ( values[i] - palette[index] );
+			if( distance < bestDistance ) {
+				bestIndex = index;
+				bestDistance = distance;
+			}
+		}
+		indices |= static_cast<unsigned __int64>( bestIndex ) << ( 3 * i );
+		error += bestDistance;
+	}
+	return error;
+}
+
+// Find the eight value mode indices by projecting the values on the range between the endpoints.
+unsigned __int64 CBlockCompressor::projectChannelIndices( const int* values, int first, int second )
+{
+	const int range = first - second;
+	if( range <= 0 ) {
+		return 0;
+	}
+
+	unsigned __int64 indices = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		// Position 0 is the second endpoint, position 7 is the first one.
+		const int position = ( ( values[i] - second ) * 14 + range ) / ( 2 * range );
+		const int index = position == 7 ? 0 : ( position == 0 ? 1 : 8 - position );
+		indices |= static_cast<unsigned __int64>( index ) << ( 3 * i );
+	}
+	return indices;
+}
+
+// Find the eight value mode endpoints that minimize the squared error for the given indices. Return false if the system is degenerate.
+bool CBlockCompressor::refineChannelEndpoints( const int* values, unsigned __int64 indices, int& first, int& second )
+{
+	float firstSquared = 0;
+	float secondSquared = 0;
+	float product = 0;
+	float firstSum = 0;
+	float secondSum = 0;
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const int index = static_cast<int>( ( indices >> ( 3 * i ) ) & 7 );
+		const float firstWeight = index == 0 ? 1.0f : ( index == 1 ? 0.0f : ( 8 - index ) / 7.0f );
+		const float secondWeight = 1 - firstWeight;
+		firstSquared += firstWeight * firstWeight;
+		secondSquared += secondWeight * secondWeight;
+		product += firstWeight * secondWeight;
+		firstSum += firstWeight * values[i];
+		secondSum += secondWeight * values[i];
+	}
+
+	const float determinant = firstSquared * secondSquared - product * product;
+	if( determinant < minDeterminant ) {
+		return false;
+	}
+	first = clampChannel( Round( ( firstSum * secondSquared - secondSum * product ) / determinant ), 255 );
+	second = clampChannel( Round( ( secondSum * firstSquared - firstSum * product ) / determinant ), 255 );
+	// The eight value mode requires the first endpoint to be greater.
+	if( first < second ) {
+		const int temp = first;
+		first = second;
+		second = temp;
+	}
+	return true;
+}
+
+void CBlockCompressor::writeChannelBlock( int first, int second, unsigned __int64 indices, BYTE* result )
+{
+	result[0] = static_cast<BYTE>( first );
+	result[1] = static_cast<BYTE>( second );
+	for( int i = 0; i < 6; i++ ) {
+		result[2 + i] = static_cast<BYTE>( indices >> ( 8 * i ) );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
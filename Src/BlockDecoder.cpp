@@ -0,0 +1,263 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <BlockDecoder.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+
+// SSE2 is a part of the x64 instruction set and is enabled by /arch:SSE2 on x86.
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#define GIN_BLOCK_DECODE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Width and height of a compressed block in pixels.
+static const int blockPixelSize = 4;
+static const int blockPixelCount = blockPixelSize * blockPixelSize;
+
+void CBlockDecoder::SetWorkerCount( int newValue )
+{
+	assert( newValue > 0 );
+	workerCount = newValue;
+}
+
+bool CBlockDecoder::IsDecodingSupported( TTextureCompressionType type )
+{
+	switch( type ) {
+	case TCT_Dxt1_RGB:
+	case TCT_Dxt1_sRGB:
+	case TCT_Dxt3:
+	case TCT_Dxt3_sRGBA:
+	case TCT_Dxt5:
+	case TCT_Dxt5_sRGBA:
+	case TCT_Bc4:
+	case TCT_Bc5:
+		return true;
+	default:
+		return false;
+	}
+}
+
+CImageData CBlockDecoder::Decode( const CImageData& source ) const
+{
+	assert( IsDecodingSupported( source.GetCompressionType() ) );
+	assert( source.Depth() == 1 );
+	CImageData result( source.GetType(), source.Width(), source.Height(), 1, TF_RGBA, TDT_UnsignedByte, source.GetMipmapCount(), source.GetArrayCount() );
+	const int faceCount = source.GetCubeFaceCount();
+	for( int level = 0; level < source.GetMipmapCount(); level++ ) {
+		const int levelWidth = max( 1, source.Width() >> level );
+		const int levelHeight = max( 1, source.Height() >> level );
+		const int destImageSize = result.GetImageDataSize( level );
+		BYTE* destLevel = result.GetMipmapData( level ).Ptr();
+		for( int arrayIndex = 0; arrayIndex < source.GetArrayCount(); arrayIndex++ ) {
+			for( int cubeFace = 0; cubeFace < faceCount; cubeFace++ ) {
+				BYTE* destImage = destLevel + ( arrayIndex * faceCount + cubeFace ) * destImageSize;
+				decodeImage( source.GetCompressionType(), source.GetImageData( level, arrayIndex, cubeFace ), levelWidth, levelHeight, destImage );
+			}
+		}
+	}
+	return result;
+}
+
+void CBlockDecoder::DecodeImage( const CImageData& source, int mipmapLevel, int arrayIndex, int cubeFace, BYTE* result ) const
+{
+	assert( IsDecodingSupported( source.GetCompressionType() ) );
+	assert( source.Depth() == 1 );
+	const int levelWidth = max( 1, source.Width() >> mipmapLevel );
+	const int levelHeight = max( 1, source.Height() >> mipmapLevel );
+	decodeImage( source.GetCompressionType(), source.GetImageData( mipmapLevel, arrayIndex, cubeFace ), levelWidth, levelHeight, result );
+}
+
+// Byte size of a DXT1 and BC4 block.
+static const int smallBlockSize = 8;
+// Byte size of a DXT3, DXT5 and BC5 block.
+static const int bigBlockSize = 16;
+int CBlockDecoder::getBlockSize( TTextureCompressionType type )
+{
+	return ( type == TCT_Dxt1_RGB || type == TCT_Dxt1_sRGB || type == TCT_Bc4 ) ? smallBlockSize : bigBlockSize;
+}
+
+// Number of block rows decoded by a single task.
+static const int decodingTaskBlockRowCount = 8;
+void CBlockDecoder::decodeImage( TTextureCompressionType type, const BYTE* blocks, int width, int height, BYTE* result ) const
+{
+	const int blockSize = getBlockSize( type );
+	const int blockColumnCount = Ceil( width, blockPixelSize );
+	const int blockRowCount = Ceil( height, blockPixelSize );
+	auto decodeBand = [&]( int, int taskIndex ) {
+		const int firstRow = taskIndex * decodingTaskBlockRowCount;
+		const int rowEnd = min( blockRowCount, firstRow + decodingTaskBlockRowCount );
+		BYTE blockPixels[blockPixelCount * 4];
+		for( int blockY = firstRow; blockY < rowEnd; blockY++ ) {
+			const BYTE* srcRow = blocks + blockY * blockColumnCount * blockSize;
+			const int pixelRowCount = min( blockPixelSize, height - blockY * blockPixelSize );
+			for( int blockX = 0; blockX < blockColumnCount; blockX++ ) {
+				DecodeBlock( type, srcRow + blockX * blockSize, blockPixels );
+				// Edge blocks are clipped by the image size.
+				const int pixelColumnCount = min( blockPixelSize, width - blockX * blockPixelSize );
+				for( int y = 0; y < pixelRowCount; y++ ) {
+					BYTE* destPixel = result + ( ( blockY * blockPixelSize + y ) * width + blockX * blockPixelSize ) * 4;
+					memcpy( destPixel, blockPixels + y * blockPixelSize * 4, pixelColumnCount * 4 );
+				}
+			}
+		}
+	};
+	ParallelFor( Ceil( blockRowCount, decodingTaskBlockRowCount ), workerCount, decodeBand );
+}
+
+void CBlockDecoder::DecodeBlock( TTextureCompressionType type, const BYTE* block, BYTE* rgbaPixels )
+{
+	switch( type ) {
+	case TCT_Dxt1_RGB:
+	case TCT_Dxt1_sRGB:
+		decodeColorBlock( block, true, rgbaPixels );
+		break;
+	case TCT_Dxt3:
+	case TCT_Dxt3_sRGBA:
+		decodeColorBlock( block + smallBlockSize, false, rgbaPixels );
+		decodeExplicitAlphaBlock( block, rgbaPixels + 3, 4 );
+		break;
+	case TCT_Dxt5:
+	case TCT_Dxt5_sRGBA:
+		decodeColorBlock( block + smallBlockSize, false, rgbaPixels );
+		decodeChannelBlock( block, rgbaPixels + 3, 4 );
+		break;
+	case TCT_Bc4:
+	case TCT_Bc5:
+		for( int i = 0; i < blockPixelCount; i++ ) {
+			rgbaPixels[i * 4 + 1] = 0;
+			rgbaPixels[i * 4 + 2] = 0;
+			rgbaPixels[i * 4 + 3] = 255;
+		}
+		decodeChannelBlock( block, rgbaPixels, 4 );
+		if( type == TCT_Bc5 ) {
+			decodeChannelBlock( block + smallBlockSize, rgbaPixels + 1, 4 );
+		}
+		break;
+	default:
+		assert( false );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Convert a 5:6:5 color to 8 bits per channel.
+static void expandColor( int color, int* result )
+{
+	const int r = ( color >> 11 ) & 31;
+	const int g = ( color >> 5 ) & 63;
+	const int b = color & 31;
+	result[0] = ( r << 3 ) | ( r >> 2 );
+	result[1] = ( g << 2 ) | ( g >> 4 );
+	result[2] = ( b << 3 ) | ( b >> 2 );
+}
+
+// Opaque RGBA8 colors of the four indices, red is in the lowest byte.
+// Three color mode is used in DXT1 blocks with the first endpoint not greater than the second, the last color is black.
+static void findColorPalette( const BYTE* block, bool allowThreeColorMode, unsigned* palette )
+{
+	const int first = block[0] | ( block[1] << 8 );
+	const int second = block[2] | ( block[3] << 8 );
+	const bool isThreeColorMode = allowThreeColorMode && first <= second;
+	int colors[4][3];
+	expandColor( first, colors[0] );
+	expandColor( second, colors[1] );
+	for( int i = 0; i < 3; i++ ) {
+		if( isThreeColorMode ) {
+			colors[2][i] = ( colors[0][i] + colors[1][i] ) / 2;
+			colors[3][i] = 0;
+		} else {
+			colors[2][i] = ( 2 * colors[0][i] + colors[1][i] ) / 3;
+			colors[3][i] = ( colors[0][i] + 2 * colors[1][i] ) / 3;
+		}
+	}
+	for( int i = 0; i < 4; i++ ) {
+		palette[i] = colors[i][0] | ( colors[i][1] << 8 ) | ( colors[i][2] << 16 ) | 0xFF000000;
+	}
+}
+
+#ifdef GIN_BLOCK_DECODE_SSE2
+
+void CBlockDecoder::decodeColorBlock( const BYTE* block, bool allowThreeColorMode, BYTE* rgbaPixels )
+{
+	unsigned palette[4];
+	findColorPalette( block, allowThreeColorMode, palette );
+	// Each pixel of a row occupies a lane. A lane selects the palette colors whose index matches its 2-bit field of the row byte.
+	const __m128i fieldMask = _mm_set_epi32( 0xC0, 0x30, 0x0C, 0x03 );
+	__m128i colors[4];
+	__m128i fieldValues[4];
+	for( int i = 0; i < 4; i++ ) {
+		colors[i] = _mm_set1_epi32( static_cast<int>( palette[i] ) );
+		fieldValues[i] = _mm_set_epi32( i << 6, i << 4, i << 2, i );
+	}
+	for( int y = 0; y < blockPixelSize; y++ ) {
+		const __m128i fields = _mm_and_si128( _mm_set1_epi32( block[4 + y] ), fieldMask );
+		__m128i row = _mm_setzero_si128();
+		for( int i = 0; i < 4; i++ ) {
+			row = _mm_or_si128( row, _mm_and_si128( _mm_cmpeq_epi32( fields, fieldValues[i] ), colors[i] ) );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( rgbaPixels + y * blockPixelSize * 4 ), row );
+	}
+}
+
+#else
+
+void CBlockDecoder::decodeColorBlock( const BYTE* block, bool allowThreeColorMode, BYTE* rgbaPixels )
+{
+	unsigned palette[4];
+	findColorPalette( block, allowThreeColorMode, palette );
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const unsigned color = palette[( block[4 + i / blockPixelSize] >> ( 2 * ( i % blockPixelSize ) ) ) & 3];
+		rgbaPixels[i * 4] = static_cast<BYTE>( color );
+		rgbaPixels[i * 4 + 1] = static_cast<BYTE>( color >> 8 );
+		rgbaPixels[i * 4 + 2] = static_cast<BYTE>( color >> 16 );
+		rgbaPixels[i * 4 + 3] = static_cast<BYTE>( color >> 24 );
+	}
+}
+
+#endif
+
+void CBlockDecoder::decodeExplicitAlphaBlock( const BYTE* block, BYTE* values, int stride )
+{
+	// Each pixel has a 4-bit alpha value.
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		const int alpha = ( block[i / 2] >> ( 4 * ( i % 2 ) ) ) & 0xF;
+		values[i * stride] = static_cast<BYTE>( alpha * 17 );
+	}
+}
+
+void CBlockDecoder::decodeChannelBlock( const BYTE* block, BYTE* values, int stride )
+{
+	// Six values are interpolated if the first endpoint is greater. Otherwise four values are interpolated and the last two are 0 and 255.
+	const int first = block[0];
+	const int second = block[1];
+	int palette[8] = { first, second };
+	if( first > second ) {
+		for( int i = 1; i < 7; i++ ) {
+			palette[1 + i] = ( ( 7 - i ) * first + i * second ) / 7;
+		}
+	} else {
+		for( int i = 1; i < 5; i++ ) {
+			palette[1 + i] = ( ( 5 - i ) * first + i * second ) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	unsigned __int64 indices = 0;
+	for( int i = 0; i < 6; i++ ) {
+		indices |= static_cast<unsigned __int64>( block[2 + i] ) << ( 8 * i );
+	}
+	for( int i = 0; i < blockPixelCount; i++ ) {
+		values[i * stride] = static_cast<BYTE>( palette[( indices >> ( 3 * i ) ) & 7] );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -3,6 +3,7 @@
 
 #include <DdsImage.h>
 #include <ImageData.h>
+#include <FileMapping.h>
 
 namespace Gin {
 
@@ -17,6 +18,10 @@ static const DDS::CDXGIToBitMaskEntry bitMaskToDXGIConversionTable[] {
 	{ DDS::DXGIF_BC1_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_DXT1 },
 	{ DDS::DXGIF_BC2_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_DXT3 },
 	{ DDS::DXGIF_BC3_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_DXT5 },
+	{ DDS::DXGIF_BC4_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_ATI1 },
+	{ DDS::DXGIF_BC4_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_BC4U },
+	{ DDS::DXGIF_BC5_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_ATI2 },
+	{ DDS::DXGIF_BC5_UNORM, DDS::DPFF_FourCC, 0, 0, 0, 0, 0, DDS::DCF_BC5U },
 	// Less common formats.
 	{ DDS::DXGIF_R16G16_UNORM, DDS::DPFF_RGB | DDS::DPFF_AlphaPixels, 32, 0xffff, 0xffff0000, 0, 0, 0 },
 	{ DDS::DXGIF_R10G10B10A2_UNORM, DDS::DPFF_RGB | DDS::DPFF_AlphaPixels, 32, 0x3ff, 0xffc00, 0x3ff00000, 0, 0 },
@@ -59,22 +64,37 @@ static const int minDdsFileSize = sizeof( DWORD ) + sizeof( DDS::CDdsHeader );
 CImageData CDdsImage::CreateImageData( bool topLeftOrigin )
 {
 	CArray<BYTE> data = readFileBuffer();
-	parseMagicNumber( data );
-	DDS::CDdsHeader header;
-	parseDdsHeader( data, header );
-	DDS::CDxt10Header dxtHeader;
-	int filePos = minDdsFileSize;
-	getOrCreateDxtHeader( data, filePos, header, dxtHeader );
-	return parseTextureData( data, filePos, header, dxtHeader, topLeftOrigin );
+	CImageParameters params;
+	const int filePos = parseHeaders( data, params );
+	return parseTextureData( data, filePos, params, topLeftOrigin );
+}
+
+extern const CError Err_NonContiguousMappedLevels;
+CImageData CDdsImage::CreateMappedImageData()
+{
+	auto mapping = CreateOwner<CFileMapping>( textureFileName );
+	const auto data = mapping->GetData();
+	checkFileSize( data.Size() );
+	CImageParameters params;
+	const int filePos = parseHeaders( data, params );
+	// The file stores all the levels of an image before the next image, so the images of a level are adjacent only without other levels.
+	// Level uploads of arrays and cubemaps read the whole level at once.
+	const int imageCount = ( params.Type == TT_TextureCubeMap ? 6 : 1 ) * params.ArrayCount;
+	check( imageCount == 1 || params.MipmapCount == 1, Err_NonContiguousMappedLevels, GetName() );
+	try {
+		return CImageData( params.Type, params.Width, params.Height, params.Depth, params.Format, params.DataType, params.CompressionType,
+			params.MipmapCount, params.ArrayCount, move( mapping ), filePos );
+	} catch( CCheckException& e ) {
+		e.SetFirstParam( GetName() );
+		throw;
+	}
 }
 
 CArray<BYTE> CDdsImage::readFileBuffer()
 {
 	CFileReader textureFile( textureFileName, FCM_OpenExisting );
 	const int length = textureFile.GetLength32();
-	if( length < minDdsFileSize ) {
-		throwDdsException( "File size is too small to support DDS format" );
-	}
+	checkFileSize( length );
 
 	CArray<BYTE> buffer;
 	buffer.IncreaseSizeNoInitialize( length );
@@ -82,9 +102,29 @@ CArray<BYTE> CDdsImage::readFileBuffer()
 	return move( buffer );
 }
 
+void CDdsImage::checkFileSize( int fileSize )
+{
+	if( fileSize < minDdsFileSize ) {
+		throwDdsException( "File size is too small to support DDS format" );
+	}
+}
+
+// Parse all the headers and get the image parameters. Return the position of the image data.
+int CDdsImage::parseHeaders( CArrayView<BYTE> data, CImageParameters& result )
+{
+	parseMagicNumber( data );
+	DDS::CDdsHeader header;
+	parseDdsHeader( data, header );
+	DDS::CDxt10Header dxtHeader;
+	int filePos = minDdsFileSize;
+	getOrCreateDxtHeader( data, filePos, header, dxtHeader );
+	getImageParameters( header, dxtHeader, result );
+	return filePos;
+}
+
 static const DWORD ddsMagicNumber = 0x20534444;
 // Check the presence of a DDS magic at the start of the file.
-void CDdsImage::parseMagicNumber( CArray<BYTE>& data )
+void CDdsImage::parseMagicNumber( CArrayView<BYTE> data )
 {
 	DWORD fileStart;
 	memcpy( &fileStart, data.Ptr(), sizeof( fileStart ) );
@@ -99,7 +139,7 @@ void CDdsImage::throwDdsException( CStringView reason ) const
 }
 
 // Fill the CDdsHeader structure.
-void CDdsImage::parseDdsHeader( CArray<BYTE>& data, DDS::CDdsHeader& result )
+void CDdsImage::parseDdsHeader( CArrayView<BYTE> data, DDS::CDdsHeader& result )
 {
 	memcpy( &result, data.Ptr() + sizeof( ddsMagicNumber ), sizeof( result ) );
 }
@@ -111,7 +151,7 @@ bool CDdsImage::hasDxtHeader( const DDS::CDdsHeader& header )
 }
 
 // Fill the CDxt10Header structure.
-void CDdsImage::getOrCreateDxtHeader( CArray<BYTE>& data, int& pos, const DDS::CDdsHeader& header, DDS::CDxt10Header& result )
+void CDdsImage::getOrCreateDxtHeader( CArrayView<BYTE> data, int& pos, const DDS::CDdsHeader& header, DDS::CDxt10Header& result )
 {
 	if( hasDxtHeader( header ) ) {
 		// Read an existing DX10 header.
@@ -153,35 +193,33 @@ void CDdsImage::createDxtHeader( const DDS::CDdsHeader& header, DDS::CDxt10Heade
 	result.MiscFlags2 = 0;	
 }
 
+// Get the image dimensions, counts and texel parameters.
+void CDdsImage::getImageParameters( const DDS::CDdsHeader& header, const DDS::CDxt10Header& dxtHeader, CImageParameters& result ) const
+{
+	getTextureParameters( header, dxtHeader, result.Type, result.Width, result.Height, result.Depth );
+	result.MipmapCount = HasFlag( header.Flags, DDS::DHF_MimmapCount ) ? header.MipMapCount : 1;
+	result.ArrayCount = dxtHeader.ArraySize;
+	getTexelParameters( header, dxtHeader, result.CompressionType, result.Format, result.DataType );
+}
+
+extern const CError Err_TruncatedImageData;
 // Create the CTextureData structure.
-CImageData CDdsImage::parseTextureData( CArray<BYTE>& data, int pos, const DDS::CDdsHeader& header, const DDS::CDxt10Header& dxtHeader, bool shouldFlip )
+CImageData CDdsImage::parseTextureData( CArrayView<BYTE> data, int pos, const CImageParameters& params, bool shouldFlip )
 {
-	// Get dimensions.
-	int width, height, depth;
-	TTextureType textureType;
-	getTextureParameters( header, dxtHeader, textureType, width, height, depth );
-
-	// Get texture count.
-	const int mipmapCount = HasFlag( header.Flags, DDS::DHF_MimmapCount ) ? header.MipMapCount : 1;
-	const int arrayCount = dxtHeader.ArraySize;
-	const int cubeFaceCount = textureType == TT_TextureCubeMap ? 6 : 1;
-
-	// Get texel parameters.
-	TTextureCompressionType compressionType;
-	TTexelFormat format;
-	TTexelDataType dataType;
-	getTexelParameters( header, dxtHeader, compressionType, format, dataType );
+	const int cubeFaceCount = params.Type == TT_TextureCubeMap ? 6 : 1;
 
 	// Create the texture data.
-	CImageData result = createTextureData( textureType, width, height, depth, compressionType, format, dataType, mipmapCount, arrayCount );
+	CImageData result = createTextureData( params.Type, params.Width, params.Height, params.Depth, params.CompressionType, params.Format, params.DataType,
+		params.MipmapCount, params.ArrayCount );
 
 	// Fill in the data.
 	try {
-		for( int arrayPos = 0; arrayPos < arrayCount; arrayPos++ ) {
+		for( int arrayPos = 0; arrayPos < params.ArrayCount; arrayPos++ ) {
 			for( int facePos = 0; facePos < cubeFaceCount; facePos++ ) {
-				for( int mipmapPos = 0; mipmapPos < mipmapCount; mipmapPos++ ) {
-					result.SetImageData( mipmapPos, arrayPos, facePos, data.Ptr() + pos, shouldFlip );
+				for( int mipmapPos = 0; mipmapPos < params.MipmapCount; mipmapPos++ ) {
 					const int dataSize = result.GetImageDataSize( mipmapPos );
+					check( dataSize <= data.Size() - pos, Err_TruncatedImageData, GetName() );
+					result.SetImageData( mipmapPos, arrayPos, facePos, data.Ptr() + pos, shouldFlip );
 					pos += dataSize;
 				}
 			}
@@ -286,6 +324,12 @@ void CDdsImage::getDxtTexelParameters( DDS::TDXGIFormat dxgiFormat, TTextureComp
 	case DDS::DXGIF_BC3_UNORM_SRGB:
 		setTexelParameters( compressionType, format, dataType, TCT_Dxt5_sRGBA, TF_Compressed, TDT_Compressed );
 		break;
+	case DDS::DXGIF_BC4_UNORM:
+		setTexelParameters( compressionType, format, dataType, TCT_Bc4, TF_Compressed, TDT_Compressed );
+		break;
+	case DDS::DXGIF_BC5_UNORM:
+		setTexelParameters( compressionType, format, dataType, TCT_Bc5, TF_Compressed, TDT_Compressed );
+		break;
 	default:
 		throwDdsException( "Unsupported DXGI format." );
 		break;
@@ -463,6 +507,10 @@ DDS::TDXGIFormat CDdsImage::getDxgiFormatFromCompressionType( TTextureCompressio
 			return DDS::DXGIF_BC2_UNORM_SRGB;
 		case TCT_Dxt5_sRGBA:
 			return DDS::DXGIF_BC3_UNORM_SRGB;
+		case TCT_Bc4:
+			return DDS::DXGIF_BC4_UNORM;
+		case TCT_Bc5:
+			return DDS::DXGIF_BC5_UNORM;
 		default:
 			assert( false );
 	}
@@ -0,0 +1,131 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <DistanceField.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CVector2<int> CDistanceFieldGenerator::GetFieldSize( CVector2<int> bitmapSize, int spread )
+{
+	assert( spread > 0 );
+	return CVector2<int>( bitmapSize.X() + 2 * spread, bitmapSize.Y() + 2 * spread );
+}
+
+void CDistanceFieldGenerator::Generate( const BYTE* bitmap, CVector2<int> bitmapSize, int pitch, int spread, CArrayBuffer<BYTE> result )
+{
+	assert( pitch >= bitmapSize.X() );
+	const auto fieldSize = GetFieldSize( bitmapSize, spread );
+	const auto fieldArea = fieldSize.X() * fieldSize.Y();
+	assert( result.Size() >= fieldArea );
+
+	initializeGrids( bitmap, bitmapSize, pitch, spread, fieldSize );
+	transformGrid( outerGrid, fieldSize );
+	transformGrid( innerGrid, fieldSize );
+
+	const float valueScale = 127.5f / spread;
+	for( int i = 0; i < fieldArea; i++ ) {
+		const auto distance = sqrtf( innerGrid[i] ) - sqrtf( outerGrid[i] );
+		const auto value = 127.5f + distance * valueScale;
+		result[i] = static_cast<BYTE>( min( 255.0f, max( 0.0f, value + 0.5f ) ) );
+	}
+}
+
+// Squared distance that is greater than any distance in a bitmap.
+static const float infiniteDistance = 1e20f;
+void CDistanceFieldGenerator::initializeGrids( const BYTE* bitmap, CVector2<int> bitmapSize, int pitch, int spread, CVector2<int> fieldSize )
+{
+	const auto fieldArea = fieldSize.X() * fieldSize.Y();
+	outerGrid.Empty();
+	outerGrid.IncreaseSize( fieldArea );
+	innerGrid.Empty();
+	innerGrid.IncreaseSize( fieldArea );
+	// The border is outside the shape.
+	for( int i = 0; i < fieldArea; i++ ) {
+		outerGrid[i] = infiniteDistance;
+		innerGrid[i] = 0.0f;
+	}
+
+	for( int y = 0; y < bitmapSize.Y(); y++ ) {
+		const BYTE* bitmapRow = bitmap + y * pitch;
+		const auto fieldRowPos = ( y + spread ) * fieldSize.X() + spread;
+		for( int x = 0; x < bitmapSize.X(); x++ ) {
+			const auto coverage = bitmapRow[x];
+			if( coverage == 0 ) {
+				continue;
+			}
+			const auto pos = fieldRowPos + x;
+			if( coverage == 255 ) {
+				outerGrid[pos] = 0.0f;
+				innerGrid[pos] = infiniteDistance;
+				continue;
+			}
+			// Partially covered pixel. The outline is assumed to pass at the distance proportional to the coverage.
+			const auto edgeDistance = 0.5f - coverage / 255.0f;
+			outerGrid[pos] = edgeDistance > 0 ? edgeDistance * edgeDistance : 0.0f;
+			innerGrid[pos] = edgeDistance < 0 ? edgeDistance * edgeDistance : 0.0f;
+		}
+	}
+}
+
+// Exact Euclidean distance transform: the one-dimensional transform is applied to each column and then to each row.
+void CDistanceFieldGenerator::transformGrid( CArray<float>& grid, CVector2<int> size )
+{
+	const auto maxLength = max( size.X(), size.Y() );
+	sampleValues.Empty();
+	sampleValues.IncreaseSize( maxLength );
+	envelopeRoots.Empty();
+	envelopeRoots.IncreaseSize( maxLength );
+	envelopeBounds.Empty();
+	envelopeBounds.IncreaseSize( maxLength + 1 );
+
+	for( int x = 0; x < size.X(); x++ ) {
+		transformLine( grid.Ptr() + x, size.Y(), size.X() );
+	}
+	for( int y = 0; y < size.Y(); y++ ) {
+		transformLine( grid.Ptr() + y * size.X(), size.X(), 1 );
+	}
+}
+
+// Squared distance transform of a sampled function. The lower envelope of parabolas rooted at each sample is computed in linear time.
+void CDistanceFieldGenerator::transformLine( float* line, int length, int stride )
+{
+	for( int i = 0; i < length; i++ ) {
+		sampleValues[i] = line[i * stride];
+	}
+
+	int envelopeSize = 0;
+	envelopeRoots[0] = 0;
+	envelopeBounds[0] = -infiniteDistance;
+	envelopeBounds[1] = infiniteDistance;
+	for( int q = 1; q < length; q++ ) {
+		float intersection;
+		for( ;; ) {
+			const auto r = envelopeRoots[envelopeSize];
+			intersection = ( sampleValues[q] + q * q - sampleValues[r] - r * r ) / ( 2.0f * ( q - r ) );
+			if( intersection > envelopeBounds[envelopeSize] || envelopeSize == 0 ) {
+				break;
+			}
+			envelopeSize--;
+		}
+		envelopeSize++;
+		envelopeRoots[envelopeSize] = q;
+		envelopeBounds[envelopeSize] = intersection;
+		envelopeBounds[envelopeSize + 1] = infiniteDistance;
+	}
+
+	int parabolaPos = 0;
+	for( int q = 0; q < length; q++ ) {
+		while( envelopeBounds[parabolaPos + 1] < q ) {
+			parabolaPos++;
+		}
+		const auto r = envelopeRoots[parabolaPos];
+		line[q * stride] = sampleValues[r] + ( q - r ) * ( q - r );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,77 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <DistanceFieldGlyphProvider.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CDistanceFieldGlyphProvider::CDistanceFieldGlyphProvider( CPtrOwner<IGlyphProvider> _sourceProvider, int _spread ) :
+	sourceProvider( move( _sourceProvider ) ),
+	spread( _spread )
+{
+	assert( sourceProvider != nullptr );
+	assert( spread > 0 );
+}
+
+CPtrOwner<IGlyph> CDistanceFieldGlyphProvider::GetGlyph( int utf32 ) const
+{
+	const auto sourceGlyph = sourceProvider->GetGlyph( utf32 );
+	const auto sourceData = sourceGlyph->GetGlyphData();
+	const auto sizeData = getFieldSizeData( sourceData.SizeData, spread );
+	CArray<BYTE> field;
+	field.IncreaseSize( sizeData.Size.X() * sizeData.Size.Y() );
+	if( !field.IsEmpty() ) {
+		generator.Generate( sourceData.BitmapData, sourceData.SizeData.Size, sourceData.SizeData.Pitch, spread, field );
+	}
+	return CreateOwner<CDistanceFieldGlyph>( sizeData, move( field ) );
+}
+
+void CDistanceFieldGlyphProvider::GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const
+{
+	sourceBatch.Empty();
+	sourceProvider->GetGlyphs( utf32Codes, sourceBatch );
+	for( int i = 0; i < sourceBatch.Size(); i++ ) {
+		const auto sourceData = sourceBatch.GetGlyphData( i );
+		const auto field = result.AddGlyphBitmap( getFieldSizeData( sourceData.SizeData, spread ) );
+		if( field.Size() > 0 ) {
+			generator.Generate( sourceData.BitmapData, sourceData.SizeData.Size, sourceData.SizeData.Pitch, spread, field );
+		}
+	}
+}
+
+// Metrics of the distance field glyph.
+CGlyphSizeData CDistanceFieldGlyphProvider::getFieldSizeData( CGlyphSizeData sourceData, int fieldSpread )
+{
+	auto result = sourceData;
+	if( sourceData.Size.X() == 0 || sourceData.Size.Y() == 0 ) {
+		// Nothing to draw, only the metrics are needed.
+		result.Size = CVector2<int>{};
+		result.Pitch = 0;
+		return result;
+	}
+
+	// Negative pitch is not supported, same as in the font renderer.
+	assert( sourceData.Pitch >= 0 );
+	// Offset points to the top left corner and Y goes up.
+	result.Offset.X() -= fieldSpread;
+	result.Offset.Y() += fieldSpread;
+	result.Size = CDistanceFieldGenerator::GetFieldSize( sourceData.Size, fieldSpread );
+	result.Pitch = result.Size.X();
+	return result;
+}
+
+CPtrOwner<IGlyphProvider> CDistanceFieldGlyphProvider::CreateWorkerCopy() const
+{
+	auto sourceCopy = sourceProvider->CreateWorkerCopy();
+	if( sourceCopy == nullptr ) {
+		return CPtrOwner<IGlyphProvider>();
+	}
+	return CreateOwner<CDistanceFieldGlyphProvider>( move( sourceCopy ), spread );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,272 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <DxtBlockFlip.h>
+
+// SSE2 is a part of the x64 instruction set and is enabled by /arch:SSE2 on x86.
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#define GIN_DXT_FLIP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Gin {
+
+namespace GinInternal {
+
+//////////////////////////////////////////////////////////////////////////
+
+static void flipDxt1Block( BYTE* dest, const BYTE* src )
+{
+	// First four bytes contain color information.
+	// Next four bytes contain 4x4 pixel block information, flip them.
+	// Each pixel is represented as 2 bits, copy every byte in reverse order.
+	const BYTE flipped[8] = { src[0], src[1], src[2], src[3], src[7], src[6], src[5], src[4] };
+	memcpy( dest, flipped, sizeof( flipped ) );
+}
+
+static void flipDxt3Block( BYTE* dest, const BYTE* src )
+{
+	// First eight bytes contain 4x4 pixel block data, flip them.
+	// Each pixel is represented as 4 bits, copy every two bytes in reverse order.
+	const BYTE flipped[8] = { src[6], src[7], src[4], src[5], src[2], src[3], src[0], src[1] };
+	// Next eight bytes are DXT1 compressed.
+	flipDxt1Block( dest + 8, src + 8 );
+	memcpy( dest, flipped, sizeof( flipped ) );
+}
+
+static void flipCompressedAlphaBlock( BYTE* dest, const BYTE* src )
+{
+	// First two bytes contain alpha values.
+	// Next six bytes contain four rows of 3-bit indices, 12 bits per row. Reverse the row order.
+	// See compression description for the logic behind the flipping:
+	// http://www.opengl.org/registry/specs/EXT/texture_compression_s3tc.txt
+	unsigned __int64 block;
+	memcpy( &block, src, sizeof( block ) );
+	const unsigned __int64 rowMask = 0xFFF;
+	const unsigned __int64 flipped = ( block & 0xFFFF )
+		| ( ( ( block >> 52 ) & rowMask ) << 16 )
+		| ( ( ( block >> 40 ) & rowMask ) << 28 )
+		| ( ( ( block >> 28 ) & rowMask ) << 40 )
+		| ( ( ( block >> 16 ) & rowMask ) << 52 );
+	memcpy( dest, &flipped, sizeof( flipped ) );
+}
+
+static void flipDxt5Block( BYTE* dest, const BYTE* src )
+{
+	// First eight bytes are alpha compressed.
+	flipCompressedAlphaBlock( dest, src );
+	// Next eight bytes are DXT1 compressed.
+	flipDxt1Block( dest + 8, src + 8 );
+}
+
+static void flipBc5Block( BYTE* dest, const BYTE* src )
+{
+	// Both channels are compressed like DXT5 alpha.
+	flipCompressedAlphaBlock( dest, src );
+	flipCompressedAlphaBlock( dest + 8, src + 8 );
+}
+
+#ifdef GIN_DXT_FLIP_SSE2
+
+// Swap the bytes of each 16-bit word.
+static __m128i swapWordBytes( __m128i value )
+{
+	return _mm_or_si128( _mm_slli_epi16( value, 8 ), _mm_srli_epi16( value, 8 ) );
+}
+
+// Flip two DXT1 blocks.
+static __m128i flipDxt1Register( __m128i blocks )
+{
+	// Index bytes are reversed by swapping the bytes in words and then swapping the last two words of each block.
+	const __m128i swappedBytes = swapWordBytes( blocks );
+	const __m128i flippedIndices = _mm_shufflehi_epi16( _mm_shufflelo_epi16( swappedBytes, _MM_SHUFFLE( 2, 3, 1, 0 ) ), _MM_SHUFFLE( 2, 3, 1, 0 ) );
+	const __m128i colorMask = _mm_set_epi32( 0, -1, 0, -1 );
+	return _mm_or_si128( _mm_and_si128( colorMask, blocks ), _mm_andnot_si128( colorMask, flippedIndices ) );
+}
+
+// Flip the color part of a 16-byte block that occupies the upper half of the register.
+static __m128i flipHighColorBlock( __m128i block )
+{
+	return _mm_shufflehi_epi16( swapWordBytes( block ), _MM_SHUFFLE( 2, 3, 1, 0 ) );
+}
+
+// Flip a single DXT3 block.
+static __m128i flipDxt3Register( __m128i block )
+{
+	// Alpha rows are 16-bit words, their order is reversed.
+	const __m128i flippedAlpha = _mm_shufflelo_epi16( block, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+	const __m128i flippedColor = flipHighColorBlock( block );
+	const __m128i alphaMask = _mm_set_epi32( 0, 0, -1, -1 );
+	const __m128i colorMask = _mm_set_epi32( 0, -1, 0, 0 );
+	const __m128i indexMask = _mm_set_epi32( -1, 0, 0, 0 );
+	return _mm_or_si128( _mm_or_si128( _mm_and_si128( alphaMask, flippedAlpha ), _mm_and_si128( colorMask, block ) ),
+		_mm_and_si128( indexMask, flippedColor ) );
+}
+
+// Flip the interpolated alpha blocks in both halves of the register.
+static __m128i flipAlphaRegister( __m128i blocks )
+{
+	// Alpha rows are 12-bit fields that start from bit 16. Each row is shifted to its mirrored position.
+	const __m128i endpointMask = _mm_set_epi32( 0, 0x0000FFFF, 0, 0x0000FFFF );
+	const __m128i row0Mask = _mm_set_epi32( 0, 0x0FFF0000, 0, 0x0FFF0000 );
+	const __m128i row1Mask = _mm_set_epi32( 0x000000FF, static_cast<int>( 0xF0000000 ), 0x000000FF, static_cast<int>( 0xF0000000 ) );
+	const __m128i row2Mask = _mm_set_epi32( 0x000FFF00, 0, 0x000FFF00, 0 );
+	const __m128i row3Mask = _mm_set_epi32( static_cast<int>( 0xFFF00000 ), 0, static_cast<int>( 0xFFF00000 ), 0 );
+	const __m128i row0 = _mm_and_si128( row3Mask, _mm_slli_epi64( blocks, 36 ) );
+	const __m128i row1 = _mm_and_si128( row2Mask, _mm_slli_epi64( blocks, 12 ) );
+	const __m128i row2 = _mm_and_si128( row1Mask, _mm_srli_epi64( blocks, 12 ) );
+	const __m128i row3 = _mm_and_si128( row0Mask, _mm_srli_epi64( blocks, 36 ) );
+	return _mm_or_si128( _mm_or_si128( _mm_and_si128( endpointMask, blocks ), row0 ), _mm_or_si128( _mm_or_si128( row1, row2 ), row3 ) );
+}
+
+// Flip a single DXT5 block.
+static __m128i flipDxt5Register( __m128i block )
+{
+	const __m128i flippedAlpha = flipAlphaRegister( block );
+	const __m128i flippedColor = flipHighColorBlock( block );
+	const __m128i alphaMask = _mm_set_epi32( 0, 0, -1, -1 );
+	const __m128i colorMask = _mm_set_epi32( 0, -1, 0, 0 );
+	const __m128i indexMask = _mm_set_epi32( -1, 0, 0, 0 );
+	return _mm_or_si128( _mm_or_si128( _mm_and_si128( alphaMask, flippedAlpha ), _mm_and_si128( colorMask, block ) ),
+		_mm_and_si128( indexMask, flippedColor ) );
+}
+
+// Number of bytes in a single register.
+static const int flipRegisterSize = sizeof( __m128i );
+
+template <class RegisterFlip>
+static int flipRegisters( BYTE* dest, const BYTE* src, int byteCount, RegisterFlip flipRegister )
+{
+	const int registerByteCount = byteCount - byteCount % flipRegisterSize;
+	for( int pos = 0; pos < registerByteCount; pos += flipRegisterSize ) {
+		const __m128i blocks = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + pos ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dest + pos ), flipRegister( blocks ) );
+	}
+	return registerByteCount;
+}
+
+template <class RegisterFlip>
+static int swapFlipRegisters( BYTE* first, BYTE* second, int byteCount, RegisterFlip flipRegister )
+{
+	const int registerByteCount = byteCount - byteCount % flipRegisterSize;
+	for( int pos = 0; pos < registerByteCount; pos += flipRegisterSize ) {
+		const __m128i firstBlocks = _mm_loadu_si128( reinterpret_cast<const __m128i*>( first + pos ) );
+		const __m128i secondBlocks = _mm_loadu_si128( reinterpret_cast<const __m128i*>( second + pos ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( first + pos ), flipRegister( secondBlocks ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( second + pos ), flipRegister( firstBlocks ) );
+	}
+	return registerByteCount;
+}
+
+static int flipBlockRegisters( TDxtBlockType type, BYTE* dest, const BYTE* src, int byteCount )
+{
+	switch( type ) {
+	case DBT_Dxt1:
+		return flipRegisters( dest, src, byteCount, flipDxt1Register );
+	case DBT_Dxt3:
+		return flipRegisters( dest, src, byteCount, flipDxt3Register );
+	case DBT_Dxt5:
+		return flipRegisters( dest, src, byteCount, flipDxt5Register );
+	case DBT_Bc4:
+	case DBT_Bc5:
+		return flipRegisters( dest, src, byteCount, flipAlphaRegister );
+	default:
+		assert( false );
+		return 0;
+	}
+}
+
+static int swapFlipBlockRegisters( TDxtBlockType type, BYTE* first, BYTE* second, int byteCount )
+{
+	switch( type ) {
+	case DBT_Dxt1:
+		return swapFlipRegisters( first, second, byteCount, flipDxt1Register );
+	case DBT_Dxt3:
+		return swapFlipRegisters( first, second, byteCount, flipDxt3Register );
+	case DBT_Dxt5:
+		return swapFlipRegisters( first, second, byteCount, flipDxt5Register );
+	case DBT_Bc4:
+	case DBT_Bc5:
+		return swapFlipRegisters( first, second, byteCount, flipAlphaRegister );
+	default:
+		assert( false );
+		return 0;
+	}
+}
+
+#else
+
+static int flipBlockRegisters( TDxtBlockType, BYTE*, const BYTE*, int )
+{
+	return 0;
+}
+
+static int swapFlipBlockRegisters( TDxtBlockType, BYTE*, BYTE*, int )
+{
+	return 0;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+// Byte block size for DXT1 and BC4 compression formats.
+static const int dxtSmallBlockSize = 8;
+// Byte block size for DXT3, DXT5 and BC5 compression formats.
+static const int dxtBigBlockSize = 16;
+int GetDxtBlockSize( TDxtBlockType type )
+{
+	return ( type == DBT_Dxt1 || type == DBT_Bc4 ) ? dxtSmallBlockSize : dxtBigBlockSize;
+}
+
+void FlipDxtBlock( TDxtBlockType type, BYTE* dest, const BYTE* src )
+{
+	switch( type ) {
+	case DBT_Dxt1:
+		flipDxt1Block( dest, src );
+		break;
+	case DBT_Dxt3:
+		flipDxt3Block( dest, src );
+		break;
+	case DBT_Dxt5:
+		flipDxt5Block( dest, src );
+		break;
+	case DBT_Bc4:
+		flipCompressedAlphaBlock( dest, src );
+		break;
+	case DBT_Bc5:
+		flipBc5Block( dest, src );
+		break;
+	default:
+		assert( false );
+	}
+}
+
+void FlipDxtBlocks( TDxtBlockType type, BYTE* dest, const BYTE* src, int byteCount )
+{
+	const int blockSize = GetDxtBlockSize( type );
+	assert( byteCount % blockSize == 0 );
+	// Blocks that do not fill a whole register are flipped one by one.
+	for( int pos = flipBlockRegisters( type, dest, src, byteCount ); pos < byteCount; pos += blockSize ) {
+		FlipDxtBlock( type, dest + pos, src + pos );
+	}
+}
+
+void SwapFlipDxtBlocks( TDxtBlockType type, BYTE* first, BYTE* second, int byteCount )
+{
+	const int blockSize = GetDxtBlockSize( type );
+	assert( byteCount % blockSize == 0 );
+	for( int pos = swapFlipBlockRegisters( type, first, second, byteCount ); pos < byteCount; pos += blockSize ) {
+		BYTE firstBlock[dxtBigBlockSize];
+		memcpy( firstBlock, first + pos, blockSize );
+		FlipDxtBlock( type, first + pos, second + pos );
+		FlipDxtBlock( type, second + pos, firstBlock );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace GinInternal.
+
+}	// namespace Gin.
+
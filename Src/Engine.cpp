@@ -25,15 +25,16 @@ long long CEngine::getCurrentTime()
 
 //////////////////////////////////////////////////////////////////////////
 
-CFixedStepEngine::CFixedStepEngine( int maxFPS )
+CFixedStepEngine::CFixedStepEngine( int _maxFPS )
 {
-	SetMaxFPS( maxFPS );
+	SetMaxFPS( _maxFPS );
 }
 
 void CFixedStepEngine::SetMaxFPS( int newValue )
 {
 	assert( newValue > 0 );
 
+	maxFPS = newValue;
 	stepSize = 1.0f / newValue;
 
 	stepSizePerfUnits = static_cast<unsigned>( Round( stepSize * GetCounterResolution() ) );
@@ -43,6 +44,12 @@ CFrameInformation CFixedStepEngine::AdvanceFrame()
 {
 	const long long lastFrameTime = GetLastUpdateStartTime();
 	const long long currentTicks = getCurrentTime();
+	if( isCaptureMode ) {
+		setLastUpdateTime( currentTicks );
+		setLastDrawTime( currentTicks );
+		return CFrameInformation{ stepSize, true, true };
+	}
+
 	const unsigned timeSinceUpdate = static_cast<unsigned>( currentTicks - lastFrameTime );
 	if( timeSinceUpdate > stepSizePerfUnits ) {
 		const int frameDelay = timeSinceUpdate % stepSizePerfUnits;
@@ -0,0 +1,67 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <FileMapping.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CFileMapping::CFileMapping( CStringPart _fileName ) :
+	fileName( _fileName )
+{
+	fileHandle = ::CreateFile( UnicodeStr( fileName ).Ptr(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	checkMappingError( fileHandle != INVALID_HANDLE_VALUE );
+
+	LARGE_INTEGER fileSize;
+	checkMappingError( ::GetFileSizeEx( fileHandle, &fileSize ) != 0 );
+	// The view size is limited by the size type of array views.
+	checkMappingError( fileSize.QuadPart <= INT_MAX );
+	size = static_cast<int>( fileSize.QuadPart );
+	if( size == 0 ) {
+		// Empty files cannot be mapped.
+		return;
+	}
+
+	mappingHandle = ::CreateFileMapping( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	checkMappingError( mappingHandle != nullptr );
+	view = static_cast<const BYTE*>( ::MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+	checkMappingError( view != nullptr );
+}
+
+CFileMapping::~CFileMapping()
+{
+	close();
+}
+
+void CFileMapping::close()
+{
+	if( view != nullptr ) {
+		::UnmapViewOfFile( view );
+		view = nullptr;
+	}
+	if( mappingHandle != nullptr ) {
+		::CloseHandle( mappingHandle );
+		mappingHandle = nullptr;
+	}
+	if( fileHandle != INVALID_HANDLE_VALUE ) {
+		::CloseHandle( fileHandle );
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+	size = 0;
+}
+
+extern const CError Err_FileMappingFailed;
+void CFileMapping::checkMappingError( bool condition )
+{
+	if( !condition ) {
+		const int errorCode = ::GetLastError();
+		close();
+		check( false, Err_FileMappingFailed, fileName, errorCode );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
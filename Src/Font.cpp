@@ -43,6 +43,47 @@ CGlyph CFontView::GetGlyphByIndex( unsigned glyphIndex, CFontSizeView fontSize )
 	return CGlyph( fontFace->glyph );
 }
 
+CGlyphData CFontView::RenderGlyphByIndex( unsigned glyphIndex, CFontSizeView fontSize ) const
+{
+	FT_Activate_Size( fontSize.GetHandle() );
+	checkFreeTypeError( FT_Load_Glyph( fontFace, glyphIndex, FT_LOAD_RENDER ) );
+	const auto slot = fontFace->glyph;
+	CGlyphData result;
+	result.SizeData.Offset.X() = slot->bitmap_left;
+	result.SizeData.Offset.Y() = slot->bitmap_top;
+	result.SizeData.Size.X() = slot->bitmap.width;
+	result.SizeData.Size.Y() = slot->bitmap.rows;
+	result.SizeData.Pitch = slot->bitmap.pitch;
+	// Slot advance is in 26.6 fixed point format.
+	result.SizeData.Advance.X() = slot->advance.x >> 6;
+	result.SizeData.Advance.Y() = slot->advance.y >> 6;
+	result.BitmapData = slot->bitmap.buffer;
+	return result;
+}
+
+bool CFontView::HasKerning() const
+{
+	return FT_HAS_KERNING( fontFace ) != 0;
+}
+
+int CFontView::GetKerning( unsigned leftGlyphIndex, unsigned rightGlyphIndex, CFontSizeView fontSize ) const
+{
+	FT_Activate_Size( fontSize.GetHandle() );
+	FT_Vector delta;
+	checkFreeTypeError( FT_Get_Kerning( fontFace, leftGlyphIndex, rightGlyphIndex, FT_KERNING_DEFAULT, &delta ) );
+	// Kerning is in 26.6 fixed point format.
+	return delta.x >> 6;
+}
+
+CFontOwner CFontView::CreateFaceCopy() const
+{
+	assert( IsLoaded() );
+	assert( !fontData.IsEmpty() );
+	FT_Face newFace;
+	checkFreeTypeError( FT_New_Memory_Face( CFontOwner::freeTypeLib, fontData.Ptr(), fontData.Size(), fontFace->face_index, &newFace ) );
+	return CFontOwner( newFace, fontData );
+}
+
 CFontSizeOwner CFontView::CreateSizeObject( int pxSize ) const
 {
 	return CreateSizeObject( CVector2<int>( pxSize, pxSize ) );
@@ -66,6 +107,12 @@ CFontOwner::CFontOwner( CStringView name )
 	Load( name );
 }
 
+CFontOwner::CFontOwner( FT_Face face, CArrayView<BYTE> sharedData )
+{
+	view.GetFtFace() = face;
+	view.SetFontData( sharedData );
+}
+
 CFontOwner::CFontOwner( CFontOwner&& other ) :
 	fontData( move( other.fontData ) ),
 	view( other.view )
@@ -89,6 +136,7 @@ CFontOwner& CFontOwner::operator=( CFontOwner&& other )
 void CFontOwner::detachView()
 {
 	view.GetFtFace() = nullptr;
+	view.SetFontData( CArrayView<BYTE>() );
 }
 
 CFontOwner::~CFontOwner()
@@ -127,6 +175,7 @@ void CFontOwner::Load( CStringView name )
 
 	// No exceptions were thrown, fill Relib structures.
 	fontData = move( data );
+	view.SetFontData( fontData );
 }
 
 void CFontOwner::Unload()
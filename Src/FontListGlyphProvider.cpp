@@ -11,18 +11,73 @@ namespace Gin {
 void CFontListGlyphProvider::AddFont( CFontView fontView, int fontPxHeight )
 {
 	fontList.Add( fontView, fontPxHeight );
+	// Characters that were missing might be present in the new font.
+	glyphSources.Empty();
 }
 
 CPtrOwner<IGlyph> CFontListGlyphProvider::GetGlyph( int utf32 ) const
 {
-	assert( !fontList.IsEmpty() );
+	const auto source = findGlyphSource( utf32 );
+	return fontList[source.FontIndex].GetGlyphByIndex( source.GlyphIndex );
+}
+
+void CFontListGlyphProvider::GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const
+{
+	for( auto code : utf32Codes ) {
+		const auto source = findGlyphSource( code );
+		result.AddGlyph( fontList[source.FontIndex].RenderGlyphByIndex( source.GlyphIndex ) );
+	}
+}
+
+bool CFontListGlyphProvider::HasKerning() const
+{
 	for( const auto& font : fontList ) {
-		const auto glyphIndex = font.GetGlyphIndex( utf32 );
+		if( font.HasKerning() ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int CFontListGlyphProvider::GetKerning( int leftUtf32, int rightUtf32 ) const
+{
+	const auto leftSource = findGlyphSource( leftUtf32 );
+	const auto rightSource = findGlyphSource( rightUtf32 );
+	// Characters from different fonts are not kerned.
+	if( leftSource.FontIndex != rightSource.FontIndex || !fontList[leftSource.FontIndex].HasKerning() ) {
+		return 0;
+	}
+	return fontList[leftSource.FontIndex].GetKerningByIndex( leftSource.GlyphIndex, rightSource.GlyphIndex );
+}
+
+CFontListGlyphProvider::CGlyphSource CFontListGlyphProvider::findGlyphSource( unsigned utf32 ) const
+{
+	assert( !fontList.IsEmpty() );
+	const auto cachedSource = glyphSources.Get( utf32 );
+	if( cachedSource != nullptr ) {
+		return *cachedSource;
+	}
+
+	CGlyphSource result;
+	for( int i = 0; i < fontList.Size(); i++ ) {
+		const auto glyphIndex = fontList[i].GetGlyphIndex( utf32 );
 		if( glyphIndex != 0 ) {
-			return font.GetGlyphByIndex( glyphIndex );
+			result.FontIndex = i;
+			result.GlyphIndex = glyphIndex;
+			break;
 		}
 	}
-	return fontList[0].GetGlyph( utf32 );
+	glyphSources.Set( utf32, result );
+	return result;
+}
+
+CPtrOwner<IGlyphProvider> CFontListGlyphProvider::CreateWorkerCopy() const
+{
+	auto result = CreateOwner<CFontListGlyphProvider>();
+	for( const auto& font : fontList ) {
+		result->fontList.Add( font.CreateFaceCopy() );
+	}
+	return move( result );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -13,33 +13,48 @@
 #include <BufferMapper.h>
 #include <DefaultSamplerContainer.h>
 #include <GlyphProvider.h>
+#include <TextBatch.h>
 
 namespace Gin {
 
 //////////////////////////////////////////////////////////////////////////
 
 CTextMesh::CTextMesh() :
-	meshData( CGlBufferOwner<BT_Array, CVector4<float>>::CreateRawBuffer() ),
-	mesh( CMeshOwner<CArrayMesh>::CreateRawMesh() )
+	meshData( CGlBufferOwner<BT_Array, CTextVertex>::CreateRawBuffer() ),
+	mesh( CMeshOwner<CElementMesh>::CreateRawMesh() ),
+	drawMesh( NotFound, MDM_Triangles )
 {
 }
 
 CTextMesh::CTextMesh( const CFontRenderer& _owner ) : 
-	meshData( CGlBufferOwner<BT_Array, CVector4<float>>::CreateRawBuffer() ),
-	mesh( CMeshOwner<CArrayMesh>::CreateRawMesh() ),
+	meshData( CGlBufferOwner<BT_Array, CTextVertex>::CreateRawBuffer() ),
+	mesh( CMeshOwner<CElementMesh>::CreateRawMesh() ),
+	drawMesh( NotFound, MDM_Triangles ),
 	owner( &_owner )
 {
 }
 
-CTextMesh::CTextMesh( CGlBufferOwner<BT_Array, CVector4<float>>&& dataSource, CMeshOwner<CArrayMesh>&& source, CPixelRect rect, const CFontRenderer& _owner, int _vertexCount ) : 
+CTextMesh::CTextMesh( CGlBufferOwner<BT_Array, CTextVertex>&& dataSource, CMeshOwner<CElementMesh>&& source, CPixelRect rect, const CFontRenderer& _owner, int _vertexCount ) : 
 	meshData( move( dataSource ) ),
 	mesh( move( source ) ),
+	drawMesh( mesh ),
 	boundRect( rect ),
 	owner( &_owner ),
 	vertexCount( _vertexCount )
 {
 }
 
+CTextMesh::CTextMesh( CElementMesh sharedMesh, int _firstVertex, CPixelRect rect, const CFontRenderer& _owner, int _vertexCount ) :
+	meshData( CGlBufferOwner<BT_Array, CTextVertex>::CreateRawBuffer() ),
+	mesh( CMeshOwner<CElementMesh>::CreateRawMesh() ),
+	drawMesh( sharedMesh ),
+	boundRect( rect ),
+	owner( &_owner ),
+	firstVertex( _firstVertex ),
+	vertexCount( _vertexCount )
+{
+}
+
 void CTextMesh::DrawExact( const CMatrix3<float>& modelToClip, float zOrder, CColor textColor /*= CColor( 255, 255, 255, 255 ) */ ) const
 {
 	assert( owner != nullptr );
@@ -60,16 +75,21 @@ CUnicodeString CFontRenderer::asciiCharsStr;
 CPtrOwner<CFontRenderer::CFontShaderData> CFontRenderer::shaderData;
 //////////////////////////////////////////////////////////////////////////
 
-CFontRenderer::CFontRenderer()
+CFontRenderer::CFontRenderer() :
+	streamBuffer( CGlBufferOwner<BT_Array, CTextVertex>::CreateRawBuffer() ),
+	streamMesh( CMeshOwner<CElementMesh>::CreateRawMesh() )
 {
 	assert( shaderData != nullptr );
 	fontTexture.SetSamplerObject( GetLinearSampler() );
 }
 
-CFontRenderer::CFontRenderer( CPtrOwner<IGlyphProvider> provider ) :
-	glyphProvider( move( provider ) )
+CFontRenderer::CFontRenderer( CPtrOwner<IGlyphProvider> provider, TGlyphAtlasMode _atlasMode ) :
+	atlasMode( _atlasMode ),
+	streamBuffer( CGlBufferOwner<BT_Array, CTextVertex>::CreateRawBuffer() ),
+	streamMesh( CMeshOwner<CElementMesh>::CreateRawMesh() )
 {
 	assert( shaderData != nullptr );
+	glyphCache.SetGlyphProvider( move( provider ) );
 	fontTexture.SetSamplerObject( GetLinearSampler() );
 }
 
@@ -88,19 +108,21 @@ void CFontRenderer::ClearShaderData()
 	shaderData = nullptr;
 }
 
-void CFontRenderer::SetGlyphProvider( CPtrOwner<IGlyphProvider> newValue )
+void CFontRenderer::SetGlyphProvider( CPtrOwner<IGlyphProvider> newValue, TGlyphAtlasMode newAtlasMode )
 {
 	UnloadFont();
-	glyphProvider = move( newValue );
+	glyphCache.SetGlyphProvider( move( newValue ) );
+	atlasMode = newAtlasMode;
 }
 
 void CFontRenderer::UnloadFont()
 {
-	fontTextureState = CGlyphAtlasState{};
+	glyphCache.SetGlyphProvider( CPtrOwner<IGlyphProvider>() );
+	atlasTextureSize = CVector2<int>{};
 	fontTexture = CTextureOwner<TBT_Texture2, TGF_Red>();
 	fontTexture.SetSamplerObject( GetLinearSampler() );
-	glyphProvider = nullptr;
-	fontData.FreeBuffer();
+	meshCachePolicy.Empty();
+	cachedMeshes.Empty();
 }
 
 void CFontRenderer::LoadBasicCharSet() const
@@ -108,170 +130,63 @@ void CFontRenderer::LoadBasicCharSet() const
 	LoadCharSet( asciiCharsStr );
 }
 
-// Distance between glyphs in the texture.
 void CFontRenderer::LoadCharSet( CUnicodePart str ) const
 {
-	assert( IsFontLoaded() );
-	const auto strLength = str.Length();
-	fontData.ReserveBuffer( fontData.Size() + strLength );
-	// Fill the glyph data.
-	CArray<CPtrOwner<IGlyph>> glyphs;
-	CArray<CVector2<int>> glyphOffsets;
-	glyphs.ReserveBuffer( strLength );
-	glyphOffsets.ReserveBuffer( strLength );
-
-	auto currentState = fontTextureState;
-	for( int i = 0; i < strLength; i++ ) {
-		// Find the glyph's UTF32 code.
-		const auto glyphCode = parseUtf16Character( str, i );
-		if( fontData.Has( glyphCode ) ) {
-			// Skip the already loaded values.
-			continue;
-		}
-
-		// Get the glyph and send the fondData.
-		glyphs.Add( glyphProvider->GetGlyph( glyphCode ) );
-		const CGlyphData glyphData = glyphs.Last()->GetGlyphData();
-		currentState = fitGlyphIntoAtlas( currentState, glyphData.SizeData.Size );
-		const CVector2<int> symbolOffset{ currentState.Offset.X() - glyphData.SizeData.Size.X(), currentState.Offset.Y() };
-		const CRenderGlyphData renderData( glyphData.SizeData, symbolOffset );
-		fontData.Set( glyphCode, renderData );
-		glyphOffsets.Add( renderData.GlyphOffset );
-	}
-	if( glyphs.IsEmpty() ) {
-		return;
-	}
-
-	CTextureBinder binder( fontTexture );
-	setGlyphAtlasState( currentState );
-
-	// Fill the glyph texture.
-	for( int i = 0; i < glyphs.Size(); i++ ) {
-		const auto glyphData = glyphs[i]->GetGlyphData();
-		// Negative pitch is not supported. At least until a single font with negative pitch is found.
-		assert( glyphData.SizeData.Pitch >= 0 );
-		assert( glyphData.SizeData.Size.X() == glyphData.SizeData.Pitch );
-		fillTextureBuffer( fontTexture, glyphOffsets[i], glyphData.BitmapData, glyphData.SizeData.Size );
-	}
+	LoadCharSet( str, 1 );
 }
 
-void CFontRenderer::fillTextureBuffer( CTextureOwner<TBT_Texture2, TGF_Red>& target,
-	CVector2<int> textureOffset, const BYTE* bitmap, CVector2<int> bitmapSize ) const
+void CFontRenderer::LoadCharSet( CUnicodePart str, int workerCount ) const
 {
-	target.SetSubData( textureOffset, bitmap, bitmapSize, 0, TF_Red, TDT_UnsignedByte );
+	glyphCache.LoadGlyphs( str, workerCount );
 }
 
-const int glyphPadding = 1;
-const int maxAtlasWidth = 1024;
-CFontRenderer::CGlyphAtlasState CFontRenderer::fitGlyphIntoAtlas( CGlyphAtlasState state, CVector2<int> glyphSize ) const
+void CFontRenderer::FlushGlyphAtlas() const
 {
-	const CVector2<int> glyphRealSize{ glyphSize.X() + glyphPadding, glyphSize.Y() + glyphPadding };
-	const auto newHOffset = state.Offset.X() + glyphRealSize.X();
-	if( newHOffset <= maxAtlasWidth ) {
-		const auto lineHeightDelta = max( 0, glyphRealSize.Y() - state.LineHeight );
-		const auto newLineHeight = state.LineHeight + lineHeightDelta;
-		const auto newWidth = max( state.Size.X(), newHOffset );
-		const auto newHeight = state.Size.Y() + lineHeightDelta;
-		const CVector2<int> newSize{ newWidth, newHeight };
-		const CVector2<int> newOffset{ newHOffset, state.Offset.Y() };
-		return CGlyphAtlasState{ newSize, newOffset, newLineHeight };
+	auto& glyphAtlas = glyphCache.GetAtlas();
+	const auto upload = glyphAtlas.TakeUpload( atlasTextureSize );
+	const auto atlasCapacity = glyphAtlas.GetCapacity();
+	const auto atlasPixels = glyphAtlas.GetPixels();
+	if( upload.IsReallocation ) {
+		CTextureBinder binder( fontTexture );
+		fontTexture.SetData( atlasPixels.Ptr(), atlasCapacity, 0, TF_Red, TDT_UnsignedByte );
+		atlasTextureSize = atlasCapacity;
+	} else if( !upload.IsEmpty() ) {
+		const BYTE* uploadData = atlasPixels.Ptr() + upload.Offset.Y() * atlasCapacity.X() + upload.Offset.X();
+		CTextureBinder binder( fontTexture );
+		gl::PixelStorei( gl::UNPACK_ROW_LENGTH, atlasCapacity.X() );
+		fontTexture.SetSubData( upload.Offset, uploadData, upload.Size, 0, TF_Red, TDT_UnsignedByte );
+		gl::PixelStorei( gl::UNPACK_ROW_LENGTH, 0 );
 	}
-	const auto newVOffset = state.Offset.Y() + state.LineHeight;
-	const auto newLineHeight = glyphRealSize.Y();
-	const auto newWidth = max( state.Size.X(), glyphRealSize.X() );
-	const auto newHeight = state.Size.Y() + newLineHeight;
-	const CVector2<int> newSize{ newWidth, newHeight };
-	const CVector2<int> newOffset{ newWidth, newVOffset };
-	return CGlyphAtlasState{ newSize, newOffset, newLineHeight };
 }
 
-void CFontRenderer::setGlyphAtlasState( CGlyphAtlasState newState ) const
+CShaderProgram CFontRenderer::Shader()
 {
-	const auto oldSize = fontTextureState.Size;
-	const auto newSize = newState.Size;
-	if( newSize.X() > oldSize.X() || newSize.Y() > oldSize.Y() ) {
-		fontTexture.GrowBuffer( oldSize, newSize, TF_Red, TDT_UnsignedByte );
-		padGlyphAtlas( oldSize, newSize );
-	}
-	fontTextureState = newState;
+	return shaderData->FontProgram;
 }
 
-void CFontRenderer::padGlyphAtlas( CVector2<int> oldSize, CVector2<int> newSize ) const
+CShaderProgram CFontRenderer::BatchShader()
 {
-	assert( oldSize.X() <= newSize.X() );
-	assert( oldSize.Y() <= newSize.Y() );
-	CArray<BYTE> zeroBuffer;
-	if( oldSize.IsNull() ) {
-		zeroBuffer.IncreaseSize( newSize.X() * newSize.Y() );
-		fontTexture.SetData( zeroBuffer.Ptr(), newSize, 0, TF_Red, TDT_UnsignedByte );
-		return;
-	}
-
-	const CVector2<int> rightPaddingSize{ newSize.X() - oldSize.X(), newSize.Y() };
-	if( rightPaddingSize.X() > 0 ) {
-		const auto rightPaddingArea = rightPaddingSize.X() * rightPaddingSize.Y();
-		zeroBuffer.IncreaseSize( rightPaddingArea );
-		const CVector2<int> rightOffset{ oldSize.X(), 0 };
-		fontTexture.SetSubData( rightOffset, zeroBuffer.Ptr(), rightPaddingSize, 0, TF_Red, TDT_UnsignedByte );
-	}
-
-	const CVector2<int> topPaddingSize{ oldSize.X(), newSize.Y() - oldSize.Y() };
-	if( topPaddingSize.Y() > 0 ) {
-		const auto topPaddingArea = topPaddingSize.X() * topPaddingSize.Y();
-		if( zeroBuffer.Size() < topPaddingArea ) {
-			zeroBuffer.IncreaseSize( topPaddingArea );
-		}
-		const CVector2<int> topOffset{ 0, oldSize.Y() };
-		fontTexture.SetSubData( topOffset, zeroBuffer.Ptr(), topPaddingSize, 0, TF_Red, TDT_UnsignedByte );
-	}
+	return shaderData->BatchProgram;
 }
 
-const CStringView invalidStrError = "Invalid string passed to renderer: %0.";
-// Get the UTF16 character code from str at strPos. A parsed UTF32 character is returned.
-unsigned CFontRenderer::parseUtf16Character( CUnicodePart str, int& strPos ) const
+CShaderProgram CFontRenderer::DistanceFieldShader()
 {
-	assert( strPos < str.Length() );
-	unsigned result;
-	if( !Unicode::TryConvertUtf16ToUtf32( str[strPos], result ) ) {
-		const auto nextPos = strPos + 1;
-		if( nextPos == str.Length() ) {
-			CMessageSourceSwitcher swt( GetMessageSource() );
-			Log::Warning( invalidStrError.SubstParam( str ) );
-			return str[strPos];
-		}
-		if( !Unicode::TryConvertUtf16ToUtf32( str[strPos], str[nextPos], result ) ) {
-			CMessageSourceSwitcher swt( GetMessageSource() );
-			Log::Warning( invalidStrError.SubstParam( str ) );
-			result = str[nextPos];
-			strPos++;
-		} else {
-			strPos += 2;
-		}
-	} else {
-		strPos++;
-	}
-	return result;
+	return shaderData->DistanceFieldProgram;
 }
 
-unsigned CFontRenderer::parseUtf8Character( CStringPart str, int& strPos ) const
+CShaderProgram CFontRenderer::DistanceFieldBatchShader()
 {
-	assert( strPos < str.Length() );
-	unsigned result;
-	const auto parsedCount = Unicode::TryConvertUtf8ToUtf32( str.begin() + strPos, str.Length() - strPos, result );
-	if( parsedCount == 0 ) {
-		CMessageSourceSwitcher swt( GetMessageSource() );
-		Log::Warning( invalidStrError.SubstParam( str ) );
-		strPos++;
-		return 0;
-	}
+	return shaderData->DistanceFieldBatchProgram;
+}
 
-	strPos += parsedCount;
-	return result;
+CShaderProgram CFontRenderer::GetShader() const
+{
+	return atlasMode == GAM_DistanceField ? DistanceFieldShader() : Shader();
 }
 
-CShaderProgram CFontRenderer::Shader()
+CShaderProgram CFontRenderer::GetBatchShader() const
 {
-	return shaderData->FontProgram;
+	return atlasMode == GAM_DistanceField ? DistanceFieldBatchShader() : BatchShader();
 }
 
 CStringView CFontRenderer::GetMessageSource()
@@ -281,19 +196,16 @@ CStringView CFontRenderer::GetMessageSource()
 
 CGlyphSizeData CFontRenderer::GetGlyphData( unsigned symbolUTF ) const
 {
-	return getOrCreateRenderData( symbolUTF ).GlyphData;
+	return glyphCache.GetRenderData( symbolUTF ).GlyphData;
 }
 
-CFontRenderer::CRenderGlyphData CFontRenderer::getOrCreateRenderData( unsigned glyphCode ) const
+int CFontRenderer::GetKerning( unsigned leftUTF, unsigned rightUTF ) const
 {
-	auto& charData = fontData.GetOrCreate( glyphCode ).Value();
-	if( charData.GlyphOffset.X() == NotFound ) {
-		addCharToTexture( glyphCode, charData );
-	}
-	return charData;
+	return glyphCache.GetKerning( leftUTF, rightUTF );
 }
 
-static const int verticesPerChar = 6;
+static const int verticesPerChar = CFontRenderer::GlyphQuadVertexCount;
+static const int indicesPerChar = 6;
 CTextMesh CFontRenderer::RenderLine( CUnicodePart str ) const
 {
 	return doRenderTextLine( str.begin(), str.Length(), &CFontRenderer::renderSingleUtf16Line );
@@ -304,117 +216,91 @@ CTextMesh CFontRenderer::RenderLine( CStringPart str ) const
 	return doRenderTextLine( str.begin(), str.Length(), &CFontRenderer::renderSingleUtf8Line );
 }
 
-CTextMesh CFontRenderer::doRenderTextLine( const void* lineBuffer, int length, void ( CFontRenderer::*renderMethod )( const void*, int, CPixelRect&, int&, CArrayBuffer<CVector4<float>> ) const ) const
+CTextMesh CFontRenderer::doRenderTextLine( const void* lineBuffer, int length, void ( CFontRenderer::*renderMethod )( const void*, int, CPixelRect&, int&, CArrayBuffer<CTextVertex> ) const ) const
 {
 	if( length == 0 ) {
 		return CTextMesh( *this );
 	}
 	// Create mesh data from string.
-	CGlBufferOwner<BT_Array, CVector4<float>> stringData;
+	CGlBufferOwner<BT_Array, CTextVertex> stringData;
 	stringData.ReserveBuffer( length * verticesPerChar, BUH_StaticDraw );
-	CTextureBinder binder( fontTexture );
 
 	CPixelRect boundRect;
 	int lineVertexCount = 0;
 	CBufferMapper( BWMM_Write, stringData, renderMethod, this, lineBuffer, length, boundRect, lineVertexCount );
 
-	CMeshOwner<CArrayMesh> textMesh( MDM_Triangles );
-	textMesh.BindBuffer( stringData, { 0 } );
-
+	auto textMesh = createTextMesh( stringData, lineVertexCount );
 	return CTextMesh( move( stringData ), move( textMesh ), boundRect, *this, lineVertexCount );
 }
 
-void CFontRenderer::renderSingleUtf16Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const
+void CFontRenderer::renderSingleUtf16Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const
 {
 	CUnicodePart str( static_cast<const wchar_t*>( strBuffer ), length );
 	CVector2<int> pos;
 	renderUtf16Line( str, pos, 0, boundRect, lineVertexCount, stringData );
 }
 
-void CFontRenderer::renderSingleUtf8Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const
+void CFontRenderer::renderSingleUtf8Line( const void* strBuffer, int length, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const
 {
 	CStringPart str( static_cast<const char*>( strBuffer ), length );
 	CVector2<int> pos;
 	renderUtf8Line( str, pos, 0, boundRect, lineVertexCount, stringData );
 }
 
-// Render a single line of text. Return the amount of vertices created.
-void CFontRenderer::renderUtf16Line( CUnicodePart line, CVector2<int>& fontPos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const
+// Render a single line of text. Glyph positions are taken from the shaped line cache.
+void CFontRenderer::renderUtf16Line( CUnicodePart line, CVector2<int>& fontPos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const
 {
-	const int lineLength = line.Length();
-	// The loop variable can skip through surrogate pairs, we need to remember the number of rendered symbols separately.
-	int symbolIndex = dataOffset;
-	for( int i = 0; i < lineLength; ) {
-		// Find the glyph's UTF32 code.
-		const auto glyphCode = parseUtf16Character( line, i );
-		symbolIndex = addNewGlyph( glyphCode, boundRect, fontPos, symbolIndex, lineVertexCount, stringData );
-	}
+	renderShapedLine( glyphCache.GetShapedLine( line ), fontPos, dataOffset, boundRect, lineVertexCount, stringData );
 }
 
-void CFontRenderer::renderUtf8Line( CStringPart line, CVector2<int>& fontPos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const
+void CFontRenderer::renderUtf8Line( CStringPart line, CVector2<int>& fontPos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const
 {
-	const int lineLength = line.Length();
-	// The loop variable can skip through surrogate pairs, we need to remember the number of rendered symbols separately.
-	int symbolIndex = dataOffset;
-	for( int i = 0; i < lineLength; ) {
-		// Find the glyph's UTF32 code.
-		const auto glyphCode = parseUtf8Character( line, i );
-		symbolIndex = addNewGlyph( glyphCode, boundRect, fontPos, symbolIndex, lineVertexCount, stringData );
-	}
+	renderShapedLine( glyphCache.GetShapedLine( line ), fontPos, dataOffset, boundRect, lineVertexCount, stringData );
 }
 
-int CFontRenderer::addNewGlyph( unsigned glyphCode, CPixelRect& boundRect, CVector2<int>& fontPos, int symbolIndex, int& lineVertexCount, CArrayBuffer<CVector4<float>> stringData ) const
+void CFontRenderer::renderShapedLine( const CShapedLine& line, CVector2<int>& fontPos, int dataOffset, CPixelRect& boundRect, int& lineVertexCount, CArrayBuffer<CTextVertex> stringData ) const
 {
-	const CRenderGlyphData& charData = getOrCreateRenderData( glyphCode );
-	boundRect = GetRectUnion( boundRect, addQuadToMesh( fontPos, charData, stringData, symbolIndex * verticesPerChar ) );
-
-	fontPos += charData.GlyphData.Advance;
-	lineVertexCount += verticesPerChar;
-	return symbolIndex + 1;
+	const auto glyphCount = line.Glyphs.Size();
+	for( int i = 0; i < glyphCount; i++ ) {
+		const auto& glyph = line.Glyphs[i];
+		const auto charData = glyphCache.GetRenderData( glyph.GlyphCode );
+		boundRect = GetRectUnion( boundRect, AddGlyphQuad( fontPos + glyph.Position, charData, stringData, ( dataOffset + i ) * verticesPerChar ) );
+	}
+	lineVertexCount += glyphCount * verticesPerChar;
+	fontPos += line.EndOffset;
 }
 
-// Load the given character to the texture and fill the result glyph data structure.
-void CFontRenderer::addCharToTexture( unsigned charCode, CRenderGlyphData& result ) const
+extern const CError Err_TextExtentExceeded;
+// Convert a glyph position coordinate to the vertex format.
+static short getVertexCoordinate( int value )
 {
-	assert( IsFontLoaded() );
-	const auto charGlyph = glyphProvider->GetGlyph( charCode );
-	const auto glyphData = charGlyph->GetGlyphData();
-	
-	const auto newAtlasState = fitGlyphIntoAtlas( fontTextureState, glyphData.SizeData.Size );
-	const CVector2<int> textureOffset{ newAtlasState.Offset.X() - glyphData.SizeData.Size.X(), newAtlasState.Offset.Y() };
-	setGlyphAtlasState( newAtlasState );
-	result.GlyphData = glyphData.SizeData;
-	result.GlyphOffset = textureOffset;
-	fillTextureBuffer( fontTexture, textureOffset, glyphData.BitmapData, glyphData.SizeData.Size );
+	check( value >= -CFontRenderer::MaxTextExtent && value <= CFontRenderer::MaxTextExtent, Err_TextExtentExceeded, CFontRenderer::MaxTextExtent );
+	return static_cast<short>( value );
 }
 
-// Construct a quad from given data and add it to the mesh. Return the bounding rectangle of the quad.
-CPixelRect CFontRenderer::addQuadToMesh( CVector2<int> fontPos, CRenderGlyphData charRenderData,
-	CArrayBuffer<CVector4<float>> stringData, int meshOffset ) const
+CPixelRect CFontRenderer::AddGlyphQuad( CVector2<int> fontPos, CRenderGlyphData charRenderData,
+	CArrayBuffer<CTextVertex> stringData, int meshOffset )
 {
 	const auto glyphData = charRenderData.GlyphData;
-	const float charTextureWidth = glyphData.Size.X() * 1.f;
-	const float charTextureHeight = glyphData.Size.Y() * 1.f;
-	
-	const auto charTextureOffset = static_cast<CVector2<float>>( charRenderData.GlyphOffset );
-	const auto charFontSize = static_cast<CVector2<float>>( glyphData.Size );
-	const auto charFontPos = static_cast<CVector2<float>>( fontPos + glyphData.Offset );
-
-	// Create 4 vertices for the quad.
-	const CVector4<float> topLeft{ charFontPos.X(), charFontPos.Y(), charTextureOffset };
-	const CVector4<float> bottomLeft{ charFontPos.X(), charFontPos.Y() - charFontSize.Y(), charTextureOffset.X(), charTextureOffset.Y() + charTextureHeight };
-	const CVector4<float> bottomRight{ charFontPos.X() + charFontSize.X(), charFontPos.Y() - charFontSize.Y(), charTextureOffset.X() + charTextureWidth, charTextureOffset.Y() + charTextureHeight };
-	const CVector4<float> topRight{ charFontPos.X() + charFontSize.X(), charFontPos.Y(), charTextureOffset.X() + charTextureWidth, charTextureOffset.Y() };
-
-	stringData[meshOffset] = topLeft;
-	stringData[meshOffset + 1] = bottomLeft;
-	stringData[meshOffset + 2] = bottomRight;
-	stringData[meshOffset + 3] = topLeft;
-	stringData[meshOffset + 4] = bottomRight;
-	stringData[meshOffset + 5] = topRight;
+	const auto charFontPos = fontPos + glyphData.Offset;
+	const auto left = getVertexCoordinate( charFontPos.X() );
+	const auto right = getVertexCoordinate( charFontPos.X() + glyphData.Size.X() );
+	const auto top = getVertexCoordinate( charFontPos.Y() );
+	const auto bottom = getVertexCoordinate( charFontPos.Y() - glyphData.Size.Y() );
+	// Atlas offsets are limited by the maximum atlas size.
+	const auto texLeft = numeric_cast<short>( charRenderData.GlyphOffset.X() );
+	const auto texRight = numeric_cast<short>( charRenderData.GlyphOffset.X() + glyphData.Size.X() );
+	const auto texTop = numeric_cast<short>( charRenderData.GlyphOffset.Y() );
+	const auto texBottom = numeric_cast<short>( charRenderData.GlyphOffset.Y() + glyphData.Size.Y() );
+
+	// Create 4 vertices for the quad. Triangles are formed by the shared index buffer.
+	stringData[meshOffset] = CTextVertex{ left, top, texLeft, texTop };
+	stringData[meshOffset + 1] = CTextVertex{ left, bottom, texLeft, texBottom };
+	stringData[meshOffset + 2] = CTextVertex{ right, bottom, texRight, texBottom };
+	stringData[meshOffset + 3] = CTextVertex{ right, top, texRight, texTop };
 	// Consider empty glyphs to be 1px tall to not generate empty bound rectangles.
 	const auto glyphBoundsHeight = max( 1, glyphData.Size.Y() );
-	return CPixelRect{ CPixelVector( bottomLeft.XY() ), glyphData.Advance.X(), glyphBoundsHeight };
+	return CPixelRect{ CPixelVector( charFontPos.X(), charFontPos.Y() - glyphData.Size.Y() ), glyphData.Advance.X(), glyphBoundsHeight };
 }
 
 void CFontRenderer::RenderMultipleLines( CUnicodePart str, int lineWidth, int startHOffset, CArray<CTextMesh>& lines ) const
@@ -423,8 +309,7 @@ void CFontRenderer::RenderMultipleLines( CUnicodePart str, int lineWidth, int st
 		return;
 	}
 
-	CArray<CVector4<float>> tempLineBuffer;
-	CTextureBinder binder( fontTexture );
+	CArray<CTextVertex> tempLineBuffer;
 	const int length = str.Length();
 	int strPos = 0;
 	CPixelRect lineRect;
@@ -457,7 +342,7 @@ void CFontRenderer::RenderMultipleLines( CUnicodePart str, int lineWidth, int st
 			if( prevLineEnd > 0 ) {
 				tempLineBuffer.DeleteAt( 0, prevLineEnd );
 			}
-			lineRect = startNewLine( static_cast<float>( currentHOffset ), wordRect, tempLineBuffer );
+			lineRect = startNewLine( currentHOffset, wordRect, tempLineBuffer );
 			currentHOffset = lineRect.GridRight();
 			lineStartPos = wordStartPos;
 		}
@@ -473,8 +358,7 @@ void CFontRenderer::RenderMultipleLines( CStringPart str, int lineWidth, int sta
 		return;
 	}
 
-	CArray<CVector4<float>> tempLineBuffer;
-	CTextureBinder binder( fontTexture );
+	CArray<CTextVertex> tempLineBuffer;
 	const int length = str.Length();
 	int strPos = 0;
 	CPixelRect lineRect;
@@ -506,7 +390,7 @@ void CFontRenderer::RenderMultipleLines( CStringPart str, int lineWidth, int sta
 			if( prevLineEnd > 0 ) {
 				tempLineBuffer.DeleteAt( 0, prevLineEnd );
 			}
-			lineRect = startNewLine( static_cast<float>( currentHOffset ), wordRect, tempLineBuffer );
+			lineRect = startNewLine( currentHOffset, wordRect, tempLineBuffer );
 			currentHOffset = lineRect.GridRight();
 			lineStartPos = wordStartPos;
 		}
@@ -529,8 +413,8 @@ int CFontRenderer::calculateWhitespaceHAdvance( CUnicodePart str, int& strPos )
 			strPos = i;
 			return result;
 		}
-		const auto glyphCode = parseUtf16Character( str, i );
-		const auto& charData = getOrCreateRenderData( glyphCode );
+		const auto glyphCode = CGlyphCache::ParseCharacter( str, i );
+		const auto& charData = glyphCache.GetRenderData( glyphCode );
 		result += charData.GlyphData.Advance.X();
 	}
 	strPos = length;
@@ -550,69 +434,80 @@ int CFontRenderer::calculateWhitespaceHAdvance( CStringPart str, int& strPos ) c
 			strPos = i;
 			return result;
 		}
-		const auto glyphCode = parseUtf8Character( str, i );
-		const auto& charData = getOrCreateRenderData( glyphCode );
+		const auto glyphCode = CGlyphCache::ParseCharacter( str, i );
+		const auto& charData = glyphCache.GetRenderData( glyphCode );
 		result += charData.GlyphData.Advance.X();
 	}
 	strPos = length;
 	return result;
 }
 
-void CFontRenderer::addLineMesh( int lineStartPos, int strPos, CPixelRect lineRect, CArrayView<CVector4<float>> lineBuffer, CArray<CTextMesh>& lines ) const
+void CFontRenderer::addLineMesh( int lineStartPos, int strPos, CPixelRect lineRect, CArrayView<CTextVertex> lineBuffer, CArray<CTextMesh>& lines ) const
 {
 	assert( strPos >= lineStartPos );
-	CGlBufferOwner<BT_Array, CVector4<float>> lineData;
+	CGlBufferOwner<BT_Array, CTextVertex> lineData;
 	lineData.CreateBuffer( lineBuffer, BUH_StaticDraw );
-	CMeshOwner<CArrayMesh> lineMesh( MDM_Triangles );
-	lineMesh.BindBuffer( lineData, { 0 } );
+	auto lineMesh = createTextMesh( lineData, lineBuffer.Size() );
 	CTextMesh resultMesh{ move( lineData ), move( lineMesh ), lineRect, *this, lineBuffer.Size() };
 	lines.Add( move( resultMesh ) );
 }
 
-CPixelRect CFontRenderer::renderUtf16Word( CUnicodePart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CVector4<float>>& wordBuffer ) const
+CPixelRect CFontRenderer::renderUtf16Word( CUnicodePart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CTextVertex>& wordBuffer ) const
 {
 	CPixelRect wordRect;
 	const int length = str.Length();
+	const auto wordStartPos = strPos;
+	unsigned prevCode = 0;
 	while( strPos < length ) {
 		if( str.IsCharWhiteSpace( str[strPos] ) ) {
 			break;
 		}
 		const auto oldPos = strPos;
-		const auto glyphCode = parseUtf16Character( str, strPos );
+		const auto glyphCode = CGlyphCache::ParseCharacter( str, strPos );
+		const auto kerning = oldPos > wordStartPos ? GetKerning( prevCode, glyphCode ) : 0;
+		symbolPos.X() += kerning;
 		if( !tryAddWordCharacter( glyphCode, maxWidth, symbolPos, wordRect, wordBuffer ) ) {
+			symbolPos.X() -= kerning;
 			strPos = oldPos;
 			break;
 		}
+		prevCode = glyphCode;
 	}
 	return wordRect;
 }
 
-CPixelRect CFontRenderer::renderUtf8Word( CStringPart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CVector4<float>>& wordBuffer ) const
+CPixelRect CFontRenderer::renderUtf8Word( CStringPart str, CVector2<int>& symbolPos, int maxWidth, int& strPos, CArray<CTextVertex>& wordBuffer ) const
 {
 	CPixelRect wordRect;
 	const int length = str.Length();
+	const auto wordStartPos = strPos;
+	unsigned prevCode = 0;
 	while( strPos < length ) {
 		if( str.IsCharWhiteSpace( str[strPos] ) ) {
 			break;
 		}
 		const auto oldPos = strPos;
-		const auto glyphCode = parseUtf8Character( str, strPos );
+		const auto glyphCode = CGlyphCache::ParseCharacter( str, strPos );
+		const auto kerning = oldPos > wordStartPos ? GetKerning( prevCode, glyphCode ) : 0;
+		symbolPos.X() += kerning;
 		if( !tryAddWordCharacter( glyphCode, maxWidth, symbolPos, wordRect, wordBuffer ) ) {
+			symbolPos.X() -= kerning;
 			strPos = oldPos;
 			break;
 		}
+		prevCode = glyphCode;
 	}
 	return wordRect;
 }
 
-bool CFontRenderer::tryAddWordCharacter( unsigned glyphCode, int maxWidth, CVector2<int>& symbolPos, CPixelRect& wordRect, CArray<CVector4<float>>& wordBuffer ) const
+bool CFontRenderer::tryAddWordCharacter( unsigned glyphCode, int maxWidth, CVector2<int>& symbolPos, CPixelRect& wordRect, CArray<CTextVertex>& wordBuffer ) const
 {
 	// Find the glyph's UTF32 code.
-	const CRenderGlyphData& charData = getOrCreateRenderData( glyphCode );
+	const CRenderGlyphData& charData = glyphCache.GetRenderData( glyphCode );
 	// Add the character to word buffer.
 	const int bufferPos = wordBuffer.Size();
 	wordBuffer.IncreaseSize( bufferPos + verticesPerChar );
-	const auto symbolRect = addQuadToMesh( symbolPos, charData, wordBuffer, bufferPos );
+	const auto symbolRect = AddGlyphQuad( symbolPos, charData, wordBuffer, bufferPos );
 	const auto wordWidth = wordRect.Width();
 	if( wordWidth == 0 || symbolRect.Width() + wordWidth <= maxWidth ) {
 		// The rendered word currently fits on the line, add the character.
@@ -627,22 +522,23 @@ bool CFontRenderer::tryAddWordCharacter( unsigned glyphCode, int maxWidth, CVect
 	}
 }
 
-CPixelRect CFontRenderer::startNewLine( float lineOffset, CPixelRect wordRect, CArrayBuffer<CVector4<float>> lineWordBuffer )
+CPixelRect CFontRenderer::startNewLine( int lineOffset, CPixelRect wordRect, CArrayBuffer<CTextVertex> lineWordBuffer )
 {
 	wordRect.Left() -= lineOffset;
 	wordRect.Right() -= lineOffset;
 	for( auto& pos : lineWordBuffer ) {
-		pos.X() -= lineOffset;
+		pos.X() = getVertexCoordinate( pos.X() - lineOffset );
 	}
 	return wordRect;
 }
 
-CPixelRect CFontRenderer::startNewLine( CPixelVector lineOffset, CPixelRect wordRect, CArrayBuffer<CVector4<float>> lineWordBuffer )
+CPixelRect CFontRenderer::startNewLine( CPixelVector lineOffset, CPixelRect wordRect, CArrayBuffer<CTextVertex> lineWordBuffer )
 {
 	const auto newLineRect = wordRect.GetOffsetRect( lineOffset );
+	const auto gridOffset = lineOffset.GetGridPos();
 	for( auto& pos : lineWordBuffer ) {
-		pos.X() += lineOffset.X();
-		pos.Y() += lineOffset.Y();
+		pos.X() = getVertexCoordinate( pos.X() + gridOffset.X() );
+		pos.Y() = getVertexCoordinate( pos.Y() + gridOffset.Y() );
 	}
 	return newLineRect;
 }
@@ -653,18 +549,15 @@ CParagraphRenderResult CFontRenderer::RenderMultipleLines( CUnicodePart str, int
 		return CParagraphRenderResult( CTextMesh( *this ), CVector2<int>( startHOffset, 0 ) );
 	}
 	// Create mesh data from string.
-	CGlBufferOwner<BT_Array, CVector4<float>> stringData;
+	CGlBufferOwner<BT_Array, CTextVertex> stringData;
 	stringData.ReserveBuffer( str.Length() * verticesPerChar, BUH_StaticDraw );
-	CTextureBinder binder( fontTexture );
 
 	CPixelRect boundRect;
 	int lineVertexCount = 0;
 	CVector2<int> endOffset( startHOffset, 0 );
 	CBufferMapper( BWMM_Write, stringData, &CFontRenderer::renderMultipleUtf16Lines, this, str, lineWidth, lineHeight, boundRect, lineVertexCount, endOffset );
 
-	CMeshOwner<CArrayMesh> textMesh( MDM_Triangles );
-	textMesh.BindBuffer( stringData, { 0 } );
-
+	auto textMesh = createTextMesh( stringData, lineVertexCount );
 	return CParagraphRenderResult( CTextMesh( move( stringData ), move( textMesh ), boundRect, *this, lineVertexCount ), endOffset );
 }
 
@@ -674,25 +567,22 @@ CParagraphRenderResult CFontRenderer::RenderMultipleLines( CStringPart str, int
 		return CParagraphRenderResult( CTextMesh( *this ), CVector2<int>( startHOffset, 0 ) );
 	}
 	// Create mesh data from string.
-	CGlBufferOwner<BT_Array, CVector4<float>> stringData;
+	CGlBufferOwner<BT_Array, CTextVertex> stringData;
 	stringData.ReserveBuffer( str.Length() * verticesPerChar, BUH_StaticDraw );
-	CTextureBinder binder( fontTexture );
 
 	CPixelRect boundRect;
 	int lineVertexCount = 0;
 	CVector2<int> endOffset( startHOffset, 0 );
 	CBufferMapper( BWMM_Write, stringData, &CFontRenderer::renderMultipleUtf8Lines, this, str, lineWidth, lineHeight, boundRect, lineVertexCount, endOffset );
 
-	CMeshOwner<CArrayMesh> textMesh( MDM_Triangles );
-	textMesh.BindBuffer( stringData, { 0 } );
-
+	auto textMesh = createTextMesh( stringData, lineVertexCount );
 	return CParagraphRenderResult( CTextMesh( move( stringData ), move( textMesh ), boundRect, *this, lineVertexCount ), endOffset );
 }
 
 void CFontRenderer::renderMultipleUtf16Lines( CUnicodePart str, int lineWidth, int lineHeight, CPixelRect& boundRect,
-	int& totalVertexCount, CVector2<int>& lineOffset, CArrayBuffer<CVector4<float>> stringData ) const
+	int& totalVertexCount, CVector2<int>& lineOffset, CArrayBuffer<CTextVertex> stringData ) const
 {
-	CArray<CVector4<float>> tempWordBuffer;
+	CArray<CTextVertex> tempWordBuffer;
 	const int length = str.Length();
 	int strPos = 0;
 	// Render the string word by word.
@@ -711,9 +601,9 @@ void CFontRenderer::renderMultipleUtf16Lines( CUnicodePart str, int lineWidth, i
 }
 
 void CFontRenderer::renderMultipleUtf8Lines( CStringPart str, int lineWidth, int lineHeight, CPixelRect& boundRect,
-	int& totalVertexCount, CVector2<int>& lineOffset, CArrayBuffer<CVector4<float>> stringData ) const
+	int& totalVertexCount, CVector2<int>& lineOffset, CArrayBuffer<CTextVertex> stringData ) const
 {
-	CArray<CVector4<float>> tempWordBuffer;
+	CArray<CTextVertex> tempWordBuffer;
 	const int length = str.Length();
 	int strPos = 0;
 	// Render the string word by word.
@@ -731,8 +621,8 @@ void CFontRenderer::renderMultipleUtf8Lines( CStringPart str, int lineWidth, int
 	}
 }
 
-void CFontRenderer::copyWordToBuffer( CPixelRect wordRect, CArray<CVector4<float>>& tempWordBuffer, int lineWidth, int lineHeight, int prevLineEndPosX, CVector2<int>& linePos,
-	CPixelRect& boundRect, int& totalVertexCount, CArrayBuffer<CVector4<float>> stringData ) const
+void CFontRenderer::copyWordToBuffer( CPixelRect wordRect, CArray<CTextVertex>& tempWordBuffer, int lineWidth, int lineHeight, int prevLineEndPosX, CVector2<int>& linePos,
+	CPixelRect& boundRect, int& totalVertexCount, CArrayBuffer<CTextVertex> stringData ) const
 {
 	const auto wordRight = Round( wordRect.Right() );
 	if( wordRight <= lineWidth ) {
@@ -756,7 +646,7 @@ void CFontRenderer::copyWordToBuffer( CPixelRect wordRect, CArray<CVector4<float
 void CFontRenderer::DisplayText( const CTextMesh& textMesh, const CMatrix3<float>& modelToClip, float zOrder, CColor color ) const
 {
 	assert( textMesh.owner == this );
-	assert( CShaderProgramSwitcher::GetCurrentShaderProgram().GetId() == shaderData->FontProgram.GetId() );
+	assert( CShaderProgramSwitcher::GetCurrentShaderProgram().GetId() == GetShader().GetId() );
 	
 	if( textMesh.IsEmpty() ) {
 		// No text to draw.
@@ -766,14 +656,280 @@ void CFontRenderer::DisplayText( const CTextMesh& textMesh, const CMatrix3<float
 	// Enable alpha blending.
 	CBlendModeSwitcher blendSwt( BF_SrcAlpha, BF_OneMinusSrcAlpha );
 	
-	const auto fltSize = static_cast<CVector2<float>>( fontTextureState.Size );
-	shaderData->AtlasSizeUniform.Set( fltSize );
-	shaderData->FontColorUniform.Set( color );
-	shaderData->FontUniform.Set( fontTexture );
-	shaderData->ModelToClipUniform.Set( modelToClip );
-	shaderData->ZOrderUniform.Set( zOrder );
+	FlushGlyphAtlas();
+	const auto fltSize = static_cast<CVector2<float>>( atlasTextureSize );
+	if( atlasMode == GAM_DistanceField ) {
+		shaderData->DistanceFieldAtlasSizeUniform.Set( fltSize );
+		shaderData->DistanceFieldColorUniform.Set( color );
+		shaderData->DistanceFieldFontUniform.Set( fontTexture );
+		shaderData->DistanceFieldModelToClipUniform.Set( modelToClip );
+		shaderData->DistanceFieldZOrderUniform.Set( zOrder );
+	} else {
+		shaderData->AtlasSizeUniform.Set( fltSize );
+		shaderData->FontColorUniform.Set( color );
+		shaderData->FontUniform.Set( fontTexture );
+		shaderData->ModelToClipUniform.Set( modelToClip );
+		shaderData->ZOrderUniform.Set( zOrder );
+	}
 	// Draw the mesh.
-	textMesh.mesh.Draw( shaderData->FontProgram, textMesh.vertexCount );
+	const auto firstIndex = textMesh.firstVertex / verticesPerChar * indicesPerChar;
+	const auto indexCount = textMesh.vertexCount / verticesPerChar * indicesPerChar;
+	textMesh.drawMesh.Draw( GetShader(), firstIndex, indexCount );
+	drawStatistics.DrawCallCount++;
+	drawStatistics.DrawnGlyphCount += textMesh.vertexCount / verticesPerChar;
+}
+
+CPixelRect CFontRenderer::RenderLineVertices( CUnicodePart str, CArray<CTextVertex>& vertices ) const
+{
+	const auto startPos = vertices.Size();
+	vertices.IncreaseSize( startPos + str.Length() * verticesPerChar );
+	CPixelRect boundRect;
+	CVector2<int> pos;
+	int lineVertexCount = 0;
+	renderUtf16Line( str, pos, startPos / verticesPerChar, boundRect, lineVertexCount, vertices );
+	// Surrogate pairs produce fewer glyphs than code units.
+	vertices.DeleteLast( vertices.Size() - startPos - lineVertexCount );
+	return boundRect;
+}
+
+CPixelRect CFontRenderer::RenderLineVertices( CStringPart str, CArray<CTextVertex>& vertices ) const
+{
+	const auto startPos = vertices.Size();
+	vertices.IncreaseSize( startPos + str.Length() * verticesPerChar );
+	CPixelRect boundRect;
+	CVector2<int> pos;
+	int lineVertexCount = 0;
+	renderUtf8Line( str, pos, startPos / verticesPerChar, boundRect, lineVertexCount, vertices );
+	// Multibyte characters produce fewer glyphs than code units.
+	vertices.DeleteLast( vertices.Size() - startPos - lineVertexCount );
+	return boundRect;
+}
+
+void CFontRenderer::DisplayTextBatch( const CTextBatch& batch, const CMatrix3<float>& pixelToClip, float zOrder ) const
+{
+	assert( batch.owner == this );
+	assert( CShaderProgramSwitcher::GetCurrentShaderProgram().GetId() == GetBatchShader().GetId() );
+	if( batch.IsEmpty() ) {
+		return;
+	}
+	if( !batch.isBufferValid ) {
+		updateBatchBuffer( batch );
+	}
+
+	CBlendModeSwitcher blendSwt( BF_SrcAlpha, BF_OneMinusSrcAlpha );
+
+	FlushGlyphAtlas();
+	const auto fltSize = static_cast<CVector2<float>>( atlasTextureSize );
+	if( atlasMode == GAM_DistanceField ) {
+		shaderData->DistanceFieldBatchAtlasSizeUniform.Set( fltSize );
+		shaderData->DistanceFieldBatchFontUniform.Set( fontTexture );
+		shaderData->DistanceFieldBatchPixelToClipUniform.Set( pixelToClip );
+		shaderData->DistanceFieldBatchZOrderUniform.Set( zOrder );
+	} else {
+		shaderData->BatchAtlasSizeUniform.Set( fltSize );
+		shaderData->BatchFontUniform.Set( fontTexture );
+		shaderData->BatchPixelToClipUniform.Set( pixelToClip );
+		shaderData->BatchZOrderUniform.Set( zOrder );
+	}
+	batch.mesh.Draw( GetBatchShader(), 0, batch.GetGlyphCount() * indicesPerChar );
+	drawStatistics.DrawCallCount++;
+	drawStatistics.DrawnGlyphCount += batch.GetGlyphCount();
+}
+
+// Batch vertex buffer size granularity in vertices.
+static const int batchBufferGranularity = 256 * verticesPerChar;
+void CFontRenderer::updateBatchBuffer( const CTextBatch& batch ) const
+{
+	const auto vertexCount = batch.vertices.Size();
+	if( vertexCount > batch.bufferCapacity ) {
+		const auto newCapacity = CeilTo( vertexCount, batchBufferGranularity );
+		if( batch.bufferCapacity == 0 ) {
+			batch.vertexBuffer = CGlBufferOwner<BT_Array, CTextBatchVertex>();
+		}
+		batch.vertexBuffer.ReserveBuffer( newCapacity, BUH_DynamicDraw );
+		reserveQuadIndices( newCapacity / verticesPerChar );
+		CMeshOwner<CElementMesh> newMesh( MDM_Triangles, shaderData->QuadIndexBuffer.View() );
+		const int stride = sizeof( CTextBatchVertex );
+		newMesh.BindRawBuffer( batch.vertexBuffer, 2, GLT_Float, 0, offsetof( CTextBatchVertex, Position ), stride );
+		newMesh.BindRawBuffer( batch.vertexBuffer, 2, GLT_Short, 1, offsetof( CTextBatchVertex, TexelOffset ), stride );
+		newMesh.BindRawBuffer( batch.vertexBuffer, 4, GLT_UnsignedByte, 2, offsetof( CTextBatchVertex, Color ), stride, true );
+		batch.mesh = move( newMesh );
+		batch.bufferCapacity = newCapacity;
+	}
+	batch.vertexBuffer.SetBuffer( batch.vertices );
+	batch.isBufferValid = true;
+	drawStatistics.BatchUploadCount++;
+	drawStatistics.BatchUploadedByteCount += vertexCount * sizeof( CTextBatchVertex );
+}
+
+CTextLayoutResult CFontRenderer::LayoutText( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset,
+	CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines ) const
+{
+	return glyphCache.LayoutText( str, lineWidth, lineHeight, startHOffset, glyphs, lines );
+}
+
+CTextLayoutResult CFontRenderer::LayoutText( CStringPart str, int lineWidth, int lineHeight, int startHOffset,
+	CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines ) const
+{
+	return glyphCache.LayoutText( str, lineWidth, lineHeight, startHOffset, glyphs, lines );
+}
+
+CPixelRect CFontRenderer::RenderLayoutVertices( CArrayView<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextVertex> vertices ) const
+{
+	assert( vertices.Size() >= glyphs.Size() * verticesPerChar );
+	CPixelRect boundRect;
+	for( int i = 0; i < glyphs.Size(); i++ ) {
+		const auto& charData = glyphCache.GetRenderData( glyphs[i].GlyphCode );
+		boundRect = GetRectUnion( boundRect, AddGlyphQuad( glyphs[i].Position, charData, vertices, i * verticesPerChar ) );
+	}
+	return boundRect;
+}
+
+// Create a text mesh from the vertex buffer and the shared quad index buffer.
+CMeshOwner<CElementMesh> CFontRenderer::createTextMesh( CGlBuffer<BT_Array, CTextVertex> vertexBuffer, int vertexCount ) const
+{
+	assert( vertexCount % verticesPerChar == 0 );
+	reserveQuadIndices( vertexCount / verticesPerChar );
+	CMeshOwner<CElementMesh> result( MDM_Triangles, shaderData->QuadIndexBuffer.View() );
+	result.BindRawBuffer( vertexBuffer, 4, GLT_Short, 0 );
+	return result;
+}
+
+static const int minQuadIndexCapacity = 4096;
+void CFontRenderer::reserveQuadIndices( int quadCount )
+{
+	if( quadCount <= shaderData->QuadIndexCapacity ) {
+		return;
+	}
+	// The buffer keeps its id, existing meshes use the prefix of the new contents and remain valid.
+	const auto newCapacity = max( minQuadIndexCapacity, max( quadCount, shaderData->QuadIndexCapacity * 2 ) );
+	CArray<unsigned> indices;
+	indices.IncreaseSize( newCapacity * indicesPerChar );
+	for( int quadPos = 0; quadPos < newCapacity; quadPos++ ) {
+		const unsigned firstVertex = quadPos * verticesPerChar;
+		const auto indexPos = quadPos * indicesPerChar;
+		indices[indexPos] = firstVertex;
+		indices[indexPos + 1] = firstVertex + 1;
+		indices[indexPos + 2] = firstVertex + 2;
+		indices[indexPos + 3] = firstVertex;
+		indices[indexPos + 4] = firstVertex + 2;
+		indices[indexPos + 5] = firstVertex + 3;
+	}
+	shaderData->QuadIndexBuffer.CreateBuffer( indices, BUH_StaticDraw );
+	shaderData->QuadIndexCapacity = newCapacity;
+}
+
+const CTextMesh& CFontRenderer::RenderCachedLine( CUnicodePart str ) const
+{
+	const CArrayView<BYTE> text( reinterpret_cast<const BYTE*>( str.begin() ), str.Length() * sizeof( wchar_t ) );
+	const CTextMeshCacheKey key( text, true );
+	const auto slot = meshCachePolicy.FindSlot( key, text );
+	return slot != NotFound ? *cachedMeshes[slot] : addCachedMesh( key, text, RenderLine( str ) );
+}
+
+const CTextMesh& CFontRenderer::RenderCachedLine( CStringPart str ) const
+{
+	const CArrayView<BYTE> text( reinterpret_cast<const BYTE*>( str.begin() ), str.Length() );
+	const CTextMeshCacheKey key( text, false );
+	const auto slot = meshCachePolicy.FindSlot( key, text );
+	return slot != NotFound ? *cachedMeshes[slot] : addCachedMesh( key, text, RenderLine( str ) );
+}
+
+const CTextMesh& CFontRenderer::RenderCachedMultipleLines( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset ) const
+{
+	const CArrayView<BYTE> text( reinterpret_cast<const BYTE*>( str.begin() ), str.Length() * sizeof( wchar_t ) );
+	const CTextMeshCacheKey key( text, true, lineWidth, lineHeight, startHOffset );
+	const auto slot = meshCachePolicy.FindSlot( key, text );
+	return slot != NotFound ? *cachedMeshes[slot] : addCachedMesh( key, text, RenderMultipleLines( str, lineWidth, lineHeight, startHOffset ).Mesh );
+}
+
+const CTextMesh& CFontRenderer::RenderCachedMultipleLines( CStringPart str, int lineWidth, int lineHeight, int startHOffset ) const
+{
+	const CArrayView<BYTE> text( reinterpret_cast<const BYTE*>( str.begin() ), str.Length() );
+	const CTextMeshCacheKey key( text, false, lineWidth, lineHeight, startHOffset );
+	const auto slot = meshCachePolicy.FindSlot( key, text );
+	return slot != NotFound ? *cachedMeshes[slot] : addCachedMesh( key, text, RenderMultipleLines( str, lineWidth, lineHeight, startHOffset ).Mesh );
+}
+
+const CTextMesh& CFontRenderer::addCachedMesh( const CTextMeshCacheKey& key, CArrayView<BYTE> text, CTextMesh mesh ) const
+{
+	const int meshByteSize = mesh.vertexCount * sizeof( CTextVertex );
+	evictedMeshSlots.Empty();
+	const auto slot = meshCachePolicy.AddSlot( key, text, meshByteSize, evictedMeshSlots );
+	for( auto evictedSlot : evictedMeshSlots ) {
+		cachedMeshes[evictedSlot] = nullptr;
+	}
+	if( slot >= cachedMeshes.Size() ) {
+		cachedMeshes.IncreaseSize( slot + 1 );
+	}
+	cachedMeshes[slot] = CreateOwner<CTextMesh>( move( mesh ) );
+	return *cachedMeshes[slot];
+}
+
+CTextMesh CFontRenderer::RenderStreamedLine( CUnicodePart str ) const
+{
+	return doRenderStreamedLine( str.begin(), str.Length(), &CFontRenderer::renderSingleUtf16Line );
+}
+
+CTextMesh CFontRenderer::RenderStreamedLine( CStringPart str ) const
+{
+	return doRenderStreamedLine( str.begin(), str.Length(), &CFontRenderer::renderSingleUtf8Line );
+}
+
+CTextMesh CFontRenderer::doRenderStreamedLine( const void* lineBuffer, int length, void ( CFontRenderer::*renderMethod )( const void*, int, CPixelRect&, int&, CArrayBuffer<CTextVertex> ) const ) const
+{
+	if( length == 0 ) {
+		return CTextMesh( *this );
+	}
+
+	streamStagingBuffer.Empty();
+	streamStagingBuffer.IncreaseSize( length * verticesPerChar );
+	CPixelRect boundRect;
+	int lineVertexCount = 0;
+	( this->*renderMethod )( lineBuffer, length, boundRect, lineVertexCount, streamStagingBuffer );
+	const auto lineVertices = streamStagingBuffer.Left( lineVertexCount );
+	streamRequestedVertexCount += lineVertexCount;
+
+	if( streamVertexCount + lineVertexCount > streamBufferCapacity ) {
+		// The streaming buffer is grown on the next frame, until then the line gets a buffer of its own.
+		CGlBufferOwner<BT_Array, CTextVertex> lineData;
+		lineData.CreateBuffer( lineVertices, BUH_StreamDraw );
+		auto lineMesh = createTextMesh( lineData, lineVertexCount );
+		return CTextMesh( move( lineData ), move( lineMesh ), boundRect, *this, lineVertexCount );
+	}
+
+	const auto firstVertex = streamVertexCount;
+	streamBuffer.SetBuffer( lineVertices, firstVertex );
+	streamVertexCount += lineVertexCount;
+	meshCachePolicy.OnMeshStreamed();
+	return CTextMesh( streamMesh, firstVertex, boundRect, *this, lineVertexCount );
+}
+
+// Streaming buffer size granularity in vertices.
+static const int streamBufferGranularity = 1024 * verticesPerChar;
+void CFontRenderer::AdvanceTextCacheFrame() const
+{
+	FlushGlyphAtlas();
+	meshCachePolicy.AdvanceFrame();
+	if( streamRequestedVertexCount > streamBufferCapacity ) {
+		resizeStreamBuffer( CeilTo( streamRequestedVertexCount, streamBufferGranularity ) );
+	} else if( streamVertexCount > 0 ) {
+		// Orphan the storage that might still be used by the previous frame draw calls.
+		streamBuffer.ReserveBuffer( streamBufferCapacity, BUH_StreamDraw );
+	}
+	streamVertexCount = 0;
+	streamRequestedVertexCount = 0;
+}
+
+void CFontRenderer::resizeStreamBuffer( int newCapacity ) const
+{
+	if( streamBufferCapacity == 0 ) {
+		streamBuffer = CGlBufferOwner<BT_Array, CTextVertex>();
+	}
+	streamBuffer.ReserveBuffer( newCapacity, BUH_StreamDraw );
+	// The mesh is recreated to pick up the index buffer with enough quads.
+	streamMesh = createTextMesh( streamBuffer, newCapacity );
+	streamBufferCapacity = newCapacity;
 }
 
 void CFontRenderer::initAsciiCharString( CUnicodeString& str )
@@ -814,6 +970,102 @@ if( result.a <= 0.0 ) {\
 gl_FragColor = result;\
 }";
 
+static const CStringView batchShaderName = "Batched text rendering shader";
+
+static const CStringView batchVertexShaderText = "#version 110\n \
+attribute vec2 position; \
+attribute vec2 texelOffset; \
+attribute vec4 vertexColor; \
+varying vec2 texCoord;	\
+varying vec4 color;	\
+uniform vec2 atlasSize; \
+uniform mat3 pixelToClip; \
+uniform float zOrder; \
+void main() {	\
+vec3 textScreenPos = pixelToClip * vec3( position, 1 ); \
+gl_Position = vec4( textScreenPos.xy, zOrder, 1 );	\
+texCoord = texelOffset / atlasSize;	\
+color = vertexColor;	\
+}";
+
+static const CStringView batchFragmentShaderText = "#version 110\n \
+varying vec2 texCoord;\
+varying vec4 color;\
+uniform sampler2D fontAtlas;\
+void main() {\
+vec4 result = vec4( 1, 1, 1, texture2D( fontAtlas, texCoord ).r ) * color;\
+if( result.a <= 0.0 ) {\
+	discard;\
+}\
+gl_FragColor = result;\
+}";
+
+static const CStringView distanceFieldShaderName = "Distance field text rendering shader";
+
+// Outline is at the middle of the value range. Screen space derivatives keep the edge one pixel wide at any scale.
+static const CStringView distanceFieldFragmentShaderText = "#version 110\n \
+varying vec2 texCoord;\
+uniform sampler2D fontAtlas;\
+uniform vec4 color;\
+void main() {\
+float distance = texture2D( fontAtlas, texCoord ).r;\
+float edgeWidth = max( 0.7 * fwidth( distance ), 0.001 );\
+vec4 result = vec4( 1, 1, 1, smoothstep( 0.5 - edgeWidth, 0.5 + edgeWidth, distance ) ) * color;\
+if( result.a <= 0.0 ) {\
+	discard;\
+}\
+gl_FragColor = result;\
+}";
+
+static const CStringView distanceFieldBatchShaderName = "Batched distance field text rendering shader";
+
+static const CStringView distanceFieldBatchFragmentShaderText = "#version 110\n \
+varying vec2 texCoord;\
+varying vec4 color;\
+uniform sampler2D fontAtlas;\
+void main() {\
+float distance = texture2D( fontAtlas, texCoord ).r;\
+float edgeWidth = max( 0.7 * fwidth( distance ), 0.001 );\
+vec4 result = vec4( 1, 1, 1, smoothstep( 0.5 - edgeWidth, 0.5 + edgeWidth, distance ) ) * color;\
+if( result.a <= 0.0 ) {\
+	discard;\
+}\
+gl_FragColor = result;\
+}";
+
+CShaderProgramOwner CFontRenderer::CFontShaderData::createBatchProgram()
+{
+	CVertexShader vertexShader;
+	vertexShader.CreateFromString( batchShaderName, batchVertexShaderText );
+	CFragmentShader fragmentShader;
+	fragmentShader.CreateFromString( batchShaderName, batchFragmentShaderText );
+
+	const CShaderLayoutInfo layoutInfo{ { "position", 0 }, { "texelOffset", 1 }, { "vertexColor", 2 } };
+	return CShaderProgramOwner( vertexShader, fragmentShader, layoutInfo );
+}
+
+CShaderProgramOwner CFontRenderer::CFontShaderData::createDistanceFieldProgram()
+{
+	CVertexShader vertexShader;
+	vertexShader.CreateFromString( distanceFieldShaderName, defaultVertexShaderText );
+	CFragmentShader fragmentShader;
+	fragmentShader.CreateFromString( distanceFieldShaderName, distanceFieldFragmentShaderText );
+
+	const CShaderLayoutInfo layoutInfo{ { "vertexData", 0 } };
+	return CShaderProgramOwner( vertexShader, fragmentShader, layoutInfo );
+}
+
+CShaderProgramOwner CFontRenderer::CFontShaderData::createDistanceFieldBatchProgram()
+{
+	CVertexShader vertexShader;
+	vertexShader.CreateFromString( distanceFieldBatchShaderName, batchVertexShaderText );
+	CFragmentShader fragmentShader;
+	fragmentShader.CreateFromString( distanceFieldBatchShaderName, distanceFieldBatchFragmentShaderText );
+
+	const CShaderLayoutInfo layoutInfo{ { "position", 0 }, { "texelOffset", 1 }, { "vertexColor", 2 } };
+	return CShaderProgramOwner( vertexShader, fragmentShader, layoutInfo );
+}
+
 CShaderProgramOwner CFontRenderer::CFontShaderData::createDefaultProgram()
 {
 	CVertexShader vertexShader;
@@ -830,8 +1082,12 @@ static const CStringView colorUniformName = "color";
 static const CStringView fontTextureName = "fontAtlas";
 static const CStringView modelToCliplName = "modelToClip";
 static const CStringView zOrderName = "zOrder";
+static const CStringView pixelToClipName = "pixelToClip";
 CFontRenderer::CFontShaderData::CFontShaderData() :
-	FontProgram( createDefaultProgram() )
+	FontProgram( createDefaultProgram() ),
+	BatchProgram( createBatchProgram() ),
+	DistanceFieldProgram( createDistanceFieldProgram() ),
+	DistanceFieldBatchProgram( createDistanceFieldBatchProgram() )
 {
 	FontColorUniform = FontProgram.GetUniform( colorUniformName );
 	AtlasSizeUniform = FontProgram.GetUniform( atlasUniformName );
@@ -839,6 +1095,22 @@ CFontRenderer::CFontShaderData::CFontShaderData() :
 	ModelToClipUniform = FontProgram.GetUniform( modelToCliplName );
 	ZOrderUniform = FontProgram.GetUniform( zOrderName );
 	CShaderProgramSwitcher swt{ FontProgram };
+
+	BatchAtlasSizeUniform = BatchProgram.GetUniform( atlasUniformName );
+	BatchFontUniform = BatchProgram.GetUniform( fontTextureName );
+	BatchPixelToClipUniform = BatchProgram.GetUniform( pixelToClipName );
+	BatchZOrderUniform = BatchProgram.GetUniform( zOrderName );
+
+	DistanceFieldColorUniform = DistanceFieldProgram.GetUniform( colorUniformName );
+	DistanceFieldAtlasSizeUniform = DistanceFieldProgram.GetUniform( atlasUniformName );
+	DistanceFieldFontUniform = DistanceFieldProgram.GetUniform( fontTextureName );
+	DistanceFieldModelToClipUniform = DistanceFieldProgram.GetUniform( modelToCliplName );
+	DistanceFieldZOrderUniform = DistanceFieldProgram.GetUniform( zOrderName );
+
+	DistanceFieldBatchAtlasSizeUniform = DistanceFieldBatchProgram.GetUniform( atlasUniformName );
+	DistanceFieldBatchFontUniform = DistanceFieldBatchProgram.GetUniform( fontTextureName );
+	DistanceFieldBatchPixelToClipUniform = DistanceFieldBatchProgram.GetUniform( pixelToClipName );
+	DistanceFieldBatchZOrderUniform = DistanceFieldBatchProgram.GetUniform( zOrderName );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,308 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <FrameCapture.h>
+#include <Engine.h>
+#include <PngEncoder.h>
+#include <BmpFile.h>
+#include <exception>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Writer of the frames to numbered image files.
+class CImageSequenceEncoder : public IImageEncoder {
+public:
+	explicit CImageSequenceEncoder( TFrameCaptureFormat _format ) : format( _format ) {}
+
+	virtual bool EncodeImage( const CImageEncodeJob& job ) override final;
+
+private:
+	TFrameCaptureFormat format;
+};
+
+bool CImageSequenceEncoder::EncodeImage( const CImageEncodeJob& job )
+{
+	if( format == FCF_Bmp ) {
+		// Pixels are read in the BGR order for this format.
+		CBmpFile bmpFile( job.FileName );
+		bmpFile.WriteImage( job.Pixels.Ptr(), job.Size, BPF_Rgb );
+	} else {
+		// Frames are already encoded in parallel, a single frame uses one thread.
+		CPngEncoder encoder;
+		const int scanLineWidth = -CeilTo( job.Size.X() * 3, sizeof( DWORD ) );
+		encoder.WriteFile( job.FileName, job.Pixels, TF_RGB, scanLineWidth, job.Size );
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Writer of the frames to a single YUV4MPEG2 stream.
+// Frames are converted in parallel and appended to the file in the order of the jobs.
+class CY4mStreamEncoder : public IImageEncoder {
+public:
+	CY4mStreamEncoder( CStringPart fileName, int frameRate );
+	~CY4mStreamEncoder();
+
+	virtual bool EncodeImage( const CImageEncodeJob& job ) override final;
+
+private:
+	CString fileName;
+	int frameRate;
+	// Protects the file and the turn of the jobs.
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE turnChanged;
+	// Stream file. Created with the first frame, when the stream size is known.
+	CPtrOwner<CFileWriter> file;
+	CVector2<int> frameSize;
+	// Index of the job that is written next.
+	int nextJobIndex = 0;
+
+	static void convertFrame( const CImageEncodeJob& job, CArray<BYTE>& result );
+	bool writeFrame( CVector2<int> size, const CArray<BYTE>& frame );
+
+	// Copying is prohibited.
+	CY4mStreamEncoder( CY4mStreamEncoder& ) = delete;
+	void operator=( CY4mStreamEncoder& ) = delete;
+};
+
+CY4mStreamEncoder::CY4mStreamEncoder( CStringPart _fileName, int _frameRate ) :
+	fileName( _fileName ),
+	frameRate( _frameRate )
+{
+	::InitializeCriticalSection( &lock );
+	::InitializeConditionVariable( &turnChanged );
+}
+
+CY4mStreamEncoder::~CY4mStreamEncoder()
+{
+	::DeleteCriticalSection( &lock );
+}
+
+bool CY4mStreamEncoder::EncodeImage( const CImageEncodeJob& job )
+{
+	CArray<BYTE> frame;
+	std::exception_ptr error;
+	try {
+		convertFrame( job, frame );
+	} catch( ... ) {
+		error = std::current_exception();
+	}
+
+	// The turn must pass to the next job even if this one fails, the following jobs wait for it.
+	bool isWritten = false;
+	::EnterCriticalSection( &lock );
+	while( job.Index != nextJobIndex ) {
+		::SleepConditionVariableCS( &turnChanged, &lock, INFINITE );
+	}
+	if( error == nullptr ) {
+		try {
+			isWritten = writeFrame( job.Size, frame );
+		} catch( ... ) {
+			error = std::current_exception();
+		}
+	}
+	nextJobIndex++;
+	::LeaveCriticalSection( &lock );
+	::WakeAllConditionVariable( &turnChanged );
+
+	if( error != nullptr ) {
+		std::rethrow_exception( error );
+	}
+	return isWritten;
+}
+
+static const CStringView y4mFrameHeader = "FRAME\n";
+// Convert bottom-up RGB rows to the planar BT.601 YCbCr frame with the header.
+void CY4mStreamEncoder::convertFrame( const CImageEncodeJob& job, CArray<BYTE>& result )
+{
+	const int width = job.Size.X();
+	const int height = job.Size.Y();
+	const int planeSize = width * height;
+	const int headerSize = y4mFrameHeader.Length();
+	result.IncreaseSizeNoInitialize( headerSize + 3 * planeSize );
+	memcpy( result.Ptr(), y4mFrameHeader.Ptr(), headerSize );
+
+	BYTE* yPlane = result.Ptr() + headerSize;
+	BYTE* uPlane = yPlane + planeSize;
+	BYTE* vPlane = uPlane + planeSize;
+	const int rowSize = CeilTo( width * 3, sizeof( DWORD ) );
+	for( int y = 0; y < height; y++ ) {
+		// The stream goes from the top to the bottom.
+		const BYTE* src = job.Pixels.Ptr() + ( height - 1 - y ) * rowSize;
+		const int destRowOffset = y * width;
+		for( int x = 0; x < width; x++ ) {
+			const int r = src[3 * x];
+			const int g = src[3 * x + 1];
+			const int b = src[3 * x + 2];
+			yPlane[destRowOffset + x] = static_cast<BYTE>( ( ( 66 * r + 129 * g + 25 * b + 128 ) >> 8 ) + 16 );
+			uPlane[destRowOffset + x] = static_cast<BYTE>( ( ( -38 * r - 74 * g + 112 * b + 128 ) >> 8 ) + 128 );
+			vPlane[destRowOffset + x] = static_cast<BYTE>( ( ( 112 * r - 94 * g - 18 * b + 128 ) >> 8 ) + 128 );
+		}
+	}
+}
+
+static const CStringView y4mStreamHeader = "YUV4MPEG2 W%0 H%1 F%2:1 Ip A1:1 C444\n";
+bool CY4mStreamEncoder::writeFrame( CVector2<int> size, const CArray<BYTE>& frame )
+{
+	if( file == nullptr ) {
+		file = CreateOwner<CFileWriter>( fileName, FCM_CreateAlways );
+		frameSize = size;
+		const auto header = y4mStreamHeader.SubstParam( size.X(), size.Y(), frameRate );
+		file->Write( header.Ptr(), header.Length() );
+	} else if( size != frameSize ) {
+		// The stream can't change its size.
+		return false;
+	}
+
+	file->Write( frame.Ptr(), frame.Size() );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CCaptureFrameWriter::CCaptureFrameWriter( const CFrameCaptureSettings& _settings, int frameRate, IImageEncoder* customEncoder ) :
+	settings( _settings ),
+	formatEncoder( createEncoder( settings, frameRate ) ),
+	encodeQueue( settings.EncoderCount, settings.MaxQueuedFrameCount, customEncoder != nullptr ? customEncoder : static_cast<IImageEncoder*>( formatEncoder ) )
+{
+	if( settings.Format != FCF_Y4m && !FileSystem::DirAccessible( settings.Path ) ) {
+		FileSystem::CreateDir( settings.Path );
+	}
+}
+
+CPtrOwner<IImageEncoder> CCaptureFrameWriter::createEncoder( const CFrameCaptureSettings& captureSettings, int frameRate )
+{
+	if( captureSettings.Format == FCF_Y4m ) {
+		return CreateOwner<CY4mStreamEncoder>( captureSettings.Path, frameRate );
+	}
+	return CreateOwner<CImageSequenceEncoder>( captureSettings.Format );
+}
+
+bool CCaptureFrameWriter::AddFrame( int frameIndex, CArrayView<BYTE> pixels, CVector2<int> size )
+{
+	CImageEncodeJob job;
+	job.FileName = GetFrameFileName( frameIndex );
+	job.Pixels.IncreaseSizeNoInitialize( pixels.Size() );
+	memcpy( job.Pixels.Ptr(), pixels.Ptr(), pixels.Size() );
+	job.Size = size;
+
+	if( settings.OverflowMode == COM_Wait ) {
+		encodeQueue.AddJob( move( job ) );
+		return true;
+	}
+	return encodeQueue.TryAddJob( job );
+}
+
+// Frame indices are padded with zeros, so that the files are sorted in the frame order and match the Frame%06d pattern of the sequence readers.
+static const int frameIndexWidth = 6;
+static const CStringView frameNameTemplate = "Frame%0%1";
+static const CStringView pngExt = ".png";
+static const CStringView bmpExt = ".bmp";
+CString CCaptureFrameWriter::GetFrameFileName( int frameIndex ) const
+{
+	assert( frameIndex >= 0 );
+	if( settings.Format == FCF_Y4m ) {
+		return CString();
+	}
+	const auto indexStr = Str( frameIndex );
+	CString paddedIndex;
+	for( int i = indexStr.Length(); i < frameIndexWidth; i++ ) {
+		paddedIndex += "0";
+	}
+	paddedIndex += indexStr;
+	const auto ext = settings.Format == FCF_Bmp ? bmpExt : pngExt;
+	return FileSystem::MergePath( settings.Path, frameNameTemplate.SubstParam( paddedIndex, ext ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static long long getCurrentTicks()
+{
+	LARGE_INTEGER count;
+	::QueryPerformanceCounter( &count );
+	return count.QuadPart;
+}
+
+CFrameCapture::CFrameCapture( CFixedStepEngine& _engine, CFrameCaptureSettings _settings ) :
+	engine( _engine ),
+	settings( move( _settings ) ),
+	frameWriter( settings, engine.GetMaxFPS() ),
+	readbackQueue( settings.ReadbackBufferCount ),
+	startTime( getCurrentTicks() )
+{
+	engine.SetCaptureMode( true );
+}
+
+CFrameCapture::~CFrameCapture()
+{
+	Finish();
+}
+
+CFrameCaptureReport CFrameCapture::GetReport() const
+{
+	const auto encodeStatistics = frameWriter.GetStatistics();
+	CFrameCaptureReport report;
+	report.FrameCount = frameCount;
+	report.DroppedFrameCount = droppedFrameCount;
+	report.LostFrameCount = lostFrameCount;
+	report.WrittenFrameCount = encodeStatistics.WrittenCount;
+	report.FailedFrameCount = encodeStatistics.FailedCount;
+	report.ReadbackStallCount = readbackQueue.GetStatistics().StallCount;
+	report.EncodeTime = encodeStatistics.EncodeTime;
+	report.WrittenPixelCount = encodeStatistics.WrittenPixelCount;
+
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency( &frequency );
+	const auto endTime = isFinished ? finishTime : getCurrentTicks();
+	report.Duration = static_cast<double>( endTime - startTime ) / frequency.QuadPart;
+	return report;
+}
+
+void CFrameCapture::CaptureFrame()
+{
+	assert( !isFinished );
+	const int frameIndex = frameCount++;
+	const TTexelFormat readFormat = settings.Format == FCF_Bmp ? TF_BGR : TF_RGB;
+	if( !readbackQueue.ReadScreenBuffer( readFormat, this, frameIndex ) ) {
+		if( settings.OverflowMode == COM_Drop ) {
+			droppedFrameCount++;
+		} else {
+			// All the buffers are free after the flush.
+			readbackQueue.Flush();
+			readbackQueue.ReadScreenBuffer( readFormat, this, frameIndex );
+		}
+	}
+	readbackQueue.Update();
+}
+
+CFrameCaptureReport CFrameCapture::Finish()
+{
+	if( !isFinished ) {
+		readbackQueue.Flush();
+		frameWriter.Flush();
+		engine.SetCaptureMode( false );
+		finishTime = getCurrentTicks();
+		isFinished = true;
+	}
+	return GetReport();
+}
+
+void CFrameCapture::OnReadbackComplete( int readbackId, CArrayView<BYTE> pixels, CVector2<int> size )
+{
+	if( !frameWriter.AddFrame( readbackId, pixels, size ) ) {
+		droppedFrameCount++;
+	}
+}
+
+void CFrameCapture::OnReadbackLost( int )
+{
+	lostFrameCount++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -8,12 +8,51 @@ namespace Gin {
 
 //////////////////////////////////////////////////////////////////////////
 
-CFreeTypeGlyphProvider::CFreeTypeGlyphProvider( CFontView font, int fontPxHeight ) :
+CFreeTypeGlyphProvider::CFreeTypeGlyphProvider( CFontView font, int _fontPxHeight ) :
 	fontView( font ),
-	fontSize( font.CreateSizeObject( fontPxHeight ) )
+	fontSize( font.CreateSizeObject( _fontPxHeight ) ),
+	fontPxHeight( _fontPxHeight )
 {
 }
 
+CFreeTypeGlyphProvider::CFreeTypeGlyphProvider( CFontOwner&& face, int _fontPxHeight ) :
+	ownFace( move( face ) ),
+	fontView( ownFace.View() ),
+	fontSize( fontView.CreateSizeObject( _fontPxHeight ) ),
+	fontPxHeight( _fontPxHeight )
+{
+}
+
+CGlyphData CFreeTypeGlyphProvider::RenderGlyphByIndex( unsigned index ) const
+{
+	return fontView.RenderGlyphByIndex( index, fontSize );
+}
+
+int CFreeTypeGlyphProvider::GetKerningByIndex( unsigned leftIndex, unsigned rightIndex ) const
+{
+	return fontView.GetKerning( leftIndex, rightIndex, fontSize );
+}
+
+CFreeTypeGlyphProvider CFreeTypeGlyphProvider::CreateFaceCopy() const
+{
+	return CFreeTypeGlyphProvider( fontView.CreateFaceCopy(), fontPxHeight );
+}
+
+bool CFreeTypeGlyphProvider::HasKerning() const
+{
+	return fontView.HasKerning();
+}
+
+int CFreeTypeGlyphProvider::GetKerning( int leftUtf32, int rightUtf32 ) const
+{
+	return HasKerning() ? GetKerningByIndex( GetGlyphIndex( leftUtf32 ), GetGlyphIndex( rightUtf32 ) ) : 0;
+}
+
+CPtrOwner<IGlyphProvider> CFreeTypeGlyphProvider::CreateWorkerCopy() const
+{
+	return CreateOwner<CFreeTypeGlyphProvider>( CreateFaceCopy() );
+}
+
 unsigned CFreeTypeGlyphProvider::GetGlyphIndex( int utf32 ) const
 {
 	return fontView.GetGlyphIndex( utf32 );
@@ -29,6 +68,13 @@ CPtrOwner<IGlyph> CFreeTypeGlyphProvider::GetGlyph( int utf32 ) const
 	return CreateOwner<CGlyph>( fontView.GetGlyph( utf32, fontSize ) );
 }
 
+void CFreeTypeGlyphProvider::GetGlyphs( CArrayView<unsigned> utf32Codes, CGlyphBatch& result ) const
+{
+	for( auto code : utf32Codes ) {
+		result.AddGlyph( RenderGlyphByIndex( GetGlyphIndex( code ) ) );
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 }	// namespace Gin.
@@ -0,0 +1,230 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <GifFile.h>
+#include <gifdec.h>
+#include <exception>
+
+namespace Gin {
+
+const CStringView CGifException::generalGifError = "GIF parsing error: %1.\nFile name: %0.";
+//////////////////////////////////////////////////////////////////////////
+
+int CGifFrameSequence::GetDuration() const
+{
+	int result = 0;
+	for( auto delay : FrameDelays ) {
+		result += delay;
+	}
+	return result;
+}
+
+int CGifFrameSequence::FindFrame( int time ) const
+{
+	assert( time >= 0 );
+	const int duration = GetDuration();
+	if( duration == 0 ) {
+		return 0;
+	}
+	int frameTime = time % duration;
+	for( int i = 0; i < FrameDelays.Size(); i++ ) {
+		if( frameTime < FrameDelays[i] ) {
+			return i;
+		}
+		frameTime -= FrameDelays[i];
+	}
+	assert( false );
+	return FrameDelays.Size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Size of an RGBA pixel in bytes.
+static const int gifPixelSize = 4;
+// Number of entries in a GIF palette.
+static const int gifPaletteSize = 0x100;
+
+// Expand the palette to RGBA colors.
+static void fillPaletteColors( const GinInternal::CGifPalette& palette, BYTE* result )
+{
+	for( int i = 0; i < gifPaletteSize; i++ ) {
+		::memcpy( result + gifPixelSize * i, palette.colors + 3 * i, 3 );
+		result[gifPixelSize * i + 3] = 255;
+	}
+}
+
+static void renderFrameRect( const GinInternal::CGiffDecodeData& gif, const BYTE* colors, BYTE* canvas )
+{
+	const bool hasTransparency = gif.gce.transparency != 0;
+	for( int y = 0; y < gif.fh; y++ ) {
+		const int rowPos = ( gif.fy + y ) * gif.width + gif.fx;
+		const BYTE* indices = gif.frame + rowPos;
+		BYTE* row = canvas + gifPixelSize * rowPos;
+		for( int x = 0; x < gif.fw; x++ ) {
+			const BYTE index = indices[x];
+			if( !hasTransparency || index != gif.gce.tindex ) {
+				::memcpy( row + gifPixelSize * x, colors + gifPixelSize * index, gifPixelSize );
+			}
+		}
+	}
+}
+
+static void clearFrameRect( const GinInternal::CGiffDecodeData& gif, BYTE* canvas )
+{
+	for( int y = 0; y < gif.fh; y++ ) {
+		BYTE* row = canvas + gifPixelSize * ( ( gif.fy + y ) * gif.width + gif.fx );
+		for( int x = 0; x < gif.fw; x++ ) {
+			row[gifPixelSize * x + 3] = 0;
+		}
+	}
+}
+
+// Apply the disposal method of the current frame to the canvas. Disposal methods are handled the same way as in gd_get_frame.
+static void disposeFrame( const GinInternal::CGiffDecodeData& gif, const BYTE* colors, BYTE* canvas )
+{
+	switch( gif.gce.disposal ) {
+	case 1:
+		renderFrameRect( gif, colors, canvas );
+		break;
+	case 2:
+		// The background is assumed to be transparent.
+		clearFrameRect( gif, canvas );
+		break;
+	default:
+		break;
+	}
+}
+
+CGifFile::CGifFile( CStringPart _fileName ) :
+	fileName( _fileName )
+{
+}
+
+CGifFrameSequence CGifFile::CreateFrameSequence( bool topLeftOrigin ) const
+{
+	const CArray<BYTE> fileData = readFileBuffer();
+	try {
+		auto gif = GinInternal::gd_open_gif( GinInternal::CGiffBuffer{ fileData, 0 } );
+		const int frameSize = gifPixelSize * gif.width * gif.height;
+		CArray<BYTE> canvas;
+		canvas.IncreaseSize( frameSize );
+		BYTE colors[gifPixelSize * gifPaletteSize];
+		// Frames are composed one after another into a single buffer and copied to the image when their count is known.
+		CArray<BYTE> frameData;
+		CArray<int> frameDelays;
+		for( ;; ) {
+			const int frameStatus = GinInternal::gd_read_frame( &gif );
+			if( frameStatus == 0 ) {
+				break;
+			}
+			if( frameStatus < 0 ) {
+				throw CGifException( fileName, "unknown block" );
+			}
+
+			fillPaletteColors( *gif.palette, colors );
+			const int framePos = frameData.Size();
+			frameData.IncreaseSizeNoInitialize( framePos + frameSize );
+			::memcpy( frameData.Ptr() + framePos, canvas.Ptr(), frameSize );
+			renderFrameRect( gif, colors, frameData.Ptr() + framePos );
+			disposeFrame( gif, colors, canvas.Ptr() );
+			// Delays are stored in hundredths of a second.
+			frameDelays.Add( 10 * gif.gce.delay );
+		}
+		if( frameDelays.IsEmpty() ) {
+			throw CGifException( fileName, "no frames found" );
+		}
+
+		CImageData frames( TT_Texture2D, gif.width, gif.height, 1, TF_RGBA, TDT_UnsignedByte, 1, frameDelays.Size() );
+		for( int i = 0; i < frameDelays.Size(); i++ ) {
+			frames.SetImageData( 0, i, 0, frameData.Ptr() + i * frameSize, topLeftOrigin );
+		}
+		return CGifFrameSequence( move( frames ), move( frameDelays ) );
+	} catch( const GinInternal::CGifInternalException& e ) {
+		throw CGifException( fileName, e.GetMessageText() );
+	}
+}
+
+CArray<BYTE> CGifFile::readFileBuffer() const
+{
+	CFileReader gifFile( fileName, FCM_OpenExisting );
+	const int length = gifFile.GetLength32();
+
+	CArray<BYTE> buffer;
+	buffer.IncreaseSizeNoInitialize( length );
+	gifFile.Read( buffer.Ptr(), length );
+	return move( buffer );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+struct CGifFrameLoader::CLoadTask {
+	CGifFile File;
+	bool HasTopLeftOrigin;
+	CPtrOwner<CGifFrameSequence> Result;
+	// Exception thrown by the decoder.
+	std::exception_ptr Error;
+	volatile LONG IsComplete = 0;
+
+	CLoadTask( CStringPart fileName, bool hasTopLeftOrigin ) : File( fileName ), HasTopLeftOrigin( hasTopLeftOrigin ) {}
+};
+
+CGifFrameLoader::CGifFrameLoader( CStringPart fileName, bool topLeftOrigin ) :
+	task( CreateOwner<CLoadTask>( fileName, topLeftOrigin ) )
+{
+	thread = ::CreateThread( nullptr, 0, loadProc, task, 0, nullptr );
+	if( thread == nullptr ) {
+		// The file is decoded on the calling thread instead.
+		runLoadTask( *task );
+	}
+}
+
+CGifFrameLoader::~CGifFrameLoader()
+{
+	waitForCompletion();
+}
+
+bool CGifFrameLoader::IsComplete() const
+{
+	return task->IsComplete != 0;
+}
+
+CGifFrameSequence CGifFrameLoader::TakeResult()
+{
+	waitForCompletion();
+	if( task->Error != nullptr ) {
+		std::rethrow_exception( task->Error );
+	}
+	assert( task->Result != nullptr );
+	auto result = move( task->Result );
+	return move( *result );
+}
+
+void CGifFrameLoader::waitForCompletion()
+{
+	if( thread != nullptr ) {
+		::WaitForSingleObject( thread, INFINITE );
+		::CloseHandle( thread );
+		thread = nullptr;
+	}
+}
+
+void CGifFrameLoader::runLoadTask( CLoadTask& loadTask )
+{
+	try {
+		loadTask.Result = CreateOwner<CGifFrameSequence>( loadTask.File.CreateFrameSequence( loadTask.HasTopLeftOrigin ) );
+	} catch( ... ) {
+		loadTask.Error = std::current_exception();
+	}
+	::InterlockedExchange( &loadTask.IsComplete, 1 );
+}
+
+DWORD WINAPI CGifFrameLoader::loadProc( void* param )
+{
+	runLoadTask( *static_cast<CLoadTask*>( param ) );
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
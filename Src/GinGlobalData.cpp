@@ -23,6 +23,11 @@ CMap<CStringView, TGinVirtualKey, CCaselessStringHash> CInputSettings::keyNameTo
 
 extern const CError Err_GeneralGlError{ "General OpenGL error! Error code: %0." };
 extern const CError Err_InvalidDxtImageHeight{ "Compressed DXT texture height must be a multiple of 4.\nFile name: %0" };
+extern const CError Err_FileMappingFailed{ "Failed to map the file into memory. Error code: %1.\nFile name: %0" };
+extern const CError Err_TruncatedImageData{ "Image data exceeds the size of the file.\nFile name: %0" };
+extern const CError Err_NonContiguousMappedLevels{ "Texture arrays and cubemaps with mipmaps cannot be mapped, their levels are not contiguous in the file.\nFile name: %0" };
+extern const CError Err_TextExtentExceeded{ "Text layout is too large. Glyph positions must be within %0 pixels from the text origin." };
+extern const CError Err_GlyphAtlasFull{ "Glyph atlas is full. Glyphs must fit in %0 atlas rows." };
 const CStringView CDdsException::generalDdsFileError = "DDS parsing error: %1.\nFile name: %0";
 extern const CStringView GeneralFreeTypeError = "FreeType error. Error code: %0.\nFreeType module name: %1.";
 
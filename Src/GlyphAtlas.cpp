@@ -0,0 +1,235 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <GlyphAtlas.h>
+#include <GlyphProvider.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+void CGlyphAtlas::ClearDirtyRegion()
+{
+	dirtyStart = CVector2<int>{};
+	dirtyEnd = CVector2<int>{};
+}
+
+CGlyphAtlasUpload CGlyphAtlas::TakeUpload( CVector2<int> textureSize )
+{
+	CGlyphAtlasUpload result;
+	if( textureSize.X() != capacity.X() || textureSize.Y() != capacity.Y() ) {
+		// The storage is recreated from the CPU copy, old texture contents are never read back.
+		result.Size = capacity;
+		result.IsReallocation = true;
+		statistics.ReallocationCount++;
+	} else if( HasDirtyRegion() ) {
+		result.Offset = dirtyStart;
+		result.Size = CVector2<int>{ dirtyEnd.X() - dirtyStart.X(), dirtyEnd.Y() - dirtyStart.Y() };
+	}
+	if( !result.IsEmpty() ) {
+		statistics.UploadCount++;
+		statistics.UploadedByteCount += result.Size.X() * result.Size.Y();
+	}
+	ClearDirtyRegion();
+	return result;
+}
+
+CAtlasGlyph CGlyphAtlas::AddGlyph( const IGlyphProvider& provider, unsigned glyphCode )
+{
+	singleGlyphBatch.Empty();
+	provider.GetGlyphs( CArrayView<unsigned>( &glyphCode, 1 ), singleGlyphBatch );
+	const auto glyphData = singleGlyphBatch.GetGlyphData( 0 );
+
+	const auto newState = fitGlyph( packingState, glyphData.SizeData.Size );
+	const CVector2<int> glyphOffset{ newState.Offset.X() - glyphData.SizeData.Size.X(), newState.Offset.Y() };
+	setPackingState( newState );
+	stageGlyphBitmap( glyphOffset, glyphData );
+	return CAtlasGlyph{ glyphData.SizeData, glyphOffset };
+}
+
+void CGlyphAtlas::AddGlyphs( const IGlyphProvider& provider, CArrayView<unsigned> glyphCodes, int workerCount, CArrayBuffer<CAtlasGlyph> result )
+{
+	assert( workerCount > 0 );
+	assert( result.Size() == glyphCodes.Size() );
+	if( glyphCodes.IsEmpty() ) {
+		return;
+	}
+
+	CArray<CGlyphBatch> taskBatches;
+	rasterizeGlyphs( provider, glyphCodes, workerCount, taskBatches );
+	CArray<CGlyphData> glyphs;
+	glyphs.ReserveBuffer( glyphCodes.Size() );
+	for( const auto& batch : taskBatches ) {
+		for( int i = 0; i < batch.Size(); i++ ) {
+			glyphs.Add( batch.GetGlyphData( i ) );
+		}
+	}
+
+	// Glyphs of similar height share the atlas rows.
+	CArray<int> order;
+	sortGlyphsByHeight( glyphs, order );
+	// New glyphs start from a new row, so the updated region contains no old glyphs.
+	auto currentState = packingState;
+	if( currentState.LineHeight > 0 ) {
+		currentState.Offset.X() = MaxWidth;
+	}
+	for( auto glyphPos : order ) {
+		const auto sizeData = glyphs[glyphPos].SizeData;
+		currentState = fitGlyph( currentState, sizeData.Size );
+		const CVector2<int> glyphOffset{ currentState.Offset.X() - sizeData.Size.X(), currentState.Offset.Y() };
+		result[glyphPos] = CAtlasGlyph{ sizeData, glyphOffset };
+	}
+
+	setPackingState( currentState );
+	for( int i = 0; i < glyphs.Size(); i++ ) {
+		stageGlyphBitmap( result[i].Offset, glyphs[i] );
+	}
+}
+
+// Number of glyphs that are rasterized by a single task.
+static const int glyphTaskSize = 16;
+void CGlyphAtlas::rasterizeGlyphs( const IGlyphProvider& provider, CArrayView<unsigned> glyphCodes, int workerCount, CArray<CGlyphBatch>& taskBatches )
+{
+	const auto taskCount = ( glyphCodes.Size() + glyphTaskSize - 1 ) / glyphTaskSize;
+	// Each task writes its glyphs into a separate batch.
+	taskBatches.IncreaseSize( taskCount );
+	// The calling thread is the first worker and uses the given provider.
+	CArray<CPtrOwner<IGlyphProvider>> workerProviders;
+	const auto copyCount = min( workerCount, taskCount ) - 1;
+	for( int i = 0; i < copyCount; i++ ) {
+		auto workerProvider = provider.CreateWorkerCopy();
+		if( workerProvider == nullptr ) {
+			break;
+		}
+		workerProviders.Add( move( workerProvider ) );
+	}
+
+	auto rasterizeTask = [&]( int workerIndex, int taskIndex ) {
+		const auto& taskProvider = workerIndex == 0 ? provider : *workerProviders[workerIndex - 1];
+		const auto taskStart = taskIndex * glyphTaskSize;
+		const auto taskSize = min( glyphCodes.Size() - taskStart, glyphTaskSize );
+		taskProvider.GetGlyphs( CArrayView<unsigned>( glyphCodes.Ptr() + taskStart, taskSize ), taskBatches[taskIndex] );
+	};
+	ParallelFor( taskCount, workerProviders.Size() + 1, rasterizeTask );
+}
+
+// Order the glyphs from the tallest to the shortest. Glyph heights are small, so a counting sort is used.
+void CGlyphAtlas::sortGlyphsByHeight( CArrayView<CGlyphData> glyphs, CArray<int>& order )
+{
+	int maxHeight = 0;
+	for( const auto& glyph : glyphs ) {
+		maxHeight = max( maxHeight, glyph.SizeData.Size.Y() );
+	}
+	CArray<int> heightPositions;
+	heightPositions.IncreaseSize( maxHeight + 2 );
+	for( const auto& glyph : glyphs ) {
+		heightPositions[maxHeight - glyph.SizeData.Size.Y() + 1]++;
+	}
+	for( int i = 1; i < heightPositions.Size(); i++ ) {
+		heightPositions[i] += heightPositions[i - 1];
+	}
+	order.IncreaseSize( glyphs.Size() );
+	for( int i = 0; i < glyphs.Size(); i++ ) {
+		const auto heightIndex = maxHeight - glyphs[i].SizeData.Size.Y();
+		order[heightPositions[heightIndex]++] = i;
+	}
+}
+
+CGlyphAtlas::CPackingState CGlyphAtlas::fitGlyph( CPackingState state, CVector2<int> glyphSize )
+{
+	const CVector2<int> glyphRealSize{ glyphSize.X() + GlyphPadding, glyphSize.Y() + GlyphPadding };
+	const auto newHOffset = state.Offset.X() + glyphRealSize.X();
+	if( newHOffset <= MaxWidth ) {
+		const auto lineHeightDelta = max( 0, glyphRealSize.Y() - state.LineHeight );
+		const auto newLineHeight = state.LineHeight + lineHeightDelta;
+		const auto newWidth = max( state.Size.X(), newHOffset );
+		const auto newHeight = state.Size.Y() + lineHeightDelta;
+		const CVector2<int> newSize{ newWidth, newHeight };
+		const CVector2<int> newOffset{ newHOffset, state.Offset.Y() };
+		return CPackingState{ newSize, newOffset, newLineHeight };
+	}
+	const auto newVOffset = state.Offset.Y() + state.LineHeight;
+	const auto newLineHeight = glyphRealSize.Y();
+	const auto newWidth = max( state.Size.X(), glyphRealSize.X() );
+	const auto newHeight = state.Size.Y() + newLineHeight;
+	const CVector2<int> newSize{ newWidth, newHeight };
+	const CVector2<int> newOffset{ glyphRealSize.X(), newVOffset };
+	return CPackingState{ newSize, newOffset, newLineHeight };
+}
+
+void CGlyphAtlas::setPackingState( CPackingState newState )
+{
+	const auto newSize = newState.Size;
+	if( newSize.X() > capacity.X() || newSize.Y() > capacity.Y() ) {
+		grow( newSize );
+	}
+	packingState = newState;
+}
+
+extern const CError Err_GlyphAtlasFull;
+// Initial height of the atlas. The height is doubled each time the atlas is full.
+static const int initialAtlasHeight = 64;
+void CGlyphAtlas::grow( CVector2<int> requiredSize )
+{
+	check( requiredSize.Y() <= MaxHeight, Err_GlyphAtlasFull, MaxHeight );
+	const auto newWidth = max( max( requiredSize.X(), capacity.X() ), MaxWidth );
+	const auto newHeight = min( max( requiredSize.Y(), max( initialAtlasHeight, capacity.Y() * 2 ) ), MaxHeight );
+	if( newWidth == capacity.X() ) {
+		// Rows keep their positions, new rows are zero initialized.
+		pixels.IncreaseSize( newWidth * newHeight );
+	} else {
+		CArray<BYTE> newPixels;
+		newPixels.IncreaseSize( newWidth * newHeight );
+		for( int y = 0; y < capacity.Y(); y++ ) {
+			memcpy( newPixels.Ptr() + y * newWidth, pixels.Ptr() + y * capacity.X(), capacity.X() );
+		}
+		pixels = move( newPixels );
+	}
+	capacity = CVector2<int>{ newWidth, newHeight };
+}
+
+// Copy the glyph bitmap to the atlas. The padding to the right and below the glyph is cleared.
+void CGlyphAtlas::stageGlyphBitmap( CVector2<int> atlasOffset, CGlyphData glyph )
+{
+	// Negative pitch is not supported. At least until a single font with negative pitch is found.
+	assert( glyph.SizeData.Pitch >= 0 );
+	const auto glyphSize = glyph.SizeData.Size;
+	const auto rowStride = capacity.X();
+	const CVector2<int> cellEnd{ min( atlasOffset.X() + glyphSize.X() + GlyphPadding, capacity.X() ),
+		min( atlasOffset.Y() + glyphSize.Y() + GlyphPadding, capacity.Y() ) };
+	const auto cellWidth = cellEnd.X() - atlasOffset.X();
+	for( int y = 0; y < glyphSize.Y(); y++ ) {
+		BYTE* atlasRow = pixels.Ptr() + ( atlasOffset.Y() + y ) * rowStride + atlasOffset.X();
+		memcpy( atlasRow, glyph.BitmapData + y * glyph.SizeData.Pitch, glyphSize.X() );
+		memset( atlasRow + glyphSize.X(), 0, cellWidth - glyphSize.X() );
+	}
+	for( int y = atlasOffset.Y() + glyphSize.Y(); y < cellEnd.Y(); y++ ) {
+		memset( pixels.Ptr() + y * rowStride + atlasOffset.X(), 0, cellWidth );
+	}
+	markDirty( atlasOffset, cellEnd );
+}
+
+void CGlyphAtlas::markDirty( CVector2<int> start, CVector2<int> end )
+{
+	if( !HasDirtyRegion() ) {
+		dirtyStart = start;
+		dirtyEnd = end;
+		return;
+	}
+	dirtyStart = CVector2<int>{ min( dirtyStart.X(), start.X() ), min( dirtyStart.Y(), start.Y() ) };
+	dirtyEnd = CVector2<int>{ max( dirtyEnd.X(), end.X() ), max( dirtyEnd.Y(), end.Y() ) };
+}
+
+void CGlyphAtlas::FreeBuffer()
+{
+	packingState = CPackingState{};
+	pixels.FreeBuffer();
+	capacity = CVector2<int>{};
+	ClearDirtyRegion();
+	singleGlyphBatch.FreeBuffer();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
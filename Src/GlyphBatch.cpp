@@ -0,0 +1,64 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <GlyphBatch.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CGlyphData CGlyphBatch::GetGlyphData( int index ) const
+{
+	const auto& glyph = glyphs[index];
+	return CGlyphData{ glyph.SizeData, bitmaps.Ptr() + glyph.BitmapOffset };
+}
+
+int CGlyphBatch::AddGlyph( CGlyphData glyphData )
+{
+	// Negative pitch is not supported, same as in the font renderer.
+	assert( glyphData.SizeData.Pitch >= 0 );
+	const auto srcPitch = glyphData.SizeData.Pitch;
+	const auto bitmap = AddGlyphBitmap( glyphData.SizeData );
+	const auto rowLength = glyphData.SizeData.Size.X();
+	if( rowLength == srcPitch ) {
+		if( bitmap.Size() > 0 ) {
+			memcpy( bitmap.Ptr(), glyphData.BitmapData, bitmap.Size() );
+		}
+	} else {
+		for( int y = 0; y < glyphData.SizeData.Size.Y(); y++ ) {
+			memcpy( bitmap.Ptr() + y * rowLength, glyphData.BitmapData + y * srcPitch, rowLength );
+		}
+	}
+	return glyphs.Size() - 1;
+}
+
+CArrayBuffer<BYTE> CGlyphBatch::AddGlyphBitmap( CGlyphSizeData sizeData )
+{
+	sizeData.Pitch = sizeData.Size.X();
+	const auto bitmapOffset = bitmaps.Size();
+	const auto bitmapSize = sizeData.Size.X() * sizeData.Size.Y();
+	bitmaps.IncreaseSizeNoInitialize( bitmapOffset + bitmapSize );
+
+	CBatchGlyph newGlyph;
+	newGlyph.SizeData = sizeData;
+	newGlyph.BitmapOffset = bitmapOffset;
+	glyphs.Add( newGlyph );
+	return CArrayBuffer<BYTE>( bitmaps.Ptr() + bitmapOffset, bitmapSize );
+}
+
+void CGlyphBatch::Empty()
+{
+	glyphs.Empty();
+	bitmaps.Empty();
+}
+
+void CGlyphBatch::FreeBuffer()
+{
+	glyphs.FreeBuffer();
+	bitmaps.FreeBuffer();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,336 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <GlyphCache.h>
+#include <GlyphProvider.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+void CGlyphCache::SetGlyphProvider( CPtrOwner<IGlyphProvider> newValue )
+{
+	glyphProvider = move( newValue );
+	latinGlyphData.FreeBuffer();
+	glyphData.FreeBuffer();
+	atlas.FreeBuffer();
+	kerningPairs.Empty();
+	kernedGlyphs.Empty();
+	shapingCachePolicy.Empty();
+	shapedLines.Empty();
+}
+
+void CGlyphCache::LoadGlyphs( CUnicodePart str, int workerCount )
+{
+	assert( IsFontLoaded() );
+	CArray<unsigned> glyphCodes;
+	reserveNewGlyphs( str, glyphCodes );
+	if( glyphCodes.IsEmpty() ) {
+		return;
+	}
+
+	CArray<CAtlasGlyph> atlasGlyphs;
+	atlasGlyphs.IncreaseSize( glyphCodes.Size() );
+	try {
+		atlas.AddGlyphs( *glyphProvider, glyphCodes, workerCount, atlasGlyphs );
+	} catch( ... ) {
+		for( auto glyphCode : glyphCodes ) {
+			getRenderDataEntry( glyphCode ) = CRenderGlyphData();
+		}
+		throw;
+	}
+
+	for( int i = 0; i < glyphCodes.Size(); i++ ) {
+		getRenderDataEntry( glyphCodes[i] ) = CRenderGlyphData( atlasGlyphs[i].SizeData, atlasGlyphs[i].Offset );
+	}
+	for( auto glyphCode : glyphCodes ) {
+		addKerningPairs( glyphCode );
+	}
+}
+
+// Find the glyphs that are not in the atlas. Their entries are reserved to skip duplicate characters.
+void CGlyphCache::reserveNewGlyphs( CUnicodePart str, CArray<unsigned>& glyphCodes )
+{
+	const auto strLength = str.Length();
+	for( int i = 0; i < strLength; ) {
+		const auto glyphCode = ParseCharacter( str, i );
+		auto& glyphEntry = getRenderDataEntry( glyphCode );
+		if( glyphEntry.GlyphOffset.X() != NotFound ) {
+			continue;
+		}
+		glyphEntry.GlyphOffset = CVector2<int>{};
+		glyphCodes.Add( glyphCode );
+	}
+}
+
+CRenderGlyphData CGlyphCache::GetRenderData( unsigned glyphCode )
+{
+	auto& charData = getRenderDataEntry( glyphCode );
+	if( charData.GlyphOffset.X() == NotFound ) {
+		addGlyphToAtlas( glyphCode, charData );
+	}
+	return charData;
+}
+
+// Find the glyph data storage for the given code. Missing glyphs have an invalid atlas offset.
+CRenderGlyphData& CGlyphCache::getRenderDataEntry( unsigned glyphCode )
+{
+	if( glyphCode < LatinSymbolCount ) {
+		if( latinGlyphData.IsEmpty() ) {
+			latinGlyphData.IncreaseSize( LatinSymbolCount );
+		}
+		return latinGlyphData[glyphCode];
+	}
+	return glyphData.GetOrCreate( glyphCode ).Value();
+}
+
+// Rasterize the given character into the atlas and fill the result glyph data structure.
+void CGlyphCache::addGlyphToAtlas( unsigned glyphCode, CRenderGlyphData& result )
+{
+	assert( IsFontLoaded() );
+	const auto atlasGlyph = atlas.AddGlyph( *glyphProvider, glyphCode );
+	result.GlyphData = atlasGlyph.SizeData;
+	result.GlyphOffset = atlasGlyph.Offset;
+	addKerningPairs( glyphCode );
+}
+
+int CGlyphCache::GetKerning( unsigned leftCode, unsigned rightCode )
+{
+	if( leftCode >= LatinSymbolCount || rightCode >= LatinSymbolCount ) {
+		return 0;
+	}
+	// Pairs are computed when the glyphs are added to the atlas.
+	GetRenderData( leftCode );
+	GetRenderData( rightCode );
+	const auto kerning = kerningPairs.Get( leftCode * LatinSymbolCount + rightCode );
+	return kerning != nullptr ? *kerning : 0;
+}
+
+// Compute the kerning between a new glyph and all the Latin glyphs in the atlas.
+void CGlyphCache::addKerningPairs( unsigned glyphCode )
+{
+	if( glyphCode >= LatinSymbolCount || !glyphProvider->HasKerning() ) {
+		return;
+	}
+	kernedGlyphs.Add( glyphCode );
+	for( auto otherCode : kernedGlyphs ) {
+		const auto leftKerning = glyphProvider->GetKerning( otherCode, glyphCode );
+		if( leftKerning != 0 ) {
+			kerningPairs.Set( otherCode * LatinSymbolCount + glyphCode, leftKerning );
+		}
+		const auto rightKerning = otherCode != glyphCode ? glyphProvider->GetKerning( glyphCode, otherCode ) : 0;
+		if( rightKerning != 0 ) {
+			kerningPairs.Set( glyphCode * LatinSymbolCount + otherCode, rightKerning );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CStringView CGlyphCache::GetMessageSource()
+{
+	return "Gin::CGlyphCache";
+}
+
+const CStringView invalidStrError = "Invalid string passed to renderer: %0.";
+// Get the UTF16 character code from str at strPos. A parsed UTF32 character is returned.
+unsigned CGlyphCache::ParseCharacter( CUnicodePart str, int& strPos )
+{
+	assert( strPos < str.Length() );
+	unsigned result;
+	if( !Unicode::TryConvertUtf16ToUtf32( str[strPos], result ) ) {
+		const auto nextPos = strPos + 1;
+		if( nextPos == str.Length() ) {
+			CMessageSourceSwitcher swt( GetMessageSource() );
+			Log::Warning( invalidStrError.SubstParam( str ) );
+			return str[strPos];
+		}
+		if( !Unicode::TryConvertUtf16ToUtf32( str[strPos], str[nextPos], result ) ) {
+			CMessageSourceSwitcher swt( GetMessageSource() );
+			Log::Warning( invalidStrError.SubstParam( str ) );
+			result = str[nextPos];
+			strPos++;
+		} else {
+			strPos += 2;
+		}
+	} else {
+		strPos++;
+	}
+	return result;
+}
+
+unsigned CGlyphCache::ParseCharacter( CStringPart str, int& strPos )
+{
+	assert( strPos < str.Length() );
+	unsigned result;
+	const auto parsedCount = Unicode::TryConvertUtf8ToUtf32( str.begin() + strPos, str.Length() - strPos, result );
+	if( parsedCount == 0 ) {
+		CMessageSourceSwitcher swt( GetMessageSource() );
+		Log::Warning( invalidStrError.SubstParam( str ) );
+		strPos++;
+		return 0;
+	}
+
+	strPos += parsedCount;
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+const CShapedLine& CGlyphCache::GetShapedLine( CUnicodePart line )
+{
+	const CArrayView<BYTE> text( reinterpret_cast<const BYTE*>( line.begin() ), line.Length() * sizeof( wchar_t ) );
+	const CTextMeshCacheKey key( text, true );
+	const auto slot = shapingCachePolicy.FindSlot( key, text );
+	return slot != NotFound ? shapedLines[slot] : addShapedLine( line, key, text );
+}
+
+const CShapedLine& CGlyphCache::GetShapedLine( CStringPart line )
+{
+	const CArrayView<BYTE> text( reinterpret_cast<const BYTE*>( line.begin() ), line.Length() );
+	const CTextMeshCacheKey key( text, false );
+	const auto slot = shapingCachePolicy.FindSlot( key, text );
+	return slot != NotFound ? shapedLines[slot] : addShapedLine( line, key, text );
+}
+
+// Decode the line, apply kerning and store the result in the cache.
+template <class StrType>
+const CShapedLine& CGlyphCache::addShapedLine( StrType line, const CTextMeshCacheKey& key, CArrayView<BYTE> text )
+{
+	CShapedLine shapedLine;
+	shapedLine.Glyphs.ReserveBuffer( line.Length() );
+	CVector2<int> pen;
+	unsigned prevCode = 0;
+	for( int strPos = 0; strPos < line.Length(); ) {
+		CTextLayoutGlyph glyph;
+		glyph.StrPos = strPos;
+		glyph.GlyphCode = ParseCharacter( line, strPos );
+		const auto sizeData = GetRenderData( glyph.GlyphCode ).GlyphData;
+		if( !shapedLine.Glyphs.IsEmpty() ) {
+			pen.X() += GetKerning( prevCode, glyph.GlyphCode );
+		}
+		glyph.Position = pen;
+		shapedLine.Glyphs.Add( glyph );
+		pen += sizeData.Advance;
+		prevCode = glyph.GlyphCode;
+	}
+	shapedLine.EndOffset = pen;
+
+	// Shaped lines are not referenced between calls, so any line can be evicted.
+	shapingCachePolicy.AdvanceFrame();
+	evictedShapingSlots.Empty();
+	const int byteSize = shapedLine.Glyphs.Size() * sizeof( CTextLayoutGlyph );
+	const auto slot = shapingCachePolicy.AddSlot( key, text, byteSize, evictedShapingSlots );
+	for( auto evictedSlot : evictedShapingSlots ) {
+		shapedLines[evictedSlot].Glyphs.FreeBuffer();
+	}
+	if( slot >= shapedLines.Size() ) {
+		shapedLines.IncreaseSize( slot + 1 );
+	}
+	shapedLines[slot] = move( shapedLine );
+	return shapedLines[slot];
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextLayoutResult CGlyphCache::LayoutText( CUnicodePart str, int lineWidth, int lineHeight, int startHOffset,
+	CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines )
+{
+	return doLayoutText( str, lineWidth, lineHeight, startHOffset, glyphs, lines );
+}
+
+CTextLayoutResult CGlyphCache::LayoutText( CStringPart str, int lineWidth, int lineHeight, int startHOffset,
+	CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines )
+{
+	return doLayoutText( str, lineWidth, lineHeight, startHOffset, glyphs, lines );
+}
+
+// Single pass word wrapping. Words are placed directly into the output and moved to the next line if they don't fit.
+template <class StrType>
+CTextLayoutResult CGlyphCache::doLayoutText( StrType str, int lineWidth, int lineHeight, int startHOffset,
+	CArrayBuffer<CTextLayoutGlyph> glyphs, CArrayBuffer<CTextLayoutLine> lines )
+{
+	CTextLayoutResult result;
+	CVector2<int> pen( startHOffset, 0 );
+	int lineFirstGlyph = 0;
+	int lineRight = startHOffset;
+	const int length = str.Length();
+	for( int strPos = 0; strPos < length; ) {
+		const auto ch = str[strPos];
+		if( ch == '\n' ) {
+			addLayoutLine( lineFirstGlyph, result.GlyphCount, lineRight, result, lines );
+			pen = CVector2<int>( 0, pen.Y() - lineHeight );
+			lineFirstGlyph = result.GlyphCount;
+			lineRight = 0;
+			strPos++;
+			continue;
+		} else if( str.IsCharWhiteSpace( ch ) ) {
+			pen.X() += GetRenderData( ParseCharacter( str, strPos ) ).GlyphData.Advance.X();
+			continue;
+		}
+
+		// Place the word.
+		const int wordFirstGlyph = result.GlyphCount;
+		const int wordStartX = pen.X();
+		int wordRight = pen.X();
+		unsigned prevCode = 0;
+		while( strPos < length && !str.IsCharWhiteSpace( str[strPos] ) ) {
+			const auto charPos = strPos;
+			const auto glyphCode = ParseCharacter( str, strPos );
+			const auto sizeData = GetRenderData( glyphCode ).GlyphData;
+			const auto kerning = result.GlyphCount > wordFirstGlyph ? GetKerning( prevCode, glyphCode ) : 0;
+			const auto glyphRight = pen.X() + kerning + sizeData.Offset.X() + sizeData.Advance.X();
+			if( result.GlyphCount > wordFirstGlyph && glyphRight - wordStartX > lineWidth ) {
+				// The word cannot fit on a single line. The rest of it is placed as a separate word.
+				strPos = charPos;
+				break;
+			}
+			pen.X() += kerning;
+			if( result.GlyphCount < glyphs.Size() ) {
+				auto& glyph = glyphs[result.GlyphCount];
+				glyph.GlyphCode = glyphCode;
+				glyph.Position = pen;
+				glyph.StrPos = charPos;
+			}
+			result.GlyphCount++;
+			pen += sizeData.Advance;
+			prevCode = glyphCode;
+			wordRight = glyphRight;
+		}
+
+		if( wordRight > lineWidth && wordStartX > 0 ) {
+			// Move the word to a new line.
+			addLayoutLine( lineFirstGlyph, wordFirstGlyph, lineRight, result, lines );
+			const auto storedGlyphEnd = min( result.GlyphCount, glyphs.Size() );
+			for( int i = wordFirstGlyph; i < storedGlyphEnd; i++ ) {
+				glyphs[i].Position.X() -= wordStartX;
+				glyphs[i].Position.Y() -= lineHeight;
+			}
+			pen.X() -= wordStartX;
+			pen.Y() -= lineHeight;
+			wordRight -= wordStartX;
+			lineFirstGlyph = wordFirstGlyph;
+			lineRight = 0;
+		}
+		lineRight = max( lineRight, wordRight );
+	}
+
+	addLayoutLine( lineFirstGlyph, result.GlyphCount, lineRight, result, lines );
+	result.EndOffset = pen;
+	return result;
+}
+
+void CGlyphCache::addLayoutLine( int firstGlyph, int glyphEnd, int width, CTextLayoutResult& result, CArrayBuffer<CTextLayoutLine> lines )
+{
+	if( result.LineCount < lines.Size() ) {
+		auto& line = lines[result.LineCount];
+		line.FirstGlyph = firstGlyph;
+		line.GlyphCount = glyphEnd - firstGlyph;
+		line.Width = width;
+	}
+	result.LineCount++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
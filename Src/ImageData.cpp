@@ -3,6 +3,7 @@
 
 #include <ImageData.h>
 #include <TextureUtils.h>
+#include <DxtBlockFlip.h>
 
 namespace Gin {
 
@@ -32,6 +33,24 @@ CImageData::CImageData( TTextureType _type, int _width, int _height, int _depth,
 	texelDataType( _pixelFormat )
 {
 	initData( _mipmapCount );
+	allocateData();
+}
+
+CImageData::CImageData( TTextureType _type, int _width, int _height, int _depth, TTexelFormat _imageFormat, TTexelDataType _pixelFormat,
+		TTextureCompressionType _compressionType, int _mipmapCount, int _arrayCount, CPtrOwner<CFileMapping> mapping, int dataOffset ) :
+	width( _width ),
+	height( _height ),
+	depth( _depth ),
+	type( _type ),
+	compressionType( _compressionType ),
+	arrayCount( _arrayCount ),
+	texelFormat( _imageFormat ),
+	texelDataType( _pixelFormat ),
+	fileMapping( move( mapping ) )
+{
+	assert( fileMapping != nullptr );
+	initData( _mipmapCount );
+	mapData( dataOffset );
 }
 
 CImageData::CImageData( CImageData&& other ) :
@@ -43,7 +62,8 @@ CImageData::CImageData( CImageData&& other ) :
 	type( move( other.type ) ),
 	compressionType( move( other.compressionType ) ),
 	texelFormat( move( other.texelFormat ) ),
-	texelDataType( move( other.texelDataType ) )
+	texelDataType( move( other.texelDataType ) ),
+	fileMapping( move( other.fileMapping ) )
 {
 
 }
@@ -55,7 +75,6 @@ void CImageData::initData( int mipmapCount )
 
 	textureData.IncreaseSize( mipmapCount );
 	fillSizes();
-	allocateData();
 }
 
 int CImageData::GetCubeFaceCount() const
@@ -101,9 +120,14 @@ int CImageData::findLineSize( int lineWidth, int bytesPerPixel ) const
 	case TCT_Uncompressed:
 		return lineWidth * bytesPerPixel;
 	case TCT_Dxt1_RGB:
+	case TCT_Dxt1_sRGB:
+	case TCT_Bc4:
 		return Ceil( lineWidth, dxtPixelBlockSize ) * dxtSmallBlockSize;
 	case TCT_Dxt3:
+	case TCT_Dxt3_sRGBA:
 	case TCT_Dxt5:
+	case TCT_Dxt5_sRGBA:
+	case TCT_Bc5:
 		return Ceil( lineWidth, dxtPixelBlockSize ) * dxtBigBlockSize;
 	default:
 		assert( false );
@@ -132,6 +156,27 @@ void CImageData::allocateData()
 	}
 }
 
+extern const CError Err_TruncatedImageData;
+// Point the images to the file contents. The file stores all the mipmap levels of an image before the next image.
+void CImageData::mapData( int dataOffset )
+{
+	const auto fileData = fileMapping->GetData();
+	const int imageCount = GetCubeFaceCount() * arrayCount;
+	for( int i = 0; i < GetMipmapCount(); i++ ) {
+		textureData[i].MappedImages.IncreaseSizeNoInitialize( imageCount );
+	}
+
+	int filePos = dataOffset;
+	for( int imagePos = 0; imagePos < imageCount; imagePos++ ) {
+		for( int i = 0; i < GetMipmapCount(); i++ ) {
+			const int imageSize = textureData[i].ImageSize;
+			check( filePos >= 0 && imageSize <= fileData.Size() - filePos, Err_TruncatedImageData, fileMapping->GetFileName() );
+			textureData[i].MappedImages[imagePos] = fileData.Ptr() + filePos;
+			filePos += imageSize;
+		}
+	}
+}
+
 int CImageData::GetImageDataSize( int mipmapLevel ) const
 {
 	assert( mipmapLevel >= 0 && mipmapLevel < GetMipmapCount() );
@@ -145,8 +190,41 @@ const BYTE* CImageData::GetImageData( int mipmapLevel, int arrayIndex /*= 0*/, i
 	assert( arrayIndex >= 0 && arrayIndex < GetArrayCount() );
 	assert( cubeFace >= 0 && cubeFace < GetCubeFaceCount() );
 
-	const int dataOffset = ( arrayIndex * GetCubeFaceCount() + cubeFace ) * textureData[mipmapLevel].ImageSize;
-	return textureData[mipmapLevel].Data.Ptr() + dataOffset;
+	const int imagePos = arrayIndex * GetCubeFaceCount() + cubeFace;
+	if( IsMapped() ) {
+		return textureData[mipmapLevel].MappedImages[imagePos];
+	}
+	return textureData[mipmapLevel].Data.Ptr() + imagePos * textureData[mipmapLevel].ImageSize;
+}
+
+void CImageData::CopyImageData( int mipmapLevel, int arrayIndex, int cubeFace, BYTE* result, bool shouldFlip ) const
+{
+	const BYTE* data = GetImageData( mipmapLevel, arrayIndex, cubeFace );
+	if( shouldFlip ) {
+		copyDataFlipped( result, data, textureData[mipmapLevel].ImageSize, mipmapLevel );
+	} else {
+		memcpy( result, data, textureData[mipmapLevel].ImageSize );
+	}
+}
+
+CArrayView<BYTE> CImageData::GetMipmapData( int mipmapLevel ) const
+{
+	assert( mipmapLevel >= 0 && mipmapLevel < GetMipmapCount() );
+	const auto& mipmap = textureData[mipmapLevel];
+	if( !IsMapped() ) {
+		return mipmap.Data;
+	}
+
+	// Images of a single level are adjacent in the file only if there are no other levels between them.
+	assert( mipmap.MappedImages.Size() == 1 || GetMipmapCount() == 1 );
+	return CArrayView<BYTE>( mipmap.MappedImages[0], mipmap.ImageSize * mipmap.MappedImages.Size() );
+}
+
+CArray<BYTE>& CImageData::GetMipmapData( int mipmapLevel )
+{
+	assert( mipmapLevel >= 0 && mipmapLevel < GetMipmapCount() );
+	assert( !IsMapped() );
+	return textureData[mipmapLevel].Data;
 }
 
 void CImageData::SetImageData( int mipmapLevel, int arrayIndex, int cubeFace, const BYTE* data, bool shouldFlip )
@@ -154,6 +232,7 @@ void CImageData::SetImageData( int mipmapLevel, int arrayIndex, int cubeFace, co
 	assert( mipmapLevel >= 0 && mipmapLevel < GetMipmapCount() );
 	assert( arrayIndex >= 0 && arrayIndex < GetArrayCount() );
 	assert( cubeFace >= 0 && cubeFace < GetCubeFaceCount() );
+	assert( !IsMapped() );
 
 	const int dataOffset = ( arrayIndex * GetCubeFaceCount() + cubeFace ) * textureData[mipmapLevel].ImageSize;
 	if( shouldFlip ) {
@@ -168,53 +247,122 @@ void CImageData::SetImageData( int mipmapLevel, int arrayIndex, int cubeFace, co
 	SetImageData( mipmapLevel, arrayIndex, cubeFace, reinterpret_cast<const BYTE*>( data ), shouldFlip );
 }
 
-extern const CError Err_InvalidDxtImageHeight;
-void CImageData::copyDataFlipped( BYTE* dest, const BYTE* src, int byteSize, int mipmapLevel ) const
+void CImageData::FlipImage( int mipmapLevel, int arrayIndex, int cubeFace )
+{
+	assert( mipmapLevel >= 0 && mipmapLevel < GetMipmapCount() );
+	assert( arrayIndex >= 0 && arrayIndex < GetArrayCount() );
+	assert( cubeFace >= 0 && cubeFace < GetCubeFaceCount() );
+	assert( !IsMapped() );
+
+	const int imageSize = textureData[mipmapLevel].ImageSize;
+	const int dataOffset = ( arrayIndex * GetCubeFaceCount() + cubeFace ) * imageSize;
+	flipDataInPlace( textureData[mipmapLevel].Data.Ptr() + dataOffset, imageSize, mipmapLevel );
+}
+
+void CImageData::FlipVertically()
+{
+	for( int arrayPos = 0; arrayPos < GetArrayCount(); arrayPos++ ) {
+		for( int facePos = 0; facePos < GetCubeFaceCount(); facePos++ ) {
+			for( int mipmapPos = 0; mipmapPos < GetMipmapCount(); mipmapPos++ ) {
+				FlipImage( mipmapPos, arrayPos, facePos );
+			}
+		}
+	}
+}
+
+static GinInternal::TDxtBlockType getDxtBlockType( TTextureCompressionType compressionType )
 {
 	switch( compressionType ) {
-	case TCT_Uncompressed:
-		copyUncompressedDataFlipped( dest, src, byteSize, mipmapLevel );
-		return;
 	case TCT_Dxt1_RGB:
 	case TCT_Dxt1_sRGB:
-		copyDxtDataFlipped( dest, src, byteSize, mipmapLevel, dxtSmallBlockSize, flipDxt1Block );
-		break;
+		return GinInternal::DBT_Dxt1;
 	case TCT_Dxt3:
 	case TCT_Dxt3_sRGBA:
-		copyDxtDataFlipped( dest, src, byteSize, mipmapLevel, dxtBigBlockSize, flipDxt3Block );
-		break;
+		return GinInternal::DBT_Dxt3;
 	case TCT_Dxt5:
 	case TCT_Dxt5_sRGBA:
-		copyDxtDataFlipped( dest, src, byteSize, mipmapLevel, dxtBigBlockSize, flipDxt5Block );
-		break;
+		return GinInternal::DBT_Dxt5;
+	case TCT_Bc4:
+		return GinInternal::DBT_Bc4;
+	case TCT_Bc5:
+		return GinInternal::DBT_Bc5;
 	default:
 		assert( false );
+		return GinInternal::DBT_Dxt1;
 	}
-	check( height % dxtPixelBlockSize == 0, Err_InvalidDxtImageHeight );
 }
 
-void CImageData::copyUncompressedDataFlipped( BYTE* dest, const BYTE* src, int imageSize, int mipmapLevel ) const
+// Copy the image with the reversed row order. Rows of compressed images consist of blocks, pixels of each block are flipped as well.
+void CImageData::copyDataFlipped( BYTE* dest, const BYTE* src, int imageSize, int mipmapLevel ) const
 {
-	int currentWidth, currentHeight, currentDepth;
-	getDimensions( mipmapLevel, currentWidth, currentHeight, currentDepth );
-	const int sliceSize = imageSize / currentDepth;
-	const int lineSize = sliceSize / currentHeight;
-	int destPos = 0;
-	int srcPos = sliceSize - lineSize;
-	// Go through the image slice by slice.
-	for( int i = 0; i < currentDepth; i++ ) {
-		// Flip each slice vertically line by line.
-		for( int j = 0; j < currentHeight; j++ ) {
-			// Copy the line.
-			memcpy( dest + destPos, src + srcPos, lineSize );
-			srcPos -= lineSize;
-			destPos += lineSize;
+	int sliceCount, rowCount;
+	getFlipRowCounts( mipmapLevel, sliceCount, rowCount );
+	const int sliceSize = imageSize / sliceCount;
+	const int rowSize = sliceSize / rowCount;
+	for( int i = 0; i < sliceCount; i++ ) {
+		BYTE* destSlice = dest + i * sliceSize;
+		const BYTE* srcSlice = src + i * sliceSize;
+		for( int j = 0; j < rowCount; j++ ) {
+			const BYTE* srcRow = srcSlice + ( rowCount - j - 1 ) * rowSize;
+			if( compressionType == TCT_Uncompressed ) {
+				memcpy( destSlice + j * rowSize, srcRow, rowSize );
+			} else {
+				GinInternal::FlipDxtBlocks( getDxtBlockType( compressionType ), destSlice + j * rowSize, srcRow, rowSize );
+			}
 		}
-		// Move to the next slice.
-		srcPos += 2 * sliceSize - lineSize;
 	}
 }
 
+// Size of the stack buffer that is used to exchange rows.
+static const int rowSwapChunkSize = 256;
+static void swapRows( BYTE* first, BYTE* second, int rowSize )
+{
+	BYTE chunk[rowSwapChunkSize];
+	for( int pos = 0; pos < rowSize; pos += rowSwapChunkSize ) {
+		const int chunkSize = min( rowSwapChunkSize, rowSize - pos );
+		memcpy( chunk, first + pos, chunkSize );
+		memcpy( first + pos, second + pos, chunkSize );
+		memcpy( second + pos, chunk, chunkSize );
+	}
+}
+
+// Exchange the row pairs from the opposite sides of each slice.
+void CImageData::flipDataInPlace( BYTE* data, int imageSize, int mipmapLevel ) const
+{
+	int sliceCount, rowCount;
+	getFlipRowCounts( mipmapLevel, sliceCount, rowCount );
+	const int sliceSize = imageSize / sliceCount;
+	const int rowSize = sliceSize / rowCount;
+	for( int i = 0; i < sliceCount; i++ ) {
+		BYTE* slice = data + i * sliceSize;
+		// The middle row of compressed images is flipped in place.
+		for( int j = 0; j < ( rowCount + 1 ) / 2; j++ ) {
+			BYTE* topRow = slice + j * rowSize;
+			BYTE* bottomRow = slice + ( rowCount - j - 1 ) * rowSize;
+			if( compressionType != TCT_Uncompressed ) {
+				GinInternal::SwapFlipDxtBlocks( getDxtBlockType( compressionType ), topRow, bottomRow, rowSize );
+			} else if( topRow != bottomRow ) {
+				swapRows( topRow, bottomRow, rowSize );
+			}
+		}
+	}
+}
+
+extern const CError Err_InvalidDxtImageHeight;
+// Get the number of slices and the number of rows in a slice. Compressed rows consist of pixel blocks.
+void CImageData::getFlipRowCounts( int mipmapLevel, int& sliceCount, int& rowCount ) const
+{
+	int currentWidth, currentHeight;
+	getDimensions( mipmapLevel, currentWidth, currentHeight, sliceCount );
+	if( compressionType == TCT_Uncompressed ) {
+		rowCount = currentHeight;
+		return;
+	}
+	// Blocks can only be flipped as a whole.
+	check( height % dxtPixelBlockSize == 0, Err_InvalidDxtImageHeight );
+	rowCount = Ceil( currentHeight, dxtPixelBlockSize );
+}
+
 // Get the dimensions of the image on the current mipmap level.
 void CImageData::getDimensions( int mipmapLevel, int& mipmapWidth, int& mipmapHeight, int& mipmapDepth ) const
 {
@@ -235,71 +383,6 @@ void CImageData::getDimensions( int mipmapLevel, int& mipmapWidth, int& mipmapHe
 	}
 }
 
-void CImageData::flipDxt1Block( BYTE* dest, const BYTE* src )
-{
-	// First four bytes contain color information.
-	memcpy( dest, src, 4 );
-
-	// Next four bytes contain 4x4 pixel block information, flip them.
-	// Each pixel is represented as 2 bits, copy every byte in reverse order.
-	dest[4] = src[7];
-	dest[5] = src[6];
-	dest[6] = src[5];
-	dest[7] = src[4];
-}
-
-void CImageData::flipDxt3Block( BYTE* dest, const BYTE* src )
-{
-	// First eight bytes contain 4x4 pixel block data, flip them.
-	// Each pixel is represented as 4 bits, copy every two bytes in reverse order.
-	dest[0] = src[6];
-	dest[1] = src[7];
-	dest[2] = src[4];
-	dest[3] = src[5];
-	dest[4] = src[2];
-	dest[5] = src[3];
-	dest[6] = src[0];
-	dest[7] = src[1];
-	
-	// Next eight bytes are DXT1 compressed.
-	flipDxt1Block( dest + 8, src + 8 );
-}
-
-void CImageData::flipCompressedAlphaBlock( BYTE* dest, const BYTE* src )
-{
-	// First two bytes contain alpha values.
-	memcpy( dest, src, 2 );
-
-	// Next six bytes contain 4x4 pixel block data, flip them.
-	// See compression description for the logic behind the flipping:
-	// http://www.opengl.org/registry/specs/EXT/texture_compression_s3tc.txt
-	dest[2] = ( src[7] & 0x0F ) << 4;
-	dest[2] |= ( src[6] & 0xF0 ) >> 4;
-
-	dest[3] = ( src[5] & 0x0F ) << 4;
-	dest[3] |= ( src[7] & 0xF0 ) >> 4;
-
-	dest[4] = ( src[6] & 0x0F ) << 4;
-	dest[4] |= ( src[5] & 0xF0 ) >> 4;
-
-	dest[5] = ( src[4] & 0x0F ) << 4;
-	dest[5] |= ( src[3] & 0xF0 ) >> 4;
-
-	dest[6] = ( src[2] & 0x0F ) << 4;
-	dest[6] |= ( src[4] & 0xF0 ) >> 4;
-
-	dest[7] = ( src[3] & 0x0F ) << 4;
-	dest[7] |= ( src[2] & 0xF0 ) >> 4;
-}
-
-void CImageData::flipDxt5Block( BYTE* dest, const BYTE* src )
-{
-	// First eight bytes are alpha compressed.
-	flipCompressedAlphaBlock( dest, src );
-	// Next eight bytes are DXT1 compressed.
-	flipDxt1Block( dest + 8, src + 8 );
-}
-
 //////////////////////////////////////////////////////////////////////////
 
 }	// namespace Gin.
@@ -0,0 +1,197 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <ImageEncodeQueue.h>
+#include <Screenshots.h>
+#include <PngEncoder.h>
+#include <CriticalSectionLock.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+static long long getCurrentTicks()
+{
+	LARGE_INTEGER count;
+	::QueryPerformanceCounter( &count );
+	return count.QuadPart;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CImageEncodeQueue::CImageEncodeQueue( int workerCount, int _maxJobCount, IImageEncoder* _encoder ) :
+	maxJobCount( _maxJobCount ),
+	encoder( _encoder )
+{
+	assert( workerCount > 0 && maxJobCount > 0 );
+	::InitializeCriticalSection( &lock );
+	::InitializeCriticalSection( &nameLock );
+	::InitializeConditionVariable( &jobAdded );
+	::InitializeConditionVariable( &jobFinished );
+
+	for( int i = 0; i < workerCount; i++ ) {
+		const HANDLE worker = ::CreateThread( nullptr, 0, workerProc, this, 0, nullptr );
+		if( worker == nullptr ) {
+			// The started workers handle the jobs. Without workers the jobs are written on the calling thread.
+			break;
+		}
+		workers.Add( worker );
+	}
+}
+
+CImageEncodeQueue::~CImageEncodeQueue()
+{
+	{
+		CCriticalSectionLock queueLock( lock );
+		isStopping = true;
+	}
+	::WakeAllConditionVariable( &jobAdded );
+	for( HANDLE worker : workers ) {
+		::WaitForSingleObject( worker, INFINITE );
+		::CloseHandle( worker );
+	}
+	::DeleteCriticalSection( &nameLock );
+	::DeleteCriticalSection( &lock );
+}
+
+int CImageEncodeQueue::GetJobCount() const
+{
+	CCriticalSectionLock queueLock( lock );
+	return jobs.Size() + activeJobCount;
+}
+
+CImageEncodeStatistics CImageEncodeQueue::GetStatistics() const
+{
+	CCriticalSectionLock queueLock( lock );
+	return statistics;
+}
+
+bool CImageEncodeQueue::TryAddJob( CImageEncodeJob& job )
+{
+	{
+		CCriticalSectionLock queueLock( lock );
+		if( jobs.Size() + activeJobCount >= maxJobCount ) {
+			statistics.RejectedCount++;
+			return false;
+		}
+	}
+	addJob( job );
+	return true;
+}
+
+void CImageEncodeQueue::AddJob( CImageEncodeJob job )
+{
+	{
+		CCriticalSectionLock queueLock( lock );
+		while( jobs.Size() + activeJobCount >= maxJobCount ) {
+			::SleepConditionVariableCS( &jobFinished, &lock, INFINITE );
+		}
+	}
+	addJob( job );
+}
+
+void CImageEncodeQueue::Flush()
+{
+	CCriticalSectionLock queueLock( lock );
+	while( !jobs.IsEmpty() || activeJobCount > 0 ) {
+		::SleepConditionVariableCS( &jobFinished, &lock, INFINITE );
+	}
+}
+
+// Only the producer thread adds jobs, so the space checked by the caller can't be taken in the meantime.
+void CImageEncodeQueue::addJob( CImageEncodeJob& job )
+{
+	job.Index = nextJobIndex++;
+	if( workers.IsEmpty() ) {
+		const auto startTime = getCurrentTicks();
+		finishJob( job, writeJob( job ), startTime );
+		return;
+	}
+
+	{
+		CCriticalSectionLock queueLock( lock );
+		jobs.Add( CreateOwner<CImageEncodeJob>( move( job ) ) );
+	}
+	::WakeConditionVariable( &jobAdded );
+}
+
+void CImageEncodeQueue::runWorker()
+{
+	for( ;; ) {
+		CPtrOwner<CImageEncodeJob> job;
+		{
+			CCriticalSectionLock queueLock( lock );
+			while( jobs.IsEmpty() && !isStopping ) {
+				::SleepConditionVariableCS( &jobAdded, &lock, INFINITE );
+			}
+			if( jobs.IsEmpty() ) {
+				return;
+			}
+			job = move( jobs[0] );
+			jobs.DeleteAt( 0 );
+			activeJobCount++;
+		}
+
+		const auto startTime = getCurrentTicks();
+		finishJob( *job, writeJob( *job ), startTime );
+		::WakeAllConditionVariable( &jobFinished );
+	}
+}
+
+void CImageEncodeQueue::finishJob( const CImageEncodeJob& job, bool isWritten, long long startTime )
+{
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency( &frequency );
+	const double encodeTime = static_cast<double>( getCurrentTicks() - startTime ) / frequency.QuadPart;
+
+	CCriticalSectionLock queueLock( lock );
+	if( !workers.IsEmpty() ) {
+		activeJobCount--;
+	}
+	statistics.EncodeTime += encodeTime;
+	if( isWritten ) {
+		statistics.WrittenCount++;
+		statistics.WrittenPixelCount += static_cast<long long>( job.Size.X() ) * job.Size.Y();
+	} else {
+		statistics.FailedCount++;
+	}
+}
+
+bool CImageEncodeQueue::writeJob( const CImageEncodeJob& job )
+{
+	try {
+		if( encoder != nullptr ) {
+			return encoder->EncodeImage( job );
+		}
+		if( job.FileName.IsEmpty() ) {
+			// The file must exist before the next unique name is created.
+			CCriticalSectionLock uniqueNameLock( nameLock );
+			writePngFile( CreateUniqueImageName(), job );
+		} else {
+			writePngFile( job.FileName, job );
+		}
+		return true;
+	} catch( ... ) {
+		// A worker thread can't pass the exception further, the failure is counted in the statistics.
+		return false;
+	}
+}
+
+void CImageEncodeQueue::writePngFile( CStringPart fileName, const CImageEncodeJob& job )
+{
+	// Images are already encoded in parallel by the queue workers, a single image uses one thread.
+	CPngEncoder pngEncoder;
+	const int scanLineWidth = -CeilTo( job.Size.X() * 3, sizeof( DWORD ) );
+	pngEncoder.WriteFile( fileName, job.Pixels, TF_RGB, scanLineWidth, job.Size );
+}
+
+DWORD WINAPI CImageEncodeQueue::workerProc( void* param )
+{
+	static_cast<CImageEncodeQueue*>( param )->runWorker();
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -197,6 +197,20 @@ void CSpecificMeshData<CElementMeshTag>::Draw( CShaderProgram shader, int extEle
 	postMeshDraw();
 }
 
+void CSpecificMeshData<CElementMeshTag>::Draw( CShaderProgram shader, int firstElement, int extElementCount ) const
+{
+	assert( firstElement >= 0 );
+	assert( elementCount >= firstElement + extElementCount );
+	const int indexSize = indexType == GLT_UnsignedShort ? sizeof( unsigned short ) : sizeof( unsigned );
+	preMeshDraw( shader );
+	assert( hasElementBinding() );
+#pragma warning( push )
+#pragma warning( disable:4312 )	// conversion from 'int' to 'void *' of greater size [OpenGL API nonsense]
+	gl::DrawElements( drawMode, extElementCount, indexType, reinterpret_cast<void*>( firstElement * indexSize ) );
+#pragma warning( pop )
+	postMeshDraw();
+}
+
 void CSpecificMeshData<CElementMeshTag>::invalidate()
 {
 	clearMeshId();
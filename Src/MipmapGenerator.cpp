@@ -0,0 +1,426 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <MipmapGenerator.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+
+// SSE is a part of the x64 instruction set and is enabled by /arch:SSE and higher on x86.
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 ) || defined( __SSE__ )
+#define GIN_MIPMAP_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+void CMipmapGenerator::SetAlphaCoveragePreservation( bool isEnabled, float referenceAlpha )
+{
+	assert( referenceAlpha > 0.0f && referenceAlpha < 1.0f );
+	preserveAlphaCoverage = isEnabled;
+	alphaCoverageReference = referenceAlpha;
+}
+
+void CMipmapGenerator::SetWorkerCount( int newValue )
+{
+	assert( newValue > 0 );
+	workerCount = newValue;
+}
+
+int CMipmapGenerator::GetFullMipmapCount( int width, int height )
+{
+	assert( width > 0 && height > 0 );
+	int result = 1;
+	for( int size = max( width, height ); size > 1; size /= 2 ) {
+		result++;
+	}
+	return result;
+}
+
+static int getChannelCount( const CImageData& image )
+{
+	assert( image.GetCompressionType() == TCT_Uncompressed && image.GetTexelDataType() == TDT_UnsignedByte );
+	switch( image.GetTexelFormat() ) {
+	case TF_Red:
+		return 1;
+	case TF_RGBA:
+	case TF_BGRA:
+		return 4;
+	default:
+		assert( false );
+		return NotFound;
+	}
+}
+
+static int getLevelSize( int baseSize, int level )
+{
+	return max( 1, baseSize >> level );
+}
+
+// Number of destination rows processed by a single task.
+static const int mipmapTaskRowCount = 16;
+void CMipmapGenerator::GenerateMipmaps( CImageData& image ) const
+{
+	assert( image.Depth() == 1 );
+	assert( !image.IsMapped() );
+	const int channelCount = getChannelCount( image );
+	const int imageCount = image.GetArrayCount() * image.GetCubeFaceCount();
+	const bool shouldPreserveCoverage = preserveAlphaCoverage && channelCount == 4;
+
+	CConversionTables tables;
+	fillConversionTables( tables );
+
+	// Coverage of the first level is preserved in all the others.
+	CArray<float> targetCoverage;
+	if( shouldPreserveCoverage ) {
+		const int referenceAlpha = Round( alphaCoverageReference * 255 );
+		const int pixelCount = image.Width() * image.Height();
+		for( int i = 0; i < imageCount; i++ ) {
+			int histogram[256];
+			findAlphaHistogram( image.GetMipmapData( 0 ).Ptr() + i * image.GetImageDataSize( 0 ), pixelCount, histogram );
+			targetCoverage.Add( findAlphaCoverage( histogram, pixelCount, 1.0f, referenceAlpha ) );
+		}
+	}
+
+	CArray<CArray<float>> workerRows;
+	workerRows.IncreaseSize( workerCount );
+	CFilterAxis horizontal;
+	CFilterAxis vertical;
+	for( int level = 1; level < image.GetMipmapCount(); level++ ) {
+		const int srcWidth = getLevelSize( image.Width(), level - 1 );
+		const int srcHeight = getLevelSize( image.Height(), level - 1 );
+		const int destWidth = getLevelSize( image.Width(), level );
+		const int destHeight = getLevelSize( image.Height(), level );
+		buildFilterAxis( srcWidth, destWidth, horizontal );
+		buildFilterAxis( srcHeight, destHeight, vertical );
+
+		const int srcImageSize = image.GetImageDataSize( level - 1 );
+		const int destImageSize = image.GetImageDataSize( level );
+		const BYTE* srcLevel = image.GetMipmapData( level - 1 ).Ptr();
+		BYTE* destLevel = image.GetMipmapData( level ).Ptr();
+		const int bandCount = ( destHeight + mipmapTaskRowCount - 1 ) / mipmapTaskRowCount;
+		auto filterBand = [&]( int workerIndex, int taskIndex ) {
+			const int imagePos = taskIndex / bandCount;
+			const int firstRow = ( taskIndex % bandCount ) * mipmapTaskRowCount;
+			const int rowEnd = min( destHeight, firstRow + mipmapTaskRowCount );
+			const BYTE* srcImage = srcLevel + imagePos * srcImageSize;
+			BYTE* destImage = destLevel + imagePos * destImageSize;
+			for( int y = firstRow; y < rowEnd; y++ ) {
+				filterRow( srcImage, srcWidth, destImage + y * destWidth * channelCount, destWidth, y, channelCount,
+					horizontal, vertical, tables, workerRows[workerIndex] );
+			}
+		};
+		ParallelFor( imageCount * bandCount, workerCount, filterBand );
+
+		if( shouldPreserveCoverage ) {
+			for( int i = 0; i < imageCount; i++ ) {
+				scaleAlphaCoverage( destLevel + i * destImageSize, destWidth * destHeight, targetCoverage[i] );
+			}
+		}
+	}
+}
+
+CImageData CMipmapGenerator::CreateMipmappedImage( const CImageData& source ) const
+{
+	const int mipmapCount = GetFullMipmapCount( source.Width(), source.Height() );
+	CImageData result( source.GetType(), source.Width(), source.Height(), source.Depth(), source.GetTexelFormat(), source.GetTexelDataType(),
+		mipmapCount, source.GetArrayCount() );
+	for( int arrayPos = 0; arrayPos < source.GetArrayCount(); arrayPos++ ) {
+		for( int facePos = 0; facePos < source.GetCubeFaceCount(); facePos++ ) {
+			result.SetImageData( 0, arrayPos, facePos, source.GetImageData( 0, arrayPos, facePos ), false );
+		}
+	}
+	GenerateMipmaps( result );
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Number of entries in the table that converts linear values to sRGB bytes.
+// The table is dense enough to resolve the steep part of the curve near zero.
+static const int linearToSrgbTableSize = 16384;
+static float srgbToLinear( float value )
+{
+	return value <= 0.04045f ? value / 12.92f : powf( ( value + 0.055f ) / 1.055f, 2.4f );
+}
+
+static float linearToSrgb( float value )
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * powf( value, 1.0f / 2.4f ) - 0.055f;
+}
+
+void CMipmapGenerator::fillConversionTables( CConversionTables& tables ) const
+{
+	for( int i = 0; i < 256; i++ ) {
+		const float value = i / 255.0f;
+		tables.AlphaToLinear[i] = value;
+		tables.ColorToLinear[i] = isSrgb ? srgbToLinear( value ) : value;
+	}
+	if( isSrgb ) {
+		tables.LinearToColor.IncreaseSizeNoInitialize( linearToSrgbTableSize );
+		for( int i = 0; i < linearToSrgbTableSize; i++ ) {
+			const float value = linearToSrgb( i / static_cast<float>( linearToSrgbTableSize - 1 ) );
+			tables.LinearToColor[i] = static_cast<BYTE>( Round( value * 255 ) );
+		}
+	}
+}
+
+// Half width of the Kaiser filter in destination pixels.
+static const float kaiserRadius = 1.5f;
+// Shape parameter of the Kaiser window.
+static const float kaiserAlpha = 4.0f;
+// Zeroth order modified Bessel function of the first kind.
+static float besselI0( float x )
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	const float halfSquare = x * x / 4.0f;
+	for( int k = 1; k < 32 && term > sum * 1e-7f; k++ ) {
+		term *= halfSquare / ( k * k );
+		sum += term;
+	}
+	return sum;
+}
+
+static float sinc( float x )
+{
+	const float pi = 3.14159265f;
+	return fabsf( x ) < 1e-5f ? 1.0f : sinf( pi * x ) / ( pi * x );
+}
+
+static float kaiserWindow( float x )
+{
+	const float ratio = x / kaiserRadius;
+	if( fabsf( ratio ) >= 1.0f ) {
+		return 0.0f;
+	}
+	return besselI0( kaiserAlpha * sqrtf( 1.0f - ratio * ratio ) ) / besselI0( kaiserAlpha );
+}
+
+// Get the range of source pixels that affect the destination pixel.
+void CMipmapGenerator::getLevelTaps( TMipmapFilter levelFilter, int destPos, float scale, int& firstTap, int& lastTap )
+{
+	if( levelFilter == MF_Box ) {
+		firstTap = static_cast<int>( floorf( destPos * scale ) );
+		lastTap = static_cast<int>( ceilf( ( destPos + 1 ) * scale ) ) - 1;
+	} else {
+		const float center = ( destPos + 0.5f ) * scale;
+		const float radius = kaiserRadius * scale;
+		firstTap = static_cast<int>( floorf( center - radius ) );
+		lastTap = static_cast<int>( ceilf( center + radius ) );
+	}
+}
+
+float CMipmapGenerator::getTapWeight( TMipmapFilter levelFilter, int srcPos, int destPos, float scale )
+{
+	if( levelFilter == MF_Box ) {
+		// Part of the source pixel covered by the destination pixel.
+		const float left = max( static_cast<float>( srcPos ), destPos * scale );
+		const float right = min( static_cast<float>( srcPos + 1 ), ( destPos + 1 ) * scale );
+		return max( 0.0f, right - left );
+	}
+	// Distance between the pixel centers in destination pixels.
+	const float distance = ( srcPos + 0.5f ) / scale - ( destPos + 0.5f );
+	return sinc( distance ) * kaiserWindow( distance );
+}
+
+// Compute normalized weights for each destination pixel. Taps outside the source are clamped to the edge pixels.
+void CMipmapGenerator::buildFilterAxis( int srcSize, int destSize, CFilterAxis& result ) const
+{
+	const float scale = static_cast<float>( srcSize ) / destSize;
+	int maxTapCount = 0;
+	for( int i = 0; i < destSize; i++ ) {
+		int firstTap, lastTap;
+		getLevelTaps( filter, i, scale, firstTap, lastTap );
+		maxTapCount = max( maxTapCount, lastTap - firstTap + 1 );
+	}
+	const int tapCount = min( maxTapCount, srcSize );
+
+	result.TapCount = tapCount;
+	result.FirstSource.Empty();
+	result.FirstSource.IncreaseSizeNoInitialize( destSize );
+	result.Weights.Empty();
+	result.Weights.IncreaseSize( destSize * tapCount );
+	for( int i = 0; i < destSize; i++ ) {
+		int firstTap, lastTap;
+		getLevelTaps( filter, i, scale, firstTap, lastTap );
+		const int firstSource = min( max( firstTap, 0 ), srcSize - tapCount );
+		result.FirstSource[i] = firstSource;
+		float* weights = result.Weights.Ptr() + i * tapCount;
+		float weightSum = 0.0f;
+		for( int tap = firstTap; tap <= lastTap; tap++ ) {
+			const float weight = getTapWeight( filter, tap, i, scale );
+			const int srcPos = min( max( tap, 0 ), srcSize - 1 );
+			weights[srcPos - firstSource] += weight;
+			weightSum += weight;
+		}
+		for( int tap = 0; tap < tapCount; tap++ ) {
+			weights[tap] /= weightSum;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Filter a single destination row. Source rows are combined vertically into the row buffer, then the buffer is resampled horizontally.
+void CMipmapGenerator::filterRow( const BYTE* srcImage, int srcWidth, BYTE* destRow, int destWidth, int destY, int channelCount,
+	const CFilterAxis& horizontal, const CFilterAxis& vertical, const CConversionTables& tables, CArray<float>& rowBuffer ) const
+{
+	const int srcRowSize = srcWidth * channelCount;
+	rowBuffer.Empty();
+	rowBuffer.IncreaseSize( srcRowSize );
+
+	const int firstSource = vertical.FirstSource[destY];
+	const float* weights = vertical.Weights.Ptr() + destY * vertical.TapCount;
+	for( int tap = 0; tap < vertical.TapCount; tap++ ) {
+		if( weights[tap] != 0.0f ) {
+			accumulateRow( srcImage + ( firstSource + tap ) * srcRowSize, srcWidth, channelCount, weights[tap], tables, rowBuffer.Ptr() );
+		}
+	}
+	resampleRow( rowBuffer.Ptr(), destRow, destWidth, channelCount, horizontal, tables );
+}
+
+void CMipmapGenerator::accumulateRow( const BYTE* srcRow, int srcWidth, int channelCount, float weight, const CConversionTables& tables, float* rowBuffer )
+{
+	if( channelCount == 1 ) {
+		for( int x = 0; x < srcWidth; x++ ) {
+			rowBuffer[x] += weight * tables.ColorToLinear[srcRow[x]];
+		}
+		return;
+	}
+
+	assert( channelCount == 4 );
+#ifdef GIN_MIPMAP_SSE
+	const __m128 weightVector = _mm_set1_ps( weight );
+	for( int x = 0; x < srcWidth; x++ ) {
+		const BYTE* pixel = srcRow + x * 4;
+		const __m128 linear = _mm_setr_ps( tables.ColorToLinear[pixel[0]], tables.ColorToLinear[pixel[1]],
+			tables.ColorToLinear[pixel[2]], tables.AlphaToLinear[pixel[3]] );
+		float* accumulated = rowBuffer + x * 4;
+		_mm_storeu_ps( accumulated, _mm_add_ps( _mm_loadu_ps( accumulated ), _mm_mul_ps( weightVector, linear ) ) );
+	}
+#else
+	for( int x = 0; x < srcWidth; x++ ) {
+		const BYTE* pixel = srcRow + x * 4;
+		float* accumulated = rowBuffer + x * 4;
+		accumulated[0] += weight * tables.ColorToLinear[pixel[0]];
+		accumulated[1] += weight * tables.ColorToLinear[pixel[1]];
+		accumulated[2] += weight * tables.ColorToLinear[pixel[2]];
+		accumulated[3] += weight * tables.AlphaToLinear[pixel[3]];
+	}
+#endif
+}
+
+void CMipmapGenerator::resampleRow( const float* rowBuffer, BYTE* destRow, int destWidth, int channelCount, const CFilterAxis& horizontal, const CConversionTables& tables )
+{
+	const int tapCount = horizontal.TapCount;
+	for( int x = 0; x < destWidth; x++ ) {
+		const float* weights = horizontal.Weights.Ptr() + x * tapCount;
+		const float* srcPixels = rowBuffer + horizontal.FirstSource[x] * channelCount;
+		BYTE* destPixel = destRow + x * channelCount;
+		if( channelCount == 1 ) {
+			float sum = 0.0f;
+			for( int tap = 0; tap < tapCount; tap++ ) {
+				sum += weights[tap] * srcPixels[tap];
+			}
+			destPixel[0] = encodeColor( sum, tables );
+			continue;
+		}
+
+		float sum[4];
+#ifdef GIN_MIPMAP_SSE
+		__m128 sumVector = _mm_setzero_ps();
+		for( int tap = 0; tap < tapCount; tap++ ) {
+			sumVector = _mm_add_ps( sumVector, _mm_mul_ps( _mm_set1_ps( weights[tap] ), _mm_loadu_ps( srcPixels + tap * 4 ) ) );
+		}
+		_mm_storeu_ps( sum, sumVector );
+#else
+		sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+		for( int tap = 0; tap < tapCount; tap++ ) {
+			for( int channel = 0; channel < 4; channel++ ) {
+				sum[channel] += weights[tap] * srcPixels[tap * 4 + channel];
+			}
+		}
+#endif
+		destPixel[0] = encodeColor( sum[0], tables );
+		destPixel[1] = encodeColor( sum[1], tables );
+		destPixel[2] = encodeColor( sum[2], tables );
+		destPixel[3] = encodeAlpha( sum[3] );
+	}
+}
+
+// Sinc lobes of the Kaiser filter may produce values outside of the valid range, the values are clamped.
+BYTE CMipmapGenerator::encodeColor( float value, const CConversionTables& tables )
+{
+	if( tables.LinearToColor.IsEmpty() ) {
+		return encodeAlpha( value );
+	}
+	const int index = static_cast<int>( value * ( linearToSrgbTableSize - 1 ) + 0.5f );
+	return tables.LinearToColor[min( max( index, 0 ), linearToSrgbTableSize - 1 )];
+}
+
+BYTE CMipmapGenerator::encodeAlpha( float value )
+{
+	const int result = static_cast<int>( value * 255 + 0.5f );
+	return static_cast<BYTE>( min( max( result, 0 ), 255 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void CMipmapGenerator::findAlphaHistogram( const BYTE* image, int pixelCount, int* histogram )
+{
+	memset( histogram, 0, 256 * sizeof( int ) );
+	for( int i = 0; i < pixelCount; i++ ) {
+		histogram[image[i * 4 + 3]]++;
+	}
+}
+
+// Fraction of the pixels that have alpha above the reference after scaling and rounding.
+float CMipmapGenerator::findAlphaCoverage( const int* histogram, int pixelCount, float alphaScale, int referenceAlpha )
+{
+	int coveredCount = 0;
+	for( int alpha = 0; alpha < 256; alpha++ ) {
+		if( encodeAlpha( alpha * alphaScale / 255 ) > referenceAlpha ) {
+			coveredCount += histogram[alpha];
+		}
+	}
+	return static_cast<float>( coveredCount ) / pixelCount;
+}
+
+// Maximum alpha multiplier of the coverage search.
+static const float maxAlphaCoverageScale = 64.0f;
+// Number of bisection steps in the coverage search.
+static const int alphaCoverageSearchSteps = 16;
+void CMipmapGenerator::scaleAlphaCoverage( BYTE* image, int pixelCount, float targetCoverage ) const
+{
+	const int referenceAlpha = Round( alphaCoverageReference * 255 );
+	int histogram[256];
+	findAlphaHistogram( image, pixelCount, histogram );
+
+	// Coverage grows with the scale. Find the scales around the target coverage.
+	float minScale = 0.0f;
+	float maxScale = maxAlphaCoverageScale;
+	for( int i = 0; i < alphaCoverageSearchSteps; i++ ) {
+		const float middleScale = ( minScale + maxScale ) / 2;
+		if( findAlphaCoverage( histogram, pixelCount, middleScale, referenceAlpha ) < targetCoverage ) {
+			minScale = middleScale;
+		} else {
+			maxScale = middleScale;
+		}
+	}
+
+	// Coverage is a step function, use the closest step.
+	const float minError = targetCoverage - findAlphaCoverage( histogram, pixelCount, minScale, referenceAlpha );
+	const float maxError = findAlphaCoverage( histogram, pixelCount, maxScale, referenceAlpha ) - targetCoverage;
+	const float alphaScale = minError < maxError ? minScale : maxScale;
+	for( int i = 0; i < pixelCount; i++ ) {
+		BYTE& alpha = image[i * 4 + 3];
+		alpha = encodeAlpha( alpha * alphaScale / 255 );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
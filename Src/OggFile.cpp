@@ -55,15 +55,7 @@ CSoundOwner COggFile::ReadAudioBuffer( int approximateChunkSize )
 	const int chunkSize = CeilTo( approximateChunkSize, byteRate );
 
 	CArray<BYTE> buffer;
-	for( ;; ) {
-		const int prevSize = buffer.Size();
-		buffer.IncreaseSizeNoInitialize( prevSize + defaultChunkSize );
-		const int bytesRead = decodeFileData( buffer.Ptr() + prevSize, defaultChunkSize );
-		if( bytesRead < defaultChunkSize ) {
-			buffer.DeleteLast( defaultChunkSize - bytesRead );
-			break;
-		}
-	}
+	DecodeAudioData( buffer );
 	return createAudioBuffer( buffer, chunkSize );
 }
 
@@ -73,6 +65,32 @@ CSoundOwner COggFile::ReadAudioBuffer()
 	assert( IsOpen() );
 }
 
+TAudioDataFormat COggFile::GetAudioFormat() const
+{
+	assert( vorbisInfo != 0 && vorbisInfo->channels <= 2 );
+	return vorbisInfo->channels == 1 ? ADF_Mono16 : ADF_Stereo16;
+}
+
+int COggFile::GetSampleRate() const
+{
+	assert( vorbisInfo != 0 );
+	return vorbisInfo->rate;
+}
+
+void COggFile::DecodeAudioData( CArray<BYTE>& result )
+{
+	assert( IsOpen() );
+	for( ;; ) {
+		const int prevSize = result.Size();
+		result.IncreaseSizeNoInitialize( prevSize + defaultChunkSize );
+		const int bytesRead = decodeFileData( result.Ptr() + prevSize, defaultChunkSize );
+		if( bytesRead < defaultChunkSize ) {
+			result.DeleteLast( defaultChunkSize - bytesRead );
+			break;
+		}
+	}
+}
+
 // Decode new data and but it in buffer.
 int COggFile::decodeFileData( BYTE* buffer, int size )
 {
@@ -91,7 +109,7 @@ int COggFile::decodeFileData( BYTE* buffer, int size )
 
 CSoundOwner COggFile::createAudioBuffer( const CArray<BYTE>& buffer, int chunkSize ) const
 {
-	TAudioDataFormat format = getAudioFormat();
+	TAudioDataFormat format = GetAudioFormat();
 	const int chunkCount = Ceil( buffer.Size(), chunkSize );
 	CSoundOwner result( chunkCount );
 	int bufferPos = 0;
@@ -103,12 +121,6 @@ CSoundOwner COggFile::createAudioBuffer( const CArray<BYTE>& buffer, int chunkSi
 	return move( result );
 }
 
-TAudioDataFormat COggFile::getAudioFormat() const
-{
-	assert( vorbisInfo != 0 && vorbisInfo->channels <= 2 );
-	return vorbisInfo->channels == 1 ? ADF_Mono16 : ADF_Stereo16;
-}
-
 static const CStringView unsupportedFeatureError = "OGG file uses unsupported features";
 void COggFile::fillAndVerifyVorbisInfo()
 {
@@ -0,0 +1,252 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <OpenAl\alc.h>
+#include <OpenAlBackend.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+COpenAlBackend::COpenAlBackend()
+{
+	// Open the default device.
+	device = alcOpenDevice( 0 );
+	assert( device != 0 );
+	context = alcCreateContext( device, 0 );
+	assert( context != 0 );
+	const bool makeCurrentResult = alcMakeContextCurrent( context ) != ALC_FALSE;
+	makeCurrentResult;
+	assert( makeCurrentResult );
+}
+
+COpenAlBackend::~COpenAlBackend()
+{
+	alcMakeContextCurrent( 0 );
+	alcDestroyContext( context );
+	alcCloseDevice( device );
+}
+
+static const CStringView floatExtensionName = "AL_EXT_FLOAT32";
+bool COpenAlBackend::IsFloatFormatSupported() const
+{
+	return alIsExtensionPresent( floatExtensionName.Ptr() ) == AL_TRUE;
+}
+
+void COpenAlBackend::CreateBuffers( int count, unsigned* result )
+{
+	alGenBuffers( count, result );
+	checkAudioError();
+}
+
+void COpenAlBackend::DeleteBuffers( int count, const unsigned* bufferIds )
+{
+	alDeleteBuffers( count, bufferIds );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetBufferData( unsigned bufferId, TAudioDataFormat format, int frequency, const void* data, int size )
+{
+	alBufferData( bufferId, format, data, size, frequency );
+	checkAudioError();
+}
+
+float COpenAlBackend::GetBufferDuration( unsigned bufferId ) const
+{
+	int size;
+	int bits;
+	int channelCount;
+	int frequency;
+	alGetBufferi( bufferId, AL_SIZE, &size );
+	alGetBufferi( bufferId, AL_BITS, &bits );
+	alGetBufferi( bufferId, AL_CHANNELS, &channelCount );
+	alGetBufferi( bufferId, AL_FREQUENCY, &frequency );
+	checkAudioError();
+	const int frameSize = bits / 8 * channelCount;
+	return frameSize > 0 && frequency > 0 ? static_cast<float>( size / frameSize ) / frequency : 0.0f;
+}
+
+unsigned COpenAlBackend::CreateSource()
+{
+	unsigned result;
+	alGenSources( 1, &result );
+	checkAudioError();
+	return result;
+}
+
+void COpenAlBackend::DeleteSource( unsigned sourceId )
+{
+	alDeleteSources( 1, &sourceId );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetSourceRelative( unsigned sourceId, bool isRelative )
+{
+	alSourcei( sourceId, AL_SOURCE_RELATIVE, isRelative ? AL_TRUE : AL_FALSE );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetSourcePosition( unsigned sourceId, CVector3<float> position )
+{
+	alSourcefv( sourceId, AEP_Position, position.Ptr() );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetSourceVelocity( unsigned sourceId, CVector3<float> velocity )
+{
+	alSourcefv( sourceId, AEP_Velocity, velocity.Ptr() );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetSourceLooping( unsigned sourceId, bool isLooping )
+{
+	alSourcei( sourceId, AL_LOOPING, isLooping ? AL_TRUE : AL_FALSE );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetSourceGain( unsigned sourceId, float gain )
+{
+	alSourcef( sourceId, AL_GAIN, gain );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetSourcePitch( unsigned sourceId, float pitch )
+{
+	alSourcef( sourceId, AL_PITCH, pitch );
+	checkAudioError();
+}
+
+// The backend doesn't change the distance model and the attenuation parameters of the sources, so the OpenAL defaults are used.
+static const float defaultReferenceDistance = 1.0f;
+static const float defaultRolloffFactor = 1.0f;
+float COpenAlBackend::GetDistanceGain( float distance ) const
+{
+	return GetInverseClampedDistanceGain( distance, defaultReferenceDistance, FLT_MAX, defaultRolloffFactor );
+}
+
+CAudioRecord::TRecordState COpenAlBackend::GetSourceState( unsigned sourceId ) const
+{
+	int result;
+	alGetSourcei( sourceId, AL_SOURCE_STATE, &result );
+	checkAudioError();
+	return CAudioRecord::TRecordState( result );
+}
+
+void COpenAlBackend::GetSourceStates( int count, const unsigned* sourceIds, CAudioRecord::TRecordState* result ) const
+{
+	// OpenAL has no batched state query.
+	for( int i = 0; i < count; i++ ) {
+		int state;
+		alGetSourcei( sourceIds[i], AL_SOURCE_STATE, &state );
+		result[i] = CAudioRecord::TRecordState( state );
+	}
+	checkAudioError();
+}
+
+void COpenAlBackend::PlaySource( unsigned sourceId )
+{
+	alSourcePlay( sourceId );
+	checkAudioError();
+}
+
+void COpenAlBackend::PauseSource( unsigned sourceId )
+{
+	alSourcePause( sourceId );
+	checkAudioError();
+}
+
+void COpenAlBackend::StopSource( unsigned sourceId )
+{
+	alSourceStop( sourceId );
+	checkAudioError();
+}
+
+void COpenAlBackend::RewindSource( unsigned sourceId )
+{
+	alSourceRewind( sourceId );
+	checkAudioError();
+}
+
+float COpenAlBackend::GetSourceOffset( unsigned sourceId ) const
+{
+	float result;
+	alGetSourcef( sourceId, AL_SEC_OFFSET, &result );
+	checkAudioError();
+	return result;
+}
+
+void COpenAlBackend::SetSourceOffset( unsigned sourceId, float offset )
+{
+	alSourcef( sourceId, AL_SEC_OFFSET, offset );
+	checkAudioError();
+}
+
+void COpenAlBackend::QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds )
+{
+	alSourceQueueBuffers( sourceId, count, bufferIds );
+	checkAudioError();
+}
+
+int COpenAlBackend::UnqueueProcessedBuffers( unsigned sourceId, int maxCount, unsigned* result )
+{
+	int processedCount;
+	alGetSourcei( sourceId, AL_BUFFERS_PROCESSED, &processedCount );
+	const int unqueueCount = min( processedCount, maxCount );
+	if( unqueueCount > 0 ) {
+		alSourceUnqueueBuffers( sourceId, unqueueCount, result );
+	}
+	checkAudioError();
+	return unqueueCount;
+}
+
+int COpenAlBackend::GetQueuedBufferCount( unsigned sourceId ) const
+{
+	int result;
+	alGetSourcei( sourceId, AL_BUFFERS_QUEUED, &result );
+	checkAudioError();
+	return result;
+}
+
+void COpenAlBackend::DetachBuffers( unsigned sourceId )
+{
+	alSourcei( sourceId, AL_BUFFER, 0 );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetListenerPosition( CVector3<float> position )
+{
+	alListenerfv( AEP_Position, position.Ptr() );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetListenerOrientation( CVector3<float> direction, CVector3<float> upVector )
+{
+	CVector<float, 6> orientation( direction, upVector );
+	alListenerfv( AEP_Orientation, orientation.Ptr() );
+	checkAudioError();
+}
+
+void COpenAlBackend::SetListenerVelocity( CVector3<float> velocity )
+{
+	alListenerfv( AEP_Velocity, velocity.Ptr() );
+	checkAudioError();
+}
+
+void COpenAlBackend::checkAudioError() const
+{
+	assert( alGetError() == AL_NO_ERROR );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
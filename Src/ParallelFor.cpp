@@ -0,0 +1,103 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <ParallelFor.h>
+#include <exception>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+int GetHardwareThreadCount()
+{
+	SYSTEM_INFO systemInfo;
+	::GetSystemInfo( &systemInfo );
+	return max( 1, static_cast<int>( systemInfo.dwNumberOfProcessors ) );
+}
+
+namespace GinInternal {
+
+// State shared by all the workers of a single RunParallelTasks call.
+struct CParallelTaskState {
+	TParallelTaskFunction Function;
+	void* Action;
+	int TaskCount;
+	volatile LONG NextTask;
+	volatile LONG IsCancelled;
+	// First exception thrown by a task. Written once under the cancellation flag.
+	std::exception_ptr Error;
+};
+
+struct CParallelWorkerParams {
+	CParallelTaskState* State;
+	int WorkerIndex;
+};
+
+static void runWorkerTasks( CParallelTaskState& state, int workerIndex )
+{
+	for( ;; ) {
+		const int taskIndex = ::InterlockedIncrement( &state.NextTask ) - 1;
+		if( taskIndex >= state.TaskCount || state.IsCancelled != 0 ) {
+			return;
+		}
+		try {
+			state.Function( state.Action, workerIndex, taskIndex );
+		} catch( ... ) {
+			if( ::InterlockedExchange( &state.IsCancelled, 1 ) == 0 ) {
+				state.Error = std::current_exception();
+			}
+			return;
+		}
+	}
+}
+
+static DWORD WINAPI parallelWorkerProc( void* param )
+{
+	const auto& workerParams = *static_cast<CParallelWorkerParams*>( param );
+	runWorkerTasks( *workerParams.State, workerParams.WorkerIndex );
+	return 0;
+}
+
+void RunParallelTasks( int taskCount, int workerCount, TParallelTaskFunction function, void* action )
+{
+	assert( workerCount > 0 );
+	if( taskCount <= 0 ) {
+		return;
+	}
+
+	CParallelTaskState state{ function, action, taskCount, 0, 0 };
+	// The calling thread is one of the workers. Thread count is limited by the wait function.
+	const auto threadCount = min( min( workerCount, taskCount ) - 1, MAXIMUM_WAIT_OBJECTS );
+	CArray<CParallelWorkerParams> workerParams;
+	CArray<HANDLE> threads;
+	workerParams.IncreaseSize( threadCount );
+	threads.ReserveBuffer( threadCount );
+	for( int i = 0; i < threadCount; i++ ) {
+		workerParams[i] = CParallelWorkerParams{ &state, i + 1 };
+		const auto thread = ::CreateThread( nullptr, 0, parallelWorkerProc, &workerParams[i], 0, nullptr );
+		if( thread == nullptr ) {
+			// The remaining work is done by the threads that have started.
+			break;
+		}
+		threads.Add( thread );
+	}
+
+	runWorkerTasks( state, 0 );
+	if( !threads.IsEmpty() ) {
+		::WaitForMultipleObjects( threads.Size(), threads.Ptr(), TRUE, INFINITE );
+		for( auto thread : threads ) {
+			::CloseHandle( thread );
+		}
+	}
+
+	if( state.Error != nullptr ) {
+		std::rethrow_exception( state.Error );
+	}
+}
+
+}	// namespace GinInternal.
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,501 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <PixelConverter.h>
+#include <ImageData.h>
+#include <ParallelFor.h>
+
+// SSE2 is a part of the x64 instruction set and is enabled by /arch:SSE2 on x86.
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#define GIN_PIXEL_CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Description of a pixel format.
+struct CPixelFormatInfo {
+	TTexelFormat TexelFormat;
+	TTexelDataType DataType;
+	int PixelSize;
+	// Byte offsets of the red, green, blue and alpha channels in 8-bit formats. NotFound for missing channels.
+	int ChannelOffsets[4];
+};
+
+static const CPixelFormatInfo pixelFormatInfos[PF_EnumCount] = {
+	{ TF_Red, TDT_UnsignedByte, 1, { 0, NotFound, NotFound, NotFound } },
+	{ TF_RG, TDT_UnsignedByte, 2, { 0, 1, NotFound, NotFound } },
+	{ TF_RGB, TDT_UnsignedByte, 3, { 0, 1, 2, NotFound } },
+	{ TF_BGR, TDT_UnsignedByte, 3, { 2, 1, 0, NotFound } },
+	{ TF_RGBA, TDT_UnsignedByte, 4, { 0, 1, 2, 3 } },
+	{ TF_BGRA, TDT_UnsignedByte, 4, { 2, 1, 0, 3 } },
+	{ TF_RGB, TDT_UnsignedShort565, 2, { NotFound, NotFound, NotFound, NotFound } },
+	{ TF_RGBA, TDT_HalfFloat, 8, { NotFound, NotFound, NotFound, NotFound } },
+	{ TF_RGBA, TDT_Float, 16, { NotFound, NotFound, NotFound, NotFound } }
+};
+
+static float srgbToLinear( float value )
+{
+	return value <= 0.04045f ? value / 12.92f : powf( ( value + 0.055f ) / 1.055f, 2.4f );
+}
+
+static float linearToSrgb( float value )
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * powf( value, 1.0f / 2.4f ) - 0.055f;
+}
+
+// Clamp the value to [0, 1]. NaN becomes zero.
+static float clampUnit( float value )
+{
+	return value > 0 ? ( value < 1 ? value : 1 ) : 0;
+}
+
+// Size of the table that converts linear values to 8-bit sRGB. Large enough to round trip every 8-bit color.
+static const int linearToSrgbTableSize = 16384;
+CPixelConverter::CPixelConverter()
+{
+	for( int i = 0; i < 256; i++ ) {
+		srgbToLinearTable[i] = srgbToLinear( i / 255.0f );
+	}
+	linearToSrgbTable.IncreaseSizeNoInitialize( linearToSrgbTableSize );
+	for( int i = 0; i < linearToSrgbTableSize; i++ ) {
+		const float value = linearToSrgb( i / static_cast<float>( linearToSrgbTableSize - 1 ) );
+		linearToSrgbTable[i] = static_cast<BYTE>( Round( value * 255 ) );
+	}
+}
+
+void CPixelConverter::SetWorkerCount( int newValue )
+{
+	assert( newValue > 0 );
+	workerCount = newValue;
+}
+
+int CPixelConverter::GetPixelSize( TPixelFormat format )
+{
+	assert( format > PF_Unknown && format < PF_EnumCount );
+	return pixelFormatInfos[format].PixelSize;
+}
+
+TPixelFormat CPixelConverter::FindPixelFormat( TTexelFormat texelFormat, TTexelDataType dataType )
+{
+	for( int i = 0; i < PF_EnumCount; i++ ) {
+		if( pixelFormatInfos[i].TexelFormat == texelFormat && pixelFormatInfos[i].DataType == dataType ) {
+			return static_cast<TPixelFormat>( i );
+		}
+	}
+	return PF_Unknown;
+}
+
+void CPixelConverter::GetTexelFormat( TPixelFormat format, TTexelFormat& texelFormat, TTexelDataType& dataType )
+{
+	assert( format > PF_Unknown && format < PF_EnumCount );
+	texelFormat = pixelFormatInfos[format].TexelFormat;
+	dataType = pixelFormatInfos[format].DataType;
+}
+
+// Number of pixels that go through the floating point buffer at once.
+static const int conversionChunkSize = 256;
+void CPixelConverter::ConvertPixels( const BYTE* src, TPixelFormat srcFormat, BYTE* dest, TPixelFormat destFormat, int pixelCount ) const
+{
+	assert( srcFormat > PF_Unknown && srcFormat < PF_EnumCount );
+	assert( destFormat > PF_Unknown && destFormat < PF_EnumCount );
+	const bool isLinearStage = isLinearStageNeeded();
+	if( !isLinearStage && isByteFormat( srcFormat ) && isByteFormat( destFormat ) ) {
+		reorderChannels( src, srcFormat, dest, destFormat, pixelCount );
+		return;
+	}
+
+	const int srcPixelSize = GetPixelSize( srcFormat );
+	const int destPixelSize = GetPixelSize( destFormat );
+	float buffer[conversionChunkSize * 4];
+	for( int pos = 0; pos < pixelCount; pos += conversionChunkSize ) {
+		const int chunkSize = min( conversionChunkSize, pixelCount - pos );
+		decodePixels( src + pos * srcPixelSize, srcFormat, isSourceSrgb && isLinearStage, buffer, chunkSize );
+		applyAlphaConversion( buffer, chunkSize );
+		encodePixels( buffer, chunkSize, destFormat, isDestSrgb && isLinearStage, dest + pos * destPixelSize );
+	}
+}
+
+// Number of pixels converted by a single task.
+static const int conversionTaskPixelCount = 64 * 1024;
+CImageData CPixelConverter::ConvertImage( const CImageData& source, TPixelFormat destFormat ) const
+{
+	assert( source.GetCompressionType() == TCT_Uncompressed );
+	const TPixelFormat srcFormat = FindPixelFormat( source.GetTexelFormat(), source.GetTexelDataType() );
+	assert( srcFormat != PF_Unknown );
+	TTexelFormat texelFormat;
+	TTexelDataType dataType;
+	GetTexelFormat( destFormat, texelFormat, dataType );
+
+	CImageData result( source.GetType(), source.Width(), source.Height(), source.Depth(), texelFormat, dataType, source.GetMipmapCount(), source.GetArrayCount() );
+	const int faceCount = source.GetCubeFaceCount();
+	const int imageCount = source.GetArrayCount() * faceCount;
+	const int srcPixelSize = GetPixelSize( srcFormat );
+	const int destPixelSize = GetPixelSize( destFormat );
+	for( int level = 0; level < source.GetMipmapCount(); level++ ) {
+		const int pixelCount = result.GetImageDataSize( level ) / destPixelSize;
+		const int taskCount = Ceil( pixelCount, conversionTaskPixelCount );
+		BYTE* destLevel = result.GetMipmapData( level ).Ptr();
+		auto convertRange = [&]( int, int taskIndex ) {
+			const int imagePos = taskIndex / taskCount;
+			const int firstPixel = ( taskIndex % taskCount ) * conversionTaskPixelCount;
+			const int rangeSize = min( conversionTaskPixelCount, pixelCount - firstPixel );
+			const BYTE* srcImage = source.GetImageData( level, imagePos / faceCount, imagePos % faceCount );
+			BYTE* destImage = destLevel + imagePos * pixelCount * destPixelSize;
+			ConvertPixels( srcImage + firstPixel * srcPixelSize, srcFormat, destImage + firstPixel * destPixelSize, destFormat, rangeSize );
+		};
+		ParallelFor( imageCount * taskCount, workerCount, convertRange );
+	}
+	return result;
+}
+
+// Colors have to be linear if the color space changes or alpha is applied.
+bool CPixelConverter::isLinearStageNeeded() const
+{
+	return alphaConversion != AC_None || isSourceSrgb != isDestSrgb;
+}
+
+bool CPixelConverter::isByteFormat( TPixelFormat format )
+{
+	return format >= PF_R8 && format <= PF_BGRA8;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifdef GIN_PIXEL_CONVERSION_SSE2
+
+// Exchange the first and the third byte of each 32-bit pixel.
+static __m128i swapRedBlue( __m128i pixels )
+{
+	const __m128i greenAlphaMask = _mm_set1_epi32( static_cast<int>( 0xFF00FF00 ) );
+	const __m128i redBlue = _mm_andnot_si128( greenAlphaMask, pixels );
+	// Shifted bytes that leave the 32-bit lane are discarded.
+	const __m128i swapped = _mm_or_si128( _mm_srli_epi32( redBlue, 16 ), _mm_slli_epi32( redBlue, 16 ) );
+	return _mm_or_si128( _mm_and_si128( greenAlphaMask, pixels ), swapped );
+}
+
+// Number of pixels in a single register of 8-bit four channel pixels.
+static const int registerPixelCount = sizeof( __m128i ) / 4;
+
+// Convert between RGBA8 and BGRA8. Return the number of processed pixels.
+static int swapRedBlueRegisters( const BYTE* src, BYTE* dest, int pixelCount )
+{
+	const int processedCount = pixelCount - pixelCount % registerPixelCount;
+	for( int pos = 0; pos < processedCount; pos += registerPixelCount ) {
+		const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + pos * 4 ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dest + pos * 4 ), swapRedBlue( pixels ) );
+	}
+	return processedCount;
+}
+
+// Decode 8-bit four channel pixels to RGBA floats. Return the number of processed pixels.
+static int decodeByteRegisters( const BYTE* src, bool isBgra, float* result, int pixelCount )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps( 1.0f / 255 );
+	const int processedCount = pixelCount - pixelCount % registerPixelCount;
+	for( int pos = 0; pos < processedCount; pos += registerPixelCount ) {
+		__m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + pos * 4 ) );
+		if( isBgra ) {
+			pixels = swapRedBlue( pixels );
+		}
+		const __m128i low = _mm_unpacklo_epi8( pixels, zero );
+		const __m128i high = _mm_unpackhi_epi8( pixels, zero );
+		const __m128i channels[registerPixelCount] = { _mm_unpacklo_epi16( low, zero ), _mm_unpackhi_epi16( low, zero ),
+			_mm_unpacklo_epi16( high, zero ), _mm_unpackhi_epi16( high, zero ) };
+		for( int i = 0; i < registerPixelCount; i++ ) {
+			_mm_storeu_ps( result + ( pos + i ) * 4, _mm_mul_ps( _mm_cvtepi32_ps( channels[i] ), scale ) );
+		}
+	}
+	return processedCount;
+}
+
+// Encode RGBA floats to 8-bit four channel pixels. Return the number of processed pixels.
+static int encodeByteRegisters( const float* pixels, bool isBgra, BYTE* result, int pixelCount )
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 scale = _mm_set1_ps( 255.0f );
+	const __m128 half = _mm_set1_ps( 0.5f );
+	const int processedCount = pixelCount - pixelCount % registerPixelCount;
+	for( int pos = 0; pos < processedCount; pos += registerPixelCount ) {
+		__m128i channels[registerPixelCount];
+		for( int i = 0; i < registerPixelCount; i++ ) {
+			// Maximum is taken first so that NaN becomes zero, the same as in clampUnit.
+			const __m128 value = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( pixels + ( pos + i ) * 4 ), zero ), one );
+			channels[i] = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( value, scale ), half ) );
+		}
+		__m128i bytes = _mm_packus_epi16( _mm_packs_epi32( channels[0], channels[1] ), _mm_packs_epi32( channels[2], channels[3] ) );
+		if( isBgra ) {
+			bytes = swapRedBlue( bytes );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( result + pos * 4 ), bytes );
+	}
+	return processedCount;
+}
+
+#else
+
+static int swapRedBlueRegisters( const BYTE*, BYTE*, int )
+{
+	return 0;
+}
+
+static int decodeByteRegisters( const BYTE*, bool, float*, int )
+{
+	return 0;
+}
+
+static int encodeByteRegisters( const float*, bool, BYTE*, int )
+{
+	return 0;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+void CPixelConverter::reorderChannels( const BYTE* src, TPixelFormat srcFormat, BYTE* dest, TPixelFormat destFormat, int pixelCount )
+{
+	const auto& srcInfo = pixelFormatInfos[srcFormat];
+	const auto& destInfo = pixelFormatInfos[destFormat];
+	if( srcFormat == destFormat ) {
+		memcpy( dest, src, pixelCount * srcInfo.PixelSize );
+		return;
+	}
+
+	int pos = 0;
+	if( ( srcFormat == PF_RGBA8 && destFormat == PF_BGRA8 ) || ( srcFormat == PF_BGRA8 && destFormat == PF_RGBA8 ) ) {
+		pos = swapRedBlueRegisters( src, dest, pixelCount );
+	}
+	for( ; pos < pixelCount; pos++ ) {
+		const BYTE* srcPixel = src + pos * srcInfo.PixelSize;
+		BYTE* destPixel = dest + pos * destInfo.PixelSize;
+		for( int i = 0; i < 4; i++ ) {
+			const int destOffset = destInfo.ChannelOffsets[i];
+			if( destOffset != NotFound ) {
+				const int srcOffset = srcInfo.ChannelOffsets[i];
+				destPixel[destOffset] = srcOffset != NotFound ? srcPixel[srcOffset] : ( i == 3 ? 255 : 0 );
+			}
+		}
+	}
+}
+
+static float halfToFloat( WORD value )
+{
+	const unsigned sign = ( value & 0x8000 ) << 16;
+	const unsigned exponent = ( value >> 10 ) & 0x1F;
+	unsigned mantissa = value & 0x3FF;
+	unsigned bits;
+	if( exponent == 0x1F ) {
+		// Infinity or NaN.
+		bits = sign | 0x7F800000 | ( mantissa << 13 );
+	} else if( exponent != 0 ) {
+		bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+	} else if( mantissa == 0 ) {
+		bits = sign;
+	} else {
+		// Denormal halves are normal floats.
+		unsigned floatExponent = 113;
+		while( ( mantissa & 0x400 ) == 0 ) {
+			mantissa <<= 1;
+			floatExponent--;
+		}
+		bits = sign | ( floatExponent << 23 ) | ( ( mantissa & 0x3FF ) << 13 );
+	}
+	float result;
+	memcpy( &result, &bits, sizeof( result ) );
+	return result;
+}
+
+// Convert a float to half with rounding to nearest even.
+static WORD floatToHalf( float value )
+{
+	unsigned bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	const unsigned sign = ( bits >> 16 ) & 0x8000;
+	const unsigned absBits = bits & 0x7FFFFFFF;
+	unsigned result;
+	if( absBits > 0x7F800000 ) {
+		// Quiet NaN.
+		result = 0x7E00;
+	} else if( absBits >= 0x477FF000 ) {
+		// Values that round above the largest half are infinite.
+		result = 0x7C00;
+	} else if( absBits >= 0x38800000 ) {
+		// Normal half. The exponent is rebiased and the mantissa is rounded to 10 bits.
+		result = ( absBits - 0x38000000 ) >> 13;
+		const unsigned remainder = absBits & 0x1FFF;
+		if( remainder > 0x1000 || ( remainder == 0x1000 && ( result & 1 ) != 0 ) ) {
+			result++;
+		}
+	} else {
+		// Denormal half in the units of 2^-24.
+		const int shift = 126 - static_cast<int>( absBits >> 23 );
+		if( shift > 24 ) {
+			result = 0;
+		} else {
+			const unsigned mantissa = ( absBits & 0x7FFFFF ) | 0x800000;
+			result = mantissa >> shift;
+			const unsigned remainder = mantissa & ( ( 1U << shift ) - 1 );
+			const unsigned halfway = 1U << ( shift - 1 );
+			if( remainder > halfway || ( remainder == halfway && ( result & 1 ) != 0 ) ) {
+				result++;
+			}
+		}
+	}
+	return static_cast<WORD>( sign | result );
+}
+
+void CPixelConverter::decodePixels( const BYTE* src, TPixelFormat format, bool convertSrgb, float* result, int pixelCount ) const
+{
+	switch( format ) {
+	case PF_RGB565:
+		for( int i = 0; i < pixelCount; i++ ) {
+			const int value = src[i * 2] | ( src[i * 2 + 1] << 8 );
+			float* pixel = result + i * 4;
+			pixel[0] = ( ( value >> 11 ) & 31 ) / 31.0f;
+			pixel[1] = ( ( value >> 5 ) & 63 ) / 63.0f;
+			pixel[2] = ( value & 31 ) / 31.0f;
+			pixel[3] = 1.0f;
+		}
+		break;
+	case PF_RGBA16F:
+		for( int i = 0; i < pixelCount * 4; i++ ) {
+			WORD value;
+			memcpy( &value, src + i * sizeof( value ), sizeof( value ) );
+			result[i] = halfToFloat( value );
+		}
+		break;
+	case PF_RGBA32F:
+		memcpy( result, src, pixelCount * 4 * sizeof( float ) );
+		break;
+	default: {
+		// 8-bit sRGB colors are converted with the table.
+		const auto& info = pixelFormatInfos[format];
+		int pos = 0;
+		if( !convertSrgb && info.PixelSize == 4 ) {
+			pos = decodeByteRegisters( src, format == PF_BGRA8, result, pixelCount );
+		}
+		for( ; pos < pixelCount; pos++ ) {
+			const BYTE* srcPixel = src + pos * info.PixelSize;
+			float* pixel = result + pos * 4;
+			for( int i = 0; i < 4; i++ ) {
+				const int offset = info.ChannelOffsets[i];
+				if( offset == NotFound ) {
+					pixel[i] = i == 3 ? 1.0f : 0.0f;
+				} else if( convertSrgb && i < 3 ) {
+					pixel[i] = srgbToLinearTable[srcPixel[offset]];
+				} else {
+					pixel[i] = srcPixel[offset] / 255.0f;
+				}
+			}
+		}
+		return;
+	}
+	}
+
+	if( convertSrgb ) {
+		for( int i = 0; i < pixelCount; i++ ) {
+			for( int j = 0; j < 3; j++ ) {
+				result[i * 4 + j] = srgbToLinear( result[i * 4 + j] );
+			}
+		}
+	}
+}
+
+void CPixelConverter::applyAlphaConversion( float* pixels, int pixelCount ) const
+{
+	if( alphaConversion == AC_None ) {
+		return;
+	}
+	for( int i = 0; i < pixelCount; i++ ) {
+		float* pixel = pixels + i * 4;
+		float factor;
+		if( alphaConversion == AC_Premultiply ) {
+			factor = pixel[3];
+		} else {
+			factor = pixel[3] > 0 ? 1 / pixel[3] : 0;
+		}
+		pixel[0] *= factor;
+		pixel[1] *= factor;
+		pixel[2] *= factor;
+	}
+}
+
+static BYTE encodeUnitValue( float value )
+{
+	return static_cast<BYTE>( clampUnit( value ) * 255 + 0.5f );
+}
+
+// Round a normalized value to the given number of bits.
+static int encodePackedValue( float value, int maxValue )
+{
+	return static_cast<int>( clampUnit( value ) * maxValue + 0.5f );
+}
+
+void CPixelConverter::encodePixels( const float* pixels, int pixelCount, TPixelFormat format, bool convertSrgb, BYTE* result ) const
+{
+	switch( format ) {
+	case PF_RGB565:
+		for( int i = 0; i < pixelCount; i++ ) {
+			const float* pixel = pixels + i * 4;
+			float color[3];
+			for( int j = 0; j < 3; j++ ) {
+				color[j] = convertSrgb ? linearToSrgb( clampUnit( pixel[j] ) ) : pixel[j];
+			}
+			const int value = ( encodePackedValue( color[0], 31 ) << 11 ) | ( encodePackedValue( color[1], 63 ) << 5 ) | encodePackedValue( color[2], 31 );
+			result[i * 2] = static_cast<BYTE>( value );
+			result[i * 2 + 1] = static_cast<BYTE>( value >> 8 );
+		}
+		break;
+	case PF_RGBA16F:
+		for( int i = 0; i < pixelCount * 4; i++ ) {
+			const bool isColor = i % 4 != 3;
+			const WORD value = floatToHalf( convertSrgb && isColor ? linearToSrgb( pixels[i] ) : pixels[i] );
+			memcpy( result + i * sizeof( value ), &value, sizeof( value ) );
+		}
+		break;
+	case PF_RGBA32F:
+		if( !convertSrgb ) {
+			memcpy( result, pixels, pixelCount * 4 * sizeof( float ) );
+			break;
+		}
+		for( int i = 0; i < pixelCount * 4; i++ ) {
+			const float value = i % 4 != 3 ? linearToSrgb( pixels[i] ) : pixels[i];
+			memcpy( result + i * sizeof( value ), &value, sizeof( value ) );
+		}
+		break;
+	default: {
+		const auto& info = pixelFormatInfos[format];
+		int pos = 0;
+		if( !convertSrgb && info.PixelSize == 4 ) {
+			pos = encodeByteRegisters( pixels, format == PF_BGRA8, result, pixelCount );
+		}
+		for( ; pos < pixelCount; pos++ ) {
+			const float* pixel = pixels + pos * 4;
+			BYTE* destPixel = result + pos * info.PixelSize;
+			for( int i = 0; i < 4; i++ ) {
+				const int offset = info.ChannelOffsets[i];
+				if( offset != NotFound ) {
+					destPixel[offset] = ( convertSrgb && i < 3 ) ? encodeSrgbColor( pixel[i] ) : encodeUnitValue( pixel[i] );
+				}
+			}
+		}
+		break;
+	}
+	}
+}
+
+BYTE CPixelConverter::encodeSrgbColor( float value ) const
+{
+	const int index = static_cast<int>( clampUnit( value ) * ( linearToSrgbTableSize - 1 ) + 0.5f );
+	return linearToSrgbTable[index];
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
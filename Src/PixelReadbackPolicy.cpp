@@ -0,0 +1,68 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <PixelReadbackPolicy.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CPixelReadbackPolicy::CPixelReadbackPolicy( int slotCount, int _minFrameDelay, int _maxFrameDelay ) :
+	minFrameDelay( _minFrameDelay ),
+	maxFrameDelay( _maxFrameDelay )
+{
+	assert( slotCount > 0 );
+	assert( minFrameDelay >= 0 && maxFrameDelay >= minFrameDelay );
+	slots.IncreaseSize( slotCount );
+}
+
+void CPixelReadbackPolicy::AdvanceFrame()
+{
+	currentFrame++;
+}
+
+int CPixelReadbackPolicy::AcquireSlot()
+{
+	if( pendingCount == slots.Size() ) {
+		statistics.BufferShortageCount++;
+		return NotFound;
+	}
+
+	const int slot = ( oldestSlot + pendingCount ) % slots.Size();
+	assert( slots[slot].State == RSS_Free );
+	slots[slot].State = RSS_Pending;
+	slots[slot].IssueFrame = currentFrame;
+	pendingCount++;
+	statistics.ReadbackCount++;
+	return slot;
+}
+
+int CPixelReadbackPolicy::FindCompletionCandidate() const
+{
+	if( pendingCount == 0 || currentFrame - slots[oldestSlot].IssueFrame < minFrameDelay ) {
+		return NotFound;
+	}
+	return oldestSlot;
+}
+
+bool CPixelReadbackPolicy::IsWaitRequired( int slot ) const
+{
+	assert( slots[slot].State == RSS_Pending );
+	return currentFrame - slots[slot].IssueFrame >= maxFrameDelay;
+}
+
+void CPixelReadbackPolicy::ReleaseSlot( int slot, bool hasStalled )
+{
+	assert( slot == oldestSlot && slots[slot].State == RSS_Pending );
+	slots[slot].State = RSS_Free;
+	oldestSlot = ( oldestSlot + 1 ) % slots.Size();
+	pendingCount--;
+	if( hasStalled ) {
+		statistics.StallCount++;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
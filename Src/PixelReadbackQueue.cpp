@@ -0,0 +1,121 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <PixelReadbackQueue.h>
+#include <GlWindowUtils.h>
+#include <Framebuffer.h>
+#include <GlBuffer.h>
+#include <GinError.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CPixelReadbackQueue::CPixelReadbackQueue( int bufferCount, int minFrameDelay, int maxFrameDelay ) :
+	policy( bufferCount, minFrameDelay, maxFrameDelay )
+{
+	for( int i = 0; i < bufferCount; i++ ) {
+		bufferIds.Add( GinInternal::CGlBufferOperations::CreateBufferId() );
+		bufferSizes.Add( 0 );
+		fences.Add( nullptr );
+	}
+	requests.IncreaseSize( bufferCount );
+}
+
+CPixelReadbackQueue::~CPixelReadbackQueue()
+{
+	for( int i = 0; i < bufferIds.Size(); i++ ) {
+		if( fences[i] != nullptr ) {
+			gl::DeleteSync( static_cast<GLsync>( fences[i] ) );
+		}
+		GinInternal::CGlBufferOperations::FreeBufferId( bufferIds[i] );
+	}
+}
+
+bool CPixelReadbackQueue::ReadScreenBuffer( TTexelFormat format, IPixelReadbackListener* listener, int readbackId )
+{
+	assert( format == TF_RGB || format == TF_BGR || format == TF_RGBA || format == TF_BGRA );
+	assert( CFramebufferSwitcher::GetReadTarget() == 0 );
+	const int slot = policy.AcquireSlot();
+	if( slot == NotFound ) {
+		return false;
+	}
+
+	const auto viewportSize = CViewportSwitcher::GetViewportSize();
+	const int pixelSize = format == TF_RGB || format == TF_BGR ? 3 : 4;
+	const int dataSize = CeilTo( pixelSize * viewportSize.X(), 4 ) * viewportSize.Y();
+	if( bufferSizes[slot] < dataSize ) {
+		GinInternal::CGlBufferOperations::ReserveBuffer( bufferIds[slot], dataSize, BT_PixelPack, BUH_StreamRead );
+		bufferSizes[slot] = dataSize;
+	}
+
+	CBufferObjectBinder packBinder( BT_PixelPack, bufferIds[slot] );
+	gl::PixelStorei( AT_Pack, 4 );
+	gl::ReadPixels( 0, 0, viewportSize.X(), viewportSize.Y(), format, TDT_UnsignedByte, nullptr );
+	gl::PixelStorei( AT_Pack, 1 );
+	fences[slot] = gl::FenceSync( gl::SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	CheckGlError();
+
+	auto& request = requests[slot];
+	request.Listener = listener;
+	request.ReadbackId = readbackId;
+	request.Size = viewportSize;
+	request.DataSize = dataSize;
+	return true;
+}
+
+void CPixelReadbackQueue::Update()
+{
+	// Fences are signaled in the issue order, the first unsignaled fence stops the search.
+	for( ;; ) {
+		const int slot = policy.FindCompletionCandidate();
+		if( slot == NotFound || !deliverReadback( slot, policy.IsWaitRequired( slot ) ) ) {
+			break;
+		}
+	}
+	policy.AdvanceFrame();
+}
+
+void CPixelReadbackQueue::Flush()
+{
+	for( int slot = policy.GetOldestPendingSlot(); slot != NotFound; slot = policy.GetOldestPendingSlot() ) {
+		deliverReadback( slot, true );
+	}
+}
+
+// Map the buffer of a finished readback and pass it to the listener. Return false if the readback is still in progress.
+bool CPixelReadbackQueue::deliverReadback( int slot, bool shouldWait )
+{
+	const auto fence = static_cast<GLsync>( fences[slot] );
+	const auto waitResult = shouldWait ? gl::ClientWaitSync( fence, gl::SYNC_FLUSH_COMMANDS_BIT, gl::TIMEOUT_IGNORED ) : gl::ClientWaitSync( fence, 0, 0 );
+	if( waitResult == gl::TIMEOUT_EXPIRED ) {
+		return false;
+	}
+	CheckGlError();
+	gl::DeleteSync( fence );
+	fences[slot] = nullptr;
+
+	const auto request = requests[slot];
+	policy.ReleaseSlot( slot, waitResult == gl::CONDITION_SATISFIED );
+
+	CBufferObjectBinder packBinder( BT_PixelPack, bufferIds[slot] );
+	const auto pixels = static_cast<const BYTE*>( gl::MapBufferRange( BT_PixelPack, 0, request.DataSize, gl::MAP_READ_BIT ) );
+	CheckGlError();
+	if( pixels == nullptr ) {
+		if( request.Listener != nullptr ) {
+			request.Listener->OnReadbackLost( request.ReadbackId );
+		}
+		return true;
+	}
+	if( request.Listener != nullptr ) {
+		request.Listener->OnReadbackComplete( request.ReadbackId, CArrayView<BYTE>( pixels, request.DataSize ), request.Size );
+	}
+	gl::UnmapBuffer( BT_PixelPack );
+	CheckGlError();
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
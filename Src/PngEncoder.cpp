@@ -0,0 +1,572 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <PngEncoder.h>
+#include <ParallelFor.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+static void writeBigEndian( DWORD value, BYTE* dest )
+{
+	dest[0] = static_cast<BYTE>( value >> 24 );
+	dest[1] = static_cast<BYTE>( value >> 16 );
+	dest[2] = static_cast<BYTE>( value >> 8 );
+	dest[3] = static_cast<BYTE>( value );
+}
+
+static DWORD readDword( const BYTE* src )
+{
+	DWORD result;
+	memcpy( &result, src, sizeof( result ) );
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Lookup table of the CRC-32 used by the PNG chunks.
+class CCrc32Table {
+public:
+	CCrc32Table();
+
+	DWORD Update( DWORD crc, const BYTE* data, int size ) const;
+
+private:
+	DWORD table[256];
+};
+
+CCrc32Table::CCrc32Table()
+{
+	for( DWORD i = 0; i < 256; i++ ) {
+		DWORD value = i;
+		for( int bit = 0; bit < 8; bit++ ) {
+			value = ( value & 1 ) != 0 ? 0xEDB88320 ^ ( value >> 1 ) : value >> 1;
+		}
+		table[i] = value;
+	}
+}
+
+DWORD CCrc32Table::Update( DWORD crc, const BYTE* data, int size ) const
+{
+	crc = ~crc;
+	for( int i = 0; i < size; i++ ) {
+		crc = table[( crc ^ data[i] ) & 0xFF] ^ ( crc >> 8 );
+	}
+	return ~crc;
+}
+
+static DWORD getCrc32( const BYTE* data, int size )
+{
+	static const CCrc32Table crcTable;
+	return crcTable.Update( 0, data, size );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const DWORD adlerBase = 65521;
+// Largest number of bytes that can be summed before the second sum overflows.
+static const int adlerBlockSize = 5552;
+static DWORD getAdler32( const BYTE* data, int size )
+{
+	DWORD sum1 = 1;
+	DWORD sum2 = 0;
+	while( size > 0 ) {
+		const int blockSize = min( size, adlerBlockSize );
+		for( int i = 0; i < blockSize; i++ ) {
+			sum1 += data[i];
+			sum2 += sum1;
+		}
+		sum1 %= adlerBase;
+		sum2 %= adlerBase;
+		data += blockSize;
+		size -= blockSize;
+	}
+	return sum1 | ( sum2 << 16 );
+}
+
+// Checksum of the concatenated data from the checksums of its two parts.
+static DWORD combineAdler32( DWORD adler1, DWORD adler2, int size2 )
+{
+	const DWORD remainder = static_cast<DWORD>( size2 ) % adlerBase;
+	DWORD sum1 = adler1 & 0xFFFF;
+	DWORD sum2 = ( remainder * sum1 ) % adlerBase;
+	sum1 += ( adler2 & 0xFFFF ) + adlerBase - 1;
+	sum2 += ( adler1 >> 16 ) + ( adler2 >> 16 ) + adlerBase - remainder;
+	sum1 %= adlerBase;
+	sum2 %= adlerBase;
+	return sum1 | ( sum2 << 16 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int endOfBlockSymbol = 256;
+static const int maxMatchLength = 258;
+static const int lengthSymbolCount = 29;
+static const int lengthBases[lengthSymbolCount] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int lengthExtraBits[lengthSymbolCount] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int distanceSymbolCount = 30;
+static const int distanceBases[distanceSymbolCount] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+	1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int distanceExtraBits[distanceSymbolCount] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static DWORD reverseBits( DWORD code, int bitCount )
+{
+	DWORD result = 0;
+	for( int i = 0; i < bitCount; i++ ) {
+		result = ( result << 1 ) | ( ( code >> i ) & 1 );
+	}
+	return result;
+}
+
+// Codes of the fixed Huffman deflate blocks. Codes are bit reversed, so they can be written starting from the lowest bit.
+struct CFixedHuffmanTables {
+	DWORD LiteralCodes[endOfBlockSymbol + 1];
+	BYTE LiteralBitCounts[endOfBlockSymbol + 1];
+	// Length codes together with their extra bits, indexed by the match length.
+	DWORD LengthCodes[maxMatchLength + 1];
+	BYTE LengthBitCounts[maxMatchLength + 1];
+	// Distance symbols indexed by distance - 1 for short distances and by 256 + ( distance - 1 ) / 128 for the rest.
+	BYTE DistanceSymbols[512];
+
+	CFixedHuffmanTables();
+};
+
+CFixedHuffmanTables::CFixedHuffmanTables()
+{
+	for( int symbol = 0; symbol <= endOfBlockSymbol; symbol++ ) {
+		if( symbol < 144 ) {
+			LiteralCodes[symbol] = reverseBits( 0x30 + symbol, 8 );
+			LiteralBitCounts[symbol] = 8;
+		} else if( symbol < 256 ) {
+			LiteralCodes[symbol] = reverseBits( 0x190 + symbol - 144, 9 );
+			LiteralBitCounts[symbol] = 9;
+		} else {
+			LiteralCodes[symbol] = reverseBits( symbol - 256, 7 );
+			LiteralBitCounts[symbol] = 7;
+		}
+	}
+
+	for( int symbol = 0; symbol < lengthSymbolCount; symbol++ ) {
+		// Length symbols start at 257. Symbols up to 279 have 7 bit codes, the rest have 8 bit codes starting at 0xC0.
+		const int lengthSymbol = 257 + symbol;
+		const int codeBitCount = lengthSymbol < 280 ? 7 : 8;
+		const DWORD code = lengthSymbol < 280 ? reverseBits( lengthSymbol - 256, 7 ) : reverseBits( 0xC0 + lengthSymbol - 280, 8 );
+		const int lengthEnd = symbol + 1 < lengthSymbolCount ? lengthBases[symbol + 1] : maxMatchLength + 1;
+		// Length 258 has its own symbol, the previous symbol stops at 257.
+		for( int length = lengthBases[symbol]; length < lengthEnd; length++ ) {
+			LengthCodes[length] = code | ( ( length - lengthBases[symbol] ) << codeBitCount );
+			LengthBitCounts[length] = static_cast<BYTE>( codeBitCount + lengthExtraBits[symbol] );
+		}
+	}
+
+	for( int symbol = 0; symbol < distanceSymbolCount; symbol++ ) {
+		const int firstDistance = distanceBases[symbol] - 1;
+		const int lastDistance = firstDistance + ( 1 << distanceExtraBits[symbol] );
+		for( int distance = firstDistance; distance < lastDistance; distance++ ) {
+			const int index = distance < 256 ? distance : 256 + ( distance >> 7 );
+			DistanceSymbols[index] = static_cast<BYTE>( symbol );
+		}
+	}
+}
+
+static const CFixedHuffmanTables& getFixedHuffmanTables()
+{
+	static const CFixedHuffmanTables tables;
+	return tables;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Writer of the deflate bit stream. Bits are packed starting from the lowest one.
+class CDeflateBitWriter {
+public:
+	explicit CDeflateBitWriter( BYTE* _dest ) : dest( _dest ) {}
+
+	void WriteBits( DWORD value, int bitCount );
+	// Write the remaining bits, the last byte is padded with zeros. Return the end of the written data.
+	BYTE* Finish();
+
+private:
+	BYTE* dest;
+	unsigned long long buffer = 0;
+	int bufferBitCount = 0;
+};
+
+void CDeflateBitWriter::WriteBits( DWORD value, int bitCount )
+{
+	buffer |= static_cast<unsigned long long>( value ) << bufferBitCount;
+	bufferBitCount += bitCount;
+	if( bufferBitCount >= 32 ) {
+		dest[0] = static_cast<BYTE>( buffer );
+		dest[1] = static_cast<BYTE>( buffer >> 8 );
+		dest[2] = static_cast<BYTE>( buffer >> 16 );
+		dest[3] = static_cast<BYTE>( buffer >> 24 );
+		dest += 4;
+		buffer >>= 32;
+		bufferBitCount -= 32;
+	}
+}
+
+BYTE* CDeflateBitWriter::Finish()
+{
+	for( ; bufferBitCount > 0; bufferBitCount -= 8 ) {
+		*dest++ = static_cast<BYTE>( buffer );
+		buffer >>= 8;
+	}
+	buffer = 0;
+	bufferBitCount = 0;
+	return dest;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int maxStoredBlockSize = 0xFFFF;
+static int getStoredSizeBound( int size )
+{
+	return size + 5 * ( size / maxStoredBlockSize + 1 );
+}
+
+// Write the data as uncompressed blocks. Only the last block of the last band is final.
+static BYTE* writeStoredBlocks( const BYTE* data, int size, bool isLastBand, BYTE* dest )
+{
+	int position = 0;
+	do {
+		const int blockSize = min( size - position, maxStoredBlockSize );
+		const bool isFinal = isLastBand && position + blockSize == size;
+		// Stored blocks start at a byte boundary, the header bits are padded to a full byte.
+		dest[0] = isFinal ? 1 : 0;
+		dest[1] = static_cast<BYTE>( blockSize );
+		dest[2] = static_cast<BYTE>( blockSize >> 8 );
+		dest[3] = static_cast<BYTE>( ~blockSize );
+		dest[4] = static_cast<BYTE>( ~blockSize >> 8 );
+		memcpy( dest + 5, data + position, blockSize );
+		dest += 5 + blockSize;
+		position += blockSize;
+	} while( position < size );
+	return dest;
+}
+
+static int getFixedHuffmanSizeBound( int size )
+{
+	// A literal takes at most 9 bits, a match is never longer than the literals it replaces.
+	// The end of the block and the alignment block take another 7 bytes.
+	return size + size / 8 + 8;
+}
+
+static const int minMatchLength = 4;
+static const int maxMatchDistance = 32768;
+static const int matchHashBits = 15;
+static const int matchHashSize = 1 << matchHashBits;
+// Compress the data to a single fixed Huffman block. Matches are found with a hash table of the last positions of 4 byte sequences.
+// Bands are compressed independently, so all bands except the last one end with an empty stored block that aligns the stream to a byte.
+static BYTE* writeFixedHuffmanBlock( const BYTE* data, int size, bool isLastBand, int* hashHeads, BYTE* dest )
+{
+	const auto& tables = getFixedHuffmanTables();
+	CDeflateBitWriter writer( dest );
+	// Final flag and the fixed Huffman block type.
+	writer.WriteBits( isLastBand ? 3 : 2, 3 );
+
+	memset( hashHeads, 0xFF, matchHashSize * sizeof( int ) );
+	int position = 0;
+	for( const int matchEnd = size - minMatchLength; position <= matchEnd; ) {
+		const DWORD sequence = readDword( data + position );
+		const DWORD hash = ( sequence * 2654435761u ) >> ( 32 - matchHashBits );
+		const int candidate = hashHeads[hash];
+		hashHeads[hash] = position;
+		if( candidate < 0 || position - candidate > maxMatchDistance || readDword( data + candidate ) != sequence ) {
+			writer.WriteBits( tables.LiteralCodes[data[position]], tables.LiteralBitCounts[data[position]] );
+			position++;
+			continue;
+		}
+
+		const int lengthLimit = min( maxMatchLength, size - position );
+		int length = minMatchLength;
+		while( length < lengthLimit && data[candidate + length] == data[position + length] ) {
+			length++;
+		}
+		writer.WriteBits( tables.LengthCodes[length], tables.LengthBitCounts[length] );
+		const int distance = position - candidate - 1;
+		const int distanceSymbol = tables.DistanceSymbols[distance < 256 ? distance : 256 + ( distance >> 7 )];
+		const DWORD distanceExtra = distance - ( distanceBases[distanceSymbol] - 1 );
+		writer.WriteBits( reverseBits( distanceSymbol, 5 ) | ( distanceExtra << 5 ), 5 + distanceExtraBits[distanceSymbol] );
+		position += length;
+	}
+	for( ; position < size; position++ ) {
+		writer.WriteBits( tables.LiteralCodes[data[position]], tables.LiteralBitCounts[data[position]] );
+	}
+	writer.WriteBits( tables.LiteralCodes[endOfBlockSymbol], tables.LiteralBitCounts[endOfBlockSymbol] );
+
+	if( isLastBand ) {
+		return writer.Finish();
+	}
+	// Header of an empty stored block followed by its length and the length complement.
+	writer.WriteBits( 0, 3 );
+	BYTE* result = writer.Finish();
+	result[0] = 0;
+	result[1] = 0;
+	result[2] = 0xFF;
+	result[3] = 0xFF;
+	return result + 4;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Filter type byte that precedes each row.
+enum TPngFilterType {
+	PFT_None,
+	PFT_Sub,
+	PFT_Up,
+	PFT_Average,
+	PFT_Paeth
+};
+
+static int getPaethPredictor( int left, int up, int upLeft )
+{
+	const int leftDistance = abs( up - upLeft );
+	const int upDistance = abs( left - upLeft );
+	const int upLeftDistance = abs( left + up - 2 * upLeft );
+	if( leftDistance <= upDistance && leftDistance <= upLeftDistance ) {
+		return left;
+	}
+	return upDistance <= upLeftDistance ? up : upLeft;
+}
+
+static void applyFilter( TPngFilterType type, const BYTE* row, const BYTE* prevRow, int rowSize, int pixelSize, BYTE* result )
+{
+	result[0] = static_cast<BYTE>( type );
+	BYTE* dest = result + 1;
+	switch( type ) {
+	case PFT_None:
+		memcpy( dest, row, rowSize );
+		break;
+	case PFT_Sub:
+		memcpy( dest, row, pixelSize );
+		for( int i = pixelSize; i < rowSize; i++ ) {
+			dest[i] = static_cast<BYTE>( row[i] - row[i - pixelSize] );
+		}
+		break;
+	case PFT_Up:
+		for( int i = 0; i < rowSize; i++ ) {
+			dest[i] = static_cast<BYTE>( row[i] - prevRow[i] );
+		}
+		break;
+	case PFT_Paeth:
+		for( int i = 0; i < pixelSize; i++ ) {
+			dest[i] = static_cast<BYTE>( row[i] - prevRow[i] );
+		}
+		for( int i = pixelSize; i < rowSize; i++ ) {
+			dest[i] = static_cast<BYTE>( row[i] - getPaethPredictor( row[i - pixelSize], prevRow[i], prevRow[i - pixelSize] ) );
+		}
+		break;
+	default:
+		assert( false );
+	}
+}
+
+// Sum of the filtered bytes taken as signed values. Smaller sums usually compress better.
+static int getFilteredRowCost( const BYTE* filteredRow, int rowSize )
+{
+	int result = 0;
+	for( int i = 0; i < rowSize; i++ ) {
+		result += abs( static_cast<signed char>( filteredRow[i] ) );
+	}
+	return result;
+}
+
+// Filter a row according to the strategy. The candidate buffer of the same size as the result is used by the minimum sum strategy.
+void CPngEncoder::filterRow( const BYTE* row, const BYTE* prevRow, int rowSize, int pixelSize, BYTE* result, BYTE* candidate ) const
+{
+	switch( filterStrategy ) {
+	case PFS_None:
+		applyFilter( PFT_None, row, prevRow, rowSize, pixelSize, result );
+		break;
+	case PFS_Sub:
+		applyFilter( PFT_Sub, row, prevRow, rowSize, pixelSize, result );
+		break;
+	case PFS_Up:
+		applyFilter( PFT_Up, row, prevRow, rowSize, pixelSize, result );
+		break;
+	case PFS_Paeth:
+		applyFilter( PFT_Paeth, row, prevRow, rowSize, pixelSize, result );
+		break;
+	case PFS_MinimumSum: {
+		applyFilter( PFT_None, row, prevRow, rowSize, pixelSize, result );
+		int bestCost = getFilteredRowCost( result + 1, rowSize );
+		const TPngFilterType candidateTypes[] = { PFT_Sub, PFT_Up, PFT_Paeth };
+		for( TPngFilterType type : candidateTypes ) {
+			applyFilter( type, row, prevRow, rowSize, pixelSize, candidate );
+			const int cost = getFilteredRowCost( candidate + 1, rowSize );
+			if( cost < bestCost ) {
+				bestCost = cost;
+				memcpy( result, candidate, rowSize + 1 );
+			}
+		}
+		break;
+	}
+	default:
+		assert( false );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void CPngEncoder::SetWorkerCount( int newValue )
+{
+	assert( newValue > 0 );
+	workerCount = newValue;
+}
+
+static const BYTE pngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+// Length, type and checksum of a chunk.
+static const int chunkFrameSize = 12;
+static BYTE* writeChunk( const char* type, const BYTE* data, int size, BYTE* dest )
+{
+	writeBigEndian( size, dest );
+	memcpy( dest + 4, type, 4 );
+	if( size > 0 ) {
+		memcpy( dest + 8, data, size );
+	}
+	writeBigEndian( getCrc32( dest + 4, size + 4 ), dest + 8 + size );
+	return dest + chunkFrameSize + size;
+}
+
+// Size of the filtered data of a single band. Bigger bands compress slightly better, smaller bands are distributed between the workers more evenly.
+static const int bandTargetSize = 1 << 18;
+// Deflate stream header: 32K window, the fastest compression level.
+static const BYTE zlibHeader[] = { 0x78, 0x01 };
+void CPngEncoder::Encode( CArrayView<BYTE> pixels, TTexelFormat format, int scanLineWidth, CVector2<int> size, CArray<BYTE>& result ) const
+{
+	assert( format == TF_RGB || format == TF_RGBA );
+	assert( size.X() > 0 && size.Y() > 0 );
+	const int width = size.X();
+	const int height = size.Y();
+	const int pixelSize = format == TF_RGB ? 3 : 4;
+	const int rowSize = width * pixelSize;
+	const int rowStride = abs( scanLineWidth );
+	assert( rowStride >= rowSize && pixels.Size() >= rowStride * ( height - 1 ) + rowSize );
+	const auto getRow = [&]( int y ) {
+		const int rowIndex = scanLineWidth < 0 ? height - 1 - y : y;
+		return pixels.Ptr() + rowIndex * rowStride;
+	};
+
+	const int filteredRowSize = rowSize + 1;
+	const int bandRowCount = max( 1, bandTargetSize / filteredRowSize );
+	const int bandCount = Ceil( height, bandRowCount );
+	const int maxBandSize = min( bandRowCount, height ) * filteredRowSize;
+	const int maxDeflateSize = max( getStoredSizeBound( maxBandSize ), getFixedHuffmanSizeBound( maxBandSize ) );
+
+	// Each band is written to its own IDAT chunk.
+	CArray<CArray<BYTE>> bandChunks;
+	bandChunks.IncreaseSize( bandCount );
+	CArray<int> bandChunkSizes;
+	bandChunkSizes.IncreaseSize( bandCount );
+	CArray<DWORD> bandChecksums;
+	bandChecksums.IncreaseSize( bandCount );
+	CArray<int> bandSizes;
+	bandSizes.IncreaseSize( bandCount );
+
+	const int bandWorkerCount = min( workerCount, bandCount );
+	CArray<CArray<BYTE>> workerFilteredData;
+	workerFilteredData.IncreaseSize( bandWorkerCount );
+	CArray<CArray<int>> workerHashHeads;
+	workerHashHeads.IncreaseSize( bandWorkerCount );
+	// The row above the image is zero.
+	CArray<BYTE> zeroRow;
+	zeroRow.IncreaseSize( rowSize );
+
+	auto encodeBand = [&]( int workerIndex, int bandIndex ) {
+		auto& filtered = workerFilteredData[workerIndex];
+		if( filtered.IsEmpty() ) {
+			// The extra row is the candidate buffer of the filter.
+			filtered.IncreaseSizeNoInitialize( maxBandSize + filteredRowSize );
+		}
+		const int firstRow = bandIndex * bandRowCount;
+		const int rowEnd = min( height, firstRow + bandRowCount );
+		BYTE* candidateRow = filtered.Ptr() + maxBandSize;
+		for( int y = firstRow; y < rowEnd; y++ ) {
+			const BYTE* prevRow = y > 0 ? getRow( y - 1 ) : zeroRow.Ptr();
+			filterRow( getRow( y ), prevRow, rowSize, pixelSize, filtered.Ptr() + ( y - firstRow ) * filteredRowSize, candidateRow );
+		}
+		const int bandSize = ( rowEnd - firstRow ) * filteredRowSize;
+		bandSizes[bandIndex] = bandSize;
+		bandChecksums[bandIndex] = getAdler32( filtered.Ptr(), bandSize );
+
+		auto& chunk = bandChunks[bandIndex];
+		chunk.IncreaseSizeNoInitialize( chunkFrameSize + sizeof( zlibHeader ) + maxDeflateSize );
+		BYTE* const chunkData = chunk.Ptr() + 8;
+		BYTE* dest = chunkData;
+		if( bandIndex == 0 ) {
+			memcpy( dest, zlibHeader, sizeof( zlibHeader ) );
+			dest += sizeof( zlibHeader );
+		}
+		const bool isLastBand = bandIndex == bandCount - 1;
+		BYTE* dataEnd = dest;
+		if( compressionLevel == PCL_Fast ) {
+			auto& hashHeads = workerHashHeads[workerIndex];
+			if( hashHeads.IsEmpty() ) {
+				hashHeads.IncreaseSizeNoInitialize( matchHashSize );
+			}
+			dataEnd = writeFixedHuffmanBlock( filtered.Ptr(), bandSize, isLastBand, hashHeads.Ptr(), dest );
+		}
+		if( compressionLevel == PCL_Store || dataEnd - dest > getStoredSizeBound( bandSize ) ) {
+			// Data that doesn't compress is stored as is.
+			dataEnd = writeStoredBlocks( filtered.Ptr(), bandSize, isLastBand, dest );
+		}
+
+		const int chunkDataSize = static_cast<int>( dataEnd - chunkData );
+		writeBigEndian( chunkDataSize, chunk.Ptr() );
+		memcpy( chunk.Ptr() + 4, "IDAT", 4 );
+		writeBigEndian( getCrc32( chunk.Ptr() + 4, chunkDataSize + 4 ), dataEnd );
+		bandChunkSizes[bandIndex] = chunkDataSize + chunkFrameSize;
+	};
+	ParallelFor( bandCount, bandWorkerCount, encodeBand );
+
+	DWORD checksum = bandChecksums[0];
+	int resultSize = sizeof( pngSignature ) + ( chunkFrameSize + 13 ) + bandChunkSizes[0] + ( chunkFrameSize + 4 ) + chunkFrameSize;
+	for( int i = 1; i < bandCount; i++ ) {
+		checksum = combineAdler32( checksum, bandChecksums[i], bandSizes[i] );
+		resultSize += bandChunkSizes[i];
+	}
+
+	result.Empty();
+	result.IncreaseSizeNoInitialize( resultSize );
+	BYTE* dest = result.Ptr();
+	memcpy( dest, pngSignature, sizeof( pngSignature ) );
+	dest += sizeof( pngSignature );
+
+	BYTE header[13];
+	writeBigEndian( width, header );
+	writeBigEndian( height, header + 4 );
+	// Bit depth, color type, compression method, filter method and interlace method.
+	header[8] = 8;
+	header[9] = format == TF_RGB ? 2 : 6;
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+	dest = writeChunk( "IHDR", header, sizeof( header ), dest );
+
+	for( int i = 0; i < bandCount; i++ ) {
+		memcpy( dest, bandChunks[i].Ptr(), bandChunkSizes[i] );
+		dest += bandChunkSizes[i];
+	}
+	// The deflate stream checksum is only known when all the bands are done, it gets its own chunk.
+	BYTE streamChecksum[4];
+	writeBigEndian( checksum, streamChecksum );
+	dest = writeChunk( "IDAT", streamChecksum, sizeof( streamChecksum ), dest );
+	dest = writeChunk( "IEND", nullptr, 0, dest );
+	assert( dest == result.Ptr() + resultSize );
+}
+
+void CPngEncoder::WriteFile( CStringPart fileName, CArrayView<BYTE> pixels, TTexelFormat format, int scanLineWidth, CVector2<int> size ) const
+{
+	CArray<BYTE> fileData;
+	Encode( pixels, format, scanLineWidth, size, fileData );
+	CFileWriter file( fileName, FCM_CreateAlways );
+	file.Write( fileData.Ptr(), fileData.Size() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -7,7 +7,8 @@
 #include <RenderMechanism.h>
 #include <GlWindowUtils.h>
 #include <DrawEnums.h>
-#include <PngFile.h>
+#include <PngEncoder.h>
+#include <ParallelFor.h>
 
 namespace Gin {
 
@@ -41,9 +42,54 @@ void MakeScreenshot()
 	const auto data = GinInternal::GetMainFrame().GetRenderer().ReadScreenBuffer( TF_RGB, screenSize );
 
 	// Write buffer to file.
-	CPngFile pngFile( CreateUniqueImageName() );
+	CPngEncoder encoder;
+	encoder.SetWorkerCount( GetHardwareThreadCount() );
 	const int scanLineWidth = -CeilTo( screenSize.X() * 3, sizeof( DWORD ) );
-	pngFile.Write( data, PCF_RGB, scanLineWidth, screenSize );
+	encoder.WriteFile( CreateUniqueImageName(), data, TF_RGB, scanLineWidth, screenSize );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CScreenshotQueue::CScreenshotQueue() = default;
+
+CScreenshotQueue::~CScreenshotQueue()
+{
+	Flush();
+}
+
+bool CScreenshotQueue::MakeScreenshot()
+{
+	const bool isStarted = readbackQueue.ReadScreenBuffer( TF_RGB, this, nextReadbackId );
+	if( isStarted ) {
+		nextReadbackId++;
+	}
+	return isStarted;
+}
+
+void CScreenshotQueue::Update()
+{
+	readbackQueue.Update();
+}
+
+void CScreenshotQueue::Flush()
+{
+	readbackQueue.Flush();
+	encodeQueue.Flush();
+}
+
+void CScreenshotQueue::OnReadbackComplete( int, CArrayView<BYTE> pixels, CVector2<int> size )
+{
+	CImageEncodeJob job;
+	job.Pixels.IncreaseSizeNoInitialize( pixels.Size() );
+	memcpy( job.Pixels.Ptr(), pixels.Ptr(), pixels.Size() );
+	job.Size = size;
+	// Screenshots are rare, waiting for the encoder is preferred to losing one.
+	encodeQueue.AddJob( move( job ) );
+}
+
+void CScreenshotQueue::OnReadbackLost( int )
+{
+	lostCount++;
 }
 
 //////////////////////////////////////////////////////////////////////////
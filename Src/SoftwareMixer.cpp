@@ -0,0 +1,532 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <SoftwareMixer.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+CSoftwareMixer::CSoftwareMixer( CPtrOwner<IAudioSink> _sink, int _sampleRate ) :
+	sink( move( _sink ) ),
+	sampleRate( _sampleRate ),
+	listenerDirection( 0.f, 0.f, -1.f ),
+	listenerUpVector( 0.f, 1.f, 0.f )
+{
+	assert( sink != nullptr );
+	assert( sampleRate > 0 );
+}
+
+void CSoftwareMixer::SetReferenceDistance( float newValue )
+{
+	assert( newValue >= 0.0f );
+	referenceDistance = newValue;
+}
+
+void CSoftwareMixer::SetMaxDistance( float newValue )
+{
+	assert( newValue >= 0.0f );
+	maxDistance = newValue;
+}
+
+void CSoftwareMixer::SetRolloffFactor( float newValue )
+{
+	assert( newValue >= 0.0f );
+	rolloffFactor = newValue;
+}
+
+void CSoftwareMixer::Render( int frameCount )
+{
+	renderBuffer.Empty();
+	Mix( frameCount, renderBuffer );
+	sink->WriteFrames( renderBuffer, sampleRate );
+}
+
+void CSoftwareMixer::Mix( int frameCount, CArray<float>& result )
+{
+	assert( frameCount >= 0 );
+	const int resultOffset = result.Size();
+	result.IncreaseSizeNoInitialize( resultOffset + 2 * frameCount );
+	float* dest = result.Ptr() + resultOffset;
+	memset( dest, 0, 2 * frameCount * sizeof( float ) );
+
+	mixedSourceCount = 0;
+	for( auto& source : sources ) {
+		if( source.IsUsed && source.State == CAudioRecord::RS_Playing ) {
+			mixSource( source, frameCount, dest );
+			mixedSourceCount++;
+		}
+	}
+}
+
+// Scale of the frame position fraction.
+static const double framePosScale = 4294967296.0;
+static const float fractionToFloat = 1.0f / 4294967296.0f;
+static const __int64 fractionMask = 0xFFFFFFFF;
+// Add the frames of the source to the result.
+void CSoftwareMixer::mixSource( CMixerSource& source, int frameCount, float* result ) const
+{
+	int frame = 0;
+	while( frame < frameCount ) {
+		if( !findPlayingBuffer( source ) ) {
+			// All the buffers are processed.
+			source.State = CAudioRecord::RS_Stopped;
+			source.QueuePos = source.Queue.Size();
+			source.FramePos = 0;
+			return;
+		}
+
+		const auto& buffer = buffers[source.Queue[source.QueuePos] - 1];
+		float leftGain;
+		float rightGain;
+		getChannelGains( source, buffer.ChannelCount, leftGain, rightGain );
+		const __int64 step = max( 1LL, static_cast<__int64>( source.Pitch * static_cast<double>( buffer.Frequency ) / sampleRate * framePosScale ) );
+
+		// Frames that are interpolated between two samples of the current buffer.
+		__int64 pos = source.FramePos;
+		const __int64 innerEnd = static_cast<__int64>( buffer.FrameCount - 1 ) << 32;
+		int runCount = 0;
+		if( pos < innerEnd ) {
+			runCount = static_cast<int>( min( static_cast<__int64>( frameCount - frame ), ( innerEnd - pos + step - 1 ) / step ) );
+		}
+
+		float* dest = result + 2 * frame;
+		const float* samples = buffer.Samples.Ptr();
+		if( buffer.ChannelCount == 1 ) {
+			for( int i = 0; i < runCount; i++ ) {
+				const int index = static_cast<int>( pos >> 32 );
+				const float fraction = ( pos & fractionMask ) * fractionToFloat;
+				const float sample = samples[index] + ( samples[index + 1] - samples[index] ) * fraction;
+				dest[2 * i] += sample * leftGain;
+				dest[2 * i + 1] += sample * rightGain;
+				pos += step;
+			}
+		} else {
+			for( int i = 0; i < runCount; i++ ) {
+				const int index = 2 * static_cast<int>( pos >> 32 );
+				const float fraction = ( pos & fractionMask ) * fractionToFloat;
+				dest[2 * i] += ( samples[index] + ( samples[index + 2] - samples[index] ) * fraction ) * leftGain;
+				dest[2 * i + 1] += ( samples[index + 1] + ( samples[index + 3] - samples[index + 1] ) * fraction ) * rightGain;
+				pos += step;
+			}
+		}
+
+		if( runCount == 0 ) {
+			// The last frame of the buffer is interpolated with the start of the next one.
+			const int index = buffer.ChannelCount * static_cast<int>( pos >> 32 );
+			const float fraction = ( pos & fractionMask ) * fractionToFloat;
+			const int rightChannel = buffer.ChannelCount - 1;
+			const float left = samples[index] + ( getNextBufferSample( source, 0 ) - samples[index] ) * fraction;
+			const float right = samples[index + rightChannel] + ( getNextBufferSample( source, rightChannel ) - samples[index + rightChannel] ) * fraction;
+			dest[0] += left * leftGain;
+			dest[1] += right * rightGain;
+			pos += step;
+			runCount = 1;
+		}
+		source.FramePos = pos;
+		frame += runCount;
+	}
+}
+
+// Skip the played buffers of the queue. Return false if the queue has ended.
+bool CSoftwareMixer::findPlayingBuffer( CMixerSource& source ) const
+{
+	// A looping queue of empty buffers would never end, so the number of skipped buffers is limited.
+	for( int skipCount = 0; skipCount <= source.Queue.Size(); skipCount++ ) {
+		if( source.QueuePos == source.Queue.Size() ) {
+			if( !source.IsLooping || source.Queue.IsEmpty() ) {
+				return false;
+			}
+			source.QueuePos = 0;
+		}
+		const __int64 bufferEnd = static_cast<__int64>( buffers[source.Queue[source.QueuePos] - 1].FrameCount ) << 32;
+		if( source.FramePos < bufferEnd ) {
+			return true;
+		}
+		source.FramePos -= bufferEnd;
+		source.QueuePos++;
+	}
+	return false;
+}
+
+// Get the first sample of the buffer that follows the playing one. Silence follows the end of the queue.
+float CSoftwareMixer::getNextBufferSample( const CMixerSource& source, int channel ) const
+{
+	int nextPos = source.QueuePos + 1;
+	if( nextPos == source.Queue.Size() ) {
+		if( !source.IsLooping ) {
+			return 0.0f;
+		}
+		nextPos = 0;
+	}
+	const auto& nextBuffer = buffers[source.Queue[nextPos] - 1];
+	return nextBuffer.FrameCount > 0 ? nextBuffer.Samples[min( channel, nextBuffer.ChannelCount - 1 )] : 0.0f;
+}
+
+static float dotProduct( CVector3<float> left, CVector3<float> right )
+{
+	return left.X() * right.X() + left.Y() * right.Y() + left.Z() * right.Z();
+}
+
+static CVector3<float> crossProduct( CVector3<float> left, CVector3<float> right )
+{
+	return CVector3<float>( left.Y() * right.Z() - left.Z() * right.Y(), left.Z() * right.X() - left.X() * right.Z(), left.X() * right.Y() - left.Y() * right.X() );
+}
+
+static const float quarterPi = 0.785398163f;
+// Get the gains of the output channels.
+void CSoftwareMixer::getChannelGains( const CMixerSource& source, int channelCount, float& leftGain, float& rightGain ) const
+{
+	if( channelCount == 2 ) {
+		// Stereo sources are not spatialized.
+		leftGain = source.Gain;
+		rightGain = source.Gain;
+		return;
+	}
+
+	// Position of the source relative to the listener and its projection on the listener right axis.
+	float distance;
+	float rightOffset;
+	if( source.IsRelative ) {
+		// Relative sources are set in the listener space with the X axis directed to the right.
+		distance = sqrtf( dotProduct( source.Position, source.Position ) );
+		rightOffset = source.Position.X();
+	} else {
+		const CVector3<float> offset( source.Position.X() - listenerPosition.X(), source.Position.Y() - listenerPosition.Y(), source.Position.Z() - listenerPosition.Z() );
+		const CVector3<float> rightAxis = crossProduct( listenerDirection, listenerUpVector );
+		const float rightAxisLength = sqrtf( dotProduct( rightAxis, rightAxis ) );
+		distance = sqrtf( dotProduct( offset, offset ) );
+		rightOffset = rightAxisLength > 0.0f ? dotProduct( offset, rightAxis ) / rightAxisLength : 0.0f;
+	}
+
+	const float pan = distance > 0.0f ? max( -1.0f, min( 1.0f, rightOffset / distance ) ) : 0.0f;
+	// Constant power pan law.
+	const float angle = ( pan + 1.0f ) * quarterPi;
+	const float gain = source.Gain * GetDistanceGain( distance );
+	leftGain = gain * cosf( angle );
+	rightGain = gain * sinf( angle );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void CSoftwareMixer::CreateBuffers( int count, unsigned* result )
+{
+	for( int i = 0; i < count; i++ ) {
+		unsigned bufferId;
+		if( freeBufferIds.IsEmpty() ) {
+			bufferId = buffers.Size() + 1;
+			buffers.IncreaseSize( bufferId );
+		} else {
+			bufferId = freeBufferIds.Last();
+			freeBufferIds.DeleteLast();
+		}
+		auto& buffer = buffers[bufferId - 1];
+		buffer.ChannelCount = 1;
+		buffer.FrameCount = 0;
+		buffer.Frequency = sampleRate;
+		buffer.IsUsed = true;
+		result[i] = bufferId;
+	}
+}
+
+void CSoftwareMixer::DeleteBuffers( int count, const unsigned* bufferIds )
+{
+	for( int i = 0; i < count; i++ ) {
+		// Zero identifiers are ignored.
+		if( bufferIds[i] != 0 ) {
+			auto& buffer = getBuffer( bufferIds[i] );
+			buffer.Samples.Empty();
+			buffer.IsUsed = false;
+			freeBufferIds.Add( bufferIds[i] );
+		}
+	}
+}
+
+// Scale of the integer samples to the [-1, 1) range.
+static const float pcm8Scale = 1.0f / 128.0f;
+static const float pcm16Scale = 1.0f / 32768.0f;
+void CSoftwareMixer::SetBufferData( unsigned bufferId, TAudioDataFormat format, int frequency, const void* data, int size )
+{
+	assert( frequency > 0 );
+	auto& buffer = getBuffer( bufferId );
+	const bool isStereo = format == ADF_Stereo8 || format == ADF_Stereo16 || format == ADF_StereoFloat32;
+	buffer.ChannelCount = isStereo ? 2 : 1;
+	buffer.Frequency = frequency;
+
+	const int sampleSize = ( format == ADF_Mono8 || format == ADF_Stereo8 ) ? 1 : ( format == ADF_Mono16 || format == ADF_Stereo16 ) ? 2 : 4;
+	buffer.FrameCount = size / ( sampleSize * buffer.ChannelCount );
+	const int sampleCount = buffer.FrameCount * buffer.ChannelCount;
+	buffer.Samples.Empty();
+	buffer.Samples.IncreaseSizeNoInitialize( sampleCount );
+	float* dest = buffer.Samples.Ptr();
+	switch( sampleSize ) {
+	case 1: {
+		// 8 bit samples are unsigned.
+		const BYTE* src = static_cast<const BYTE*>( data );
+		for( int i = 0; i < sampleCount; i++ ) {
+			dest[i] = ( src[i] - 128 ) * pcm8Scale;
+		}
+		break;
+	}
+	case 2: {
+		const short* src = static_cast<const short*>( data );
+		for( int i = 0; i < sampleCount; i++ ) {
+			dest[i] = src[i] * pcm16Scale;
+		}
+		break;
+	}
+	default:
+		memcpy( dest, data, sampleCount * sizeof( float ) );
+		break;
+	}
+}
+
+float CSoftwareMixer::GetBufferDuration( unsigned bufferId ) const
+{
+	const auto& buffer = buffers[bufferId - 1];
+	return static_cast<float>( buffer.FrameCount ) / buffer.Frequency;
+}
+
+unsigned CSoftwareMixer::CreateSource()
+{
+	unsigned sourceId;
+	if( freeSourceIds.IsEmpty() ) {
+		sourceId = sources.Size() + 1;
+		sources.IncreaseSize( sourceId );
+	} else {
+		sourceId = freeSourceIds.Last();
+		freeSourceIds.DeleteLast();
+	}
+	auto& source = sources[sourceId - 1];
+	source.Queue.Empty();
+	source.QueuePos = 0;
+	source.FramePos = 0;
+	source.IsPositionSet = false;
+	source.Position = CVector3<float>();
+	source.Velocity = CVector3<float>();
+	source.Gain = 1.0f;
+	source.Pitch = 1.0f;
+	source.IsRelative = false;
+	source.IsLooping = false;
+	source.State = CAudioRecord::RS_Initial;
+	source.IsUsed = true;
+	return sourceId;
+}
+
+void CSoftwareMixer::DeleteSource( unsigned sourceId )
+{
+	auto& source = getSource( sourceId );
+	source.Queue.Empty();
+	source.IsUsed = false;
+	freeSourceIds.Add( sourceId );
+}
+
+void CSoftwareMixer::SetSourceRelative( unsigned sourceId, bool isRelative )
+{
+	getSource( sourceId ).IsRelative = isRelative;
+}
+
+void CSoftwareMixer::SetSourcePosition( unsigned sourceId, CVector3<float> position )
+{
+	getSource( sourceId ).Position = position;
+}
+
+void CSoftwareMixer::SetSourceVelocity( unsigned sourceId, CVector3<float> velocity )
+{
+	getSource( sourceId ).Velocity = velocity;
+}
+
+void CSoftwareMixer::SetSourceLooping( unsigned sourceId, bool isLooping )
+{
+	getSource( sourceId ).IsLooping = isLooping;
+}
+
+void CSoftwareMixer::SetSourceGain( unsigned sourceId, float gain )
+{
+	assert( gain >= 0.0f );
+	getSource( sourceId ).Gain = gain;
+}
+
+void CSoftwareMixer::SetSourcePitch( unsigned sourceId, float pitch )
+{
+	assert( pitch > 0.0f );
+	getSource( sourceId ).Pitch = pitch;
+}
+
+float CSoftwareMixer::GetDistanceGain( float distance ) const
+{
+	return GetInverseClampedDistanceGain( distance, referenceDistance, maxDistance, rolloffFactor );
+}
+
+CAudioRecord::TRecordState CSoftwareMixer::GetSourceState( unsigned sourceId ) const
+{
+	return getSource( sourceId ).State;
+}
+
+void CSoftwareMixer::GetSourceStates( int count, const unsigned* sourceIds, CAudioRecord::TRecordState* result ) const
+{
+	for( int i = 0; i < count; i++ ) {
+		result[i] = getSource( sourceIds[i] ).State;
+	}
+}
+
+void CSoftwareMixer::PlaySource( unsigned sourceId )
+{
+	auto& source = getSource( sourceId );
+	// Paused sources are resumed, other sources start from the beginning of the queue or from the set offset.
+	if( source.State != CAudioRecord::RS_Paused && !source.IsPositionSet ) {
+		source.QueuePos = 0;
+		source.FramePos = 0;
+	}
+	source.IsPositionSet = false;
+	source.State = source.Queue.IsEmpty() ? CAudioRecord::RS_Stopped : CAudioRecord::RS_Playing;
+}
+
+void CSoftwareMixer::PauseSource( unsigned sourceId )
+{
+	auto& source = getSource( sourceId );
+	if( source.State == CAudioRecord::RS_Playing ) {
+		source.State = CAudioRecord::RS_Paused;
+	}
+}
+
+void CSoftwareMixer::StopSource( unsigned sourceId )
+{
+	// All the buffers of a stopped source are processed.
+	auto& source = getSource( sourceId );
+	source.State = CAudioRecord::RS_Stopped;
+	source.QueuePos = source.Queue.Size();
+	source.FramePos = 0;
+	source.IsPositionSet = false;
+}
+
+void CSoftwareMixer::RewindSource( unsigned sourceId )
+{
+	auto& source = getSource( sourceId );
+	source.State = CAudioRecord::RS_Initial;
+	source.QueuePos = 0;
+	source.FramePos = 0;
+	source.IsPositionSet = false;
+}
+
+float CSoftwareMixer::GetSourceOffset( unsigned sourceId ) const
+{
+	const auto& source = getSource( sourceId );
+	double result = 0.0;
+	for( int i = 0; i < source.QueuePos; i++ ) {
+		const auto& buffer = buffers[source.Queue[i] - 1];
+		result += static_cast<double>( buffer.FrameCount ) / buffer.Frequency;
+	}
+	if( source.QueuePos < source.Queue.Size() ) {
+		result += source.FramePos / framePosScale / buffers[source.Queue[source.QueuePos] - 1].Frequency;
+	}
+	return static_cast<float>( result );
+}
+
+void CSoftwareMixer::SetSourceOffset( unsigned sourceId, float offset )
+{
+	assert( offset >= 0.0f );
+	auto& source = getSource( sourceId );
+	double remainingOffset = offset;
+	source.QueuePos = 0;
+	source.FramePos = 0;
+	while( source.QueuePos < source.Queue.Size() ) {
+		const auto& buffer = buffers[source.Queue[source.QueuePos] - 1];
+		const double duration = static_cast<double>( buffer.FrameCount ) / buffer.Frequency;
+		if( remainingOffset < duration ) {
+			source.FramePos = static_cast<__int64>( remainingOffset * buffer.Frequency * framePosScale );
+			break;
+		}
+		remainingOffset -= duration;
+		source.QueuePos++;
+	}
+	source.IsPositionSet = source.State != CAudioRecord::RS_Playing && source.State != CAudioRecord::RS_Paused;
+}
+
+void CSoftwareMixer::QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds )
+{
+	auto& source = getSource( sourceId );
+	for( int i = 0; i < count; i++ ) {
+		assert( getBuffer( bufferIds[i] ).IsUsed );
+		source.Queue.Add( bufferIds[i] );
+	}
+}
+
+int CSoftwareMixer::UnqueueProcessedBuffers( unsigned sourceId, int maxCount, unsigned* result )
+{
+	auto& source = getSource( sourceId );
+	// Buffers of a looping source are never processed.
+	const int unqueueCount = source.IsLooping ? 0 : min( maxCount, source.QueuePos );
+	for( int i = 0; i < unqueueCount; i++ ) {
+		result[i] = source.Queue[i];
+	}
+	for( int i = unqueueCount; i < source.Queue.Size(); i++ ) {
+		source.Queue[i - unqueueCount] = source.Queue[i];
+	}
+	source.Queue.DeleteLast( unqueueCount );
+	source.QueuePos -= unqueueCount;
+	return unqueueCount;
+}
+
+int CSoftwareMixer::GetQueuedBufferCount( unsigned sourceId ) const
+{
+	return getSource( sourceId ).Queue.Size();
+}
+
+void CSoftwareMixer::DetachBuffers( unsigned sourceId )
+{
+	auto& source = getSource( sourceId );
+	assert( source.State == CAudioRecord::RS_Initial || source.State == CAudioRecord::RS_Stopped );
+	source.Queue.Empty();
+	source.QueuePos = 0;
+	source.FramePos = 0;
+	source.IsPositionSet = false;
+}
+
+void CSoftwareMixer::SetListenerPosition( CVector3<float> position )
+{
+	listenerPosition = position;
+}
+
+void CSoftwareMixer::SetListenerOrientation( CVector3<float> direction, CVector3<float> upVector )
+{
+	listenerDirection = direction;
+	listenerUpVector = upVector;
+}
+
+void CSoftwareMixer::SetListenerVelocity( CVector3<float> )
+{
+	// Velocities are not used by the mixer.
+}
+
+CSoftwareMixer::CMixerBuffer& CSoftwareMixer::getBuffer( unsigned bufferId )
+{
+	assert( bufferId > 0 && static_cast<int>( bufferId ) <= buffers.Size() );
+	return buffers[bufferId - 1];
+}
+
+CSoftwareMixer::CMixerSource& CSoftwareMixer::getSource( unsigned sourceId )
+{
+	assert( sourceId > 0 && static_cast<int>( sourceId ) <= sources.Size() );
+	return sources[sourceId - 1];
+}
+
+const CSoftwareMixer::CMixerSource& CSoftwareMixer::getSource( unsigned sourceId ) const
+{
+	assert( sourceId > 0 && static_cast<int>( sourceId ) <= sources.Size() );
+	return sources[sourceId - 1];
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
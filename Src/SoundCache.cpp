@@ -0,0 +1,455 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <SoundCache.h>
+#include <AlGlobals.h>
+#include <AlContextManager.h>
+#include <OggFile.h>
+#include <WavDecoder.h>
+#include <CriticalSectionLock.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+CSharedSound::CSharedSound( CSoundCache& _cache, int _slot ) :
+	cache( &_cache ),
+	slot( _slot )
+{
+	cache->addReference( slot );
+}
+
+CSharedSound::CSharedSound( const CSharedSound& other ) :
+	cache( other.cache ),
+	slot( other.slot )
+{
+	if( cache != nullptr ) {
+		cache->addReference( slot );
+	}
+}
+
+CSharedSound::CSharedSound( CSharedSound&& other ) :
+	cache( other.cache ),
+	slot( other.slot )
+{
+	other.cache = nullptr;
+	other.slot = NotFound;
+}
+
+CSharedSound& CSharedSound::operator=( const CSharedSound& other )
+{
+	// The new reference is added first, so that assigning to itself doesn't release the sound.
+	if( other.cache != nullptr ) {
+		other.cache->addReference( other.slot );
+	}
+	Release();
+	cache = other.cache;
+	slot = other.slot;
+	return *this;
+}
+
+CSharedSound& CSharedSound::operator=( CSharedSound&& other )
+{
+	if( this != &other ) {
+		Release();
+		cache = other.cache;
+		slot = other.slot;
+		other.cache = nullptr;
+		other.slot = NotFound;
+	}
+	return *this;
+}
+
+CSharedSound::~CSharedSound()
+{
+	Release();
+}
+
+CSoundView CSharedSound::GetSound() const
+{
+	return cache == nullptr ? CSoundView() : cache->getSound( slot );
+}
+
+void CSharedSound::Release()
+{
+	if( cache != nullptr ) {
+		cache->releaseReference( slot );
+		cache = nullptr;
+		slot = NotFound;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CSoundCache::CSoundCache( __int64 _byteBudget, int workerCount ) :
+	byteBudget( _byteBudget )
+{
+	assert( byteBudget >= 0 && workerCount >= 0 );
+	::InitializeCriticalSection( &lock );
+	::InitializeConditionVariable( &jobAdded );
+	::InitializeConditionVariable( &jobFinished );
+
+	for( int i = 0; i < workerCount; i++ ) {
+		const HANDLE worker = ::CreateThread( nullptr, 0, workerProc, this, 0, nullptr );
+		if( worker == nullptr ) {
+			// Without workers the prefetched files are decoded by the Flush and GetSound calls.
+			break;
+		}
+		workers.Add( worker );
+	}
+}
+
+CSoundCache::~CSoundCache()
+{
+	{
+		CCriticalSectionLock cacheLock( lock );
+		isStopping = true;
+	}
+	::WakeAllConditionVariable( &jobAdded );
+	for( HANDLE worker : workers ) {
+		::WaitForSingleObject( worker, INFINITE );
+		::CloseHandle( worker );
+	}
+	::DeleteCriticalSection( &lock );
+
+	// Jobs that haven't been started are dropped, the buffers are deleted with the entries.
+	for( const auto& entry : entries ) {
+		entry;
+		assert( entry.UseCount == 0 );
+	}
+}
+
+void CSoundCache::SetByteBudget( __int64 newValue )
+{
+	assert( newValue >= 0 );
+	byteBudget = newValue;
+	evictLeastRecent( 0 );
+}
+
+bool CSoundCache::IsLoaded( CStringPart fileName ) const
+{
+	const auto slotPtr = fileNameToSlot.Get( fileName );
+	return slotPtr != nullptr && entries[*slotPtr].Job == nullptr;
+}
+
+CSharedSound CSoundCache::GetSound( CStringPart fileName )
+{
+	const auto slotPtr = fileNameToSlot.Get( fileName );
+	if( slotPtr != nullptr ) {
+		const int slot = *slotPtr;
+		if( entries[slot].Job == nullptr ) {
+			statistics.HitCount++;
+			unlinkSlot( slot );
+			linkAsMostRecent( slot );
+			return CSharedSound( *this, slot );
+		}
+		// The entry is removed if the prefetch has failed. The file is decoded again to throw the error.
+		if( finishPrefetch( slot, true ) ) {
+			return CSharedSound( *this, slot );
+		}
+	}
+
+	statistics.MissCount++;
+	CDecodedSound decodedSound;
+	decodeFile( fileName, GetAudioContextManager().GetBackend().IsFloatFormatSupported(), decodedSound );
+	const int slot = addEntry( fileName );
+	loadSound( slot, decodedSound );
+	return CSharedSound( *this, slot );
+}
+
+void CSoundCache::Prefetch( CStringPart fileName )
+{
+	if( fileNameToSlot.Get( fileName ) != nullptr ) {
+		return;
+	}
+
+	const int slot = addEntry( fileName );
+	auto job = CreateOwner<CDecodeJob>();
+	job->FileName = entries[slot].FileName;
+	// The backend is queried here, workers make no audio calls.
+	job->AllowFloatOutput = GetAudioContextManager().GetBackend().IsFloatFormatSupported();
+	CDecodeJob* jobPtr = job;
+	entries[slot].Job = move( job );
+	prefetchSlots.Add( slot );
+
+	{
+		CCriticalSectionLock cacheLock( lock );
+		queuedJobs.Add( jobPtr );
+	}
+	::WakeConditionVariable( &jobAdded );
+}
+
+void CSoundCache::Update()
+{
+	// Finished prefetches are removed from the list.
+	for( int i = prefetchSlots.Size() - 1; i >= 0; i-- ) {
+		finishPrefetch( prefetchSlots[i], false );
+	}
+	// Sounds that were played by records after their release can be evicted now.
+	evictLeastRecent( 0 );
+}
+
+void CSoundCache::Flush()
+{
+	while( !prefetchSlots.IsEmpty() ) {
+		finishPrefetch( prefetchSlots.Last(), true );
+	}
+}
+
+void CSoundCache::EvictUnused()
+{
+	for( int slot = recentTail; slot != NotFound; ) {
+		const int prevSlot = entries[slot].PrevSlot;
+		if( canEvict( slot ) ) {
+			removeEntry( slot );
+		}
+		slot = prevSlot;
+	}
+}
+
+int CSoundCache::addEntry( CStringPart fileName )
+{
+	int slot;
+	if( freeSlots.IsEmpty() ) {
+		slot = entries.Size();
+		entries.IncreaseSize( slot + 1 );
+	} else {
+		slot = freeSlots.Last();
+		freeSlots.DeleteLast();
+	}
+
+	auto& entry = entries[slot];
+	entry.FileName = CString( fileName );
+	fileNameToSlot.Set( entry.FileName, slot );
+	return slot;
+}
+
+// Load the prefetched sound of the entry. Return false if the job is not finished yet or the file couldn't be decoded, in the latter case the entry is removed.
+// When waiting is allowed, jobs that haven't been started by the workers are taken back and decoded on the calling thread.
+bool CSoundCache::finishPrefetch( int slot, bool waitForJob )
+{
+	CDecodeJob* job = entries[slot].Job;
+	TDecodeJobState jobState;
+	{
+		CCriticalSectionLock cacheLock( lock );
+		if( !waitForJob && ( job->State == DJS_Queued || job->State == DJS_Decoding ) ) {
+			return false;
+		}
+		if( job->State == DJS_Queued ) {
+			for( int i = 0; i < queuedJobs.Size(); i++ ) {
+				if( queuedJobs[i] == job ) {
+					queuedJobs.DeleteAt( i );
+					break;
+				}
+			}
+		} else if( job->State == DJS_Decoding ) {
+			statistics.PrefetchWaitCount++;
+			while( job->State == DJS_Decoding ) {
+				::SleepConditionVariableCS( &jobFinished, &lock, INFINITE );
+			}
+		}
+		jobState = job->State;
+	}
+	if( jobState == DJS_Queued ) {
+		// The job is no longer visible to the workers.
+		jobState = decodeJob( *job );
+	}
+
+	for( int i = prefetchSlots.Size() - 1; i >= 0; i-- ) {
+		if( prefetchSlots[i] == slot ) {
+			prefetchSlots.DeleteAt( i );
+			break;
+		}
+	}
+
+	if( jobState == DJS_Decoded ) {
+		const CPtrOwner<CDecodeJob> finishedJob = move( entries[slot].Job );
+		loadSound( slot, finishedJob->Result );
+		return true;
+	}
+	if( jobState == DJS_Failed ) {
+		statistics.PrefetchFailedCount++;
+	}
+	removeEntry( slot );
+	return false;
+}
+
+void CSoundCache::loadSound( int slot, const CDecodedSound& decodedSound )
+{
+	const __int64 byteSize = decodedSound.Data.Size();
+	evictLeastRecent( byteSize );
+
+	// Cached sounds are expected to be short effects, so the whole sound is put into a single buffer.
+	auto& entry = entries[slot];
+	entry.Sound = CSoundOwner( 1 );
+	entry.Sound.SetData( 0, decodedSound.Format, decodedSound.Frequency, decodedSound.Data.Ptr(), decodedSound.Data.Size() );
+	entry.ByteSize = byteSize;
+	usedByteCount += byteSize;
+	soundCount++;
+	linkAsMostRecent( slot );
+}
+
+void CSoundCache::removeEntry( int slot )
+{
+	auto& entry = entries[slot];
+	assert( entry.UseCount == 0 );
+	if( entry.Job == nullptr ) {
+		unlinkSlot( slot );
+		usedByteCount -= entry.ByteSize;
+		soundCount--;
+	}
+	fileNameToSlot.Delete( entry.FileName );
+	// The buffers are deleted with the owner.
+	const CSoundOwner removedSound = move( entry.Sound );
+	entry.Job = nullptr;
+	entry.FileName.Empty();
+	entry.ByteSize = 0;
+	freeSlots.Add( slot );
+}
+
+void CSoundCache::evictLeastRecent( __int64 requiredSize )
+{
+	int slot = recentTail;
+	while( slot != NotFound && usedByteCount + requiredSize > byteBudget ) {
+		const int prevSlot = entries[slot].PrevSlot;
+		if( canEvict( slot ) ) {
+			removeEntry( slot );
+			statistics.EvictionCount++;
+		}
+		slot = prevSlot;
+	}
+}
+
+bool CSoundCache::canEvict( int slot ) const
+{
+	// Records keep only a view of the sound, so the buffers of the playing sounds must stay alive.
+	const auto& entry = entries[slot];
+	return entry.UseCount == 0 && !GetAudioContextManager().HasSoundRecords( entry.Sound );
+}
+
+void CSoundCache::linkAsMostRecent( int slot )
+{
+	auto& entry = entries[slot];
+	entry.PrevSlot = NotFound;
+	entry.NextSlot = recentHead;
+	if( recentHead != NotFound ) {
+		entries[recentHead].PrevSlot = slot;
+	} else {
+		recentTail = slot;
+	}
+	recentHead = slot;
+}
+
+void CSoundCache::unlinkSlot( int slot )
+{
+	auto& entry = entries[slot];
+	if( entry.PrevSlot != NotFound ) {
+		entries[entry.PrevSlot].NextSlot = entry.NextSlot;
+	} else {
+		recentHead = entry.NextSlot;
+	}
+	if( entry.NextSlot != NotFound ) {
+		entries[entry.NextSlot].PrevSlot = entry.PrevSlot;
+	} else {
+		recentTail = entry.PrevSlot;
+	}
+	entry.PrevSlot = NotFound;
+	entry.NextSlot = NotFound;
+}
+
+void CSoundCache::addReference( int slot )
+{
+	entries[slot].UseCount++;
+}
+
+void CSoundCache::releaseReference( int slot )
+{
+	auto& entry = entries[slot];
+	assert( entry.UseCount > 0 );
+	entry.UseCount--;
+	if( entry.UseCount == 0 && usedByteCount > byteBudget ) {
+		evictLeastRecent( 0 );
+	}
+}
+
+void CSoundCache::runWorker()
+{
+	for( ;; ) {
+		CDecodeJob* job;
+		{
+			CCriticalSectionLock cacheLock( lock );
+			while( queuedJobs.IsEmpty() && !isStopping ) {
+				::SleepConditionVariableCS( &jobAdded, &lock, INFINITE );
+			}
+			if( isStopping ) {
+				return;
+			}
+			job = queuedJobs[0];
+			queuedJobs.DeleteAt( 0 );
+			job->State = DJS_Decoding;
+		}
+
+		const auto newState = decodeJob( *job );
+		{
+			CCriticalSectionLock cacheLock( lock );
+			job->State = newState;
+		}
+		::WakeAllConditionVariable( &jobFinished );
+	}
+}
+
+// Decode the file of a prefetch job and return the resulting job state.
+CSoundCache::TDecodeJobState CSoundCache::decodeJob( CDecodeJob& job )
+{
+	try {
+		decodeFile( job.FileName, job.AllowFloatOutput, job.Result );
+		return DJS_Decoded;
+	} catch( ... ) {
+		// Errors can't be passed from a worker thread. The file is decoded again when the sound is requested, so the error is thrown there.
+		return DJS_Failed;
+	}
+}
+
+DWORD WINAPI CSoundCache::workerProc( void* param )
+{
+	static_cast<CSoundCache*>( param )->runWorker();
+	return 0;
+}
+
+void CSoundCache::decodeFile( CStringPart fileName, bool allowFloatOutput, CDecodedSound& result )
+{
+	if( isOggFile( fileName ) ) {
+		COggFile oggFile( fileName );
+		result.Format = oggFile.GetAudioFormat();
+		result.Frequency = oggFile.GetSampleRate();
+		oggFile.DecodeAudioData( result.Data );
+	} else {
+		CWavDecoder decoder( fileName, allowFloatOutput );
+		result.Format = decoder.GetOutputFormat();
+		result.Frequency = decoder.GetSampleRate();
+		decoder.Decode( decoder.GetFrameCount(), result.Data );
+	}
+}
+
+static const BYTE oggSignature[] = { 'O', 'g', 'g', 'S' };
+bool CSoundCache::isOggFile( CStringPart fileName )
+{
+	CDynamicFile file;
+	file.Open( fileName, FRWM_Read, FCM_OpenExisting, FSM_DenyNone );
+	BYTE signature[sizeof( oggSignature )];
+	const int readSize = file.Read( signature, sizeof( signature ) );
+	return readSize == sizeof( signature ) && memcmp( signature, oggSignature, sizeof( signature ) ) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
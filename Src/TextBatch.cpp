@@ -0,0 +1,68 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TextBatch.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextBatch::CTextBatch( const CFontRenderer& renderer ) :
+	owner( &renderer ),
+	vertexBuffer( CGlBufferOwner<BT_Array, CTextBatchVertex>::CreateRawBuffer() ),
+	mesh( CMeshOwner<CElementMesh>::CreateRawMesh() )
+{
+}
+
+int CTextBatch::GetGlyphCount() const
+{
+	return vertices.Size() / CFontRenderer::GlyphQuadVertexCount;
+}
+
+void CTextBatch::AddLine( CUnicodePart str, const CMatrix3<float>& modelToPixel, CColor color )
+{
+	lineVertices.Empty();
+	owner->RenderLineVertices( str, lineVertices );
+	addLineVertices( modelToPixel, color );
+}
+
+void CTextBatch::AddLine( CStringPart str, const CMatrix3<float>& modelToPixel, CColor color )
+{
+	lineVertices.Empty();
+	owner->RenderLineVertices( str, lineVertices );
+	addLineVertices( modelToPixel, color );
+}
+
+void CTextBatch::addLineVertices( const CMatrix3<float>& modelToPixel, CColor color )
+{
+	const CVector4<BYTE> vertexColor( color.R, color.G, color.B, color.A );
+	const auto startPos = vertices.Size();
+	vertices.IncreaseSize( startPos + lineVertices.Size() );
+	for( int i = 0; i < lineVertices.Size(); i++ ) {
+		const auto& src = lineVertices[i];
+		const float x = src.X();
+		const float y = src.Y();
+		auto& dest = vertices[startPos + i];
+		dest.Position = CVector2<float>( modelToPixel( 0, 0 ) * x + modelToPixel( 1, 0 ) * y + modelToPixel( 2, 0 ),
+			modelToPixel( 0, 1 ) * x + modelToPixel( 1, 1 ) * y + modelToPixel( 2, 1 ) );
+		dest.TexelOffset = CVector2<short>( src.Z(), src.W() );
+		dest.Color = vertexColor;
+	}
+	isBufferValid = false;
+}
+
+void CTextBatch::Empty()
+{
+	vertices.Empty();
+	isBufferValid = false;
+}
+
+void CTextBatch::Draw( const CMatrix3<float>& pixelToClip, float zOrder ) const
+{
+	owner->DisplayTextBatch( *this, pixelToClip, zOrder );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,194 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TextMeshCache.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+// FNV-1a hash parameters.
+static const unsigned textHashOffsetBasis = 2166136261U;
+static const unsigned textHashPrime = 16777619U;
+CTextMeshCacheKey::CTextMeshCacheKey( CArrayView<BYTE> text, bool isUtf16, int lineWidth, int lineHeight, int startHOffset ) :
+	TextSize( text.Size() ),
+	LineWidth( lineWidth ),
+	LineHeight( lineHeight ),
+	StartHOffset( startHOffset ),
+	IsUtf16( isUtf16 )
+{
+	unsigned hash = textHashOffsetBasis;
+	for( auto ch : text ) {
+		hash = ( hash ^ ch ) * textHashPrime;
+	}
+	TextHash = static_cast<int>( hash );
+}
+
+int CTextMeshCacheKey::HashKey() const
+{
+	const auto paramHash = CombineHashKey( CombineHashKey( LineWidth, LineHeight ), CombineHashKey( StartHOffset, IsUtf16 ) );
+	return CombineHashKey( CombineHashKey( TextHash, TextSize ), paramHash );
+}
+
+bool CTextMeshCacheKey::operator==( const CTextMeshCacheKey& other ) const
+{
+	return TextHash == other.TextHash && TextSize == other.TextSize && LineWidth == other.LineWidth
+		&& LineHeight == other.LineHeight && StartHOffset == other.StartHOffset && IsUtf16 == other.IsUtf16;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextMeshCachePolicy::CTextMeshCachePolicy( int _byteBudget ) :
+	byteBudget( _byteBudget )
+{
+	assert( byteBudget >= 0 );
+}
+
+void CTextMeshCachePolicy::SetByteBudget( int newValue )
+{
+	assert( newValue >= 0 );
+	byteBudget = newValue;
+}
+
+void CTextMeshCachePolicy::AdvanceFrame()
+{
+	currentFrame++;
+}
+
+int CTextMeshCachePolicy::FindSlot( const CTextMeshCacheKey& key, CArrayView<BYTE> text )
+{
+	const auto slotPtr = keyToSlot.Get( key );
+	if( slotPtr == nullptr || !isTextEqual( entries[*slotPtr].Text, text ) ) {
+		statistics.MissCount++;
+		return NotFound;
+	}
+
+	const auto slot = *slotPtr;
+	statistics.HitCount++;
+	entries[slot].LastUsedFrame = currentFrame;
+	unlinkSlot( slot );
+	linkAsMostRecent( slot );
+	return slot;
+}
+
+int CTextMeshCachePolicy::AddSlot( const CTextMeshCacheKey& key, CArrayView<BYTE> text, int meshByteSize, CArray<int>& evictedSlots )
+{
+	// A different text with the same key is replaced.
+	const auto collisionSlot = keyToSlot.Get( key );
+	if( collisionSlot != nullptr ) {
+		const auto slot = *collisionSlot;
+		if( entries[slot].LastUsedFrame == currentFrame ) {
+			// The mesh may still be drawn during this frame. It can't be found anymore and is evicted with the least recent meshes later.
+			keyToSlot.Delete( key );
+		} else {
+			removeSlot( slot );
+			evictedSlots.Add( slot );
+			statistics.EvictionCount++;
+		}
+	}
+
+	const auto byteSize = meshByteSize + text.Size();
+	evictLeastRecent( byteSize, evictedSlots );
+
+	int slot;
+	if( freeSlots.IsEmpty() ) {
+		slot = entries.Size();
+		entries.IncreaseSize( slot + 1 );
+	} else {
+		slot = freeSlots.Last();
+		freeSlots.DeleteLast();
+	}
+
+	auto& entry = entries[slot];
+	entry.Key = key;
+	entry.Text.Empty();
+	entry.Text.IncreaseSize( text.Size() );
+	if( text.Size() > 0 ) {
+		memcpy( entry.Text.Ptr(), text.Ptr(), text.Size() );
+	}
+	entry.ByteSize = byteSize;
+	entry.LastUsedFrame = currentFrame;
+	linkAsMostRecent( slot );
+	keyToSlot.Set( key, slot );
+	usedByteCount += byteSize;
+	return slot;
+}
+
+void CTextMeshCachePolicy::Empty()
+{
+	entries.Empty();
+	freeSlots.Empty();
+	keyToSlot.Empty();
+	recentHead = NotFound;
+	recentTail = NotFound;
+	usedByteCount = 0;
+}
+
+void CTextMeshCachePolicy::evictLeastRecent( int requiredSize, CArray<int>& evictedSlots )
+{
+	while( recentTail != NotFound && usedByteCount + requiredSize > byteBudget ) {
+		const auto slot = recentTail;
+		if( entries[slot].LastUsedFrame == currentFrame ) {
+			// Everything else has been used during this frame. The budget is exceeded until the next frame.
+			return;
+		}
+		removeSlot( slot );
+		evictedSlots.Add( slot );
+		statistics.EvictionCount++;
+	}
+}
+
+void CTextMeshCachePolicy::removeSlot( int slot )
+{
+	auto& entry = entries[slot];
+	unlinkSlot( slot );
+	// The key may belong to a newer entry if the text has been replaced while the mesh was in use.
+	const auto mappedSlot = keyToSlot.Get( entry.Key );
+	if( mappedSlot != nullptr && *mappedSlot == slot ) {
+		keyToSlot.Delete( entry.Key );
+	}
+	usedByteCount -= entry.ByteSize;
+	entry.ByteSize = 0;
+	entry.Text.Empty();
+	freeSlots.Add( slot );
+}
+
+void CTextMeshCachePolicy::linkAsMostRecent( int slot )
+{
+	auto& entry = entries[slot];
+	entry.PrevSlot = NotFound;
+	entry.NextSlot = recentHead;
+	if( recentHead != NotFound ) {
+		entries[recentHead].PrevSlot = slot;
+	} else {
+		recentTail = slot;
+	}
+	recentHead = slot;
+}
+
+void CTextMeshCachePolicy::unlinkSlot( int slot )
+{
+	auto& entry = entries[slot];
+	if( entry.PrevSlot != NotFound ) {
+		entries[entry.PrevSlot].NextSlot = entry.NextSlot;
+	} else {
+		recentHead = entry.NextSlot;
+	}
+	if( entry.NextSlot != NotFound ) {
+		entries[entry.NextSlot].PrevSlot = entry.PrevSlot;
+	} else {
+		recentTail = entry.PrevSlot;
+	}
+	entry.PrevSlot = NotFound;
+	entry.NextSlot = NotFound;
+}
+
+bool CTextMeshCachePolicy::isTextEqual( const CArray<BYTE>& left, CArrayView<BYTE> right )
+{
+	return left.Size() == right.Size() && ( left.Size() == 0 || memcmp( left.Ptr(), right.Ptr(), left.Size() ) == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
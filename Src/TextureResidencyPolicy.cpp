@@ -0,0 +1,251 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TextureResidencyPolicy.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextureResidencyPolicy::CTextureResidencyPolicy( __int64 _byteBudget, int _tailSize ) :
+	byteBudget( _byteBudget ),
+	tailSize( _tailSize )
+{
+	assert( byteBudget >= 0 );
+	assert( tailSize > 0 );
+}
+
+void CTextureResidencyPolicy::SetByteBudget( __int64 newValue )
+{
+	assert( newValue >= 0 );
+	byteBudget = newValue;
+}
+
+int CTextureResidencyPolicy::AddTexture( int width, int height, CArrayView<int> levelByteSizes )
+{
+	assert( width > 0 && height > 0 );
+	assert( !levelByteSizes.IsEmpty() );
+	int texture;
+	if( freeSlots.IsEmpty() ) {
+		texture = textures.Size();
+		textures.IncreaseSize( texture + 1 );
+	} else {
+		texture = freeSlots.Last();
+		freeSlots.DeleteLast();
+	}
+
+	auto& entry = textures[texture];
+	entry.Width = width;
+	entry.Height = height;
+	entry.LevelByteSizes.Empty();
+	for( auto size : levelByteSizes ) {
+		entry.LevelByteSizes.Add( size );
+	}
+	entry.TailLevel = findTailLevel( width, height, levelByteSizes.Size() );
+	entry.ResidentLevel = entry.TailLevel;
+	entry.DesiredLevel = entry.TailLevel;
+	entry.LoadingLevel = NotFound;
+	// New textures are placed at the head of the recency list, which must only contain the textures used during the current frame.
+	entry.LastUsedFrame = currentFrame;
+	for( int i = entry.TailLevel; i < levelByteSizes.Size(); i++ ) {
+		usedByteCount += levelByteSizes[i];
+	}
+	linkAsMostRecent( texture );
+	return texture;
+}
+
+void CTextureResidencyPolicy::RemoveTexture( int texture )
+{
+	auto& entry = textures[texture];
+	assert( entry.LoadingLevel == NotFound );
+	for( int i = entry.ResidentLevel; i < entry.LevelByteSizes.Size(); i++ ) {
+		usedByteCount -= entry.LevelByteSizes[i];
+	}
+	unlinkTexture( texture );
+	entry.LevelByteSizes.Empty();
+	freeSlots.Add( texture );
+}
+
+void CTextureResidencyPolicy::AdvanceFrame()
+{
+	currentFrame++;
+}
+
+void CTextureResidencyPolicy::UpdateScreenSize( int texture, float screenSize )
+{
+	auto& entry = textures[texture];
+	const int desiredLevel = min( FindDesiredLevel( entry.Width, entry.Height, screenSize ), entry.TailLevel );
+	entry.DesiredLevel = entry.LastUsedFrame == currentFrame ? min( entry.DesiredLevel, desiredLevel ) : desiredLevel;
+	entry.LastUsedFrame = currentFrame;
+	unlinkTexture( texture );
+	linkAsMostRecent( texture );
+}
+
+int CTextureResidencyPolicy::ScheduleNextLoad( int& level, CArray<int>& evictedTextures )
+{
+	const int texture = findNextLoadTexture();
+	if( texture == NotFound ) {
+		return NotFound;
+	}
+
+	auto& entry = textures[texture];
+	const int nextLevel = entry.ResidentLevel - 1;
+	const int levelSize = entry.LevelByteSizes[nextLevel];
+	if( !evictLevels( levelSize, texture, evictedTextures ) ) {
+		statistics.BudgetShortageCount++;
+		return NotFound;
+	}
+
+	entry.LoadingLevel = nextLevel;
+	usedByteCount += levelSize;
+	statistics.LoadCount++;
+	level = nextLevel;
+	return texture;
+}
+
+void CTextureResidencyPolicy::OnLevelLoaded( int texture )
+{
+	auto& entry = textures[texture];
+	assert( entry.LoadingLevel == entry.ResidentLevel - 1 );
+	entry.ResidentLevel = entry.LoadingLevel;
+	entry.LoadingLevel = NotFound;
+}
+
+void CTextureResidencyPolicy::OnLevelLoadFailed( int texture )
+{
+	auto& entry = textures[texture];
+	assert( entry.LoadingLevel != NotFound );
+	usedByteCount -= entry.LevelByteSizes[entry.LoadingLevel];
+	entry.LoadingLevel = NotFound;
+}
+
+int CTextureResidencyPolicy::FindDesiredLevel( int width, int height, float screenSize )
+{
+	const int size = max( width, height );
+	int level = 0;
+	while( ( size >> ( level + 1 ) ) > 0 && ( size >> ( level + 1 ) ) >= screenSize ) {
+		level++;
+	}
+	return level;
+}
+
+// Objects closer than this distance are estimated as if they were at this distance.
+static const float minEstimateDistance = 1e-3f;
+float CTextureResidencyPolicy::EstimateScreenSize( float objectSize, float distance, float verticalFov, int viewportHeight )
+{
+	assert( verticalFov > 0 && viewportHeight > 0 );
+	const float viewHeight = 2 * max( distance, minEstimateDistance ) * tanf( verticalFov / 2 );
+	return objectSize / viewHeight * viewportHeight;
+}
+
+int CTextureResidencyPolicy::findTailLevel( int width, int height, int levelCount ) const
+{
+	int level = 0;
+	while( level < levelCount - 1 && max( width >> level, height >> level ) > tailSize ) {
+		level++;
+	}
+	return level;
+}
+
+// Find the texture used during the current frame that lacks the most levels.
+int CTextureResidencyPolicy::findNextLoadTexture() const
+{
+	int result = NotFound;
+	int maxMissingCount = 0;
+	for( int texture = recentHead; texture != NotFound && textures[texture].LastUsedFrame == currentFrame; texture = textures[texture].NextTexture ) {
+		const auto& entry = textures[texture];
+		const int missingCount = entry.ResidentLevel - entry.DesiredLevel;
+		if( entry.LoadingLevel == NotFound && missingCount > maxMissingCount ) {
+			result = texture;
+			maxMissingCount = missingCount;
+		}
+	}
+	return result;
+}
+
+// Find the coarsest level the texture can be reduced to.
+int CTextureResidencyPolicy::findEvictionLevel( int texture ) const
+{
+	const auto& entry = textures[texture];
+	if( entry.LoadingLevel != NotFound ) {
+		return entry.ResidentLevel;
+	}
+	return entry.LastUsedFrame == currentFrame ? max( entry.ResidentLevel, entry.DesiredLevel ) : entry.TailLevel;
+}
+
+bool CTextureResidencyPolicy::evictLevels( __int64 requiredSize, int requester, CArray<int>& evictedTextures )
+{
+	if( usedByteCount + requiredSize <= byteBudget ) {
+		return true;
+	}
+
+	// Nothing is evicted if the released memory is not going to be enough.
+	__int64 releasableSize = 0;
+	for( int texture = recentTail; texture != NotFound && usedByteCount + requiredSize - releasableSize > byteBudget; texture = textures[texture].PrevTexture ) {
+		if( texture == requester ) {
+			continue;
+		}
+		const auto& entry = textures[texture];
+		const int evictionLevel = findEvictionLevel( texture );
+		for( int i = entry.ResidentLevel; i < evictionLevel; i++ ) {
+			releasableSize += entry.LevelByteSizes[i];
+		}
+	}
+	if( usedByteCount + requiredSize - releasableSize > byteBudget ) {
+		return false;
+	}
+
+	for( int texture = recentTail; texture != NotFound && usedByteCount + requiredSize > byteBudget; texture = textures[texture].PrevTexture ) {
+		if( texture == requester ) {
+			continue;
+		}
+		auto& entry = textures[texture];
+		const int evictionLevel = findEvictionLevel( texture );
+		if( entry.ResidentLevel == evictionLevel ) {
+			continue;
+		}
+		// The finest levels are released first.
+		while( entry.ResidentLevel < evictionLevel && usedByteCount + requiredSize > byteBudget ) {
+			usedByteCount -= entry.LevelByteSizes[entry.ResidentLevel];
+			entry.ResidentLevel++;
+			statistics.EvictionCount++;
+		}
+		evictedTextures.Add( texture );
+	}
+	return true;
+}
+
+void CTextureResidencyPolicy::linkAsMostRecent( int texture )
+{
+	auto& entry = textures[texture];
+	entry.PrevTexture = NotFound;
+	entry.NextTexture = recentHead;
+	if( recentHead != NotFound ) {
+		textures[recentHead].PrevTexture = texture;
+	} else {
+		recentTail = texture;
+	}
+	recentHead = texture;
+}
+
+void CTextureResidencyPolicy::unlinkTexture( int texture )
+{
+	auto& entry = textures[texture];
+	if( entry.PrevTexture != NotFound ) {
+		textures[entry.PrevTexture].NextTexture = entry.NextTexture;
+	} else {
+		recentHead = entry.NextTexture;
+	}
+	if( entry.NextTexture != NotFound ) {
+		textures[entry.NextTexture].PrevTexture = entry.PrevTexture;
+	} else {
+		recentTail = entry.PrevTexture;
+	}
+	entry.PrevTexture = NotFound;
+	entry.NextTexture = NotFound;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,241 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TextureStreamingManager.h>
+#include <TextureBinder.h>
+#include <DefaultSamplerContainer.h>
+#include <GinError.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextureStreamingManager::CTextureStreamingManager( CTextureUploadQueue& _uploadQueue, __int64 byteBudget, int tailSize ) :
+	uploadQueue( _uploadQueue ),
+	policy( byteBudget, tailSize )
+{
+}
+
+CTextureStreamingManager::~CTextureStreamingManager()
+{
+	for( const auto& texture : textures ) {
+		if( texture != nullptr ) {
+			GinInternal::CTextureData::DeleteTextureId( texture->TextureId );
+		}
+	}
+}
+
+void CTextureStreamingManager::SetMaxLoadCount( int newValue )
+{
+	assert( newValue > 0 );
+	maxLoadCount = newValue;
+}
+
+int CTextureStreamingManager::AddTexture( CImageData sourceData, bool topLeftOrigin, TTextureGlFormat internalFormat )
+{
+	assert( sourceData.GetType() == TT_Texture2D );
+	assert( sourceData.Depth() == 1 && sourceData.GetArrayCount() == 1 );
+	const int levelCount = sourceData.GetMipmapCount();
+	CArray<int> levelByteSizes;
+	for( int level = 0; level < levelCount; level++ ) {
+		levelByteSizes.Add( sourceData.GetImageDataSize( level ) );
+	}
+
+	const int texture = policy.AddTexture( sourceData.Width(), sourceData.Height(), levelByteSizes );
+	if( textures.Size() <= texture ) {
+		textures.IncreaseSize( texture + 1 );
+	}
+	textures[texture] = CreateOwner<CStreamedTexture>( move( sourceData ), topLeftOrigin, internalFormat, GinInternal::CTextureData::CreateTextureId() );
+	textures[texture]->StorageLevel = levelCount;
+
+	// Tail levels are small enough to be uploaded right away.
+	for( int level = levelCount - 1; level >= policy.GetTailLevel( texture ); level-- ) {
+		loadLevelDirectly( texture, level );
+	}
+	CTextureBinder binder( TBT_Texture2, getTextureData( *textures[texture] ) );
+	updateMipmapRange( texture );
+	return texture;
+}
+
+void CTextureStreamingManager::RemoveTexture( int texture )
+{
+	if( policy.GetLoadingLevel( texture ) != NotFound ) {
+		// The upload queue may still write to the texture.
+		textures[texture]->IsRemoved = true;
+	} else {
+		deleteTexture( texture );
+	}
+}
+
+void CTextureStreamingManager::Update()
+{
+	while( loadCount < maxLoadCount ) {
+		evictedTextures.Empty();
+		int level;
+		const int texture = policy.ScheduleNextLoad( level, evictedTextures );
+		for( auto evictedTexture : evictedTextures ) {
+			releaseEvictedLevels( evictedTexture );
+		}
+		if( texture == NotFound ) {
+			break;
+		}
+		if( !startLevelLoad( texture, level ) ) {
+			// Staging memory is busy, the level is scheduled again during the next update.
+			policy.OnLevelLoadFailed( texture );
+			break;
+		}
+	}
+	policy.AdvanceFrame();
+}
+
+void CTextureStreamingManager::OnUploadComplete( int uploadId )
+{
+	finishLevelLoad( uploadId, true );
+}
+
+void CTextureStreamingManager::OnUploadLost( int uploadId )
+{
+	finishLevelLoad( uploadId, false );
+}
+
+bool CTextureStreamingManager::startLevelLoad( int texture, int level )
+{
+	auto& entry = *textures[texture];
+	const int byteSize = entry.Source.GetImageDataSize( level );
+	if( byteSize > uploadQueue.GetStagingBufferSize() ) {
+		// Levels that don't fit into a staging buffer are uploaded synchronously.
+		loadLevelDirectly( texture, level );
+		policy.OnLevelLoaded( texture );
+		CTextureBinder binder( TBT_Texture2, getTextureData( entry ) );
+		updateMipmapRange( texture );
+		return true;
+	}
+
+	BYTE* stagingMemory;
+	const int uploadHandle = uploadQueue.BeginUpload( byteSize, stagingMemory );
+	if( uploadHandle == NotFound ) {
+		return false;
+	}
+	entry.Source.CopyImageData( level, 0, 0, stagingMemory, entry.HasTopLeftOrigin );
+	{
+		CTextureBinder binder( TBT_Texture2, getTextureData( entry ) );
+		setLevelStorage( entry, level, nullptr );
+	}
+	entry.StorageLevel = level;
+
+	CTextureUploadRequest request;
+	request.TextureId = entry.TextureId;
+	request.Level = level;
+	request.Offset = CVector2<int>( 0, 0 );
+	request.Size = CVector2<int>( max( 1, entry.Source.Width() >> level ), max( 1, entry.Source.Height() >> level ) );
+	request.TexelFormat = entry.Source.GetTexelFormat();
+	request.DataType = entry.Source.GetTexelDataType();
+	request.CompressionType = entry.Source.GetCompressionType();
+	request.Listener = this;
+	request.UploadId = texture;
+	uploadQueue.CommitUpload( uploadHandle, byteSize, request );
+	loadCount++;
+	return true;
+}
+
+void CTextureStreamingManager::loadLevelDirectly( int texture, int level )
+{
+	auto& entry = *textures[texture];
+	CTextureBinder binder( TBT_Texture2, getTextureData( entry ) );
+	if( entry.HasTopLeftOrigin ) {
+		CArray<BYTE> flippedData;
+		flippedData.IncreaseSizeNoInitialize( entry.Source.GetImageDataSize( level ) );
+		entry.Source.CopyImageData( level, 0, 0, flippedData.Ptr(), true );
+		setLevelStorage( entry, level, flippedData.Ptr() );
+	} else {
+		setLevelStorage( entry, level, entry.Source.GetImageData( level ) );
+	}
+	entry.StorageLevel = level;
+}
+
+void CTextureStreamingManager::releaseEvictedLevels( int texture )
+{
+	auto& entry = *textures[texture];
+	const int residentLevel = policy.GetResidentLevel( texture );
+	CTextureBinder binder( TBT_Texture2, getTextureData( entry ) );
+	// The clamp is moved before the storage is released, so the texture stays complete.
+	updateMipmapRange( texture );
+	for( int level = entry.StorageLevel; level < residentLevel; level++ ) {
+		releaseLevelStorage( entry, level );
+	}
+	entry.StorageLevel = residentLevel;
+}
+
+void CTextureStreamingManager::finishLevelLoad( int texture, bool isLoaded )
+{
+	assert( loadCount > 0 );
+	loadCount--;
+	auto& entry = *textures[texture];
+	if( isLoaded ) {
+		policy.OnLevelLoaded( texture );
+	} else {
+		policy.OnLevelLoadFailed( texture );
+	}
+
+	if( entry.IsRemoved ) {
+		deleteTexture( texture );
+		return;
+	}
+
+	CTextureBinder binder( TBT_Texture2, getTextureData( entry ) );
+	if( isLoaded ) {
+		updateMipmapRange( texture );
+	} else {
+		releaseLevelStorage( entry, entry.StorageLevel );
+		entry.StorageLevel = policy.GetResidentLevel( texture );
+	}
+}
+
+void CTextureStreamingManager::deleteTexture( int texture )
+{
+	policy.RemoveTexture( texture );
+	GinInternal::CTextureData::DeleteTextureId( textures[texture]->TextureId );
+	textures[texture] = CPtrOwner<CStreamedTexture>();
+}
+
+// Expose the resident levels to the GPU. The texture must be bound.
+void CTextureStreamingManager::updateMipmapRange( int texture )
+{
+	getTextureData( *textures[texture] ).SetTextureMipmapRange( TBT_Texture2, policy.GetResidentLevel( texture ), policy.GetLevelCount( texture ) - 1 );
+}
+
+// Allocate the level storage and fill it with the given data. Null data only allocates the storage. The texture must be bound.
+void CTextureStreamingManager::setLevelStorage( const CStreamedTexture& texture, int level, const BYTE* data )
+{
+	const auto& source = texture.Source;
+	const int width = max( 1, source.Width() >> level );
+	const int height = max( 1, source.Height() >> level );
+	if( source.GetCompressionType() == TCT_Uncompressed ) {
+		gl::TexImage2D( TBT_Texture2, level, texture.InternalFormat, width, height, 0, source.GetTexelFormat(), source.GetTexelDataType(), data );
+	} else {
+		gl::CompressedTexImage2D( TBT_Texture2, level, source.GetCompressionType(), width, height, 0, source.GetImageDataSize( level ), data );
+	}
+	CheckGlError();
+}
+
+// Replace the level storage with an empty image. The level must be outside of the mipmap range. The texture must be bound.
+void CTextureStreamingManager::releaseLevelStorage( const CStreamedTexture& texture, int level )
+{
+	const auto& source = texture.Source;
+	if( source.GetCompressionType() == TCT_Uncompressed ) {
+		gl::TexImage2D( TBT_Texture2, level, texture.InternalFormat, 0, 0, 0, source.GetTexelFormat(), source.GetTexelDataType(), nullptr );
+	} else {
+		gl::CompressedTexImage2D( TBT_Texture2, level, source.GetCompressionType(), 0, 0, 0, 0, nullptr );
+	}
+	CheckGlError();
+}
+
+GinInternal::CTextureData CTextureStreamingManager::getTextureData( const CStreamedTexture& texture )
+{
+	return GinInternal::CTextureData( texture.TextureId, GetDefaultSampler() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
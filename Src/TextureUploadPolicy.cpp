@@ -0,0 +1,127 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TextureUploadPolicy.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextureUploadPolicy::CTextureUploadPolicy( int slotCount, int _slotByteSize, int _frameByteBudget ) :
+	slotByteSize( _slotByteSize ),
+	frameByteBudget( _frameByteBudget )
+{
+	assert( slotCount > 0 );
+	assert( slotByteSize > 0 );
+	assert( frameByteBudget > 0 );
+	slots.IncreaseSize( slotCount );
+}
+
+void CTextureUploadPolicy::SetFrameByteBudget( int newValue )
+{
+	assert( newValue > 0 );
+	frameByteBudget = newValue;
+}
+
+void CTextureUploadPolicy::AdvanceFrame()
+{
+	if( isFrameDeferred ) {
+		statistics.DeferredFrameCount++;
+	}
+	frameUploadedByteCount = 0;
+	frameUploadCount = 0;
+	isFrameDeferred = false;
+}
+
+int CTextureUploadPolicy::FindIdleSlot() const
+{
+	for( int i = 0; i < slots.Size(); i++ ) {
+		if( slots[i].State == USS_Idle ) {
+			return i;
+		}
+	}
+	return NotFound;
+}
+
+void CTextureUploadPolicy::OnSlotPrepared( int slot )
+{
+	assert( slots[slot].State == USS_Idle );
+	slots[slot].State = USS_Available;
+}
+
+int CTextureUploadPolicy::AcquireSlot( int byteSize )
+{
+	assert( byteSize > 0 && byteSize <= slotByteSize );
+	byteSize;
+	for( int i = 0; i < slots.Size(); i++ ) {
+		if( slots[i].State == USS_Available ) {
+			slots[i].State = USS_Writing;
+			return i;
+		}
+	}
+	statistics.StagingShortageCount++;
+	return NotFound;
+}
+
+void CTextureUploadPolicy::CommitSlot( int slot, int byteSize )
+{
+	assert( slots[slot].State == USS_Writing );
+	assert( byteSize > 0 && byteSize <= slotByteSize );
+	slots[slot].State = USS_Queued;
+	slots[slot].DataSize = byteSize;
+	queuedSlots.Add( slot );
+}
+
+void CTextureUploadPolicy::CancelSlot( int slot )
+{
+	assert( slots[slot].State == USS_Writing );
+	slots[slot].State = USS_Available;
+}
+
+int CTextureUploadPolicy::ScheduleNextUpload()
+{
+	if( queuedSlots.IsEmpty() ) {
+		return NotFound;
+	}
+
+	const int slot = queuedSlots[0];
+	const int dataSize = slots[slot].DataSize;
+	// The first upload of a frame is always issued, otherwise uploads bigger than the budget would never leave the queue.
+	if( frameUploadCount > 0 && frameUploadedByteCount + dataSize > frameByteBudget ) {
+		isFrameDeferred = true;
+		return NotFound;
+	}
+
+	queuedSlots.DeleteAt( 0 );
+	pendingSlots.Add( slot );
+	slots[slot].State = USS_Pending;
+	frameUploadedByteCount += dataSize;
+	frameUploadCount++;
+	statistics.UploadCount++;
+	statistics.UploadedByteCount += dataSize;
+	return slot;
+}
+
+void CTextureUploadPolicy::ReleaseSlot( int slot )
+{
+	assert( slots[slot].State == USS_Pending );
+	deleteSlotIndex( slot, pendingSlots );
+	slots[slot].State = USS_Idle;
+	slots[slot].DataSize = 0;
+}
+
+void CTextureUploadPolicy::deleteSlotIndex( int slot, CArray<int>& slotList )
+{
+	for( int i = 0; i < slotList.Size(); i++ ) {
+		if( slotList[i] == slot ) {
+			slotList.DeleteAt( i );
+			return;
+		}
+	}
+	assert( false );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -0,0 +1,243 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TextureUploadQueue.h>
+#include <TextureBinder.h>
+#include <TextureData.h>
+#include <DefaultSamplerContainer.h>
+#include <GlBuffer.h>
+#include <GinError.h>
+#include <CriticalSectionLock.h>
+
+namespace Gin {
+
+//////////////////////////////////////////////////////////////////////////
+
+CTextureUploadQueue::CTextureUploadQueue( int stagingBufferCount, int _stagingBufferSize, int frameByteBudget ) :
+	stagingBufferSize( _stagingBufferSize ),
+	policy( stagingBufferCount, _stagingBufferSize, frameByteBudget )
+{
+	::InitializeCriticalSection( &lock );
+	for( int i = 0; i < stagingBufferCount; i++ ) {
+		const auto bufferId = GinInternal::CGlBufferOperations::CreateBufferId();
+		GinInternal::CGlBufferOperations::ReserveBuffer( bufferId, stagingBufferSize, BT_PixelUnpack, BUH_StreamDraw );
+		bufferIds.Add( bufferId );
+		mappedMemory.Add( nullptr );
+		fences.Add( nullptr );
+	}
+	requests.IncreaseSize( stagingBufferCount );
+	prepareIdleSlots();
+}
+
+CTextureUploadQueue::~CTextureUploadQueue()
+{
+	for( int i = 0; i < bufferIds.Size(); i++ ) {
+		if( fences[i] != nullptr ) {
+			gl::DeleteSync( static_cast<GLsync>( fences[i] ) );
+		}
+		if( mappedMemory[i] != nullptr ) {
+			unmapStagingBuffer( i );
+		}
+		GinInternal::CGlBufferOperations::FreeBufferId( bufferIds[i] );
+	}
+	::DeleteCriticalSection( &lock );
+}
+
+int CTextureUploadQueue::GetFrameByteBudget() const
+{
+	CCriticalSectionLock queueLock( lock );
+	return policy.GetFrameByteBudget();
+}
+
+void CTextureUploadQueue::SetFrameByteBudget( int newValue )
+{
+	CCriticalSectionLock queueLock( lock );
+	policy.SetFrameByteBudget( newValue );
+}
+
+CTextureUploadStatistics CTextureUploadQueue::GetStatistics() const
+{
+	CCriticalSectionLock queueLock( lock );
+	return policy.GetStatistics();
+}
+
+int CTextureUploadQueue::BeginUpload( int byteSize, BYTE*& stagingMemory )
+{
+	assert( byteSize > 0 && byteSize <= stagingBufferSize );
+	CCriticalSectionLock queueLock( lock );
+	const int slot = policy.AcquireSlot( byteSize );
+	stagingMemory = slot == NotFound ? nullptr : mappedMemory[slot];
+	return slot;
+}
+
+void CTextureUploadQueue::CommitUpload( int uploadHandle, int byteSize, const CTextureUploadRequest& request )
+{
+	assert( request.TextureId != 0 );
+	assert( request.Level >= 0 && request.Size.X() > 0 && request.Size.Y() > 0 );
+	CCriticalSectionLock queueLock( lock );
+	requests[uploadHandle] = request;
+	policy.CommitSlot( uploadHandle, byteSize );
+}
+
+void CTextureUploadQueue::CancelUpload( int uploadHandle )
+{
+	CCriticalSectionLock queueLock( lock );
+	policy.CancelSlot( uploadHandle );
+}
+
+void CTextureUploadQueue::Update()
+{
+	{
+		CCriticalSectionLock queueLock( lock );
+		policy.AdvanceFrame();
+	}
+	releaseFinishedUploads();
+	issueQueuedUploads();
+	prepareIdleSlots();
+}
+
+void CTextureUploadQueue::releaseFinishedUploads()
+{
+	// Fences are signaled in the issue order, the first unsignaled fence stops the search.
+	for( ;; ) {
+		int slot;
+		{
+			CCriticalSectionLock queueLock( lock );
+			slot = policy.GetOldestPendingSlot();
+		}
+		if( slot == NotFound ) {
+			return;
+		}
+
+		const auto fence = static_cast<GLsync>( fences[slot] );
+		const auto waitResult = gl::ClientWaitSync( fence, 0, 0 );
+		if( waitResult == gl::TIMEOUT_EXPIRED ) {
+			return;
+		}
+		CheckGlError();
+		gl::DeleteSync( fence );
+		fences[slot] = nullptr;
+
+		const auto listener = requests[slot].Listener;
+		const auto uploadId = requests[slot].UploadId;
+		{
+			CCriticalSectionLock queueLock( lock );
+			policy.ReleaseSlot( slot );
+		}
+		if( listener != nullptr ) {
+			listener->OnUploadComplete( uploadId );
+		}
+	}
+}
+
+void CTextureUploadQueue::issueQueuedUploads()
+{
+	for( ;; ) {
+		int slot;
+		int byteSize;
+		{
+			CCriticalSectionLock queueLock( lock );
+			slot = policy.ScheduleNextUpload();
+			if( slot == NotFound ) {
+				return;
+			}
+			byteSize = policy.GetSlotDataSize( slot );
+		}
+
+		const auto& request = requests[slot];
+		if( !unmapStagingBuffer( slot ) ) {
+			// The staging memory has been corrupted, there is nothing to upload.
+			const auto listener = request.Listener;
+			const auto uploadId = request.UploadId;
+			{
+				CCriticalSectionLock queueLock( lock );
+				policy.ReleaseSlot( slot );
+			}
+			if( listener != nullptr ) {
+				listener->OnUploadLost( uploadId );
+			}
+			continue;
+		}
+
+		CBufferObjectBinder unpackBinder( BT_PixelUnpack, bufferIds[slot] );
+		uploadRegion( request, byteSize );
+		fences[slot] = gl::FenceSync( gl::SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		CheckGlError();
+	}
+}
+
+void CTextureUploadQueue::prepareIdleSlots()
+{
+	for( ;; ) {
+		int slot;
+		{
+			CCriticalSectionLock queueLock( lock );
+			slot = policy.FindIdleSlot();
+		}
+		if( slot == NotFound ) {
+			return;
+		}
+
+		// The fence guarantees that the GPU is done with the buffer, no additional synchronization is needed.
+		CBufferObjectBinder binder( BT_CopyWrite, bufferIds[slot] );
+		const GLbitfield mapFlags = gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_BUFFER_BIT | gl::MAP_UNSYNCHRONIZED_BIT;
+		const auto memory = static_cast<BYTE*>( gl::MapBufferRange( BT_CopyWrite, 0, stagingBufferSize, mapFlags ) );
+		CheckGlError();
+		if( memory == nullptr ) {
+			// Mapping is retried during the next update.
+			return;
+		}
+		mappedMemory[slot] = memory;
+		{
+			CCriticalSectionLock queueLock( lock );
+			policy.OnSlotPrepared( slot );
+		}
+	}
+}
+
+// Release buffer mapping.
+// False return value indicates that the buffer contents have been lost.
+bool CTextureUploadQueue::unmapStagingBuffer( int slot )
+{
+	CBufferObjectBinder binder( BT_CopyWrite, bufferIds[slot] );
+	const bool unmapSuccessful = ( gl::UnmapBuffer( BT_CopyWrite ) == gl::TRUE_ );
+	mappedMemory[slot] = nullptr;
+	CheckGlError();
+	return unmapSuccessful;
+}
+
+// Copy the region from the bound pixel unpack buffer.
+void CTextureUploadQueue::uploadRegion( const CTextureUploadRequest& request, int byteSize ) const
+{
+	CTextureBinder textureBinder( request.Target, GinInternal::CTextureData( request.TextureId, GetDefaultSampler() ) );
+	const bool isCompressed = request.CompressionType != TCT_Uncompressed;
+	const auto offset = request.Offset;
+	const auto size = request.Size;
+	switch( request.Target ) {
+	case TBT_Texture2:
+	case TBT_CubeMap: {
+		const GLenum imageTarget = request.Target == TBT_CubeMap ? static_cast<GLenum>( request.Face ) : static_cast<GLenum>( TBT_Texture2 );
+		if( isCompressed ) {
+			gl::CompressedTexSubImage2D( imageTarget, request.Level, offset.X(), offset.Y(), size.X(), size.Y(), request.CompressionType, byteSize, nullptr );
+		} else {
+			gl::TexSubImage2D( imageTarget, request.Level, offset.X(), offset.Y(), size.X(), size.Y(), request.TexelFormat, request.DataType, nullptr );
+		}
+		break;
+	}
+	case TBT_TextureArray2:
+		if( isCompressed ) {
+			gl::CompressedTexSubImage3D( TBT_TextureArray2, request.Level, offset.X(), offset.Y(), request.Layer, size.X(), size.Y(), 1, request.CompressionType, byteSize, nullptr );
+		} else {
+			gl::TexSubImage3D( TBT_TextureArray2, request.Level, offset.X(), offset.Y(), request.Layer, size.X(), size.Y(), 1, request.TexelFormat, request.DataType, nullptr );
+		}
+		break;
+	default:
+		assert( false );
+	}
+	CheckGlError();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Gin.
+
@@ -46,6 +46,7 @@ int FindBytesPerPixel( TTexelDataType texelDataType, TTexelFormat texelFormat )
 		return findUnpackedBytesPerPixel( texelFormat, 1 );
 	case TDT_UnsignedShort:
 	case TDT_Short:
+	case TDT_HalfFloat:
 		return findUnpackedBytesPerPixel( texelFormat, 2 );
 	case TDT_UnsignedInt:
 	case TDT_Int:
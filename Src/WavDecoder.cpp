@@ -0,0 +1,426 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <WavDecoder.h>
+#include <WavUtils.h>
+
+// SSE2 is a part of the x64 instruction set and is enabled by /arch:SSE2 on x86.
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#define GIN_WAV_DECODE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+static short readShort( const BYTE* src )
+{
+	short result;
+	memcpy( &result, src, sizeof( result ) );
+	return result;
+}
+
+static int readInt( const BYTE* src )
+{
+	int result;
+	memcpy( &result, src, sizeof( result ) );
+	return result;
+}
+
+// Scale of the 32 bit integer samples to the [-1, 1) range.
+static const float intSampleScale = 1.0f / 2147483648.0f;
+
+static void convertPcm24ToPcm16( const BYTE* src, int sampleCount, short* dest )
+{
+	// The lowest byte is dropped.
+	for( int i = 0; i < sampleCount; i++ ) {
+		dest[i] = static_cast<short>( src[3 * i + 1] | ( src[3 * i + 2] << 8 ) );
+	}
+}
+
+static void convertPcm24ToFloat( const BYTE* src, int sampleCount, float* dest )
+{
+	for( int i = 0; i < sampleCount; i++ ) {
+		const unsigned value = ( src[3 * i] << 8 ) | ( src[3 * i + 1] << 16 ) | ( static_cast<unsigned>( src[3 * i + 2] ) << 24 );
+		dest[i] = static_cast<int>( value ) * intSampleScale;
+	}
+}
+
+static void convertPcm32ToPcm16( const BYTE* src, int sampleCount, short* dest )
+{
+	int i = 0;
+#ifdef GIN_WAV_DECODE_SSE2
+	for( ; i + 8 <= sampleCount; i += 8 ) {
+		const __m128i low = _mm_srai_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + 4 * i ) ), 16 );
+		const __m128i high = _mm_srai_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + 4 * i + 16 ) ), 16 );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i ), _mm_packs_epi32( low, high ) );
+	}
+#endif
+	for( ; i < sampleCount; i++ ) {
+		dest[i] = static_cast<short>( readInt( src + 4 * i ) >> 16 );
+	}
+}
+
+static void convertPcm32ToFloat( const BYTE* src, int sampleCount, float* dest )
+{
+	int i = 0;
+#ifdef GIN_WAV_DECODE_SSE2
+	const __m128 scale = _mm_set1_ps( intSampleScale );
+	for( ; i + 4 <= sampleCount; i += 4 ) {
+		const __m128i values = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + 4 * i ) );
+		_mm_storeu_ps( dest + i, _mm_mul_ps( _mm_cvtepi32_ps( values ), scale ) );
+	}
+#endif
+	for( ; i < sampleCount; i++ ) {
+		dest[i] = readInt( src + 4 * i ) * intSampleScale;
+	}
+}
+
+static void convertFloatToPcm16( const BYTE* src, int sampleCount, short* dest )
+{
+	int i = 0;
+#ifdef GIN_WAV_DECODE_SSE2
+	// Values are clamped before the conversion, out of range conversions produce the integer minimum.
+	const __m128 minValue = _mm_set1_ps( -1.0f );
+	const __m128 maxValue = _mm_set1_ps( 1.0f );
+	const __m128 scale = _mm_set1_ps( 32767.0f );
+	for( ; i + 8 <= sampleCount; i += 8 ) {
+		const __m128 low = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( reinterpret_cast<const float*>( src + 4 * i ) ), minValue ), maxValue );
+		const __m128 high = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( reinterpret_cast<const float*>( src + 4 * i + 16 ) ), minValue ), maxValue );
+		const __m128i lowValues = _mm_cvtps_epi32( _mm_mul_ps( low, scale ) );
+		const __m128i highValues = _mm_cvtps_epi32( _mm_mul_ps( high, scale ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i ), _mm_packs_epi32( lowValues, highValues ) );
+	}
+#endif
+	for( ; i < sampleCount; i++ ) {
+		float value;
+		memcpy( &value, src + 4 * i, sizeof( value ) );
+		value = max( -1.0f, min( 1.0f, value ) );
+		// Rounded to the nearest even value like the vector conversion.
+		dest[i] = static_cast<short>( lrintf( value * 32767.0f ) );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int imaStepTableSize = 89;
+static const int imaStepTable[imaStepTableSize] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+static const int imaIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+// State of a single ADPCM channel.
+struct CImaChannelState {
+	int Predictor;
+	int StepIndex;
+
+	short DecodeNibble( int nibble );
+};
+
+short CImaChannelState::DecodeNibble( int nibble )
+{
+	const int step = imaStepTable[StepIndex];
+	int difference = step >> 3;
+	if( ( nibble & 1 ) != 0 ) {
+		difference += step >> 2;
+	}
+	if( ( nibble & 2 ) != 0 ) {
+		difference += step >> 1;
+	}
+	if( ( nibble & 4 ) != 0 ) {
+		difference += step;
+	}
+	Predictor += ( nibble & 8 ) != 0 ? -difference : difference;
+	Predictor = max( -32768, min( 32767, Predictor ) );
+	StepIndex = max( 0, min( imaStepTableSize - 1, StepIndex + imaIndexTable[nibble & 7] ) );
+	return static_cast<short>( Predictor );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CWavDecoder::CWavDecoder( CStringPart fileName, bool allowFloatOutput )
+{
+	wavFile.Open( fileName, FRWM_Read, FCM_OpenExisting, FSM_DenyNone );
+	parseHeaders( allowFloatOutput );
+	Rewind();
+}
+
+static const CStringView wavFileTooSmallError = "WAV file too small";
+static const CStringView invalidWavFileError = "Invalid WAV file";
+static const int riffFileId = 0x46464952;	// "RIFF".
+static const int wavFileFormat = 0x45564157;	// "WAVE".
+static const int wavFormatId = 0x20746d66;	// "fmt ".
+static const int wavFactId = 0x74636166;	// "fact".
+static const int wavDataId = 0x61746164;	// "data".
+// Size of the basic format chunk and the format chunk with the extensible format fields.
+static const int minFormatSize = 16;
+static const int maxFormatSize = 40;
+void CWavDecoder::parseHeaders( bool allowFloatOutput )
+{
+	WAV::CRiffHeader riffHeader;
+	checkWavError( wavFile.Read( &riffHeader, sizeof( riffHeader ) ) == sizeof( riffHeader ), wavFileTooSmallError );
+	checkWavError( riffHeader.Id == riffFileId && riffHeader.Format == wavFileFormat, invalidWavFileError );
+
+	bool hasFormat = false;
+	int factFrameCount = NotFound;
+	int chunkOffset = sizeof( riffHeader );
+	for( ;; ) {
+		// All the chunks start with the same identifier and size pair as the data chunk.
+		WAV::CWavSubheader2 chunkHeader;
+		checkWavError( wavFile.Read( &chunkHeader, sizeof( chunkHeader ) ) == sizeof( chunkHeader ), wavFileTooSmallError );
+		checkWavError( chunkHeader.Size >= 0, invalidWavFileError );
+		chunkOffset += sizeof( chunkHeader );
+		if( chunkHeader.Id == wavDataId ) {
+			checkWavError( hasFormat, invalidWavFileError );
+			dataOffset = chunkOffset;
+			dataSize = chunkHeader.Size;
+			break;
+		}
+
+		if( chunkHeader.Id == wavFormatId ) {
+			checkWavError( chunkHeader.Size >= minFormatSize, invalidWavFileError );
+			BYTE formatData[maxFormatSize];
+			const int formatSize = min( chunkHeader.Size, maxFormatSize );
+			checkWavError( wavFile.Read( formatData, formatSize ) == formatSize, wavFileTooSmallError );
+			parseFormat( formatData, formatSize, allowFloatOutput );
+			hasFormat = true;
+		} else if( chunkHeader.Id == wavFactId && chunkHeader.Size >= static_cast<int>( sizeof( int ) ) ) {
+			checkWavError( wavFile.Read( &factFrameCount, sizeof( int ) ) == sizeof( int ), wavFileTooSmallError );
+		}
+		// Chunks are padded to an even size.
+		chunkOffset += chunkHeader.Size + ( chunkHeader.Size & 1 );
+		wavFile.Seek( chunkOffset, FSP_Begin );
+	}
+
+	if( encoding != WSE_ImaAdpcm ) {
+		frameCount = dataSize / blockAlign;
+		return;
+	}
+	// Frames of the last incomplete block are counted too.
+	const int headerSize = 4 * channelCount;
+	const int lastBlockSize = dataSize % blockAlign;
+	frameCount = ( dataSize / blockAlign ) * framesPerBlock + ( lastBlockSize >= headerSize ? 1 + ( lastBlockSize - headerSize ) / headerSize * 8 : 0 );
+	if( factFrameCount >= 0 ) {
+		frameCount = min( frameCount, factFrameCount );
+	}
+}
+
+static const CStringView unsupportedFeatureError = "WAV feature unsupported";
+static const CStringView compressionNotSupportedError = "WAV compression format is not supported";
+static const int pcmFormatTag = 1;
+static const int floatFormatTag = 3;
+static const int imaAdpcmFormatTag = 0x11;
+// The actual format tag is stored in the first bytes of the subformat identifier.
+static const int extensibleFormatTag = 0xFFFE;
+static const int extensibleSubformatOffset = 24;
+void CWavDecoder::parseFormat( const BYTE* data, int size, bool allowFloatOutput )
+{
+	int formatTag = static_cast<WORD>( readShort( data ) );
+	channelCount = readShort( data + 2 );
+	sampleRate = readInt( data + 4 );
+	blockAlign = readShort( data + 12 );
+	const int bitsPerSample = readShort( data + 14 );
+	if( formatTag == extensibleFormatTag ) {
+		checkWavError( size >= maxFormatSize, invalidWavFileError );
+		formatTag = static_cast<WORD>( readShort( data + extensibleSubformatOffset ) );
+	}
+	checkWavError( channelCount == 1 || channelCount == 2, unsupportedFeatureError );
+	checkWavError( sampleRate > 0 && blockAlign > 0, invalidWavFileError );
+
+	bool isWideFormat = true;
+	switch( formatTag ) {
+	case pcmFormatTag:
+		checkWavError( bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32, unsupportedFeatureError );
+		checkWavError( blockAlign == channelCount * bitsPerSample / 8, invalidWavFileError );
+		encoding = bitsPerSample == 8 ? WSE_Pcm8 : bitsPerSample == 16 ? WSE_Pcm16 : bitsPerSample == 24 ? WSE_Pcm24 : WSE_Pcm32;
+		isWideFormat = bitsPerSample > 16;
+		break;
+	case floatFormatTag:
+		checkWavError( bitsPerSample == 32, unsupportedFeatureError );
+		checkWavError( blockAlign == channelCount * 4, invalidWavFileError );
+		encoding = WSE_Float32;
+		break;
+	case imaAdpcmFormatTag: {
+		// A block starts with a header of 4 bytes per channel, the rest of the block consists of 4 byte groups per channel.
+		const int headerSize = 4 * channelCount;
+		checkWavError( bitsPerSample == 4, unsupportedFeatureError );
+		checkWavError( blockAlign > headerSize && ( blockAlign - headerSize ) % headerSize == 0, invalidWavFileError );
+		encoding = WSE_ImaAdpcm;
+		isWideFormat = false;
+		framesPerBlock = 1 + ( blockAlign - headerSize ) / headerSize * 8;
+		break;
+	}
+	default:
+		checkWavError( false, compressionNotSupportedError );
+	}
+
+	if( encoding == WSE_Pcm8 ) {
+		outputFormat = channelCount == 1 ? ADF_Mono8 : ADF_Stereo8;
+		outputFrameSize = channelCount;
+	} else if( isWideFormat && allowFloatOutput ) {
+		outputFormat = channelCount == 1 ? ADF_MonoFloat32 : ADF_StereoFloat32;
+		outputFrameSize = 4 * channelCount;
+	} else {
+		outputFormat = channelCount == 1 ? ADF_Mono16 : ADF_Stereo16;
+		outputFrameSize = 2 * channelCount;
+	}
+}
+
+int CWavDecoder::Decode( int maxFrameCount, CArray<BYTE>& result )
+{
+	assert( maxFrameCount >= 0 );
+	return encoding == WSE_ImaAdpcm ? decodeAdpcm( maxFrameCount, result ) : decodePcm( maxFrameCount, result );
+}
+
+void CWavDecoder::Rewind()
+{
+	wavFile.Seek( dataOffset, FSP_Begin );
+	dataPosition = 0;
+	position = 0;
+	blockFrameCount = 0;
+	blockFramePosition = 0;
+}
+
+int CWavDecoder::decodePcm( int maxFrameCount, CArray<BYTE>& result )
+{
+	const int requestedFrameCount = min( maxFrameCount, frameCount - position );
+	const int decodedFrameCount = readData( requestedFrameCount * blockAlign ) / blockAlign;
+	if( decodedFrameCount < requestedFrameCount ) {
+		// The file ends before the end of the data chunk.
+		frameCount = position + decodedFrameCount;
+	}
+
+	const int resultOffset = result.Size();
+	result.IncreaseSizeNoInitialize( resultOffset + decodedFrameCount * outputFrameSize );
+	BYTE* dest = result.Ptr() + resultOffset;
+	const BYTE* src = readBuffer.Ptr();
+	const int sampleCount = decodedFrameCount * channelCount;
+	const bool isFloatOutput = outputFormat == ADF_MonoFloat32 || outputFormat == ADF_StereoFloat32;
+	switch( encoding ) {
+	case WSE_Pcm8:
+	case WSE_Pcm16:
+		memcpy( dest, src, decodedFrameCount * blockAlign );
+		break;
+	case WSE_Pcm24:
+		if( isFloatOutput ) {
+			convertPcm24ToFloat( src, sampleCount, reinterpret_cast<float*>( dest ) );
+		} else {
+			convertPcm24ToPcm16( src, sampleCount, reinterpret_cast<short*>( dest ) );
+		}
+		break;
+	case WSE_Pcm32:
+		if( isFloatOutput ) {
+			convertPcm32ToFloat( src, sampleCount, reinterpret_cast<float*>( dest ) );
+		} else {
+			convertPcm32ToPcm16( src, sampleCount, reinterpret_cast<short*>( dest ) );
+		}
+		break;
+	case WSE_Float32:
+		if( isFloatOutput ) {
+			memcpy( dest, src, decodedFrameCount * blockAlign );
+		} else {
+			convertFloatToPcm16( src, sampleCount, reinterpret_cast<short*>( dest ) );
+		}
+		break;
+	default:
+		assert( false );
+	}
+
+	position += decodedFrameCount;
+	return decodedFrameCount;
+}
+
+int CWavDecoder::decodeAdpcm( int maxFrameCount, CArray<BYTE>& result )
+{
+	int decodedFrameCount = 0;
+	while( decodedFrameCount < maxFrameCount && position < frameCount ) {
+		if( blockFramePosition == blockFrameCount && !readAdpcmBlock() ) {
+			frameCount = position;
+			break;
+		}
+		const int copyFrameCount = min( min( maxFrameCount - decodedFrameCount, blockFrameCount - blockFramePosition ), frameCount - position );
+		const int copySize = copyFrameCount * outputFrameSize;
+		const int resultOffset = result.Size();
+		result.IncreaseSizeNoInitialize( resultOffset + copySize );
+		memcpy( result.Ptr() + resultOffset, blockSamples.Ptr() + blockFramePosition * channelCount, copySize );
+		blockFramePosition += copyFrameCount;
+		position += copyFrameCount;
+		decodedFrameCount += copyFrameCount;
+	}
+	return decodedFrameCount;
+}
+
+static const CStringView invalidAdpcmBlockError = "Invalid ADPCM block";
+// Decode the next ADPCM block. Return false if the data has ended.
+bool CWavDecoder::readAdpcmBlock()
+{
+	const int headerSize = 4 * channelCount;
+	const int blockSize = readData( min( blockAlign, dataSize - dataPosition ) );
+	if( blockSize < headerSize ) {
+		return false;
+	}
+
+	const BYTE* src = readBuffer.Ptr();
+	const int groupCount = ( blockSize - headerSize ) / headerSize;
+	blockFrameCount = 1 + groupCount * 8;
+	blockFramePosition = 0;
+	if( blockSamples.Size() < blockFrameCount * channelCount ) {
+		blockSamples.IncreaseSizeNoInitialize( blockFrameCount * channelCount );
+	}
+	short* samples = blockSamples.Ptr();
+	for( int channel = 0; channel < channelCount; channel++ ) {
+		// The header holds the first sample and the initial step.
+		CImaChannelState state;
+		state.Predictor = readShort( src + 4 * channel );
+		state.StepIndex = src[4 * channel + 2];
+		checkWavError( state.StepIndex < imaStepTableSize, invalidAdpcmBlockError );
+		samples[channel] = static_cast<short>( state.Predictor );
+
+		// Each group holds 8 samples of the channel, the low nibble of a byte comes first.
+		for( int group = 0; group < groupCount; group++ ) {
+			const BYTE* groupData = src + headerSize + ( group * channelCount + channel ) * 4;
+			short* groupSamples = samples + ( 1 + group * 8 ) * channelCount + channel;
+			for( int i = 0; i < 4; i++ ) {
+				groupSamples[2 * i * channelCount] = state.DecodeNibble( groupData[i] & 0x0F );
+				groupSamples[( 2 * i + 1 ) * channelCount] = state.DecodeNibble( groupData[i] >> 4 );
+			}
+		}
+	}
+	return true;
+}
+
+// Read the next part of the data chunk to the read buffer. Return the number of bytes read.
+int CWavDecoder::readData( int size )
+{
+	size = min( size, dataSize - dataPosition );
+	if( readBuffer.Size() < size ) {
+		readBuffer.IncreaseSizeNoInitialize( size );
+	}
+	const int readSize = size > 0 ? wavFile.Read( readBuffer.Ptr(), size ) : 0;
+	dataPosition += readSize;
+	return readSize;
+}
+
+void CWavDecoder::checkWavError( bool condition, CStringPart errorStr ) const
+{
+	if( !condition ) {
+		throw CWavException( wavFile.GetFileName(), errorStr );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
@@ -0,0 +1,136 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <WavStream.h>
+#include <AlGlobals.h>
+#include <AlContextManager.h>
+
+namespace Gin {
+
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+
+CWavStream::CWavStream( CStringPart fileName, int bufferCount, int bufferDuration ) :
+	backend( GetAudioContextManager().GetBackend() ),
+	decoder( fileName, backend.IsFloatFormatSupported() ),
+	buffers( bufferCount )
+{
+	assert( bufferCount > 0 && bufferDuration > 0 );
+	bufferFrameCount = max( 1, decoder.GetSampleRate() * bufferDuration / 1000 );
+	sourceId = backend.CreateSource();
+	backend.SetSourceRelative( sourceId, true );
+}
+
+CWavStream::~CWavStream()
+{
+	assert( GetAudioContextManager().HasContext() );
+	// Buffers can't be deleted while they are attached to the source.
+	backend.StopSource( sourceId );
+	backend.DetachBuffers( sourceId );
+	backend.DeleteSource( sourceId );
+}
+
+void CWavStream::SetPosition( CVector3<float> newValue )
+{
+	backend.SetSourceRelative( sourceId, false );
+	backend.SetSourcePosition( sourceId, newValue );
+}
+
+void CWavStream::SetGain( float newValue )
+{
+	backend.SetSourceGain( sourceId, newValue );
+}
+
+void CWavStream::Play()
+{
+	if( !isActive ) {
+		queueBuffers( buffers.Buffers() );
+		isActive = true;
+	}
+	isPaused = false;
+	backend.PlaySource( sourceId );
+}
+
+void CWavStream::Pause()
+{
+	if( isActive ) {
+		backend.PauseSource( sourceId );
+		isPaused = true;
+	}
+}
+
+void CWavStream::Stop()
+{
+	backend.StopSource( sourceId );
+	backend.DetachBuffers( sourceId );
+	decoder.Rewind();
+	isActive = false;
+	isPaused = false;
+}
+
+void CWavStream::Update()
+{
+	if( !isActive || isPaused ) {
+		return;
+	}
+
+	unsigned processedIds[DefaultBufferCount];
+	for( ;; ) {
+		const int unqueueCount = backend.UnqueueProcessedBuffers( sourceId, DefaultBufferCount, processedIds );
+		if( unqueueCount == 0 ) {
+			break;
+		}
+		queueBuffers( CArrayView<unsigned>( processedIds, unqueueCount ) );
+	}
+
+	if( backend.GetSourceState( sourceId ) == CAudioRecord::RS_Playing ) {
+		return;
+	}
+	if( backend.GetQueuedBufferCount( sourceId ) > 0 ) {
+		// The source has played all the queued data before the update.
+		backend.PlaySource( sourceId );
+	} else {
+		// The data has ended.
+		Stop();
+	}
+}
+
+// Fill the buffers with the next parts of the file and append them to the source queue.
+void CWavStream::queueBuffers( CArrayView<unsigned> bufferIds )
+{
+	for( auto bufferId : bufferIds ) {
+		if( !fillBuffer( bufferId ) ) {
+			break;
+		}
+		backend.QueueBuffers( sourceId, 1, &bufferId );
+	}
+}
+
+// Decode the next part of the file to the buffer. Return false if there is no data left.
+bool CWavStream::fillBuffer( unsigned bufferId )
+{
+	bufferData.Empty();
+	int frameCount = decoder.Decode( bufferFrameCount, bufferData );
+	while( isLooping && frameCount < bufferFrameCount && decoder.GetFrameCount() > 0 ) {
+		decoder.Rewind();
+		frameCount += decoder.Decode( bufferFrameCount - frameCount, bufferData );
+	}
+	if( frameCount == 0 ) {
+		return false;
+	}
+
+	backend.SetBufferData( bufferId, decoder.GetOutputFormat(), decoder.GetSampleRate(), bufferData.Ptr(), bufferData.Size() );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Audio.
+
+}	// namespace Gin.
+
+#endif
+
@@ -9,20 +9,6 @@ namespace GinInternal {
 
 //////////////////////////////////////////////////////////////////////////
 
-struct CGifEntry {
-	uint16_t length;
-	uint16_t prefix;
-	uint8_t suffix;
-};
-
-struct CGifTable {
-	int bulk;
-	int nentries;
-	CArray<CGifEntry> entries;
-};
-
-//////////////////////////////////////////////////////////////////////////
-
 static void throwGifError( CStringView errorStr )
 {
 	throw CGifInternalException( errorStr );
@@ -30,15 +16,17 @@ static void throwGifError( CStringView errorStr )
 
 static void read( CGiffBuffer& buffer, void* dest, int byteCount )
 {
+	if( buffer.Pos + byteCount > buffer.GifData.Size() ) {
+		throwGifError( "unexpected end of data" );
+	}
 	::memcpy( dest, buffer.GifData.Ptr() + buffer.Pos, byteCount );
 	buffer.Pos += byteCount;
 }
 
 static uint16_t read_num( CGiffBuffer& buffer )
 {
-	const auto pos = buffer.Pos;
-	uint8_t bytes[2]{ buffer.GifData[pos], buffer.GifData[pos + 1] };
-	buffer.Pos += 2;
+	uint8_t bytes[2];
+	read( buffer, bytes, 2 );
 	return bytes[0] + ( ( (uint16_t) bytes[1] ) << 8 );
 }
 
@@ -218,63 +206,152 @@ static void read_ext( CGiffDecodeData* gif )
 	}
 }
 
-static CGifTable new_table( int key_size )
+// Number of codes in a full LZW table.
+static const int maxLzwCodeCount = 0x1000;
+// Maximum LZW code width in bits.
+static const int maxLzwKeySize = 12;
+// Zero bytes after the code stream. Enough for a word read at any position the code reader can reach.
+static const int codeStreamPadding = 16;
+
+// Reader of the LZW codes. Codes are packed starting from the least significant bit, the stream is read in 64-bit words.
+class CLzwCodeReader {
+public:
+	explicit CLzwCodeReader( CArrayView<uint8_t> _stream ) : stream( _stream.Ptr() ), streamBitCount( 8 * ( _stream.Size() - codeStreamPadding ) ) {}
+
+	// Check if the codes read so far exceeded the stream data.
+	bool IsExhausted() const
+		{ return 8 * pos - bitCount > streamBitCount; }
+
+	int ReadCode( int keySize )
+	{
+		if( bitCount < keySize ) {
+			refill();
+		}
+		const int code = static_cast<int>( bitBuffer & ( ( 1 << keySize ) - 1 ) );
+		bitBuffer >>= keySize;
+		bitCount -= keySize;
+		return code;
+	}
+
+private:
+	const uint8_t* stream;
+	int streamBitCount;
+	// Position of the next unread byte.
+	int pos = 0;
+	unsigned __int64 bitBuffer = 0;
+	int bitCount = 0;
+
+	void refill()
+	{
+		unsigned __int64 word;
+		::memcpy( &word, stream + pos, sizeof( word ) );
+		bitBuffer |= word << bitCount;
+		// Only whole bytes that fit into the buffer are consumed.
+		const int byteCount = ( 64 - bitCount ) / 8;
+		pos += byteCount;
+		bitCount += 8 * byteCount;
+	}
+};
+
+// Gather the image data sub-blocks into a contiguous padded buffer.
+static void read_code_stream( CGiffDecodeData* gif )
 {
-	CGifTable table;
-	int key;
-	int init_bulk = max( 1 << ( key_size + 1 ), 0x100 );
-	table.entries.IncreaseSize( init_bulk );
-	table.bulk = init_bulk;
-	table.nentries = ( 1 << key_size ) + 2;
-	for( key = 0; key < ( 1 << key_size ); key++ ) {
-		table.entries[key] = CGifEntry{ 1, 0xFFF, static_cast<uint8_t>( key ) };
+	auto& result = gif->CodeStream;
+	result.Empty();
+	uint8_t size;
+	read( gif->fd, &size, 1 );
+	while( size != 0 ) {
+		const int pos = result.Size();
+		result.IncreaseSizeNoInitialize( pos + size );
+		read( gif->fd, result.Ptr() + pos, size );
+		read( gif->fd, &size, 1 );
 	}
-	return table;
+	const int dataSize = result.Size();
+	result.IncreaseSizeNoInitialize( dataSize + codeStreamPadding );
+	::memset( result.Ptr() + dataSize, 0, codeStreamPadding );
 }
 
-/* Add table entry. Return value:
- *  0 on success
- *  +1 if key size must be incremented after this addition
- *  -1 if could not realloc table */
-static int add_entry( CGifTable* table, uint16_t length, uint16_t prefix, uint8_t suffix )
+// Strings that fit into this size are copied with a single word. The decoder output must be padded by this size.
+static const int decodedWordSize = 8;
+
+// Copy a previously decoded string to the end of the output.
+static void copy_decoded_string( uint8_t* output, int srcPos, int destPos, int length )
 {
-	if( table->nentries == table->bulk ) {
-		table->bulk *= 2;
-		table->entries.IncreaseSize( table->bulk );
-	}
-	table->entries[table->nentries] = CGifEntry{ length, prefix, suffix };
-	table->nentries++;
-	if( ( table->nentries & ( table->nentries - 1 ) ) == 0 ) {
-		return 1;
+	if( srcPos + length > destPos ) {
+		// The source of the code that is being defined overlaps the destination. Bytes are copied one by one to repeat the start of the string.
+		for( int i = 0; i < length; i++ ) {
+			output[destPos + i] = output[srcPos + i];
+		}
+	} else if( length <= decodedWordSize ) {
+		// Bytes after the string are overwritten by the next strings.
+		unsigned __int64 word;
+		::memcpy( &word, output + srcPos, sizeof( word ) );
+		::memcpy( output + destPos, &word, sizeof( word ) );
+	} else {
+		::memcpy( output + destPos, output + srcPos, length );
 	}
-	return 0;
 }
 
-static uint16_t get_key( CGiffDecodeData* gif, int key_size, uint8_t* sub_len, uint8_t* shift, uint8_t* byte )
+/* Decode the LZW code stream to the color indices in the stream order. Return the number of decoded indices.
+ * The output must have decodedWordSize bytes of padding after outputSize.
+ * Every string of the code table is a previous output string followed by one index, so the table entries
+ * reference the place in the output where their string was first decoded and strings are copied as a whole. */
+static int decode_lzw_stream( CArrayView<uint8_t> codeStream, int minKeySize, uint8_t* output, int outputSize )
 {
-	int bits_read;
-	int rpad;
-	int frag_size;
-	uint16_t key;
-
-	key = 0;
-	for( bits_read = 0; bits_read < key_size; bits_read += frag_size ) {
-		rpad = ( *shift + bits_read ) % 8;
-		if( rpad == 0 ) {
-			/* Update byte. */
-			if( *sub_len == 0 ) {
-				read( gif->fd, sub_len, 1 ); /* Must be nonzero! */
+	if( minKeySize < 1 || minKeySize >= maxLzwKeySize ) {
+		throwGifError( "invalid LZW code size" );
+	}
+	const int clear = 1 << minKeySize;
+	const int stop = clear + 1;
+	int entryOffsets[maxLzwCodeCount];
+	int entryLengths[maxLzwCodeCount];
+	int keySize = minKeySize + 1;
+	int nextCode = clear + 2;
+	// String decoded by the previous code. Its offset is NotFound at the start of the table.
+	int prevOffset = NotFound;
+	int prevLength = 0;
+	int outPos = 0;
+
+	CLzwCodeReader reader( codeStream );
+	while( outPos < outputSize ) {
+		const int code = reader.ReadCode( keySize );
+		if( reader.IsExhausted() || code == stop ) {
+			break;
+		}
+		if( code == clear ) {
+			keySize = minKeySize + 1;
+			nextCode = clear + 2;
+			prevOffset = NotFound;
+			continue;
+		}
+
+		int length;
+		if( code < clear ) {
+			output[outPos] = static_cast<uint8_t>( code );
+			length = 1;
+		} else if( code > stop && code < nextCode ) {
+			length = min( entryLengths[code], outputSize - outPos );
+			copy_decoded_string( output, entryOffsets[code], outPos, length );
+		} else if( code == nextCode && prevOffset != NotFound ) {
+			length = min( prevLength + 1, outputSize - outPos );
+			copy_decoded_string( output, prevOffset, outPos, length );
+		} else {
+			throwGifError( "invalid LZW code" );
+		}
+
+		if( prevOffset != NotFound && nextCode < maxLzwCodeCount ) {
+			entryOffsets[nextCode] = prevOffset;
+			entryLengths[nextCode] = prevLength + 1;
+			nextCode++;
+			if( nextCode == ( 1 << keySize ) && keySize < maxLzwKeySize ) {
+				keySize++;
 			}
-			read( gif->fd, byte, 1 );
-			( *sub_len )--;
 		}
-		frag_size = min( key_size - bits_read, 8 - rpad );
-		key |= ( (uint16_t) ( ( *byte ) >> rpad ) ) << bits_read;
+		prevOffset = outPos;
+		prevLength = length;
+		outPos += length;
 	}
-	/* Clear extra bits to the left. */
-	key &= ( 1 << key_size ) - 1;
-	*shift = ( *shift + key_size ) % 8;
-	return key;
+	return outPos;
 }
 
 /* Compute output index of y-th input line, in frame of height h. */
@@ -287,12 +364,12 @@ static int interlaced_line_index( int h, int y )
 		return y * 8;
 	}
 	y -= p;
-	p = ( h - 5 ) / 8 + 1;
+	p = ( h + 3 ) / 8;
 	if( y < p ) { /* pass 2 */
 		return y * 8 + 4;
 	}
 	y -= p;
-	p = ( h - 3 ) / 4 + 1;
+	p = ( h + 1 ) / 4;
 	if( y < p ) { /* pass 3 */
 		return y * 4 + 2;
 	}
@@ -301,90 +378,30 @@ static int interlaced_line_index( int h, int y )
 	return y * 2 + 1;
 }
 
-/* Decompress image pixels.
- * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table). */
-static int read_image_data( CGiffDecodeData* gif, int interlace )
+/* Decompress image pixels. */
+static void read_image_data( CGiffDecodeData* gif, int interlace )
 {
-	uint8_t sub_len, shift, byte;
-	int init_key_size, key_size;
-	int	table_is_full = 0;
-	uint16_t str_len = 0;
-	int frm_off, p, x, y;
-	uint16_t key, clear, stop;
-	int ret;
-	CGifTable table;
-	CGifEntry entry{};
-	int start, end;
-
-	read( gif->fd, &byte, 1 );
-	key_size = (int) byte;
-	start = gif->fd.Pos;
-	discard_sub_blocks( gif );
-	end = gif->fd.Pos;
-	gif->fd.Pos = start;
-	clear = 1 << key_size;
-	stop = clear + 1;
-	table = new_table( key_size );
-	key_size++;
-	init_key_size = key_size;
-	sub_len = shift = 0;
-	key = get_key( gif, key_size, &sub_len, &shift, &byte ); /* clear code */
-	frm_off = 0;
-	ret = 0;
-	while( true ) {
-		if( key == clear ) {
-			key_size = init_key_size;
-			table.nentries = ( 1 << ( key_size - 1 ) ) + 2;
-			table_is_full = 0;
-		} else if( !table_is_full ) {
-			ret = add_entry( &table, str_len + 1, key, entry.suffix );
-			if( ret == -1 ) {
-				return -1;
-			}
-			if( table.nentries == 0x1000 ) {
-				ret = 0;
-				table_is_full = 1;
-			}
-		}
-		key = get_key( gif, key_size, &sub_len, &shift, &byte );
-		if( key == clear ) {
-			continue;
-		}
-		if( key == stop ) {
-			break;
-		}
-		if( ret == 1 ) {
-			key_size++;
-		}
-		entry = table.entries[key];
-		str_len = entry.length;
-		while( true ) {
-			p = frm_off + entry.length - 1;
-			x = p % gif->fw;
-			y = p / gif->fw;
-			if( interlace ) {
-				y = interlaced_line_index((int) gif->fh, y);
-			}
-			gif->frame[(gif->fy + y) * gif->width + gif->fx + x] = entry.suffix;
-			if( entry.prefix == 0xFFF ) {
-				break;
-			} else {
-				entry = table.entries[entry.prefix];
-			}
-		}
-		frm_off += str_len;
-		if( key < table.nentries - 1 && !table_is_full ) {
-			table.entries[table.nentries - 1].suffix = entry.suffix;
-		}
+	uint8_t minKeySize;
+	read( gif->fd, &minKeySize, 1 );
+	read_code_stream( gif );
+
+	const int pixelCount = gif->fw * gif->fh;
+	auto& indices = gif->FrameIndices;
+	if( indices.Size() < pixelCount + decodedWordSize ) {
+		indices.IncreaseSizeNoInitialize( pixelCount + decodedWordSize );
+	}
+	const int decodedCount = decode_lzw_stream( gif->CodeStream, minKeySize, indices.Ptr(), pixelCount );
+
+	// Pixels that are missing from a truncated stream keep their previous indices.
+	for( int y = 0; y * gif->fw < decodedCount; y++ ) {
+		const int frameY = interlace ? interlaced_line_index( gif->fh, y ) : y;
+		const int rowLength = min( static_cast<int>( gif->fw ), decodedCount - y * gif->fw );
+		::memcpy( gif->frame + ( gif->fy + frameY ) * gif->width + gif->fx, indices.Ptr() + y * gif->fw, rowLength );
 	}
-	read( gif->fd, &sub_len, 1 ); /* Must be zero! */
-	gif->fd.Pos = end;
-	return 0;
 }
 
-/* Read image.
- * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table). */
-static int read_image( CGiffDecodeData* gif )
+/* Read image. */
+static void read_image( CGiffDecodeData* gif )
 {
 	uint8_t fisrz;
 	int interlace;
@@ -394,6 +411,9 @@ static int read_image( CGiffDecodeData* gif )
 	gif->fy = read_num( gif->fd );
 	gif->fw = read_num( gif->fd );
 	gif->fh = read_num( gif->fd );
+	if( gif->fx + gif->fw > gif->width || gif->fy + gif->fh > gif->height ) {
+		throwGifError( "frame exceeds the canvas" );
+	}
 	read( gif->fd, &fisrz, 1 );
 	interlace = fisrz & 0x40;
 	/* Ignore Sort Flag. */
@@ -406,27 +426,24 @@ static int read_image( CGiffDecodeData* gif )
 	} else
 		gif->palette = gif->gct;
 	/* Image Data. */
-	return read_image_data( gif, interlace );
+	read_image_data( gif, interlace );
 }
 
 static void render_frame_rect( CGiffDecodeData* gif, uint8_t* buffer, CDynamicBitSet<>& transparencyMask )
 {
-	int i, j, k;
-	uint8_t index, *color;
-	i = gif->fy * gif->width + gif->fx;
-	for( j = 0; j < gif->fh; j++ ) {
-		for( k = 0; k < gif->fw; k++ ) {
-			const auto y = gif->fy + j;
-			const auto x = gif->fx + k;
-			const auto framePos = y * gif->width + x;
-			index = gif->frame[framePos];
-			if( !gif->gce.transparency || index != gif->gce.tindex ) {
-				color = &gif->palette->colors[index*3];
-				::memcpy( &buffer[( i + k ) * 3], color, 3 );
-				transparencyMask -= framePos;
+	const bool hasTransparency = gif->gce.transparency != 0;
+	const uint8_t* colors = gif->palette->colors;
+	for( int j = 0; j < gif->fh; j++ ) {
+		const int rowPos = ( gif->fy + j ) * gif->width + gif->fx;
+		const uint8_t* indices = gif->frame + rowPos;
+		uint8_t* row = buffer + 3 * rowPos;
+		for( int k = 0; k < gif->fw; k++ ) {
+			const uint8_t index = indices[k];
+			if( !hasTransparency || index != gif->gce.tindex ) {
+				::memcpy( row + 3 * k, colors + 3 * index, 3 );
+				transparencyMask -= rowPos + k;
 			}
 		}
-		i += gif->width;
 	}
 }
 
@@ -460,10 +477,15 @@ static void dispose( CGiffDecodeData* gif )
 
 /* Return 1 if got a frame; 0 if got GIF trailer; -1 if error. */
 int gd_get_frame( CGiffDecodeData* gif )
+{
+	dispose( gif );
+	return gd_read_frame( gif );
+}
+
+int gd_read_frame( CGiffDecodeData* gif )
 {
 	char sep;
 
-	dispose( gif );
 	read( gif->fd, &sep, 1 );
 	while( sep != ',' ) {
 		if( sep == ';' ) {
@@ -476,9 +498,7 @@ int gd_get_frame( CGiffDecodeData* gif )
 		}
 		read( gif->fd, &sep, 1 );
 	}
-	if( read_image( gif ) == -1 ) {
-		return -1;
-	}
+	read_image( gif );
 	return 1;
 }
 
@@ -54,12 +54,17 @@ struct CGiffDecodeData {
 	uint8_t *canvas, *frame;
 	CArray<uint8_t> ColorData;
 	CDynamicBitSet<> TransparencyMask;
+	// Buffers reused by the frame decoder: contiguous LZW code stream and the decoded indices in the stream order.
+	CArray<uint8_t> CodeStream;
+	CArray<uint8_t> FrameIndices;
 };
 
 //////////////////////////////////////////////////////////////////////////
 
 CGiffDecodeData gd_open_gif( CGiffBuffer buffer );
 int gd_get_frame( CGiffDecodeData* gif );
+// Read the next frame without disposing the previous one. Return value is the same as in gd_get_frame.
+int gd_read_frame( CGiffDecodeData* gif );
 void gd_render_frame( CGiffDecodeData* gif, uint8_t* buffer, CDynamicBitSet<>& transparencyMask );
 void gd_rewind( CGiffDecodeData* gif );
 
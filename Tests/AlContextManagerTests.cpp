@@ -0,0 +1,243 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <TestFramework.h>
+#include <FakeAudioBackend.h>
+#include <AlContextManager.h>
+
+namespace Gin {
+
+namespace Tests {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+// Size of the source pool of the context manager.
+static const int sourcePoolSize = 16;
+
+static CFakeAudioBackend& initializeFakeBackend( CAlContextManager& manager )
+{
+	auto backend = CreateOwner<CFakeAudioBackend>();
+	CFakeAudioBackend& result = *backend;
+	manager.InitializeBackend( move( backend ) );
+	return result;
+}
+
+// Create single buffer sounds of the given duration.
+static void createSounds( CFakeAudioBackend& backend, int count, float duration, CArray<unsigned>& bufferIds )
+{
+	bufferIds.IncreaseSize( count );
+	backend.CreateBuffers( count, bufferIds.Ptr() );
+	for( auto bufferId : bufferIds ) {
+		// The data is not read by the backend.
+		backend.SetBufferData( bufferId, ADF_Mono16, 1000, nullptr, Round( duration * 2000 ) );
+	}
+}
+
+static CSoundView getSound( const CArray<unsigned>& bufferIds, int index )
+{
+	return CSoundView( CArrayView<unsigned>( bufferIds.Ptr() + index, 1 ) );
+}
+
+// Play the sound in front of the listener. Voices of a new manager are numbered in the creation order.
+static void playSound( CAlContextManager& manager, CSoundView sound, float distance, TSourcePriority priority = SP_LowPriority, bool isLooping = false )
+{
+	manager.CreateRecord( sound, priority, CVector3<float>( 0.0f, 0.0f, -distance ), CVector3<float>(), isLooping );
+}
+
+static bool isPlaying( const CFakeAudioBackend& backend, unsigned bufferId )
+{
+	const unsigned sourceId = backend.FindBufferSource( bufferId );
+	return sourceId != 0 && backend.GetSource( sourceId ).State == CAudioRecord::RS_Playing;
+}
+
+static float getSourceOffset( const CFakeAudioBackend& backend, unsigned bufferId )
+{
+	return backend.GetSourceOffset( backend.FindBufferSource( bufferId ) );
+}
+
+// Simulate a frame of the given length.
+static void advance( CAlContextManager& manager, CFakeAudioBackend& backend, float seconds )
+{
+	backend.Advance( seconds );
+	manager.Update( seconds );
+}
+
+GIN_TEST( AlContextManagerPlaysVoicesOnSources )
+{
+	CAlContextManager manager;
+	auto& backend = initializeFakeBackend( manager );
+	GIN_CHECK( backend.GetSourceCount() == sourcePoolSize );
+	CArray<unsigned> bufferIds;
+	createSounds( backend, 1, 1.0f, bufferIds );
+
+	playSound( manager, getSound( bufferIds, 0 ), 2.0f );
+	GIN_CHECK( isPlaying( backend, bufferIds[0] ) );
+	GIN_CHECK( manager.GetVoiceCount() == 1 && manager.GetVirtualVoiceCount() == 0 );
+	GIN_CHECK( manager.HasSoundRecords( getSound( bufferIds, 0 ) ) );
+	const auto& source = backend.GetSource( backend.FindBufferSource( bufferIds[0] ) );
+	GIN_CHECK( !source.IsRelative && source.Position.Z() == -2.0f );
+
+	// Voice parameters are passed to the source. Panned voices are placed in front of the listener.
+	manager.SetVoiceGain( 0, 0.5f );
+	manager.SetVoicePan( 0, 0.6f );
+	GIN_CHECK( source.Gain == 0.5f );
+	GIN_CHECK( source.IsRelative && fabsf( source.Position.X() - 0.6f ) < 1e-6f && fabsf( source.Position.Z() + 0.8f ) < 1e-6f );
+
+	// Paused voices are kept.
+	manager.PauseVoice( 0 );
+	GIN_CHECK( manager.GetVoiceState( 0 ) == CAudioRecord::RS_Paused && source.State == CAudioRecord::RS_Paused );
+	advance( manager, backend, 0.5f );
+	GIN_CHECK( manager.GetVoiceCount() == 1 );
+
+	// Voices are released once their sources stop.
+	manager.PlayVoice( 0 );
+	advance( manager, backend, 0.6f );
+	GIN_CHECK( manager.GetVoiceState( 0 ) == CAudioRecord::RS_Playing );
+	advance( manager, backend, 0.6f );
+	GIN_CHECK( manager.GetVoiceCount() == 0 );
+	GIN_CHECK( manager.GetVoiceState( 0 ) == CAudioRecord::RS_Stopped );
+	GIN_CHECK( manager.GetAudioRecord( 0, 0 ) == NotFound );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[0] ) == 0 );
+	GIN_CHECK( !manager.HasSoundRecords( getSound( bufferIds, 0 ) ) );
+
+	// The source states are queried by a single call per update.
+	GIN_CHECK( backend.BatchedStateQueryCount == 3 );
+	GIN_CHECK( backend.StateQueryCount == 0 );
+}
+
+GIN_TEST( AlContextManagerVirtualizesQuietVoices )
+{
+	CAlContextManager manager;
+	auto& backend = initializeFakeBackend( manager );
+	CArray<unsigned> bufferIds;
+	createSounds( backend, sourcePoolSize + 2, 2.0f, bufferIds );
+	for( int i = 0; i < sourcePoolSize; i++ ) {
+		playSound( manager, getSound( bufferIds, i ), 2.0f );
+	}
+	advance( manager, backend, 0.3f );
+
+	// A louder voice takes the source of the first quieter voice, which becomes virtual.
+	const int loudVoice = sourcePoolSize;
+	const int quietVoice = sourcePoolSize + 1;
+	playSound( manager, getSound( bufferIds, loudVoice ), 1.0f );
+	GIN_CHECK( isPlaying( backend, bufferIds[loudVoice] ) );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[0] ) == 0 );
+	GIN_CHECK( manager.GetVoiceState( 0 ) == CAudioRecord::RS_Playing );
+	GIN_CHECK( manager.GetVoiceCount() == sourcePoolSize + 1 && manager.GetVirtualVoiceCount() == 1 );
+	// A quieter voice doesn't get a source.
+	playSound( manager, getSound( bufferIds, quietVoice ), 4.0f );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[quietVoice] ) == 0 );
+	GIN_CHECK( manager.GetVirtualVoiceCount() == 2 );
+
+	// The released source goes to the loudest virtual voice, which resumes from its tracked position.
+	manager.StopVoice( loudVoice );
+	advance( manager, backend, 0.25f );
+	GIN_CHECK( isPlaying( backend, bufferIds[0] ) );
+	GIN_CHECK( fabsf( getSourceOffset( backend, bufferIds[0] ) - 0.55f ) < 1e-5f );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[quietVoice] ) == 0 );
+	GIN_CHECK( manager.GetVirtualVoiceCount() == 1 );
+
+	// Virtual voices end with their sounds.
+	advance( manager, backend, 2.0f );
+	GIN_CHECK( manager.GetVoiceCount() == 0 );
+	GIN_CHECK( manager.GetVoiceState( quietVoice ) == CAudioRecord::RS_Stopped );
+}
+
+GIN_TEST( AlContextManagerKeepsHighPriorityVoices )
+{
+	CAlContextManager manager;
+	auto& backend = initializeFakeBackend( manager );
+	CArray<unsigned> bufferIds;
+	createSounds( backend, sourcePoolSize + 2, 1.0f, bufferIds );
+	for( int i = 0; i < sourcePoolSize; i++ ) {
+		playSound( manager, getSound( bufferIds, i ), 10.0f, SP_HighPriority );
+	}
+
+	// Low priority voices never take the sources of high priority voices.
+	const int lowPriorityVoice = sourcePoolSize;
+	playSound( manager, getSound( bufferIds, lowPriorityVoice ), 0.5f );
+	advance( manager, backend, 0.1f );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[lowPriorityVoice] ) == 0 );
+	GIN_CHECK( manager.GetVirtualVoiceCount() == 1 );
+
+	// Louder high priority voices do.
+	const int highPriorityVoice = sourcePoolSize + 1;
+	playSound( manager, getSound( bufferIds, highPriorityVoice ), 5.0f, SP_HighPriority );
+	GIN_CHECK( isPlaying( backend, bufferIds[highPriorityVoice] ) );
+	GIN_CHECK( manager.GetVirtualVoiceCount() == 2 );
+}
+
+GIN_TEST( AlContextManagerKeepsSourcesOfSimilarVoices )
+{
+	CAlContextManager manager;
+	auto& backend = initializeFakeBackend( manager );
+	CArray<unsigned> bufferIds;
+	createSounds( backend, sourcePoolSize + 1, 2.0f, bufferIds );
+	for( int i = 0; i < sourcePoolSize; i++ ) {
+		playSound( manager, getSound( bufferIds, i ), 2.0f );
+	}
+
+	// A slightly louder voice doesn't take a source from the playing voices.
+	const int newVoice = sourcePoolSize;
+	playSound( manager, getSound( bufferIds, newVoice ), 1.9f );
+	advance( manager, backend, 0.1f );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[newVoice] ) == 0 );
+
+	// The scores are updated every frame.
+	manager.SetVoiceGain( 3, 0.5f );
+	advance( manager, backend, 0.1f );
+	GIN_CHECK( isPlaying( backend, bufferIds[newVoice] ) );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[3] ) == 0 );
+	GIN_CHECK( manager.GetVoiceState( 3 ) == CAudioRecord::RS_Playing );
+	GIN_CHECK( manager.GetVirtualVoiceCount() == 1 );
+}
+
+GIN_TEST( AlContextManagerAdvancesVirtualVoices )
+{
+	CAlContextManager manager;
+	auto& backend = initializeFakeBackend( manager );
+	CArray<unsigned> bufferIds;
+	createSounds( backend, sourcePoolSize + 2, 1.0f, bufferIds );
+	for( int i = 0; i < sourcePoolSize; i++ ) {
+		playSound( manager, getSound( bufferIds, i ), 1.0f );
+	}
+	const int loopingVoice = sourcePoolSize;
+	const int pausedVoice = sourcePoolSize + 1;
+	playSound( manager, getSound( bufferIds, loopingVoice ), 4.0f, SP_LowPriority, true );
+	playSound( manager, getSound( bufferIds, pausedVoice ), 4.0f );
+	advance( manager, backend, 0.7f );
+
+	// Looping virtual voices wrap around, paused ones keep the position.
+	// The voices get sources when the other voices end.
+	manager.PauseVoice( pausedVoice );
+	advance( manager, backend, 0.7f );
+	GIN_CHECK( manager.GetVoiceCount() == 2 );
+	GIN_CHECK( isPlaying( backend, bufferIds[loopingVoice] ) );
+	GIN_CHECK( backend.GetSource( backend.FindBufferSource( bufferIds[loopingVoice] ) ).IsLooping );
+	GIN_CHECK( fabsf( getSourceOffset( backend, bufferIds[loopingVoice] ) - 0.4f ) < 1e-5f );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[pausedVoice] ) == 0 );
+	GIN_CHECK( manager.GetVoiceState( pausedVoice ) == CAudioRecord::RS_Paused );
+
+	manager.PlayVoice( pausedVoice );
+	GIN_CHECK( isPlaying( backend, bufferIds[pausedVoice] ) );
+	GIN_CHECK( fabsf( getSourceOffset( backend, bufferIds[pausedVoice] ) - 0.7f ) < 1e-5f );
+	manager.RewindVoice( pausedVoice );
+	GIN_CHECK( manager.GetVoiceState( pausedVoice ) == CAudioRecord::RS_Initial );
+	GIN_CHECK( backend.GetSource( backend.FindBufferSource( bufferIds[pausedVoice] ) ).State == CAudioRecord::RS_Initial );
+
+	manager.StopAllRecords();
+	GIN_CHECK( manager.GetVoiceCount() == 0 );
+	GIN_CHECK( backend.FindBufferSource( bufferIds[loopingVoice] ) == 0 && backend.FindBufferSource( bufferIds[pausedVoice] ) == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+#endif
@@ -0,0 +1,246 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <BlockCompressor.h>
+#include <BlockDecoder.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const TBlockCompressionQuality compressionQualities[] = { BCQ_Fast, BCQ_Normal, BCQ_High };
+
+static void setPixel( int r, int g, int b, int a, BYTE* pixel )
+{
+	pixel[0] = static_cast<BYTE>( r );
+	pixel[1] = static_cast<BYTE>( g );
+	pixel[2] = static_cast<BYTE>( b );
+	pixel[3] = static_cast<BYTE>( a );
+}
+
+static void fillSolidBlock( int r, int g, int b, int a, BYTE* rgbaPixels )
+{
+	for( int i = 0; i < 16; i++ ) {
+		setPixel( r, g, b, a, rgbaPixels + i * 4 );
+	}
+}
+
+// Largest difference between the channels of two pixel arrays. Only the given number of channels is compared in each pixel.
+static int getMaxError( const BYTE* pixels, const BYTE* decodedPixels, int pixelCount, int channelCount )
+{
+	int result = 0;
+	for( int i = 0; i < pixelCount; i++ ) {
+		for( int c = 0; c < channelCount; c++ ) {
+			result = max( result, abs( pixels[i * 4 + c] - decodedPixels[i * 4 + c] ) );
+		}
+	}
+	return result;
+}
+
+static int getSquaredError( const BYTE* pixels, const BYTE* decodedPixels )
+{
+	int result = 0;
+	for( int i = 0; i < 16; i++ ) {
+		for( int c = 0; c < 3; c++ ) {
+			const int difference = pixels[i * 4 + c] - decodedPixels[i * 4 + c];
+			result += difference * difference;
+		}
+	}
+	return result;
+}
+
+// Fill a block with pseudo random colors around a random line in the color space.
+static void fillRandomBlock( unsigned& seed, BYTE* rgbaPixels )
+{
+	int first[3];
+	int second[3];
+	for( int c = 0; c < 3; c++ ) {
+		seed = seed * 1664525 + 1013904223;
+		first[c] = seed >> 24;
+		seed = seed * 1664525 + 1013904223;
+		second[c] = seed >> 24;
+	}
+	for( int i = 0; i < 16; i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		const int position = ( seed >> 24 ) % 16;
+		for( int c = 0; c < 3; c++ ) {
+			seed = seed * 1664525 + 1013904223;
+			const int noise = static_cast<int>( ( seed >> 24 ) % 17 ) - 8;
+			const int value = ( first[c] * ( 15 - position ) + second[c] * position ) / 15 + noise;
+			rgbaPixels[i * 4 + c] = static_cast<BYTE>( min( max( value, 0 ), 255 ) );
+		}
+		rgbaPixels[i * 4 + 3] = 255;
+	}
+}
+
+GIN_TEST( BlockCompressorKeepsSolidBlocks )
+{
+	CBlockCompressor compressor;
+	BYTE pixels[64];
+	BYTE block[8];
+	BYTE decodedPixels[64];
+	for( auto quality : compressionQualities ) {
+		compressor.SetQuality( quality );
+		// Colors representable in 5:6:5 are restored exactly, others are within the quantization error.
+		fillSolidBlock( 255, 0, 255, 255, pixels );
+		compressor.CompressColorBlock( pixels, block );
+		CBlockDecoder::DecodeBlock( TCT_Dxt1_RGB, block, decodedPixels );
+		GIN_CHECK( getMaxError( pixels, decodedPixels, 16, 4 ) == 0 );
+
+		fillSolidBlock( 100, 150, 200, 255, pixels );
+		compressor.CompressColorBlock( pixels, block );
+		CBlockDecoder::DecodeBlock( TCT_Dxt1_RGB, block, decodedPixels );
+		GIN_CHECK( getMaxError( pixels, decodedPixels, 16, 4 ) <= 4 );
+
+		// Single channel blocks have 8-bit endpoints.
+		fillSolidBlock( 77, 0, 0, 255, pixels );
+		compressor.CompressChannelBlock( pixels, 4, block );
+		CBlockDecoder::DecodeBlock( TCT_Bc4, block, decodedPixels );
+		GIN_CHECK( getMaxError( pixels, decodedPixels, 16, 4 ) == 0 );
+	}
+}
+
+GIN_TEST( BlockCompressorKeepsTwoColorBlocks )
+{
+	CBlockCompressor compressor;
+	BYTE pixels[64];
+	for( int i = 0; i < 16; i++ ) {
+		const int value = ( i + i / 4 ) % 2 == 0 ? 255 : 0;
+		setPixel( value, value, value, 255 - value, pixels + i * 4 );
+	}
+	BYTE colorBlock[8];
+	BYTE alphaBlock[8];
+	BYTE decodedPixels[64];
+	for( auto quality : compressionQualities ) {
+		compressor.SetQuality( quality );
+		compressor.CompressColorBlock( pixels, colorBlock );
+		CBlockDecoder::DecodeBlock( TCT_Dxt1_RGB, colorBlock, decodedPixels );
+		// The fast tier insets the endpoints by a sixteenth of the range.
+		GIN_CHECK( getMaxError( pixels, decodedPixels, 16, 3 ) <= ( quality == BCQ_Fast ? 16 : 0 ) );
+
+		compressor.CompressChannelBlock( pixels + 3, 4, alphaBlock );
+		CBlockDecoder::DecodeBlock( TCT_Bc4, alphaBlock, decodedPixels );
+		for( int i = 0; i < 16; i++ ) {
+			GIN_CHECK( decodedPixels[i * 4] == pixels[i * 4 + 3] );
+		}
+	}
+}
+
+GIN_TEST( BlockCompressorRefinesWithQuality )
+{
+	// Higher tiers start from the result of the lower ones and keep only the improvements.
+	CBlockCompressor compressor;
+	unsigned seed = 1;
+	int totalErrors[3] = {};
+	int worseBlockCount = 0;
+	for( int blockPos = 0; blockPos < 200; blockPos++ ) {
+		BYTE pixels[64];
+		fillRandomBlock( seed, pixels );
+		int previousError = INT_MAX;
+		for( int i = 0; i < 3; i++ ) {
+			compressor.SetQuality( compressionQualities[i] );
+			BYTE block[8];
+			BYTE decodedPixels[64];
+			compressor.CompressColorBlock( pixels, block );
+			CBlockDecoder::DecodeBlock( TCT_Dxt1_RGB, block, decodedPixels );
+			const int error = getSquaredError( pixels, decodedPixels );
+			if( error > previousError ) {
+				worseBlockCount++;
+			}
+			previousError = error;
+			totalErrors[i] += error;
+		}
+	}
+	GIN_CHECK( worseBlockCount == 0 );
+	GIN_CHECK( totalErrors[1] < totalErrors[0] );
+	GIN_CHECK( totalErrors[2] <= totalErrors[1] );
+}
+
+GIN_TEST( BlockCompressorInterpolatesChannelGradients )
+{
+	CBlockCompressor compressor;
+	BYTE pixels[64];
+	for( int i = 0; i < 16; i++ ) {
+		setPixel( 0, 0, 0, 40 + i * 9, pixels + i * 4 );
+	}
+	BYTE block[8];
+	BYTE decodedPixels[64];
+	for( auto quality : compressionQualities ) {
+		compressor.SetQuality( quality );
+		compressor.CompressChannelBlock( pixels + 3, 4, block );
+		CBlockDecoder::DecodeBlock( TCT_Bc4, block, decodedPixels );
+		int maxError = 0;
+		for( int i = 0; i < 16; i++ ) {
+			maxError = max( maxError, abs( decodedPixels[i * 4] - pixels[i * 4 + 3] ) );
+		}
+		// The range of 135 is split into seven steps.
+		GIN_CHECK( maxError <= 10 );
+	}
+}
+
+GIN_TEST( BlockCompressorCompressesImages )
+{
+	// The 6x6 image with two levels covers edge blocks and small mipmaps.
+	const int width = 6;
+	const int height = 6;
+	CImageData image( TT_Texture2D, width, height, 1, TF_RGBA, TDT_UnsignedByte, 2, 1 );
+	for( int level = 0; level < 2; level++ ) {
+		auto& levelData = image.GetMipmapData( level );
+		for( int i = 0; i < levelData.Size(); i += 4 ) {
+			const int pos = i / 4;
+			levelData[i] = static_cast<BYTE>( pos * 7 );
+			levelData[i + 1] = static_cast<BYTE>( 255 - pos * 5 );
+			levelData[i + 2] = static_cast<BYTE>( 64 + level * 64 );
+			levelData[i + 3] = static_cast<BYTE>( pos % 2 == 0 ? 255 : 128 );
+		}
+	}
+
+	CBlockCompressor compressor;
+	compressor.SetWorkerCount( 2 );
+	CBlockDecoder decoder;
+	const TTextureCompressionType types[] = { TCT_Dxt1_RGB, TCT_Dxt5, TCT_Bc4, TCT_Bc5 };
+	const int channelCounts[] = { 3, 4, 1, 2 };
+	// Color gradients are limited by the 5:6:5 endpoints, single channels have 8-bit endpoints.
+	const int maxErrors[] = { 16, 16, 10, 10 };
+	for( int i = 0; i < 4; i++ ) {
+		GIN_CHECK( CBlockCompressor::IsCompressionSupported( types[i] ) );
+		const auto compressed = compressor.Compress( image, types[i] );
+		GIN_CHECK( compressed.GetCompressionType() == types[i] );
+		GIN_CHECK( compressed.GetMipmapCount() == 2 );
+		const auto decoded = decoder.Decode( compressed );
+		for( int level = 0; level < 2; level++ ) {
+			const int pixelCount = image.GetImageDataSize( level ) / 4;
+			GIN_CHECK( getMaxError( image.GetImageData( level ), decoded.GetImageData( level ), pixelCount, channelCounts[i] ) <= maxErrors[i] );
+		}
+	}
+	GIN_CHECK( !CBlockCompressor::IsCompressionSupported( TCT_Dxt3 ) );
+}
+
+GIN_TEST( BlockCompressorReadsMissingChannels )
+{
+	// Red and green images are compressed with zero blue and opaque alpha.
+	CImageData image( TT_Texture2D, 4, 4, 1, TF_RG, TDT_UnsignedByte, 1, 1 );
+	auto& pixels = image.GetMipmapData( 0 );
+	for( int i = 0; i < 16; i++ ) {
+		pixels[i * 2] = 200;
+		pixels[i * 2 + 1] = 30;
+	}
+	CBlockCompressor compressor;
+	const auto compressed = compressor.Compress( image, TCT_Dxt5 );
+	BYTE decodedPixels[64];
+	CBlockDecoder::DecodeBlock( TCT_Dxt5, compressed.GetImageData( 0 ), decodedPixels );
+	for( int i = 0; i < 16; i++ ) {
+		GIN_CHECK( abs( decodedPixels[i * 4] - 200 ) <= 4 && abs( decodedPixels[i * 4 + 1] - 30 ) <= 2 );
+		GIN_CHECK( decodedPixels[i * 4 + 2] == 0 && decodedPixels[i * 4 + 3] == 255 );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
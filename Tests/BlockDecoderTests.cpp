@@ -0,0 +1,179 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <BlockDecoder.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Write a DXT1 color block with the given 5:6:5 endpoints and rows of 2-bit indices.
+static void writeColorBlock( int first, int second, const BYTE* indexRows, BYTE* result )
+{
+	result[0] = static_cast<BYTE>( first );
+	result[1] = static_cast<BYTE>( first >> 8 );
+	result[2] = static_cast<BYTE>( second );
+	result[3] = static_cast<BYTE>( second >> 8 );
+	memcpy( result + 4, indexRows, 4 );
+}
+
+// Write a BC4 block with the given endpoints and 3-bit indices of the 16 pixels.
+static void writeChannelBlock( int first, int second, const int* indices, BYTE* result )
+{
+	result[0] = static_cast<BYTE>( first );
+	result[1] = static_cast<BYTE>( second );
+	unsigned __int64 packedIndices = 0;
+	for( int i = 0; i < 16; i++ ) {
+		packedIndices |= static_cast<unsigned __int64>( indices[i] ) << ( 3 * i );
+	}
+	for( int i = 0; i < 6; i++ ) {
+		result[2 + i] = static_cast<BYTE>( packedIndices >> ( 8 * i ) );
+	}
+}
+
+static bool hasPixel( const BYTE* rgbaPixels, int pos, int r, int g, int b, int a )
+{
+	const BYTE* pixel = rgbaPixels + pos * 4;
+	return pixel[0] == r && pixel[1] == g && pixel[2] == b && pixel[3] == a;
+}
+
+// Indices of the pixels of a channel block: pixel i uses index i % 8.
+static const int cyclicChannelIndices[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+GIN_TEST( BlockDecoderDecodesFourColorBlocks )
+{
+	// Pure red and pure blue endpoints. The first row uses every index, the other rows use a single index.
+	const BYTE indexRows[] = { 0xE4, 0x00, 0x55, 0xFF };
+	BYTE block[8];
+	writeColorBlock( 0xF800, 0x001F, indexRows, block );
+	BYTE pixels[64];
+	CBlockDecoder::DecodeBlock( TCT_Dxt1_RGB, block, pixels );
+	GIN_CHECK( hasPixel( pixels, 0, 255, 0, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 1, 0, 0, 255, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 2, 170, 0, 85, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 3, 85, 0, 170, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 7, 255, 0, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 11, 0, 0, 255, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 15, 85, 0, 170, 255 ) );
+
+	// Endpoints are expanded by replicating the high bits.
+	writeColorBlock( 0x8410, 0x0000, indexRows, block );
+	CBlockDecoder::DecodeBlock( TCT_Dxt1_sRGB, block, pixels );
+	GIN_CHECK( hasPixel( pixels, 0, 132, 130, 132, 255 ) );
+}
+
+GIN_TEST( BlockDecoderDecodesThreeColorBlocks )
+{
+	// The first endpoint is not greater than the second one: the third color is the average and the fourth is black.
+	const BYTE indexRows[] = { 0xE4, 0xE4, 0xE4, 0xE4 };
+	BYTE block[8];
+	writeColorBlock( 0x001F, 0xF800, indexRows, block );
+	BYTE pixels[64];
+	CBlockDecoder::DecodeBlock( TCT_Dxt1_RGB, block, pixels );
+	GIN_CHECK( hasPixel( pixels, 0, 0, 0, 255, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 1, 255, 0, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 2, 127, 0, 127, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 3, 0, 0, 0, 255 ) );
+
+	// Color blocks of DXT3 and DXT5 always use four colors.
+	BYTE dxt5Block[16] = {};
+	writeColorBlock( 0x001F, 0xF800, indexRows, dxt5Block + 8 );
+	CBlockDecoder::DecodeBlock( TCT_Dxt5, dxt5Block, pixels );
+	GIN_CHECK( hasPixel( pixels, 2, 85, 0, 170, 0 ) );
+	GIN_CHECK( hasPixel( pixels, 3, 170, 0, 85, 0 ) );
+}
+
+GIN_TEST( BlockDecoderDecodesAlphaBlocks )
+{
+	const BYTE indexRows[] = { 0, 0, 0, 0 };
+	BYTE pixels[64];
+
+	// DXT3 stores 4-bit alpha values.
+	BYTE dxt3Block[16];
+	for( int i = 0; i < 8; i++ ) {
+		dxt3Block[i] = static_cast<BYTE>( ( 2 * i ) | ( ( 2 * i + 1 ) << 4 ) );
+	}
+	writeColorBlock( 0xFFFF, 0x0000, indexRows, dxt3Block + 8 );
+	CBlockDecoder::DecodeBlock( TCT_Dxt3, dxt3Block, pixels );
+	GIN_CHECK( hasPixel( pixels, 0, 255, 255, 255, 0 ) );
+	GIN_CHECK( hasPixel( pixels, 1, 255, 255, 255, 17 ) );
+	GIN_CHECK( hasPixel( pixels, 10, 255, 255, 255, 170 ) );
+	GIN_CHECK( hasPixel( pixels, 15, 255, 255, 255, 255 ) );
+
+	// DXT5 with the first endpoint greater than the second interpolates six values.
+	BYTE dxt5Block[16];
+	writeChannelBlock( 255, 0, cyclicChannelIndices, dxt5Block );
+	writeColorBlock( 0xFFFF, 0x0000, indexRows, dxt5Block + 8 );
+	CBlockDecoder::DecodeBlock( TCT_Dxt5_sRGBA, dxt5Block, pixels );
+	const int expectedAlpha[8] = { 255, 0, 218, 182, 145, 109, 72, 36 };
+	for( int i = 0; i < 16; i++ ) {
+		GIN_CHECK( hasPixel( pixels, i, 255, 255, 255, expectedAlpha[i % 8] ) );
+	}
+}
+
+GIN_TEST( BlockDecoderDecodesChannelBlocks )
+{
+	BYTE pixels[64];
+	// The first endpoint is not greater than the second: four interpolated values, then 0 and 255.
+	BYTE bc4Block[8];
+	writeChannelBlock( 0, 100, cyclicChannelIndices, bc4Block );
+	CBlockDecoder::DecodeBlock( TCT_Bc4, bc4Block, pixels );
+	const int expectedRed[8] = { 0, 100, 20, 40, 60, 80, 0, 255 };
+	for( int i = 0; i < 16; i++ ) {
+		GIN_CHECK( hasPixel( pixels, i, expectedRed[i % 8], 0, 0, 255 ) );
+	}
+
+	// The second block of BC5 is the green channel.
+	BYTE bc5Block[16];
+	const int redIndices[16] = {};
+	writeChannelBlock( 70, 7, redIndices, bc5Block );
+	writeChannelBlock( 200, 60, cyclicChannelIndices, bc5Block + 8 );
+	CBlockDecoder::DecodeBlock( TCT_Bc5, bc5Block, pixels );
+	const int expectedGreen[8] = { 200, 60, 180, 160, 140, 120, 100, 80 };
+	for( int i = 0; i < 16; i++ ) {
+		GIN_CHECK( hasPixel( pixels, i, 70, expectedGreen[i % 8], 0, 255 ) );
+	}
+}
+
+GIN_TEST( BlockDecoderClipsEdgeBlocks )
+{
+	// A 6x5 image has two columns and two rows of blocks. Each block is a solid color.
+	const int width = 6;
+	const int height = 5;
+	CImageData image( TT_Texture2D, width, height, 1, TCT_Dxt1_RGB, 1, 1 );
+	const int blockColors[4] = { 0xF800, 0x07E0, 0x001F, 0xFFFF };
+	const BYTE indexRows[] = { 0, 0, 0, 0 };
+	auto& blocks = image.GetMipmapData( 0 );
+	GIN_CHECK( blocks.Size() == 4 * 8 );
+	for( int i = 0; i < 4; i++ ) {
+		writeColorBlock( blockColors[i], 0, indexRows, blocks.Ptr() + i * 8 );
+	}
+
+	CBlockDecoder decoder;
+	decoder.SetWorkerCount( 2 );
+	const auto result = decoder.Decode( image );
+	GIN_CHECK( result.GetCompressionType() == TCT_Uncompressed );
+	GIN_CHECK( result.GetTexelFormat() == TF_RGBA );
+	const BYTE* pixels = result.GetImageData( 0 );
+	GIN_CHECK( hasPixel( pixels, 0, 255, 0, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 3 * width + 3, 255, 0, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 4, 0, 255, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 3 * width + 5, 0, 255, 0, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 4 * width, 0, 0, 255, 255 ) );
+	GIN_CHECK( hasPixel( pixels, 4 * width + 5, 255, 255, 255, 255 ) );
+
+	CArray<BYTE> imagePixels;
+	imagePixels.IncreaseSize( width * height * 4 );
+	decoder.DecodeImage( image, 0, 0, 0, imagePixels.Ptr() );
+	GIN_CHECK( memcmp( imagePixels.Ptr(), pixels, width * height * 4 ) == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
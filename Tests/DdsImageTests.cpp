@@ -0,0 +1,185 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <DdsImage.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// The test files are written to the working directory and overwritten by each test.
+static const char* testFileName = "DdsImageTest.dds";
+
+// Fill the images with a pattern that differs between the rows, images and levels.
+static void fillImages( CImageData& data )
+{
+	for( int level = 0; level < data.GetMipmapCount(); level++ ) {
+		auto& levelData = data.GetMipmapData( level );
+		for( int i = 0; i < levelData.Size(); i++ ) {
+			levelData[i] = static_cast<BYTE>( i * 7 + level * 31 + 1 );
+		}
+	}
+}
+
+static bool hasSameLayout( const CImageData& first, const CImageData& second )
+{
+	return first.GetType() == second.GetType() && first.Width() == second.Width() && first.Height() == second.Height()
+		&& first.GetCompressionType() == second.GetCompressionType() && first.GetTexelFormat() == second.GetTexelFormat()
+		&& first.GetTexelDataType() == second.GetTexelDataType() && first.GetMipmapCount() == second.GetMipmapCount()
+		&& first.GetArrayCount() == second.GetArrayCount();
+}
+
+// Write the image to the test file and compare the mapped images with the images of the copying loader.
+// The copying loader flips the images by default, the mapped images give the same result when they are copied with a flip.
+static bool checkMappedImages( const CImageData& source )
+{
+	CDdsImage image( testFileName );
+	image.WriteImageData( source );
+	const CImageData copied = image.CreateImageData( false );
+	const CImageData flipped = image.CreateImageData();
+	const CImageData mapped = image.CreateMappedImageData();
+	if( !mapped.IsMapped() || copied.IsMapped() || !hasSameLayout( mapped, source ) || !hasSameLayout( copied, source ) ) {
+		return false;
+	}
+
+	CArray<BYTE> flippedImage;
+	for( int level = 0; level < source.GetMipmapCount(); level++ ) {
+		const int imageSize = source.GetImageDataSize( level );
+		if( mapped.GetImageDataSize( level ) != imageSize ) {
+			return false;
+		}
+		for( int arrayIndex = 0; arrayIndex < source.GetArrayCount(); arrayIndex++ ) {
+			for( int cubeFace = 0; cubeFace < source.GetCubeFaceCount(); cubeFace++ ) {
+				const BYTE* mappedImage = mapped.GetImageData( level, arrayIndex, cubeFace );
+				if( memcmp( mappedImage, source.GetImageData( level, arrayIndex, cubeFace ), imageSize ) != 0
+					|| memcmp( mappedImage, copied.GetImageData( level, arrayIndex, cubeFace ), imageSize ) != 0 )
+				{
+					return false;
+				}
+				flippedImage.Empty();
+				flippedImage.IncreaseSizeNoInitialize( imageSize );
+				mapped.CopyImageData( level, arrayIndex, cubeFace, flippedImage.Ptr(), true );
+				if( memcmp( flippedImage.Ptr(), flipped.GetImageData( level, arrayIndex, cubeFace ), imageSize ) != 0 ) {
+					return false;
+				}
+			}
+		}
+		// Whole levels are uploaded from the same memory as the images.
+		const CArrayView<BYTE> mappedLevel = mapped.GetMipmapData( level );
+		const CArrayView<BYTE> copiedLevel = copied.GetMipmapData( level );
+		if( mappedLevel.Size() != copiedLevel.Size() || memcmp( mappedLevel.Ptr(), copiedLevel.Ptr(), copiedLevel.Size() ) != 0 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+GIN_TEST( DdsImageMapsUncompressedImages )
+{
+	CImageData rgbaImage( TT_Texture2D, 12, 8, 1, TF_RGBA, TDT_UnsignedByte, 4, 1 );
+	fillImages( rgbaImage );
+	GIN_CHECK( checkMappedImages( rgbaImage ) );
+
+	CImageData redImage( TT_Texture2D, 7, 5, 1, TF_Red, TDT_UnsignedByte, 3, 1 );
+	fillImages( redImage );
+	GIN_CHECK( checkMappedImages( redImage ) );
+
+	// Images of a single level are adjacent in the file.
+	CImageData arrayImage( TT_Texture2D, 4, 4, 1, TF_BGRA, TDT_UnsignedByte, 1, 3 );
+	fillImages( arrayImage );
+	GIN_CHECK( checkMappedImages( arrayImage ) );
+
+	CImageData cubeImage( TT_TextureCubeMap, 4, 4, 1, TF_RGBA, TDT_UnsignedByte, 1, 1 );
+	fillImages( cubeImage );
+	GIN_CHECK( checkMappedImages( cubeImage ) );
+}
+
+GIN_TEST( DdsImageMapsCompressedImages )
+{
+	// Blocks are flipped along with the block rows.
+	CImageData dxt1Image( TT_Texture2D, 16, 8, 1, TCT_Dxt1_RGB, 4, 1 );
+	fillImages( dxt1Image );
+	GIN_CHECK( checkMappedImages( dxt1Image ) );
+
+	CImageData dxt5Image( TT_Texture2D, 8, 12, 1, TCT_Dxt5, 2, 1 );
+	fillImages( dxt5Image );
+	GIN_CHECK( checkMappedImages( dxt5Image ) );
+
+	CImageData bc5Image( TT_Texture2D, 8, 8, 1, TCT_Bc5, 1, 2 );
+	fillImages( bc5Image );
+	GIN_CHECK( checkMappedImages( bc5Image ) );
+}
+
+// Check that the mapped loader rejects the test file and the copying loader accepts it.
+static bool isMappingRejected()
+{
+	CDdsImage image( testFileName );
+	const CImageData copied = image.CreateImageData();
+	try {
+		image.CreateMappedImageData();
+	} catch( CCheckException& ) {
+		return true;
+	}
+	return false;
+}
+
+GIN_TEST( DdsImageRejectsNonContiguousLevels )
+{
+	CImageData arrayImage( TT_Texture2D, 8, 8, 1, TF_RGBA, TDT_UnsignedByte, 2, 2 );
+	fillImages( arrayImage );
+	CDdsImage( testFileName ).WriteImageData( arrayImage );
+	GIN_CHECK( isMappingRejected() );
+
+	CImageData cubeImage( TT_TextureCubeMap, 8, 8, 1, TCT_Dxt1_RGB, 2, 1 );
+	fillImages( cubeImage );
+	CDdsImage( testFileName ).WriteImageData( cubeImage );
+	GIN_CHECK( isMappingRejected() );
+}
+
+// Check that both loaders reject the test file.
+static bool isTruncationRejected()
+{
+	CDdsImage image( testFileName );
+	int rejectedCount = 0;
+	try {
+		image.CreateImageData();
+	} catch( CCheckException& ) {
+		rejectedCount++;
+	}
+	try {
+		image.CreateMappedImageData();
+	} catch( CCheckException& ) {
+		rejectedCount++;
+	}
+	return rejectedCount == 2;
+}
+
+GIN_TEST( DdsImageRejectsTruncatedFiles )
+{
+	CImageData source( TT_Texture2D, 8, 8, 1, TF_RGBA, TDT_UnsignedByte, 3, 1 );
+	fillImages( source );
+	CDdsImage( testFileName ).WriteImageData( source );
+
+	CArray<BYTE> fileData;
+	{
+		CFileReader file( testFileName, FCM_OpenExisting );
+		fileData.IncreaseSizeNoInitialize( file.GetLength32() );
+		file.Read( fileData.Ptr(), fileData.Size() );
+	}
+	{
+		// The last byte of the smallest level is missing.
+		CFileWriter file( testFileName, FCM_CreateAlways );
+		file.Write( fileData.Ptr(), fileData.Size() - 1 );
+	}
+	GIN_CHECK( isTruncationRejected() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
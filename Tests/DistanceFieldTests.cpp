@@ -0,0 +1,211 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <DistanceField.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Squared distance of the pixels that have no shape in the field.
+static const float infiniteDistance = 1e20f;
+
+// Field value of a pixel at the given signed distance from the outline. Positive distances are inside the shape.
+static BYTE getFieldValue( float distance, int spread )
+{
+	const auto value = 127.5f + distance * ( 127.5f / spread );
+	return static_cast<BYTE>( min( 255.0f, max( 0.0f, value + 0.5f ) ) );
+}
+
+static void generateField( const CArray<BYTE>& bitmap, CVector2<int> bitmapSize, int pitch, int spread, CArray<BYTE>& field )
+{
+	const auto fieldSize = CDistanceFieldGenerator::GetFieldSize( bitmapSize, spread );
+	field.Empty();
+	field.IncreaseSize( fieldSize.X() * fieldSize.Y() );
+	CDistanceFieldGenerator generator;
+	generator.Generate( bitmap.Ptr(), bitmapSize, pitch, spread, field );
+}
+
+// Squared distances of the sampled grid: the minimum of the sample plus the squared distance to the sample over all the samples.
+static void transformBruteForce( const CArray<float>& samples, CVector2<int> size, CArray<float>& result )
+{
+	result.Empty();
+	result.IncreaseSize( samples.Size() );
+	for( int y = 0; y < size.Y(); y++ ) {
+		for( int x = 0; x < size.X(); x++ ) {
+			float minDistance = 2 * infiniteDistance;
+			for( int sampleY = 0; sampleY < size.Y(); sampleY++ ) {
+				for( int sampleX = 0; sampleX < size.X(); sampleX++ ) {
+					const auto offset = CVector2<int>( x - sampleX, y - sampleY );
+					const auto distance = samples[sampleY * size.X() + sampleX] + static_cast<float>( offset.X() * offset.X() + offset.Y() * offset.Y() );
+					minDistance = min( minDistance, distance );
+				}
+			}
+			result[y * size.X() + x] = minDistance;
+		}
+	}
+}
+
+// Reference field that is computed without the separable transform. Coverage is interpreted in the same way as in the generator.
+static void generateBruteForceField( const CArray<BYTE>& bitmap, CVector2<int> bitmapSize, int pitch, int spread, CArray<BYTE>& field )
+{
+	const auto fieldSize = CDistanceFieldGenerator::GetFieldSize( bitmapSize, spread );
+	const auto fieldArea = fieldSize.X() * fieldSize.Y();
+	CArray<float> outerSamples;
+	outerSamples.IncreaseSize( fieldArea );
+	CArray<float> innerSamples;
+	innerSamples.IncreaseSize( fieldArea );
+	for( int i = 0; i < fieldArea; i++ ) {
+		outerSamples[i] = infiniteDistance;
+	}
+	for( int y = 0; y < bitmapSize.Y(); y++ ) {
+		for( int x = 0; x < bitmapSize.X(); x++ ) {
+			const auto coverage = bitmap[y * pitch + x];
+			const auto pos = ( y + spread ) * fieldSize.X() + x + spread;
+			const auto edgeDistance = 0.5f - coverage / 255.0f;
+			if( coverage == 255 ) {
+				outerSamples[pos] = 0.0f;
+				innerSamples[pos] = infiniteDistance;
+			} else if( coverage > 0 ) {
+				outerSamples[pos] = edgeDistance > 0 ? edgeDistance * edgeDistance : 0.0f;
+				innerSamples[pos] = edgeDistance < 0 ? edgeDistance * edgeDistance : 0.0f;
+			}
+		}
+	}
+
+	CArray<float> outerGrid;
+	transformBruteForce( outerSamples, fieldSize, outerGrid );
+	CArray<float> innerGrid;
+	transformBruteForce( innerSamples, fieldSize, innerGrid );
+	field.Empty();
+	field.IncreaseSize( fieldArea );
+	for( int i = 0; i < fieldArea; i++ ) {
+		field[i] = getFieldValue( sqrtf( innerGrid[i] ) - sqrtf( outerGrid[i] ), spread );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+GIN_TEST( DistanceFieldMeasuresSinglePixel )
+{
+	const int spread = 4;
+	CArray<BYTE> bitmap;
+	bitmap.Add( 255 );
+	CArray<BYTE> field;
+	generateField( bitmap, CVector2<int>( 1, 1 ), 1, spread, field );
+	const int fieldWidth = 2 * spread + 1;
+	GIN_CHECK( field.Size() == fieldWidth * fieldWidth );
+
+	// The pixel is one pixel away from the border that surrounds it. Other pixels are outside at their distance to the pixel.
+	for( int y = 0; y < fieldWidth; y++ ) {
+		for( int x = 0; x < fieldWidth; x++ ) {
+			const auto offset = CVector2<int>( x - spread, y - spread );
+			const auto isCenter = offset.X() == 0 && offset.Y() == 0;
+			const auto distance = isCenter ? 1.0f : -sqrtf( static_cast<float>( offset.X() * offset.X() + offset.Y() * offset.Y() ) );
+			GIN_CHECK( field[y * fieldWidth + x] == getFieldValue( distance, spread ) );
+		}
+	}
+	GIN_CHECK( field[spread * fieldWidth + spread] > 128 );
+	GIN_CHECK( field[spread * fieldWidth + spread + 1] < 128 );
+	// Corners are farther than the spread.
+	GIN_CHECK( field[0] == 0 );
+}
+
+GIN_TEST( DistanceFieldMeasuresHalfPlane )
+{
+	const int spread = 4;
+	const CVector2<int> bitmapSize( 16, 32 );
+	const int edgeX = 8;
+	CArray<BYTE> bitmap;
+	bitmap.IncreaseSize( bitmapSize.X() * bitmapSize.Y() );
+	for( int y = 0; y < bitmapSize.Y(); y++ ) {
+		for( int x = 0; x < edgeX; x++ ) {
+			bitmap[y * bitmapSize.X() + x] = 255;
+		}
+	}
+	CArray<BYTE> field;
+	generateField( bitmap, bitmapSize, bitmapSize.X(), spread, field );
+
+	// Rows in the middle of the shape are far from the top and bottom borders. Distances near the edge are horizontal.
+	const auto fieldWidth = bitmapSize.X() + 2 * spread;
+	for( int y = 12; y < 20; y++ ) {
+		const BYTE* fieldRow = field.Ptr() + ( y + spread ) * fieldWidth + spread;
+		for( int x = edgeX - 4; x < edgeX; x++ ) {
+			GIN_CHECK( fieldRow[x] == getFieldValue( static_cast<float>( edgeX - x ), spread ) );
+		}
+		for( int x = edgeX; x < bitmapSize.X(); x++ ) {
+			GIN_CHECK( fieldRow[x] == getFieldValue( static_cast<float>( edgeX - 1 - x ), spread ) );
+		}
+	}
+}
+
+GIN_TEST( DistanceFieldSignFollowsCoverage )
+{
+	const int spread = 2;
+	const BYTE coverages[] = { 0, 64, 128, 192, 255 };
+	int prevValue = -1;
+	for( BYTE coverage : coverages ) {
+		CArray<BYTE> bitmap;
+		bitmap.Add( coverage );
+		CArray<BYTE> field;
+		generateField( bitmap, CVector2<int>( 1, 1 ), 1, spread, field );
+		const int value = field[spread * ( 2 * spread + 1 ) + spread];
+		// The outline moves across the pixel as the coverage grows.
+		GIN_CHECK( value > prevValue );
+		GIN_CHECK( coverage < 128 ? value < 128 : value >= 128 );
+		prevValue = value;
+	}
+}
+
+// Compare the fields of random bitmaps with the reference. Binary bitmaps have exact squared distances, partially covered pixels may differ by rounding.
+static bool checkRandomFields( bool hasPartialCoverage, int maxDifference )
+{
+	unsigned seed = hasPartialCoverage ? 11 : 7;
+	for( int i = 0; i < 24; i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		const CVector2<int> bitmapSize( 1 + ( seed >> 8 ) % 13, 1 + ( seed >> 16 ) % 9 );
+		const int spread = 1 + ( seed >> 24 ) % 6;
+		// Rows are padded with garbage that is not a part of the bitmap.
+		const int pitch = bitmapSize.X() + 3;
+		CArray<BYTE> bitmap;
+		bitmap.IncreaseSize( pitch * bitmapSize.Y() );
+		for( int pos = 0; pos < bitmap.Size(); pos++ ) {
+			seed = seed * 1664525 + 1013904223;
+			const auto randomValue = seed >> 24;
+			const bool isPadding = pos % pitch >= bitmapSize.X();
+			if( isPadding ) {
+				bitmap[pos] = 255;
+			} else if( hasPartialCoverage && randomValue % 3 == 0 ) {
+				bitmap[pos] = static_cast<BYTE>( randomValue );
+			} else {
+				bitmap[pos] = randomValue % 2 == 0 ? 255 : 0;
+			}
+		}
+
+		CArray<BYTE> field;
+		generateField( bitmap, bitmapSize, pitch, spread, field );
+		CArray<BYTE> expected;
+		generateBruteForceField( bitmap, bitmapSize, pitch, spread, expected );
+		for( int pos = 0; pos < field.Size(); pos++ ) {
+			if( abs( field[pos] - expected[pos] ) > maxDifference ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+GIN_TEST( DistanceFieldMatchesBruteForce )
+{
+	GIN_CHECK( checkRandomFields( false, 0 ) );
+	GIN_CHECK( checkRandomFields( true, 1 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,226 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <DxtBlockFlip.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+namespace Tests {
+
+using namespace GinInternal;
+
+//////////////////////////////////////////////////////////////////////////
+
+static const TDxtBlockType blockTypes[] = { DBT_Dxt1, DBT_Dxt3, DBT_Dxt5, DBT_Bc4, DBT_Bc5 };
+// Block counts up to this value cover whole registers and the blocks that are left after them.
+static const int maxBlockCount = 9;
+static const int maxBlockSize = 16;
+
+static void fillRandomBytes( unsigned& seed, BYTE* data, int byteCount )
+{
+	for( int i = 0; i < byteCount; i++ ) {
+		seed = seed * 1664525 + 1013904223;
+		data[i] = static_cast<BYTE>( seed >> 24 );
+	}
+}
+
+// Reverse the order of four rows of bits that start from the given bit. Other bits are kept.
+static unsigned __int64 reverseRows( unsigned __int64 bits, int firstBit, int rowBitCount )
+{
+	const unsigned __int64 rowMask = ( 1ULL << rowBitCount ) - 1;
+	unsigned __int64 result = bits;
+	for( int row = 0; row < 4; row++ ) {
+		result &= ~( rowMask << ( firstBit + row * rowBitCount ) );
+	}
+	for( int row = 0; row < 4; row++ ) {
+		const unsigned __int64 rowBits = ( bits >> ( firstBit + row * rowBitCount ) ) & rowMask;
+		result |= rowBits << ( firstBit + ( 3 - row ) * rowBitCount );
+	}
+	return result;
+}
+
+// Flip a block by moving its index rows. Color rows are bytes, explicit alpha rows are 16-bit words and interpolated alpha rows are 12-bit fields after the endpoints.
+static void flipReferenceBlock( TDxtBlockType type, BYTE* dest, const BYTE* src )
+{
+	unsigned __int64 halves[2] = {};
+	memcpy( halves, src, GetDxtBlockSize( type ) );
+	switch( type ) {
+	case DBT_Dxt1:
+		halves[0] = reverseRows( halves[0], 32, 8 );
+		break;
+	case DBT_Dxt3:
+		halves[0] = reverseRows( halves[0], 0, 16 );
+		halves[1] = reverseRows( halves[1], 32, 8 );
+		break;
+	case DBT_Dxt5:
+		halves[0] = reverseRows( halves[0], 16, 12 );
+		halves[1] = reverseRows( halves[1], 32, 8 );
+		break;
+	case DBT_Bc4:
+		halves[0] = reverseRows( halves[0], 16, 12 );
+		break;
+	case DBT_Bc5:
+		halves[0] = reverseRows( halves[0], 16, 12 );
+		halves[1] = reverseRows( halves[1], 16, 12 );
+		break;
+	}
+	memcpy( dest, halves, GetDxtBlockSize( type ) );
+}
+
+static bool checkSingleBlocks( TDxtBlockType type )
+{
+	unsigned seed = 17;
+	const int blockSize = GetDxtBlockSize( type );
+	for( int i = 0; i < 64; i++ ) {
+		BYTE block[maxBlockSize];
+		fillRandomBytes( seed, block, blockSize );
+		BYTE flipped[maxBlockSize];
+		FlipDxtBlock( type, flipped, block );
+		BYTE expected[maxBlockSize];
+		flipReferenceBlock( type, expected, block );
+		if( memcmp( flipped, expected, blockSize ) != 0 ) {
+			return false;
+		}
+		// Flipping twice restores the block.
+		FlipDxtBlock( type, flipped, flipped );
+		if( memcmp( flipped, block, blockSize ) != 0 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+GIN_TEST( DxtBlockFlipReversesBlockRows )
+{
+	for( TDxtBlockType type : blockTypes ) {
+		GIN_CHECK( checkSingleBlocks( type ) );
+	}
+}
+
+// Compare the flips of the ranges with the flips of single blocks.
+static bool checkRangeFlips( TDxtBlockType type, int blockCount )
+{
+	unsigned seed = 31 + blockCount;
+	const int byteCount = blockCount * GetDxtBlockSize( type );
+	BYTE source[maxBlockCount * maxBlockSize];
+	fillRandomBytes( seed, source, byteCount );
+	BYTE expected[maxBlockCount * maxBlockSize];
+	for( int pos = 0; pos < byteCount; pos += GetDxtBlockSize( type ) ) {
+		FlipDxtBlock( type, expected + pos, source + pos );
+	}
+
+	BYTE flipped[maxBlockCount * maxBlockSize];
+	FlipDxtBlocks( type, flipped, source, byteCount );
+	if( memcmp( flipped, expected, byteCount ) != 0 ) {
+		return false;
+	}
+	// In place flip.
+	FlipDxtBlocks( type, source, source, byteCount );
+	return memcmp( source, expected, byteCount ) == 0;
+}
+
+GIN_TEST( DxtBlockFlipRegistersMatchSingleBlocks )
+{
+	for( TDxtBlockType type : blockTypes ) {
+		for( int blockCount = 1; blockCount <= maxBlockCount; blockCount++ ) {
+			GIN_CHECK( checkRangeFlips( type, blockCount ) );
+		}
+	}
+}
+
+static bool checkRangeSwaps( TDxtBlockType type, int blockCount )
+{
+	unsigned seed = 47 + blockCount;
+	const int blockSize = GetDxtBlockSize( type );
+	const int byteCount = blockCount * blockSize;
+	BYTE first[maxBlockCount * maxBlockSize];
+	BYTE second[maxBlockCount * maxBlockSize];
+	fillRandomBytes( seed, first, byteCount );
+	fillRandomBytes( seed, second, byteCount );
+	BYTE expectedFirst[maxBlockCount * maxBlockSize];
+	BYTE expectedSecond[maxBlockCount * maxBlockSize];
+	for( int pos = 0; pos < byteCount; pos += blockSize ) {
+		FlipDxtBlock( type, expectedFirst + pos, second + pos );
+		FlipDxtBlock( type, expectedSecond + pos, first + pos );
+	}
+
+	SwapFlipDxtBlocks( type, first, second, byteCount );
+	if( memcmp( first, expectedFirst, byteCount ) != 0 || memcmp( second, expectedSecond, byteCount ) != 0 ) {
+		return false;
+	}
+	// The middle block row of an image is exchanged with itself.
+	BYTE expectedMiddle[maxBlockCount * maxBlockSize];
+	FlipDxtBlocks( type, expectedMiddle, first, byteCount );
+	SwapFlipDxtBlocks( type, first, first, byteCount );
+	return memcmp( first, expectedMiddle, byteCount ) == 0;
+}
+
+GIN_TEST( DxtBlockFlipSwapsRanges )
+{
+	for( TDxtBlockType type : blockTypes ) {
+		for( int blockCount = 1; blockCount <= maxBlockCount; blockCount++ ) {
+			GIN_CHECK( checkRangeSwaps( type, blockCount ) );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Compare the in place flip of all the images with their flipped copies.
+static bool checkImageFlip( CImageData& data )
+{
+	unsigned seed = 59;
+	for( int level = 0; level < data.GetMipmapCount(); level++ ) {
+		auto& levelData = data.GetMipmapData( level );
+		fillRandomBytes( seed, levelData.Ptr(), levelData.Size() );
+	}
+
+	CArray<BYTE> flippedCopies;
+	for( int level = 0; level < data.GetMipmapCount(); level++ ) {
+		const int imageSize = data.GetImageDataSize( level );
+		for( int arrayIndex = 0; arrayIndex < data.GetArrayCount(); arrayIndex++ ) {
+			const int pos = flippedCopies.Size();
+			flippedCopies.IncreaseSizeNoInitialize( pos + imageSize );
+			data.CopyImageData( level, arrayIndex, 0, flippedCopies.Ptr() + pos, true );
+		}
+	}
+
+	data.FlipVertically();
+	int pos = 0;
+	for( int level = 0; level < data.GetMipmapCount(); level++ ) {
+		const int imageSize = data.GetImageDataSize( level );
+		for( int arrayIndex = 0; arrayIndex < data.GetArrayCount(); arrayIndex++ ) {
+			if( memcmp( data.GetImageData( level, arrayIndex ), flippedCopies.Ptr() + pos, imageSize ) != 0 ) {
+				return false;
+			}
+			pos += imageSize;
+		}
+	}
+	return true;
+}
+
+GIN_TEST( ImageDataFlipsInPlaceLikeCopy )
+{
+	// Rows of five DXT1 blocks fill two registers and leave a block. Three block rows have a middle row.
+	CImageData dxt1Image( TT_Texture2D, 20, 12, 1, TCT_Dxt1_RGB, 3, 1 );
+	GIN_CHECK( checkImageFlip( dxt1Image ) );
+	CImageData dxt3Image( TT_Texture2D, 12, 8, 1, TCT_Dxt3, 2, 1 );
+	GIN_CHECK( checkImageFlip( dxt3Image ) );
+	CImageData dxt5Image( TT_Texture2D, 12, 12, 1, TCT_Dxt5, 2, 2 );
+	GIN_CHECK( checkImageFlip( dxt5Image ) );
+	CImageData bc4Image( TT_Texture2D, 28, 4, 1, TCT_Bc4, 1, 1 );
+	GIN_CHECK( checkImageFlip( bc4Image ) );
+	CImageData bc5Image( TT_Texture2D, 8, 12, 1, TCT_Bc5, 1, 1 );
+	GIN_CHECK( checkImageFlip( bc5Image ) );
+
+	CImageData rgbImage( TT_Texture2D, 5, 7, 1, TF_RGB, TDT_UnsignedByte, 3, 1 );
+	GIN_CHECK( checkImageFlip( rgbImage ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
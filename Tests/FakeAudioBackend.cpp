@@ -0,0 +1,249 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <FakeAudioBackend.h>
+
+namespace Gin {
+
+namespace Tests {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+int CFakeAudioBackend::GetBufferByteCount() const
+{
+	int result = 0;
+	for( const auto& buffer : buffers ) {
+		if( buffer.IsUsed ) {
+			result += buffer.ByteSize;
+		}
+	}
+	return result;
+}
+
+unsigned CFakeAudioBackend::FindBufferSource( unsigned bufferId ) const
+{
+	for( int i = 0; i < sources.Size(); i++ ) {
+		for( auto queuedId : sources[i].Queue ) {
+			if( queuedId == bufferId ) {
+				return i + 1;
+			}
+		}
+	}
+	return 0;
+}
+
+void CFakeAudioBackend::Advance( float seconds )
+{
+	for( auto& source : sources ) {
+		if( source.State != CAudioRecord::RS_Playing ) {
+			continue;
+		}
+		const float duration = getQueueDuration( source );
+		source.Offset += seconds * source.Pitch;
+		if( source.Offset >= duration ) {
+			if( source.IsLooping && duration > 0.0f ) {
+				source.Offset = fmodf( source.Offset, duration );
+			} else {
+				source.State = CAudioRecord::RS_Stopped;
+				source.Offset = 0.0f;
+			}
+		}
+	}
+}
+
+float CFakeAudioBackend::getQueueDuration( const CFakeSource& source ) const
+{
+	float result = 0.0f;
+	for( auto bufferId : source.Queue ) {
+		result += GetBufferDuration( bufferId );
+	}
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void CFakeAudioBackend::CreateBuffers( int count, unsigned* result )
+{
+	// Identifiers are not reused, so the deleted buffers can be checked.
+	for( int i = 0; i < count; i++ ) {
+		buffers.IncreaseSize( buffers.Size() + 1 );
+		buffers.Last().IsUsed = true;
+		result[i] = buffers.Size();
+	}
+	CreatedBufferCount += count;
+}
+
+void CFakeAudioBackend::DeleteBuffers( int count, const unsigned* bufferIds )
+{
+	for( int i = 0; i < count; i++ ) {
+		if( bufferIds[i] != 0 ) {
+			assert( buffers[bufferIds[i] - 1].IsUsed );
+			buffers[bufferIds[i] - 1].IsUsed = false;
+			DeletedBufferCount++;
+		}
+	}
+}
+
+void CFakeAudioBackend::SetBufferData( unsigned bufferId, TAudioDataFormat format, int frequency, const void*, int size )
+{
+	auto& buffer = buffers[bufferId - 1];
+	assert( buffer.IsUsed );
+	const int channelCount = ( format == ADF_Stereo8 || format == ADF_Stereo16 || format == ADF_StereoFloat32 ) ? 2 : 1;
+	const int sampleSize = ( format == ADF_Mono8 || format == ADF_Stereo8 ) ? 1 : ( format == ADF_Mono16 || format == ADF_Stereo16 ) ? 2 : 4;
+	buffer.Duration = static_cast<float>( size / ( channelCount * sampleSize ) ) / frequency;
+	buffer.ByteSize = size;
+	BufferUploadCount++;
+}
+
+float CFakeAudioBackend::GetBufferDuration( unsigned bufferId ) const
+{
+	return buffers[bufferId - 1].Duration;
+}
+
+unsigned CFakeAudioBackend::CreateSource()
+{
+	sources.IncreaseSize( sources.Size() + 1 );
+	return sources.Size();
+}
+
+void CFakeAudioBackend::DeleteSource( unsigned sourceId )
+{
+	auto& source = sources[sourceId - 1];
+	source.Queue.Empty();
+	source.State = CAudioRecord::RS_Stopped;
+}
+
+void CFakeAudioBackend::SetSourceRelative( unsigned sourceId, bool isRelative )
+{
+	sources[sourceId - 1].IsRelative = isRelative;
+}
+
+void CFakeAudioBackend::SetSourcePosition( unsigned sourceId, CVector3<float> position )
+{
+	sources[sourceId - 1].Position = position;
+}
+
+void CFakeAudioBackend::SetSourceVelocity( unsigned, CVector3<float> )
+{
+}
+
+void CFakeAudioBackend::SetSourceLooping( unsigned sourceId, bool isLooping )
+{
+	sources[sourceId - 1].IsLooping = isLooping;
+}
+
+void CFakeAudioBackend::SetSourceGain( unsigned sourceId, float gain )
+{
+	sources[sourceId - 1].Gain = gain;
+}
+
+void CFakeAudioBackend::SetSourcePitch( unsigned sourceId, float pitch )
+{
+	sources[sourceId - 1].Pitch = pitch;
+}
+
+float CFakeAudioBackend::GetDistanceGain( float distance ) const
+{
+	return GetInverseClampedDistanceGain( distance, 1.0f, FLT_MAX, 1.0f );
+}
+
+CAudioRecord::TRecordState CFakeAudioBackend::GetSourceState( unsigned sourceId ) const
+{
+	StateQueryCount++;
+	return sources[sourceId - 1].State;
+}
+
+void CFakeAudioBackend::GetSourceStates( int count, const unsigned* sourceIds, CAudioRecord::TRecordState* result ) const
+{
+	BatchedStateQueryCount++;
+	for( int i = 0; i < count; i++ ) {
+		result[i] = sources[sourceIds[i] - 1].State;
+	}
+}
+
+void CFakeAudioBackend::PlaySource( unsigned sourceId )
+{
+	auto& source = sources[sourceId - 1];
+	if( source.State != CAudioRecord::RS_Paused && !source.IsOffsetSet ) {
+		source.Offset = 0.0f;
+	}
+	source.IsOffsetSet = false;
+	source.State = source.Queue.IsEmpty() ? CAudioRecord::RS_Stopped : CAudioRecord::RS_Playing;
+}
+
+void CFakeAudioBackend::PauseSource( unsigned sourceId )
+{
+	auto& source = sources[sourceId - 1];
+	if( source.State == CAudioRecord::RS_Playing ) {
+		source.State = CAudioRecord::RS_Paused;
+	}
+}
+
+void CFakeAudioBackend::StopSource( unsigned sourceId )
+{
+	auto& source = sources[sourceId - 1];
+	source.State = CAudioRecord::RS_Stopped;
+	source.Offset = 0.0f;
+	source.IsOffsetSet = false;
+}
+
+void CFakeAudioBackend::RewindSource( unsigned sourceId )
+{
+	auto& source = sources[sourceId - 1];
+	source.State = CAudioRecord::RS_Initial;
+	source.Offset = 0.0f;
+	source.IsOffsetSet = false;
+}
+
+float CFakeAudioBackend::GetSourceOffset( unsigned sourceId ) const
+{
+	return sources[sourceId - 1].Offset;
+}
+
+void CFakeAudioBackend::SetSourceOffset( unsigned sourceId, float offset )
+{
+	auto& source = sources[sourceId - 1];
+	source.Offset = offset;
+	source.IsOffsetSet = source.State != CAudioRecord::RS_Playing && source.State != CAudioRecord::RS_Paused;
+}
+
+void CFakeAudioBackend::QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds )
+{
+	auto& source = sources[sourceId - 1];
+	for( int i = 0; i < count; i++ ) {
+		assert( buffers[bufferIds[i] - 1].IsUsed );
+		source.Queue.Add( bufferIds[i] );
+	}
+}
+
+int CFakeAudioBackend::UnqueueProcessedBuffers( unsigned, int, unsigned* )
+{
+	// Processed buffers are not tracked.
+	return 0;
+}
+
+int CFakeAudioBackend::GetQueuedBufferCount( unsigned sourceId ) const
+{
+	return sources[sourceId - 1].Queue.Size();
+}
+
+void CFakeAudioBackend::DetachBuffers( unsigned sourceId )
+{
+	auto& source = sources[sourceId - 1];
+	assert( source.State == CAudioRecord::RS_Initial || source.State == CAudioRecord::RS_Stopped );
+	source.Queue.Empty();
+	source.Offset = 0.0f;
+	source.IsOffsetSet = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+#endif
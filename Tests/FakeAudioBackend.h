@@ -0,0 +1,112 @@
+#pragma once
+
+#ifndef GIN_NO_AUDIO
+
+#include <AudioBackend.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Audio backend that only keeps the object states and counts the calls.
+// Playback is simulated by the Advance method: sources move their offsets and stop at the end of the queue.
+class CFakeAudioBackend : public Audio::IAudioBackend {
+public:
+	struct CFakeBuffer {
+		float Duration = 0.0f;
+		int ByteSize = 0;
+		bool IsUsed = false;
+	};
+
+	struct CFakeSource {
+		CArray<unsigned> Queue;
+		CVector3<float> Position;
+		float Gain = 1.0f;
+		float Pitch = 1.0f;
+		bool IsRelative = false;
+		bool IsLooping = false;
+		Audio::CAudioRecord::TRecordState State = Audio::CAudioRecord::RS_Initial;
+		float Offset = 0.0f;
+		// The offset is set before the playback and must be kept by the next PlaySource.
+		bool IsOffsetSet = false;
+	};
+
+	// Call counters.
+	int CreatedBufferCount = 0;
+	int DeletedBufferCount = 0;
+	int BufferUploadCount = 0;
+	// The state queries are const, so their counters are mutable.
+	mutable int StateQueryCount = 0;
+	mutable int BatchedStateQueryCount = 0;
+
+	int GetLiveBufferCount() const
+		{ return CreatedBufferCount - DeletedBufferCount; }
+	// Size of the data of the existing buffers.
+	int GetBufferByteCount() const;
+
+	const CFakeBuffer& GetBuffer( unsigned bufferId ) const
+		{ return buffers[bufferId - 1]; }
+	int GetSourceCount() const
+		{ return sources.Size(); }
+	const CFakeSource& GetSource( unsigned sourceId ) const
+		{ return sources[sourceId - 1]; }
+	// Find the source that has the buffer in its queue. Return zero if there is none.
+	unsigned FindBufferSource( unsigned bufferId ) const;
+
+	// Advance the playing sources by the given time.
+	void Advance( float seconds );
+
+	virtual bool IsFloatFormatSupported() const override final
+		{ return false; }
+
+	virtual void CreateBuffers( int count, unsigned* result ) override final;
+	virtual void DeleteBuffers( int count, const unsigned* bufferIds ) override final;
+	virtual void SetBufferData( unsigned bufferId, Audio::TAudioDataFormat format, int frequency, const void* data, int size ) override final;
+	virtual float GetBufferDuration( unsigned bufferId ) const override final;
+
+	virtual unsigned CreateSource() override final;
+	virtual void DeleteSource( unsigned sourceId ) override final;
+
+	virtual void SetSourceRelative( unsigned sourceId, bool isRelative ) override final;
+	virtual void SetSourcePosition( unsigned sourceId, CVector3<float> position ) override final;
+	virtual void SetSourceVelocity( unsigned sourceId, CVector3<float> velocity ) override final;
+	virtual void SetSourceLooping( unsigned sourceId, bool isLooping ) override final;
+	virtual void SetSourceGain( unsigned sourceId, float gain ) override final;
+	virtual void SetSourcePitch( unsigned sourceId, float pitch ) override final;
+	virtual float GetDistanceGain( float distance ) const override final;
+
+	virtual Audio::CAudioRecord::TRecordState GetSourceState( unsigned sourceId ) const override final;
+	virtual void GetSourceStates( int count, const unsigned* sourceIds, Audio::CAudioRecord::TRecordState* result ) const override final;
+	virtual void PlaySource( unsigned sourceId ) override final;
+	virtual void PauseSource( unsigned sourceId ) override final;
+	virtual void StopSource( unsigned sourceId ) override final;
+	virtual void RewindSource( unsigned sourceId ) override final;
+	virtual float GetSourceOffset( unsigned sourceId ) const override final;
+	virtual void SetSourceOffset( unsigned sourceId, float offset ) override final;
+
+	virtual void QueueBuffers( unsigned sourceId, int count, const unsigned* bufferIds ) override final;
+	virtual int UnqueueProcessedBuffers( unsigned sourceId, int maxCount, unsigned* result ) override final;
+	virtual int GetQueuedBufferCount( unsigned sourceId ) const override final;
+	virtual void DetachBuffers( unsigned sourceId ) override final;
+
+	virtual void SetListenerPosition( CVector3<float> ) override final {}
+	virtual void SetListenerOrientation( CVector3<float>, CVector3<float> ) override final {}
+	virtual void SetListenerVelocity( CVector3<float> ) override final {}
+
+private:
+	CArray<CFakeBuffer> buffers;
+	CArray<CFakeSource> sources;
+
+	float getQueueDuration( const CFakeSource& source ) const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+#endif
@@ -0,0 +1,163 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <FrameCapture.h>
+#include <RecordingImageEncoder.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Frames are written to the working directory and overwritten by each test.
+static const char* testFolderName = "FrameCaptureTest";
+static const char* testStreamName = "FrameCaptureTest.y4m";
+static const int frameRate = 30;
+static const CVector2<int> frameSize( 3, 2 );
+// Rows of three RGB pixels are aligned to 4 bytes.
+static const int frameByteSize = 12 * 2;
+
+static CFrameCaptureSettings createSettings( TFrameCaptureFormat format, TCaptureOverflowMode overflowMode )
+{
+	CFrameCaptureSettings settings;
+	settings.Path = format == FCF_Y4m ? testStreamName : testFolderName;
+	settings.Format = format;
+	settings.OverflowMode = overflowMode;
+	settings.EncoderCount = 2;
+	settings.MaxQueuedFrameCount = 2;
+	return settings;
+}
+
+// Synthetic frame with all the channels set to the same value.
+static bool addGrayFrame( CCaptureFrameWriter& writer, int frameIndex, BYTE value )
+{
+	BYTE pixels[frameByteSize];
+	memset( pixels, value, frameByteSize );
+	return writer.AddFrame( frameIndex, CArrayView<BYTE>( pixels, frameByteSize ), frameSize );
+}
+
+static bool readFile( CStringPart fileName, CArray<BYTE>& result )
+{
+	try {
+		CFileReader file( fileName, FCM_OpenExisting );
+		result.Empty();
+		result.IncreaseSizeNoInitialize( file.GetLength32() );
+		file.Read( result.Ptr(), result.Size() );
+		return true;
+	} catch( const CException& ) {
+		return false;
+	}
+}
+
+// Check that the file exists and starts with the signature.
+static bool hasSignature( CStringPart fileName, const char* signature )
+{
+	CArray<BYTE> data;
+	const int length = static_cast<int>( strlen( signature ) );
+	return readFile( fileName, data ) && data.Size() > length && memcmp( data.Ptr(), signature, length ) == 0;
+}
+
+GIN_TEST( FrameCapturePadsFrameNames )
+{
+	const CCaptureFrameWriter pngWriter( createSettings( FCF_Png, COM_Wait ), frameRate );
+	GIN_CHECK( pngWriter.GetFrameFileName( 0 ) == FileSystem::MergePath( testFolderName, "Frame000000.png" ) );
+	GIN_CHECK( pngWriter.GetFrameFileName( 42 ) == FileSystem::MergePath( testFolderName, "Frame000042.png" ) );
+	GIN_CHECK( pngWriter.GetFrameFileName( 999999 ) == FileSystem::MergePath( testFolderName, "Frame999999.png" ) );
+	// Longer indices are kept whole.
+	GIN_CHECK( pngWriter.GetFrameFileName( 1234567 ) == FileSystem::MergePath( testFolderName, "Frame1234567.png" ) );
+
+	const CCaptureFrameWriter bmpWriter( createSettings( FCF_Bmp, COM_Wait ), frameRate );
+	GIN_CHECK( bmpWriter.GetFrameFileName( 7 ) == FileSystem::MergePath( testFolderName, "Frame000007.bmp" ) );
+
+	const CCaptureFrameWriter streamWriter( createSettings( FCF_Y4m, COM_Wait ), frameRate );
+	GIN_CHECK( streamWriter.GetFrameFileName( 7 ).IsEmpty() );
+}
+
+GIN_TEST( FrameCaptureWritesNumberedFiles )
+{
+	const int frameCount = 5;
+	for( int format = FCF_Png; format <= FCF_Bmp; format++ ) {
+		CCaptureFrameWriter writer( createSettings( static_cast<TFrameCaptureFormat>( format ), COM_Wait ), frameRate );
+		// The producer waits for the encoders when the queue is full.
+		for( int i = 0; i < frameCount; i++ ) {
+			GIN_CHECK( addGrayFrame( writer, i, static_cast<BYTE>( i * 40 ) ) );
+		}
+		writer.Flush();
+
+		const CImageEncodeStatistics statistics = writer.GetStatistics();
+		GIN_CHECK( statistics.WrittenCount == frameCount );
+		GIN_CHECK( statistics.FailedCount == 0 );
+		GIN_CHECK( statistics.WrittenPixelCount == frameCount * frameSize.X() * frameSize.Y() );
+		const char* signature = format == FCF_Png ? "\x89PNG" : "BM";
+		for( int i = 0; i < frameCount; i++ ) {
+			GIN_CHECK( hasSignature( writer.GetFrameFileName( i ), signature ) );
+		}
+	}
+}
+
+GIN_TEST( FrameCaptureWritesStreamInFrameOrder )
+{
+	const int frameCount = 6;
+	{
+		CCaptureFrameWriter writer( createSettings( FCF_Y4m, COM_Wait ), frameRate );
+		// Frames are converted in parallel and appended in the order of addition.
+		for( int i = 0; i < frameCount; i++ ) {
+			GIN_CHECK( addGrayFrame( writer, i, static_cast<BYTE>( 255 - i * 40 ) ) );
+		}
+		writer.Flush();
+		GIN_CHECK( writer.GetStatistics().WrittenCount == frameCount );
+	}
+
+	CArray<BYTE> data;
+	GIN_CHECK( readFile( testStreamName, data ) );
+	const char* header = "YUV4MPEG2 W3 H2 F30:1 Ip A1:1 C444\n";
+	const int headerSize = static_cast<int>( strlen( header ) );
+	const int planeSize = frameSize.X() * frameSize.Y();
+	const int streamFrameSize = 6 + 3 * planeSize;
+	GIN_CHECK( data.Size() == headerSize + frameCount * streamFrameSize );
+	if( data.Size() != headerSize + frameCount * streamFrameSize ) {
+		return;
+	}
+	GIN_CHECK( memcmp( data.Ptr(), header, headerSize ) == 0 );
+	for( int i = 0; i < frameCount; i++ ) {
+		const BYTE* frame = data.Ptr() + headerSize + i * streamFrameSize;
+		GIN_CHECK( memcmp( frame, "FRAME\n", 6 ) == 0 );
+		// BT.601 luma of the gray value.
+		const int gray = 255 - i * 40;
+		const BYTE expectedLuma = static_cast<BYTE>( ( ( 220 * gray + 128 ) >> 8 ) + 16 );
+		GIN_CHECK( frame[6] == expectedLuma && frame[6 + planeSize - 1] == expectedLuma );
+	}
+}
+
+GIN_TEST( FrameCaptureDropsFramesWhenQueueIsFull )
+{
+	CFrameCaptureSettings settings = createSettings( FCF_Png, COM_Drop );
+	settings.EncoderCount = 1;
+	CRecordingEncoder encoder( false );
+	CCaptureFrameWriter writer( settings, frameRate, &encoder );
+
+	// The encoder holds the first frame and the second one waits in the queue.
+	GIN_CHECK( addGrayFrame( writer, 0, 0 ) );
+	encoder.WaitForStartedJobs( 1 );
+	GIN_CHECK( addGrayFrame( writer, 1, 0 ) );
+	GIN_CHECK( !addGrayFrame( writer, 2, 0 ) );
+	GIN_CHECK( !addGrayFrame( writer, 3, 0 ) );
+
+	encoder.Open();
+	writer.Flush();
+	GIN_CHECK( addGrayFrame( writer, 4, 0 ) );
+	writer.Flush();
+
+	const CImageEncodeStatistics statistics = writer.GetStatistics();
+	GIN_CHECK( statistics.RejectedCount == 2 );
+	GIN_CHECK( statistics.WrittenCount == 3 );
+	GIN_CHECK( encoder.HasEncodedJobs( 3 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,312 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <GifFile.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Writer of the LZW codes. Codes are packed starting from the least significant bit.
+// The code width grows with the code table in the same way as in the decoder, so the test lists the codes and not their bits.
+class CLzwCodeWriter {
+public:
+	explicit CLzwCodeWriter( int _minKeySize ) : minKeySize( _minKeySize ), keySize( _minKeySize + 1 ), nextCode( GetClearCode() + 2 ) {}
+
+	int GetClearCode() const
+		{ return 1 << minKeySize; }
+	int GetStopCode() const
+		{ return GetClearCode() + 1; }
+	int GetKeySize() const
+		{ return keySize; }
+
+	void AddCode( int code );
+	// Stream with the last partial byte.
+	const CArray<BYTE>& GetStream();
+
+private:
+	const int minKeySize;
+	int keySize;
+	int nextCode;
+	// The table gets a new entry with each code after the first one.
+	bool hasPrevCode = false;
+	CArray<BYTE> stream;
+	unsigned bitBuffer = 0;
+	int bitCount = 0;
+};
+
+void CLzwCodeWriter::AddCode( int code )
+{
+	assert( code >= 0 && code < ( 1 << keySize ) );
+	bitBuffer |= code << bitCount;
+	bitCount += keySize;
+	while( bitCount >= 8 ) {
+		stream.Add( static_cast<BYTE>( bitBuffer ) );
+		bitBuffer >>= 8;
+		bitCount -= 8;
+	}
+
+	if( code == GetClearCode() ) {
+		keySize = minKeySize + 1;
+		nextCode = GetClearCode() + 2;
+		hasPrevCode = false;
+		return;
+	}
+	if( code == GetStopCode() ) {
+		return;
+	}
+	if( hasPrevCode && nextCode < 0x1000 ) {
+		nextCode++;
+		if( nextCode == ( 1 << keySize ) && keySize < 12 ) {
+			keySize++;
+		}
+	}
+	hasPrevCode = true;
+}
+
+const CArray<BYTE>& CLzwCodeWriter::GetStream()
+{
+	if( bitCount > 0 ) {
+		stream.Add( static_cast<BYTE>( bitBuffer ) );
+		bitBuffer = 0;
+		bitCount = 0;
+	}
+	return stream;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// The test file is written to the working directory and overwritten by each test.
+static const char* testFileName = "GifDecoderTest.gif";
+// Pixels of the first frame that are missing from the code stream have the background index.
+static const BYTE backgroundIndex = 7;
+
+static void addWord( CArray<BYTE>& data, int value )
+{
+	data.Add( static_cast<BYTE>( value ) );
+	data.Add( static_cast<BYTE>( value >> 8 ) );
+}
+
+// Write a single frame image with the given code stream. The red channel of each palette color is equal to its index.
+// If hasTerminator is false, the file ends in the middle of the image data.
+static void writeGifFile( int width, int height, bool isInterlaced, int minKeySize, const CArray<BYTE>& codeStream, bool hasTerminator = true )
+{
+	CArray<BYTE> data;
+	const char* header = "GIF89a";
+	for( int i = 0; i < 6; i++ ) {
+		data.Add( static_cast<BYTE>( header[i] ) );
+	}
+	addWord( data, width );
+	addWord( data, height );
+	// Global color table with 256 entries, background color and aspect ratio.
+	data.Add( 0x87 );
+	data.Add( backgroundIndex );
+	data.Add( 0 );
+	for( int i = 0; i < 256; i++ ) {
+		data.Add( static_cast<BYTE>( i ) );
+		data.Add( static_cast<BYTE>( 255 - i ) );
+		data.Add( static_cast<BYTE>( i / 2 ) );
+	}
+
+	// Image descriptor of a frame that covers the whole canvas.
+	data.Add( ',' );
+	addWord( data, 0 );
+	addWord( data, 0 );
+	addWord( data, width );
+	addWord( data, height );
+	data.Add( isInterlaced ? 0x40 : 0 );
+	data.Add( static_cast<BYTE>( minKeySize ) );
+	for( int pos = 0; pos < codeStream.Size(); pos += 255 ) {
+		const int blockSize = min( 255, codeStream.Size() - pos );
+		data.Add( static_cast<BYTE>( blockSize ) );
+		for( int i = 0; i < blockSize; i++ ) {
+			data.Add( codeStream[pos + i] );
+		}
+	}
+	if( hasTerminator ) {
+		data.Add( 0 );
+		data.Add( ';' );
+	}
+
+	CFileWriter file( testFileName, FCM_CreateAlways );
+	file.Write( data.Ptr(), data.Size() );
+}
+
+// Decode the test file and compare the palette indices of its pixels with the expected ones. The pixels are in the top-down order.
+static bool hasIndices( const CArray<BYTE>& expected )
+{
+	const CGifFrameSequence sequence = CGifFile( testFileName ).CreateFrameSequence( false );
+	const CImageData& frames = sequence.Frames;
+	if( frames.GetArrayCount() != 1 || frames.Width() * frames.Height() != expected.Size() ) {
+		return false;
+	}
+	const BYTE* pixels = frames.GetImageData( 0 );
+	for( int i = 0; i < expected.Size(); i++ ) {
+		const BYTE* pixel = pixels + 4 * i;
+		if( pixel[0] != expected[i] || pixel[1] != 255 - expected[i] || pixel[3] != 255 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool isRejected()
+{
+	try {
+		CGifFile( testFileName ).CreateFrameSequence();
+	} catch( const CGifException& ) {
+		return true;
+	}
+	return false;
+}
+
+GIN_TEST( GifDecoderDecodesKwKwKCodes )
+{
+	CLzwCodeWriter writer( 2 );
+	writer.AddCode( writer.GetClearCode() );
+	writer.AddCode( 1 );
+	// The code that is being defined: the previous string followed by its own first index.
+	writer.AddCode( 6 );
+	writer.AddCode( 6 );
+	// The code width has grown to 4 bits.
+	GIN_CHECK( writer.GetKeySize() == 4 );
+	writer.AddCode( 2 );
+	writer.AddCode( 8 );
+	writer.AddCode( writer.GetStopCode() );
+	writeGifFile( 3, 3, false, 2, writer.GetStream() );
+
+	const BYTE expected[] = { 1, 1, 1, 1, 1, 2, 1, 1, 2 };
+	CArray<BYTE> expectedIndices;
+	for( BYTE index : expected ) {
+		expectedIndices.Add( index );
+	}
+	GIN_CHECK( hasIndices( expectedIndices ) );
+}
+
+GIN_TEST( GifDecoderKeepsFullTableUntilClear )
+{
+	// Literals fill the code table: each literal after the first one defines a code, the last defined code is 4095.
+	const int literalCount = 0x1000 - 6 + 1;
+	CLzwCodeWriter writer( 2 );
+	CArray<BYTE> expected;
+	writer.AddCode( writer.GetClearCode() );
+	for( int i = 0; i < literalCount; i++ ) {
+		writer.AddCode( i % 4 );
+		expected.Add( static_cast<BYTE>( i % 4 ) );
+	}
+	GIN_CHECK( writer.GetKeySize() == 12 );
+
+	// The encoder defers the clear code and goes on with the full table. Codes stay 12 bits wide.
+	writer.AddCode( 3 );
+	expected.Add( 3 );
+	// Code 4095 is defined by the last two literals.
+	writer.AddCode( 0xFFF );
+	expected.Add( static_cast<BYTE>( ( literalCount - 2 ) % 4 ) );
+	expected.Add( static_cast<BYTE>( ( literalCount - 1 ) % 4 ) );
+	GIN_CHECK( writer.GetKeySize() == 12 );
+
+	// The clear code restores the initial width.
+	writer.AddCode( writer.GetClearCode() );
+	GIN_CHECK( writer.GetKeySize() == 3 );
+	writer.AddCode( 2 );
+	expected.Add( 2 );
+	writer.AddCode( 1 );
+	expected.Add( 1 );
+	writer.AddCode( 6 );
+	expected.Add( 2 );
+	expected.Add( 1 );
+	writer.AddCode( writer.GetStopCode() );
+
+	writeGifFile( expected.Size(), 1, false, 2, writer.GetStream() );
+	GIN_CHECK( hasIndices( expected ) );
+}
+
+GIN_TEST( GifDecoderStopsAtTruncatedStream )
+{
+	CLzwCodeWriter writer( 2 );
+	writer.AddCode( writer.GetClearCode() );
+	writer.AddCode( 1 );
+	writer.AddCode( 2 );
+	writer.AddCode( 3 );
+	writer.AddCode( 1 );
+	// The stream ends at a byte boundary without the stop code.
+	writeGifFile( 4, 2, false, 2, writer.GetStream() );
+	const BYTE expected[] = { 1, 2, 3, 1, backgroundIndex, backgroundIndex, backgroundIndex, backgroundIndex };
+	CArray<BYTE> expectedIndices;
+	for( BYTE index : expected ) {
+		expectedIndices.Add( index );
+	}
+	GIN_CHECK( hasIndices( expectedIndices ) );
+
+	// Codes past the size of the frame are ignored.
+	CLzwCodeWriter longWriter( 2 );
+	longWriter.AddCode( longWriter.GetClearCode() );
+	for( int i = 0; i < 6; i++ ) {
+		longWriter.AddCode( 3 );
+	}
+	longWriter.AddCode( longWriter.GetStopCode() );
+	writeGifFile( 2, 2, false, 2, longWriter.GetStream() );
+	CArray<BYTE> longExpected;
+	for( int i = 0; i < 4; i++ ) {
+		longExpected.Add( 3 );
+	}
+	GIN_CHECK( hasIndices( longExpected ) );
+
+	// A file that ends inside the image data is an error.
+	writeGifFile( 4, 2, false, 2, writer.GetStream(), false );
+	GIN_CHECK( isRejected() );
+}
+
+GIN_TEST( GifDecoderRejectsInvalidCodes )
+{
+	CLzwCodeWriter writer( 2 );
+	writer.AddCode( writer.GetClearCode() );
+	writer.AddCode( 1 );
+	// The next code to be defined is 6, code 7 is unknown.
+	writer.AddCode( 7 );
+	writer.AddCode( writer.GetStopCode() );
+	writeGifFile( 2, 2, false, 2, writer.GetStream() );
+	GIN_CHECK( isRejected() );
+
+	// A code that is being defined can't be the first after a clear.
+	CLzwCodeWriter clearWriter( 2 );
+	clearWriter.AddCode( clearWriter.GetClearCode() );
+	clearWriter.AddCode( 6 );
+	writeGifFile( 2, 2, false, 2, clearWriter.GetStream() );
+	GIN_CHECK( isRejected() );
+}
+
+GIN_TEST( GifDecoderPlacesInterlacedRows )
+{
+	const int width = 2;
+	const int height = 10;
+	CLzwCodeWriter writer( 4 );
+	writer.AddCode( writer.GetClearCode() );
+	// Each stream row is filled with its index.
+	for( int y = 0; y < height; y++ ) {
+		for( int x = 0; x < width; x++ ) {
+			writer.AddCode( y );
+		}
+	}
+	writer.AddCode( writer.GetStopCode() );
+	writeGifFile( width, height, true, 4, writer.GetStream() );
+
+	// Rows of the passes: every 8th row from 0, every 8th row from 4, every 4th row from 2 and every 2nd row from 1.
+	const int streamRows[height] = { 0, 5, 3, 6, 2, 7, 4, 8, 1, 9 };
+	CArray<BYTE> expected;
+	for( int y = 0; y < height; y++ ) {
+		for( int x = 0; x < width; x++ ) {
+			expected.Add( static_cast<BYTE>( streamRows[y] ) );
+		}
+	}
+	GIN_CHECK( hasIndices( expected ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,333 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <GlyphAtlas.h>
+#include <GlyphProvider.h>
+#include <DistanceFieldGlyphProvider.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+class CPatternGlyph : public IGlyph {
+public:
+	CPatternGlyph( CGlyphSizeData _sizeData, CArray<BYTE> _bitmap ) : sizeData( _sizeData ), bitmap( move( _bitmap ) ) {}
+
+	virtual CGlyphData GetGlyphData() const override final
+		{ return CGlyphData{ sizeData, bitmap.Ptr() }; }
+
+private:
+	CGlyphSizeData sizeData;
+	CArray<BYTE> bitmap;
+};
+
+// Provider of synthetic glyphs. Sizes and texels are computed from the glyph code, so every copy of the provider returns the same glyphs.
+// The repository has no font files, the glyphs stand in for a rasterized font.
+class CPatternGlyphProvider : public IGlyphProvider {
+public:
+	// Worker copies of the provider increment the counter.
+	explicit CPatternGlyphProvider( int* _copyCount ) : copyCount( _copyCount ) {}
+
+	static CGlyphSizeData GetSizeData( unsigned code );
+	static BYTE GetTexel( unsigned code, int x, int y )
+		{ return static_cast<BYTE>( code * 31 + x * 7 + y * 13 ); }
+
+	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+	virtual CPtrOwner<IGlyphProvider> CreateWorkerCopy() const override final;
+
+private:
+	int* copyCount;
+};
+
+CGlyphSizeData CPatternGlyphProvider::GetSizeData( unsigned code )
+{
+	CGlyphSizeData result;
+	// Some glyphs have no bitmap, like spaces.
+	const bool isEmpty = code % 17 == 0;
+	result.Size = isEmpty ? CVector2<int>{} : CVector2<int>( 3 + code % 7, 2 + code * 5 % 11 );
+	result.Offset = CVector2<int>( 1, result.Size.Y() - 2 );
+	result.Advance = CVector2<int>( result.Size.X() + 2, 0 );
+	// Rows have padding that the atlas skips.
+	result.Pitch = isEmpty ? 0 : result.Size.X() + 2;
+	return result;
+}
+
+CPtrOwner<IGlyph> CPatternGlyphProvider::GetGlyph( int utf32 ) const
+{
+	const auto sizeData = GetSizeData( utf32 );
+	CArray<BYTE> bitmap;
+	bitmap.IncreaseSize( sizeData.Pitch * sizeData.Size.Y() );
+	for( int y = 0; y < sizeData.Size.Y(); y++ ) {
+		for( int x = 0; x < sizeData.Size.X(); x++ ) {
+			bitmap[y * sizeData.Pitch + x] = GetTexel( utf32, x, y );
+		}
+	}
+	return CreateOwner<CPatternGlyph>( sizeData, move( bitmap ) );
+}
+
+CPtrOwner<IGlyphProvider> CPatternGlyphProvider::CreateWorkerCopy() const
+{
+	( *copyCount )++;
+	return CreateOwner<CPatternGlyphProvider>( copyCount );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Codes of the Latin range and some codes from other ranges.
+static void createGlyphCodes( unsigned firstCode, int count, CArray<unsigned>& result )
+{
+	for( int i = 0; i < count; i++ ) {
+		result.Add( firstCode + i * ( i % 3 == 0 ? 97 : 1 ) );
+	}
+}
+
+static bool isSameVector( CVector2<int> left, CVector2<int> right )
+{
+	return left.X() == right.X() && left.Y() == right.Y();
+}
+
+static bool isSameGlyph( const CAtlasGlyph& left, const CAtlasGlyph& right )
+{
+	return isSameVector( left.SizeData.Size, right.SizeData.Size ) && isSameVector( left.SizeData.Offset, right.SizeData.Offset )
+		&& isSameVector( left.SizeData.Advance, right.SizeData.Advance ) && isSameVector( left.Offset, right.Offset );
+}
+
+// Add the glyphs to both atlases and compare the results.
+static bool addSameGlyphs( const IGlyphProvider& provider, CArrayView<unsigned> glyphCodes, int workerCount, CGlyphAtlas& sequentialAtlas, CGlyphAtlas& parallelAtlas )
+{
+	CArray<CAtlasGlyph> sequentialGlyphs;
+	sequentialGlyphs.IncreaseSize( glyphCodes.Size() );
+	sequentialAtlas.AddGlyphs( provider, glyphCodes, 1, sequentialGlyphs );
+	CArray<CAtlasGlyph> parallelGlyphs;
+	parallelGlyphs.IncreaseSize( glyphCodes.Size() );
+	parallelAtlas.AddGlyphs( provider, glyphCodes, workerCount, parallelGlyphs );
+
+	for( int i = 0; i < glyphCodes.Size(); i++ ) {
+		if( !isSameGlyph( sequentialGlyphs[i], parallelGlyphs[i] ) ) {
+			return false;
+		}
+	}
+	const auto pixels = sequentialAtlas.GetPixels();
+	return isSameVector( sequentialAtlas.GetCapacity(), parallelAtlas.GetCapacity() ) && pixels.Size() == parallelAtlas.GetPixels().Size()
+		&& memcmp( pixels.Ptr(), parallelAtlas.GetPixels().Ptr(), pixels.Size() ) == 0
+		&& isSameVector( sequentialAtlas.GetDirtyStart(), parallelAtlas.GetDirtyStart() ) && isSameVector( sequentialAtlas.GetDirtyEnd(), parallelAtlas.GetDirtyEnd() );
+}
+
+GIN_TEST( GlyphAtlasPacksParallelGlyphsLikeSequential )
+{
+	int copyCount = 0;
+	const CPatternGlyphProvider provider( &copyCount );
+	CGlyphAtlas sequentialAtlas;
+	CGlyphAtlas parallelAtlas;
+	CArray<unsigned> glyphCodes;
+	createGlyphCodes( 32, 300, glyphCodes );
+	GIN_CHECK( addSameGlyphs( provider, glyphCodes, 4, sequentialAtlas, parallelAtlas ) );
+	GIN_CHECK( copyCount == 3 );
+	// The next glyphs start from a new row after the existing ones. The atlas grows to fit them.
+	CArray<unsigned> moreCodes;
+	createGlyphCodes( 0x400, 700, moreCodes );
+	GIN_CHECK( addSameGlyphs( provider, moreCodes, 3, sequentialAtlas, parallelAtlas ) );
+	GIN_CHECK( copyCount == 5 );
+	// Fewer glyphs than workers.
+	CArray<unsigned> fewCodes;
+	createGlyphCodes( 0x3000, 5, fewCodes );
+	GIN_CHECK( addSameGlyphs( provider, fewCodes, 8, sequentialAtlas, parallelAtlas ) );
+	GIN_CHECK( copyCount == 5 );
+}
+
+GIN_TEST( GlyphAtlasPacksParallelDistanceFieldsLikeSequential )
+{
+	int copyCount = 0;
+	const CDistanceFieldGlyphProvider provider( CreateOwner<CPatternGlyphProvider>( &copyCount ), 3 );
+	CGlyphAtlas sequentialAtlas;
+	CGlyphAtlas parallelAtlas;
+	CArray<unsigned> glyphCodes;
+	createGlyphCodes( 32, 200, glyphCodes );
+	GIN_CHECK( addSameGlyphs( provider, glyphCodes, 4, sequentialAtlas, parallelAtlas ) );
+	GIN_CHECK( copyCount == 3 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Check that the glyph bitmap is in the atlas and the padding after it is cleared.
+static bool hasGlyphBitmap( const CGlyphAtlas& atlas, unsigned code, const CAtlasGlyph& glyph )
+{
+	const auto size = glyph.SizeData.Size;
+	const auto rowStride = atlas.GetCapacity().X();
+	const auto pixels = atlas.GetPixels();
+	for( int y = 0; y <= size.Y(); y++ ) {
+		for( int x = 0; x <= size.X(); x++ ) {
+			const auto pos = ( glyph.Offset.Y() + y ) * rowStride + glyph.Offset.X() + x;
+			const auto expected = x < size.X() && y < size.Y() ? CPatternGlyphProvider::GetTexel( code, x, y ) : 0;
+			if( pixels[pos] != expected ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+GIN_TEST( GlyphAtlasCopiesGlyphBitmaps )
+{
+	int copyCount = 0;
+	const CPatternGlyphProvider provider( &copyCount );
+	CGlyphAtlas atlas;
+	CArray<unsigned> glyphCodes;
+	createGlyphCodes( 32, 400, glyphCodes );
+	CArray<CAtlasGlyph> glyphs;
+	glyphs.IncreaseSize( glyphCodes.Size() );
+	atlas.AddGlyphs( provider, glyphCodes, 2, glyphs );
+	const unsigned singleCode = 0x2000;
+	const auto singleGlyph = atlas.AddGlyph( provider, singleCode );
+
+	GIN_CHECK( atlas.GetCapacity().X() == CGlyphAtlas::MaxWidth );
+	for( int i = 0; i < glyphCodes.Size(); i++ ) {
+		GIN_CHECK( hasGlyphBitmap( atlas, glyphCodes[i], glyphs[i] ) );
+	}
+	GIN_CHECK( hasGlyphBitmap( atlas, singleCode, singleGlyph ) );
+
+	// The dirty region covers all the glyphs with their padding.
+	glyphs.Add( singleGlyph );
+	CVector2<int> glyphsStart = glyphs[0].Offset;
+	CVector2<int> glyphsEnd;
+	for( const auto& glyph : glyphs ) {
+		glyphsStart.X() = min( glyphsStart.X(), glyph.Offset.X() );
+		glyphsStart.Y() = min( glyphsStart.Y(), glyph.Offset.Y() );
+		glyphsEnd.X() = max( glyphsEnd.X(), glyph.Offset.X() + glyph.SizeData.Size.X() + CGlyphAtlas::GlyphPadding );
+		glyphsEnd.Y() = max( glyphsEnd.Y(), glyph.Offset.Y() + glyph.SizeData.Size.Y() + CGlyphAtlas::GlyphPadding );
+	}
+	GIN_CHECK( atlas.HasDirtyRegion() );
+	GIN_CHECK( isSameVector( atlas.GetDirtyStart(), glyphsStart ) );
+	GIN_CHECK( isSameVector( atlas.GetDirtyEnd(), glyphsEnd ) );
+	atlas.ClearDirtyRegion();
+	GIN_CHECK( !atlas.HasDirtyRegion() );
+
+	atlas.FreeBuffer();
+	GIN_CHECK( isSameVector( atlas.GetCapacity(), CVector2<int>() ) );
+	GIN_CHECK( atlas.GetPixels().IsEmpty() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+GIN_TEST( GlyphAtlasUploadsChangedRegions )
+{
+	int copyCount = 0;
+	const CPatternGlyphProvider provider( &copyCount );
+	CGlyphAtlas atlas;
+	CArray<unsigned> glyphCodes;
+	createGlyphCodes( 32, 96, glyphCodes );
+	CArray<CAtlasGlyph> glyphs;
+	glyphs.IncreaseSize( glyphCodes.Size() );
+	atlas.AddGlyphs( provider, glyphCodes, 1, glyphs );
+
+	// The first upload creates the texture storage.
+	CVector2<int> textureSize;
+	const auto firstUpload = atlas.TakeUpload( textureSize );
+	GIN_CHECK( firstUpload.IsReallocation );
+	GIN_CHECK( isSameVector( firstUpload.Size, atlas.GetCapacity() ) );
+	GIN_CHECK( !atlas.HasDirtyRegion() );
+	textureSize = atlas.GetCapacity();
+	// Nothing is uploaded while the atlas is unchanged.
+	GIN_CHECK( atlas.TakeUpload( textureSize ).IsEmpty() );
+	GIN_CHECK( atlas.GetStatistics().UploadCount == 1 );
+	GIN_CHECK( atlas.GetStatistics().UploadedByteCount == atlas.GetPixels().Size() );
+	GIN_CHECK( atlas.GetStatistics().ReallocationCount == 1 );
+
+	// Each frame adds a new glyph and uploads its cell. The storage is recreated when the atlas grows.
+	atlas.ResetStatistics();
+	const int frameCount = 3000;
+	int expectedByteCount = 0;
+	int expectedReallocationCount = 0;
+	int maxCellByteCount = 0;
+	for( int frame = 0; frame < frameCount; frame++ ) {
+		const auto glyph = atlas.AddGlyph( provider, 0x4000 + frame * 3 );
+		const auto upload = atlas.TakeUpload( textureSize );
+		if( !isSameVector( textureSize, atlas.GetCapacity() ) ) {
+			GIN_CHECK( upload.IsReallocation );
+			GIN_CHECK( isSameVector( upload.Size, atlas.GetCapacity() ) );
+			expectedByteCount += atlas.GetPixels().Size();
+			expectedReallocationCount++;
+			textureSize = atlas.GetCapacity();
+		} else {
+			// Glyphs without a bitmap take a padding texel. The padding of the last glyph in a row is clipped by the atlas edge.
+			const CVector2<int> cellEnd( min( glyph.Offset.X() + glyph.SizeData.Size.X() + CGlyphAtlas::GlyphPadding, atlas.GetCapacity().X() ),
+				glyph.Offset.Y() + glyph.SizeData.Size.Y() + CGlyphAtlas::GlyphPadding );
+			const CVector2<int> cellSize( cellEnd.X() - glyph.Offset.X(), cellEnd.Y() - glyph.Offset.Y() );
+			GIN_CHECK( !upload.IsReallocation );
+			GIN_CHECK( isSameVector( upload.Offset, glyph.Offset ) );
+			GIN_CHECK( isSameVector( upload.Size, cellSize ) );
+			expectedByteCount += cellSize.X() * cellSize.Y();
+			maxCellByteCount = max( maxCellByteCount, cellSize.X() * cellSize.Y() );
+		}
+	}
+	GIN_CHECK( expectedReallocationCount > 0 );
+	GIN_CHECK( atlas.GetStatistics().UploadCount == frameCount );
+	GIN_CHECK( atlas.GetStatistics().ReallocationCount == expectedReallocationCount );
+	GIN_CHECK( atlas.GetStatistics().UploadedByteCount == expectedByteCount );
+	// A single glyph update is a small fraction of the atlas.
+	GIN_CHECK( maxCellByteCount * 100 < atlas.GetPixels().Size() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Provider of blank glyphs that take a whole atlas row.
+class CTallGlyphProvider : public IGlyphProvider {
+public:
+	static const int GlyphHeight = 3000;
+
+	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+};
+
+CPtrOwner<IGlyph> CTallGlyphProvider::GetGlyph( int utf32 ) const
+{
+	CGlyphSizeData sizeData;
+	sizeData.Size = utf32 == 0 ? CVector2<int>( 2, 2 ) : CVector2<int>( CGlyphAtlas::MaxWidth / 2 + 1, GlyphHeight );
+	sizeData.Advance = CVector2<int>( sizeData.Size.X(), 0 );
+	sizeData.Pitch = sizeData.Size.X();
+	CArray<BYTE> bitmap;
+	bitmap.IncreaseSize( sizeData.Pitch * sizeData.Size.Y() );
+	return CreateOwner<CPatternGlyph>( sizeData, move( bitmap ) );
+}
+
+// Add tall glyphs until the atlas is full. Return the number of added glyphs.
+static int fillAtlas( const IGlyphProvider& provider, CGlyphAtlas& atlas )
+{
+	for( int glyphCount = 0; ; glyphCount++ ) {
+		try {
+			const auto glyph = atlas.AddGlyph( provider, 1 + glyphCount );
+			if( glyph.Offset.Y() + glyph.SizeData.Size.Y() > CGlyphAtlas::MaxHeight ) {
+				return NotFound;
+			}
+		} catch( CCheckException& ) {
+			return glyphCount;
+		}
+	}
+}
+
+GIN_TEST( GlyphAtlasRejectsGlyphsBeyondMaxHeight )
+{
+	const CTallGlyphProvider provider;
+	CGlyphAtlas atlas;
+	const int rowHeight = CTallGlyphProvider::GlyphHeight + CGlyphAtlas::GlyphPadding;
+	const int rowCount = CGlyphAtlas::MaxHeight / rowHeight;
+	GIN_CHECK( fillAtlas( provider, atlas ) == rowCount );
+	// The last growth is limited by the maximum height.
+	GIN_CHECK( atlas.GetCapacity().Y() == CGlyphAtlas::MaxHeight );
+
+	// The rejected glyph does not change the atlas, smaller glyphs still fit in the last row.
+	const auto capacity = atlas.GetCapacity();
+	const auto pixelCount = atlas.GetPixels().Size();
+	const auto smallGlyph = atlas.AddGlyph( provider, 0 );
+	GIN_CHECK( isSameVector( atlas.GetCapacity(), capacity ) );
+	GIN_CHECK( atlas.GetPixels().Size() == pixelCount );
+	GIN_CHECK( smallGlyph.Offset.Y() == ( rowCount - 1 ) * rowHeight );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,276 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <GlyphCache.h>
+#include <GlyphProvider.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+class CBlankGlyph : public IGlyph {
+public:
+	explicit CBlankGlyph( CGlyphSizeData _sizeData ) : sizeData( _sizeData ) {}
+
+	virtual CGlyphData GetGlyphData() const override final
+		{ return CGlyphData{ sizeData, bitmap }; }
+
+private:
+	CGlyphSizeData sizeData;
+	BYTE bitmap[6] = {};
+};
+
+// Provider of blank glyphs with advances and kerning computed from the glyph codes.
+class CKerningGlyphProvider : public IGlyphProvider {
+public:
+	// Kerning requests increment the counter.
+	CKerningGlyphProvider( bool _hasKerning, int* _kerningCallCount ) : hasKerning( _hasKerning ), kerningCallCount( _kerningCallCount ) {}
+
+	static int GetAdvance( unsigned code )
+		{ return 5 + code % 4; }
+	// Some of the pairs have no kerning.
+	static int GetPairKerning( unsigned leftCode, unsigned rightCode )
+		{ return static_cast<int>( ( leftCode * 7 + rightCode * 3 ) % 5 ) - 2; }
+
+	virtual CPtrOwner<IGlyph> GetGlyph( int utf32 ) const override final;
+	virtual bool HasKerning() const override final
+		{ return hasKerning; }
+	virtual int GetKerning( int leftUtf32, int rightUtf32 ) const override final;
+
+private:
+	bool hasKerning;
+	int* kerningCallCount;
+};
+
+CPtrOwner<IGlyph> CKerningGlyphProvider::GetGlyph( int utf32 ) const
+{
+	CGlyphSizeData sizeData;
+	sizeData.Size = CVector2<int>( 2, 3 );
+	sizeData.Offset = CVector2<int>( 0, 3 );
+	sizeData.Advance = CVector2<int>( GetAdvance( utf32 ), 0 );
+	sizeData.Pitch = 2;
+	return CreateOwner<CBlankGlyph>( sizeData );
+}
+
+int CKerningGlyphProvider::GetKerning( int leftUtf32, int rightUtf32 ) const
+{
+	( *kerningCallCount )++;
+	return GetPairKerning( leftUtf32, rightUtf32 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static int getExpectedKerning( unsigned leftCode, unsigned rightCode )
+{
+	const bool isLatinPair = leftCode < CGlyphCache::LatinSymbolCount && rightCode < CGlyphCache::LatinSymbolCount;
+	return isLatinPair ? CKerningGlyphProvider::GetPairKerning( leftCode, rightCode ) : 0;
+}
+
+GIN_TEST( GlyphCacheComputesKerningOfLatinPairs )
+{
+	int kerningCallCount = 0;
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( true, &kerningCallCount ) );
+	const wchar_t codes[] = L"AVTo.";
+	const int codeCount = 5;
+	cache.LoadGlyphs( codes, 1 );
+	// Each new glyph is paired with itself and the previous glyphs in both orders.
+	GIN_CHECK( kerningCallCount == codeCount * codeCount );
+
+	for( int left = 0; left < codeCount; left++ ) {
+		for( int right = 0; right < codeCount; right++ ) {
+			GIN_CHECK( cache.GetKerning( codes[left], codes[right] ) == getExpectedKerning( codes[left], codes[right] ) );
+		}
+	}
+	// Lookups of the loaded glyphs do not request the provider.
+	GIN_CHECK( kerningCallCount == codeCount * codeCount );
+
+	// A lookup adds a missing glyph and computes its pairs.
+	GIN_CHECK( cache.GetKerning( 'W', 'A' ) == getExpectedKerning( 'W', 'A' ) );
+	GIN_CHECK( kerningCallCount == ( codeCount + 1 ) * ( codeCount + 1 ) );
+	GIN_CHECK( cache.GetKerning( 'A', 'W' ) == getExpectedKerning( 'A', 'W' ) );
+
+	// Glyphs outside the Latin range have no kerning.
+	const unsigned cyrillicCode = 0x416;
+	GIN_CHECK( cache.GetKerning( cyrillicCode, 'A' ) == 0 );
+	GIN_CHECK( cache.GetKerning( 'A', cyrillicCode ) == 0 );
+	cache.GetRenderData( cyrillicCode );
+	GIN_CHECK( kerningCallCount == ( codeCount + 1 ) * ( codeCount + 1 ) );
+}
+
+GIN_TEST( GlyphCacheSkipsKerningWithoutProviderSupport )
+{
+	int kerningCallCount = 0;
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( false, &kerningCallCount ) );
+	cache.LoadGlyphs( L"AVTo.", 1 );
+	GIN_CHECK( CKerningGlyphProvider::GetPairKerning( 'A', 'V' ) != 0 );
+	GIN_CHECK( cache.GetKerning( 'A', 'V' ) == 0 );
+	GIN_CHECK( cache.GetKerning( 'T', 'o' ) == 0 );
+	GIN_CHECK( kerningCallCount == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Check the glyph codes and the kerned pen positions of a shaped line.
+static bool isShapedLine( const CShapedLine& line, CArrayView<unsigned> codes, CArrayView<int> strPositions )
+{
+	if( line.Glyphs.Size() != codes.Size() ) {
+		return false;
+	}
+	int pen = 0;
+	for( int i = 0; i < codes.Size(); i++ ) {
+		if( i > 0 ) {
+			pen += getExpectedKerning( codes[i - 1], codes[i] );
+		}
+		const auto& glyph = line.Glyphs[i];
+		if( glyph.GlyphCode != codes[i] || glyph.StrPos != strPositions[i] || glyph.Position.X() != pen || glyph.Position.Y() != 0 ) {
+			return false;
+		}
+		pen += CKerningGlyphProvider::GetAdvance( codes[i] );
+	}
+	return line.EndOffset.X() == pen && line.EndOffset.Y() == 0;
+}
+
+GIN_TEST( GlyphCacheShapesLinesOnce )
+{
+	int kerningCallCount = 0;
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( true, &kerningCallCount ) );
+	const unsigned codes[] = { 'A', 'V', 'A', 'V', 'o' };
+	const int strPositions[] = { 0, 1, 2, 3, 4 };
+	const auto& line = cache.GetShapedLine( CUnicodePart( L"AVAVo" ) );
+	GIN_CHECK( isShapedLine( line, CArrayView<unsigned>( codes, 5 ), CArrayView<int>( strPositions, 5 ) ) );
+	GIN_CHECK( cache.GetShapingCacheStatistics().MissCount == 1 );
+
+	// The same text is taken from the cache.
+	const auto& cachedLine = cache.GetShapedLine( CUnicodePart( L"AVAVo" ) );
+	GIN_CHECK( &cachedLine == &line );
+	GIN_CHECK( cache.GetShapingCacheStatistics().HitCount == 1 );
+	GIN_CHECK( cache.GetShapingCacheStatistics().EvictionCount == 0 );
+
+	// Encoding is a part of the key. Both encodings produce the same glyphs.
+	const auto& utf8Line = cache.GetShapedLine( CStringPart( "AVAVo" ) );
+	GIN_CHECK( isShapedLine( utf8Line, CArrayView<unsigned>( codes, 5 ), CArrayView<int>( strPositions, 5 ) ) );
+	GIN_CHECK( cache.GetShapingCacheStatistics().MissCount == 2 );
+	GIN_CHECK( cache.GetShapingCacheStatistics().HitCount == 1 );
+
+	// Positions in the string refer to code units.
+	const unsigned surrogateCodes[] = { 'A', 0x1F600, 'V' };
+	const int surrogatePositions[] = { 0, 1, 3 };
+	const wchar_t surrogateText[] = { L'A', 0xD83D, 0xDE00, L'V' };
+	const auto& surrogateLine = cache.GetShapedLine( CUnicodePart( surrogateText, 4 ) );
+	GIN_CHECK( isShapedLine( surrogateLine, CArrayView<unsigned>( surrogateCodes, 3 ), CArrayView<int>( surrogatePositions, 3 ) ) );
+	const unsigned utf8Codes[] = { 'A', 0x416, 'V' };
+	const auto& utf8MultibyteLine = cache.GetShapedLine( CStringPart( "A\xD0\x96V" ) );
+	GIN_CHECK( isShapedLine( utf8MultibyteLine, CArrayView<unsigned>( utf8Codes, 3 ), CArrayView<int>( surrogatePositions, 3 ) ) );
+}
+
+GIN_TEST( GlyphCacheEvictsShapedLines )
+{
+	int kerningCallCount = 0;
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( true, &kerningCallCount ) );
+	// A line of four glyphs takes a bit more than the glyphs, the budget keeps two or three lines.
+	cache.SetShapingCacheBudget( 3 * 4 * sizeof( CTextLayoutGlyph ) );
+	const char* texts[] = { "AAAA", "VVVV", "TTTT", "oooo", "AVTo" };
+	for( auto text : texts ) {
+		cache.GetShapedLine( CStringPart( text ) );
+	}
+	GIN_CHECK( cache.GetShapingCacheStatistics().MissCount == 5 );
+	const auto evictionCount = cache.GetShapingCacheStatistics().EvictionCount;
+	GIN_CHECK( evictionCount >= 2 );
+
+	// The last line is kept, the first one is shaped again with the same result.
+	cache.GetShapedLine( CStringPart( "AVTo" ) );
+	GIN_CHECK( cache.GetShapingCacheStatistics().HitCount == 1 );
+	GIN_CHECK( cache.GetShapingCacheStatistics().EvictionCount == evictionCount );
+	const unsigned codes[] = { 'A', 'A', 'A', 'A' };
+	const int strPositions[] = { 0, 1, 2, 3 };
+	const auto& line = cache.GetShapedLine( CStringPart( "AAAA" ) );
+	GIN_CHECK( cache.GetShapingCacheStatistics().MissCount == 6 );
+	GIN_CHECK( isShapedLine( line, CArrayView<unsigned>( codes, 4 ), CArrayView<int>( strPositions, 4 ) ) );
+
+	// Replacing the provider removes the shaped lines.
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( true, &kerningCallCount ) );
+	cache.GetShapedLine( CStringPart( "AAAA" ) );
+	GIN_CHECK( cache.GetShapingCacheStatistics().MissCount == 7 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+GIN_TEST( GlyphCacheLayoutMatchesShapedLine )
+{
+	int kerningCallCount = 0;
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( true, &kerningCallCount ) );
+	CArray<CTextLayoutGlyph> glyphs;
+	glyphs.IncreaseSize( 8 );
+	CArray<CTextLayoutLine> lines;
+	lines.IncreaseSize( 2 );
+	const auto result = cache.LayoutText( CUnicodePart( L"AVAVoT" ), 1000, 10, 0, glyphs, lines );
+	GIN_CHECK( result.GlyphCount == 6 );
+	GIN_CHECK( result.LineCount == 1 );
+
+	const auto& shapedLine = cache.GetShapedLine( CUnicodePart( L"AVAVoT" ) );
+	for( int i = 0; i < result.GlyphCount; i++ ) {
+		GIN_CHECK( glyphs[i].GlyphCode == shapedLine.Glyphs[i].GlyphCode );
+		GIN_CHECK( glyphs[i].Position.X() == shapedLine.Glyphs[i].Position.X() );
+		GIN_CHECK( glyphs[i].Position.Y() == shapedLine.Glyphs[i].Position.Y() );
+	}
+	GIN_CHECK( result.EndOffset.X() == shapedLine.EndOffset.X() );
+	GIN_CHECK( lines[0].GlyphCount == 6 );
+	GIN_CHECK( lines[0].Width == shapedLine.EndOffset.X() );
+}
+
+GIN_TEST( GlyphCacheLayoutWrapsWords )
+{
+	int kerningCallCount = 0;
+	CGlyphCache cache;
+	cache.SetGlyphProvider( CreateOwner<CKerningGlyphProvider>( true, &kerningCallCount ) );
+	const int lineHeight = 10;
+	const int wordWidth = CKerningGlyphProvider::GetAdvance( 'A' ) + getExpectedKerning( 'A', 'V' ) + CKerningGlyphProvider::GetAdvance( 'V' );
+	const int spaceWidth = CKerningGlyphProvider::GetAdvance( ' ' );
+	// Two words do not fit on a line.
+	const int lineWidth = 2 * wordWidth + spaceWidth - 1;
+	CArray<CTextLayoutGlyph> glyphs;
+	glyphs.IncreaseSize( 10 );
+	CArray<CTextLayoutLine> lines;
+	lines.IncreaseSize( 4 );
+	const auto result = cache.LayoutText( CUnicodePart( L"AV AV\nAV" ), lineWidth, lineHeight, 0, glyphs, lines );
+	GIN_CHECK( result.GlyphCount == 6 );
+	GIN_CHECK( result.LineCount == 3 );
+	for( int line = 0; line < 3; line++ ) {
+		GIN_CHECK( lines[line].FirstGlyph == 2 * line );
+		GIN_CHECK( lines[line].GlyphCount == 2 );
+		GIN_CHECK( lines[line].Width == wordWidth );
+		// Each word starts a line and keeps its kerning.
+		const auto& first = glyphs[2 * line];
+		const auto& second = glyphs[2 * line + 1];
+		GIN_CHECK( first.GlyphCode == 'A' && second.GlyphCode == 'V' );
+		GIN_CHECK( first.Position.X() == 0 && first.Position.Y() == -line * lineHeight );
+		GIN_CHECK( second.Position.X() == CKerningGlyphProvider::GetAdvance( 'A' ) + getExpectedKerning( 'A', 'V' ) );
+		GIN_CHECK( second.Position.Y() == first.Position.Y() );
+	}
+	GIN_CHECK( glyphs[2].StrPos == 3 && glyphs[4].StrPos == 6 );
+
+	// Counts include the glyphs and the lines that do not fit into the storage.
+	CArray<CTextLayoutGlyph> fewGlyphs;
+	fewGlyphs.IncreaseSize( 3 );
+	CArray<CTextLayoutLine> fewLines;
+	fewLines.IncreaseSize( 1 );
+	const auto truncatedResult = cache.LayoutText( CUnicodePart( L"AV AV\nAV" ), lineWidth, lineHeight, 0, fewGlyphs, fewLines );
+	GIN_CHECK( truncatedResult.GlyphCount == 6 );
+	GIN_CHECK( truncatedResult.LineCount == 3 );
+	GIN_CHECK( fewGlyphs[2].GlyphCode == 'A' && fewGlyphs[2].Position.Y() == -lineHeight );
+	GIN_CHECK( fewLines[0].GlyphCount == 2 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,102 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <RecordingImageEncoder.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+static CImageEncodeJob createJob( int width, int height )
+{
+	CImageEncodeJob job;
+	job.Size = CVector2<int>( width, height );
+	job.Pixels.IncreaseSize( CeilTo( width * 3, sizeof( DWORD ) ) * height );
+	return job;
+}
+
+GIN_TEST( ImageEncodeQueueWritesJobsInOrder )
+{
+	CRecordingEncoder encoder( true );
+	CImageEncodeQueue queue( 1, 2, &encoder );
+	GIN_CHECK( queue.GetWorkerCount() == 1 );
+	// The producer is blocked while the queue is full.
+	for( int i = 0; i < 6; i++ ) {
+		queue.AddJob( createJob( i + 1, 2 ) );
+	}
+	queue.Flush();
+	GIN_CHECK( queue.GetJobCount() == 0 );
+	GIN_CHECK( encoder.HasEncodedJobs( 6 ) );
+
+	const CImageEncodeStatistics statistics = queue.GetStatistics();
+	GIN_CHECK( statistics.WrittenCount == 6 );
+	GIN_CHECK( statistics.FailedCount == 0 );
+	GIN_CHECK( statistics.RejectedCount == 0 );
+	GIN_CHECK( statistics.WrittenPixelCount == 2 * ( 1 + 2 + 3 + 4 + 5 + 6 ) );
+}
+
+GIN_TEST( ImageEncodeQueueRejectsJobsWhenFull )
+{
+	CRecordingEncoder encoder( false );
+	CImageEncodeQueue queue( 1, 2, &encoder );
+	CImageEncodeJob first = createJob( 4, 4 );
+	GIN_CHECK( queue.TryAddJob( first ) );
+	// The worker holds the first job and the second one waits in the queue.
+	encoder.WaitForStartedJobs( 1 );
+	CImageEncodeJob second = createJob( 4, 4 );
+	GIN_CHECK( queue.TryAddJob( second ) );
+	GIN_CHECK( queue.GetJobCount() == 2 );
+
+	CImageEncodeJob rejected = createJob( 4, 4 );
+	GIN_CHECK( !queue.TryAddJob( rejected ) );
+	// The rejected job is left untouched and can be retried.
+	GIN_CHECK( rejected.Pixels.Size() == 48 );
+	GIN_CHECK( queue.GetStatistics().RejectedCount == 1 );
+
+	encoder.Open();
+	queue.Flush();
+	GIN_CHECK( queue.TryAddJob( rejected ) );
+	queue.Flush();
+	GIN_CHECK( encoder.HasEncodedJobs( 3 ) );
+	GIN_CHECK( queue.GetStatistics().WrittenCount == 3 );
+}
+
+GIN_TEST( ImageEncodeQueueCountsFailedJobs )
+{
+	CRecordingEncoder encoder( true, 1 );
+	CImageEncodeQueue queue( 2, 4, &encoder );
+	queue.AddJob( createJob( 2, 2 ) );
+	queue.AddJob( createJob( 2, 2 ) );
+	queue.AddJob( createJob( 2, 2 ) );
+	queue.Flush();
+
+	const CImageEncodeStatistics statistics = queue.GetStatistics();
+	GIN_CHECK( statistics.WrittenCount == 2 );
+	GIN_CHECK( statistics.FailedCount == 1 );
+	GIN_CHECK( statistics.WrittenPixelCount == 8 );
+}
+
+GIN_TEST( ImageEncodeQueueWritesRemainingJobsOnShutdown )
+{
+	CRecordingEncoder encoder( false );
+	{
+		CImageEncodeQueue queue( 1, 4, &encoder );
+		for( int i = 0; i < 4; i++ ) {
+			queue.AddJob( createJob( 2, 2 ) );
+		}
+		encoder.WaitForStartedJobs( 1 );
+		GIN_CHECK( queue.GetJobCount() == 4 );
+		// The queue is destroyed while the jobs are still queued.
+		encoder.Open();
+	}
+	GIN_CHECK( encoder.HasEncodedJobs( 4 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
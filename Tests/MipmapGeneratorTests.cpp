@@ -0,0 +1,189 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <MipmapGenerator.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Create an image with the full mipmap chain and fill its first level with the given pixels.
+static CImageData createImage( int width, int height, TTexelFormat format, const BYTE* pixels )
+{
+	const int channelCount = format == TF_Red ? 1 : 4;
+	CImageData result( TT_Texture2D, width, height, 1, format, TDT_UnsignedByte, CMipmapGenerator::GetFullMipmapCount( width, height ), 1 );
+	memcpy( result.GetMipmapData( 0 ).Ptr(), pixels, width * height * channelCount );
+	return result;
+}
+
+static bool isNear( int value, int expected, int tolerance )
+{
+	return abs( value - expected ) <= tolerance;
+}
+
+GIN_TEST( MipmapGeneratorCountsFullChain )
+{
+	GIN_CHECK( CMipmapGenerator::GetFullMipmapCount( 1, 1 ) == 1 );
+	GIN_CHECK( CMipmapGenerator::GetFullMipmapCount( 2, 2 ) == 2 );
+	GIN_CHECK( CMipmapGenerator::GetFullMipmapCount( 256, 256 ) == 9 );
+	GIN_CHECK( CMipmapGenerator::GetFullMipmapCount( 256, 1 ) == 9 );
+	GIN_CHECK( CMipmapGenerator::GetFullMipmapCount( 37, 20 ) == 6 );
+}
+
+GIN_TEST( MipmapGeneratorAveragesBoxPixels )
+{
+	const BYTE pixels[] = {
+		0, 100, 255, 255,	10, 100, 0, 255,
+		20, 200, 255, 255,	30, 200, 0, 255
+	};
+	auto image = createImage( 2, 2, TF_RGBA, pixels );
+	CMipmapGenerator generator;
+	generator.GenerateMipmaps( image );
+
+	const BYTE* result = image.GetMipmapData( 1 ).Ptr();
+	GIN_CHECK( result[0] == 15 );
+	GIN_CHECK( result[1] == 150 );
+	GIN_CHECK( result[2] == 128 );
+	GIN_CHECK( result[3] == 255 );
+
+	const BYTE redPixels[] = { 0, 40, 80, 120 };
+	auto redImage = createImage( 2, 2, TF_Red, redPixels );
+	generator.GenerateMipmaps( redImage );
+	GIN_CHECK( redImage.GetMipmapData( 1 )[0] == 60 );
+}
+
+GIN_TEST( MipmapGeneratorCoversOddSizes )
+{
+	// Each destination pixel of a five pixel row covers two and a half source pixels.
+	const BYTE pixels[] = { 0, 50, 100, 150, 200 };
+	auto image = createImage( 5, 1, TF_Red, pixels );
+	CMipmapGenerator generator;
+	generator.GenerateMipmaps( image );
+	GIN_CHECK( image.GetMipmapCount() == 3 );
+	GIN_CHECK( image.GetMipmapData( 1 )[0] == 40 );
+	GIN_CHECK( image.GetMipmapData( 1 )[1] == 160 );
+	GIN_CHECK( image.GetMipmapData( 2 )[0] == 100 );
+}
+
+GIN_TEST( MipmapGeneratorKeepsConstantImages )
+{
+	const int width = 37;
+	const int height = 20;
+	CArray<BYTE> pixels;
+	for( int i = 0; i < width * height; i++ ) {
+		pixels.Add( 100 );
+		pixels.Add( 50 );
+		pixels.Add( 200 );
+		pixels.Add( 255 );
+	}
+	const TMipmapFilter filters[] = { MF_Box, MF_Kaiser };
+	for( auto filter : filters ) {
+		for( int srgb = 0; srgb < 2; srgb++ ) {
+			auto image = createImage( width, height, TF_RGBA, pixels.Ptr() );
+			CMipmapGenerator generator;
+			generator.SetFilter( filter );
+			generator.SetSrgb( srgb != 0 );
+			generator.SetWorkerCount( 3 );
+			generator.GenerateMipmaps( image );
+
+			int mismatchCount = 0;
+			for( int level = 1; level < image.GetMipmapCount(); level++ ) {
+				const auto& levelData = image.GetMipmapData( level );
+				for( int i = 0; i < levelData.Size(); i += 4 ) {
+					if( levelData[i] != 100 || levelData[i + 1] != 50 || levelData[i + 2] != 200 || levelData[i + 3] != 255 ) {
+						mismatchCount++;
+					}
+				}
+			}
+			GIN_CHECK( mismatchCount == 0 );
+		}
+	}
+}
+
+GIN_TEST( MipmapGeneratorAveragesSrgbInLinearSpace )
+{
+	const BYTE pixels[] = {
+		0, 0, 0, 0,			255, 255, 255, 255,
+		0, 0, 0, 0,			255, 255, 255, 255
+	};
+	auto linearImage = createImage( 2, 2, TF_RGBA, pixels );
+	CMipmapGenerator generator;
+	generator.GenerateMipmaps( linearImage );
+	GIN_CHECK( linearImage.GetMipmapData( 1 )[0] == 128 );
+
+	// Half of the linear intensity is 188 in sRGB. Alpha is averaged linearly.
+	auto srgbImage = createImage( 2, 2, TF_RGBA, pixels );
+	generator.SetSrgb( true );
+	generator.GenerateMipmaps( srgbImage );
+	const BYTE* result = srgbImage.GetMipmapData( 1 ).Ptr();
+	GIN_CHECK( isNear( result[0], 188, 1 ) );
+	GIN_CHECK( result[0] == result[1] && result[1] == result[2] );
+	GIN_CHECK( result[3] == 128 );
+}
+
+// Fraction of the pixels of the level with alpha above the reference.
+static float getAlphaCoverage( const CImageData& image, int level, int referenceAlpha )
+{
+	const auto levelData = image.GetMipmapData( level );
+	int coveredCount = 0;
+	for( int i = 3; i < levelData.Size(); i += 4 ) {
+		if( levelData[i] > referenceAlpha ) {
+			coveredCount++;
+		}
+	}
+	return static_cast<float>( coveredCount ) * 4 / levelData.Size();
+}
+
+GIN_TEST( MipmapGeneratorPreservesAlphaCoverage )
+{
+	// Noisy alpha is averaged towards the middle value, so the coverage above a high reference shrinks on each level.
+	const int size = 64;
+	const int referenceAlpha = 178;
+	CArray<BYTE> pixels;
+	unsigned noise = 1;
+	for( int i = 0; i < size * size; i++ ) {
+		noise = noise * 1664525 + 1013904223;
+		pixels.Add( 255 );
+		pixels.Add( 255 );
+		pixels.Add( 255 );
+		pixels.Add( static_cast<BYTE>( noise >> 24 ) );
+	}
+	auto plainImage = createImage( size, size, TF_RGBA, pixels.Ptr() );
+	auto preservedImage = createImage( size, size, TF_RGBA, pixels.Ptr() );
+	CMipmapGenerator generator;
+	generator.GenerateMipmaps( plainImage );
+	generator.SetAlphaCoveragePreservation( true, referenceAlpha / 255.0f );
+	generator.GenerateMipmaps( preservedImage );
+
+	const float coverage = getAlphaCoverage( preservedImage, 0, referenceAlpha );
+	GIN_CHECK( getAlphaCoverage( plainImage, 2, referenceAlpha ) < coverage / 2 );
+	for( int level = 1; level <= 4; level++ ) {
+		GIN_CHECK( fabsf( getAlphaCoverage( preservedImage, level, referenceAlpha ) - coverage ) < 0.05f );
+	}
+}
+
+GIN_TEST( MipmapGeneratorCreatesMipmappedImage )
+{
+	const BYTE pixels[] = {
+		10, 20, 30, 40,		50, 60, 70, 80,		90, 100, 110, 120,	130, 140, 150, 160
+	};
+	CImageData source( TT_Texture2D, 4, 1, 1, TF_RGBA, TDT_UnsignedByte, 1, 1 );
+	memcpy( source.GetMipmapData( 0 ).Ptr(), pixels, sizeof( pixels ) );
+
+	CMipmapGenerator generator;
+	const auto result = generator.CreateMipmappedImage( source );
+	GIN_CHECK( result.GetMipmapCount() == 3 );
+	GIN_CHECK( memcmp( result.GetImageData( 0 ), pixels, sizeof( pixels ) ) == 0 );
+	const BYTE* lastLevel = result.GetImageData( 2 );
+	GIN_CHECK( lastLevel[0] == 70 && lastLevel[1] == 80 && lastLevel[2] == 90 && lastLevel[3] == 100 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
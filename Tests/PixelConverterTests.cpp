@@ -0,0 +1,267 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <PixelConverter.h>
+#include <ImageData.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Fill RGBA8 pixels with every byte value in every channel.
+static void fillAllByteValues( CArray<BYTE>& result )
+{
+	result.Empty();
+	for( int i = 0; i < 256; i++ ) {
+		result.Add( static_cast<BYTE>( i ) );
+		result.Add( static_cast<BYTE>( 255 - i ) );
+		result.Add( static_cast<BYTE>( i * 7 ) );
+		result.Add( static_cast<BYTE>( i * 13 ) );
+	}
+}
+
+static WORD getHalf( const BYTE* halfPixels, int pos )
+{
+	return static_cast<WORD>( halfPixels[pos * 2] | ( halfPixels[pos * 2 + 1] << 8 ) );
+}
+
+GIN_TEST( PixelConverterReordersByteChannels )
+{
+	CPixelConverter converter;
+	// Seven pixels are processed both as whole registers and one by one.
+	const BYTE rgbaPixels[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28 };
+	BYTE bgraPixels[28];
+	converter.ConvertPixels( rgbaPixels, PF_RGBA8, bgraPixels, PF_BGRA8, 7 );
+	for( int i = 0; i < 7; i++ ) {
+		GIN_CHECK( bgraPixels[i * 4] == rgbaPixels[i * 4 + 2] && bgraPixels[i * 4 + 1] == rgbaPixels[i * 4 + 1] );
+		GIN_CHECK( bgraPixels[i * 4 + 2] == rgbaPixels[i * 4] && bgraPixels[i * 4 + 3] == rgbaPixels[i * 4 + 3] );
+	}
+	BYTE restoredPixels[28];
+	converter.ConvertPixels( bgraPixels, PF_BGRA8, restoredPixels, PF_RGBA8, 7 );
+	GIN_CHECK( memcmp( restoredPixels, rgbaPixels, sizeof( rgbaPixels ) ) == 0 );
+
+	// Missing color channels are zero and missing alpha is opaque.
+	const BYTE rgPixels[] = { 10, 20, 30, 40 };
+	BYTE bgrPixels[6];
+	converter.ConvertPixels( rgPixels, PF_RG8, bgrPixels, PF_BGR8, 2 );
+	const BYTE expectedBgrPixels[] = { 0, 20, 10, 0, 40, 30 };
+	GIN_CHECK( memcmp( bgrPixels, expectedBgrPixels, sizeof( bgrPixels ) ) == 0 );
+	BYTE opaquePixels[8];
+	converter.ConvertPixels( rgPixels, PF_RG8, opaquePixels, PF_RGBA8, 2 );
+	const BYTE expectedOpaquePixels[] = { 10, 20, 0, 255, 30, 40, 0, 255 };
+	GIN_CHECK( memcmp( opaquePixels, expectedOpaquePixels, sizeof( opaquePixels ) ) == 0 );
+	BYTE redPixels[2];
+	converter.ConvertPixels( rgbaPixels, PF_RGBA8, redPixels, PF_R8, 2 );
+	GIN_CHECK( redPixels[0] == 1 && redPixels[1] == 5 );
+}
+
+GIN_TEST( PixelConverterRoundTripsFloatFormats )
+{
+	CPixelConverter converter;
+	CArray<BYTE> pixels;
+	fillAllByteValues( pixels );
+	const int pixelCount = pixels.Size() / 4;
+
+	CArray<float> floatPixels;
+	floatPixels.IncreaseSize( pixelCount * 4 );
+	converter.ConvertPixels( pixels.Ptr(), PF_RGBA8, reinterpret_cast<BYTE*>( floatPixels.Ptr() ), PF_RGBA32F, pixelCount );
+	GIN_CHECK( floatPixels[0] == 0.0f && floatPixels[1] == 1.0f );
+	GIN_CHECK( fabsf( floatPixels[4 * 51] - 0.2f ) < 1e-6f );
+
+	const TPixelFormat destFormats[] = { PF_RGBA8, PF_BGRA8 };
+	for( auto destFormat : destFormats ) {
+		CArray<BYTE> restoredPixels;
+		restoredPixels.IncreaseSize( pixels.Size() );
+		converter.ConvertPixels( reinterpret_cast<const BYTE*>( floatPixels.Ptr() ), PF_RGBA32F, restoredPixels.Ptr(), destFormat, pixelCount );
+		CArray<BYTE> rgbaPixels;
+		rgbaPixels.IncreaseSize( pixels.Size() );
+		converter.ConvertPixels( restoredPixels.Ptr(), destFormat, rgbaPixels.Ptr(), PF_RGBA8, pixelCount );
+		GIN_CHECK( memcmp( rgbaPixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+	}
+
+	// Half floats have enough precision for every 8-bit value.
+	CArray<BYTE> halfPixels;
+	halfPixels.IncreaseSize( pixelCount * CPixelConverter::GetPixelSize( PF_RGBA16F ) );
+	converter.ConvertPixels( pixels.Ptr(), PF_RGBA8, halfPixels.Ptr(), PF_RGBA16F, pixelCount );
+	GIN_CHECK( getHalf( halfPixels.Ptr(), 0 ) == 0 && getHalf( halfPixels.Ptr(), 1 ) == 0x3C00 );
+	CArray<BYTE> restoredPixels;
+	restoredPixels.IncreaseSize( pixels.Size() );
+	converter.ConvertPixels( halfPixels.Ptr(), PF_RGBA16F, restoredPixels.Ptr(), PF_RGBA8, pixelCount );
+	GIN_CHECK( memcmp( restoredPixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+}
+
+GIN_TEST( PixelConverterEncodesHalfFloats )
+{
+	CPixelConverter converter;
+	const unsigned nanBits = 0x7FC00000;
+	float nan;
+	memcpy( &nan, &nanBits, sizeof( nan ) );
+	const float values[] = { 1.0f, 0.5f, -2.0f, 65504.0f, 70000.0f, 1.0f / ( 1 << 24 ), 1.0f / ( 1 << 26 ), nan };
+	const WORD expectedHalves[] = { 0x3C00, 0x3800, 0xC000, 0x7BFF, 0x7C00, 0x0001, 0x0000, 0x7E00 };
+	BYTE halfPixels[16];
+	converter.ConvertPixels( reinterpret_cast<const BYTE*>( values ), PF_RGBA32F, halfPixels, PF_RGBA16F, 2 );
+	for( int i = 0; i < 8; i++ ) {
+		GIN_CHECK( getHalf( halfPixels, i ) == expectedHalves[i] );
+	}
+
+	// Denormal halves are decoded exactly.
+	float decodedValues[8];
+	converter.ConvertPixels( halfPixels, PF_RGBA16F, reinterpret_cast<BYTE*>( decodedValues ), PF_RGBA32F, 2 );
+	GIN_CHECK( decodedValues[0] == 1.0f && decodedValues[2] == -2.0f && decodedValues[3] == 65504.0f );
+	GIN_CHECK( decodedValues[5] == 1.0f / ( 1 << 24 ) );
+	GIN_CHECK( decodedValues[7] != decodedValues[7] );
+}
+
+GIN_TEST( PixelConverterClampsNormalizedValues )
+{
+	CPixelConverter converter;
+	const unsigned nanBits = 0x7FC00000;
+	float nan;
+	memcpy( &nan, &nanBits, sizeof( nan ) );
+	// Five pixels are processed both as a whole register and one by one.
+	float values[20];
+	for( int i = 0; i < 5; i++ ) {
+		values[i * 4] = -1.0f;
+		values[i * 4 + 1] = 2.0f;
+		values[i * 4 + 2] = nan;
+		values[i * 4 + 3] = 0.5f;
+	}
+	BYTE pixels[20];
+	converter.ConvertPixels( reinterpret_cast<const BYTE*>( values ), PF_RGBA32F, pixels, PF_RGBA8, 5 );
+	for( int i = 0; i < 5; i++ ) {
+		GIN_CHECK( pixels[i * 4] == 0 && pixels[i * 4 + 1] == 255 && pixels[i * 4 + 2] == 0 && pixels[i * 4 + 3] == 128 );
+	}
+}
+
+GIN_TEST( PixelConverterRoundTripsPackedColors )
+{
+	CPixelConverter converter;
+	// Every 5:6:5 value survives the round trip through RGBA8.
+	CArray<BYTE> packedPixels;
+	for( int i = 0; i < 65536; i++ ) {
+		packedPixels.Add( static_cast<BYTE>( i ) );
+		packedPixels.Add( static_cast<BYTE>( i >> 8 ) );
+	}
+	CArray<BYTE> rgbaPixels;
+	rgbaPixels.IncreaseSize( 65536 * 4 );
+	converter.ConvertPixels( packedPixels.Ptr(), PF_RGB565, rgbaPixels.Ptr(), PF_RGBA8, 65536 );
+	GIN_CHECK( rgbaPixels[0xF800 * 4] == 255 && rgbaPixels[0xF800 * 4 + 1] == 0 && rgbaPixels[0xF800 * 4 + 3] == 255 );
+	GIN_CHECK( rgbaPixels[0x07E0 * 4 + 1] == 255 && rgbaPixels[0x001F * 4 + 2] == 255 );
+	CArray<BYTE> restoredPixels;
+	restoredPixels.IncreaseSize( 65536 * 2 );
+	converter.ConvertPixels( rgbaPixels.Ptr(), PF_RGBA8, restoredPixels.Ptr(), PF_RGB565, 65536 );
+	GIN_CHECK( memcmp( restoredPixels.Ptr(), packedPixels.Ptr(), packedPixels.Size() ) == 0 );
+
+	// Channels are rounded to nearest.
+	const BYTE orangePixel[] = { 255, 128, 0, 255 };
+	BYTE packedPixel[2];
+	converter.ConvertPixels( orangePixel, PF_RGBA8, packedPixel, PF_RGB565, 1 );
+	GIN_CHECK( packedPixel[0] == 0x00 && packedPixel[1] == 0xFC );
+}
+
+GIN_TEST( PixelConverterConvertsSrgb )
+{
+	CPixelConverter converter;
+	converter.SetSourceSrgb( true );
+	CArray<BYTE> pixels;
+	fillAllByteValues( pixels );
+	const int pixelCount = pixels.Size() / 4;
+
+	// Colors are linearized and alpha is kept. Every 8-bit color survives the round trip.
+	CArray<float> linearPixels;
+	linearPixels.IncreaseSize( pixelCount * 4 );
+	converter.ConvertPixels( pixels.Ptr(), PF_RGBA8, reinterpret_cast<BYTE*>( linearPixels.Ptr() ), PF_RGBA32F, pixelCount );
+	GIN_CHECK( fabsf( linearPixels[4 * 188] - 0.5029f ) < 1e-3f );
+	GIN_CHECK( fabsf( linearPixels[4 * 188 + 3] - ( 188 * 13 % 256 ) / 255.0f ) < 1e-6f );
+
+	converter.SetSourceSrgb( false );
+	converter.SetDestSrgb( true );
+	CArray<BYTE> restoredPixels;
+	restoredPixels.IncreaseSize( pixels.Size() );
+	converter.ConvertPixels( reinterpret_cast<const BYTE*>( linearPixels.Ptr() ), PF_RGBA32F, restoredPixels.Ptr(), PF_RGBA8, pixelCount );
+	GIN_CHECK( memcmp( restoredPixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+
+	// The same color space on both sides does not change the values.
+	converter.SetSourceSrgb( true );
+	converter.ConvertPixels( pixels.Ptr(), PF_RGBA8, restoredPixels.Ptr(), PF_RGBA8, pixelCount );
+	GIN_CHECK( memcmp( restoredPixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+}
+
+GIN_TEST( PixelConverterConvertsAlpha )
+{
+	CPixelConverter converter;
+	const BYTE pixels[] = { 200, 100, 50, 128,	10, 20, 30, 0,	90, 80, 70, 255 };
+	BYTE premultipliedPixels[12];
+	converter.SetAlphaConversion( AC_Premultiply );
+	converter.ConvertPixels( pixels, PF_RGBA8, premultipliedPixels, PF_RGBA8, 3 );
+	const BYTE expectedPremultiplied[] = { 100, 50, 25, 128,	0, 0, 0, 0,		90, 80, 70, 255 };
+	GIN_CHECK( memcmp( premultipliedPixels, expectedPremultiplied, sizeof( premultipliedPixels ) ) == 0 );
+
+	BYTE restoredPixels[12];
+	converter.SetAlphaConversion( AC_Unpremultiply );
+	converter.ConvertPixels( premultipliedPixels, PF_RGBA8, restoredPixels, PF_BGRA8, 3 );
+	const BYTE expectedRestored[] = { 50, 100, 199, 128,	0, 0, 0, 0,		70, 80, 90, 255 };
+	GIN_CHECK( memcmp( restoredPixels, expectedRestored, sizeof( restoredPixels ) ) == 0 );
+
+	// sRGB colors are premultiplied in linear space.
+	const BYTE whitePixel[] = { 255, 255, 255, 128 };
+	BYTE premultipliedWhite[4];
+	converter.SetAlphaConversion( AC_Premultiply );
+	converter.SetSourceSrgb( true );
+	converter.SetDestSrgb( true );
+	converter.ConvertPixels( whitePixel, PF_RGBA8, premultipliedWhite, PF_RGBA8, 1 );
+	GIN_CHECK( abs( premultipliedWhite[0] - 188 ) <= 1 && premultipliedWhite[3] == 128 );
+}
+
+GIN_TEST( PixelConverterFindsFormats )
+{
+	for( int i = PF_R8; i < PF_EnumCount; i++ ) {
+		const auto format = static_cast<TPixelFormat>( i );
+		TTexelFormat texelFormat;
+		TTexelDataType dataType;
+		CPixelConverter::GetTexelFormat( format, texelFormat, dataType );
+		GIN_CHECK( CPixelConverter::FindPixelFormat( texelFormat, dataType ) == format );
+	}
+	GIN_CHECK( CPixelConverter::FindPixelFormat( TF_RGBA, TDT_UnsignedShort ) == PF_Unknown );
+	GIN_CHECK( CPixelConverter::GetPixelSize( PF_RGB565 ) == 2 );
+	GIN_CHECK( CPixelConverter::GetPixelSize( PF_RGBA32F ) == 16 );
+}
+
+GIN_TEST( PixelConverterConvertsImages )
+{
+	CImageData image( TT_Texture2D, 3, 3, 1, TF_RGBA, TDT_UnsignedByte, 2, 1 );
+	for( int level = 0; level < 2; level++ ) {
+		auto& levelData = image.GetMipmapData( level );
+		for( int i = 0; i < levelData.Size(); i++ ) {
+			levelData[i] = static_cast<BYTE>( level * 100 + i );
+		}
+	}
+
+	CPixelConverter converter;
+	converter.SetWorkerCount( 2 );
+	const auto result = converter.ConvertImage( image, PF_BGRA8 );
+	GIN_CHECK( result.GetTexelFormat() == TF_BGRA && result.GetTexelDataType() == TDT_UnsignedByte );
+	GIN_CHECK( result.GetMipmapCount() == 2 );
+	for( int level = 0; level < 2; level++ ) {
+		const BYTE* srcPixels = image.GetImageData( level );
+		const BYTE* destPixels = result.GetImageData( level );
+		const int byteCount = image.GetImageDataSize( level );
+		GIN_CHECK( result.GetImageDataSize( level ) == byteCount );
+		int mismatchCount = 0;
+		for( int i = 0; i < byteCount; i += 4 ) {
+			if( destPixels[i] != srcPixels[i + 2] || destPixels[i + 1] != srcPixels[i + 1] || destPixels[i + 2] != srcPixels[i] || destPixels[i + 3] != srcPixels[i + 3] ) {
+				mismatchCount++;
+			}
+		}
+		GIN_CHECK( mismatchCount == 0 );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,93 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <PixelReadbackPolicy.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+GIN_TEST( PixelReadbackPolicyReusesRingSlots )
+{
+	CPixelReadbackPolicy policy( 3 );
+	GIN_CHECK( policy.GetOldestPendingSlot() == NotFound );
+	GIN_CHECK( policy.AcquireSlot() == 0 );
+	GIN_CHECK( policy.AcquireSlot() == 1 );
+	GIN_CHECK( policy.AcquireSlot() == 2 );
+	GIN_CHECK( policy.GetPendingCount() == 3 );
+	GIN_CHECK( policy.GetSlotState( 1 ) == RSS_Pending );
+
+	// All the buffers are pending.
+	GIN_CHECK( policy.AcquireSlot() == NotFound );
+	GIN_CHECK( policy.GetStatistics().BufferShortageCount == 1 );
+
+	// The released slot is the next one in the ring, the oldest pending slot follows it.
+	GIN_CHECK( policy.GetOldestPendingSlot() == 0 );
+	policy.ReleaseSlot( 0, false );
+	GIN_CHECK( policy.GetSlotState( 0 ) == RSS_Free );
+	GIN_CHECK( policy.GetOldestPendingSlot() == 1 );
+	GIN_CHECK( policy.AcquireSlot() == 0 );
+	GIN_CHECK( policy.AcquireSlot() == NotFound );
+
+	policy.ReleaseSlot( 1, false );
+	policy.ReleaseSlot( 2, false );
+	GIN_CHECK( policy.GetOldestPendingSlot() == 0 );
+	GIN_CHECK( policy.AcquireSlot() == 1 );
+	policy.ReleaseSlot( 0, false );
+	policy.ReleaseSlot( 1, false );
+	GIN_CHECK( policy.GetPendingCount() == 0 );
+	GIN_CHECK( policy.GetOldestPendingSlot() == NotFound );
+	// The ring goes on from the last released slot.
+	GIN_CHECK( policy.AcquireSlot() == 2 );
+
+	GIN_CHECK( policy.GetStatistics().ReadbackCount == 6 );
+	GIN_CHECK( policy.GetStatistics().BufferShortageCount == 2 );
+	GIN_CHECK( policy.GetStatistics().StallCount == 0 );
+}
+
+GIN_TEST( PixelReadbackPolicyDelaysCompletion )
+{
+	CPixelReadbackPolicy policy( 4, 1, 3 );
+	GIN_CHECK( policy.FindCompletionCandidate() == NotFound );
+	const int first = policy.AcquireSlot();
+	// The GPU has no time to finish the readback during the frame it was issued.
+	GIN_CHECK( policy.FindCompletionCandidate() == NotFound );
+
+	policy.AdvanceFrame();
+	const int second = policy.AcquireSlot();
+	GIN_CHECK( policy.FindCompletionCandidate() == first );
+	GIN_CHECK( !policy.IsWaitRequired( first ) );
+
+	policy.AdvanceFrame();
+	policy.AdvanceFrame();
+	GIN_CHECK( policy.IsWaitRequired( first ) );
+	GIN_CHECK( !policy.IsWaitRequired( second ) );
+	policy.ReleaseSlot( first, true );
+	GIN_CHECK( policy.GetStatistics().StallCount == 1 );
+
+	// Only the oldest slot is a candidate.
+	GIN_CHECK( policy.FindCompletionCandidate() == second );
+	policy.ReleaseSlot( second, false );
+	GIN_CHECK( policy.FindCompletionCandidate() == NotFound );
+	GIN_CHECK( policy.GetStatistics().StallCount == 1 );
+}
+
+GIN_TEST( PixelReadbackPolicyCompletesImmediatelyWithoutDelay )
+{
+	CPixelReadbackPolicy policy( 2, 0, 0 );
+	const int slot = policy.AcquireSlot();
+	GIN_CHECK( policy.FindCompletionCandidate() == slot );
+	GIN_CHECK( policy.IsWaitRequired( slot ) );
+
+	policy.ResetStatistics();
+	GIN_CHECK( policy.GetStatistics().ReadbackCount == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
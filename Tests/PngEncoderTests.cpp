@@ -0,0 +1,468 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <PngEncoder.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Reader of the deflate bit stream. Reading past the end gives zero bits and marks the reader as overrun.
+class CInflateBitReader {
+public:
+	CInflateBitReader( const BYTE* _data, int _size ) : data( _data ), size( _size ) {}
+
+	bool IsOverrun() const
+		{ return bitPos > size * 8; }
+	int GetBytePos() const
+		{ return bitPos / 8; }
+
+	// Read a value stored starting from the lowest bit.
+	int ReadBits( int count );
+	// Append bits to a Huffman code. Huffman codes are stored starting from the highest bit.
+	int ReadCodeBits( int code, int count );
+	void AlignToByte()
+		{ bitPos = ( bitPos + 7 ) / 8 * 8; }
+	void SkipBytes( int count )
+		{ bitPos += count * 8; }
+
+private:
+	const BYTE* data;
+	int size;
+	int bitPos = 0;
+
+	int readBit();
+};
+
+int CInflateBitReader::ReadBits( int count )
+{
+	int result = 0;
+	for( int i = 0; i < count; i++ ) {
+		result |= readBit() << i;
+	}
+	return result;
+}
+
+int CInflateBitReader::ReadCodeBits( int code, int count )
+{
+	for( int i = 0; i < count; i++ ) {
+		code = ( code << 1 ) | readBit();
+	}
+	return code;
+}
+
+int CInflateBitReader::readBit()
+{
+	const int bit = bitPos < size * 8 ? ( data[bitPos / 8] >> ( bitPos % 8 ) ) & 1 : 0;
+	bitPos++;
+	return bit;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int lengthBases[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int lengthExtraBits[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int distanceBases[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+	1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int distanceExtraBits[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Decode a literal or length symbol of the fixed Huffman code.
+static int readFixedSymbol( CInflateBitReader& reader )
+{
+	int code = reader.ReadCodeBits( 0, 7 );
+	if( code < 0x18 ) {
+		return 256 + code;
+	}
+	code = reader.ReadCodeBits( code, 1 );
+	if( code >= 0x30 && code < 0xC0 ) {
+		return code - 0x30;
+	}
+	if( code >= 0xC0 && code < 0xC8 ) {
+		return 280 + code - 0xC0;
+	}
+	code = reader.ReadCodeBits( code, 1 );
+	return 144 + code - 0x190;
+}
+
+static bool inflateFixedBlock( CInflateBitReader& reader, CArray<BYTE>& result )
+{
+	for( ;; ) {
+		const int symbol = readFixedSymbol( reader );
+		if( reader.IsOverrun() ) {
+			return false;
+		}
+		if( symbol < 256 ) {
+			result.Add( static_cast<BYTE>( symbol ) );
+			continue;
+		}
+		if( symbol == 256 ) {
+			return true;
+		}
+		const int lengthSymbol = symbol - 257;
+		if( lengthSymbol >= 29 ) {
+			return false;
+		}
+		const int length = lengthBases[lengthSymbol] + reader.ReadBits( lengthExtraBits[lengthSymbol] );
+		const int distanceSymbol = reader.ReadCodeBits( 0, 5 );
+		if( distanceSymbol >= 30 ) {
+			return false;
+		}
+		const int distance = distanceBases[distanceSymbol] + reader.ReadBits( distanceExtraBits[distanceSymbol] );
+		if( distance > result.Size() ) {
+			return false;
+		}
+		for( int i = 0; i < length; i++ ) {
+			result.Add( result[result.Size() - distance] );
+		}
+	}
+}
+
+static bool inflateStoredBlock( CInflateBitReader& reader, const BYTE* data, int size, CArray<BYTE>& result )
+{
+	reader.AlignToByte();
+	const int pos = reader.GetBytePos();
+	if( pos + 4 > size ) {
+		return false;
+	}
+	const int length = data[pos] | ( data[pos + 1] << 8 );
+	const int lengthComplement = data[pos + 2] | ( data[pos + 3] << 8 );
+	if( ( length ^ lengthComplement ) != 0xFFFF || pos + 4 + length > size ) {
+		return false;
+	}
+	for( int i = 0; i < length; i++ ) {
+		result.Add( data[pos + 4 + i] );
+	}
+	reader.SkipBytes( 4 + length );
+	return true;
+}
+
+static DWORD readBigEndian( const BYTE* src )
+{
+	return ( static_cast<DWORD>( src[0] ) << 24 ) | ( src[1] << 16 ) | ( src[2] << 8 ) | src[3];
+}
+
+static DWORD getTestAdler32( const CArray<BYTE>& data )
+{
+	DWORD sum1 = 1;
+	DWORD sum2 = 0;
+	for( int i = 0; i < data.Size(); i++ ) {
+		sum1 = ( sum1 + data[i] ) % 65521;
+		sum2 = ( sum2 + sum1 ) % 65521;
+	}
+	return sum1 | ( sum2 << 16 );
+}
+
+// Number of deflate blocks of each type in a stream.
+struct CDeflateBlockCounts {
+	int StoredCount = 0;
+	int FixedCount = 0;
+};
+
+// Inflate a zlib stream. Only stored and fixed Huffman blocks are supported, those are the blocks written by the encoder.
+static bool inflateZlibStream( const CArray<BYTE>& stream, CArray<BYTE>& result, CDeflateBlockCounts& blockCounts )
+{
+	if( stream.Size() < 6 || stream[0] != 0x78 || ( stream[0] * 256 + stream[1] ) % 31 != 0 ) {
+		return false;
+	}
+	const BYTE* data = stream.Ptr() + 2;
+	const int size = stream.Size() - 2;
+	CInflateBitReader reader( data, size );
+	for( bool isFinal = false; !isFinal; ) {
+		isFinal = reader.ReadBits( 1 ) != 0;
+		const int blockType = reader.ReadBits( 2 );
+		bool isValid = false;
+		if( blockType == 0 ) {
+			blockCounts.StoredCount++;
+			isValid = inflateStoredBlock( reader, data, size, result );
+		} else if( blockType == 1 ) {
+			blockCounts.FixedCount++;
+			isValid = inflateFixedBlock( reader, result );
+		}
+		if( !isValid ) {
+			return false;
+		}
+	}
+	reader.AlignToByte();
+	const int checksumPos = reader.GetBytePos();
+	return checksumPos + 4 == size && readBigEndian( data + checksumPos ) == getTestAdler32( result );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static DWORD getTestCrc32( const BYTE* data, int size )
+{
+	DWORD crc = 0xFFFFFFFF;
+	for( int i = 0; i < size; i++ ) {
+		crc ^= data[i];
+		for( int bit = 0; bit < 8; bit++ ) {
+			crc = ( crc & 1 ) != 0 ? 0xEDB88320 ^ ( crc >> 1 ) : crc >> 1;
+		}
+	}
+	return ~crc;
+}
+
+static int getPaethPredictor( int left, int up, int upLeft )
+{
+	const int estimate = left + up - upLeft;
+	const int leftDistance = abs( estimate - left );
+	const int upDistance = abs( estimate - up );
+	const int upLeftDistance = abs( estimate - upLeft );
+	if( leftDistance <= upDistance && leftDistance <= upLeftDistance ) {
+		return left;
+	}
+	return upDistance <= upLeftDistance ? up : upLeft;
+}
+
+// Reverse the row filters. The result has the pixel rows without the filter type bytes.
+static bool unfilterRows( const CArray<BYTE>& filteredData, int width, int height, int pixelSize, CArray<BYTE>& result )
+{
+	const int rowSize = width * pixelSize;
+	if( filteredData.Size() != ( rowSize + 1 ) * height ) {
+		return false;
+	}
+	result.Empty();
+	result.IncreaseSize( rowSize * height );
+	for( int y = 0; y < height; y++ ) {
+		const int filterType = filteredData[y * ( rowSize + 1 )];
+		const BYTE* src = filteredData.Ptr() + y * ( rowSize + 1 ) + 1;
+		BYTE* row = result.Ptr() + y * rowSize;
+		const BYTE* prevRow = y > 0 ? row - rowSize : nullptr;
+		for( int i = 0; i < rowSize; i++ ) {
+			const int left = i >= pixelSize ? row[i - pixelSize] : 0;
+			const int up = prevRow != nullptr ? prevRow[i] : 0;
+			const int upLeft = prevRow != nullptr && i >= pixelSize ? prevRow[i - pixelSize] : 0;
+			int predictor = 0;
+			switch( filterType ) {
+			case 0:
+				break;
+			case 1:
+				predictor = left;
+				break;
+			case 2:
+				predictor = up;
+				break;
+			case 3:
+				predictor = ( left + up ) / 2;
+				break;
+			case 4:
+				predictor = getPaethPredictor( left, up, upLeft );
+				break;
+			default:
+				return false;
+			}
+			row[i] = static_cast<BYTE>( src[i] + predictor );
+		}
+	}
+	return true;
+}
+
+// Contents of a decoded PNG file.
+struct CDecodedPng {
+	int Width = 0;
+	int Height = 0;
+	int ColorType = 0;
+	int IdatChunkCount = 0;
+	CDeflateBlockCounts BlockCounts;
+	// Pixel rows without padding.
+	CArray<BYTE> Pixels;
+};
+
+// Decode an 8-bit RGB or RGBA file and check the chunk checksums.
+static bool decodePng( const CArray<BYTE>& file, CDecodedPng& result )
+{
+	const BYTE signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	if( file.Size() < 8 || memcmp( file.Ptr(), signature, sizeof( signature ) ) != 0 ) {
+		return false;
+	}
+	CArray<BYTE> stream;
+	bool hasHeader = false;
+	int pos = 8;
+	for( ;; ) {
+		if( pos + 12 > file.Size() ) {
+			return false;
+		}
+		const int chunkSize = static_cast<int>( readBigEndian( file.Ptr() + pos ) );
+		const BYTE* type = file.Ptr() + pos + 4;
+		const BYTE* data = type + 4;
+		if( pos + 12 + chunkSize > file.Size() || readBigEndian( data + chunkSize ) != getTestCrc32( type, chunkSize + 4 ) ) {
+			return false;
+		}
+		pos += 12 + chunkSize;
+		if( memcmp( type, "IHDR", 4 ) == 0 ) {
+			if( chunkSize != 13 || data[8] != 8 || data[10] != 0 || data[11] != 0 || data[12] != 0 ) {
+				return false;
+			}
+			result.Width = static_cast<int>( readBigEndian( data ) );
+			result.Height = static_cast<int>( readBigEndian( data + 4 ) );
+			result.ColorType = data[9];
+			hasHeader = true;
+		} else if( memcmp( type, "IDAT", 4 ) == 0 ) {
+			result.IdatChunkCount++;
+			for( int i = 0; i < chunkSize; i++ ) {
+				stream.Add( data[i] );
+			}
+		} else if( memcmp( type, "IEND", 4 ) == 0 ) {
+			break;
+		}
+	}
+	if( !hasHeader || pos != file.Size() || ( result.ColorType != 2 && result.ColorType != 6 ) ) {
+		return false;
+	}
+
+	CArray<BYTE> filteredData;
+	if( !inflateZlibStream( stream, filteredData, result.BlockCounts ) ) {
+		return false;
+	}
+	return unfilterRows( filteredData, result.Width, result.Height, result.ColorType == 2 ? 3 : 4, result.Pixels );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Create an image with smooth gradients and some noise, the content that the row filters are made for.
+static void createTestImage( int width, int height, int pixelSize, CArray<BYTE>& result )
+{
+	result.Empty();
+	unsigned noise = 1;
+	for( int y = 0; y < height; y++ ) {
+		for( int x = 0; x < width; x++ ) {
+			noise = noise * 1664525 + 1013904223;
+			result.Add( static_cast<BYTE>( x * 3 + y ) );
+			result.Add( static_cast<BYTE>( y * 5 ) );
+			result.Add( static_cast<BYTE>( ( x * y ) / 7 + ( noise >> 30 ) ) );
+			if( pixelSize == 4 ) {
+				result.Add( static_cast<BYTE>( x < width / 2 ? 255 : noise >> 24 ) );
+			}
+		}
+	}
+}
+
+static const TPngCompressionLevel compressionLevels[] = { PCL_Store, PCL_Fast };
+static const TPngFilterStrategy filterStrategies[] = { PFS_None, PFS_Sub, PFS_Up, PFS_Paeth, PFS_MinimumSum };
+
+GIN_TEST( PngEncoderRoundTripsAllSettings )
+{
+	const int width = 37;
+	const int height = 23;
+	const TTexelFormat formats[] = { TF_RGB, TF_RGBA };
+	for( auto format : formats ) {
+		const int pixelSize = format == TF_RGB ? 3 : 4;
+		CArray<BYTE> pixels;
+		createTestImage( width, height, pixelSize, pixels );
+		int storedFileSize = 0;
+		for( auto level : compressionLevels ) {
+			for( auto strategy : filterStrategies ) {
+				CPngEncoder encoder;
+				encoder.SetCompressionLevel( level );
+				encoder.SetFilterStrategy( strategy );
+				CArray<BYTE> file;
+				encoder.Encode( pixels, format, width * pixelSize, CVector2<int>( width, height ), file );
+
+				CDecodedPng png;
+				GIN_CHECK( decodePng( file, png ) );
+				GIN_CHECK( png.Width == width && png.Height == height );
+				GIN_CHECK( png.ColorType == ( format == TF_RGB ? 2 : 6 ) );
+				GIN_CHECK( png.Pixels.Size() == pixels.Size() && memcmp( png.Pixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+				// A single band and the separate checksum chunk.
+				GIN_CHECK( png.IdatChunkCount == 2 );
+				GIN_CHECK( png.BlockCounts.FixedCount + png.BlockCounts.StoredCount == 1 );
+				if( level == PCL_Store ) {
+					GIN_CHECK( png.BlockCounts.FixedCount == 0 );
+					storedFileSize = file.Size();
+				} else if( strategy != PFS_None ) {
+					// Filtered rows of the test image are compressible.
+					GIN_CHECK( png.BlockCounts.FixedCount == 1 && file.Size() < storedFileSize );
+				}
+			}
+		}
+	}
+}
+
+GIN_TEST( PngEncoderReadsBottomUpRows )
+{
+	const int width = 10;
+	const int height = 7;
+	// Rows are padded to a multiple of four bytes.
+	const int rowStride = 32;
+	CArray<BYTE> pixels;
+	createTestImage( width, height, 3, pixels );
+	CArray<BYTE> bottomUpPixels;
+	bottomUpPixels.IncreaseSize( rowStride * height );
+	for( int y = 0; y < height; y++ ) {
+		memcpy( bottomUpPixels.Ptr() + ( height - 1 - y ) * rowStride, pixels.Ptr() + y * width * 3, width * 3 );
+	}
+
+	CPngEncoder encoder;
+	CArray<BYTE> file;
+	encoder.Encode( bottomUpPixels, TF_RGB, -rowStride, CVector2<int>( width, height ), file );
+	CDecodedPng png;
+	GIN_CHECK( decodePng( file, png ) );
+	GIN_CHECK( png.Pixels.Size() == pixels.Size() && memcmp( png.Pixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+}
+
+GIN_TEST( PngEncoderJoinsMultipleBands )
+{
+	// Rows of 1201 filtered bytes make bands of 218 rows, the image is split into four bands.
+	const int width = 300;
+	const int height = 700;
+	CArray<BYTE> pixels;
+	createTestImage( width, height, 4, pixels );
+	for( auto level : compressionLevels ) {
+		CPngEncoder encoder;
+		encoder.SetCompressionLevel( level );
+		encoder.SetWorkerCount( 3 );
+		CArray<BYTE> file;
+		encoder.Encode( pixels, TF_RGBA, width * 4, CVector2<int>( width, height ), file );
+
+		CDecodedPng png;
+		GIN_CHECK( decodePng( file, png ) );
+		GIN_CHECK( png.Pixels.Size() == pixels.Size() && memcmp( png.Pixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+		GIN_CHECK( png.IdatChunkCount == 5 );
+		if( level == PCL_Store ) {
+			// Each band of 261818 bytes takes four stored blocks.
+			GIN_CHECK( png.BlockCounts.StoredCount == 13 && png.BlockCounts.FixedCount == 0 );
+		} else {
+			// Fixed Huffman bands except the last one are aligned with an empty stored block.
+			GIN_CHECK( png.BlockCounts.FixedCount == 4 && png.BlockCounts.StoredCount == 3 );
+		}
+	}
+}
+
+GIN_TEST( PngEncoderStoresIncompressibleBands )
+{
+	const int width = 64;
+	const int height = 64;
+	CArray<BYTE> pixels;
+	unsigned noise = 7;
+	for( int i = 0; i < width * height * 4; i++ ) {
+		noise = noise * 1664525 + 1013904223;
+		pixels.Add( static_cast<BYTE>( noise >> 24 ) );
+	}
+	CPngEncoder encoder;
+	encoder.SetFilterStrategy( PFS_None );
+	CArray<BYTE> file;
+	encoder.Encode( pixels, TF_RGBA, width * 4, CVector2<int>( width, height ), file );
+	CDecodedPng png;
+	GIN_CHECK( decodePng( file, png ) );
+	GIN_CHECK( png.BlockCounts.FixedCount == 0 && png.BlockCounts.StoredCount == 1 );
+	GIN_CHECK( png.Pixels.Size() == pixels.Size() && memcmp( png.Pixels.Ptr(), pixels.Ptr(), pixels.Size() ) == 0 );
+
+	// Constant images compress to a small fraction of their size.
+	for( int i = 0; i < pixels.Size(); i++ ) {
+		pixels[i] = 200;
+	}
+	encoder.SetFilterStrategy( PFS_Up );
+	encoder.Encode( pixels, TF_RGBA, width * 4, CVector2<int>( width, height ), file );
+	CDecodedPng constantPng;
+	GIN_CHECK( decodePng( file, constantPng ) );
+	GIN_CHECK( constantPng.BlockCounts.FixedCount == 1 );
+	GIN_CHECK( file.Size() < pixels.Size() / 20 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,80 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <RecordingImageEncoder.h>
+#include <CriticalSectionLock.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+CRecordingEncoder::CRecordingEncoder( bool _isOpen, int _failingIndex ) :
+	isOpen( _isOpen ),
+	failingIndex( _failingIndex )
+{
+	::InitializeCriticalSection( &lock );
+	::InitializeConditionVariable( &stateChanged );
+}
+
+CRecordingEncoder::~CRecordingEncoder()
+{
+	::DeleteCriticalSection( &lock );
+}
+
+void CRecordingEncoder::Open()
+{
+	{
+		CCriticalSectionLock encoderLock( lock );
+		isOpen = true;
+	}
+	::WakeAllConditionVariable( &stateChanged );
+}
+
+void CRecordingEncoder::WaitForStartedJobs( int count )
+{
+	CCriticalSectionLock encoderLock( lock );
+	while( startedCount < count ) {
+		::SleepConditionVariableCS( &stateChanged, &lock, INFINITE );
+	}
+}
+
+bool CRecordingEncoder::HasEncodedJobs( int count ) const
+{
+	CCriticalSectionLock encoderLock( lock );
+	if( encodedIndices.Size() != count ) {
+		return false;
+	}
+	for( int i = 0; i < count; i++ ) {
+		if( encodedIndices[i] != i ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CRecordingEncoder::EncodeImage( const CImageEncodeJob& job )
+{
+	{
+		CCriticalSectionLock encoderLock( lock );
+		startedCount++;
+	}
+	::WakeAllConditionVariable( &stateChanged );
+
+	CCriticalSectionLock encoderLock( lock );
+	while( !isOpen ) {
+		::SleepConditionVariableCS( &stateChanged, &lock, INFINITE );
+	}
+	if( job.Index == failingIndex ) {
+		return false;
+	}
+	encodedIndices.Add( job.Index );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,40 @@
+#pragma once
+#include <ImageEncodeQueue.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Encoder that records the encoded jobs instead of writing files.
+// A closed encoder blocks the workers until it is opened, so the test controls the number of active jobs.
+class CRecordingEncoder : public IImageEncoder {
+public:
+	// The job with the failing index is not written.
+	explicit CRecordingEncoder( bool _isOpen, int _failingIndex = NotFound );
+	~CRecordingEncoder();
+
+	// Let the blocked and the following jobs through.
+	void Open();
+	// Wait until the given number of jobs have entered the encoder.
+	void WaitForStartedJobs( int count );
+	// Check that the jobs from 0 to count - 1 have been written in the order of their indices.
+	bool HasEncodedJobs( int count ) const;
+
+	virtual bool EncodeImage( const CImageEncodeJob& job ) override final;
+
+private:
+	mutable CRITICAL_SECTION lock;
+	CONDITION_VARIABLE stateChanged;
+	bool isOpen;
+	const int failingIndex;
+	int startedCount = 0;
+	CArray<int> encodedIndices;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
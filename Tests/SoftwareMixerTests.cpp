@@ -0,0 +1,291 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <TestFramework.h>
+#include <SoftwareMixer.h>
+#include <AudioSequence.h>
+
+namespace Gin {
+
+namespace Tests {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+// Sink that keeps all the received samples.
+class CTestAudioSink : public IAudioSink {
+public:
+	CArray<float> Samples;
+	int SampleRate = 0;
+
+	virtual void WriteFrames( CArrayView<float> samples, int sampleRate ) override final;
+};
+
+void CTestAudioSink::WriteFrames( CArrayView<float> samples, int sampleRate )
+{
+	for( float sample : samples ) {
+		Samples.Add( sample );
+	}
+	SampleRate = sampleRate;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// The test buffers and the expected output consist of values that are exact in binary, so the mixer output is compared exactly.
+static bool isEqual( const CArray<float>& samples, int offset, const float* expected, int count )
+{
+	if( samples.Size() < offset + count ) {
+		return false;
+	}
+	for( int i = 0; i < count; i++ ) {
+		if( samples[offset + i] != expected[i] ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool isSilent( const CArray<float>& samples, int offset )
+{
+	for( int i = offset; i < samples.Size(); i++ ) {
+		if( samples[i] != 0.0f ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static unsigned createBuffer( CSoftwareMixer& mixer, TAudioDataFormat format, int frequency, const void* data, int size )
+{
+	unsigned bufferId;
+	mixer.CreateBuffers( 1, &bufferId );
+	mixer.SetBufferData( bufferId, format, frequency, data, size );
+	return bufferId;
+}
+
+static unsigned createSource( CSoftwareMixer& mixer, int bufferCount, const unsigned* bufferIds )
+{
+	const unsigned sourceId = mixer.CreateSource();
+	mixer.QueueBuffers( sourceId, bufferCount, bufferIds );
+	mixer.PlaySource( sourceId );
+	return sourceId;
+}
+
+GIN_TEST( SoftwareMixerPlaysStereoBuffers )
+{
+	auto sink = CreateOwner<CTestAudioSink>();
+	CTestAudioSink* sinkPtr = sink;
+	CSoftwareMixer mixer( move( sink ), 8000 );
+	const short samples[] = { 16384, -16384, 8192, 4096, -32768, 0, 0, 16384 };
+	const unsigned bufferId = createBuffer( mixer, ADF_Stereo16, 8000, samples, sizeof( samples ) );
+	GIN_CHECK( mixer.GetBufferDuration( bufferId ) == 4.0f / 8000 );
+	const unsigned sourceId = createSource( mixer, 1, &bufferId );
+	mixer.SetSourceGain( sourceId, 0.5f );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Playing );
+
+	// The output is passed to the sink in parts, silence follows the end of the queue.
+	mixer.Render( 3 );
+	mixer.Render( 3 );
+	const float expected[] = { 0.25f, -0.25f, 0.125f, 0.0625f, -0.5f, 0.0f, 0.0f, 0.25f };
+	GIN_CHECK( sinkPtr->Samples.Size() == 12 && sinkPtr->SampleRate == 8000 );
+	GIN_CHECK( isEqual( sinkPtr->Samples, 0, expected, 8 ) );
+	GIN_CHECK( isSilent( sinkPtr->Samples, 8 ) );
+	GIN_CHECK( mixer.GetMixedSourceCount() == 1 );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Stopped );
+	unsigned processedId = 0;
+	GIN_CHECK( mixer.UnqueueProcessedBuffers( sourceId, 1, &processedId ) == 1 && processedId == bufferId );
+	GIN_CHECK( mixer.GetQueuedBufferCount( sourceId ) == 0 );
+
+	// 8 bit samples are unsigned.
+	const BYTE bytes[] = { 192, 64, 128, 0 };
+	mixer.SetBufferData( bufferId, ADF_Stereo8, 8000, bytes, sizeof( bytes ) );
+	mixer.QueueBuffers( sourceId, 1, &bufferId );
+	mixer.PlaySource( sourceId );
+	CArray<float> result;
+	mixer.Mix( 2, result );
+	const float expectedBytes[] = { 0.25f, -0.25f, 0.0f, -0.5f };
+	GIN_CHECK( isEqual( result, 0, expectedBytes, 4 ) );
+}
+
+GIN_TEST( SoftwareMixerInterpolatesResampledBuffers )
+{
+	CSoftwareMixer mixer( CreateOwner<CNullAudioSink>(), 8000 );
+	const float samples[] = { 0.0f, 0.0f, 1.0f, -1.0f, 0.5f, 0.25f, -1.0f, 1.0f };
+	const unsigned bufferId = createBuffer( mixer, ADF_StereoFloat32, 4000, samples, sizeof( samples ) );
+	const unsigned sourceId = createSource( mixer, 1, &bufferId );
+
+	// The buffer is played at half the output rate. The last frame fades to silence.
+	// Splitting the output into parts doesn't change the result.
+	CArray<float> result;
+	mixer.Mix( 3, result );
+	mixer.Mix( 7, result );
+	const float expected[] = {
+		0.0f, 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 0.75f, -0.375f, 0.5f, 0.25f, -0.25f, 0.625f, -1.0f, 1.0f, -0.5f, 0.5f
+	};
+	GIN_CHECK( result.Size() == 20 );
+	GIN_CHECK( isEqual( result, 0, expected, 16 ) );
+	GIN_CHECK( isSilent( result, 16 ) );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Stopped );
+
+	// The pitch multiplies the step.
+	mixer.SetSourcePitch( sourceId, 2.0f );
+	mixer.PlaySource( sourceId );
+	result.Empty();
+	mixer.Mix( 5, result );
+	GIN_CHECK( isEqual( result, 0, samples, 8 ) );
+	GIN_CHECK( isSilent( result, 8 ) );
+}
+
+GIN_TEST( SoftwareMixerJoinsQueuedBuffers )
+{
+	CSoftwareMixer mixer( CreateOwner<CNullAudioSink>(), 8000 );
+	const float firstSamples[] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	const float secondSamples[] = { -1.0f, 0.5f, 0.5f, -1.0f };
+	unsigned bufferIds[2];
+	bufferIds[0] = createBuffer( mixer, ADF_StereoFloat32, 4000, firstSamples, sizeof( firstSamples ) );
+	bufferIds[1] = createBuffer( mixer, ADF_StereoFloat32, 4000, secondSamples, sizeof( secondSamples ) );
+	const unsigned sourceId = createSource( mixer, 2, bufferIds );
+
+	// The last frame of a buffer is interpolated with the start of the next one.
+	CArray<float> result;
+	mixer.Mix( 5, result );
+	const float expected[] = {
+		0.0f, 0.0f, 0.5f, 0.5f, 1.0f, 1.0f, 0.0f, 0.75f, -1.0f, 0.5f,
+		-0.25f, -0.25f, 0.5f, -1.0f, 0.5f, -0.25f, 0.5f, 0.5f, 0.25f, 0.25f
+	};
+	GIN_CHECK( isEqual( result, 0, expected, 10 ) );
+
+	// The processed buffer is refilled and queued again like in a stream.
+	unsigned processedId = 0;
+	GIN_CHECK( mixer.UnqueueProcessedBuffers( sourceId, 2, &processedId ) == 1 && processedId == bufferIds[0] );
+	const float refillSamples[] = { 0.5f, 0.5f };
+	mixer.SetBufferData( processedId, ADF_StereoFloat32, 4000, refillSamples, sizeof( refillSamples ) );
+	mixer.QueueBuffers( sourceId, 1, &processedId );
+	mixer.Mix( 6, result );
+	GIN_CHECK( isEqual( result, 0, expected, 20 ) );
+	GIN_CHECK( isSilent( result, 20 ) );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Stopped );
+}
+
+GIN_TEST( SoftwareMixerLoopsBuffers )
+{
+	CSoftwareMixer mixer( CreateOwner<CNullAudioSink>(), 8000 );
+	const float samples[] = { 1.0f, -1.0f, 0.0f, 0.0f };
+	const unsigned bufferId = createBuffer( mixer, ADF_StereoFloat32, 4000, samples, sizeof( samples ) );
+	const unsigned sourceId = mixer.CreateSource();
+	mixer.SetSourceLooping( sourceId, true );
+	mixer.QueueBuffers( sourceId, 1, &bufferId );
+	mixer.PlaySource( sourceId );
+
+	// The end of the buffer is interpolated with its start.
+	CArray<float> result;
+	mixer.Mix( 10, result );
+	const float period[] = { 1.0f, -1.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, -0.5f };
+	for( int i = 0; i < 20; i++ ) {
+		GIN_CHECK( result[i] == period[i % 8] );
+	}
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Playing );
+	unsigned processedId;
+	GIN_CHECK( mixer.UnqueueProcessedBuffers( sourceId, 1, &processedId ) == 0 );
+}
+
+GIN_TEST( SoftwareMixerAttenuatesAndPansMonoSources )
+{
+	CSoftwareMixer mixer( CreateOwner<CNullAudioSink>(), 8000 );
+	const float samples[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+	const unsigned bufferId = createBuffer( mixer, ADF_MonoFloat32, 8000, samples, sizeof( samples ) );
+	const unsigned sourceId = createSource( mixer, 1, &bufferId );
+
+	// The default listener looks along the negative Z axis, so the source on the negative X axis is on the left.
+	mixer.SetSourcePosition( sourceId, CVector3<float>( -4.0f, 0.0f, 0.0f ) );
+	CArray<float> result;
+	mixer.Mix( 1, result );
+	GIN_CHECK( result[0] == 0.125f && result[1] == 0.0f );
+
+	// The source is on the right of the moved listener. The distance is clamped.
+	mixer.SetListenerPosition( CVector3<float>( -8.0f, 0.0f, 0.0f ) );
+	mixer.SetMaxDistance( 2.0f );
+	GIN_CHECK( mixer.GetDistanceGain( 4.0f ) == 0.5f );
+	GIN_CHECK( mixer.GetDistanceGain( 0.5f ) == 1.0f );
+	mixer.Mix( 1, result );
+	GIN_CHECK( fabsf( result[2] ) < 1e-6f && result[3] == 0.25f );
+
+	// Relative sources in front of the listener are centered.
+	mixer.SetMaxDistance( FLT_MAX );
+	mixer.SetSourceRelative( sourceId, true );
+	mixer.SetSourcePosition( sourceId, CVector3<float>( 0.0f, 0.0f, -2.0f ) );
+	mixer.Mix( 1, result );
+	const float centerGain = 0.25f * 0.70710678f;
+	GIN_CHECK( fabsf( result[4] - centerGain ) < 1e-6f && fabsf( result[5] - centerGain ) < 1e-6f );
+
+	// Stereo sources get only the gain.
+	const float stereoSamples[] = { 0.5f, -0.5f, 0.5f, -0.5f };
+	mixer.SetBufferData( bufferId, ADF_StereoFloat32, 8000, stereoSamples, sizeof( stereoSamples ) );
+	mixer.SetSourceGain( sourceId, 0.5f );
+	mixer.PlaySource( sourceId );
+	mixer.Mix( 1, result );
+	GIN_CHECK( result[6] == 0.25f && result[7] == -0.25f );
+}
+
+GIN_TEST( SoftwareMixerControlsPlayback )
+{
+	// The low sample rate makes the offsets exact.
+	CSoftwareMixer mixer( CreateOwner<CNullAudioSink>(), 8 );
+	const float samples[] = { 0.125f, -0.125f, 0.25f, -0.25f, 0.375f, -0.375f, 0.5f, -0.5f };
+	const unsigned bufferId = createBuffer( mixer, ADF_StereoFloat32, 8, samples, sizeof( samples ) );
+	const unsigned sourceId = createSource( mixer, 1, &bufferId );
+	CArray<float> result;
+	mixer.Mix( 1, result );
+	GIN_CHECK( mixer.GetSourceOffset( sourceId ) == 0.125f );
+
+	// Paused sources keep the position.
+	mixer.PauseSource( sourceId );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Paused );
+	mixer.Mix( 1, result );
+	GIN_CHECK( mixer.GetMixedSourceCount() == 0 );
+	mixer.PlaySource( sourceId );
+	mixer.Mix( 1, result );
+	const float expected[] = { 0.125f, -0.125f, 0.0f, 0.0f, 0.25f, -0.25f };
+	GIN_CHECK( isEqual( result, 0, expected, 6 ) );
+
+	// Rewound sources are silent until played from the set offset.
+	mixer.StopSource( sourceId );
+	mixer.RewindSource( sourceId );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Initial );
+	mixer.SetSourceOffset( sourceId, 0.25f );
+	GIN_CHECK( mixer.GetSourceOffset( sourceId ) == 0.25f );
+	result.Empty();
+	mixer.Mix( 1, result );
+	mixer.PlaySource( sourceId );
+	mixer.Mix( 1, result );
+	GIN_CHECK( result[0] == 0.0f && result[1] == 0.0f );
+	GIN_CHECK( result[2] == 0.375f && result[3] == -0.375f );
+
+	// Stopped sources have all the buffers processed.
+	mixer.StopSource( sourceId );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Stopped );
+	mixer.DetachBuffers( sourceId );
+	GIN_CHECK( mixer.GetQueuedBufferCount( sourceId ) == 0 );
+	// Sources without buffers stop at once.
+	mixer.PlaySource( sourceId );
+	GIN_CHECK( mixer.GetSourceState( sourceId ) == CAudioRecord::RS_Stopped );
+
+	// Identifiers are reused.
+	mixer.DeleteSource( sourceId );
+	GIN_CHECK( mixer.CreateSource() == sourceId );
+	mixer.DeleteBuffers( 1, &bufferId );
+	unsigned newBufferId;
+	mixer.CreateBuffers( 1, &newBufferId );
+	GIN_CHECK( newBufferId == bufferId );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+#endif
@@ -0,0 +1,297 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <TestFramework.h>
+#include <FakeAudioBackend.h>
+#include <SoundCache.h>
+#include <AlGlobals.h>
+#include <AlContextManager.h>
+#include <WavUtils.h>
+#include <Application.h>
+#include <StartupInfo.h>
+#include <State.h>
+
+namespace Gin {
+
+namespace Tests {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+// The cache uses the context manager of the application.
+class CTestApplication : public CApplication {
+protected:
+	virtual CPtrOwner<IState> onInitialize( CPtrOwner<IStartupInfo> ) override final
+		{ return nullptr; }
+};
+
+static CFakeAudioBackend& initializeFakeBackend()
+{
+	auto backend = CreateOwner<CFakeAudioBackend>();
+	CFakeAudioBackend& result = *backend;
+	GetAudioContextManager().InitializeBackend( move( backend ) );
+	return result;
+}
+
+// The test files are written to the working directory.
+static const char* const testFileNames[] = { "SoundCacheTest0.wav", "SoundCacheTest1.wav", "SoundCacheTest2.wav", "SoundCacheTest3.wav" };
+static const char* const invalidFileName = "SoundCacheInvalidTest.wav";
+
+// Size of the decoded data of a test file.
+static const int soundByteSize = 200;
+
+static void addValue( int value, int size, CArray<BYTE>& data )
+{
+	for( int i = 0; i < size; i++ ) {
+		data.Add( static_cast<BYTE>( value >> ( 8 * i ) ) );
+	}
+}
+
+static void addId( const char* id, CArray<BYTE>& data )
+{
+	for( int i = 0; i < 4; i++ ) {
+		data.Add( static_cast<BYTE>( id[i] ) );
+	}
+}
+
+// Write a silent 16 bit WAV file of 0.1 seconds. Files with more than two channels are rejected by the decoder.
+static void writeWavFile( const char* fileName, int channelCount )
+{
+	const int blockAlign = 2 * channelCount;
+	const int dataSize = 100 * blockAlign;
+	CArray<BYTE> data;
+	addId( "RIFF", data );
+	addValue( 36 + dataSize, 4, data );
+	addId( "WAVE", data );
+	addId( "fmt ", data );
+	addValue( 16, 4, data );
+	addValue( 1, 2, data );
+	addValue( channelCount, 2, data );
+	addValue( 1000, 4, data );
+	addValue( 1000 * blockAlign, 4, data );
+	addValue( blockAlign, 2, data );
+	addValue( 16, 2, data );
+	addId( "data", data );
+	addValue( dataSize, 4, data );
+	for( int i = 0; i < dataSize; i++ ) {
+		data.Add( 0 );
+	}
+
+	CFileWriter file( fileName, FCM_CreateAlways );
+	file.Write( data.Ptr(), data.Size() );
+}
+
+static void writeTestFiles()
+{
+	for( auto fileName : testFileNames ) {
+		writeWavFile( fileName, 1 );
+	}
+	writeWavFile( invalidFileName, 3 );
+}
+
+// Check that the cache data matches the live buffers of the backend.
+static bool isConsistent( const CSoundCache& cache, const CFakeAudioBackend& backend )
+{
+	return cache.GetSoundCount() == backend.GetLiveBufferCount() && cache.GetUsedByteCount() == backend.GetBufferByteCount();
+}
+
+GIN_TEST( SoundCacheSharesLoadedSounds )
+{
+	writeTestFiles();
+	CTestApplication application;
+	auto& backend = initializeFakeBackend();
+	CSoundCache cache( 1000, 0 );
+	GIN_CHECK( cache.GetWorkerCount() == 0 );
+
+	auto sound = cache.GetSound( testFileNames[0] );
+	GIN_CHECK( cache.IsLoaded( testFileNames[0] ) && !cache.IsLoaded( testFileNames[1] ) );
+	GIN_CHECK( cache.GetSoundCount() == 1 && cache.GetUsedByteCount() == soundByteSize );
+	GIN_CHECK( cache.GetStatistics().MissCount == 1 && cache.GetStatistics().HitCount == 0 );
+	GIN_CHECK( sound.GetSound().Buffers().Size() == 1 );
+	GIN_CHECK( backend.GetBuffer( sound.GetSound().Buffers()[0] ).ByteSize == soundByteSize );
+
+	// Further requests share the buffer. File names are case insensitive.
+	const auto sameSound = cache.GetSound( testFileNames[0] );
+	const auto upperCaseSound = cache.GetSound( "SOUNDCACHETEST0.WAV" );
+	GIN_CHECK( sameSound.GetSound() == sound.GetSound() && upperCaseSound.GetSound() == sound.GetSound() );
+	GIN_CHECK( cache.GetStatistics().MissCount == 1 && cache.GetStatistics().HitCount == 2 );
+	GIN_CHECK( backend.CreatedBufferCount == 1 && backend.BufferUploadCount == 1 );
+
+	const auto otherSound = cache.GetSound( testFileNames[1] );
+	GIN_CHECK( !( otherSound.GetSound() == sound.GetSound() ) );
+	GIN_CHECK( cache.GetSoundCount() == 2 && isConsistent( cache, backend ) );
+
+	// Referenced sounds are kept.
+	sound.Release();
+	GIN_CHECK( sound.IsEmpty() && sound.GetSound().IsEmpty() );
+	cache.EvictUnused();
+	GIN_CHECK( cache.GetSoundCount() == 2 );
+	cache.ResetStatistics();
+	GIN_CHECK( cache.GetStatistics().HitCount == 0 );
+}
+
+GIN_TEST( SoundCacheEvictsLeastRecentSounds )
+{
+	writeTestFiles();
+	CTestApplication application;
+	auto& backend = initializeFakeBackend();
+	CSoundCache cache( 2 * soundByteSize + soundByteSize / 2, 0 );
+
+	// A hit makes the sound the most recent one.
+	cache.GetSound( testFileNames[0] );
+	cache.GetSound( testFileNames[1] );
+	cache.GetSound( testFileNames[0] );
+	cache.GetSound( testFileNames[2] );
+	GIN_CHECK( cache.IsLoaded( testFileNames[0] ) && !cache.IsLoaded( testFileNames[1] ) && cache.IsLoaded( testFileNames[2] ) );
+	GIN_CHECK( cache.GetStatistics().EvictionCount == 1 );
+	GIN_CHECK( cache.GetUsedByteCount() <= cache.GetByteBudget() && isConsistent( cache, backend ) );
+
+	// An evicted sound is decoded again.
+	cache.GetSound( testFileNames[1] );
+	GIN_CHECK( !cache.IsLoaded( testFileNames[0] ) && cache.IsLoaded( testFileNames[1] ) && cache.IsLoaded( testFileNames[2] ) );
+	GIN_CHECK( cache.GetStatistics().MissCount == 4 && cache.GetStatistics().EvictionCount == 2 );
+	GIN_CHECK( backend.CreatedBufferCount == 4 && backend.DeletedBufferCount == 2 );
+
+	// Lowering the budget evicts the sounds immediately.
+	cache.SetByteBudget( soundByteSize );
+	GIN_CHECK( cache.GetSoundCount() == 1 && cache.IsLoaded( testFileNames[1] ) );
+	GIN_CHECK( cache.GetStatistics().EvictionCount == 3 && isConsistent( cache, backend ) );
+
+	cache.EvictUnused();
+	GIN_CHECK( cache.GetSoundCount() == 0 && cache.GetUsedByteCount() == 0 );
+	GIN_CHECK( backend.GetLiveBufferCount() == 0 );
+	// Explicit eviction isn't counted.
+	GIN_CHECK( cache.GetStatistics().EvictionCount == 3 );
+}
+
+GIN_TEST( SoundCacheKeepsSoundsInUse )
+{
+	writeTestFiles();
+	CTestApplication application;
+	auto& backend = initializeFakeBackend();
+	CSoundCache cache( soundByteSize + soundByteSize / 2, 0 );
+
+	// The budget is exceeded while all the sounds are referenced.
+	auto firstSound = cache.GetSound( testFileNames[0] );
+	auto secondSound = cache.GetSound( testFileNames[1] );
+	GIN_CHECK( cache.GetSoundCount() == 2 && cache.GetUsedByteCount() == 2 * soundByteSize );
+	GIN_CHECK( cache.GetStatistics().EvictionCount == 0 );
+
+	// Copies keep the sound alive.
+	auto firstSoundCopy = firstSound;
+	firstSound.Release();
+	GIN_CHECK( cache.GetSoundCount() == 2 );
+	// The released sound is evicted right away.
+	firstSoundCopy = secondSound;
+	GIN_CHECK( !cache.IsLoaded( testFileNames[0] ) && cache.IsLoaded( testFileNames[1] ) );
+	GIN_CHECK( cache.GetStatistics().EvictionCount == 1 && isConsistent( cache, backend ) );
+
+	// Sounds played by records are kept after their release.
+	PlaySound( secondSound );
+	firstSoundCopy.Release();
+	secondSound.Release();
+	cache.SetByteBudget( 0 );
+	cache.EvictUnused();
+	GIN_CHECK( cache.IsLoaded( testFileNames[1] ) );
+
+	// The record ends with the sound, the cache update evicts it.
+	backend.Advance( 0.2f );
+	GetAudioContextManager().Update( 0.2f );
+	GIN_CHECK( cache.IsLoaded( testFileNames[1] ) );
+	cache.Update();
+	GIN_CHECK( cache.GetSoundCount() == 0 && backend.GetLiveBufferCount() == 0 );
+	GIN_CHECK( cache.GetStatistics().EvictionCount == 2 );
+}
+
+// Check that the request of an invalid file throws the decoding error.
+static bool isRejected( CSoundCache& cache )
+{
+	try {
+		cache.GetSound( invalidFileName );
+	} catch( CWavException& ) {
+		return true;
+	}
+	return false;
+}
+
+// Prefetch the test files and wait for them to load.
+static bool checkPrefetch( int workerCount )
+{
+	CTestApplication application;
+	CFakeAudioBackend& backend = initializeFakeBackend();
+	CSoundCache cache( 1000, workerCount );
+	if( cache.GetWorkerCount() != workerCount ) {
+		return false;
+	}
+
+	cache.Prefetch( testFileNames[0] );
+	cache.Prefetch( testFileNames[1] );
+	cache.Prefetch( invalidFileName );
+	// Repeated prefetches are ignored.
+	cache.Prefetch( testFileNames[0] );
+	if( cache.GetPrefetchCount() != 3 || cache.IsLoaded( testFileNames[0] ) || cache.GetSoundCount() != 0 ) {
+		return false;
+	}
+
+	cache.Flush();
+	const auto& statistics = cache.GetStatistics();
+	if( cache.GetPrefetchCount() != 0 || cache.GetSoundCount() != 2 || statistics.PrefetchFailedCount != 1 ) {
+		return false;
+	}
+	if( !cache.IsLoaded( testFileNames[0] ) || !cache.IsLoaded( testFileNames[1] ) || cache.IsLoaded( invalidFileName ) ) {
+		return false;
+	}
+	// Prefetched sounds are hits, failed prefetches are decoded again to throw the error.
+	const auto sound = cache.GetSound( testFileNames[1] );
+	if( statistics.HitCount != 1 || statistics.MissCount != 0 || !isRejected( cache ) || statistics.MissCount != 1 ) {
+		return false;
+	}
+	return isConsistent( cache, backend ) && backend.BufferUploadCount == 2;
+}
+
+GIN_TEST( SoundCachePrefetchesFiles )
+{
+	writeTestFiles();
+	GIN_CHECK( checkPrefetch( 0 ) );
+	GIN_CHECK( checkPrefetch( 1 ) );
+}
+
+GIN_TEST( SoundCacheLoadsPrefetchedFilesOnUpdate )
+{
+	writeTestFiles();
+	CTestApplication application;
+	auto& backend = initializeFakeBackend();
+	{
+		// Without workers the pending prefetch is decoded by the request.
+		CSoundCache cache( 1000, 0 );
+		cache.Prefetch( testFileNames[0] );
+		cache.Update();
+		GIN_CHECK( cache.GetPrefetchCount() == 1 && !cache.IsLoaded( testFileNames[0] ) );
+		const auto sound = cache.GetSound( testFileNames[0] );
+		GIN_CHECK( !sound.IsEmpty() && cache.GetPrefetchCount() == 0 );
+		GIN_CHECK( cache.GetStatistics().MissCount == 0 && cache.GetStatistics().HitCount == 0 );
+	}
+	GIN_CHECK( backend.GetLiveBufferCount() == 0 );
+
+	CSoundCache cache( 1000, 1 );
+	cache.Prefetch( testFileNames[0] );
+	cache.Prefetch( testFileNames[1] );
+	for( int i = 0; i < 1000 && cache.GetPrefetchCount() > 0; i++ ) {
+		::Sleep( 1 );
+		cache.Update();
+	}
+	GIN_CHECK( cache.GetPrefetchCount() == 0 );
+	GIN_CHECK( cache.IsLoaded( testFileNames[0] ) && cache.IsLoaded( testFileNames[1] ) );
+	GIN_CHECK( cache.GetSoundCount() == 2 && isConsistent( cache, backend ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+#endif
@@ -0,0 +1,55 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <cstdio>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+CTestCase* CTestCase::firstCase = nullptr;
+CTestCase* CTestCase::lastCase = nullptr;
+int CTestCase::failureCount = 0;
+
+CTestCase::CTestCase( const char* _name, TTestFunction _function ) :
+	name( _name ),
+	function( _function )
+{
+	if( lastCase != nullptr ) {
+		lastCase->next = this;
+	} else {
+		firstCase = this;
+	}
+	lastCase = this;
+}
+
+bool CTestCase::Run() const
+{
+	failureCount = 0;
+	try {
+		function();
+	} catch( const CException& e ) {
+		printf( "%s: unexpected exception: %s\n", name, e.GetMessageText().Ptr() );
+		failureCount++;
+	} catch( ... ) {
+		printf( "%s: unexpected exception\n", name );
+		failureCount++;
+	}
+	printf( "%s %s\n", failureCount == 0 ? "[passed]" : "[FAILED]", name );
+	return failureCount == 0;
+}
+
+void CTestCase::ReportFailure( const char* file, int line, const char* condition )
+{
+	printf( "%s(%d): check failed: %s\n", file, line, condition );
+	failureCount++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+typedef void ( *TTestFunction )();
+
+// Test case of the test executable. Test cases are registered by their static objects and run in the order of registration.
+class CTestCase {
+public:
+	CTestCase( const char* name, TTestFunction function );
+
+	const char* GetName() const
+		{ return name; }
+	const CTestCase* GetNext() const
+		{ return next; }
+	static const CTestCase* GetFirst()
+		{ return firstCase; }
+
+	// Run the test and return true if all its checks have passed. Exceptions are reported as failures.
+	bool Run() const;
+
+	// Report a failed check of the running test.
+	static void ReportFailure( const char* file, int line, const char* condition );
+
+private:
+	const char* name;
+	TTestFunction function;
+	CTestCase* next = nullptr;
+
+	static CTestCase* firstCase;
+	static CTestCase* lastCase;
+	// Number of failed checks of the running test.
+	static int failureCount;
+
+	// Copying is prohibited.
+	CTestCase( CTestCase& ) = delete;
+	void operator=( CTestCase& ) = delete;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+// Define a test function and register it in the test executable.
+#define GIN_TEST( testName ) \
+	static void testName(); \
+	static const Gin::Tests::CTestCase testName##Case( #testName, testName ); \
+	static void testName()
+
+// Check a condition of the running test. Failed checks are reported and the test goes on.
+#define GIN_CHECK( condition ) \
+	( ( condition ) ? static_cast<void>( 0 ) : Gin::Tests::CTestCase::ReportFailure( __FILE__, __LINE__, #condition ) )
@@ -0,0 +1,22 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <cstdio>
+
+using namespace Gin::Tests;
+
+// Run all the registered tests. The exit code is the number of failed tests.
+int main()
+{
+	int testCount = 0;
+	int failedCount = 0;
+	for( auto testCase = CTestCase::GetFirst(); testCase != nullptr; testCase = testCase->GetNext() ) {
+		testCount++;
+		if( !testCase->Run() ) {
+			failedCount++;
+		}
+	}
+	printf( "%d of %d tests failed.\n", failedCount, testCount );
+	return failedCount;
+}
@@ -0,0 +1,129 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <TextMeshCache.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+static CArrayView<BYTE> getTextBytes( const char* text )
+{
+	return CArrayView<BYTE>( reinterpret_cast<const BYTE*>( text ), static_cast<int>( strlen( text ) ) );
+}
+
+// Size of the test meshes. Together with the four letter texts an entry takes 40 bytes.
+static const int meshSize = 36;
+
+GIN_TEST( TextMeshCacheFindsAddedMeshes )
+{
+	CTextMeshCachePolicy policy( 1000 );
+	CArray<int> evictedSlots;
+	const auto text = getTextBytes( "abcd" );
+	const CTextMeshCacheKey key( text, false );
+	GIN_CHECK( policy.FindSlot( key, text ) == NotFound );
+
+	const int slot = policy.AddSlot( key, text, meshSize, evictedSlots );
+	GIN_CHECK( policy.FindSlot( key, text ) == slot );
+	GIN_CHECK( policy.GetUsedByteCount() == 40 );
+	GIN_CHECK( evictedSlots.IsEmpty() );
+
+	// Layout parameters are a part of the key.
+	const CTextMeshCacheKey wrappedKey( text, false, 100, 20 );
+	GIN_CHECK( policy.FindSlot( wrappedKey, text ) == NotFound );
+	GIN_CHECK( policy.GetStatistics().HitCount == 1 );
+	GIN_CHECK( policy.GetStatistics().MissCount == 2 );
+}
+
+GIN_TEST( TextMeshCacheEvictsLeastRecentMeshes )
+{
+	CTextMeshCachePolicy policy( 100 );
+	CArray<int> evictedSlots;
+	const auto first = getTextBytes( "aaaa" );
+	const auto second = getTextBytes( "bbbb" );
+	const auto third = getTextBytes( "cccc" );
+	const int firstSlot = policy.AddSlot( CTextMeshCacheKey( first, false ), first, meshSize, evictedSlots );
+	const int secondSlot = policy.AddSlot( CTextMeshCacheKey( second, false ), second, meshSize, evictedSlots );
+
+	// The first mesh is used again, so the second one becomes the least recent.
+	policy.AdvanceFrame();
+	GIN_CHECK( policy.FindSlot( CTextMeshCacheKey( first, false ), first ) == firstSlot );
+	policy.AddSlot( CTextMeshCacheKey( third, false ), third, meshSize, evictedSlots );
+	GIN_CHECK( evictedSlots.Size() == 1 && evictedSlots[0] == secondSlot );
+	GIN_CHECK( policy.FindSlot( CTextMeshCacheKey( second, false ), second ) == NotFound );
+	GIN_CHECK( policy.GetUsedByteCount() == 80 );
+	GIN_CHECK( policy.GetEntryCount() == 2 );
+	GIN_CHECK( policy.GetStatistics().EvictionCount == 1 );
+}
+
+GIN_TEST( TextMeshCacheKeepsMeshesOfTheCurrentFrame )
+{
+	CTextMeshCachePolicy policy( 100 );
+	CArray<int> evictedSlots;
+	const char* texts[] = { "aaaa", "bbbb", "cccc" };
+	for( auto text : texts ) {
+		policy.AddSlot( CTextMeshCacheKey( getTextBytes( text ), false ), getTextBytes( text ), meshSize, evictedSlots );
+	}
+	// All the meshes may be drawn during this frame, the budget is exceeded instead.
+	GIN_CHECK( evictedSlots.IsEmpty() );
+	GIN_CHECK( policy.GetUsedByteCount() == 120 );
+
+	policy.AdvanceFrame();
+	const auto text = getTextBytes( "dddd" );
+	policy.AddSlot( CTextMeshCacheKey( text, false ), text, meshSize, evictedSlots );
+	GIN_CHECK( evictedSlots.Size() == 2 );
+	GIN_CHECK( policy.GetUsedByteCount() == 80 );
+}
+
+GIN_TEST( TextMeshCacheReplacesCollidingText )
+{
+	CTextMeshCachePolicy policy( 1000 );
+	CArray<int> evictedSlots;
+	const auto text = getTextBytes( "abcd" );
+	const auto otherText = getTextBytes( "efgh" );
+	// Different texts with the same key simulate a hash collision.
+	const CTextMeshCacheKey key( text, false );
+	const int slot = policy.AddSlot( key, text, meshSize, evictedSlots );
+
+	policy.AdvanceFrame();
+	const int otherSlot = policy.AddSlot( key, otherText, meshSize, evictedSlots );
+	GIN_CHECK( evictedSlots.Size() == 1 && evictedSlots[0] == slot );
+	GIN_CHECK( policy.FindSlot( key, text ) == NotFound );
+	GIN_CHECK( policy.FindSlot( key, otherText ) == otherSlot );
+	GIN_CHECK( policy.GetEntryCount() == 1 );
+}
+
+GIN_TEST( TextMeshCacheKeepsCollidingMeshInUse )
+{
+	CTextMeshCachePolicy policy( 100 );
+	CArray<int> evictedSlots;
+	const auto text = getTextBytes( "abcd" );
+	const auto otherText = getTextBytes( "efgh" );
+	const CTextMeshCacheKey key( text, false );
+	const int slot = policy.AddSlot( key, text, meshSize, evictedSlots );
+
+	// The replaced mesh has been returned during this frame and must stay valid.
+	const int otherSlot = policy.AddSlot( key, otherText, meshSize, evictedSlots );
+	GIN_CHECK( otherSlot != slot );
+	GIN_CHECK( evictedSlots.IsEmpty() );
+	GIN_CHECK( policy.FindSlot( key, text ) == NotFound );
+	GIN_CHECK( policy.FindSlot( key, otherText ) == otherSlot );
+
+	// The replaced mesh is evicted later without dropping the key of the new one.
+	policy.AdvanceFrame();
+	GIN_CHECK( policy.FindSlot( key, otherText ) == otherSlot );
+	const auto newText = getTextBytes( "ijkl" );
+	policy.AddSlot( CTextMeshCacheKey( newText, false ), newText, meshSize, evictedSlots );
+	GIN_CHECK( evictedSlots.Size() == 1 && evictedSlots[0] == slot );
+	GIN_CHECK( policy.FindSlot( key, otherText ) == otherSlot );
+	GIN_CHECK( policy.GetUsedByteCount() == 80 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,214 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <TextureResidencyPolicy.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+// Byte sizes of the levels of a 256x256 RGBA8 texture.
+static const int levelByteSizes[] = { 262144, 65536, 16384, 4096, 1024, 256, 64, 16, 4 };
+static const int levelCount = sizeof( levelByteSizes ) / sizeof( levelByteSizes[0] );
+// With the default tail size of 64 the tail starts at the third level.
+static const int tailByteSize = 16384 + 4096 + 1024 + 256 + 64 + 16 + 4;
+
+static int addTexture( CTextureResidencyPolicy& policy )
+{
+	return policy.AddTexture( 256, 256, CArrayView<int>( levelByteSizes, levelCount ) );
+}
+
+// Schedule and finish a single load. Return the loaded level.
+static int loadNextLevel( CTextureResidencyPolicy& policy, int expectedTexture )
+{
+	CArray<int> evictedTextures;
+	int level = NotFound;
+	const int texture = policy.ScheduleNextLoad( level, evictedTextures );
+	GIN_CHECK( texture == expectedTexture );
+	if( texture != NotFound ) {
+		policy.OnLevelLoaded( texture );
+	}
+	return level;
+}
+
+GIN_TEST( TextureResidencyPolicyFindsLevels )
+{
+	CTextureResidencyPolicy policy;
+	const int texture = addTexture( policy );
+	GIN_CHECK( policy.GetLevelCount( texture ) == levelCount );
+	GIN_CHECK( policy.GetTailLevel( texture ) == 2 );
+	GIN_CHECK( policy.GetResidentLevel( texture ) == 2 );
+	GIN_CHECK( policy.GetDesiredLevel( texture ) == 2 );
+	GIN_CHECK( policy.GetLoadingLevel( texture ) == NotFound );
+	GIN_CHECK( policy.GetUsedByteCount() == tailByteSize );
+
+	// Textures smaller than the tail size are resident as a whole.
+	const int smallLevels[] = { 4096, 1024 };
+	const int smallTexture = policy.AddTexture( 32, 32, CArrayView<int>( smallLevels, 2 ) );
+	GIN_CHECK( policy.GetTailLevel( smallTexture ) == 0 );
+	GIN_CHECK( policy.GetUsedByteCount() == tailByteSize + 5120 );
+
+	GIN_CHECK( CTextureResidencyPolicy::FindDesiredLevel( 256, 256, 300 ) == 0 );
+	GIN_CHECK( CTextureResidencyPolicy::FindDesiredLevel( 256, 256, 100 ) == 1 );
+	GIN_CHECK( CTextureResidencyPolicy::FindDesiredLevel( 256, 64, 64 ) == 2 );
+	GIN_CHECK( CTextureResidencyPolicy::FindDesiredLevel( 256, 256, 0.5f ) == 8 );
+	GIN_CHECK( fabsf( CTextureResidencyPolicy::EstimateScreenSize( 2, 10, 3.14159265f / 2, 1000 ) - 100 ) < 1e-3f );
+}
+
+GIN_TEST( TextureResidencyPolicyUsesBiggestScreenSize )
+{
+	CTextureResidencyPolicy policy;
+	const int texture = addTexture( policy );
+	// Desired levels never go past the tail.
+	policy.UpdateScreenSize( texture, 20 );
+	GIN_CHECK( policy.GetDesiredLevel( texture ) == 2 );
+	policy.UpdateScreenSize( texture, 200 );
+	policy.UpdateScreenSize( texture, 50 );
+	GIN_CHECK( policy.GetDesiredLevel( texture ) == 0 );
+
+	// A new frame starts over.
+	policy.AdvanceFrame();
+	policy.UpdateScreenSize( texture, 100 );
+	GIN_CHECK( policy.GetDesiredLevel( texture ) == 1 );
+}
+
+GIN_TEST( TextureResidencyPolicyLoadsFromCoarseToFine )
+{
+	CTextureResidencyPolicy policy;
+	const int texture = addTexture( policy );
+	CArray<int> evictedTextures;
+	int level = NotFound;
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == NotFound );
+
+	policy.UpdateScreenSize( texture, 300 );
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == texture );
+	GIN_CHECK( level == 1 );
+	GIN_CHECK( policy.GetLoadingLevel( texture ) == 1 );
+	GIN_CHECK( policy.GetUsedByteCount() == tailByteSize + 65536 );
+	// A texture has a single pending load.
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == NotFound );
+
+	policy.OnLevelLoaded( texture );
+	GIN_CHECK( policy.GetResidentLevel( texture ) == 1 );
+	GIN_CHECK( loadNextLevel( policy, texture ) == 0 );
+	GIN_CHECK( policy.GetResidentLevel( texture ) == 0 );
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == NotFound );
+	GIN_CHECK( policy.GetUsedByteCount() == tailByteSize + 65536 + 262144 );
+	GIN_CHECK( policy.GetStatistics().LoadCount == 2 );
+	GIN_CHECK( evictedTextures.IsEmpty() );
+}
+
+GIN_TEST( TextureResidencyPolicyPrefersMostMissingLevels )
+{
+	CTextureResidencyPolicy policy;
+	const int first = addTexture( policy );
+	const int second = addTexture( policy );
+	policy.UpdateScreenSize( second, 300 );
+	// The second texture lacks two levels and goes first, even though the first one has been used more recently.
+	policy.UpdateScreenSize( first, 100 );
+	GIN_CHECK( loadNextLevel( policy, second ) == 1 );
+}
+
+GIN_TEST( TextureResidencyPolicyEvictsLeastRecentTextures )
+{
+	// The budget fits both tails and a single streamed level.
+	CTextureResidencyPolicy policy( 2 * tailByteSize + 65536 );
+	const int first = addTexture( policy );
+	const int second = addTexture( policy );
+	policy.UpdateScreenSize( first, 100 );
+	loadNextLevel( policy, first );
+	GIN_CHECK( policy.GetUsedByteCount() == policy.GetByteBudget() );
+
+	// The first texture is not used in the new frame and loses its streamed level.
+	policy.AdvanceFrame();
+	policy.UpdateScreenSize( second, 100 );
+	CArray<int> evictedTextures;
+	int level = NotFound;
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == second );
+	GIN_CHECK( level == 1 );
+	GIN_CHECK( evictedTextures.Size() == 1 && evictedTextures[0] == first );
+	GIN_CHECK( policy.GetResidentLevel( first ) == policy.GetTailLevel( first ) );
+	GIN_CHECK( policy.GetUsedByteCount() == policy.GetByteBudget() );
+	GIN_CHECK( policy.GetStatistics().EvictionCount == 1 );
+}
+
+GIN_TEST( TextureResidencyPolicyKeepsLevelsOfTheCurrentFrame )
+{
+	CTextureResidencyPolicy policy( 2 * tailByteSize + 65536 );
+	const int first = addTexture( policy );
+	const int second = addTexture( policy );
+	policy.UpdateScreenSize( first, 100 );
+	loadNextLevel( policy, first );
+
+	// Both textures need their first level during this frame, the load is postponed.
+	policy.AdvanceFrame();
+	policy.UpdateScreenSize( first, 100 );
+	policy.UpdateScreenSize( second, 100 );
+	CArray<int> evictedTextures;
+	int level = NotFound;
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == NotFound );
+	GIN_CHECK( evictedTextures.IsEmpty() );
+	GIN_CHECK( policy.GetResidentLevel( first ) == 1 );
+	GIN_CHECK( policy.GetStatistics().BudgetShortageCount == 1 );
+
+	// Levels finer than the current need can be released.
+	policy.AdvanceFrame();
+	policy.UpdateScreenSize( first, 20 );
+	policy.UpdateScreenSize( second, 100 );
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == second );
+	GIN_CHECK( evictedTextures.Size() == 1 && evictedTextures[0] == first );
+	GIN_CHECK( policy.GetResidentLevel( first ) == 2 );
+}
+
+GIN_TEST( TextureResidencyPolicyKeepsPendingLoads )
+{
+	CTextureResidencyPolicy policy( 2 * tailByteSize + 65536 );
+	const int first = addTexture( policy );
+	const int second = addTexture( policy );
+	policy.UpdateScreenSize( first, 100 );
+	CArray<int> evictedTextures;
+	int level = NotFound;
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == first );
+
+	// The reserved memory of the pending load cannot be released.
+	policy.AdvanceFrame();
+	policy.UpdateScreenSize( second, 100 );
+	GIN_CHECK( policy.ScheduleNextLoad( level, evictedTextures ) == NotFound );
+	GIN_CHECK( policy.GetLoadingLevel( first ) == 1 );
+
+	// A failed load releases the reserved memory.
+	policy.OnLevelLoadFailed( first );
+	GIN_CHECK( policy.GetUsedByteCount() == 2 * tailByteSize );
+	GIN_CHECK( policy.GetResidentLevel( first ) == 2 );
+	GIN_CHECK( loadNextLevel( policy, second ) == 1 );
+	GIN_CHECK( evictedTextures.IsEmpty() );
+}
+
+GIN_TEST( TextureResidencyPolicyRemovesTextures )
+{
+	CTextureResidencyPolicy policy;
+	const int first = addTexture( policy );
+	const int second = addTexture( policy );
+	policy.UpdateScreenSize( first, 100 );
+	loadNextLevel( policy, first );
+	GIN_CHECK( policy.GetTextureCount() == 2 );
+
+	policy.RemoveTexture( first );
+	GIN_CHECK( policy.GetTextureCount() == 1 );
+	GIN_CHECK( policy.GetUsedByteCount() == tailByteSize );
+	// Removed handles are reused and the recency list stays consistent.
+	GIN_CHECK( addTexture( policy ) == first );
+	policy.RemoveTexture( second );
+	policy.UpdateScreenSize( first, 100 );
+	GIN_CHECK( loadNextLevel( policy, first ) == 1 );
+	GIN_CHECK( policy.GetUsedByteCount() == tailByteSize + 65536 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
@@ -0,0 +1,177 @@
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFramework.h>
+#include <TextureUploadPolicy.h>
+
+namespace Gin {
+
+namespace Tests {
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int slotByteSize = 1000;
+
+// Prepare the staging memory of all the idle slots.
+static void prepareSlots( CTextureUploadPolicy& policy )
+{
+	for( int slot = policy.FindIdleSlot(); slot != NotFound; slot = policy.FindIdleSlot() ) {
+		policy.OnSlotPrepared( slot );
+	}
+}
+
+// Acquire a slot and commit data of the given size to it. Return the slot.
+static int queueUpload( CTextureUploadPolicy& policy, int byteSize )
+{
+	const int slot = policy.AcquireSlot( byteSize );
+	GIN_CHECK( slot != NotFound );
+	if( slot != NotFound ) {
+		policy.CommitSlot( slot, byteSize );
+	}
+	return slot;
+}
+
+GIN_TEST( TextureUploadPolicyAcquiresPreparedSlots )
+{
+	CTextureUploadPolicy policy( 2, slotByteSize );
+	GIN_CHECK( policy.GetSlotCount() == 2 );
+	GIN_CHECK( policy.GetSlotState( 0 ) == USS_Idle );
+	// Slots without staging memory can't be acquired.
+	GIN_CHECK( policy.AcquireSlot( 100 ) == NotFound );
+	GIN_CHECK( policy.GetStatistics().StagingShortageCount == 1 );
+
+	GIN_CHECK( policy.FindIdleSlot() == 0 );
+	policy.OnSlotPrepared( 0 );
+	GIN_CHECK( policy.GetSlotState( 0 ) == USS_Available );
+	GIN_CHECK( policy.FindIdleSlot() == 1 );
+
+	const int slot = policy.AcquireSlot( 100 );
+	GIN_CHECK( slot == 0 );
+	GIN_CHECK( policy.GetSlotState( 0 ) == USS_Writing );
+	GIN_CHECK( policy.AcquireSlot( 100 ) == NotFound );
+	GIN_CHECK( policy.GetStatistics().StagingShortageCount == 2 );
+
+	// A cancelled slot can be acquired again and nothing is queued.
+	policy.CancelSlot( slot );
+	GIN_CHECK( policy.GetSlotState( 0 ) == USS_Available );
+	GIN_CHECK( policy.GetQueuedCount() == 0 );
+	GIN_CHECK( policy.AcquireSlot( 100 ) == 0 );
+	policy.CommitSlot( 0, 100 );
+	GIN_CHECK( policy.GetSlotState( 0 ) == USS_Queued );
+	GIN_CHECK( policy.GetSlotDataSize( 0 ) == 100 );
+	GIN_CHECK( policy.GetQueuedCount() == 1 );
+}
+
+GIN_TEST( TextureUploadPolicyKeepsCommitOrder )
+{
+	CTextureUploadPolicy policy( 3, slotByteSize );
+	prepareSlots( policy );
+	const int first = policy.AcquireSlot( 100 );
+	const int second = policy.AcquireSlot( 200 );
+	const int third = policy.AcquireSlot( 300 );
+	GIN_CHECK( first == 0 && second == 1 && third == 2 );
+
+	// Loaders finish in a different order than they have started.
+	policy.CommitSlot( third, 300 );
+	policy.CommitSlot( first, 100 );
+	policy.CommitSlot( second, 200 );
+	GIN_CHECK( policy.ScheduleNextUpload() == third );
+	GIN_CHECK( policy.ScheduleNextUpload() == first );
+	GIN_CHECK( policy.ScheduleNextUpload() == second );
+	GIN_CHECK( policy.ScheduleNextUpload() == NotFound );
+	GIN_CHECK( policy.GetQueuedCount() == 0 );
+	GIN_CHECK( policy.GetPendingCount() == 3 );
+	GIN_CHECK( policy.GetSlotState( first ) == USS_Pending );
+}
+
+GIN_TEST( TextureUploadPolicySplitsBudgetBetweenFrames )
+{
+	CTextureUploadPolicy policy( 4, slotByteSize, 1000 );
+	prepareSlots( policy );
+	const int first = queueUpload( policy, 400 );
+	const int second = queueUpload( policy, 500 );
+	const int third = queueUpload( policy, 300 );
+	const int fourth = queueUpload( policy, 100 );
+
+	GIN_CHECK( policy.ScheduleNextUpload() == first );
+	GIN_CHECK( policy.ScheduleNextUpload() == second );
+	GIN_CHECK( policy.GetFrameUploadedByteCount() == 900 );
+	// The third upload exceeds the budget. The fourth one would fit but it can't overtake the third one.
+	GIN_CHECK( policy.ScheduleNextUpload() == NotFound );
+	GIN_CHECK( policy.GetQueuedCount() == 2 );
+
+	policy.AdvanceFrame();
+	GIN_CHECK( policy.GetStatistics().DeferredFrameCount == 1 );
+	GIN_CHECK( policy.GetFrameUploadedByteCount() == 0 );
+	GIN_CHECK( policy.ScheduleNextUpload() == third );
+	GIN_CHECK( policy.ScheduleNextUpload() == fourth );
+	GIN_CHECK( policy.ScheduleNextUpload() == NotFound );
+
+	// An empty queue doesn't defer the frame.
+	policy.AdvanceFrame();
+	GIN_CHECK( policy.GetStatistics().DeferredFrameCount == 1 );
+	GIN_CHECK( policy.GetStatistics().UploadCount == 4 );
+	GIN_CHECK( policy.GetStatistics().UploadedByteCount == 1300 );
+}
+
+GIN_TEST( TextureUploadPolicyIssuesBigUploadsAlone )
+{
+	CTextureUploadPolicy policy( 3, slotByteSize, 300 );
+	prepareSlots( policy );
+	const int big = queueUpload( policy, 800 );
+	const int small = queueUpload( policy, 100 );
+
+	// The first upload of a frame is issued even if it's bigger than the budget.
+	GIN_CHECK( policy.ScheduleNextUpload() == big );
+	GIN_CHECK( policy.GetFrameUploadedByteCount() == 800 );
+	GIN_CHECK( policy.ScheduleNextUpload() == NotFound );
+	policy.AdvanceFrame();
+	GIN_CHECK( policy.ScheduleNextUpload() == small );
+
+	// The budget change takes effect immediately.
+	policy.SetFrameByteBudget( 1000 );
+	GIN_CHECK( policy.GetFrameByteBudget() == 1000 );
+	const int next = queueUpload( policy, 800 );
+	GIN_CHECK( policy.ScheduleNextUpload() == next );
+	GIN_CHECK( policy.GetFrameUploadedByteCount() == 900 );
+}
+
+GIN_TEST( TextureUploadPolicyReleasesSlotsInIssueOrder )
+{
+	CTextureUploadPolicy policy( 3, slotByteSize );
+	prepareSlots( policy );
+	const int first = queueUpload( policy, 100 );
+	const int second = queueUpload( policy, 200 );
+	const int third = queueUpload( policy, 300 );
+	GIN_CHECK( policy.GetOldestPendingSlot() == NotFound );
+	policy.ScheduleNextUpload();
+	policy.ScheduleNextUpload();
+	policy.ScheduleNextUpload();
+
+	// Fences are signaled in the issue order.
+	GIN_CHECK( policy.GetOldestPendingSlot() == first );
+	policy.ReleaseSlot( first );
+	GIN_CHECK( policy.GetSlotState( first ) == USS_Idle );
+	GIN_CHECK( policy.GetSlotDataSize( first ) == 0 );
+	GIN_CHECK( policy.GetOldestPendingSlot() == second );
+
+	// An abandoned upload is released out of order.
+	policy.ReleaseSlot( third );
+	GIN_CHECK( policy.GetPendingCount() == 1 );
+	GIN_CHECK( policy.GetOldestPendingSlot() == second );
+	policy.ReleaseSlot( second );
+	GIN_CHECK( policy.GetOldestPendingSlot() == NotFound );
+
+	// Released slots need new staging memory before they are reused.
+	GIN_CHECK( policy.AcquireSlot( 100 ) == NotFound );
+	GIN_CHECK( policy.FindIdleSlot() == first );
+	prepareSlots( policy );
+	GIN_CHECK( policy.GetSlotState( third ) == USS_Available );
+	GIN_CHECK( queueUpload( policy, 100 ) == first );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
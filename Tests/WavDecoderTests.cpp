@@ -0,0 +1,244 @@
+#include <common.h>
+#pragma hdrstop
+
+#ifndef GIN_NO_AUDIO
+
+#include <TestFramework.h>
+#include <WavDecoder.h>
+#include <WavUtils.h>
+
+namespace Gin {
+
+namespace Tests {
+
+using namespace Audio;
+
+//////////////////////////////////////////////////////////////////////////
+
+// The test files are written to the working directory and overwritten by each test.
+static const char* testFileName = "WavDecoderTest.wav";
+
+static const int pcmFormatTag = 1;
+static const int floatFormatTag = 3;
+static const int imaAdpcmFormatTag = 0x11;
+
+static void addValue( int value, int size, CArray<BYTE>& data )
+{
+	for( int i = 0; i < size; i++ ) {
+		data.Add( static_cast<BYTE>( value >> ( 8 * i ) ) );
+	}
+}
+
+static void addId( const char* id, CArray<BYTE>& data )
+{
+	for( int i = 0; i < 4; i++ ) {
+		data.Add( static_cast<BYTE>( id[i] ) );
+	}
+}
+
+static void addChunkHeader( const char* id, int size, CArray<BYTE>& data )
+{
+	addId( id, data );
+	addValue( size, 4, data );
+}
+
+// Write a WAV file with the basic format chunk. An odd sized chunk precedes the data to check the chunk padding.
+static void writeWavFile( int formatTag, int channelCount, int bitsPerSample, int blockAlign, const void* samples, int dataSize,
+	int factFrameCount = NotFound )
+{
+	CArray<BYTE> data;
+	// The RIFF size is set at the end.
+	addChunkHeader( "RIFF", 0, data );
+	addId( "WAVE", data );
+	addChunkHeader( "fmt ", 16, data );
+	addValue( formatTag, 2, data );
+	addValue( channelCount, 2, data );
+	addValue( 22050, 4, data );
+	addValue( 22050 * blockAlign, 4, data );
+	addValue( blockAlign, 2, data );
+	addValue( bitsPerSample, 2, data );
+	if( factFrameCount != NotFound ) {
+		addChunkHeader( "fact", 4, data );
+		addValue( factFrameCount, 4, data );
+	}
+	addChunkHeader( "LIST", 3, data );
+	addValue( 0, 4, data );
+	addChunkHeader( "data", dataSize, data );
+	for( int i = 0; i < dataSize; i++ ) {
+		data.Add( static_cast<const BYTE*>( samples )[i] );
+	}
+	const int riffSize = data.Size() - 8;
+	for( int i = 0; i < 4; i++ ) {
+		data[4 + i] = static_cast<BYTE>( riffSize >> ( 8 * i ) );
+	}
+
+	CFileWriter file( testFileName, FCM_CreateAlways );
+	file.Write( data.Ptr(), data.Size() );
+}
+
+// Decode the rest of the file by parts of the given size.
+static void decodeFile( CWavDecoder& decoder, int maxFrameCount, CArray<BYTE>& result )
+{
+	while( decoder.Decode( maxFrameCount, result ) > 0 ) {
+	}
+}
+
+static bool isEqual( const CArray<BYTE>& data, const void* expected, int expectedSize )
+{
+	return data.Size() == expectedSize && memcmp( data.Ptr(), expected, expectedSize ) == 0;
+}
+
+// Check that the decoding of the whole file by parts of the given size produces the expected data.
+static bool checkDecodedData( int maxFrameCount, bool allowFloatOutput, const void* expected, int expectedSize )
+{
+	CWavDecoder decoder( testFileName, allowFloatOutput );
+	CArray<BYTE> result;
+	decodeFile( decoder, maxFrameCount, result );
+	if( !decoder.IsFinished() || !isEqual( result, expected, expectedSize ) ) {
+		return false;
+	}
+	// The second pass gives the same result.
+	decoder.Rewind();
+	result.Empty();
+	decodeFile( decoder, decoder.GetFrameCount(), result );
+	return isEqual( result, expected, expectedSize );
+}
+
+GIN_TEST( WavDecoderPassesNarrowPcm )
+{
+	const BYTE bytes[] = { 0, 255, 128, 127, 1, 254, 64, 192, 10, 20 };
+	writeWavFile( pcmFormatTag, 2, 8, 2, bytes, sizeof( bytes ) );
+	{
+		CWavDecoder decoder( testFileName );
+		GIN_CHECK( decoder.GetEncoding() == WSE_Pcm8 );
+		GIN_CHECK( decoder.GetOutputFormat() == ADF_Stereo8 );
+		GIN_CHECK( decoder.GetChannelCount() == 2 && decoder.GetSampleRate() == 22050 );
+		GIN_CHECK( decoder.GetFrameCount() == 5 && decoder.GetOutputFrameSize() == 2 );
+		// Decoding goes up to the end of the data.
+		CArray<BYTE> result;
+		GIN_CHECK( decoder.Decode( 3, result ) == 3 && decoder.GetPosition() == 3 );
+		GIN_CHECK( decoder.Decode( 3, result ) == 2 && decoder.IsFinished() );
+		GIN_CHECK( decoder.Decode( 3, result ) == 0 );
+		GIN_CHECK( isEqual( result, bytes, sizeof( bytes ) ) );
+	}
+
+	const short samples[] = { 0, 1, -1, 32767, -32768, 12345, -12345 };
+	writeWavFile( pcmFormatTag, 1, 16, 2, samples, sizeof( samples ) );
+	GIN_CHECK( checkDecodedData( 2, true, samples, sizeof( samples ) ) );
+	CWavDecoder decoder( testFileName, true );
+	GIN_CHECK( decoder.GetOutputFormat() == ADF_Mono16 );
+	GIN_CHECK( decoder.GetFrameCount() == 7 );
+}
+
+GIN_TEST( WavDecoderConvertsWidePcm )
+{
+	// 24 bit samples lose the lowest byte in 16 bit output.
+	const BYTE pcm24Bytes[] = { 0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x80, 0x00, 0x01, 0x00, 0x56, 0x34, 0x12, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00 };
+	const short pcm24Samples[] = { 32767, -32768, 1, 0x1234, -1, 0 };
+	const float pcm24Floats[] = { 8388607.0f / 8388608, -1.0f, 256.0f / 8388608, 0x123456 / 8388608.0f, -1.0f / 8388608, 0.0f };
+	writeWavFile( pcmFormatTag, 2, 24, 6, pcm24Bytes, sizeof( pcm24Bytes ) );
+	GIN_CHECK( checkDecodedData( 2, false, pcm24Samples, sizeof( pcm24Samples ) ) );
+	GIN_CHECK( checkDecodedData( 1, true, pcm24Floats, sizeof( pcm24Floats ) ) );
+	{
+		CWavDecoder decoder( testFileName, true );
+		GIN_CHECK( decoder.GetEncoding() == WSE_Pcm24 );
+		GIN_CHECK( decoder.GetOutputFormat() == ADF_StereoFloat32 && decoder.GetOutputFrameSize() == 8 );
+	}
+
+	// The sample count covers the vector loops and the remainder.
+	const int sampleCount = 19;
+	int pcm32Samples[sampleCount];
+	short pcm32ShortSamples[sampleCount];
+	float pcm32Floats[sampleCount];
+	for( int i = 0; i < sampleCount; i++ ) {
+		pcm32Samples[i] = static_cast<int>( 0x80000000u + static_cast<unsigned>( i ) * 0x0E38E38Eu + 0x1234u );
+		pcm32ShortSamples[i] = static_cast<short>( pcm32Samples[i] >> 16 );
+		pcm32Floats[i] = pcm32Samples[i] / 2147483648.0f;
+	}
+	writeWavFile( pcmFormatTag, 1, 32, 4, pcm32Samples, sizeof( pcm32Samples ) );
+	GIN_CHECK( checkDecodedData( 11, false, pcm32ShortSamples, sizeof( pcm32ShortSamples ) ) );
+	GIN_CHECK( checkDecodedData( 11, true, pcm32Floats, sizeof( pcm32Floats ) ) );
+}
+
+GIN_TEST( WavDecoderConvertsFloatSamples )
+{
+	// Values are clamped and rounded to the nearest even integer.
+	const float floatSamples[] = { -2.0f, -1.0f, -0.5f, 0.0f, 0.25f, 0.5f, 1.0f, 2.0f, 0.375f, 0.75f, -0.75f };
+	const short shortSamples[] = { -32767, -32767, -16384, 0, 8192, 16384, 32767, 32767, 12288, 24575, -24575 };
+	writeWavFile( floatFormatTag, 1, 32, 4, floatSamples, sizeof( floatSamples ) );
+	GIN_CHECK( checkDecodedData( 9, false, shortSamples, sizeof( shortSamples ) ) );
+	GIN_CHECK( checkDecodedData( 9, true, floatSamples, sizeof( floatSamples ) ) );
+	CWavDecoder decoder( testFileName, true );
+	GIN_CHECK( decoder.GetEncoding() == WSE_Float32 && decoder.GetOutputFormat() == ADF_MonoFloat32 );
+}
+
+GIN_TEST( WavDecoderDecodesImaAdpcm )
+{
+	// Two blocks of nine frames, the fact chunk cuts the second block.
+	const BYTE blocks[] = {
+		0x00, 0x00, 0, 0, 0x77, 0x77, 0x77, 0x77,
+		0xE8, 0x03, 20, 0, 0x80, 0x3F, 0x12, 0x9A
+	};
+	const short samples[] = { 0, 11, 41, 104, 240, 533, 1164, 2521, 5431, 1000, 1006, 1001, 925, 1002, 1052 };
+	writeWavFile( imaAdpcmFormatTag, 1, 4, 8, blocks, sizeof( blocks ), 15 );
+	GIN_CHECK( checkDecodedData( 4, true, samples, sizeof( samples ) ) );
+	CWavDecoder decoder( testFileName );
+	GIN_CHECK( decoder.GetEncoding() == WSE_ImaAdpcm );
+	GIN_CHECK( decoder.GetOutputFormat() == ADF_Mono16 );
+	GIN_CHECK( decoder.GetFrameCount() == 15 );
+}
+
+GIN_TEST( WavDecoderDecodesStereoImaAdpcm )
+{
+	// The channels alternate by groups of 8 samples and the predictors are clamped.
+	// The last block has only the headers and gives a single frame.
+	const BYTE blocks[] = {
+		0xBC, 0x7F, 60, 0, 0xFB, 0xFF, 88, 0, 0x77, 0x00, 0x88, 0xFF, 0x0F, 0xF0, 0x71, 0x17,
+		0x10, 0x00, 5, 0, 0xF0, 0xFF, 7, 0
+	};
+	const short samples[] = {
+		32700, -5, 32767, -32768, 32767, -28673, 32767, -24949, 32767, -32768,
+		31689, -20482, 30709, 32767, 17337, 32767, -11329, 32767, 16, -16
+	};
+	writeWavFile( imaAdpcmFormatTag, 2, 4, 16, blocks, sizeof( blocks ) );
+	GIN_CHECK( checkDecodedData( 3, false, samples, sizeof( samples ) ) );
+	CWavDecoder decoder( testFileName );
+	GIN_CHECK( decoder.GetOutputFormat() == ADF_Stereo16 );
+	GIN_CHECK( decoder.GetFrameCount() == 10 );
+}
+
+// Check that opening the test file fails.
+static bool isRejected()
+{
+	try {
+		CWavDecoder decoder( testFileName );
+	} catch( CWavException& ) {
+		return true;
+	}
+	return false;
+}
+
+GIN_TEST( WavDecoderRejectsUnsupportedFiles )
+{
+	const BYTE bytes[24] = {};
+	writeWavFile( pcmFormatTag, 3, 8, 3, bytes, sizeof( bytes ) );
+	GIN_CHECK( isRejected() );
+	writeWavFile( pcmFormatTag, 1, 12, 2, bytes, sizeof( bytes ) );
+	GIN_CHECK( isRejected() );
+	// Microsoft ADPCM.
+	writeWavFile( 2, 1, 4, 8, bytes, sizeof( bytes ) );
+	GIN_CHECK( isRejected() );
+	// The block size must fit the header and whole groups.
+	writeWavFile( imaAdpcmFormatTag, 1, 4, 6, bytes, sizeof( bytes ) );
+	GIN_CHECK( isRejected() );
+	writeWavFile( pcmFormatTag, 1, 16, 4, bytes, sizeof( bytes ) );
+	GIN_CHECK( isRejected() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+}	// namespace Tests.
+
+}	// namespace Gin.
+
+#endif